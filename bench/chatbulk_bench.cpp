@@ -0,0 +1,203 @@
+// bench/chatbulk_bench.cpp
+//
+// Бенчмарк конвейеров tools/chatbulk без Postgres: строк в секунду на 1, 4 и 16
+// рабочих потоках.
+//   import — NDJSON → разбор → encrypt_batch → кортежи двоичного COPY;
+//   export — поток двоичного COPY → decrypt_batch → NDJSON.
+// Байты COPY никуда не отправляются: измеряется та часть, которую распараллеливает
+// chatbulk (на реальной БД потолок задаёт ещё и сам COPY на стороне сервера).
+//
+// Пример:
+//   ./chatbulk_bench --rows 500000 --text-size 200 --threads 1,4,16
+
+#include "chatserver/infrastructure/bulk/bulk_copy.h"
+#include "chatserver/infrastructure/concurrency/ordered_pipeline.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure::bulk;
+using chatserver::infrastructure::concurrency::run_ordered_pipeline;
+using chatserver::infrastructure::crypto::OpenSSLMessageEncryptor;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::size_t rows = 200000;
+    std::size_t textSize = 200;
+    std::size_t batch = 2000;
+    std::vector<std::size_t> threads{1, 4, 16};
+};
+
+std::vector<std::size_t> parse_list(const std::string& s) {
+    std::vector<std::size_t> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) out.push_back(std::stoul(item));
+    return out;
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--rows") opts.rows = std::stoul(value());
+            else if (arg == "--text-size") opts.textSize = std::stoul(value());
+            else if (arg == "--batch") opts.batch = std::stoul(value());
+            else if (arg == "--threads") opts.threads = parse_list(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "chatbulk_bench: " << ex.what() << "\n"
+                  << "usage: chatbulk_bench [--rows N] [--text-size B] [--batch ROWS] [--threads 1,4,16]\n";
+        return EXIT_FAILURE;
+    }
+
+    const OpenSSLMessageEncryptor encryptor("supersecretkey");
+    const std::int64_t baseUs = 1'700'000'000'000'000;
+
+    // Вход импорта: NDJSON в памяти, как его прочитал бы chatbulk.
+    std::string ndjson;
+    {
+        const std::string text(opts.textSize, 'x');
+        for (std::size_t i = 0; i < opts.rows; ++i) {
+            BulkMessageRow row;
+            row.id = static_cast<std::int64_t>(i + 1);
+            row.senderId = static_cast<std::int64_t>(i % 1000 + 1);
+            row.receiverId = static_cast<std::int64_t>(i % 997 + 1001);
+            row.text = text;
+            row.createdAtUs = baseUs + static_cast<std::int64_t>(i);
+            append_row(ndjson, row, BulkFormat::Ndjson);
+        }
+    }
+
+    // Вход экспорта: поток COPY TO STDOUT (FORMAT binary) с шифртекстами.
+    std::string copyOut;
+    {
+        pgcopy::append_header(copyOut);
+        const auto cipher = encryptor.encrypt(std::string(opts.textSize, 'x'));
+        for (std::size_t i = 0; i < opts.rows; ++i) {
+            pgcopy::begin_tuple(copyOut, 6);
+            pgcopy::append_int8(copyOut, static_cast<std::int64_t>(i + 1));
+            pgcopy::append_int8(copyOut, static_cast<std::int64_t>(i % 1000 + 1));
+            pgcopy::append_int8(copyOut, static_cast<std::int64_t>(i % 997 + 1001));
+            pgcopy::append_null(copyOut);
+            pgcopy::append_text(copyOut, cipher);
+            pgcopy::append_timestamp(copyOut, baseUs + static_cast<std::int64_t>(i));
+        }
+        pgcopy::append_trailer(copyOut);
+    }
+
+    std::cout << "chatbulk_bench: " << opts.rows << " messages of " << opts.textSize << " bytes, batch "
+              << opts.batch << ", " << std::thread::hardware_concurrency() << " cores\n";
+
+    for (const auto threads : opts.threads) {
+        // ---------------------
+        // Импорт
+        // ---------------------
+        std::istringstream in(ndjson);
+        BulkRecordReader reader(in, BulkFormat::Ndjson);
+        const BulkRowParser parser(BulkFormat::Ndjson);
+        std::size_t imported = 0;
+        std::size_t copyBytes = 0;
+        auto start = Clock::now();
+        run_ordered_pipeline<BulkChunk, std::string>(
+            threads, 2 * threads,
+            [&]() -> std::optional<BulkChunk> {
+                BulkChunk chunk;
+                std::string record;
+                while (chunk.records.size() < opts.batch && reader.next(record)) {
+                    chunk.records.push_back(std::move(record));
+                    chunk.lines.push_back(reader.line());
+                }
+                if (chunk.records.empty()) return std::nullopt;
+                imported += chunk.records.size();
+                return chunk;
+            },
+            [&](BulkChunk& chunk) { return encode_messages(chunk, parser, encryptor, baseUs); },
+            [&](std::string& encoded) { copyBytes += encoded.size(); });
+        const double importSecs = seconds_since(start);
+
+        // ---------------------
+        // Экспорт
+        // ---------------------
+        PgCopyBinaryReader copyReader;
+        PgCopyBinaryReader::Tuple tuple;
+        std::size_t fed = 0;
+        std::size_t exported = 0;
+        std::size_t outBytes = 0;
+        start = Clock::now();
+        run_ordered_pipeline<std::vector<BulkMessageRow>, std::string>(
+            threads, 2 * threads,
+            [&]() -> std::optional<std::vector<BulkMessageRow>> {
+                std::vector<BulkMessageRow> chunk;
+                while (chunk.size() < opts.batch) {
+                    if (copyReader.next(tuple)) {
+                        chunk.push_back(message_from_copy(tuple));
+                        continue;
+                    }
+                    if (copyReader.finished() || fed == copyOut.size()) break;
+                    // Порциями, как их отдаёт PQgetCopyData.
+                    const auto n = std::min<std::size_t>(64 * 1024, copyOut.size() - fed);
+                    copyReader.feed(copyOut.data() + fed, n);
+                    fed += n;
+                }
+                if (chunk.empty()) return std::nullopt;
+                exported += chunk.size();
+                return chunk;
+            },
+            [&](std::vector<BulkMessageRow>& chunk) { return format_messages(chunk, encryptor, BulkFormat::Ndjson); },
+            [&](std::string& text) { outBytes += text.size(); });
+        const double exportSecs = seconds_since(start);
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(2) << threads << " threads: import "
+                  << static_cast<double>(imported) / importSecs << " rows/s ("
+                  << std::setprecision(1) << static_cast<double>(copyBytes) / importSecs / (1 << 20)
+                  << " MB/s COPY), export " << std::setprecision(0)
+                  << static_cast<double>(exported) / exportSecs << " rows/s ("
+                  << std::setprecision(1) << static_cast<double>(outBytes) / exportSecs / (1 << 20)
+                  << " MB/s NDJSON)\n";
+    }
+
+    // ---------------------
+    // encrypt() на каждое сообщение против encrypt_batch() на пачку, один поток
+    // ---------------------
+    {
+        const std::vector<std::string> texts(opts.batch, std::string(opts.textSize, 'x'));
+        const std::size_t rounds = std::max<std::size_t>(1, opts.rows / opts.batch);
+        std::size_t sink = 0;
+        auto start = Clock::now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (const auto& t : texts) sink += encryptor.encrypt(t).size();
+        }
+        const double single = seconds_since(start);
+        start = Clock::now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (const auto& c : encryptor.encrypt_batch(texts)) sink += c.size();
+        }
+        const double batched = seconds_since(start);
+        const auto n = static_cast<double>(rounds * opts.batch);
+        std::cout << std::setprecision(0) << "encrypt:    " << n / single << " msgs/s one by one, "
+                  << n / batched << " msgs/s encrypt_batch (" << sink % 10 << ")\n";
+    }
+    return EXIT_SUCCESS;
+}
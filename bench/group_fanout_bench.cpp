@@ -0,0 +1,165 @@
+// bench/group_fanout_bench.cpp
+//
+// Бенчмарк рассылки группового сообщения: CPU на одно доставленное сообщение
+// (кадр, поставленный в очередь соединения участника) для групп 10 / 1k / 10k.
+//   • per-member  — как если бы группа рассылалась через message_stored() на каждого
+//                   участника: свой JSON-кадр и своя аллокация на получателя;
+//   • serialize-once — SendGroupMessageHandler::handle():
+//                   шифрование и запись один раз, один кадр на всех, send_to_users()
+//                   с одним захватом мьютекса на шард.
+// Соединения — in-process заглушки с очередью кадров (как у WebSocketSession),
+// чтобы замер показывал стоимость сервера, а не loopback-сокетов. CPU меряется
+// CLOCK_PROCESS_CPUTIME_ID: учитываются все потоки процесса.
+//
+// Пример:
+//   ./group_fanout_bench --messages 200 --sizes 10,1000,10000
+
+#include "chatserver/application/handlers/send_group_message_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+#include <ctime>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+
+namespace {
+
+struct Options {
+    std::size_t messages = 200;
+    std::vector<std::size_t> sizes{10, 1'000, 10'000};
+};
+
+// Очередь исходящих кадров: кадры держатся, пока «сокет» их не заберёт
+// (drain после каждого сообщения), — как deque в WebSocketSession.
+struct QueueConnection : realtime::RealtimeConnection {
+    std::deque<std::shared_ptr<const std::string>> queue;
+    std::size_t bytes = 0;
+    void send(std::shared_ptr<const std::string> frame) override {
+        bytes += frame->size();
+        queue.push_back(std::move(frame));
+    }
+    void drain() { queue.clear(); }
+};
+
+double cpu_seconds() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+struct Result {
+    double nsPerDelivery = 0;
+    double frameBytesPerMessage = 0;
+};
+
+Result run(std::size_t groupSize, std::size_t messages, bool serializeOnce) {
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    auto groups = std::make_shared<repository::InMemoryGroupRepository>();
+    auto notifier = std::make_shared<realtime::RealtimeMessageNotifier>(registry);
+    chatserver::application::SendGroupMessageHandler handler(
+        std::make_shared<crypto::OpenSSLMessageEncryptor>("bench-secret"),
+        std::make_shared<repository::InMemoryMessageRepository>(),
+        groups,
+        notifier);
+
+    std::vector<UserId> members;
+    std::vector<std::shared_ptr<QueueConnection>> connections;
+    for (std::size_t i = 1; i <= groupSize; ++i) {
+        members.emplace_back(static_cast<std::int64_t>(i));
+        connections.push_back(std::make_shared<QueueConnection>());
+        registry->add(static_cast<std::int64_t>(i), connections.back());
+    }
+    const auto groupId = groups->create(members);
+    const std::string text(120, 'x');
+
+    auto drain = [&] {
+        for (auto& connection : connections) connection->drain();
+    };
+
+    const double start = cpu_seconds();
+    for (std::size_t m = 0; m < messages; ++m) {
+        if (serializeOnce) {
+            handler.handle(chatserver::application::SendGroupMessageCommand{1, groupId, text});
+        } else {
+            // Базовая линия: то же сообщение, но кадр строится заново для каждого
+            // участника (сериализация + аллокация на получателя).
+            message::Message stored(MessageId(static_cast<std::int64_t>(m + 1)), UserId(1),
+                                    GroupId(groupId), MessageText(text), Timestamp::now());
+            for (const auto& member : members) {
+                if (member == UserId(1)) continue;
+                auto frame = std::make_shared<const std::string>(realtime::RealtimeMessageNotifier::to_frame(stored));
+                registry->send_to_user(member.value(), frame);
+            }
+        }
+        drain();
+    }
+    const double cpu = cpu_seconds() - start;
+
+    std::size_t bytes = 0;
+    for (const auto& connection : connections) bytes += connection->bytes;
+    const double deliveries = static_cast<double>(messages) * static_cast<double>(groupSize - 1);
+    // Байты кадров, выделенные на одно сообщение: при serialize-once — один кадр.
+    const double frameBytes = serializeOnce
+        ? static_cast<double>(bytes) / deliveries
+        : static_cast<double>(bytes) / static_cast<double>(messages);
+    return {cpu * 1e9 / deliveries, frameBytes};
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--messages") opts.messages = std::stoull(value());
+            else if (arg == "--sizes") {
+                opts.sizes.clear();
+                std::stringstream ss(value());
+                for (std::string item; std::getline(ss, item, ',');) opts.sizes.push_back(std::stoull(item));
+            }
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.messages == 0 || opts.sizes.empty()) throw std::invalid_argument("messages and sizes must be > 0");
+        for (auto size : opts.sizes) {
+            if (size < 2) throw std::invalid_argument("group size must be >= 2");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "group_fanout_bench: " << ex.what() << "\n"
+                  << "usage: group_fanout_bench [--messages N] [--sizes 10,1000,10000]\n";
+        return 2;
+    }
+
+    std::cout << "group_fanout_bench: " << opts.messages << " messages per group size, 120-byte text\n"
+              << std::setw(8) << "members" << std::setw(22) << "per-member ns/deliv"
+              << std::setw(22) << "once ns/deliv" << std::setw(10) << "speedup"
+              << std::setw(22) << "frame bytes/msg" << "\n";
+    for (auto size : opts.sizes) {
+        // Для маленьких групп сообщений больше, чтобы замер не утонул в шуме.
+        const std::size_t messages = std::max<std::size_t>(opts.messages, opts.messages * 1000 / size);
+        const auto naive = run(size, messages, false);
+        const auto once = run(size, messages, true);
+        std::cout << std::fixed << std::setprecision(0)
+                  << std::setw(8) << size << std::setw(22) << naive.nsPerDelivery
+                  << std::setw(22) << once.nsPerDelivery << std::setprecision(1)
+                  << std::setw(9) << naive.nsPerDelivery / once.nsPerDelivery << "x"
+                  << std::setprecision(0) << std::setw(10) << naive.frameBytesPerMessage << " -> "
+                  << once.frameBytesPerMessage << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+// bench/history_cache_bench.cpp
+//
+// Бенчмарк кэша горячих переписок (ConversationCache) на пути GET /messages:
+// задержка первой страницы истории (GetMessageHistoryHandler) без кэша (cold) и
+// с прогретым кэшем открытых текстов и шифртекстов (warm), плюс доля попаданий при
+// бюджете меньше рабочего набора.
+//   • переписки выбираются по Zipf (s = --skew): немного горячих, длинный хвост;
+//   • каждая десятая операция — отправка (SendMessageHandler пишет в кэш сквозь);
+//   • хранилище — InMemoryMessageRepository с искусственной задержкой запроса
+//     (--db-latency-us, по умолчанию 200 мкс — порядок round trip до Postgres).
+//
+// Пример:
+//   ./history_cache_bench --conversations 10000 --messages 200 --db-latency-us 200
+
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::application::GetMessageHistoryHandler;
+using chatserver::application::GetMessageHistoryQuery;
+using chatserver::application::SendMessageHandler;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::int64_t conversations = 10'000;
+    std::size_t messages = 200;
+    std::size_t samples = 20'000;
+    std::chrono::microseconds dbLatency{200};
+    double skew = 1.0;
+    std::size_t smallBudgetMb = 4;
+};
+
+// Хранилище с задержкой запроса: ждём активно — sleep на 200 мкс неточен.
+class SlowRepository final : public repository::MessageRepository {
+public:
+    explicit SlowRepository(std::chrono::microseconds latency) : latency_(latency) {}
+    std::int64_t save(const message::Message& message) override {
+        wait();
+        return inner_.save(message);
+    }
+    std::vector<message::Message> find_page(const ConversationId& conversation,
+                                            std::optional<MessageId> before,
+                                            std::size_t limit) const override {
+        wait();
+        return inner_.find_page(conversation, before, limit);
+    }
+    repository::InMemoryMessageRepository& inner() { return inner_; }
+
+private:
+    void wait() const {
+        if (latency_.count() == 0) return;
+        const auto until = Clock::now() + latency_;
+        while (Clock::now() < until) {
+        }
+    }
+    std::chrono::microseconds latency_;
+    repository::InMemoryMessageRepository inner_;
+};
+
+// Переписка k — пользователи 2k+1 и 2k+2.
+std::pair<std::int64_t, std::int64_t> peers(std::int64_t k) {
+    return {2 * k + 1, 2 * k + 2};
+}
+
+class Zipf {
+public:
+    Zipf(std::int64_t n, double s) : cdf_(static_cast<std::size_t>(n)) {
+        double sum = 0;
+        for (std::int64_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            cdf_[static_cast<std::size_t>(i)] = sum;
+        }
+        for (auto& c : cdf_) c /= sum;
+    }
+    std::int64_t operator()(std::mt19937_64& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+struct Result {
+    double p50us = 0;
+    double p99us = 0;
+    double hitRatio = 0;
+    std::size_t bytes = 0;
+};
+
+Result run(const Options& opts, const std::shared_ptr<SlowRepository>& repo,
+           const std::shared_ptr<crypto::OpenSSLMessageEncryptor>& encryptor,
+           std::shared_ptr<cache::ConversationCache> conversationCache, bool prewarm) {
+    GetMessageHistoryHandler history(encryptor, repo, nullptr, conversationCache);
+    SendMessageHandler sender(encryptor, repo, nullptr, conversationCache);
+    const Zipf zipf(opts.conversations, opts.skew);
+    std::mt19937_64 rng(7);
+
+    if (prewarm) {
+        // Прогрев: рабочий набор запросов уже прошёл один раз.
+        for (std::size_t i = 0; i < opts.samples; ++i) {
+            const auto [a, b] = peers(zipf(rng));
+            history.handle(GetMessageHistoryQuery{a, b, std::nullopt, 50, std::nullopt});
+        }
+    }
+    const auto before = conversationCache ? conversationCache->stats() : cache::ConversationCacheStats{};
+
+    std::vector<double> us;
+    us.reserve(opts.samples);
+    for (std::size_t i = 0; i < opts.samples; ++i) {
+        const auto [a, b] = peers(zipf(rng));
+        if (i % 10 == 9) {
+            sender.handle({a, b, "reply " + std::to_string(i), std::nullopt});
+            continue;
+        }
+        const auto start = Clock::now();
+        auto page = history.handle(GetMessageHistoryQuery{b, a, std::nullopt, 50, std::nullopt});
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        if (page.messages.empty()) {
+            throw std::runtime_error("empty history page");
+        }
+    }
+    std::sort(us.begin(), us.end());
+
+    Result r;
+    r.p50us = us[us.size() / 2];
+    r.p99us = us[us.size() * 99 / 100];
+    if (conversationCache) {
+        const auto after = conversationCache->stats();
+        const auto hits = after.hits - before.hits;
+        const auto lookups = hits + after.misses - before.misses;
+        r.hitRatio = lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+        r.bytes = after.bytes;
+    }
+    return r;
+}
+
+void print_row(const std::string& name, const Result& r) {
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << r.p50us << std::setw(10) << r.p99us << std::setw(10)
+              << std::setprecision(3) << r.hitRatio << std::setw(12) << std::setprecision(1)
+              << static_cast<double>(r.bytes) / (1 << 20) << "\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--conversations") opts.conversations = std::stoll(value());
+            else if (arg == "--messages") opts.messages = std::stoull(value());
+            else if (arg == "--samples") opts.samples = std::stoull(value());
+            else if (arg == "--db-latency-us") opts.dbLatency = std::chrono::microseconds(std::stoll(value()));
+            else if (arg == "--skew") opts.skew = std::stod(value());
+            else if (arg == "--small-budget-mb") opts.smallBudgetMb = std::stoull(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.conversations <= 0 || opts.messages == 0 || opts.samples < 100) {
+            throw std::invalid_argument("conversations, messages must be > 0 and samples >= 100");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "history_cache_bench: " << ex.what() << "\n"
+                  << "usage: history_cache_bench [--conversations N] [--messages M] [--samples S]\n"
+                  << "                           [--db-latency-us US] [--skew S] [--small-budget-mb MB]\n";
+        return 2;
+    }
+
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("bench-secret");
+    auto repo = std::make_shared<SlowRepository>(opts.dbLatency);
+    // Заполняем хранилище напрямую, без задержки.
+    const auto cipher = encryptor->encrypt("message text of a typical length");
+    for (std::size_t m = 0; m < opts.messages; ++m) {
+        for (std::int64_t k = 0; k < opts.conversations; ++k) {
+            const auto [a, b] = peers(k);
+            repo->inner().save(message::Message(UserId(m % 2 ? a : b), UserId(m % 2 ? b : a),
+                                                MessageText(cipher), Timestamp(1700000000)));
+        }
+    }
+
+    std::cout << "history_cache_bench: " << opts.conversations << " conversations x " << opts.messages
+              << " messages, first page of 50, zipf s=" << opts.skew << ", db latency "
+              << opts.dbLatency.count() << " us, " << opts.samples << " ops (10% sends)\n"
+              << std::left << std::setw(34) << "" << std::right << std::setw(10) << "p50 us"
+              << std::setw(10) << "p99 us" << std::setw(10) << "hit" << std::setw(12) << "cache MB" << "\n";
+
+    print_row("cold (no cache)", run(opts, repo, encryptor, nullptr, false));
+
+    cache::ConversationCacheOptions plain;
+    plain.budgetBytes = std::size_t{1} << 30;
+    print_row("cold cache, plain, filling", run(opts, repo, encryptor,
+              std::make_shared<cache::ConversationCache>(plain), false));
+    print_row("warm, plain text", run(opts, repo, encryptor,
+              std::make_shared<cache::ConversationCache>(plain), true));
+
+    auto encrypted = plain;
+    encrypted.text = cache::CachedTextForm::Encrypted;
+    print_row("warm, encrypted blobs", run(opts, repo, encryptor,
+              std::make_shared<cache::ConversationCache>(encrypted), true));
+
+    auto small = plain;
+    small.budgetBytes = opts.smallBudgetMb << 20;
+    print_row("warm, plain, " + std::to_string(opts.smallBudgetMb) + " MB budget (LRU)",
+              run(opts, repo, encryptor, std::make_shared<cache::ConversationCache>(small), true));
+    return 0;
+}
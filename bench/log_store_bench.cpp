@@ -0,0 +1,174 @@
+// bench/log_store_bench.cpp
+//
+// Бенчмарк LogMessageRepository: пропускная способность append при разных
+// политиках fsync и время восстановления журнала заданного объёма.
+//
+// Пример (журнал на 10 GB, 8 писателей, group commit):
+//   ./log_store_bench --dir /var/tmp/chatlog --gb 10 --threads 8 --fsync group
+// Каталог удаляется перед запуском и после него (--keep оставляет данные).
+
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chatserver::infrastructure::repository;
+using chatserver::domain::message::Message;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string dir = "log_store_bench_data";
+    double gigabytes = 1.0;
+    int threads = 4;
+    std::size_t textSize = 200;
+    FsyncPolicy policy = FsyncPolicy::GroupCommit;
+    std::uint64_t segmentMb = 256;
+    bool keep = false;
+};
+
+FsyncPolicy parse_policy(const std::string& s) {
+    if (s == "always") return FsyncPolicy::EveryWrite;
+    if (s == "group") return FsyncPolicy::GroupCommit;
+    if (s == "interval") return FsyncPolicy::Interval;
+    throw std::invalid_argument("--fsync expects always|group|interval");
+}
+
+const char* policy_name(FsyncPolicy p) {
+    switch (p) {
+    case FsyncPolicy::EveryWrite: return "always";
+    case FsyncPolicy::GroupCommit: return "group";
+    case FsyncPolicy::Interval: return "interval";
+    }
+    return "?";
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--dir") opts.dir = value();
+            else if (arg == "--gb") opts.gigabytes = std::stod(value());
+            else if (arg == "--threads") opts.threads = std::stoi(value());
+            else if (arg == "--text-size") opts.textSize = std::stoul(value());
+            else if (arg == "--fsync") opts.policy = parse_policy(value());
+            else if (arg == "--segment-mb") opts.segmentMb = std::stoull(value());
+            else if (arg == "--keep") opts.keep = true;
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "log_store_bench: " << ex.what() << "\n"
+                  << "usage: log_store_bench [--dir D] [--gb N] [--threads T] [--text-size B]\n"
+                  << "                       [--fsync always|group|interval] [--segment-mb M] [--keep]\n";
+        return EXIT_FAILURE;
+    }
+
+    fs::remove_all(opts.dir);
+    LogStoreOptions storeOpts;
+    storeOpts.directory = opts.dir;
+    storeOpts.fsyncPolicy = opts.policy;
+    storeOpts.maxSegmentBytes = opts.segmentMb << 20;
+
+    const std::size_t recordBytes = 8 + 45 + opts.textSize;
+    const auto totalBytes = static_cast<std::uint64_t>(opts.gigabytes * (1ull << 30));
+    const std::uint64_t totalRecords = totalBytes / recordBytes;
+
+    std::cout << "log_store_bench: " << opts.gigabytes << " GB, " << totalRecords << " records of "
+              << recordBytes << " bytes, " << opts.threads << " writers, fsync=" << policy_name(opts.policy)
+              << ", segment " << opts.segmentMb << " MB\n";
+
+    // ---------------------
+    // 1. Append
+    // ---------------------
+    {
+        LogMessageRepository repo(storeOpts);
+        std::atomic<std::int64_t> remaining{static_cast<std::int64_t>(totalRecords)};
+        std::vector<std::thread> writers;
+        const auto start = Clock::now();
+        for (int t = 0; t < opts.threads; ++t) {
+            writers.emplace_back([&, t] {
+                const Message message(chatserver::domain::UserId(t + 1),
+                                      chatserver::domain::UserId(t + 2),
+                                      chatserver::domain::MessageText(std::string(opts.textSize, 'a' + t % 26)),
+                                      chatserver::domain::Timestamp::now());
+                while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0) {
+                    repo.save(message);
+                }
+            });
+        }
+        for (auto& w : writers) w.join();
+        repo.sync();
+        const double secs = seconds_since(start);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "append:   " << totalRecords / secs << " records/s, "
+                  << (totalRecords * recordBytes) / secs / (1 << 20) << " MB/s ("
+                  << std::setprecision(2) << secs << " s)\n";
+    }
+
+    // ---------------------
+    // 2. Recovery: чистый журнал, затем журнал с рваным хвостом
+    // ---------------------
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass == 1) {
+            std::vector<fs::path> logs;
+            for (const auto& e : fs::directory_iterator(opts.dir)) {
+                if (e.path().extension() == ".log") logs.push_back(e.path());
+            }
+            std::sort(logs.begin(), logs.end());
+            std::ofstream out(logs.back(), std::ios::binary | std::ios::app);
+            const std::string torn(recordBytes / 2, '\x7f');
+            out.write(torn.data(), static_cast<std::streamsize>(torn.size()));
+        }
+        const auto start = Clock::now();
+        LogMessageRepository repo(storeOpts);
+        const double secs = seconds_since(start);
+        const auto& st = repo.recovery_stats();
+        std::cout << std::fixed << std::setprecision(3)
+                  << (pass == 0 ? "recovery: " : "torn:     ") << secs * 1000.0 << " ms, "
+                  << st.segments << " segments (" << st.scannedSegments << " scanned), "
+                  << st.records << " records, truncated " << st.truncatedBytes << " bytes\n";
+
+        if (pass == 0) {
+            // Случайные чтения через mmap + разреженный индекс
+            std::mt19937_64 rng(42);
+            std::uniform_int_distribution<std::int64_t> dist(1, repo.last_id());
+            constexpr int kReads = 200000;
+            const auto readStart = Clock::now();
+            std::size_t found = 0;
+            for (int i = 0; i < kReads; ++i) {
+                found += repo.find_by_id(dist(rng)).has_value();
+            }
+            const double readSecs = seconds_since(readStart);
+            std::cout << std::setprecision(1) << "reads:    " << kReads / readSecs
+                      << " random find_by_id/s (" << found << "/" << kReads << " found)\n";
+        }
+    }
+
+    if (!opts.keep) {
+        fs::remove_all(opts.dir);
+    }
+    return EXIT_SUCCESS;
+}
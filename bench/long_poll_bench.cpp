@@ -0,0 +1,227 @@
+// bench/long_poll_bench.cpp
+//
+// Бенчмарк long-poll доставки (GET /messages/wait).
+//   • реестр: N одновременно ожидающих запросов (по умолчанию 50k) — память на
+//     ожидание (RSS до/после), нс на парковку, пробуждение всех публикацией
+//     (нс на ожидание) и истечение таймаутов на колесе;
+//   • сервер: M настоящих HTTP-соединений, припаркованных в HttpServer с двумя
+//     воркерами, — память на соединение и время от публикации до последнего
+//     прочитанного ответа. M ограничено лимитом дескрипторов (клиент и сервер в
+//     одном процессе: по два fd на соединение).
+//
+// Пример:
+//   ./long_poll_bench --waiters 50000 --connections 5000
+
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/http/resources/long_poll_resource.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace beast = boost::beast;
+namespace bhttp = beast::http;
+namespace net   = boost::asio;
+using tcp       = net::ip::tcp;
+using namespace chatserver::infrastructure;
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Options {
+    std::size_t waiters = 50'000;
+    std::size_t connections = 5'000;
+};
+
+std::size_t rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+double ns_per(Clock::duration d, std::size_t ops) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) /
+           static_cast<double>(ops);
+}
+
+double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+std::shared_ptr<const std::string> make_frame(std::int64_t id, std::int64_t receiver) {
+    return std::make_shared<const std::string>(
+        R"({"type":"message","id":)" + std::to_string(id) + R"(,"sender_id":1,"receiver_id":)" +
+        std::to_string(receiver) + R"(,"text":"hello","timestamp":"2024-01-01T00:00:00Z"})");
+}
+
+void bench_registry(const Options& opts) {
+    const std::size_t n = opts.waiters;
+    realtime::LongPollOptions lpOptions;
+    lpOptions.tick = 10ms;
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> frames{0};
+    auto callback = [&](realtime::LongPollResult result) {
+        frames.fetch_add(result.frames.size(), std::memory_order_relaxed);
+        done.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    realtime::LongPollRegistry registry(lpOptions);
+    const auto rssBefore = rss_kb();
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        registry.wait(static_cast<std::int64_t>(i + 1), std::nullopt, 60s, callback);
+    }
+    const auto park = Clock::now() - t0;
+    const auto rssAfter = rss_kb();
+    const auto parked = registry.stats().parked;
+
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto user = static_cast<std::int64_t>(i + 1);
+        registry.publish(user, user, make_frame(user, user));
+    }
+    const auto wake = Clock::now() - t0;
+    const auto woken = done.load();
+
+    // Таймауты: паркуем снова (ящики уже есть, курсор — последний кадр) и ждём колесо.
+    done = 0;
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto user = static_cast<std::int64_t>(i + 1);
+        registry.wait(user, user, 200ms, callback);
+    }
+    while (done.load() < n && Clock::now() - t0 < 30s) std::this_thread::sleep_for(1ms);
+    const auto expire = Clock::now() - t0;
+
+    std::cout << "registry: " << parked << " parked polls\n" << std::fixed << std::setprecision(1)
+              << "  memory " << static_cast<double>(rssAfter - rssBefore) * 1024.0 / static_cast<double>(n)
+              << " B per parked poll (mailbox + waiter + timer), park " << ns_per(park, n) << " ns\n"
+              << "  wake " << woken << " by publish: " << ns_per(wake, n) << " ns per poll incl. frame build ("
+              << frames.load() << " frames delivered)\n"
+              << "  timeout " << done.load() << " polls of 200 ms: all answered after " << ms(expire)
+              << " ms (tick " << lpOptions.tick.count() << " ms)\n";
+}
+
+// Клиент одного соединения: пишет запрос и читает ответ асинхронно.
+struct Poller {
+    explicit Poller(net::io_context& ioc) : socket(ioc) {}
+    tcp::socket socket;
+    bhttp::request<bhttp::empty_body> request;
+    beast::flat_buffer buffer;
+    bhttp::response<bhttp::string_body> response;
+};
+
+void bench_server(const Options& opts) {
+    rlimit limit{};
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    const std::size_t fdBudget = limit.rlim_cur > 200 ? (limit.rlim_cur - 100) / 2 : 0;
+    const std::size_t n = std::min(opts.connections, fdBudget);
+    if (n == 0) {
+        std::cout << "server: skipped (fd limit " << limit.rlim_cur << ")\n";
+        return;
+    }
+
+    auto longPoll = std::make_shared<realtime::LongPollRegistry>();
+    auto router = std::make_shared<http::HttpRouter>();
+    http::resources::LongPollResource(longPoll).register_routes(*router);
+    http::HttpServerOptions serverOptions;
+    serverOptions.workerThreads = 2;
+    serverOptions.ioThreads = 1;
+    http::HttpServer server("127.0.0.1", 0, router, std::make_shared<realtime::ConnectionRegistry>(), serverOptions);
+    server.start();
+
+    net::io_context ioc{1};
+    const auto endpoint = tcp::endpoint(net::ip::make_address("127.0.0.1"), server.port());
+    std::vector<std::unique_ptr<Poller>> pollers;
+    pollers.reserve(n);
+    std::size_t answered = 0;
+    Clock::time_point lastAnswer;
+
+    const auto rssBefore = rss_kb();
+    for (std::size_t i = 0; i < n; ++i) {
+        auto& p = *pollers.emplace_back(std::make_unique<Poller>(ioc));
+        p.socket.connect(endpoint);
+        p.request = {bhttp::verb::get, "/messages/wait?user=" + std::to_string(i + 1) + "&timeout=60", 11};
+        p.request.set(bhttp::field::host, "127.0.0.1");
+        bhttp::async_write(p.socket, p.request, [&p, &answered, &lastAnswer](beast::error_code ec, std::size_t) {
+            if (ec) return;
+            bhttp::async_read(p.socket, p.buffer, p.response, [&answered, &lastAnswer](beast::error_code ec, std::size_t) {
+                if (ec) return;
+                ++answered;
+                lastAnswer = Clock::now();
+            });
+        });
+        ioc.poll();
+    }
+    const auto parkStart = Clock::now();
+    while (longPoll->stats().parked < n && Clock::now() - parkStart < 60s) {
+        ioc.poll();
+        std::this_thread::sleep_for(1ms);
+    }
+    const auto parked = longPoll->stats().parked;
+    const auto rssAfter = rss_kb();
+
+    const auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto user = static_cast<std::int64_t>(i + 1);
+        longPoll->publish(user, user, make_frame(user, user));
+    }
+    const auto published = Clock::now() - t0;
+    while (answered < n && Clock::now() - t0 < 60s) {
+        ioc.run_for(10ms);
+    }
+
+    std::cout << "server: " << parked << " parked HTTP polls on 1 io thread + 2 workers\n"
+              << std::fixed << std::setprecision(1) << "  memory "
+              << static_cast<double>(rssAfter - rssBefore) * 1024.0 / static_cast<double>(n)
+              << " B per parked connection (server session + client socket + kernel buffers)\n"
+              << "  publish to all: " << ms(published) << " ms; last of " << answered
+              << " responses read after " << ms(lastAnswer - t0) << " ms\n";
+    server.stop();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--waiters") opts.waiters = std::stoull(value());
+            else if (arg == "--connections") opts.connections = std::stoull(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.waiters == 0) throw std::invalid_argument("waiters must be > 0");
+    } catch (const std::exception& ex) {
+        std::cerr << "long_poll_bench: " << ex.what() << "\n"
+                  << "usage: long_poll_bench [--waiters N] [--connections M]\n";
+        return 2;
+    }
+
+    bench_registry(opts);
+    if (opts.connections > 0) {
+        bench_server(opts);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+// bench/message_history_bench.cpp
+//
+// Бенчмарк чтения истории переписок (MessageRepository::find_page):
+//   • inbox — открытие случайной переписки (первая страница) среди N активных;
+//   • глубина — задержка страницы keyset-пагинации в зависимости от глубины
+//     в сравнении с OFFSET (прочитать depth + limit строк и отбросить depth);
+//   • расшифровка страницы поштучно и через decrypt_batch().
+//
+// Пример (50M сообщений в 10k переписках, по 5k сообщений на переписку):
+//   ./message_history_bench --rows 50000000 --conversations 10000
+// Журнал на диске вместо памяти:
+//   ./message_history_bench --backend log --dir /var/tmp/history_bench --rows 5000000
+// В памяти 50M сообщений занимают ~4 GB; для Postgres-версии того же замера
+// см. bench/message_history_pg.sql.
+
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::message::Message;
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::size_t rows = 50'000'000;
+    std::int64_t conversations = 10'000;
+    std::size_t limit = 50;
+    std::size_t samples = 2000;
+    std::size_t textSize = 16;
+    std::string backend = "memory";
+    std::string dir = "message_history_bench_data";
+};
+
+struct Latency {
+    double p50us = 0;
+    double p99us = 0;
+};
+
+template <typename F>
+Latency measure(std::size_t samples, F&& fn) {
+    std::vector<double> us;
+    us.reserve(samples);
+    for (std::size_t i = 0; i < samples; ++i) {
+        const auto start = Clock::now();
+        fn(i);
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::sort(us.begin(), us.end());
+    return {us[us.size() / 2], us[std::min(us.size() - 1, us.size() * 99 / 100)]};
+}
+
+// Переписка c — пара пользователей (c + 1, c + 1 + conversations): все пары различны.
+UserId sender_of(std::int64_t c) { return UserId(c + 1); }
+UserId receiver_of(std::int64_t c, std::int64_t conversations) { return UserId(c + 1 + conversations); }
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--rows") opts.rows = std::stoull(value());
+            else if (arg == "--conversations") opts.conversations = std::stoll(value());
+            else if (arg == "--limit") opts.limit = std::stoul(value());
+            else if (arg == "--samples") opts.samples = std::stoul(value());
+            else if (arg == "--text-size") opts.textSize = std::stoul(value());
+            else if (arg == "--backend") opts.backend = value();
+            else if (arg == "--dir") opts.dir = value();
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.conversations <= 0 || opts.limit == 0 ||
+            opts.rows < static_cast<std::size_t>(opts.conversations) * opts.limit) {
+            throw std::invalid_argument("need conversations > 0, limit > 0 and rows >= conversations * limit");
+        }
+        if (opts.backend != "memory" && opts.backend != "log") {
+            throw std::invalid_argument("--backend expects memory|log");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "message_history_bench: " << ex.what() << "\n"
+                  << "usage: message_history_bench [--rows N] [--conversations N] [--limit N]"
+                     " [--samples N] [--text-size BYTES] [--backend memory|log] [--dir PATH]\n";
+        return 2;
+    }
+
+    std::cout << "message_history_bench: " << opts.rows << " rows, " << opts.conversations
+              << " conversations, page " << opts.limit << ", backend " << opts.backend << "\n";
+
+    std::unique_ptr<MessageRepository> repo;
+    if (opts.backend == "memory") {
+        repo = std::make_unique<InMemoryMessageRepository>(opts.rows);
+    } else {
+        fs::remove_all(opts.dir);
+        LogStoreOptions log;
+        log.directory = opts.dir;
+        log.fsyncPolicy = FsyncPolicy::Interval;
+        repo = std::make_unique<LogMessageRepository>(log);
+    }
+
+    const std::string text(opts.textSize, 'x');
+    const auto fillStart = Clock::now();
+    for (std::size_t i = 0; i < opts.rows; ++i) {
+        // Переписки чередуются: у переписки c id = c + 1 + k * conversations,
+        // и по обе стороны от каждого сообщения — сообщения других переписок.
+        const auto c = static_cast<std::int64_t>(i) % opts.conversations;
+        repo->save(Message(sender_of(c), receiver_of(c, opts.conversations),
+                           MessageText(text), Timestamp(1700000000)));
+    }
+    std::cout << "fill:     " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(Clock::now() - fillStart).count() << " s\n";
+
+    const std::size_t perConversation = opts.rows / static_cast<std::size_t>(opts.conversations);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::int64_t> conversationDist(0, opts.conversations - 1);
+    auto key_of = [&](std::int64_t c) {
+        return ConversationId::between(sender_of(c), receiver_of(c, opts.conversations));
+    };
+
+    auto inbox = measure(opts.samples, [&](std::size_t) {
+        const auto c = conversationDist(rng);
+        if (repo->find_page(key_of(c), std::nullopt, opts.limit).size() != opts.limit) std::abort();
+    });
+    std::cout << "inbox:    open random conversation, first page: p50 " << inbox.p50us
+              << " us, p99 " << inbox.p99us << " us\n";
+
+    // Курсор для глубины depth в переписке c — id сообщения, стоящего depth-м с конца.
+    auto cursor_at = [&](std::int64_t c, std::size_t depth) {
+        const std::size_t k = perConversation - depth;
+        return MessageId(c + 1 + static_cast<std::int64_t>(k) * opts.conversations);
+    };
+
+    std::cout << std::setw(12) << "depth" << std::setw(16) << "keyset p50 us" << std::setw(16)
+              << "keyset p99 us" << std::setw(16) << "offset p50 us" << std::setw(16) << "offset p99 us"
+              << "\n";
+    for (std::size_t depth = 0; depth + opts.limit <= perConversation;
+         depth = depth == 0 ? 100 : depth * 10) {
+        auto keyset = measure(opts.samples, [&](std::size_t) {
+            const auto c = conversationDist(rng);
+            auto page = depth == 0 ? repo->find_page(key_of(c), std::nullopt, opts.limit)
+                                   : repo->find_page(key_of(c), cursor_at(c, depth), opts.limit);
+            if (page.size() != opts.limit) std::abort();
+        });
+        // OFFSET читает и отбрасывает depth строк: для честного сравнения
+        // берём столько же строк через ту же выборку и оставляем последние limit.
+        // На больших глубинах это дорого, поэтому число замеров уменьшаем.
+        const std::size_t offsetSamples = std::max<std::size_t>(3, opts.samples * 100 / (depth + 100));
+        auto offset = measure(offsetSamples, [&](std::size_t) {
+            const auto c = conversationDist(rng);
+            if (repo->find_page(key_of(c), std::nullopt, depth + opts.limit).size() != depth + opts.limit) {
+                std::abort();
+            }
+        });
+        std::cout << std::setw(12) << depth << std::setprecision(1)
+                  << std::setw(16) << keyset.p50us << std::setw(16) << keyset.p99us
+                  << std::setw(16) << offset.p50us << std::setw(16) << offset.p99us << "\n";
+    }
+
+    // Расшифровка страницы: поштучный decrypt() против decrypt_batch().
+    chatserver::infrastructure::crypto::OpenSSLMessageEncryptor encryptor("bench-secret");
+    std::vector<std::string> cipherTexts;
+    for (std::size_t i = 0; i < opts.limit; ++i) {
+        cipherTexts.push_back(encryptor.encrypt(std::string(120, 'a' + static_cast<char>(i % 26))));
+    }
+    auto single = measure(opts.samples, [&](std::size_t) {
+        for (const auto& c : cipherTexts) {
+            if (encryptor.decrypt(c).empty()) std::abort();
+        }
+    });
+    auto batch = measure(opts.samples, [&](std::size_t) {
+        if (encryptor.decrypt_batch(cipherTexts).size() != cipherTexts.size()) std::abort();
+    });
+    std::cout << "decrypt page of " << opts.limit << ": per-message p50 " << single.p50us
+              << " us, batch p50 " << batch.p50us << " us\n";
+
+    repo.reset();
+    if (opts.backend == "log") {
+        fs::remove_all(opts.dir);
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+-- bench/message_history_pg.sql
+--
+-- История переписок на таблице messages из 50M строк в 10k активных переписках
+-- (схема tools/migrate_db.sh). Запуск на отдельной базе (заполнение — несколько минут):
+--   psql -d chat_bench -f bench/message_history_pg.sql
+-- В выводе EXPLAIN (ANALYZE, BUFFERS) сравнивайте Execution Time и число
+-- прочитанных буферов: у keyset по (conversation_id, id) они не растут с глубиной,
+-- у OFFSET — линейно.
+
+\timing on
+
+DROP TABLE IF EXISTS messages;
+DROP TABLE IF EXISTS users;
+CREATE TABLE users (
+    id SERIAL PRIMARY KEY,
+    username VARCHAR(255) UNIQUE NOT NULL,
+    password_hash TEXT NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+CREATE TABLE messages (
+    id SERIAL PRIMARY KEY,
+    sender_id BIGINT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    text TEXT NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    receiver_id BIGINT REFERENCES users(id) ON DELETE CASCADE,
+    conversation_id BIGINT
+);
+
+-- Переписка c (0..9999) — пользователи c + 1 и c + 10001; сообщения переписок
+-- чередуются, как во входящих живого сервера. По 5000 сообщений на переписку.
+INSERT INTO users (username, password_hash)
+SELECT 'user' || g, 'salt:hash' FROM generate_series(1, 20000) g;
+INSERT INTO messages (sender_id, receiver_id, conversation_id, text)
+SELECT (g % 10000) + 1, (g % 10000) + 10001,
+       (((g % 10000) + 1)::BIGINT << 32) | ((g % 10000) + 10001),
+       md5(g::text)
+FROM generate_series(0, 49999999) g;
+
+CREATE INDEX messages_conversation_id_id_idx ON messages (conversation_id, id);
+VACUUM ANALYZE messages;
+
+-- Переписка пользователей 1 и 10001: id = 1 + 10000 * k, последний — 49990001.
+-- Открытие переписки (первая страница)
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 10001 AND id < 9223372036854775807
+ORDER BY id DESC LIMIT 50;
+
+-- Глубина 1000
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 10001 AND id < 49990001 - 10000 * 1000
+ORDER BY id DESC LIMIT 50;
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 10001
+ORDER BY id DESC OFFSET 1000 LIMIT 50;
+
+-- Глубина 4900 (почти начало переписки)
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 10001 AND id < 49990001 - 10000 * 4900
+ORDER BY id DESC LIMIT 50;
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 10001
+ORDER BY id DESC OFFSET 4900 LIMIT 50;
@@ -0,0 +1,134 @@
+-- bench/message_partition_pg.sql
+--
+-- Секционированная по created_at таблица messages на 500M строк: 100 суточных
+-- партиций по 5M, 100k переписок, id в раскладке MessageIdGenerator (время в id).
+-- Запуск на отдельной базе (заполнение — час и больше, ~80 ГБ с индексами):
+--   psql -d chat_bench -f bench/message_partition_pg.sql
+--   psql -d chat_bench -v flat=1 -f bench/message_partition_pg.sql
+-- flat=1 дополнительно строит несекционированную копию тех же строк для сравнения
+-- вставок и чтений (ещё столько же времени и места).
+-- Сравнивайте Execution Time, число партиций в плане («Subplans Removed») и
+-- прочитанные буферы: запрос истории с условием на created_at (как строит
+-- PostgresMessageRepository при messages_partitions != none) спускается в индекс
+-- одной-двух партиций, без него — в индекс каждой из 101.
+
+\timing on
+
+DROP TABLE IF EXISTS messages;
+DROP TABLE IF EXISTS messages_flat;
+CREATE TABLE messages (
+    id BIGINT NOT NULL,
+    sender_id BIGINT NOT NULL,
+    text TEXT NOT NULL,
+    created_at TIMESTAMP NOT NULL,
+    receiver_id BIGINT,
+    conversation_id BIGINT,
+    group_id BIGINT,
+    PRIMARY KEY (id, created_at)
+) PARTITION BY RANGE (created_at);
+CREATE INDEX messages_conversation_id_id_idx ON messages (conversation_id, id);
+
+-- Сто суток данных до начала сегодняшних и пустая партиция текущих суток.
+DO $$
+DECLARE
+    start TIMESTAMP := date_trunc('day', now() AT TIME ZONE 'UTC') - INTERVAL '100 days';
+    p TIMESTAMP;
+BEGIN
+    FOR k IN 0..100 LOOP
+        p := start + k * INTERVAL '1 day';
+        EXECUTE format('CREATE TABLE %I PARTITION OF messages FOR VALUES FROM (%L) TO (%L)',
+                       'messages_p' || to_char(p, 'YYYYMMDD'), p, p + INTERVAL '1 day');
+    END LOOP;
+END $$;
+
+-- Строка g: время равномерно по ста суткам (шаг 17.28 мс), переписка g % 100000
+-- (пользователи c + 1 и c + 100001), id = (мс от 2024-01-01 << 22) | (g & 4095).
+CREATE TEMP VIEW bench_rows AS
+SELECT g,
+       date_trunc('day', now() AT TIME ZONE 'UTC') - INTERVAL '100 days'
+           + g * INTERVAL '17.28 milliseconds' AS created_at
+FROM generate_series(0, 499999999) g;
+
+INSERT INTO messages (id, sender_id, receiver_id, conversation_id, text, created_at)
+SELECT ((EXTRACT(EPOCH FROM created_at) * 1000)::BIGINT - 1704067200000) << 22 | (g & 4095),
+       (g % 100000) + 1, (g % 100000) + 100001,
+       (((g % 100000) + 1)::BIGINT << 32) | ((g % 100000) + 100001),
+       md5(g::text), created_at
+FROM bench_rows;
+VACUUM ANALYZE messages;
+
+\if :{?flat}
+CREATE TABLE messages_flat (LIKE messages);
+INSERT INTO messages_flat SELECT * FROM messages;
+ALTER TABLE messages_flat ADD PRIMARY KEY (id);
+CREATE INDEX messages_flat_conversation_id_id_idx ON messages_flat (conversation_id, id);
+VACUUM ANALYZE messages_flat;
+\endif
+
+-- Курсор глубоко в истории переписки 1 ↔ 100001 (3000 сообщений назад, около
+-- 60 суток назад). Верхняя граница — время курсора + 5 минут, как у сервера (clockSkew).
+SELECT id AS deep_id,
+       created_at + INTERVAL '5 minutes' AS deep_upper,
+       created_at + INTERVAL '5 minutes' - INTERVAL '7 days' AS deep_recent
+FROM messages WHERE conversation_id = (1::BIGINT << 32) | 100001
+ORDER BY id DESC OFFSET 3000 LIMIT 1 \gset
+SELECT (now() AT TIME ZONE 'UTC') - INTERVAL '7 days' AS head_recent \gset
+
+-- Открытие переписки (первая страница): без условия на время — все 101 партиция,
+-- с окном в 7 дней — только последние
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 100001 AND id < 9223372036854775807
+ORDER BY id DESC LIMIT 50;
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 100001 AND id < 9223372036854775807
+  AND created_at >= :'head_recent'
+ORDER BY id DESC LIMIT 50;
+
+-- Глубокая страница: курсор несёт время, партиции новее него отбрасываются
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 100001 AND id < :deep_id
+ORDER BY id DESC LIMIT 50;
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages
+WHERE conversation_id = (1::BIGINT << 32) | 100001 AND id < :deep_id
+  AND created_at >= :'deep_recent' AND created_at < :'deep_upper'
+ORDER BY id DESC LIMIT 50;
+
+\if :{?flat}
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, sender_id, receiver_id, text, created_at FROM messages_flat
+WHERE conversation_id = (1::BIGINT << 32) | 100001 AND id < :deep_id
+ORDER BY id DESC LIMIT 50;
+\endif
+
+-- Вставка 1M новых сообщений: в секционированной таблице индексы текущей партиции
+-- (5M строк) держатся в памяти, в несекционированной — индексы на 500M строк
+INSERT INTO messages (id, sender_id, receiver_id, conversation_id, text, created_at)
+SELECT ((EXTRACT(EPOCH FROM now()) * 1000)::BIGINT - 1704067200000) << 22 | 4096 + g,
+       (g % 100000) + 1, (g % 100000) + 100001,
+       (((g % 100000) + 1)::BIGINT << 32) | ((g % 100000) + 100001),
+       md5(g::text), now() AT TIME ZONE 'UTC'
+FROM generate_series(0, 999999) g;
+\if :{?flat}
+INSERT INTO messages_flat (id, sender_id, receiver_id, conversation_id, text, created_at)
+SELECT ((EXTRACT(EPOCH FROM now()) * 1000)::BIGINT - 1704067200000) << 22 | 4096 + g,
+       (g % 100000) + 1, (g % 100000) + 100001,
+       (((g % 100000) + 1)::BIGINT << 32) | ((g % 100000) + 100001),
+       md5(g::text), now() AT TIME ZONE 'UTC'
+FROM generate_series(0, 999999) g;
+\endif
+
+-- Срок хранения: сутки данных — DETACH + DROP партиции против DELETE (и VACUUM,
+-- без которого место не освобождается)
+SELECT 'messages_p' || to_char(date_trunc('day', now() AT TIME ZONE 'UTC') - INTERVAL '100 days',
+                               'YYYYMMDD') AS oldest \gset
+ALTER TABLE messages DETACH PARTITION :"oldest" CONCURRENTLY;
+DROP TABLE :"oldest";
+\if :{?flat}
+DELETE FROM messages_flat
+WHERE created_at < date_trunc('day', now() AT TIME ZONE 'UTC') - INTERVAL '99 days';
+VACUUM messages_flat;
+\endif
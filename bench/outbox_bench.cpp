@@ -0,0 +1,246 @@
+// bench/outbox_bench.cpp
+//
+// Бенчмарк write-behind outbox (OutboxMessageRepository): задержка подтверждения
+// save() против синхронной записи в хранилище, скорость слива пачками и поведение,
+// когда хранилище «тормозит».
+//
+// Postgres заменён заглушкой с настраиваемой стоимостью: --commit-us на коммит
+// (сетевой круг + fsync WAL) и --row-us на строку пачки. Outbox пишет на настоящий диск.
+//
+// Пример:
+//   ./outbox_bench --dir /var/tmp/outbox --messages 20000 --threads 8 --commit-us 2000 --stall-ms 2000
+// Каталог удаляется перед запуском и после него.
+
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::message::Message;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string dir = "outbox_bench_data";
+    std::size_t messages = 20000;
+    int threads = 8;
+    std::size_t textSize = 200;
+    long commitUs = 2000;
+    long rowUs = 5;
+    long stallMs = 2000;
+    std::size_t batch = 1000;
+    std::size_t maxPending = 1'000'000;
+};
+
+// Хранилище-заглушка: каждая транзакция стоит commitUs + rowUs на строку;
+// stall() на время останавливает запись, как зависший Postgres.
+class SimulatedStore final : public MessageRepository {
+public:
+    SimulatedStore(long commitUs, long rowUs) : commitUs_(commitUs), rowUs_(rowUs) {}
+
+    std::int64_t save(const Message& message) override {
+        wait_stall();
+        std::this_thread::sleep_for(std::chrono::microseconds(commitUs_));
+        std::lock_guard lock(mutex_);
+        ids_.insert(message.id().value());
+        return message.id().value();
+    }
+
+    std::size_t save_batch(const std::vector<Message>& messages) override {
+        wait_stall();
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            commitUs_ + rowUs_ * static_cast<long>(messages.size())));
+        std::lock_guard lock(mutex_);
+        std::size_t written = 0;
+        for (const auto& m : messages) written += ids_.insert(m.id().value()).second ? 1 : 0;
+        return written;
+    }
+
+    std::vector<Message> find_page(const ConversationId&, std::optional<MessageId>, std::size_t) const override {
+        return {};
+    }
+
+    void stall(std::chrono::milliseconds duration) {
+        stalledUntil_.store((Clock::now() + duration).time_since_epoch().count());
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return ids_.size();
+    }
+
+private:
+    void wait_stall() const {
+        const Clock::time_point until{Clock::duration(stalledUntil_.load())};
+        if (Clock::now() < until) std::this_thread::sleep_until(until);
+    }
+
+    long commitUs_;
+    long rowUs_;
+    std::atomic<Clock::rep> stalledUntil_{0};
+    mutable std::mutex mutex_;
+    std::unordered_set<std::int64_t> ids_;
+};
+
+struct Run {
+    double seconds = 0;
+    std::vector<double> latencyUs;
+};
+
+// threads писателей отправляют messages сообщений через repo, замеряя каждое подтверждение.
+Run send_all(MessageRepository& repo, MessageIdGenerator& ids, const Options& opts, std::size_t messages) {
+    std::atomic<std::int64_t> remaining{static_cast<std::int64_t>(messages)};
+    std::vector<std::vector<double>> perThread(static_cast<std::size_t>(opts.threads));
+    std::vector<std::thread> writers;
+    const auto start = Clock::now();
+    for (int t = 0; t < opts.threads; ++t) {
+        writers.emplace_back([&, t] {
+            const MessageText text(std::string(opts.textSize, static_cast<char>('a' + t % 26)));
+            auto& lat = perThread[static_cast<std::size_t>(t)];
+            while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0) {
+                const Message message(ids.next(), UserId(t + 1), UserId(t + 2), text, Timestamp::now());
+                const auto begin = Clock::now();
+                repo.save(message);
+                lat.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    Run run;
+    run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& lat : perThread) run.latencyUs.insert(run.latencyUs.end(), lat.begin(), lat.end());
+    std::sort(run.latencyUs.begin(), run.latencyUs.end());
+    return run;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * static_cast<double>(sorted.size())))];
+}
+
+void print_run(const char* label, const Run& run) {
+    std::cout << std::fixed << std::setprecision(1) << label
+              << static_cast<double>(run.latencyUs.size()) / run.seconds << " acks/s, latency p50 "
+              << percentile(run.latencyUs, 0.50) << " us, p99 " << percentile(run.latencyUs, 0.99)
+              << " us, max " << (run.latencyUs.empty() ? 0.0 : run.latencyUs.back()) << " us\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--dir") opts.dir = value();
+            else if (arg == "--messages") opts.messages = std::stoul(value());
+            else if (arg == "--threads") opts.threads = std::stoi(value());
+            else if (arg == "--text-size") opts.textSize = std::stoul(value());
+            else if (arg == "--commit-us") opts.commitUs = std::stol(value());
+            else if (arg == "--row-us") opts.rowUs = std::stol(value());
+            else if (arg == "--stall-ms") opts.stallMs = std::stol(value());
+            else if (arg == "--batch") opts.batch = std::stoul(value());
+            else if (arg == "--max-pending") opts.maxPending = std::stoul(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "outbox_bench: " << ex.what() << "\n"
+                  << "usage: outbox_bench [--dir D] [--messages N] [--threads T] [--text-size B]\n"
+                  << "                    [--commit-us U] [--row-us U] [--stall-ms M] [--batch B] [--max-pending P]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "outbox_bench: " << opts.messages << " messages of " << opts.textSize << " bytes, "
+              << opts.threads << " writers, store commit " << opts.commitUs << " us + " << opts.rowUs
+              << " us/row, batch " << opts.batch << "\n";
+
+    MessageIdGenerator ids(1);
+    OutboxOptions outboxOpts;
+    outboxOpts.directory = opts.dir;
+    outboxOpts.batchSize = opts.batch;
+    outboxOpts.maxPending = opts.maxPending;
+
+    // ---------------------
+    // 1. Синхронная запись: подтверждение ждёт коммита хранилища
+    // ---------------------
+    {
+        SimulatedStore store(opts.commitUs, opts.rowUs);
+        // Синхронный путь медленный: хватит части сообщений для оценки задержки.
+        const auto n = std::max<std::size_t>(opts.messages / 10, 1);
+        print_run("direct:   ", send_all(store, ids, opts, n));
+    }
+
+    // ---------------------
+    // 2. Outbox: подтверждение после fdatasync локального файла, слив пачками
+    // ---------------------
+    {
+        fs::remove_all(opts.dir);
+        auto store = std::make_shared<SimulatedStore>(opts.commitUs, opts.rowUs);
+        OutboxMessageRepository outbox(store, outboxOpts);
+        const auto run = send_all(outbox, ids, opts, opts.messages);
+        print_run("outbox:   ", run);
+        const auto appendedAt = Clock::now();
+        outbox.flush(std::chrono::minutes(10));
+        const double tail = std::chrono::duration<double>(Clock::now() - appendedAt).count();
+        const auto s = outbox.stats();
+        std::cout << std::setprecision(1) << "drain:    " << static_cast<double>(s.drained) / (run.seconds + tail)
+                  << " msgs/s into the store, " << s.batches << " batches, " << s.fsyncs << " fsyncs for "
+                  << s.appended << " acks, caught up " << std::setprecision(3) << tail * 1000.0
+                  << " ms after the last ack (" << store->size() << " rows)\n";
+    }
+
+    // ---------------------
+    // 3. Хранилище «зависает» на stall-ms, писатели продолжают
+    // ---------------------
+    {
+        fs::remove_all(opts.dir);
+        auto store = std::make_shared<SimulatedStore>(opts.commitUs, opts.rowUs);
+        OutboxMessageRepository outbox(store, outboxOpts);
+        store->stall(std::chrono::milliseconds(opts.stallMs));
+
+        std::atomic<bool> sampling{true};
+        std::size_t peakPending = 0;
+        std::int64_t peakLagMs = 0;
+        std::thread sampler([&] {
+            while (sampling) {
+                const auto s = outbox.stats();
+                peakPending = std::max(peakPending, s.pending);
+                peakLagMs = std::max(peakLagMs, s.oldestPendingMs);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+        const auto run = send_all(outbox, ids, opts, opts.messages);
+        print_run("stalled:  ", run);
+        const auto appendedAt = Clock::now();
+        outbox.flush(std::chrono::minutes(10));
+        const double tail = std::chrono::duration<double>(Clock::now() - appendedAt).count();
+        sampling = false;
+        sampler.join();
+        const auto s = outbox.stats();
+        std::cout << std::setprecision(3) << "          peak pending " << peakPending << ", peak lag "
+                  << peakLagMs << " ms, throttled " << s.throttled << " saves, caught up "
+                  << tail * 1000.0 << " ms after the last ack\n";
+    }
+
+    fs::remove_all(opts.dir);
+    return EXIT_SUCCESS;
+}
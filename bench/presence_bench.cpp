@@ -0,0 +1,156 @@
+// bench/presence_bench.cpp
+//
+// Бенчмарк реестра присутствия (ConnectionRegistry):
+//   • память на онлайн-пользователя с одним соединением (RSS до/после);
+//   • поиск под высокой «текучкой»: T потоков, каждый в цикле либо подключает/
+//     отключает соединение случайного пользователя (доля --churn), либо доставляет
+//     кадр случайному пользователю (send_to_user). Сравнение 1 шарда и N шардов.
+//
+// Пример:
+//   ./presence_bench --users 1000000 --threads 8 --churn 0.3
+
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace chatserver::infrastructure::realtime;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::size_t users = 1'000'000;
+    std::size_t threads = 4;
+    double churn = 0.3;
+    double seconds = 3.0;
+    std::size_t shards = 64;
+};
+
+struct NullConnection : RealtimeConnection {
+    void send(std::shared_ptr<const std::string>) override {}
+};
+
+std::size_t rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+struct ChurnResult {
+    double lookupsPerSec = 0;
+    double churnPerSec = 0;
+};
+
+ChurnResult run_churn(const Options& opts, std::size_t shards) {
+    ConnectionRegistryOptions registryOptions;
+    registryOptions.shards = shards;
+    ConnectionRegistry registry(registryOptions);
+
+    // Половина пользователей онлайн с самого начала
+    auto resident = std::make_shared<NullConnection>();
+    for (std::size_t u = 1; u <= opts.users; u += 2) {
+        registry.add(static_cast<std::int64_t>(u), resident);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> lookups{0};
+    std::atomic<std::uint64_t> churnOps{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < opts.threads; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 1);
+            std::uniform_int_distribution<std::int64_t> userDist(1, static_cast<std::int64_t>(opts.users));
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            auto device = std::make_shared<NullConnection>();
+            auto frame = std::make_shared<const std::string>("{}");
+            std::vector<std::int64_t> attached;
+            std::uint64_t myLookups = 0, myChurn = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 256; ++i) {
+                    if (coin(rng) < opts.churn) {
+                        // Текучка: подключаем нового или отключаем ранее подключённого
+                        if (attached.size() < 1024 && (attached.empty() || coin(rng) < 0.5)) {
+                            const auto user = userDist(rng);
+                            if (registry.add(user, device)) attached.push_back(user);
+                        } else {
+                            registry.remove(attached.back(), device.get());
+                            attached.pop_back();
+                        }
+                        ++myChurn;
+                    } else {
+                        registry.send_to_user(userDist(rng), frame);
+                        ++myLookups;
+                    }
+                }
+            }
+            lookups += myLookups;
+            churnOps += myChurn;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(opts.seconds));
+    stop = true;
+    for (auto& thread : threads) thread.join();
+    return {static_cast<double>(lookups) / opts.seconds, static_cast<double>(churnOps) / opts.seconds};
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--users") opts.users = std::stoull(value());
+            else if (arg == "--threads") opts.threads = std::stoull(value());
+            else if (arg == "--churn") opts.churn = std::stod(value());
+            else if (arg == "--seconds") opts.seconds = std::stod(value());
+            else if (arg == "--shards") opts.shards = std::stoull(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.users == 0 || opts.threads == 0) throw std::invalid_argument("users and threads must be > 0");
+    } catch (const std::exception& ex) {
+        std::cerr << "presence_bench: " << ex.what() << "\n"
+                  << "usage: presence_bench [--users N] [--threads N] [--churn FRACTION] [--seconds S] [--shards N]\n";
+        return 2;
+    }
+
+    std::cout << "presence_bench: " << opts.users << " users, " << opts.threads << " threads, churn "
+              << opts.churn << ", " << std::thread::hardware_concurrency() << " cpus\n";
+
+    {
+        const auto before = rss_kb();
+        ConnectionRegistry registry;
+        auto connection = std::make_shared<NullConnection>();
+        for (std::size_t u = 1; u <= opts.users; ++u) {
+            registry.add(static_cast<std::int64_t>(u), connection);
+        }
+        const auto after = rss_kb();
+        std::cout << "memory:   " << std::fixed << std::setprecision(1)
+                  << static_cast<double>(after - before) * 1024.0 / static_cast<double>(opts.users)
+                  << " bytes per online user (entry + hash node), sizeof(ConnectionList) = "
+                  << sizeof(ConnectionList) << "\n";
+    }
+
+    std::cout << std::setw(8) << "shards" << std::setw(18) << "lookups/s" << std::setw(18) << "churn ops/s" << "\n";
+    for (std::size_t shards : {std::size_t{1}, opts.shards}) {
+        auto r = run_churn(opts, shards);
+        std::cout << std::setw(8) << shards << std::setprecision(0) << std::setw(18) << r.lookupsPerSec
+                  << std::setw(18) << r.churnPerSec << "\n";
+    }
+    return 0;
+}
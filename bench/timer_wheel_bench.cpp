@@ -0,0 +1,187 @@
+// bench/timer_wheel_bench.cpp
+//
+// Бенчмарк сроков соединений: N взведённых таймеров (по умолчанию 1M — по таймеру
+// на соединение) на колесе TimingWheel против asio::steady_timer, которым раньше
+// пользовались beast::tcp_stream и websocket::stream.
+//   • память на взведённый таймер (RSS до/после);
+//   • взвод, перевзвод (keep-alive после каждого запроса) и снятие, нс на операцию;
+//   • тик колеса с N взведёнными таймерами, когда ничего не истекает
+//     (столько стоит простой io-потока), и нс на срабатывание таймера.
+// Всё в одном потоке, как в io-потоке сервера.
+//
+// Пример:
+//   ./timer_wheel_bench --timers 1000000
+
+#include "chatserver/infrastructure/concurrency/timing_wheel.h"
+
+#include <utility>
+#include <boost/asio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace net = boost::asio;
+using chatserver::infrastructure::concurrency::TimingWheel;
+using chatserver::infrastructure::concurrency::WheelTimer;
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Options {
+    std::size_t timers = 1'000'000;
+    std::chrono::milliseconds tick{100};
+};
+
+std::size_t rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+double ns_per(Clock::duration d, std::size_t ops) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) /
+           static_cast<double>(ops);
+}
+
+// Сроки как у соединений: от нескольких секунд (заголовки) до минут (keep-alive, ping).
+std::vector<std::chrono::milliseconds> make_delays(std::size_t n) {
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<int> dist(1'000, 120'000);
+    std::vector<std::chrono::milliseconds> delays(n);
+    for (auto& d : delays) d = std::chrono::milliseconds(dist(rng));
+    return delays;
+}
+
+void print_row(const char* name, double bytes, double arm, double rearm, double cancel) {
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << bytes << std::setw(12) << arm << std::setw(12) << rearm
+              << std::setw(12) << cancel << "\n";
+}
+
+void bench_wheel(const Options& opts, const std::vector<std::chrono::milliseconds>& delays) {
+    const std::size_t n = opts.timers;
+    const auto start = Clock::now();
+    TimingWheel wheel(opts.tick, start);
+    std::size_t fired = 0;
+
+    const auto rssBefore = rss_kb();
+    std::unique_ptr<WheelTimer[]> timers(new WheelTimer[n]);
+    for (std::size_t i = 0; i < n; ++i) {
+        timers[i].set_handler([&fired] { ++fired; });
+    }
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) wheel.schedule(timers[i], delays[i]);
+    const auto arm = Clock::now() - t0;
+    const auto rssAfter = rss_kb();
+
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) wheel.schedule(timers[i], delays[n - 1 - i]);
+    const auto rearm = Clock::now() - t0;
+
+    // Простой: до ближайшего срока (1 с) ничего не истекает, тик лишь обходит пустой слот.
+    const std::size_t kIdleTicks = std::max<std::size_t>(1, 999ms / opts.tick);
+    t0 = Clock::now();
+    std::size_t idleFired = 0;
+    for (std::size_t t = 1; t <= kIdleTicks; ++t) idleFired += wheel.advance(start + opts.tick * t);
+    const auto idle = Clock::now() - t0;
+
+    // Срабатывание: проворачиваем колесо за самый дальний срок.
+    t0 = Clock::now();
+    wheel.advance(start + opts.tick * kIdleTicks + 121s);
+    const auto expire = Clock::now() - t0;
+
+    for (std::size_t i = 0; i < n; ++i) wheel.schedule(timers[i], delays[i]);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) timers[i].cancel();
+    const auto cancel = Clock::now() - t0;
+
+    print_row("timing wheel", static_cast<double>(rssAfter - rssBefore) * 1024.0 / static_cast<double>(n),
+              ns_per(arm, n), ns_per(rearm, n), ns_per(cancel, n));
+    std::cout << "  sizeof(WheelTimer) = " << sizeof(WheelTimer) << ", wheel itself "
+              << sizeof(TimingWheel) / 1024 << " KB; idle tick with " << n << " armed: "
+              << std::setprecision(2) << ns_per(idle, kIdleTicks) / 1000.0 << " us ("
+              << std::setprecision(6) << 100.0 * ns_per(idle, kIdleTicks) /
+                     static_cast<double>(std::chrono::nanoseconds(opts.tick).count())
+              << "% of one core at " << opts.tick.count() << " ms tick, " << idleFired << " fired); expiry "
+              << std::setprecision(1) << ns_per(expire, fired == 0 ? 1 : fired) << " ns per timer (" << fired
+              << " fired)\n";
+}
+
+void bench_asio(const Options& opts, const std::vector<std::chrono::milliseconds>& delays) {
+    const std::size_t n = opts.timers;
+    net::io_context ioc{1};
+    std::size_t completions = 0;
+    auto handler = [&completions](const boost::system::error_code&) { ++completions; };
+
+    const auto rssBefore = rss_kb();
+    std::vector<std::unique_ptr<net::steady_timer>> timers;
+    timers.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) timers.push_back(std::make_unique<net::steady_timer>(ioc));
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        timers[i]->expires_after(delays[i]);
+        timers[i]->async_wait(handler);
+    }
+    const auto arm = Clock::now() - t0;
+    const auto rssAfter = rss_kb();
+
+    // Перевзвод отменяет ожидание: старый обработчик выполнится с operation_aborted.
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        timers[i]->expires_after(delays[n - 1 - i]);
+        timers[i]->async_wait(handler);
+    }
+    ioc.poll();
+    const auto rearm = Clock::now() - t0;
+
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) timers[i]->cancel();
+    ioc.poll();
+    const auto cancel = Clock::now() - t0;
+
+    print_row("steady_timer", static_cast<double>(rssAfter - rssBefore) * 1024.0 / static_cast<double>(n),
+              ns_per(arm, n), ns_per(rearm, n), ns_per(cancel, n));
+    std::cout << "  sizeof(steady_timer) = " << sizeof(net::steady_timer)
+              << " + wait operation on the heap; per-timer heap of the reactor is O(log n)\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--timers") opts.timers = std::stoull(value());
+            else if (arg == "--tick-ms") opts.tick = std::chrono::milliseconds(std::stoll(value()));
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.timers == 0 || opts.tick.count() <= 0) throw std::invalid_argument("timers and tick must be > 0");
+    } catch (const std::exception& ex) {
+        std::cerr << "timer_wheel_bench: " << ex.what() << "\n"
+                  << "usage: timer_wheel_bench [--timers N] [--tick-ms MS]\n";
+        return 2;
+    }
+
+    std::cout << "timer_wheel_bench: " << opts.timers << " armed timers, delays 1..120 s\n"
+              << std::left << std::setw(14) << "" << std::right << std::setw(12) << "bytes/timer"
+              << std::setw(12) << "arm ns" << std::setw(12) << "re-arm ns" << std::setw(12) << "cancel ns" << "\n";
+    const auto delays = make_delays(opts.timers);
+    bench_wheel(opts, delays);
+    bench_asio(opts, delays);
+    return 0;
+}
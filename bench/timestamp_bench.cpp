@@ -0,0 +1,147 @@
+// bench/timestamp_bench.cpp
+//
+// Бенчмарк Timestamp::now() — время создания ставится на каждое сообщение:
+//   • нс на вызов для источников precise (system_clock), coarse (CLOCK_REALTIME_COARSE)
+//     и cached (фоновый ClockTicker) на 1 и нескольких потоках (--threads);
+//   • шаг часов: средняя разница между соседними различающимися значениями, то есть
+//     реальная точность created_at в каждом режиме.
+//
+// Пример:
+//   ./timestamp_bench --calls 20000000 --threads 1,4 --tick-us 1000
+
+#include "chatserver/domain/common/timestamp.h"
+#include "chatserver/infrastructure/concurrency/clock_ticker.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using chatserver::domain::Timestamp;
+using chatserver::domain::TimestampClock;
+using chatserver::infrastructure::concurrency::ClockTicker;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::size_t calls = 20'000'000;
+    // Вызовов now() на поток.
+    std::vector<unsigned> threads{1, 4};
+    std::chrono::microseconds tick{1000};
+};
+
+volatile std::int64_t gSink = 0;
+// Сумма значений уходит сюда, чтобы компилятор не выкинул цикл вызовов now().
+
+struct Run {
+    double nsPerCall = 0;
+    double stepUs = 0;
+    // Средний шаг между различающимися соседними значениями (на первом потоке).
+};
+
+Run run(unsigned threads, std::size_t calls) {
+    std::vector<std::int64_t> sinks(threads, 0);
+    std::vector<std::size_t> changes(threads, 0);
+    std::vector<std::int64_t> spans(threads, 0);
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            ++ready;
+            while (!go.load(std::memory_order_acquire)) {}
+            std::int64_t first = Timestamp::now().epoch_micros();
+            std::int64_t prev = first;
+            std::int64_t sum = 0;
+            std::size_t changed = 0;
+            for (std::size_t i = 0; i < calls; ++i) {
+                const auto v = Timestamp::now().epoch_micros();
+                changed += v != prev ? 1 : 0;
+                prev = v;
+                sum += v;
+            }
+            sinks[t] = sum;
+            changes[t] = changed;
+            spans[t] = prev - first;
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    const auto elapsed = Clock::now() - start;
+
+    Run result;
+    result.nsPerCall = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(calls);
+    result.stepUs = changes[0] > 0 ? static_cast<double>(spans[0]) / static_cast<double>(changes[0]) : 0;
+    gSink = sinks[0];
+    return result;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--calls") opts.calls = std::stoull(value());
+            else if (arg == "--tick-us") opts.tick = std::chrono::microseconds(std::stoll(value()));
+            else if (arg == "--threads") {
+                opts.threads.clear();
+                std::stringstream list(value());
+                for (std::string item; std::getline(list, item, ',');) opts.threads.push_back(std::stoul(item));
+            }
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.calls == 0 || opts.threads.empty() || opts.tick.count() <= 0) {
+            throw std::invalid_argument("calls, threads and tick must be positive");
+        }
+        for (const auto t : opts.threads) {
+            if (t == 0) throw std::invalid_argument("thread count must be positive");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "timestamp_bench: " << ex.what() << "\n"
+                  << "usage: timestamp_bench [--calls N] [--threads T1,T2,...] [--tick-us U]\n";
+        return 2;
+    }
+
+    std::cout << "timestamp_bench: " << opts.calls << " now() calls per thread, "
+              << std::thread::hardware_concurrency() << " hardware threads, tick "
+              << opts.tick.count() << " us\n"
+              << std::left << std::setw(10) << "clock" << std::right << std::setw(10) << "threads"
+              << std::setw(12) << "ns/call" << std::setw(14) << "step us" << "\n";
+
+    const std::pair<const char*, TimestampClock> modes[] = {
+        {"precise", TimestampClock::Precise},
+        {"coarse", TimestampClock::Coarse},
+        {"cached", TimestampClock::Cached},
+    };
+    for (const auto& [name, mode] : modes) {
+        std::unique_ptr<ClockTicker> ticker;
+        if (mode == TimestampClock::Cached) {
+            ticker = std::make_unique<ClockTicker>(opts.tick);
+        } else {
+            Timestamp::use_clock(mode);
+        }
+        for (const unsigned threads : opts.threads) {
+            const auto r = run(threads, opts.calls);
+            std::cout << std::left << std::setw(10) << name << std::right << std::setw(10) << threads
+                      << std::fixed << std::setprecision(2) << std::setw(12) << r.nsPerCall
+                      << std::setprecision(1) << std::setw(14) << r.stepUs << "\n";
+        }
+    }
+    Timestamp::use_clock(TimestampClock::Precise);
+    return 0;
+}
@@ -0,0 +1,116 @@
+// bench/username_filter_bench.cpp
+//
+// Бенчмарк фильтра занятых имён (UsernameFilter) для предпроверки /register:
+//   • память и измеренная доля ложных срабатываний на --users именах (по умолчанию 10M)
+//     для нескольких целевых долей (--fpr, через запятую);
+//   • стоимость add() и may_contain() в наносекундах;
+//   • для сравнения — цена того, что фильтр экономит: один PBKDF2 (OpenSSLPasswordHasher).
+// Имена — «user-<n>» для занятых и «guest-<n>» для проверяемых свободных, как у chatload.
+//
+// Пример:
+//   ./username_filter_bench --users 10000000 --probes 2000000 --fpr 0.01,0.001
+
+#include "chatserver/infrastructure/cache/username_filter.h"
+#include "chatserver/infrastructure/crypto/openssl_password_hasher.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::size_t users = 10'000'000;
+    std::size_t probes = 2'000'000;
+    std::vector<double> fprs{0.01, 0.001};
+};
+
+double ns_per(Clock::duration d, std::size_t n) {
+    return std::chrono::duration<double, std::nano>(d).count() / static_cast<double>(n);
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--users") opts.users = std::stoull(value());
+            else if (arg == "--probes") opts.probes = std::stoull(value());
+            else if (arg == "--fpr") {
+                opts.fprs.clear();
+                std::stringstream list(value());
+                for (std::string item; std::getline(list, item, ',');) opts.fprs.push_back(std::stod(item));
+            }
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.users == 0 || opts.probes == 0 || opts.fprs.empty()) {
+            throw std::invalid_argument("users, probes and fpr list must be non-empty");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "username_filter_bench: " << ex.what() << "\n"
+                  << "usage: username_filter_bench [--users N] [--probes P] [--fpr P1,P2,...]\n";
+        return 2;
+    }
+
+    std::cout << "username_filter_bench: " << opts.users << " names, " << opts.probes
+              << " probes of absent names\n"
+              << std::left << std::setw(10) << "target" << std::right << std::setw(12) << "measured"
+              << std::setw(12) << "estimated" << std::setw(6) << "k" << std::setw(12) << "bits/name"
+              << std::setw(10) << "MB" << std::setw(10) << "add ns" << std::setw(10) << "check ns" << "\n";
+
+    std::string name;
+    for (const double target : opts.fprs) {
+        cache::UsernameFilterOptions options;
+        options.expectedItems = opts.users;
+        options.falsePositiveRate = target;
+        cache::UsernameFilter filter(options);
+
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < opts.users; ++i) {
+            name.assign("user-").append(std::to_string(i));
+            filter.add(name);
+        }
+        const double addNs = ns_per(Clock::now() - start, opts.users);
+
+        std::size_t positives = 0;
+        start = Clock::now();
+        for (std::size_t i = 0; i < opts.probes; ++i) {
+            name.assign("guest-").append(std::to_string(i));
+            positives += filter.may_contain(name) ? 1 : 0;
+        }
+        const double checkNs = ns_per(Clock::now() - start, opts.probes);
+
+        const auto s = filter.stats();
+        std::cout << std::left << std::setw(10) << target << std::right << std::fixed
+                  << std::setprecision(5) << std::setw(12)
+                  << static_cast<double>(positives) / static_cast<double>(opts.probes)
+                  << std::setw(12) << s.estimatedFpr << std::setw(6) << s.hashes
+                  << std::setprecision(2) << std::setw(12)
+                  << static_cast<double>(s.bits) / static_cast<double>(opts.users)
+                  << std::setw(10) << static_cast<double>(s.bytes) / (1 << 20)
+                  << std::setprecision(1) << std::setw(10) << addNs << std::setw(10) << checkNs << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    // Что экономит «точно занято»: один хэш пароля (и INSERT, упавший на UNIQUE).
+    crypto::OpenSSLPasswordHasher hasher;
+    constexpr int kHashes = 5;
+    const auto start = Clock::now();
+    for (int i = 0; i < kHashes; ++i) hasher.hash("correct horse battery staple");
+    std::cout << "PBKDF2 hash (skipped for taken names): " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::milli>(Clock::now() - start).count() / kHashes
+              << " ms\n";
+    return 0;
+}
@@ -0,0 +1,246 @@
+// bench/ws_burst_bench.cpp
+//
+// Бенчмарк исходящих очередей WebSocket под всплесками:
+//   • burst — N подключённых получателей; всплеск = --burst-size кадров одному
+//     случайному пользователю подряд (активный пользователь в оживлённом чате).
+//     Сравниваются обычные клиенты (кадр = WebSocket-сообщение = запись в сокет)
+//     и клиенты с ?batch=1 (кадры, накопившиеся за время записи, — одна gather-запись).
+//     Отчёт: записей в сокет на сообщение (счётчики сервера), CPU процесса на сообщение.
+//   • stalled — получатель перестал читать, на него льётся --stall-mb мегабайт:
+//     сколько памяти держит сервер и сколько кадров отброшено по порогу.
+// Каждая запись сервера — async_write одного неподкреплённого (unmasked) сообщения:
+// пока в буфере сокета есть место, это ровно один sendmsg.
+//
+// Пример:
+//   ./ws_burst_bench --connections 1000 --bursts 2000 --burst-size 32
+
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+
+using namespace chatserver::infrastructure;
+
+namespace {
+
+struct Options {
+    std::size_t connections = 1'000;
+    std::size_t bursts = 2'000;
+    std::size_t burstSize = 32;
+    std::size_t stallMb = 256;
+};
+
+double cpu_seconds() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+std::size_t rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+// Клиент считает кадры в каждом сообщении по вхождениям "type":"message",
+// без полного разбора JSON.
+class Client : public std::enable_shared_from_this<Client> {
+public:
+    Client(net::io_context& ioc, std::atomic<std::size_t>& frames, std::atomic<std::size_t>& connected)
+        : ws_(ioc), frames_(frames), connected_(connected) {}
+
+    void start(const tcp::endpoint& endpoint, const std::string& target) {
+        target_ = target;
+        ws_.next_layer().async_connect(endpoint, [self = shared_from_this()](beast::error_code ec) {
+            if (ec) return;
+            self->ws_.async_handshake("127.0.0.1", self->target_, [self](beast::error_code ec) {
+                if (ec) return;
+                self->connected_.fetch_add(1, std::memory_order_relaxed);
+                self->do_read();
+            });
+        });
+    }
+
+private:
+    void do_read() {
+        ws_.async_read(buffer_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) return;
+            const auto data = beast::buffers_to_string(self->buffer_.data());
+            self->buffer_.consume(self->buffer_.size());
+            std::size_t count = 0;
+            static constexpr std::string_view kMarker = R"("type":"message")";
+            for (auto pos = data.find(kMarker); pos != std::string::npos; pos = data.find(kMarker, pos + 1)) {
+                ++count;
+            }
+            self->frames_.fetch_add(count, std::memory_order_release);
+            self->do_read();
+        });
+    }
+
+    websocket::stream<tcp::socket> ws_;
+    beast::flat_buffer buffer_;
+    std::atomic<std::size_t>& frames_;
+    std::atomic<std::size_t>& connected_;
+    std::string target_;
+};
+
+struct BurstResult {
+    double writesPerMessage = 0;
+    double cpuNsPerMessage = 0;
+    double messagesPerSecond = 0;
+};
+
+BurstResult run_bursts(const Options& opts, bool batch) {
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    http::HttpServerOptions serverOptions;
+    serverOptions.workerThreads = 1;
+    http::HttpServer server("127.0.0.1", 0, std::make_shared<http::HttpRouter>(), registry, serverOptions);
+    server.start();
+
+    net::io_context clientIoc{1};
+    std::atomic<std::size_t> frames{0}, connected{0};
+    std::vector<std::shared_ptr<Client>> clients;
+    const tcp::endpoint endpoint(net::ip::make_address("127.0.0.1"), server.port());
+    for (std::size_t i = 0; i < opts.connections; ++i) {
+        clients.push_back(std::make_shared<Client>(clientIoc, frames, connected));
+        clients.back()->start(endpoint, "/ws?user=" + std::to_string(i + 1) + (batch ? "&batch=1" : ""));
+    }
+    auto guard = net::make_work_guard(clientIoc);
+    std::thread clientThread([&] { clientIoc.run(); });
+    while (connected < opts.connections || registry->connection_count() < opts.connections) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::int64_t> userDist(1, static_cast<std::int64_t>(opts.connections));
+    auto frame = std::make_shared<const std::string>(
+        R"({"type":"message","id":1,"sender_id":1,"receiver_id":2,"text":")" + std::string(100, 'x') +
+        R"(","created_at":1700000000})");
+
+    const auto before = registry->outbound().snapshot();
+    const double cpuStart = cpu_seconds();
+    const auto wallStart = std::chrono::steady_clock::now();
+    const std::size_t total = opts.bursts * opts.burstSize;
+    for (std::size_t b = 0; b < opts.bursts; ++b) {
+        const auto user = userDist(rng);
+        for (std::size_t i = 0; i < opts.burstSize; ++i) {
+            registry->send_to_user(user, frame);
+        }
+    }
+    while (frames.load(std::memory_order_acquire) < total) {
+        std::this_thread::yield();
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    const double cpu = cpu_seconds() - cpuStart;
+    while (registry->outbound().snapshot().framesWritten - before.framesWritten < total) {
+        std::this_thread::yield();
+    }
+    const auto after = registry->outbound().snapshot();
+
+    guard.reset();
+    server.stop();
+    clientIoc.stop();
+    clientThread.join();
+    return {static_cast<double>(after.writeCalls - before.writeCalls) / static_cast<double>(total),
+            cpu * 1e9 / static_cast<double>(total),
+            static_cast<double>(total) / wall};
+}
+
+void run_stalled(const Options& opts) {
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    http::HttpServerOptions serverOptions;
+    serverOptions.workerThreads = 1;
+    http::HttpServer server("127.0.0.1", 0, std::make_shared<http::HttpRouter>(), registry, serverOptions);
+    server.start();
+
+    // Клиент подключается и больше не читает.
+    net::io_context ioc;
+    websocket::stream<tcp::socket> ws(ioc);
+    ws.next_layer().open(tcp::v4());
+    ws.next_layer().set_option(net::socket_base::receive_buffer_size(4096));
+    ws.next_layer().connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), server.port()));
+    ws.handshake("127.0.0.1", "/ws?user=1&batch=1");
+    while (!registry->is_online(1)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Каждый кадр — отдельная аллокация, как у настоящих сообщений.
+    const std::size_t frameBytes = 4096;
+    const std::size_t count = opts.stallMb * 1024 * 1024 / frameBytes;
+    const auto rssBefore = rss_kb();
+    for (std::size_t i = 0; i < count; ++i) {
+        registry->send_to_user(1, std::make_shared<const std::string>(std::string(frameBytes, 'x')));
+    }
+    for (;;) {
+        const auto s = registry->outbound().snapshot();
+        if (s.framesQueued + s.framesDropped >= count) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    const auto rssAfter = rss_kb();
+    const auto stats = registry->outbound().snapshot();
+    std::cout << "stalled:  " << opts.stallMb << " MB pushed to a reader that stopped reading: "
+              << stats.framesDropped << " of " << count << " frames dropped, " << stats.slowConsumers
+              << " slow-consumer episode(s), RSS +" << (rssAfter > rssBefore ? (rssAfter - rssBefore) / 1024 : 0)
+              << " MB (high-water " << serverOptions.wsHighWaterBytes / 1024 << " KB)\n";
+    server.stop();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--connections") opts.connections = std::stoull(value());
+            else if (arg == "--bursts") opts.bursts = std::stoull(value());
+            else if (arg == "--burst-size") opts.burstSize = std::stoull(value());
+            else if (arg == "--stall-mb") opts.stallMb = std::stoull(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.connections == 0 || opts.bursts == 0 || opts.burstSize == 0) {
+            throw std::invalid_argument("connections, bursts and burst-size must be > 0");
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "ws_burst_bench: " << ex.what() << "\n"
+                  << "usage: ws_burst_bench [--connections N] [--bursts N] [--burst-size N] [--stall-mb N]\n";
+        return 2;
+    }
+
+    std::cout << "ws_burst_bench: " << opts.connections << " connections, " << opts.bursts << " bursts of "
+              << opts.burstSize << " frames\n"
+              << std::setw(10) << "mode" << std::setw(18) << "writes/message" << std::setw(18)
+              << "cpu ns/message" << std::setw(16) << "messages/s" << "\n";
+    for (bool batch : {false, true}) {
+        const auto r = run_bursts(opts, batch);
+        std::cout << std::setw(10) << (batch ? "batch=1" : "plain") << std::fixed << std::setprecision(3)
+                  << std::setw(18) << r.writesPerMessage << std::setprecision(0) << std::setw(18)
+                  << r.cpuNsPerMessage << std::setw(16) << r.messagesPerSecond << "\n";
+    }
+    run_stalled(opts);
+    return 0;
+}
@@ -0,0 +1,272 @@
+// bench/ws_fanout_bench.cpp
+//
+// Бенчмарк доставки по WebSocket: задержка от SendMessageHandler::handle()
+// до прихода кадра в клиентский сокет при N простаивающих соединениях.
+//   • single — по одному сообщению случайному получателю, следующее после доставки;
+//   • burst  — пачка сообщений разным получателям подряд, задержка каждого
+//              и время до доставки последнего.
+// Сервер (HttpServer + InMemory-репозитории) и клиенты работают в одном процессе
+// через loopback. Клиенты подключаются к 127.0.0.1..127.0.0.8, чтобы 100k
+// соединений не упёрлись в диапазон эфемерных портов одного адреса.
+//
+// Пример:
+//   ./ws_fanout_bench --connections 10000
+//   ./ws_fanout_bench --connections 100000 --io-threads 4
+// Каждое соединение — два дескриптора (клиент и сервер): для 100k нужен
+// ulimit -n не меньше ~200100 (бенчмарк поднимает мягкий лимит до жёсткого).
+
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using Clock         = std::chrono::steady_clock;
+
+using namespace chatserver::infrastructure;
+
+namespace {
+
+struct Options {
+    std::size_t connections = 10'000;
+    std::size_t messages = 2'000;
+    std::size_t burst = 1'000;
+    std::size_t ioThreads = 1;
+};
+
+std::size_t rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Клиентская сторона: текст сообщения — момент отправки (steady_clock, нс).
+// Кадр не разбирается целиком: задержка клиента не должна попадать в замер.
+struct Deliveries {
+    std::vector<double> latencyUs;
+    std::atomic<std::size_t> received{0};
+    std::atomic<std::size_t> connected{0};
+    std::atomic<std::size_t> failed{0};
+};
+
+class Client : public std::enable_shared_from_this<Client> {
+public:
+    Client(net::io_context& ioc, Deliveries& out) : ws_(ioc), out_(out) {}
+
+    void start(const tcp::endpoint& endpoint, std::int64_t userId, std::function<void()> onReady) {
+        onReady_ = std::move(onReady);
+        target_ = "/ws?user=" + std::to_string(userId);
+        ws_.next_layer().async_connect(endpoint, [self = shared_from_this()](beast::error_code ec) {
+            if (ec) return self->fail();
+            self->ws_.async_handshake("127.0.0.1", self->target_, [self](beast::error_code ec) {
+                if (ec) return self->fail();
+                self->out_.connected.fetch_add(1, std::memory_order_relaxed);
+                self->ready();
+                self->do_read();
+            });
+        });
+    }
+
+private:
+    void fail() {
+        out_.failed.fetch_add(1, std::memory_order_relaxed);
+        ready();
+    }
+
+    void ready() {
+        if (onReady_) {
+            auto cb = std::move(onReady_);
+            onReady_ = nullptr;
+            cb();
+        }
+    }
+
+    void do_read() {
+        ws_.async_read(buffer_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) return;
+            const auto receivedAt = now_ns();
+            const auto frame = beast::buffers_to_string(self->buffer_.data());
+            self->buffer_.consume(self->buffer_.size());
+            const auto pos = frame.find("\"text\":\"");
+            std::int64_t sentAt = 0;
+            if (pos != std::string::npos) {
+                const char* begin = frame.data() + pos + 8;
+                std::from_chars(begin, frame.data() + frame.size(), sentAt);
+            }
+            self->out_.latencyUs.push_back(static_cast<double>(receivedAt - sentAt) / 1000.0);
+            self->out_.received.fetch_add(1, std::memory_order_release);
+            self->do_read();
+        });
+    }
+
+    websocket::stream<tcp::socket> ws_;
+    beast::flat_buffer buffer_;
+    Deliveries& out_;
+    std::string target_;
+    std::function<void()> onReady_;
+};
+
+struct Summary {
+    double p50 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+Summary summarize(std::vector<double> us) {
+    if (us.empty()) return {};
+    std::sort(us.begin(), us.end());
+    auto at = [&](double q) { return us[std::min(us.size() - 1, static_cast<std::size_t>(us.size() * q))]; };
+    return {at(0.5), at(0.99), at(0.999), us.back()};
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--connections") opts.connections = std::stoull(value());
+            else if (arg == "--messages") opts.messages = std::stoull(value());
+            else if (arg == "--burst") opts.burst = std::stoull(value());
+            else if (arg == "--io-threads") opts.ioThreads = std::stoull(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.connections == 0) throw std::invalid_argument("--connections must be > 0");
+    } catch (const std::exception& ex) {
+        std::cerr << "ws_fanout_bench: " << ex.what() << "\n"
+                  << "usage: ws_fanout_bench [--connections N] [--messages N] [--burst N] [--io-threads N]\n";
+        return 2;
+    }
+
+    rlimit limit{};
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < opts.connections * 2 + 100) {
+        std::cerr << "ws_fanout_bench: RLIMIT_NOFILE " << limit.rlim_cur << " is too low for "
+                  << opts.connections << " connections (need ~" << opts.connections * 2 + 100 << ")\n";
+        return 2;
+    }
+
+    // Сервер: InMemory-хранилище, чтобы замер показывал путь доставки, а не БД.
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("bench-secret");
+    auto repo = std::make_shared<repository::InMemoryMessageRepository>();
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    chatserver::application::SendMessageHandler handler(
+        encryptor, repo, std::make_shared<realtime::RealtimeMessageNotifier>(registry));
+    http::HttpServerOptions serverOptions;
+    serverOptions.ioThreads = opts.ioThreads;
+    serverOptions.workerThreads = 1;
+    http::HttpServer server("0.0.0.0", 0, std::make_shared<http::HttpRouter>(), registry, serverOptions);
+    server.start();
+
+    const auto rssBefore = rss_kb();
+
+    // Клиенты: один io-поток, не более 512 незавершённых handshake одновременно.
+    net::io_context clientIoc{1};
+    Deliveries deliveries;
+    deliveries.latencyUs.reserve(opts.messages + opts.burst);
+    std::vector<std::shared_ptr<Client>> clients;
+    clients.reserve(opts.connections);
+    std::size_t next = 0;
+    std::function<void()> launch = [&] {
+        if (next >= opts.connections) return;
+        const std::size_t i = next++;
+        tcp::endpoint endpoint(net::ip::address_v4(0x7F000001u + static_cast<std::uint32_t>(i % 8)), server.port());
+        auto client = std::make_shared<Client>(clientIoc, deliveries);
+        clients.push_back(client);
+        client->start(endpoint, static_cast<std::int64_t>(i) + 1, [&] { launch(); });
+    };
+    for (std::size_t i = 0; i < std::min<std::size_t>(512, opts.connections); ++i) {
+        net::post(clientIoc, launch);
+    }
+    auto guard = net::make_work_guard(clientIoc);
+    std::thread clientThread([&] { clientIoc.run(); });
+
+    const auto connectStart = Clock::now();
+    while (deliveries.connected + deliveries.failed < opts.connections ||
+           registry->connection_count() < deliveries.connected) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const double connectSeconds = std::chrono::duration<double>(Clock::now() - connectStart).count();
+    const auto rssAfter = rss_kb();
+    std::cout << "ws_fanout_bench: " << deliveries.connected << " idle connections (" << deliveries.failed
+              << " failed) in " << std::fixed << std::setprecision(1) << connectSeconds << " s, io threads "
+              << opts.ioThreads << "\n"
+              << "memory:   " << (rssAfter - rssBefore) / 1024 << " MB RSS for clients + server, "
+              << std::setprecision(2) << static_cast<double>(rssAfter - rssBefore) / std::max<std::size_t>(1, deliveries.connected)
+              << " KB per connection pair\n";
+    if (deliveries.connected == 0) return 1;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::int64_t> userDist(1, static_cast<std::int64_t>(opts.connections));
+    const std::int64_t sender = static_cast<std::int64_t>(opts.connections) + 1;
+
+    auto wait_for = [&](std::size_t count) {
+        while (deliveries.received.load(std::memory_order_acquire) < count) {
+            std::this_thread::yield();
+        }
+    };
+
+    // single: одно сообщение в полёте
+    for (std::size_t i = 0; i < opts.messages; ++i) {
+        handler.handle({sender, userDist(rng), std::to_string(now_ns()), std::nullopt});
+        wait_for(i + 1);
+    }
+    auto single = summarize({deliveries.latencyUs.begin(), deliveries.latencyUs.end()});
+
+    // burst: пачка без ожидания
+    const auto burstStart = Clock::now();
+    for (std::size_t i = 0; i < opts.burst; ++i) {
+        handler.handle({sender, userDist(rng), std::to_string(now_ns()), std::nullopt});
+    }
+    wait_for(opts.messages + opts.burst);
+    const double burstMs = std::chrono::duration<double, std::milli>(Clock::now() - burstStart).count();
+    auto burst = summarize({deliveries.latencyUs.begin() + static_cast<std::ptrdiff_t>(opts.messages),
+                            deliveries.latencyUs.end()});
+
+    std::cout << std::setprecision(1)
+              << "single:   " << opts.messages << " messages, p50 " << single.p50 << " us, p99 " << single.p99
+              << " us, p99.9 " << single.p999 << " us, max " << single.max << " us\n"
+              << "burst:    " << opts.burst << " messages, p50 " << burst.p50 << " us, p99 " << burst.p99
+              << " us, max " << burst.max << " us, all delivered in " << burstMs << " ms\n";
+
+    guard.reset();
+    server.stop();
+    clientIoc.stop();
+    clientThread.join();
+    return 0;
+}
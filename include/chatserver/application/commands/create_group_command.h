@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+// std::int64_t — удобный тип для идентификаторов.
+#include <vector>
+
+namespace chatserver::application {
+// CreateGroupCommand — намерение создать групповой чат с заданным составом.
+struct CreateGroupCommand {
+    std::vector<std::int64_t> member_ids;
+    // Участники группы (включая создателя). Повторы не считаются ошибкой.
+};
+
+}
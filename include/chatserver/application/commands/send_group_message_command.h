@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+// std::int64_t — удобный тип для идентификаторов.
+#include <string>
+// std::string — текст сообщения, пришедший извне.
+
+namespace chatserver::application {
+// SendGroupMessageCommand — намерение отправить сообщение в групповой чат.
+// В отличие от SendMessageCommand получатель — не пользователь, а группа:
+// сообщение сохраняется один раз и доставляется всем участникам, кроме отправителя.
+struct SendGroupMessageCommand {
+    std::int64_t sender_id;
+    // Отправитель; должен быть участником группы.
+    std::int64_t group_id;
+    // Группа (chat_groups.id).
+    std::string text;
+    // Текст сообщения в сыром виде.
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 // std::int64_t — удобный тип для идентификаторов.
+#include <optional>
 #include <string>
 // std::string — текст сообщения, пришедший извне.
 
@@ -19,10 +20,15 @@ struct SendMessageCommand {
     std::int64_t sender_id;
     // Идентификатор отправителя, пришедший извне.
     // Это еще не доменный UserId - просто число, полученное от клиента.
+    std::int64_t receiver_id;
+    // Идентификатор получателя. Вместе с sender_id определяет переписку.
     std::string text;
     // Текст сообщения в сыром виде.
     // В handler'e он будет преобразован в MessageText,
     // который уже проверяет инварианты (не пустой, корректный и т.д).
+    std::optional<std::string> idempotency_key;
+    // Ключ идемпотентности клиента (заголовок Idempotency-Key): повтор с тем же
+    // ключом от того же отправителя возвращает id уже сохранённого сообщения.
 };
 
 }
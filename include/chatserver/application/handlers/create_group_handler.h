@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "chatserver/application/commands/create_group_command.h"
+// CreateGroupCommand — состав новой группы.
+#include "chatserver/infrastructure/repository/group_repository.h"
+// GroupRepository — хранилище групп и их участников.
+
+namespace chatserver::application {
+// CreateGroupHandler — обработчик use-case "создать групповой чат".
+// Проверяет состав (id участников в допустимом диапазоне, группа не пустая
+// и не больше kMaxMembers) и сохраняет группу через репозиторий.
+class CreateGroupHandler {
+public:
+    static constexpr std::size_t kMaxMembers = 100'000;
+    // Верхняя граница состава: ограничивает стоимость рассылки одного сообщения.
+
+    explicit CreateGroupHandler(std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository);
+
+    std::int64_t handle(const CreateGroupCommand& command);
+    // Возвращает id созданной группы. std::invalid_argument — некорректный состав.
+
+private:
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository_;
+};
+
+}
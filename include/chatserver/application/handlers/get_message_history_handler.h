@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chatserver/application/queries/get_message_history_query.h"
+// GetMessageHistoryQuery — параметры страницы истории (peer, курсор, limit).
+#include "chatserver/domain/services/message_encryptor.h"
+// MessageEncryptor — расшифровывает тексты всей страницы одним decrypt_batch().
+#include "chatserver/infrastructure/repository/message_repository.h"
+// MessageRepository — keyset-выборка страницы через find_page().
+#include "chatserver/infrastructure/repository/group_repository.h"
+// GroupRepository — проверка членства перед чтением истории группы.
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+// ConversationCache — последние сообщения горячих переписок в памяти процесса.
+
+namespace chatserver::application {
+
+struct MessageHistoryItem {
+    std::int64_t id;
+    std::int64_t sender_id;
+    std::int64_t receiver_id;
+    std::string text;
+    // Уже расшифрованный текст.
+    std::int64_t created_at;
+    // Микросекунды от эпохи (Timestamp::epoch_micros()).
+    std::int64_t group_id = 0;
+    // 0 — личное сообщение; иначе receiver_id = 0, а сообщение принадлежит группе.
+};
+
+struct MessageHistoryPage {
+    std::vector<MessageHistoryItem> messages;
+    // Сообщения от новых к старым (id по убыванию).
+    bool has_more = false;
+    // true — за последним элементом есть ещё сообщения; его id и есть следующий курсор.
+};
+
+// GetMessageHistoryHandler — обработчик use-case "прочитать историю сообщений".
+// Читает страницу через репозиторий и расшифровывает её целиком одним вызовом.
+// С кэшем страница горячей переписки отдаётся из памяти, а промах первой страницы
+// загружает в кэш хвост переписки.
+// Как и остальные handler'ы, не знает ни о HTTP, ни о формате курсора.
+class GetMessageHistoryHandler {
+public:
+    static constexpr std::size_t kDefaultLimit = 50;
+    static constexpr std::size_t kMaxLimit = 500;
+    // Верхняя граница страницы: ответ и расшифровка остаются ограниченными по памяти.
+
+    GetMessageHistoryHandler(
+        std::shared_ptr<domain::services::MessageEncryptor> encryptor,
+        std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
+        std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository = nullptr,
+        std::shared_ptr<infrastructure::cache::ConversationCache> cache = nullptr
+    );
+
+    MessageHistoryPage handle(const GetMessageHistoryQuery& query) const;
+
+private:
+    std::shared_ptr<domain::services::MessageEncryptor> encryptor_;
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository_;
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository_;
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache_;
+    // nullptr — каждое чтение идёт в хранилище.
+
+    MessageHistoryPage page_from_cache(std::vector<infrastructure::cache::CachedMessage> rows,
+                                       std::size_t limit) const;
+};
+
+}
@@ -13,6 +13,8 @@
 #include "chatserver/domain/services/password_hasher.h"
 // PasswordHasher - доменный сервис, отвечающий за хэширование паролей.
 // Это часть доменной логики, а не инфраструктуры.
+#include "chatserver/infrastructure/cache/username_filter.h"
+// UsernameFilter - фильтр Блума занятых имён: предпроверка до хэширования пароля.
 namespace chatserver::application {
 // RegisterUserHandler - это обработчик use-case "Register User".
 // Он находится в application-слое и отвечает за:
@@ -26,20 +28,25 @@ class RegisterUserHandler {
 public:
     RegisterUserHandler(
         std::shared_ptr<domain::services::PasswordHasher> passwordHasher,
-        std::shared_ptr<infrastructure::repository::UserRepository> userRepository
+        std::shared_ptr<infrastructure::repository::UserRepository> userRepository,
+        std::shared_ptr<infrastructure::cache::UsernameFilter> usernameFilter = nullptr
     );
     // Внедрение зависимостей (Dependency Injection):
     //   • PasswordHasher — доменный сервис
     //   • UserRepository — инфраструктурный репозиторий
     //
+    //   • UsernameFilter — необязательный фильтр занятых имён
+    //
     // Handler сам ничего не создаёт — ему всё дают извне.
     // Это делает код тестируемым и независимым от инфраструктуры.
 
-    // Выполняет регистрацию пользователя. Бросает исключение в случае ошибки.
+    // Выполняет регистрацию пользователя. Бросает исключение в случае ошибки;
+    // занятое имя — UsernameTakenError.
     std::int64_t handle(const RegisterUserCommand& command);
     // Метод use-case:
     //   • принимает RegisterUserCommand (username + password),
-    //   • проверяет, что пользователь не существует,
+    //   • проверяет, что пользователь не существует (с фильтром — до хэширования:
+    //     «возможно, занято» подтверждается поиском, «точно свободно» — сразу дальше),
     //   • хэширует пароль,
     //   • создаёт доменную сущность User
     //   • сохраняет её через репозиторий,
@@ -54,6 +61,10 @@ private:
     std::shared_ptr<infrastructure::repository::UserRepository> userRepository_;
     // Репозиторий для работы с пользователями.
     // Handler не знает SQL, таблицы, соединения — это скрыто в реализации.
+
+    std::shared_ptr<infrastructure::cache::UsernameFilter> usernameFilter_;
+    // nullptr — без предпроверки: дубликат узнаётся только по отказу save()
+    // после дорогого PBKDF2.
 };
 
 }
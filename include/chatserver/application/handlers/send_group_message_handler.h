@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "chatserver/application/commands/send_group_message_command.h"
+// SendGroupMessageCommand — намерение отправить сообщение в группу (sender_id, group_id, text).
+#include "chatserver/domain/services/message_encryptor.h"
+// MessageEncryptor — шифрование текста перед сохранением.
+#include "chatserver/domain/services/message_notifier.h"
+// MessageNotifier — доставка сохранённого сообщения участникам.
+#include "chatserver/infrastructure/repository/group_repository.h"
+// GroupRepository — состав группы: проверка членства и список получателей.
+#include "chatserver/infrastructure/repository/message_repository.h"
+// MessageRepository — хранилище сообщений.
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+// ConversationCache — кэш горячих переписок (write-through).
+#include "chatserver/domain/message/message_id_generator.h"
+// MessageIdGenerator — id сообщения назначается до сохранения.
+
+namespace chatserver::application {
+// SendGroupMessageHandler — обработчик use-case "отправить сообщение в группу".
+// Стоимость отправки почти не растёт с размером группы: текст шифруется один раз,
+// сообщение сохраняется одной записью (ключ переписки — ConversationId::group),
+// а notifier получает сообщение вместе со списком участников и сериализует его
+// один раз для всех. На участника остаётся только постановка готового кадра в очередь.
+class SendGroupMessageHandler {
+public:
+    SendGroupMessageHandler(
+        std::shared_ptr<domain::services::MessageEncryptor> encryptor,
+        std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
+        std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository,
+        std::shared_ptr<domain::services::MessageNotifier> notifier = nullptr,
+        std::shared_ptr<infrastructure::cache::ConversationCache> cache = nullptr,
+        std::shared_ptr<domain::MessageIdGenerator> ids = nullptr
+    );
+
+    std::int64_t handle(const SendGroupMessageCommand& command);
+    // Возвращает id сохранённого сообщения.
+    //   • std::invalid_argument — невалидный id группы или пустой текст (400),
+    //   • GroupNotFoundError — группы нет (404),
+    //   • NotGroupMemberError — отправитель не участник (403).
+    // Отправитель уведомление о своём сообщении не получает.
+
+private:
+    std::shared_ptr<domain::services::MessageEncryptor> encryptor_;
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository_;
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository_;
+    std::shared_ptr<domain::services::MessageNotifier> notifier_;
+    // nullptr — только сохранение (участники читают историю).
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache_;
+    std::shared_ptr<domain::MessageIdGenerator> ids_;
+    // nullptr — id назначает хранилище.
+};
+
+}
@@ -10,6 +10,14 @@
 // MessageEncryptor — доменный сервис.
 // Он отвечает за шифрование текста сообщения перед сохранением.
 // Это часть доменной логики, а не инфраструктуры.
+#include "chatserver/domain/services/message_notifier.h"
+// MessageNotifier — доменный сервис доставки сохранённого сообщения получателю.
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+// ConversationCache — кэш горячих переписок, в который пишется сохранённое сообщение.
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+// IdempotencyTable — недавние ключи идемпотентности → id сохранённых сообщений.
+#include "chatserver/domain/message/message_id_generator.h"
+// MessageIdGenerator — доменный сервис, назначающий id сообщения до сохранения.
 #include "chatserver/infrastructure/repository/message_repository.h"
 // MessageRepository — интерфейс доступа к сообщениям.
 // Он находится в infrastructure, потому что знает о БД.
@@ -21,17 +29,26 @@ namespace chatserver::application {
 //   • вызов доменных сервисов (шифрование),
 //   • создание доменной сущности Message,
 //   • сохранение её через репозиторий,
+//   • уведомление получателя (если подключён notifier),
 //   • возврат ID созданного сообщения.
 // Он НЕ знает о HTTP, JSON, SQL — только о бизнес-процессе.
 class SendMessageHandler {
 public:
     SendMessageHandler(
         std::shared_ptr<domain::services::MessageEncryptor> encryptor,
-        std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository
+        std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
+        std::shared_ptr<domain::services::MessageNotifier> notifier = nullptr,
+        std::shared_ptr<infrastructure::cache::ConversationCache> cache = nullptr,
+        std::shared_ptr<infrastructure::cache::IdempotencyTable> idempotency = nullptr,
+        std::shared_ptr<domain::MessageIdGenerator> ids = nullptr
     );
     // Внедрение зависимостей (Dependency Injection):
     //   • MessageEncryptor — доменный сервис шифрования
     //   • MessageRepository — инфраструктурный репозиторий
+    //   • MessageNotifier — доставка в реальном времени (необязательно)
+    //   • ConversationCache — write-through в кэш истории (необязательно)
+    //   • IdempotencyTable — дедупликация повторов по idempotency_key (необязательно)
+    //   • MessageIdGenerator — id до сохранения вместо назначенного БД (необязательно)
     // Handler сам ничего не создаёт — ему всё дают извне.
     // Это делает код тестируемым и независимым от инфраструктуры.
 
@@ -41,9 +58,16 @@ public:
     //   • шифрует текст,
     //   • создаёт доменную сущность Message,
     //   • сохраняет её,
+    //   • передаёт сохранённое сообщение (с открытым текстом) notifier'у,
     //   • возвращает ID нового сообщения.
+    // С idempotency_key и таблицей повтор (в том числе одновременный) возвращает ID
+    // первого сообщения, не шифруя и не сохраняя ничего; тот же ключ с другим
+    // получателем или текстом — IdempotencyKeyReusedError.
 
 private:
+    std::int64_t send(const SendMessageCommand& command);
+    // Собственно отправка: шифрование, сохранение, кэш, доставка.
+
     std::shared_ptr<domain::services::MessageEncryptor> encryptor_;
     // Доменный сервис для шифрования текста.
     // Handler не знает, какой алгоритм используется — AES, RSA, ChaCha20 —
@@ -51,6 +75,14 @@ private:
     std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository_;
     // Репозиторий для работы с сообщениями.
     // Handler не знает SQL, таблицы, соединения — это скрыто в реализации.
+    std::shared_ptr<domain::services::MessageNotifier> notifier_;
+    // Доставка получателю. nullptr — только сохранение (получатель читает историю).
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache_;
+    // Кэш горячих переписок: сохранённое сообщение сразу попадает в хвост переписки.
+    std::shared_ptr<infrastructure::cache::IdempotencyTable> idempotency_;
+    // nullptr — idempotency_key игнорируется, каждый повтор сохраняется заново.
+    std::shared_ptr<domain::MessageIdGenerator> ids_;
+    // nullptr — id назначает хранилище (SERIAL в Postgres, счётчик в локальных).
 };
 
 }
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace chatserver::application {
+// GetMessageHistoryQuery — запрос на чтение (в отличие от команд, ничего не меняет).
+// Как и SendMessageCommand, это сырые данные от клиента: в handler'е они
+// превращаются в доменные UserId / MessageId.
+struct GetMessageHistoryQuery {
+    std::int64_t user_id;
+    std::int64_t peer_id;
+    // Участники переписки: чья история и с кем. Порядок не важен — ключ переписки
+    // строится из упорядоченной пары.
+    std::optional<std::int64_t> before_id;
+    // Курсор: id последнего сообщения предыдущей страницы. nullopt — первая страница.
+    std::size_t limit;
+    // Желаемый размер страницы; handler ограничивает его сверху.
+    std::optional<std::int64_t> group_id;
+    // История группового чата вместо личной переписки: peer_id тогда не используется,
+    // а user_id должен быть участником группы.
+};
+
+}
@@ -6,13 +6,31 @@
 #include "chatserver/application/handlers/register_user_handler.h"
 #include "chatserver/application/handlers/login_user_handler.h"
 #include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/create_group_handler.h"
+#include "chatserver/application/handlers/send_group_message_handler.h"
 #include "chatserver/infrastructure/http/http_server.h"
 #include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+#include "chatserver/infrastructure/cache/username_filter.h"
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/concurrency/clock_ticker.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+#include "chatserver/infrastructure/repository/message_partition_maintainer.h"
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/repository/pg_connection_pool.h"
+#include "chatserver/infrastructure/repository/pg_replica_router.h"
 
 // Forward declarations для ресурсов (чтобы не тянуть их заголовки здесь)
 namespace chatserver::infrastructure::http::resources {
     class UserResource;
     class MessageResource;
+    class AdminResource;
+    class GroupResource;
+    class LongPollResource;
 }
 
 namespace chatserver::bootstrap {
@@ -22,6 +40,39 @@ struct AppContext {
     std::shared_ptr<chatserver::application::RegisterUserHandler> registerHandler;
     std::shared_ptr<chatserver::application::LoginUserHandler> loginHandler;
     std::shared_ptr<chatserver::application::SendMessageHandler> sendMessageHandler;
+    std::shared_ptr<chatserver::application::GetMessageHistoryHandler> messageHistoryHandler;
+    std::shared_ptr<chatserver::application::CreateGroupHandler> createGroupHandler;
+    std::shared_ptr<chatserver::application::SendGroupMessageHandler> sendGroupMessageHandler;
+
+    // Realtime: открытые WebSocket-соединения по id пользователя
+    std::shared_ptr<chatserver::infrastructure::realtime::ConnectionRegistry> connections;
+    // Long-poll: ожидающие GET /messages/wait по id пользователя
+    std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> longPoll;
+    // Кэш горячих переписок (nullptr — выключен)
+    std::shared_ptr<chatserver::infrastructure::cache::ConversationCache> conversationCache;
+    // Кэш пользователей перед Postgres (nullptr — выключен или другое хранилище)
+    std::shared_ptr<chatserver::infrastructure::repository::CachingUserRepository> userCache;
+    // Фильтр занятых имён для /register (nullptr — выключен)
+    std::shared_ptr<chatserver::infrastructure::cache::UsernameFilter> usernameFilter;
+    // Недавние ключи Idempotency-Key /send_message (nullptr — выключено)
+    std::shared_ptr<chatserver::infrastructure::cache::IdempotencyTable> idempotency;
+    // Генератор id сообщений (nullptr — id назначает хранилище)
+    std::shared_ptr<chatserver::domain::MessageIdGenerator> messageIds;
+    // Write-behind outbox сообщений перед Postgres (nullptr — выключен)
+    std::shared_ptr<chatserver::infrastructure::repository::OutboxMessageRepository> outbox;
+    // Обслуживание партиций messages (nullptr — таблица не секционирована)
+    std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer> partitions;
+    // Шарды сообщений (nullptr — одна БД), их пулы соединений (Postgres) и обслуживание
+    // их партиций (пусто — не секционированы); индексы совпадают с кольцом
+    std::shared_ptr<chatserver::infrastructure::repository::ShardedMessageRepository> sharded;
+    std::vector<std::shared_ptr<chatserver::infrastructure::repository::PgConnectionPool>> shardPools;
+    std::vector<std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer>> shardPartitions;
+    // Маршрутизация чтений основной БД по репликам (nullptr — реплик нет)
+    std::shared_ptr<chatserver::infrastructure::repository::PgReplicaRouter> replicas;
+    // Тикер кэшированных часов для Timestamp::now() (nullptr — часы читаются напрямую)
+    std::shared_ptr<chatserver::infrastructure::concurrency::ClockTicker> clockTicker;
+    // Адаптивные лимиты одновременных запросов по классам маршрутов (nullptr — без лимита)
+    std::shared_ptr<chatserver::infrastructure::concurrency::AdmissionControl> admission;
 
     // HTTP infra
     std::shared_ptr<chatserver::infrastructure::http::HttpRouter> router;
@@ -30,6 +81,9 @@ struct AppContext {
     // Typed resources (рекомендуется — явный тип, проще читать и отлаживать)
     std::shared_ptr<chatserver::infrastructure::http::resources::UserResource> userResource;
     std::shared_ptr<chatserver::infrastructure::http::resources::MessageResource> messageResource;
+    std::shared_ptr<chatserver::infrastructure::http::resources::AdminResource> adminResource;
+    std::shared_ptr<chatserver::infrastructure::http::resources::GroupResource> groupResource;
+    std::shared_ptr<chatserver::infrastructure::http::resources::LongPollResource> longPollResource;
 
     // Дополнительный контейнер для хранения любых ресурсов (если нужно хранить разные типы)
     // Можно не использовать, если достаточно typed fields выше.
@@ -1,19 +1,135 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "chatserver/bootstrap/app_context.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+#include "chatserver/infrastructure/repository/message_partition_maintainer.h"
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/repository/pg_connection_pool.h"
+#include "chatserver/infrastructure/repository/pg_replica_router.h"
+#include "chatserver/infrastructure/sharding/hash_ring.h"
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+#include "chatserver/infrastructure/cache/username_filter.h"
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+#include "chatserver/domain/common/timestamp.h"
 
 namespace chatserver::bootstrap {
 
+enum class StorageBackend {
+    Postgres,
+    // PostgresUserRepository / PostgresMessageRepository — основной режим.
+    InMemory,
+    // InMemoryUserRepository / InMemoryMessageRepository — нагрузочные тесты,
+    // бенчмарки и single-node режим: задержка БД не влияет на замеры CPU сервера.
+    EmbeddedLog,
+    // LogMessageRepository — сообщения в локальном журнале на диске (edge без Postgres).
+    // Пользователи и группы пока хранятся в памяти (InMemoryUserRepository, InMemoryGroupRepository).
+};
+
+struct MessageShardingOptions {
+    std::vector<infrastructure::sharding::ShardSpec> shards;
+    // Шарды сообщений на консистентном кольце. Пусто — сообщения в основной БД.
+    std::map<std::string, std::string> connections;
+    // Имя шарды → строка подключения (storage = postgres). storage = memory —
+    // шарды в памяти (InMemoryShardRepository), строки не нужны.
+    std::vector<infrastructure::sharding::ShardMove> moves;
+    // Переносы диапазонов поверх кольца (tools/chatshard).
+    infrastructure::repository::ShardKey key = infrastructure::repository::ShardKey::Conversation;
+    infrastructure::repository::PgPoolOptions pool;
+    // Пул соединений каждой шарды.
+    std::size_t readThreads = 4;
+    // Общий пул чтения истории с нескольких шард; 0 — шарды читаются по очереди.
+};
+
+struct StorageOptions {
+    StorageBackend backend = StorageBackend::Postgres;
+    infrastructure::repository::LogStoreOptions log;
+    // Используется только для StorageBackend::EmbeddedLog.
+    infrastructure::cache::ConversationCacheOptions conversationCache;
+    // Кэш горячих переписок перед любым хранилищем; budgetBytes == 0 — без кэша.
+    infrastructure::repository::UserCacheOptions userCache;
+    // Кэш find_by_username перед PostgresUserRepository; capacity == 0 — без кэша.
+    infrastructure::cache::UsernameFilterOptions usernameFilter;
+    // Фильтр занятых имён для /register, заполняется из хранилища при старте;
+    // expectedItems == 0 — без фильтра.
+    infrastructure::cache::IdempotencyOptions idempotency;
+    // Ключи Idempotency-Key для /send_message; capacity == 0 — повторы не распознаются.
+    std::int64_t messageIdNode = -1;
+    // Номер узла для MessageIdGenerator (0..1023, уникален среди узлов одной БД):
+    // id сообщений назначает сервер, INSERT без RETURNING. Только для Postgres;
+    // -1 — id назначает последовательность БД.
+    infrastructure::repository::OutboxOptions outbox;
+    // Write-behind outbox перед PostgresMessageRepository: /send_message отвечает после
+    // записи в локальный файл. directory пустой — выключен; нужен messageIdNode ≥ 0.
+    infrastructure::repository::PartitionOptions partitions;
+    // messages секционирована по created_at (только Postgres): фоновое создание и
+    // удаление партиций, условие на created_at в запросах истории. None — обычная таблица.
+    std::chrono::hours historyRecentWindow{24 * 7};
+    // Окно первого запроса истории по секционированной таблице (HistoryPruningOptions).
+    MessageShardingOptions sharding;
+    // Сообщения на нескольких БД (ShardedMessageRepository); нужен messageIdNode ≥ 0.
+    std::vector<std::string> replicas;
+    // Строки подключения реплик основной БД (только Postgres): find_by_username и
+    // история (без шард) читаются с них через PgReplicaRouter. Пусто — всё в primary,
+    // соединение на запрос, как раньше.
+    infrastructure::repository::ReplicaOptions replicaRouting;
+    // Выбор реплики, допустимое отставание, окно read-your-writes; pool — пулы primary
+    // и каждой реплики.
+    domain::TimestampClock timestampClock = domain::TimestampClock::Precise;
+    // Часы для created_at новых сообщений (Timestamp::now()), см. domain::TimestampClock.
+    std::chrono::microseconds timestampTick{1000};
+    // Период тикера для TimestampClock::Cached.
+};
+
+StorageBackend parse_storage_backend(const std::string& name);
+// "postgres" | "memory" | "log" → StorageBackend. Неизвестное значение — std::invalid_argument.
+
+infrastructure::repository::FsyncPolicy parse_fsync_policy(const std::string& name);
+// "always" | "group" | "interval" → FsyncPolicy.
+
+infrastructure::http::SlowConsumerPolicy parse_slow_consumer_policy(const std::string& name);
+// "throttle" | "disconnect" → SlowConsumerPolicy.
+
+infrastructure::cache::CachedTextForm parse_cached_text_form(const std::string& name);
+// "plain" | "encrypted" → CachedTextForm.
+
+domain::TimestampClock parse_timestamp_clock(const std::string& name);
+// "precise" | "coarse" | "cached" → TimestampClock.
+
+std::unordered_map<std::string, std::chrono::milliseconds> parse_route_deadlines(const std::string& list);
+// "/send_message:2000,/messages:1000" → бюджеты маршрутов (HttpServerOptions::routeDeadlines).
+
+std::unordered_map<std::string, std::string> parse_route_classes(const std::string& list);
+// "/send_message:write,/login:auth,/admin/storage:none" → классы маршрутов (AdmissionOptions).
+
 AppContext initialize_app(const std::string& dbConnStr,
                           const std::string& secret,
                           const std::string& address,
-                          int port);
+                          int port,
+                          const StorageOptions& storage = {},
+                          const infrastructure::http::HttpServerOptions& http = {},
+                          const infrastructure::concurrency::AdmissionOptions& admission = {});
+
+void shutdown_app(AppContext& ctx, std::chrono::milliseconds timeout);
+// Остановка после ctx.server->run() (или вместо него): HTTP-сервер останавливается,
+// outbox сливает подтверждённые сообщения в БД (до timeout), фоновые потоки
+// (партиции, замер реплик, тикер часов) останавливаются, простаивающие соединения
+// пулов закрываются, буферы stdout/stderr сбрасываются.
 
 void run_app(const std::string& dbConnStr,
              const std::string& secret,
              const std::string& address,
-             int port);
+             int port,
+             const StorageOptions& storage = {},
+             const infrastructure::http::HttpServerOptions& http = {},
+             const infrastructure::concurrency::AdmissionOptions& admission = {});
 
 } // namespace chatserver::bootstrap
-
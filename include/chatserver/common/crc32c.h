@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace chatserver::common {
+
+std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc = 0);
+// CRC-32C (Castagnoli), табличная реализация slicing-by-8.
+// crc — значение для продолжения подсчёта по частям: crc32c(b, n, crc32c(a, m)).
+
+}
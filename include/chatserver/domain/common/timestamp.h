@@ -12,9 +12,24 @@ namespace chatserver::domain {
 // Открываем пространство имён domain внутри chatserver.
 // Здесь находятся сущности предметной области (DDD).
 
+enum class TimestampClock {
+    // Источник времени для Timestamp::now().
+    Precise,
+    // system_clock::now() на каждый вызов — точное время с микросекундами.
+    Coarse,
+    // CLOCK_REALTIME_COARSE: время последнего тика ядра (шаг 1–4 мс), читается из vDSO
+    // без обращения к источнику часов. Где такого нет — как Precise.
+    Cached,
+    // Значение, которое публикует фоновый тикер (concurrency::ClockTicker) через
+    // Timestamp::publish_cached(). Точность — период тикера; без тикера — как Precise.
+};
+
 class Timestamp {
-    // Класс представляет собой обертку над временем в секундах от эпохи Unix.
+    // Класс представляет собой обертку над временем в микросекундах от эпохи Unix.
     // Используется как Value Object в доменной модели.
+    // Микросекунды упорядочивают сообщения внутри одной секунды; при грубых часах
+    // (Coarse / Cached) сообщения одного тика получают одинаковое время — порядок
+    // внутри тика задаёт id.
 public:
     using clock = std::chrono::system_clock;
     // Определяем псевдоним clock, чтобы явно указать, какие часы используются.
@@ -22,27 +37,46 @@ public:
 
     static Timestamp now();
     // Статический фабричный метод, создающий Timestamp с текущим временем.
-    // Реализация обычно вызывает clock::now() и преобразует в секунды.
+    // Источник времени — глобальный, см. use_clock(). Вызывается на каждое сообщение,
+    // поэтому выбор источника — один relaxed-load атомика.
+
+    static Timestamp precise_now();
+    // Всегда system_clock::now(), независимо от use_clock().
+
+    static void use_clock(TimestampClock source);
+    static TimestampClock current_clock();
+    // Выбор источника для now() на весь процесс. По умолчанию Precise.
+
+    static void publish_cached(Timestamp value);
+    // Тикер публикует время для TimestampClock::Cached.
 
     explicit Timestamp(std::int64_t epochSeconds);
     // Конструктор принимаетт количество секунд с 1 января 1970 года (Unix epoch).
     // explicit предотвращает неявные преобразования из int64_t в Timestamp.
 
+    static Timestamp from_micros(std::int64_t epochMicros);
+    // Timestamp из микросекунд от эпохи — так его хранят репозитории.
+
     std::int64_t epoch_seconds() const;
-    // Геттер, возвращающий внутреннее значение времени в секундах.
+    // Геттер, возвращающий время в целых секундах (с округлением вниз).
     // const гарантирует, что метод не изменяет объект.
 
+    std::int64_t epoch_micros() const;
+    // Полное значение в микросекундах от эпохи.
+
     bool operator==(const Timestamp& other) const;
-    // Оператор сравнения на равенство. Сравнивает два Timestamp по epochSeconds_.
+    // Оператор сравнения на равенство. Сравнивает два Timestamp по epochMicros_.
 
     bool operator<(const Timestamp& other) const;
     // Оператор меньше. Позволяет сортировать Timestamp и использовать в map/set.
 
 private:
-    std::int64_t epochSeconds_;
-    // Внутреннее хранение времени в секундах от эпохи.
-    // int64_t позволяет хранить даты на десятки тясяч лет вперед/назад.
+    struct Micros {};
+    Timestamp(Micros, std::int64_t epochMicros);
+
+    std::int64_t epochMicros_;
+    // Внутреннее хранение времени в микросекундах от эпохи.
+    // int64_t в микросекундах — это ±292 тысячи лет.
 };
 
 }
-
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+// Подключает фиксированные целочисленные типы, такие как std::int64_t.
+namespace chatserver::domain {
+// Пространство имен domain - слой предметной области (DDD).
+// GroupId - Value Object, представляющий идентификатор группового чата.
+class GroupId {
+// Класс инкапсулирует идентификатор группы как неизменяемое значение.
+// Диапазон проверяется там, где id становится ключом переписки
+// (ConversationId::group): как и UserId, он должен помещаться в 32 бита.
+public:
+    explicit GroupId(std::int64_t value);
+    // explicit предотвращает неявные преобразования из int64_t в GroupId
+    // и случайную подстановку UserId вместо GroupId.
+    std::int64_t value() const;
+    // Геттер, возвращающий внутреннее значение идентификатора.
+    bool operator==(const GroupId& other) const;
+    // Оператор сравнения на равенство.
+
+private:
+    std::int64_t value_;
+    // Внутреннее хранилище идентификатора группы (chat_groups.id).
+};
+
+}
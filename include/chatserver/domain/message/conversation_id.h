@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+// Подключает фиксированные целочисленные типы.
+#include "chatserver/domain/user/user_id.h"
+// Подключаем Value Object UserId - участники переписки.
+#include "chatserver/domain/group/group_id.h"
+// Подключаем Value Object GroupId - групповой чат тоже переписка.
+
+namespace chatserver::domain {
+// Пространство имен domain - слой предметной области (DDD).
+// ConversationId - Value Object, идентифицирующий переписку двух пользователей.
+
+class ConversationId {
+// Ключ переписки — упорядоченная пара участников (меньший id, больший id),
+// поэтому A→B и B→A попадают в одну переписку.
+// Пара упакована в одно 64-битное число: старшие 32 бита — меньший id,
+// младшие — больший. users.id в БД — SERIAL (int4), так что пара помещается
+// без потерь, а в messages ключ хранится одним BIGINT с индексом (conversation_id, id).
+// Ключ группового чата — id группы в младших битах при нулевых старших:
+// у пары пользователей меньший id >= 1, поэтому ключи не пересекаются.
+public:
+    static ConversationId between(const UserId& a, const UserId& b);
+    // Ключ переписки двух пользователей (порядок аргументов не важен).
+    // Бросает std::invalid_argument, если id вне диапазона [1, 2^32).
+
+    static ConversationId group(const GroupId& group);
+    // Ключ переписки группового чата.
+    // Бросает std::invalid_argument, если id группы вне диапазона [1, 2^32).
+
+    explicit ConversationId(std::int64_t value);
+    // Восстановление из сохранённого значения (БД, журнал).
+
+    std::int64_t value() const;
+    // Упакованное значение — то, что лежит в колонке conversation_id.
+
+    bool is_group() const;
+    // true — ключ группового чата (старшие 32 бита нулевые).
+
+    UserId low() const;
+    UserId high() const;
+    // Участники переписки: меньший и больший id. Для группового ключа не определены.
+
+    bool operator==(const ConversationId& other) const;
+
+private:
+    std::int64_t value_;
+};
+
+}
@@ -8,6 +8,11 @@
 // Подключаем Value Object UserId - идентификатор отправителя.
 #include "chatserver/domain/common/timestamp.h"
 // Подключаем Value Object Timestamp - время создания сообщения.
+#include "chatserver/domain/message/conversation_id.h"
+// Подключаем Value Object ConversationId - ключ переписки (пара участников).
+#include "chatserver/domain/group/group_id.h"
+// Подключаем Value Object GroupId - адресат группового сообщения.
+#include <optional>
 
 namespace chatserver::domain::message {
 // Пространство имен messgae внутри domain - логическая группировка
@@ -20,20 +25,35 @@ public:
     Message(
         MessageId id,
         UserId senderId,
+        UserId receiverId,
         MessageText text,
         Timestamp createdAt
     );
 
-    Message(UserId senderId, MessageText text, Timestamp createdAt);
+    Message(UserId senderId, UserId receiverId, MessageText text, Timestamp createdAt);
     // Основной конструктор сущности Message.
     // Используется при создании нового сообщения или загрузке из БД.
     // Все параметры передаются по значению, затем перемещаются в поля —
     // это упрощает вызов и позволяет использовать move semantics.
 
+    Message(MessageId id, UserId senderId, GroupId groupId, MessageText text, Timestamp createdAt);
+    Message(UserId senderId, GroupId groupId, MessageText text, Timestamp createdAt);
+    // Сообщение в групповой чат: адресовано группе, а не пользователю.
+    // receiver_id() у такого сообщения — UserId(0).
+
+    Message with_id(MessageId id) const;
+    // Копия сообщения с присвоенным id (репозиторий после сохранения).
+
     const MessageId& id() const;
     // Геттер, возвращающий ссылку на идентификатор сообщения.
     const UserId& sender_id() const;
     // Геттер, возвращающий идентификатор отправителя.
+    const UserId& receiver_id() const;
+    // Геттер, возвращающий идентификатор получателя (0 — групповое сообщение).
+    std::optional<GroupId> group_id() const;
+    // Группа, в которую отправлено сообщение; nullopt — личное сообщение.
+    ConversationId conversation_id() const;
+    // Ключ переписки отправителя и получателя (или группы) — по нему читается история.
     const MessageText& text() const;
     // Геттер, возвращающий текст сообщения.
     const Timestamp& created_at() const;
@@ -44,6 +64,11 @@ private:
     // Уникальный идентификатор сообщения — определяет сущность.
     UserId senderId_;
     // Идентификатор пользователя, который отправил сообщение.
+    UserId receiverId_;
+    // Идентификатор пользователя, которому адресовано сообщение.
+    std::int64_t groupId_ = 0;
+    // Групповой чат сообщения; 0 — личное сообщение. Хранится числом, а не
+    // std::optional<GroupId>, чтобы не раздувать сущность на 8 байт.
     MessageText text_;
     // Текст сообщения — Value Object, всегда валидный.
     Timestamp createdAt_;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include "chatserver/domain/message/message_id.h"
+
+namespace chatserver::domain {
+
+class MessageIdGenerator {
+// Доменный сервис: выдаёт MessageId до сохранения (в стиле Snowflake), чтобы
+// хранилище не назначало id само и запись не ждала RETURNING id.
+//
+// Раскладка 64-битного id (старший бит всегда 0, id положительны):
+//   [41 бит: мс от kEpochMs][10 бит: номер узла][12 бит: последовательность]
+// 41 бит миллисекунд — ~69 лет от 2024-01-01; 4096 id на узел в миллисекунду.
+//
+// Монотонность в пределах узла: состояние (мс << 12 | последовательность) — одно
+// атомарное слово, следующее значение = max(предыдущее + 1, текущее время << 12),
+// публикуется CAS (без блокировок). Поэтому:
+//   • id строго растут во всех потоках узла, а не только внутри потока;
+//   • при переполнении последовательности id «занимает» следующую миллисекунду
+//     вместо ожидания — часы генератора ненадолго забегают вперёд;
+//   • если системные часы идут назад, id продолжают расти от последнего выданного.
+// Id разных узлов различаются полем узла; их общий порядок — порядок по времени
+// с точностью до расхождения часов узлов.
+//
+// id растут быстрее, чем SERIAL, и больше 2^53: JavaScript-клиентам нужно читать их
+// как строки или BigInt.
+public:
+    static constexpr int kSequenceBits = 12;
+    static constexpr int kNodeBits = 10;
+    static constexpr std::int64_t kMaxNode = (std::int64_t{1} << kNodeBits) - 1;
+    static constexpr std::int64_t kEpochMs = 1'704'067'200'000;
+    // 2024-01-01T00:00:00Z в мс Unix-времени.
+
+    struct Parts {
+        std::int64_t unixMs = 0;
+        std::int64_t node = 0;
+        std::int64_t sequence = 0;
+    };
+
+    explicit MessageIdGenerator(std::int64_t node, std::function<std::int64_t()> unixMsClock = nullptr);
+    // node — 0..kMaxNode, уникален среди узлов, пишущих в одно хранилище
+    // (иначе std::invalid_argument). unixMsClock — источник времени в мс для тестов;
+    // по умолчанию system_clock.
+
+    MessageId next();
+
+    void advance_past(MessageId issued);
+    // Следующие id будут больше issued. После рестарта id, выданные прошлым запуском
+    // «в долг» (переполнение последовательности), ещё могут быть впереди часов —
+    // например, у сообщений, которые write-behind outbox повторит при старте.
+
+    std::int64_t node() const { return node_; }
+
+    static MessageId compose(std::int64_t unixMs, std::int64_t node, std::int64_t sequence);
+    // Id с заданным временем: для импорта старых сообщений, чтобы их место в
+    // истории (ORDER BY id) соответствовало created_at. unixMs раньше kEpochMs,
+    // node вне 0..kMaxNode — std::invalid_argument; sequence берётся по модулю 4096.
+    // Уникальность — на вызывающем: генератор состояния не меняет.
+
+    static Parts decode(MessageId id);
+    // Разбор id на время, узел и последовательность (для отладки и миграций).
+
+private:
+    std::int64_t now_ms() const;
+
+    std::int64_t node_;
+    std::function<std::int64_t()> clock_;
+    alignas(64) std::atomic<std::uint64_t> state_{0};
+    // (мс от kEpochMs << kSequenceBits) | последовательность последнего выданного id.
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace chatserver::domain::services {
 // Пространство имён services - слой доменных сервисов (DDD).
@@ -21,6 +22,14 @@ public:
     // Чисто виртуальный метод.
     // Принимает зашифрованный текст и возвращает расшифрованную строку.
     // Контракт симметричен encrypt().
+    virtual std::vector<std::string> encrypt_batch(const std::vector<std::string>& plainTexts) const;
+    // Шифрует пачку сообщений (массовый импорт) за один вызов; порядок сохраняется.
+    // По умолчанию — encrypt() для каждого элемента.
+    virtual std::vector<std::string> decrypt_batch(const std::vector<std::string>& cipherTexts) const;
+    // Расшифровывает пачку сообщений (например, страницу истории) за один вызов.
+    // Результат — в том же порядке, что и вход. Реализация по умолчанию вызывает
+    // decrypt() для каждого элемента; конкретные шифраторы переопределяют её,
+    // чтобы разделить подготовку ключа и контекста шифра на всю пачку.
 };
 
 }
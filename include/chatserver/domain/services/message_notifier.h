@@ -0,0 +1,30 @@
+#pragma once
+
+#include "chatserver/domain/message/message.h"
+// Подключаем сущность Message — то, о чём уведомляем получателя.
+#include "chatserver/domain/user/user_id.h"
+
+#include <vector>
+namespace chatserver::domain::services {
+// Пространство имён services - слой доменных сервисов (DDD).
+class MessageNotifier {
+// Абстрактный доменный сервис доставки: "получатель должен узнать о новом сообщении".
+// Домен не знает, как именно — WebSocket, long-poll, push-уведомление;
+// конкретная реализация находится в инфраструктурном слое.
+public:
+    virtual ~MessageNotifier() = default;
+    // Виртуальный деструктор по умолчанию.
+    virtual void message_stored(const chatserver::domain::message::Message& message) = 0;
+    // Вызывается после того, как сообщение сохранено (у него уже есть id).
+    // message.text() — открытый текст: именно его видит получатель.
+    // Доставка best-effort: сообщение уже в хранилище, и клиент, который был
+    // не в сети, получит его через историю. Реализация не должна блокироваться
+    // на медленном получателе — только поставить сообщение в очередь.
+    virtual void group_message_stored(const chatserver::domain::message::Message& message,
+                                      const std::vector<chatserver::domain::UserId>& recipients) = 0;
+    // Групповое сообщение (message.group_id() задан) для всех recipients сразу.
+    // Одно сообщение — одна сериализация: реализация строит представление
+    // сообщения один раз и раздаёт его всем получателям.
+};
+
+}
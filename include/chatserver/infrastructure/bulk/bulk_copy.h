@@ -0,0 +1,84 @@
+#pragma once
+
+#include "chatserver/infrastructure/bulk/bulk_rows.h"
+#include "chatserver/infrastructure/bulk/pg_copy_binary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chatserver::domain {
+class MessageIdGenerator;
+}
+namespace chatserver::domain::services {
+class MessageEncryptor;
+}
+
+namespace chatserver::infrastructure::bulk {
+// Перевод пачек строк импорта/экспорта в кортежи двоичного COPY и обратно.
+// Каждая функция работает с одной пачкой и не держит состояния, поэтому пачки
+// обрабатываются параллельно (concurrency::run_ordered_pipeline).
+
+inline constexpr std::string_view kMessageCopyIn =
+    "COPY messages (id, sender_id, receiver_id, group_id, conversation_id, text, created_at) "
+    "FROM STDIN (FORMAT binary)";
+// Колонка messages.id должна быть BIGINT (tools/migrate_db.sh): двоичный COPY не
+// приводит int8 к int4.
+inline constexpr std::string_view kUserCopyIn =
+    "COPY users (id, username, password_hash, created_at) FROM STDIN (FORMAT binary)";
+
+inline constexpr std::string_view kMessageCopyOut =
+    "COPY (SELECT id::BIGINT, sender_id, receiver_id, group_id, text, created_at FROM messages "
+    "WHERE receiver_id IS NOT NULL OR group_id IS NOT NULL ORDER BY id) TO STDOUT (FORMAT binary)";
+// Строки без получателя и группы (до миграции receiver_id) в историю не попадают
+// и не выгружаются.
+inline constexpr std::string_view kUserCopyOut =
+    "COPY (SELECT id::BIGINT, username::TEXT, password_hash, created_at FROM users ORDER BY id) "
+    "TO STDOUT (FORMAT binary)";
+
+struct BulkChunk {
+    std::vector<std::string> records;
+    std::vector<std::size_t> lines;
+    // Сырые записи входа (BulkRecordReader) и номера их строк — для ошибок.
+    std::vector<std::int64_t> ids;
+    // id для записей без своего id и без created_at, по одному на запись
+    // (reserve_message_ids). Пусто — генератора нет.
+    std::int64_t idNode = 0;
+    // Узел генератора: из него и created_at составляются id записей со временем.
+};
+
+void reserve_message_ids(BulkChunk& chunk, domain::MessageIdGenerator& ids);
+// Выдаёт chunk.ids. Зовётся в читающей (последовательной) стадии конвейера:
+// пачки получают id в порядке входа, и история, упорядоченная по id, сохраняет
+// порядок файла, хотя кодируют пачки параллельно.
+
+std::string encode_messages(const BulkChunk& chunk,
+                            const BulkRowParser& parser,
+                            const domain::services::MessageEncryptor& encryptor,
+                            std::int64_t nowUs);
+// Разбор, шифрование одним encrypt_batch и кортежи kMessageCopyIn. Запись без id
+// (пустой chunk.ids — ошибка) со своим created_at получает id из этого времени
+// (MessageIdGenerator::compose, последовательность — номер строки по модулю 4096: id
+// различны, если записи одной миллисекунды ближе 4096 строк друг к другу — так во
+// входе, отсортированном по времени), иначе chunk.ids[i]:
+// история упорядочена по id, и старое сообщение не должно встать выше сегодняшних.
+// created_at раньше 2024-01-01 в id не помещается — такой записи нужен свой id.
+// Записи без времени получают nowUs. Ошибка записи — std::invalid_argument("line N: ...").
+
+std::string encode_users(const BulkChunk& chunk, const BulkRowParser& parser, std::int64_t nowUs);
+// Кортежи kUserCopyIn. users.id — int4: id больше 2^31-1 — std::invalid_argument.
+
+BulkMessageRow message_from_copy(const PgCopyBinaryReader::Tuple& tuple);
+// Кортеж kMessageCopyOut; text — ещё шифртекст.
+BulkUserRow user_from_copy(const PgCopyBinaryReader::Tuple& tuple);
+
+std::string format_messages(std::vector<BulkMessageRow>& rows,
+                            const domain::services::MessageEncryptor& encryptor,
+                            BulkFormat format);
+// Расшифровывает тексты одним decrypt_batch (на месте) и форматирует пачку.
+// Нерасшифровываемый текст (другой ключ, битые данные) — std::runtime_error с id.
+std::string format_users(const std::vector<BulkUserRow>& rows, BulkFormat format);
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chatserver::infrastructure::bulk {
+
+enum class BulkFormat {
+    Ndjson,
+    // Объект JSON на строку: {"id":1,"sender_id":2,"receiver_id":3,"text":"..","created_at_us":..}
+    Csv,
+    // RFC 4180: первая строка — заголовок с именами тех же полей в любом порядке;
+    // поле в кавычках может содержать запятые, кавычки ("") и переводы строк.
+};
+
+BulkFormat parse_bulk_format(const std::string& name);
+// "ndjson" | "csv"; иначе std::invalid_argument.
+
+struct BulkMessageRow {
+    std::int64_t id = 0;
+    // 0 — не задан (назначит MessageIdGenerator).
+    std::int64_t senderId = 0;
+    std::optional<std::int64_t> receiverId;
+    std::optional<std::int64_t> groupId;
+    // Ровно одно из двух: личное или групповое сообщение.
+    std::string text;
+    // Открытый текст в файле; в БД — шифртекст.
+    std::optional<std::int64_t> createdAtUs;
+    // Микросекунды Unix-времени. На входе можно "created_at" в секундах.
+};
+
+struct BulkUserRow {
+    std::int64_t id = 0;
+    std::string username;
+    std::string passwordHash;
+    // Переносится как есть: пароли в выгрузку не попадают.
+    std::optional<std::int64_t> createdAtUs;
+};
+
+inline constexpr std::string_view kMessageCsvHeader = "id,sender_id,receiver_id,group_id,text,created_at_us\n";
+inline constexpr std::string_view kUserCsvHeader = "id,username,password_hash,created_at_us\n";
+
+class BulkRecordReader {
+// Делит вход на записи, не разбирая их: строку NDJSON или запись CSV (с учётом
+// переводов строк внутри кавычек). Разбор — BulkRowParser, его можно вести
+// параллельно в нескольких потоках.
+public:
+    BulkRecordReader(std::istream& in, BulkFormat format);
+    // Для CSV сразу читает заголовок (нет заголовка — std::invalid_argument).
+
+    bool next(std::string& record);
+    // false — вход кончился. Пустые строки пропускаются.
+
+    std::size_t line() const { return recordLine_; }
+    // Номер строки входа, с которой началась последняя запись (с 1) — для сообщений об ошибках.
+
+    const std::vector<std::string>& header() const { return header_; }
+
+private:
+    std::istream& in_;
+    BulkFormat format_;
+    std::vector<std::string> header_;
+    std::size_t lineNo_ = 0;
+    std::size_t recordLine_ = 0;
+};
+
+class BulkRowParser {
+// Разбор одной записи. Неизвестные поля игнорируются; нет обязательного поля,
+// не число там, где нужно число, и т. п. — std::invalid_argument.
+// id в NDJSON можно писать и числом, и строкой (id больше 2^53).
+public:
+    explicit BulkRowParser(BulkFormat format, std::vector<std::string> csvHeader = {});
+
+    BulkMessageRow message(std::string_view record) const;
+    BulkUserRow user(std::string_view record) const;
+
+private:
+    BulkFormat format_;
+    std::vector<std::string> header_;
+};
+
+void append_row(std::string& out, const BulkMessageRow& row, BulkFormat format);
+void append_row(std::string& out, const BulkUserRow& row, BulkFormat format);
+// Дописывает запись с завершающим '\n'. Заголовок CSV — kMessageCsvHeader / kUserCsvHeader.
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chatserver::infrastructure::bulk {
+// Массовая загрузка и выгрузка (tools/chatbulk): форматы строк и двоичный COPY Postgres.
+
+namespace pgcopy {
+// Двоичный формат COPY ... (FORMAT binary): сигнатура, затем кортежи
+//   [i16 число полей][i32 длина поля | -1 для NULL][байты поля]...
+// и завершающий i16 -1. Все числа — в сетевом порядке байт. Postgres не разбирает
+// текст и не переводит типы из строк, поэтому загрузка дешевле текстового COPY.
+// Типы полей должны точно совпадать с колонками: int8 — 8 байт, int4 — 4 байта,
+// timestamp — i64 микросекунд от 2000-01-01.
+
+constexpr std::int64_t kPostgresEpochUnixUs = 946'684'800'000'000;
+// 2000-01-01T00:00:00Z в микросекундах Unix-времени.
+
+void append_header(std::string& out);
+void append_trailer(std::string& out);
+void begin_tuple(std::string& out, std::int16_t fields);
+void append_int8(std::string& out, std::int64_t value);
+void append_int4(std::string& out, std::int32_t value);
+void append_text(std::string& out, std::string_view value);
+void append_timestamp(std::string& out, std::int64_t unixMicros);
+void append_null(std::string& out);
+
+std::int64_t read_int8(std::string_view field);
+std::int64_t read_timestamp(std::string_view field);
+// Микросекунды Unix-времени. Поле другой длины — std::runtime_error.
+
+}
+
+class PgCopyBinaryReader {
+// Разбирает поток COPY ... TO STDOUT (FORMAT binary), приходящий кусками
+// (PQgetCopyData отдаёт его порциями, граница кортежа может попасть куда угодно).
+public:
+    using Tuple = std::vector<std::optional<std::string_view>>;
+    // Поля кортежа; nullopt — NULL. string_view указывают во внутренний буфер и
+    // действительны до следующего feed().
+
+    void feed(const char* data, std::size_t size);
+
+    bool next(Tuple& tuple);
+    // false — в буфере нет целого кортежа (нужен feed) или поток закончился (finished()).
+    // Битая сигнатура или длина поля — std::runtime_error.
+
+    bool finished() const { return finished_; }
+    // Прочитан завершающий маркер.
+
+private:
+    std::string buffer_;
+    std::size_t pos_ = 0;
+    bool headerDone_ = false;
+    bool finished_ = false;
+};
+
+}
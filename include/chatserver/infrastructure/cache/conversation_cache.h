@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::cache {
+// Пространство имён для кэшей в памяти процесса.
+
+enum class CachedTextForm {
+    Plain,
+    // Расшифрованный текст: чтение горячей переписки не трогает ни хранилище, ни шифр.
+    Encrypted,
+    // Шифртекст как в хранилище: открытый текст не живёт в памяти дольше запроса,
+    // страница по-прежнему расшифровывается (decrypt_batch), но без похода в БД.
+};
+
+struct ConversationCacheOptions {
+    std::size_t budgetBytes = std::size_t{64} << 20;
+    // Общий бюджет памяти. Делится поровну между шардами, в каждом — своё LRU.
+    std::size_t messagesPerConversation = 64;
+    // Ёмкость кольца переписки: последние N сообщений (первая страница — 50).
+    CachedTextForm text = CachedTextForm::Plain;
+    std::chrono::seconds ttl{5};
+    // Срок записи от загрузки из хранилища. Write-through видит только сохранения этого
+    // процесса: сообщение, записанное другим узлом, появится в истории не позже чем
+    // через ttl. 0 — без срока, только для единственного узла.
+    std::size_t shards = 16;
+    // Число шардов (округляется вверх до степени двойки), у каждого свой мьютекс.
+};
+
+struct CachedMessage {
+    std::int64_t id = 0;
+    std::int64_t senderId = 0;
+    std::int64_t receiverId = 0;
+    std::int64_t groupId = 0;
+    // 0 — личное сообщение.
+    std::int64_t createdAt = 0;
+    // Микросекунды от эпохи.
+    std::string text;
+    // Открытый текст или шифртекст — в зависимости от CachedTextForm кэша.
+};
+
+struct ConversationCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    // Страницы, отданные из кэша, и запросы, ушедшие в хранилище.
+    std::uint64_t fills = 0;
+    // Переписки, загруженные в кэш после промаха.
+    std::uint64_t appends = 0;
+    // Сообщения, записанные в кэш при сохранении (write-through).
+    std::uint64_t evictions = 0;
+    // Переписки, вытесненные по бюджету памяти.
+    std::uint64_t expired = 0;
+    // Переписки, выброшенные по ttl (следующее чтение загрузит их заново).
+    std::size_t conversations = 0;
+    std::size_t messages = 0;
+    std::size_t bytes = 0;
+    std::size_t budgetBytes = 0;
+};
+
+class ConversationCache {
+// Кэш горячих переписок: последние сообщения каждой в кольце фиксированной ёмкости.
+// Большинство чтений истории — первая страница нескольких активных переписок; кэш
+// отдаёт её без запроса к хранилищу (и, в режиме Plain, без расшифровки).
+//
+// В кольце лежит непрерывный «хвост» переписки: все сообщения с id не меньше самого
+// старого из кольца. Страница отдаётся из кэша, только если она целиком лежит в
+// хвосте, — иначе промах и чтение из хранилища. Флаг complete — в кольце вся
+// переписка (она короче кольца), тогда из кэша отдаётся и короткая последняя страница.
+//
+// Заполнение — при промахе первой страницы: begin_fill() заводит пустую запись,
+// читатель загружает хвост из хранилища и передаёт его в complete_fill(). Сообщения,
+// сохранённые за это время (append), копятся в записи и вливаются в загруженное —
+// иначе сообщение, не попавшее в снимок, пропало бы из кэша.
+// append() для переписки, которой нет в кэше, ничего не делает: кэш заполняют чтения.
+//
+// Запись живёт ttl от заполнения: append() её не продлевает, потому что сохраняет
+// только сообщения этого процесса. Истёкшая запись удаляется при чтении — промах.
+//
+// Память: кольцо резервируется целиком при заполнении, плюс тексты. При превышении
+// бюджета шарда вытесняются переписки, которые дольше всех не читались и не писались.
+public:
+    explicit ConversationCache(ConversationCacheOptions options = {});
+
+    ConversationCache(const ConversationCache&) = delete;
+    ConversationCache& operator=(const ConversationCache&) = delete;
+
+    bool stores_plain_text() const;
+    std::size_t messages_per_conversation() const;
+
+    std::optional<std::vector<CachedMessage>> find_page(std::int64_t conversation,
+                                                        std::optional<std::int64_t> before,
+                                                        std::size_t limit);
+    // До limit сообщений переписки с id < before (без before — с конца), по убыванию id,
+    // как MessageRepository::find_page. nullopt — промах: страница не вся в кэше.
+
+    std::uint64_t begin_fill(std::int64_t conversation);
+    // Билет заполнения; 0 — заполнять не нужно (переписка уже в кэше или загружается).
+    void complete_fill(std::int64_t conversation, std::uint64_t ticket,
+                       std::vector<CachedMessage> newestFirst, bool wholeConversation);
+    // newestFirst — последние сообщения переписки из хранилища (по убыванию id);
+    // wholeConversation — старше них сообщений нет. Устаревший билет игнорируется.
+    void abort_fill(std::int64_t conversation, std::uint64_t ticket);
+    // Загрузка не удалась: убирает пустую запись.
+
+    void append(std::int64_t conversation, CachedMessage message);
+    // Write-through после успешного сохранения.
+
+    ConversationCacheStats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::vector<CachedMessage> ring;
+        std::size_t head = 0;
+        // Кольцо по возрастанию id начиная с head (самое старое).
+        bool complete = false;
+        Clock::time_point expires = Clock::time_point::max();
+        std::uint64_t loading = 0;
+        // Билет незавершённого заполнения; 0 — запись загружена.
+        std::vector<CachedMessage> pending;
+        // append() во время заполнения.
+        std::size_t textBytes = 0;
+        std::size_t bytes = 0;
+        std::list<std::int64_t>::iterator lru;
+
+        std::size_t size() const { return ring.size(); }
+        const CachedMessage& at(std::size_t i) const { return ring[(head + i) % ring.size()]; }
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::int64_t, Entry> entries;
+        std::list<std::int64_t> lru;
+        // Спереди — недавно использованные.
+        std::size_t bytes = 0;
+    };
+
+    Shard& shard_for(std::int64_t conversation) const;
+    void insert(Entry& entry, CachedMessage message);
+    void account(Shard& shard, Entry& entry);
+    void evict(Shard& shard);
+    void erase(Shard& shard, std::unordered_map<std::int64_t, Entry>::iterator it);
+
+    ConversationCacheOptions options_;
+    std::size_t shardBudget_ = 0;
+    std::size_t shardMask_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+
+    std::atomic<std::uint64_t> nextTicket_{1};
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> fills_{0};
+    std::atomic<std::uint64_t> appends_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> expired_{0};
+};
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace chatserver::infrastructure::cache {
+
+struct IdempotencyOptions {
+    std::size_t capacity = 100'000;
+    // Сколько выполненных ключей помнит таблица; 0 — таблица выключена.
+    std::chrono::seconds ttl{600};
+    // Сколько помнить ключ: окно, в котором повтор клиента ещё узнаётся.
+    std::size_t shards = 16;
+    // Число шардов (округляется вверх до степени двойки), у каждого свой мьютекс.
+};
+
+struct IdempotencyStats {
+    std::uint64_t executed = 0;
+    // Запросы, дошедшие до выполнения (первые с данным ключом).
+    std::uint64_t replayed = 0;
+    // Повторы, получившие сохранённый результат из таблицы.
+    std::uint64_t coalesced = 0;
+    // Повторы, дождавшиеся ещё выполняющегося первого запроса.
+    std::uint64_t mismatches = 0;
+    // Ключ пришёл с другим телом запроса (IdempotencyKeyReusedError).
+    std::uint64_t evictions = 0;
+    std::uint64_t expired = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t capacity = 0;
+};
+
+class IdempotencyKeyReusedError : public std::runtime_error {
+    // Тот же ключ с другим содержимым запроса: это не повтор, а ошибка клиента.
+public:
+    explicit IdempotencyKeyReusedError(const std::string& key)
+        : std::runtime_error("idempotency key reused with a different request: " + key) {}
+};
+
+class IdempotencyTable {
+// Таблица недавних ключей идемпотентности → id результата (например, сохранённого
+// сообщения). Повтор запроса с тем же ключом получает прежний id, не выполняясь.
+//
+// execute(key, fingerprint, run):
+//   • ключ выполнен и не истёк — сразу сохранённый id, run не вызывается;
+//   • ключ выполняется сейчас — ждём первый запрос и отдаём его результат
+//     (или его исключение: повтор клиента после ошибки выполнится заново);
+//   • иначе run() выполняется, id запоминается на ttl.
+// fingerprint — хэш содержимого запроса: тот же ключ с другим телом не подменяется
+// чужим результатом, а отклоняется IdempotencyKeyReusedError.
+//
+// Ёмкость ограничена: в шарде выполненные ключи идут в очереди по времени записи
+// (ttl у всех одинаковый), вставка сначала снимает истёкшие с головы, затем —
+// самые старые сверх ёмкости. Выполняющиеся ключи в очереди не стоят и не вытесняются.
+//
+// Таблица живёт в памяти процесса: повтор, пришедший на другой узел или после
+// рестарта, выполнится ещё раз.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        std::int64_t id = 0;
+        bool replayed = false;
+        // true — id взят из таблицы (сохранённый или совпавший с выполняющимся).
+    };
+
+    explicit IdempotencyTable(IdempotencyOptions options = {});
+
+    Result execute(const std::string& key, std::uint64_t fingerprint,
+                   const std::function<std::int64_t()>& run);
+
+    bool enabled() const { return options_.capacity > 0; }
+
+    IdempotencyStats stats() const;
+
+private:
+    struct Flight {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool finished = false;
+        std::int64_t id = 0;
+        std::exception_ptr error;
+    };
+
+    struct Entry {
+        std::uint64_t fingerprint = 0;
+        std::int64_t id = 0;
+        Clock::time_point expires{};
+        std::shared_ptr<Flight> flight;
+        // Не nullptr, пока первый запрос выполняется.
+    };
+
+    struct Completed {
+        std::string key;
+        Clock::time_point expires;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::deque<Completed> order;
+        // Выполненные ключи по времени записи. Запись могла устареть (ключ истёк и
+        // выполнен заново) — тогда expires не совпадёт с записью в entries.
+        std::size_t bytes = 0;
+    };
+
+    Shard& shard_for(const std::string& key) const;
+    void trim(Shard& shard, Clock::time_point now);
+
+    IdempotencyOptions options_;
+    std::size_t perShard_ = 0;
+    std::size_t shardMask_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+
+    std::atomic<std::uint64_t> executed_{0};
+    std::atomic<std::uint64_t> replayed_{0};
+    std::atomic<std::uint64_t> coalesced_{0};
+    std::atomic<std::uint64_t> mismatches_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> expired_{0};
+};
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace chatserver::infrastructure::cache {
+
+struct UsernameFilterOptions {
+    std::size_t expectedItems = 1'000'000;
+    // На сколько имён рассчитан фильтр; 0 — фильтр выключен. При переполнении
+    // доля ложных срабатываний растёт (см. UsernameFilterStats::estimatedFpr).
+    double falsePositiveRate = 0.01;
+    // Целевая доля ложных «возможно, занято» при expectedItems именах.
+};
+
+struct UsernameFilterStats {
+    std::uint64_t items = 0;
+    // Добавлено имён (повторы считаются: add() не знает, было ли имя).
+    std::uint64_t checks = 0;
+    std::uint64_t definitelyAbsent = 0;
+    // Проверки, после которых поиск пользователя не нужен.
+    std::uint64_t falsePositives = 0;
+    // «Возможно, занято», но пользователя не нашлось (сообщает вызывающий).
+    double estimatedFpr = 0;
+    // Ожидаемая доля ложных срабатываний при текущем items.
+    std::size_t bits = 0;
+    std::size_t hashes = 0;
+    std::size_t bytes = 0;
+};
+
+class UsernameFilter {
+// Фильтр Блума занятых имён пользователей — предпроверка для /register.
+//
+// Фильтр отвечает «точно нет» или «возможно, есть», поэтому решать сам он не может:
+//   • «точно нет» — имя свободно, проверочный поиск не нужен;
+//   • «возможно, есть» — вызывающий подтверждает поиском (find_by_username) и только
+//     тогда отказывает, не тратя время на хэш пароля.
+// Ложных «точно нет» не бывает для имён, прошедших через add(); имена, добавленные
+// мимо фильтра (другой узел, ручная вставка), он не видит — поэтому окончательное
+// слово всегда за UNIQUE(username) в хранилище, фильтр лишь экономит работу.
+//
+// Блочная схема: имя целиком попадает в один блок размером с кэш-линию (512 бит),
+// все k битов ставятся внутри него — одна линия на проверку вместо k случайных
+// обращений к памяти. Цена — чуть выше доля ложных срабатываний, чем у классического
+// фильтра того же размера; её компенсирует небольшой запас по числу бит.
+//
+// Биты — атомарные слова (fetch_or / load relaxed): add() и may_contain() идут из
+// воркеров без блокировок. Проверка, пересёкшаяся с add(), может ответить «точно нет» —
+// это безопасно по той же причине, что и имена с других узлов.
+public:
+    explicit UsernameFilter(UsernameFilterOptions options = {});
+
+    void add(std::string_view username);
+    bool may_contain(std::string_view username) const;
+
+    void note_false_positive();
+    // Вызывающий сообщает: «возможно, есть» не подтвердилось поиском.
+
+    UsernameFilterStats stats() const;
+
+private:
+    static constexpr std::size_t kBlockBits = 512;
+    static constexpr std::size_t kWordsPerBlock = kBlockBits / 64;
+
+    struct alignas(64) Block {
+        std::atomic<std::uint64_t> words[kWordsPerBlock];
+    };
+
+    struct Probe {
+        std::size_t block;
+        std::uint64_t bits;
+        // Источник позиций внутри блока: по 9 бит на позицию, исчерпанный — перемешивается.
+    };
+    Probe probe(std::string_view username) const;
+
+    std::size_t blocks_ = 0;
+    std::size_t hashes_ = 0;
+    std::unique_ptr<Block[]> bits_;
+
+    std::atomic<std::uint64_t> items_{0};
+    mutable std::atomic<std::uint64_t> checks_{0};
+    mutable std::atomic<std::uint64_t> definitelyAbsent_{0};
+    std::atomic<std::uint64_t> falsePositives_{0};
+};
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::concurrency {
+
+struct AdaptiveLimiterOptions {
+    std::size_t initialLimit = 32;
+    std::size_t minLimit = 4;
+    std::size_t maxLimit = 1024;
+    // Пределы лимита одновременных запросов класса.
+    double tolerance = 2.0;
+    // Задержка до tolerance × minRtt считается нормой: лимит не снижается.
+    double smoothing = 0.2;
+    // Доля нового значения при пересчёте лимита (сглаживание выбросов).
+    std::size_t windowSamples = 20;
+    // Лимит пересчитывается по средней задержке каждых windowSamples запросов.
+    std::size_t minRttResetWindows = 100;
+    // Раз в столько окон minRtt забывается и замеряется заново: иначе после разового
+    // очень быстрого ответа (или смены БД на более медленную) лимит остался бы низким.
+};
+
+struct AdaptiveLimiterStats {
+    std::size_t limit = 0;
+    std::size_t inFlight = 0;
+    std::uint64_t admitted = 0;
+    std::uint64_t shed = 0;
+    // Отказы (503) из-за исчерпанного лимита.
+    std::uint64_t minRttUs = 0;
+    std::uint64_t sampleRttUs = 0;
+    // Минимальная задержка и средняя в последнем окне; 0 — замеров ещё не было.
+};
+
+class AdaptiveLimiter {
+// Лимит одновременных запросов, подстраиваемый по задержке (градиент, как в
+// Netflix concurrency-limits): пока задержка окна близка к минимальной, очереди нет
+// и лимит растёт на √limit; когда запросы начинают ждать (воркеров, соединений БД),
+// задержка растёт, и лимит уменьшается пропорционально minRtt / задержка. Запросы
+// сверх лимита отбрасываются сразу, а не копятся в очереди воркеров.
+//
+// Лимит растёт, только если в окне реально было занято больше половины: при малой
+// нагрузке задержка ничего не говорит о пропускной способности.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit AdaptiveLimiter(AdaptiveLimiterOptions options = {});
+
+    AdaptiveLimiter(const AdaptiveLimiter&) = delete;
+    AdaptiveLimiter& operator=(const AdaptiveLimiter&) = delete;
+
+    bool try_acquire();
+    // Занимает место; false — лимит исчерпан (учитывается как shed).
+
+    void release(Clock::duration latency);
+    // Запрос обработан за latency — замер для пересчёта лимита.
+
+    void release_dropped();
+    // Запрос не дошёл до обработчика (клиент ушёл, сервер остановлен): без замера.
+
+    AdaptiveLimiterStats stats() const;
+
+private:
+    void update_limit();
+
+    AdaptiveLimiterOptions options_;
+    mutable std::mutex mutex_;
+    double limit_;
+    std::size_t inFlight_ = 0;
+    std::uint64_t admitted_ = 0;
+    std::uint64_t shed_ = 0;
+    double minRtt_ = 0;
+    double sampleRtt_ = 0;
+    // Секунды; 0 — замеров не было.
+    double windowSum_ = 0;
+    std::size_t windowCount_ = 0;
+    std::size_t windowPeak_ = 0;
+    // Наибольшее число одновременных запросов за окно.
+    std::size_t windows_ = 0;
+};
+
+struct AdmissionOptions {
+    bool enabled = false;
+    AdaptiveLimiterOptions limiter;
+    // Одинаковые начальные параметры для лимитера каждого класса.
+    std::unordered_map<std::string, std::string> routeClasses;
+    // Путь → класс маршрутов со своим лимитом. Пути без класса — в "default",
+    // класс "none" не ограничивается (служебные маршруты, чтобы было видно перегрузку).
+    std::chrono::seconds retryAfter{1};
+    // Retry-After в ответе 503.
+};
+
+struct AdmissionClassStats {
+    std::string name;
+    AdaptiveLimiterStats limiter;
+};
+
+class AdmissionControl {
+// Лимитеры по классам маршрутов: запись (БД, outbox), чтение истории, вход
+// (PBKDF2) упираются в разные ресурсы, и перегрузка одного класса не должна
+// отнимать места у другого. HttpServer спрашивает лимитер, как только прочитаны
+// заголовки: лишний запрос получает 503 до чтения тела и до очереди воркеров.
+public:
+    static constexpr std::string_view kDefaultClass = "default";
+    static constexpr std::string_view kUnlimitedClass = "none";
+
+    explicit AdmissionControl(AdmissionOptions options);
+
+    AdaptiveLimiter* limiter_for(std::string_view path);
+    // Лимитер класса пути; nullptr — класс "none". Указатель живёт, пока жив AdmissionControl.
+
+    std::chrono::seconds retry_after() const { return options_.retryAfter; }
+
+    std::vector<AdmissionClassStats> stats() const;
+    // По классам, в порядке имён.
+
+private:
+    AdmissionOptions options_;
+    std::unordered_map<std::string, std::unique_ptr<AdaptiveLimiter>> limiters_;
+    // Все классы создаются в конструкторе — дальше только чтение, без блокировок.
+};
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "chatserver/domain/common/timestamp.h"
+
+namespace chatserver::infrastructure::concurrency {
+
+class ClockTicker {
+// Фоновый поток, который раз в interval публикует текущее время для
+// domain::TimestampClock::Cached. Тогда Timestamp::now() на горячем пути — чтение
+// одного атомика вместо вызова часов; цена — точность не лучше interval.
+//
+// Пока тикер жив, Timestamp::now() читает его значение; деструктор (или stop())
+// возвращает прежний источник. Одновременно в процессе должен работать один тикер.
+public:
+    explicit ClockTicker(std::chrono::microseconds interval = std::chrono::milliseconds(1));
+    // Публикует время сразу (до возврата), затем переключает now() на Cached.
+    ~ClockTicker();
+
+    ClockTicker(const ClockTicker&) = delete;
+    ClockTicker& operator=(const ClockTicker&) = delete;
+
+    void stop();
+    // Останавливает поток и возвращает прежний источник. Повторный вызов безопасен.
+
+    std::chrono::microseconds interval() const { return interval_; }
+
+private:
+    void run();
+
+    std::chrono::microseconds interval_;
+    domain::TimestampClock previous_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
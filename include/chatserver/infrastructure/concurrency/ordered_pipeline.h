@@ -0,0 +1,138 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chatserver::infrastructure::concurrency {
+
+template <typename In, typename Out>
+void run_ordered_pipeline(std::size_t workers,
+                          std::size_t maxInFlight,
+                          const std::function<std::optional<In>()>& produce,
+                          const std::function<Out(In&)>& transform,
+                          const std::function<void(Out&)>& consume);
+// Конвейер «один производитель → N воркеров → один потребитель» с сохранением порядка:
+// produce() вызывается в текущем потоке, пока не вернёт nullopt; transform() — в
+// workers потоках параллельно; consume() — в отдельном потоке строго в порядке produce().
+// Одновременно существует не больше maxInFlight элементов (прочитанных, но ещё не
+// потреблённых), поэтому память ограничена при любом объёме входа, а медленный
+// потребитель тормозит чтение, а не копит очередь.
+// Первое исключение любой стадии останавливает конвейер и пробрасывается отсюда.
+
+template <typename In, typename Out>
+void run_ordered_pipeline(std::size_t workers,
+                          std::size_t maxInFlight,
+                          const std::function<std::optional<In>()>& produce,
+                          const std::function<Out(In&)>& transform,
+                          const std::function<void(Out&)>& consume)
+{
+    if (workers == 0 || maxInFlight == 0) {
+        throw std::invalid_argument("run_ordered_pipeline: workers and maxInFlight must be positive");
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<std::uint64_t, In>> inputs;
+    std::map<std::uint64_t, Out> outputs;
+    std::size_t inFlight = 0;
+    std::uint64_t nextToConsume = 0;
+    bool produced = false;
+    std::exception_ptr error;
+
+    const auto fail = [&](std::exception_ptr ex) {
+        std::lock_guard lock(mutex);
+        if (!error) error = std::move(ex);
+        changed.notify_all();
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        pool.emplace_back([&] {
+            while (true) {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return error || !inputs.empty() || produced; });
+                if (error || inputs.empty()) return;
+                auto [seq, item] = std::move(inputs.front());
+                inputs.pop_front();
+                lock.unlock();
+                try {
+                    auto out = transform(item);
+                    lock.lock();
+                    outputs.emplace(seq, std::move(out));
+                    changed.notify_all();
+                } catch (...) {
+                    fail(std::current_exception());
+                    return;
+                }
+            }
+        });
+    }
+
+    std::thread consumer([&] {
+        while (true) {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [&] {
+                return error || outputs.count(nextToConsume) > 0 || (produced && inFlight == 0);
+            });
+            if (error || outputs.count(nextToConsume) == 0) return;
+            auto node = outputs.extract(nextToConsume);
+            lock.unlock();
+            try {
+                consume(node.mapped());
+            } catch (...) {
+                fail(std::current_exception());
+                return;
+            }
+            lock.lock();
+            ++nextToConsume;
+            --inFlight;
+            changed.notify_all();
+        }
+    });
+
+    std::uint64_t seq = 0;
+    try {
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return error || inFlight < maxInFlight; });
+                if (error) break;
+            }
+            auto item = produce();
+            std::lock_guard lock(mutex);
+            if (!item) {
+                produced = true;
+                changed.notify_all();
+                break;
+            }
+            inputs.emplace_back(seq++, std::move(*item));
+            ++inFlight;
+            changed.notify_all();
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        produced = true;
+        changed.notify_all();
+    }
+    for (auto& t : pool) t.join();
+    consumer.join();
+    if (error) std::rethrow_exception(error);
+}
+
+}
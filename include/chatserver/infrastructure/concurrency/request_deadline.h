@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::concurrency {
+
+class DeadlineExceeded : public std::runtime_error {
+// Срок запроса истёк до или во время обращения к БД. HttpServer отвечает 504.
+public:
+    DeadlineExceeded() : std::runtime_error("request deadline exceeded") {}
+};
+
+struct RequestDeadlineStats {
+    std::uint64_t requests = 0;
+    // Запросы, выполненные со сроком.
+    std::uint64_t exceeded = 0;
+    // ...из них превысившие его (ответ 504).
+};
+
+class RequestDeadline {
+// Срок текущего HTTP-запроса, видимый всему коду, который выполняется в его воркере:
+// HttpServer открывает Scope вокруг обработчика маршрута, а репозитории читают
+// remaining() перед запросами к БД (statement_timeout, отмена). Сигнатуры
+// application-слоя о сроках не знают. Вне Scope срока нет: фоновые потоки
+// (outbox, обслуживание партиций, замер реплик) работают без ограничения.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Forked {};
+    static constexpr Forked kForked{};
+
+    class Scope {
+    public:
+        explicit Scope(Clock::time_point deadline);
+        // Вложенный Scope не продлевает внешний срок: действует более ранний.
+        Scope(Clock::time_point deadline, Forked);
+        // Срок запроса, перенесённый в другой поток (параллельное чтение шард): не
+        // считается отдельным запросом в stats(). Превышение вызывающий забирает
+        // через exceeded() и повторяет у себя mark_exceeded().
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        bool exceeded() const;
+        // Кто-то в этом Scope сообщил о превышении срока (mark_exceeded).
+
+    private:
+        std::optional<Clock::time_point> previous_;
+        bool previousExceeded_ = false;
+        bool counted_ = true;
+    };
+
+    static std::optional<Clock::time_point> current();
+    // Срок текущего потока; nullopt — вне Scope.
+
+    static std::optional<std::chrono::milliseconds> remaining();
+    // Сколько осталось (не меньше 0); nullopt — срока нет.
+
+    static void check();
+    // Срок истёк — mark_exceeded() и DeadlineExceeded.
+
+    static void mark_exceeded();
+    // Запрос прерван из-за срока (отменённый запрос к БД, ожидание соединения):
+    // ответ заменяется на 504, даже если обработчик превратил ошибку в другой ответ.
+
+    static RequestDeadlineStats stats();
+};
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace chatserver::infrastructure::concurrency {
+// Примитивы многопоточности инфраструктурного слоя.
+// Домен и application о потоках ничего не знают.
+
+using Task = std::function<void()>;
+
+class TaskQueue {
+// Блокирующая очередь задач MPMC (много производителей, много потребителей).
+// Производители — io-потоки HTTP-сервера, потребители — воркеры ThreadPool.
+public:
+    bool push(Task task);
+    // Кладёт задачу в конец очереди и будит одного потребителя.
+    // После close() задачи не принимаются — возвращает false.
+
+    std::optional<Task> pop();
+    // Ждёт задачу. nullopt — очередь закрыта и пуста: потребителю пора завершаться.
+    // Задачи, поставленные до close(), выдаются до конца (drain).
+
+    void close();
+    // Закрывает очередь и будит всех ждущих.
+
+    std::size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Task> tasks_;
+    bool closed_ = false;
+};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "chatserver/infrastructure/concurrency/task_queue.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace chatserver::infrastructure::concurrency {
+
+class ThreadPool {
+// Фиксированный пул воркеров для блокирующей работы: хеширование паролей,
+// запросы к Postgres, шифрование. io-потоки HTTP-сервера отдают такую работу
+// сюда и не блокируются — иначе одно медленное обращение к БД остановило бы
+// все соединения (в том числе WebSocket), обслуживаемые этим io-потоком.
+public:
+    explicit ThreadPool(std::size_t threads);
+    // threads == 0 — по числу ядер (std::thread::hardware_concurrency()).
+    ~ThreadPool();
+    // Вызывает stop(): дожидается выполнения уже поставленных задач.
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    bool post(Task task);
+    // Ставит задачу в очередь. false — пул уже остановлен, задача не будет выполнена.
+
+    void stop();
+    // Закрывает очередь, даёт воркерам доделать поставленные задачи и join'ит их.
+    // Повторный вызов безопасен.
+
+    std::size_t size() const { return workers_.size(); }
+    std::size_t pending() const { return queue_.size(); }
+
+private:
+    void worker_loop();
+
+    TaskQueue queue_;
+    std::vector<std::thread> workers_;
+};
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace chatserver::infrastructure::concurrency {
+
+class TimingWheel;
+
+class WheelTimer {
+// Таймер, встроенный в объект-владелец (сессию): узел интрузивного списка слота
+// колеса. Отдельных аллокаций на взвод нет — перевзвод таймаута keep-alive на
+// каждый запрос это два обновления указателей. Обработчик задаётся один раз при
+// создании; типичный — [this] { on_deadline(); }: он помещается в буфер
+// std::function без кучи, а деструктор таймера снимает его с колеса, так что
+// сработать после смерти владельца он не может.
+// Таймер принадлежит потоку своего колеса: взводить, снимать и уничтожать
+// взведённый таймер можно только из него.
+public:
+    WheelTimer() = default;
+    explicit WheelTimer(std::function<void()> onExpire) : onExpire_(std::move(onExpire)) {}
+    ~WheelTimer() { cancel(); }
+
+    WheelTimer(const WheelTimer&) = delete;
+    WheelTimer& operator=(const WheelTimer&) = delete;
+
+    void set_handler(std::function<void()> onExpire) { onExpire_ = std::move(onExpire); }
+
+    bool armed() const { return wheel_ != nullptr; }
+    void cancel();
+    // O(1). Снятие невзведённого или уже сработавшего таймера ничего не делает.
+
+private:
+    friend class TimingWheel;
+
+    WheelTimer* next_ = nullptr;
+    WheelTimer** pprev_ = nullptr;
+    // Указатель на поле, которое указывает на нас (голова слота или next_ соседа):
+    // снятие из середины списка без его обхода.
+    TimingWheel* wheel_ = nullptr;
+    std::uint64_t expiry_ = 0;
+    // Абсолютный номер тика срабатывания.
+    std::function<void()> onExpire_;
+};
+
+class TimingWheel {
+// Хешированное иерархическое колесо таймеров (Varghese & Lauck): 4 уровня по 256
+// слотов. Уровень 0 покрывает ближайшие 256 тиков, каждый следующий — в 256 раз
+// больше; таймер кладётся в слот по своему номеру тика срабатывания, а при
+// переходе младшего уровня через ноль слот старшего «осыпается» вниз. Взвод и
+// снятие — O(1) независимо от числа таймеров; тик — O(таймеров в слоте).
+// С тиком 100 мс колесо покрывает ~13 лет, более дальние сроки обрезаются.
+// Колесо однопоточное: у каждого io-потока HTTP-сервера своё, и тикает оно из
+// его же event loop. Точность — один тик: таймер срабатывает не раньше срока
+// и не позже чем через тик после него.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 8;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+
+    explicit TimingWheel(Clock::duration tick = std::chrono::milliseconds(100),
+                         Clock::time_point start = Clock::now());
+    ~TimingWheel();
+    // Оставшиеся таймеры снимаются без срабатывания.
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    void schedule(WheelTimer& timer, Clock::duration delay);
+    // Взводит (или перевзводит) таймер через delay от текущего тика колеса.
+    // Срок округляется вверх до тика, минимум — следующий тик.
+
+    std::size_t advance(Clock::time_point now);
+    // Проворачивает колесо до момента now и вызывает обработчики истёкших
+    // таймеров. Обработчик может взводить и снимать любые таймеры этого колеса.
+    // Возвращает число сработавших.
+
+    std::size_t armed() const { return armed_; }
+    Clock::duration tick() const { return tick_; }
+
+private:
+    friend class WheelTimer;
+
+    void insert(WheelTimer& timer);
+    void unlink(WheelTimer& timer);
+    void cascade(unsigned level);
+
+    Clock::duration tick_;
+    Clock::time_point start_;
+    std::uint64_t current_ = 0;
+    std::size_t armed_ = 0;
+    std::array<std::array<WheelTimer*, kSlots>, kLevels> slots_{};
+};
+
+}
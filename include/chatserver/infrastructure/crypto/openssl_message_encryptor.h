@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <string>
+#include <vector>
 
 #include "chatserver/domain/services/message_encryptor.h"
 
@@ -13,9 +15,15 @@ public:
 
     std::string encrypt(const std::string& plaintext) const override;
     std::string decrypt(const std::string& ciphertext) const override;
+    std::vector<std::string> encrypt_batch(const std::vector<std::string>& plaintexts) const override;
+    std::vector<std::string> decrypt_batch(const std::vector<std::string>& ciphertexts) const override;
+    // Один EVP_CIPHER_CTX на всю пачку: шифр и развёрнутый ключ настраиваются
+    // один раз, для каждого сообщения меняется только IV.
 
 private:
     std::string secret_;
+    std::array<unsigned char, 32> key_{};
+    // SHA-256(secret_) — ключ AES-256-GCM. Считается один раз в конструкторе.
 };
 
 }
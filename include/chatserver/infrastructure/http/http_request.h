@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 // Подключаем стандартные типы: строки и хэш-таблицу для заголовков HTTP.
 namespace chatserver::infrastructure::http {
@@ -20,6 +22,16 @@ struct HttpRequest {
     std::unordered_map<std::string, std::string> headers;
     // Коллекция HTTP-заголовков: "Content-Type", "Authorization", "User-Agent" и т.д.
     // unordered_map обеспечивает быстрый доступ по имени заголовка.
+
+    std::string_view path() const;
+    // target без query-строки: "/messages?peer=1" → "/messages". По нему ищется маршрут.
+
+    std::optional<std::string> query_param(std::string_view name) const;
+    // Значение параметра из query-строки (с декодированием %XX и '+'), nullopt — нет такого.
+
+    std::optional<std::string> header(std::string_view name) const;
+    // Значение заголовка без учёта регистра имени (клиенты пишут и "idempotency-key"),
+    // nullopt — нет такого.
 };
 
 }
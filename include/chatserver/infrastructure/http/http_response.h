@@ -1,12 +1,28 @@
 #pragma once
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
 namespace chatserver::infrastructure::http {
 // Пространство имён инфраструктурного слоя, отвечающего за HTTP.
 // Домен ничего не знает о HTTP - это правильно по DDD.
+using ChunkWriter = std::function<void(std::string_view chunk)>;
+// Отправляет очередной кусок тела клиенту (один HTTP/1.1 chunk).
+
+struct HttpResponse;
+using ResponseSink = std::function<void(HttpResponse response)>;
+// Завершает отложенный ответ (см. HttpResponse::deferred).
+
 struct HttpResponse {
+    HttpResponse() = default;
+    HttpResponse(int status, std::string body)
+        : status_code(status), body(std::move(body)) {}
+    // Ресурсы отвечают как HttpResponse{статус, тело}. Конструктор, а не агрегатная
+    // инициализация: новые поля ответа не требуют правки каждого места вызова.
+
     int status_code = 200;
     // HTTP-статус ответа. По умолчанию 200 ОК.
     // Может быть 404, 500, 302 и т.д
@@ -16,6 +32,15 @@ struct HttpResponse {
     std::unordered_map<std::string, std::string> headers;
     // Коллекция HTTP‑заголовков: "Content-Type", "Set-Cookie", "Location" и т.д.
     // unordered_map обеспечивает быстрый доступ по имени заголовка.
+    std::function<void(const ChunkWriter&)> stream_body;
+    // Если задано — body игнорируется, а ответ уходит с Transfer-Encoding: chunked:
+    // сервер отправляет заголовки и вызывает stream_body, который пишет тело по частям.
+    // Так большой ответ не собирается целиком в одну строку перед отправкой.
+    std::function<void(ResponseSink)> deferred;
+    // Если задано — ответ будет готов позже (long-poll). Сервер вызывает deferred
+    // в воркере, передаёт ему ResponseSink и сразу отпускает воркер: соединение ждёт
+    // ответа без потока. Sink нужно вызвать ровно один раз, из любого потока;
+    // после остановки сервера вызов ничего не делает.
 };
 
 }
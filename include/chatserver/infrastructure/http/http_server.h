@@ -1,33 +1,114 @@
 #pragma once
 
 #include "http_router.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/concurrency/adaptive_limiter.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
-// Подключаем HttpRouter и стандартные типы: строки и умные указатели.
+#include <unordered_map>
+// Подключаем HttpRouter, реестр realtime-соединений и стандартные типы.
 
 namespace chatserver::infrastructure::http {
 // Пространство имён инфраструктурного слоя HTTP.
 // Домен ничего не знает о HTTP — это правильно по DDD.
 
+enum class SlowConsumerPolicy {
+    Throttle,
+    // Новые кадры сверх порога отбрасываются, пока очередь не опустеет наполовину;
+    // затем клиент получает {"type":"gap","dropped":N} и дочитывает пропущенное
+    // через GET /messages. Соединение остаётся открытым.
+    Disconnect,
+    // Соединение закрывается: клиент переподключится и прочитает историю.
+};
+
+struct HttpServerOptions {
+    std::size_t ioThreads = 1;
+    // Число io-потоков. У каждого свой io_context: соединение живёт в одном потоке
+    // от accept до закрытия, поэтому его состояние не требует блокировок.
+    std::size_t workerThreads = 0;
+    // Воркеры для обработчиков маршрутов (БД, хеширование, шифрование блокируют поток).
+    // 0 — по числу ядер.
+    std::chrono::seconds idleTimeout{60};
+    // Сколько keep-alive соединение может ждать следующего запроса. Этот же срок
+    // даётся на чтение тела запроса и на запись ответа.
+    std::chrono::seconds headerTimeout{10};
+    // Заголовки запроса должны прийти целиком за это время после первого байта
+    // (защита от slowloris), и за него же должен завершиться WebSocket handshake.
+    std::chrono::seconds wsPingInterval{30};
+    // Простаивающему WebSocket раз в интервал уходит ping; не ответивший до
+    // следующего раза (в том числе не читающий вовсе) клиент отключается.
+    std::chrono::milliseconds timerTick{100};
+    // Шаг колеса таймеров io-потока: все сроки соединений отсчитываются с этой точностью.
+    std::string websocketPath = "/ws";
+    // Путь WebSocket upgrade: GET /ws?user=<id> с заголовками Upgrade: websocket.
+    // С ?batch=1 клиент соглашается получать склеенные кадры (см. wsMaxBatchBytes).
+    std::size_t wsHighWaterBytes = 1 << 20;
+    // Порог исходящей очереди одного соединения: сколько байт кадров может ждать
+    // записи. Память медленного получателя ограничена этим порогом.
+    SlowConsumerPolicy wsSlowConsumerPolicy = SlowConsumerPolicy::Throttle;
+    std::size_t wsMaxBatchBytes = 64 * 1024;
+    // Для клиентов с batch=1: кадры, накопившиеся за время предыдущей записи,
+    // уходят одним сообщением {"type":"batch","messages":[...]} — одна gather-запись
+    // (заголовок + сами кадры без копирования) вместо записи на кадр.
+    std::chrono::milliseconds requestDeadline{0};
+    // Бюджет запроса от прихода заголовков до ответа (включая очередь к воркеру и
+    // запросы к БД). Превысивший его запрос получает 504, зависший запрос к БД
+    // отменяется. 0 — без срока. Не распространяется на потоковые и отложенные
+    // (long-poll) ответы после возврата из обработчика.
+    std::unordered_map<std::string, std::chrono::milliseconds> routeDeadlines;
+    // Бюджеты отдельных маршрутов по пути (без query), вместо requestDeadline.
+    // Значение 0 снимает срок с маршрута.
+    std::chrono::milliseconds drainTimeout{10000};
+    // Сколько run() по SIGTERM/SIGINT ждёт завершения начатых запросов (см. shutdown()).
+};
+
 class HttpServer {
 public:
     HttpServer(const std::string& address,
                int port,
-               std::shared_ptr<HttpRouter> router);
+               std::shared_ptr<HttpRouter> router,
+               std::shared_ptr<realtime::ConnectionRegistry> connections = nullptr,
+               HttpServerOptions options = {},
+               std::shared_ptr<concurrency::AdmissionControl> admission = nullptr);
     // Конструктор HTTP‑сервера.
     // address — IP‑адрес, на котором сервер будет слушать (например, "0.0.0.0").
-    // port — порт (например, 8080).
+    // port — порт (например, 8080); 0 — выбрать свободный (см. port()).
     // router — объект маршрутизатора, который будет обрабатывать входящие запросы.
+    // connections — реестр WebSocket-соединений; nullptr — upgrade не поддерживается
+    //   и запрос на websocketPath обрабатывается роутером как обычный.
+    // admission — адаптивные лимиты одновременных запросов по классам маршрутов;
+    //   nullptr — без ограничения (запросы ждут воркеров в очереди).
+    ~HttpServer();
+
+    void start();
+    // Открывает порт и запускает io-потоки и воркеры; возвращает управление сразу.
     void run();
-    // Запускает сервер.
-    // Обычно включает:
-    //   - создание сокета,
-    //   - bind(address, port),
-    //   - listen()
-    //   - цикл accept() → чтение запроса → передача в router → отправка ответа.
-    // Реализация находится в .cpp.
+    // start() и ожидание stop() либо SIGTERM/SIGINT — тогда shutdown(drainTimeout).
+    // Обычный способ запуска из main(); после возврата сервер остановлен.
+    void shutdown(std::chrono::milliseconds timeout);
+    // Плавная остановка: порт закрывается, простаивающие keep-alive соединения
+    // закрываются сразу, начатые запросы дорабатывают и получают Connection: close,
+    // ждущие long-poll — 503 с Retry-After, WebSocket — close 1001 (going away).
+    // Через timeout оставшиеся соединения рвутся (stop()).
+    void stop();
+    // Закрывает порт, останавливает воркеры и io-потоки. Открытые соединения рвутся.
+    // Повторный или параллельный вызов ждёт, пока остановка завершится.
+    unsigned short port() const;
+    // Фактический порт после start() (важно, если в конструктор передан 0).
+    std::size_t open_connections() const;
+    // Открытые соединения (HTTP и WebSocket), в том числе ещё не приславшие запрос.
+    bool handling_signals() const;
+    // run() уже ждёт SIGTERM/SIGINT: с этого момента сигнал останавливает сервер,
+    // а не процесс.
 
 private:
+    struct Runtime;
+    // io_context'ы, acceptor, потоки — детали Asio/Beast, скрытые в .cpp.
+
     std::string                       address_;
     // Адрес, на котором сервер слушает входящие HTTP‑запросы.
     int                               port_;
@@ -35,7 +116,19 @@ private:
     std::shared_ptr<HttpRouter>       router_;
     // Маршрутизатор, который определяет, какой обработчик вызвать для конкретного запроса.
     // shared_ptr позволяет разделять один роутер между несколькими компонентами.
+    std::shared_ptr<realtime::ConnectionRegistry> connections_;
+    // Реестр WebSocket-соединений по id пользователя.
+    HttpServerOptions                 options_;
+    std::shared_ptr<concurrency::AdmissionControl> admission_;
+
+    std::unique_ptr<Runtime>          runtime_;
+    mutable std::mutex                lifecycleMutex_;
+    std::condition_variable           stopped_;
+    bool                              running_ = false;
+    bool                              stopping_ = false;
+    // stop() изъял runtime_ и ещё останавливает потоки (running_ уже false).
+    bool                              shutdownRequested_ = false;
+    // Пришёл SIGTERM/SIGINT: run() выполняет shutdown() в своём потоке.
 };
 
 }
-
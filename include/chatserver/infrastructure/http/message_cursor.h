@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace chatserver::infrastructure::http {
+// Непрозрачный курсор пагинации истории сообщений.
+// Клиент получает его в next_cursor и возвращает в ?before= без разбора.
+// Внутри — версия формата и id последнего сообщения страницы (base64url без '='),
+// поэтому сервер может поменять ключ пагинации, не ломая API.
+
+std::string encode_message_cursor(std::int64_t beforeId);
+
+std::optional<std::int64_t> decode_message_cursor(std::string_view cursor);
+// nullopt — строка не является курсором этой версии (клиент должен получить 400).
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+#include "chatserver/infrastructure/cache/username_filter.h"
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+#include "chatserver/infrastructure/repository/message_partition_maintainer.h"
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/repository/pg_connection_pool.h"
+#include "chatserver/infrastructure/repository/pg_replica_router.h"
+#include "chatserver/infrastructure/concurrency/adaptive_limiter.h"
+#include <vector>
+// AdminResource — служебные маршруты эксплуатации (состояние сервера, счётчики).
+// К application-слою не обращается: отдаёт состояние инфраструктуры как есть.
+
+namespace chatserver::infrastructure::http::resources {
+// Пространство имён для HTTP‑ресурсов (endpoints).
+
+class AdminResource {
+public:
+    explicit AdminResource(std::shared_ptr<chatserver::infrastructure::realtime::ConnectionRegistry> connections,
+                           std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> longPoll = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::cache::ConversationCache> conversationCache = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::repository::CachingUserRepository> userCache = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::cache::UsernameFilter> usernameFilter = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::cache::IdempotencyTable> idempotency = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::repository::OutboxMessageRepository> outbox = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer> partitions = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::repository::ShardedMessageRepository> sharded = nullptr,
+                           std::vector<std::shared_ptr<chatserver::infrastructure::repository::PgConnectionPool>> shardPools = {},
+                           std::vector<std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer>> shardPartitions = {},
+                           std::shared_ptr<chatserver::infrastructure::repository::PgReplicaRouter> replicas = nullptr,
+                           std::shared_ptr<chatserver::infrastructure::concurrency::AdmissionControl> admission = nullptr);
+    // Реестр присутствия — источник онлайн-счётчиков; long-poll реестр (если есть) —
+    // счётчиков ожидающих запросов; кэши переписок и пользователей, фильтр имён и
+    // таблица ключей идемпотентности (если есть) — счётчиков кэшей; outbox, партиции
+    // messages, шарды (с пулами и партициями по индексам кольца) и маршрутизация
+    // чтений по репликам — состояния хранилища; лимиты HttpServer по классам маршрутов.
+
+    void register_routes(chatserver::infrastructure::http::HttpRouter& router);
+    // GET /admin/presence            → {"online_users":..,"connections":..,"went_online":..,
+    //                                   "went_offline":..,"rejected":..,"shards":..,
+    //                                   "outbound":{"frames_written":..,"write_calls":..,
+    //                                   "frames_dropped":..,"slow_consumers":..,...},
+    //                                   "long_poll":{"mailboxes":..,"parked":..,"immediate":..,
+    //                                   "woken":..,"timed_out":..,"superseded":..}}
+    // GET /admin/presence?user=<id>  → {"user_id":..,"online":true,"connections":2}
+    // GET /admin/cache               → {"conversations":{"hits":..,"misses":..,"hit_ratio":..,
+    //                                   "fills":..,"appends":..,"evictions":..,"expired":..,
+    //                                   "cached":..,"messages":..,"bytes":..,"budget_bytes":..},
+    //                                   "users":{"hits":..,"negative_hits":..,"misses":..,
+    //                                   "coalesced":..,"hit_ratio":..,"evictions":..,"expired":..,
+    //                                   "invalidations":..,"entries":..,"capacity":..,"bytes":..},
+    //                                   "username_filter":{"items":..,"checks":..,
+    //                                   "definitely_absent":..,"false_positives":..,
+    //                                   "estimated_fpr":..,"bits":..,"hashes":..,"bytes":..},
+    //                                   "idempotency":{"executed":..,"replayed":..,"coalesced":..,
+    //                                   "mismatches":..,"evictions":..,"expired":..,"entries":..,
+    //                                   "capacity":..,"bytes":..}}
+    //                                   (выключенный кэш — null)
+    // GET /admin/storage             → {"outbox":{"appended":..,"fsyncs":..,"replayed":..,
+    //                                   "drained":..,"duplicates":..,"batches":..,"failures":..,
+    //                                   "rejected":..,"throttled":..,"pending":..,"segments":..,
+    //                                   "oldest_pending_ms":..,"failed":..},
+    //                                   "partitions":{"interval":..,"partitions":..,
+    //                                   "covered_until":..,"runs":..,"created":..,"dropped":..,
+    //                                   "failures":..,"last_run":..,"last_error":..},
+    //                                   "shards":{"fanout_reads":..,"moves":"<message_shard_moves>",
+    //                                   "list":[{"name":..,"share":..,"saves":..,"reads":..,
+    //                                   "failures":..,"pool":{"opened":..,"reused":..,"waits":..,
+    //                                   "timeouts":..,"broken":..,"idle":..,"leased":..}|null,
+    //                                   "partitions":{...}|null}]},
+    //                                   "replicas":{"policy":..,"primary_reads":..,
+    //                                   "sticky_reads":..,"lag_fallbacks":..,"sticky_keys":..,
+    //                                   "primary_pool":{...},"list":[{"name":..,"lag_ms":..|null,
+    //                                   "usable":..,"reads":..,"failures":..}]},
+    //                                   "deadlines":{"requests":..,"exceeded":..,"queries":..,
+    //                                   "statement_timeouts":..,"cancelled":..,
+    //                                   "expired_before_query":..,"pool_wait_expired":..}}
+    //                                   (выключено — null; deadlines есть всегда)
+    // GET /admin/limits              → {"enabled":..,"retry_after_s":..,"classes":[{"name":..,
+    //                                   "limit":..,"in_flight":..,"admitted":..,"shed":..,
+    //                                   "min_rtt_us":..,"sample_rtt_us":..}]}
+    // Маршруты служебные: в продакшене закрываются на уровне сети/прокси.
+
+private:
+    std::shared_ptr<chatserver::infrastructure::realtime::ConnectionRegistry> connections_;
+    std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> longPoll_;
+    std::shared_ptr<chatserver::infrastructure::cache::ConversationCache> conversationCache_;
+    std::shared_ptr<chatserver::infrastructure::repository::CachingUserRepository> userCache_;
+    std::shared_ptr<chatserver::infrastructure::cache::UsernameFilter> usernameFilter_;
+    std::shared_ptr<chatserver::infrastructure::cache::IdempotencyTable> idempotency_;
+    std::shared_ptr<chatserver::infrastructure::repository::OutboxMessageRepository> outbox_;
+    std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer> partitions_;
+    std::shared_ptr<chatserver::infrastructure::repository::ShardedMessageRepository> sharded_;
+    std::vector<std::shared_ptr<chatserver::infrastructure::repository::PgConnectionPool>> shardPools_;
+    std::vector<std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer>> shardPartitions_;
+    std::shared_ptr<chatserver::infrastructure::repository::PgReplicaRouter> replicas_;
+    std::shared_ptr<chatserver::infrastructure::concurrency::AdmissionControl> admission_;
+};
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "chatserver/application/handlers/create_group_handler.h"
+#include "chatserver/application/handlers/send_group_message_handler.h"
+#include "chatserver/infrastructure/http/http_router.h"
+// GroupResource — HTTP-адаптер для групповых чатов: создание группы и отправка в неё.
+// История группы читается через MessageResource (GET /messages?group=).
+
+namespace chatserver::infrastructure::http::resources {
+// Пространство имён для HTTP‑ресурсов (endpoints).
+
+class GroupResource {
+public:
+    GroupResource(std::shared_ptr<chatserver::application::CreateGroupHandler> createHandler,
+                  std::shared_ptr<chatserver::application::SendGroupMessageHandler> sendHandler);
+
+    void register_routes(chatserver::infrastructure::http::HttpRouter& router);
+    // POST /groups {"members":[1,2,3]} → {"id":..}
+    // POST /send_group_message {"sender_id","group_id","text"} → {"id":..}
+    //      (403 — отправитель не участник, 404 — группы нет)
+
+private:
+    std::shared_ptr<chatserver::application::CreateGroupHandler> createHandler_;
+    std::shared_ptr<chatserver::application::SendGroupMessageHandler> sendHandler_;
+};
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+// LongPollResource — доставка в реальном времени для клиентов без WebSocket.
+// Ответ отложенный (HttpResponse::deferred): ожидающий запрос не держит ни воркер,
+// ни io-поток — только запись в LongPollRegistry.
+
+namespace chatserver::infrastructure::http::resources {
+// Пространство имён для HTTP‑ресурсов (endpoints).
+
+class LongPollResource {
+public:
+    explicit LongPollResource(std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> registry);
+
+    void register_routes(chatserver::infrastructure::http::HttpRouter& router);
+    // GET /messages/wait?user=<id>&after=<message id>&timeout=<s, по умолчанию 30>
+    //   → {"messages":[<кадры как в WebSocket>],"next_after":..,"gap":false}
+    // Отвечает сразу, если после after уже есть сообщения; иначе ждёт первого
+    // сообщения или таймаута (тогда "messages" пуст). "gap":true — часть сообщений
+    // не сохранилась в ящике, их нужно дочитать через GET /messages.
+
+private:
+    std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> registry_;
+};
+
+}
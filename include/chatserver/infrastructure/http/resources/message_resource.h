@@ -1,6 +1,7 @@
 #pragma once
 
 #include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/application/handlers/get_message_history_handler.h"
 #include "chatserver/infrastructure/http/http_router.h"
 // Подключаем application‑слой (use case отправки сообщения) и HTTP‑роутер.
 // MessageResource — это адаптер между HTTP и application‑логикой.
@@ -11,20 +12,26 @@ namespace chatserver::infrastructure::http::resources {
 
 class MessageResource {
 public:
-    explicit MessageResource(std::shared_ptr<chatserver::application::SendMessageHandler> sendHandler);
-    // Конструктор принимает обработчик use case "отправить сообщение".
-    // Используем shared_ptr, чтобы ресурс мог безопасно хранить зависимость.
+    MessageResource(std::shared_ptr<chatserver::application::SendMessageHandler> sendHandler,
+                    std::shared_ptr<chatserver::application::GetMessageHistoryHandler> historyHandler);
+    // Конструктор принимает обработчики use case "отправить сообщение" и "прочитать историю".
+    // Используем shared_ptr, чтобы ресурс мог безопасно хранить зависимости.
 
     void register_routes(chatserver::infrastructure::http::HttpRouter& router);
     // Регистрирует HTTP‑маршруты, связанные с сообщениями.
     // Например:
-    //   POST /messages/send → sendHandler_
+    //   POST /send_message → sendHandler_ (заголовок Idempotency-Key: повтор с тем же
+    //                        ключом → прежний {"id":..}; тот же ключ с другим телом → 422)
+    //   GET  /messages?user=<id>&peer=<id>&before=<cursor>&limit=<n> → historyHandler_
+    //   GET  /messages?user=<id>&group=<id>&... — история группового чата (403 — не участник)
     // Здесь ресурс определяет, какой URL вызывает какой use case
 
 private:
     std::shared_ptr<chatserver::application::SendMessageHandler> sendHandler_;
     // Обработчик отправки сообщения.
     // Хранится как зависимость, чтобы HTTP‑слой мог вызвать application‑логику.
+    std::shared_ptr<chatserver::application::GetMessageHistoryHandler> historyHandler_;
+    // Обработчик чтения истории (keyset-пагинация + пакетная расшифровка).
 };
 
 }
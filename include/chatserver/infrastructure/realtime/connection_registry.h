@@ -0,0 +1,201 @@
+#pragma once
+
+#include "chatserver/infrastructure/realtime/realtime_connection.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::realtime {
+
+class ConnectionList {
+// Соединения одного пользователя — маленький вектор: первые kInline хранятся
+// прямо в записи реестра, без отдельной аллокации. Почти у всех пользователей
+// одно-два устройства, так что запись онлайн-пользователя — фиксированные ~48 байт.
+// Порядок элементов не сохраняется: удаление переносит последний на место удалённого.
+public:
+    static constexpr std::size_t kInline = 2;
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void push_back(std::weak_ptr<RealtimeConnection> connection);
+
+    template <typename Pred>
+    std::size_t remove_if(Pred pred) {
+        // Возвращает число удалённых элементов.
+        std::size_t removed = 0;
+        for (std::size_t i = 0; i < size_;) {
+            if (pred(at(i))) {
+                at(i) = std::move(at(size_ - 1));
+                pop_back();
+                ++removed;
+            } else {
+                ++i;
+            }
+        }
+        return removed;
+    }
+
+    template <typename F>
+    void for_each(F&& fn) const {
+        for (std::size_t i = 0; i < size_; ++i) fn(at(i));
+    }
+
+private:
+    std::weak_ptr<RealtimeConnection>& at(std::size_t i) {
+        return i < kInline ? inline_[i] : (*overflow_)[i - kInline];
+    }
+    const std::weak_ptr<RealtimeConnection>& at(std::size_t i) const {
+        return i < kInline ? inline_[i] : (*overflow_)[i - kInline];
+    }
+    void pop_back();
+
+    std::array<std::weak_ptr<RealtimeConnection>, kInline> inline_;
+    std::unique_ptr<std::vector<std::weak_ptr<RealtimeConnection>>> overflow_;
+    // Создаётся только у пользователя с третьим соединением и освобождается,
+    // когда их снова становится не больше kInline.
+    std::uint32_t size_ = 0;
+};
+
+struct ConnectionRegistryOptions {
+    std::size_t shards = 64;
+    // Число шардов (округляется вверх до степени двойки). У каждого шарда свой
+    // мьютекс: подключения, отключения и доставка разным пользователям не
+    // конкурируют за одну блокировку.
+    std::size_t maxConnectionsPerUser = 8;
+    // Верхняя граница соединений одного пользователя: вместе с ConnectionList
+    // она ограничивает память записи пользователя.
+};
+
+struct PresenceStats {
+    std::size_t onlineUsers = 0;
+    std::size_t connections = 0;
+    std::uint64_t wentOnline = 0;
+    // Переходы offline → online (первое соединение пользователя).
+    std::uint64_t wentOffline = 0;
+    // Переходы online → offline (закрыто последнее соединение).
+    std::uint64_t rejected = 0;
+    // Отказы из-за maxConnectionsPerUser.
+    std::size_t shards = 0;
+};
+
+struct OutboundStats {
+    std::uint64_t framesQueued = 0;
+    // Принятые в очереди кадры, включая служебные {"type":"gap"}.
+    std::uint64_t framesWritten = 0;
+    std::uint64_t writeCalls = 0;
+    // Операций записи в сокет. При склейке кадров writeCalls < framesWritten.
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t framesDropped = 0;
+    // Кадры, отброшенные из-за переполненной очереди медленного получателя.
+    std::uint64_t slowConsumers = 0;
+    // Сколько раз очередь соединения превысила порог (эпизоды, а не кадры).
+    std::uint64_t slowConsumersDisconnected = 0;
+};
+
+class OutboundCounters {
+// Счётчики исходящих очередей всех соединений. Сессии увеличивают их из своих
+// io-потоков; relaxed-атомики, по одному инкременту на запись, а не на кадр.
+public:
+    void queued(std::uint64_t frames) { framesQueued_.fetch_add(frames, std::memory_order_relaxed); }
+    void written(std::uint64_t frames, std::uint64_t bytes) {
+        framesWritten_.fetch_add(frames, std::memory_order_relaxed);
+        bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+        writeCalls_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void dropped(std::uint64_t frames) { framesDropped_.fetch_add(frames, std::memory_order_relaxed); }
+    void slow_consumer() { slowConsumers_.fetch_add(1, std::memory_order_relaxed); }
+    void disconnected() { slowConsumersDisconnected_.fetch_add(1, std::memory_order_relaxed); }
+
+    OutboundStats snapshot() const;
+
+private:
+    std::atomic<std::uint64_t> framesQueued_{0};
+    std::atomic<std::uint64_t> framesWritten_{0};
+    std::atomic<std::uint64_t> writeCalls_{0};
+    std::atomic<std::uint64_t> bytesWritten_{0};
+    std::atomic<std::uint64_t> framesDropped_{0};
+    std::atomic<std::uint64_t> slowConsumers_{0};
+    std::atomic<std::uint64_t> slowConsumersDisconnected_{0};
+};
+
+class ConnectionRegistry {
+// Реестр присутствия: открытые соединения по id пользователя. У одного пользователя
+// может быть несколько соединений (телефон, браузер) — сообщение уходит во все.
+// Пользователь онлайн, пока у него есть хотя бы одно соединение; запись удаляется
+// вместе с последним соединением, так что офлайн-пользователи памяти не занимают.
+// Реестр хранит weak_ptr: временем жизни соединения управляет транспорт,
+// а закрытое соединение само удаляет себя через remove().
+public:
+    using PresenceListener = std::function<void(std::int64_t userId, bool online)>;
+
+    explicit ConnectionRegistry(ConnectionRegistryOptions options = {});
+
+    bool add(std::int64_t userId, const std::shared_ptr<RealtimeConnection>& connection);
+    // Регистрирует соединение пользователя (после успешного WebSocket handshake).
+    // false — превышен maxConnectionsPerUser, соединение не зарегистрировано.
+
+    void remove(std::int64_t userId, const RealtimeConnection* connection);
+    // Удаляет соединение; пользователь без соединений удаляется из реестра целиком.
+
+    std::size_t send_to_user(std::int64_t userId, const std::shared_ptr<const std::string>& frame) const;
+    // Ставит кадр в очередь всех соединений пользователя.
+    // Возвращает число соединений, в которые кадр поставлен (0 — пользователь не в сети).
+    // Сами соединения вызываются уже без блокировки шарда.
+
+    std::size_t send_to_users(const std::vector<std::int64_t>& userIds,
+                              const std::shared_ptr<const std::string>& frame) const;
+    // Один кадр многим пользователям (участники группы). Пользователи группируются
+    // по шардам, и каждый затронутый шард блокируется один раз, а не на каждого
+    // участника. Возвращает общее число соединений, получивших кадр.
+
+    void set_presence_listener(PresenceListener listener);
+    // Вызывается на переходах online/offline под блокировкой шарда пользователя,
+    // поэтому события одного пользователя приходят по порядку. Слушатель должен
+    // быть быстрым и не обращаться к реестру. Устанавливается до начала работы.
+
+    bool is_online(std::int64_t userId) const;
+    // Есть ли у пользователя хотя бы одно открытое соединение.
+    std::size_t connections_of(std::int64_t userId) const;
+
+    std::size_t online_users() const;
+    std::size_t connection_count() const;
+    // Счётчики глобальные и атомарные: O(1) без обхода шардов.
+    PresenceStats stats() const;
+
+    OutboundCounters& outbound() const { return outbound_; }
+    // Счётчики исходящих очередей соединений (склейка записей, медленные получатели).
+    // Живут здесь, потому что реестр — общая точка транспорта и /admin.
+
+private:
+    struct alignas(64) Shard {
+        // alignas(64): соседние шарды не делят кэш-линию (нет false sharing мьютексов).
+        mutable std::mutex mutex;
+        std::unordered_map<std::int64_t, ConnectionList> users;
+    };
+
+    std::size_t shard_index(std::int64_t userId) const;
+    Shard& shard_for(std::int64_t userId) const;
+
+    ConnectionRegistryOptions options_;
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shardMask_ = 0;
+    PresenceListener listener_;
+
+    std::atomic<std::size_t> onlineUsers_{0};
+    std::atomic<std::size_t> connectionCount_{0};
+    std::atomic<std::uint64_t> wentOnline_{0};
+    std::atomic<std::uint64_t> wentOffline_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    mutable OutboundCounters outbound_;
+};
+
+}
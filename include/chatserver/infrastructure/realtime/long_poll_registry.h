@@ -0,0 +1,172 @@
+#pragma once
+
+#include "chatserver/infrastructure/concurrency/timing_wheel.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::realtime {
+
+struct LongPollOptions {
+    std::size_t shards = 64;
+    // Число шардов (округляется вверх до степени двойки), у каждого свой мьютекс.
+    std::size_t mailboxCapacity = 64;
+    // Сколько последних кадров пользователя хранится для ответа «сразу». Клиент,
+    // отставший сильнее, получает gap и дочитывает историю через GET /messages.
+    std::size_t maxWaitersPerUser = 8;
+    // Лишний ожидающий запрос вытесняет самый старый (тот получает пустой ответ).
+    std::chrono::seconds maxTimeout{60};
+    std::chrono::seconds mailboxRetention{120};
+    // Почтовый ящик живёт, пока пользователь опрашивает сервер, и ещё столько после
+    // последнего запроса: кадры, пришедшие между двумя запросами, не теряются.
+    std::chrono::milliseconds tick{100};
+    // Точность таймаутов ожидания.
+};
+
+struct LongPollResult {
+    std::vector<std::shared_ptr<const std::string>> frames;
+    // JSON-кадры сообщений — те же, что уходят по WebSocket (сериализуются один раз).
+    std::int64_t nextAfter = 0;
+    // Курсор следующего запроса: id последнего отданного кадра (или прежний after).
+    bool gap = false;
+    // Часть сообщений после after уже вытеснена из ящика — перечитать историю.
+};
+
+struct LongPollStats {
+    std::size_t mailboxes = 0;
+    std::size_t parked = 0;
+    // Запросы, ожидающие сейчас.
+    std::uint64_t immediate = 0;
+    // Ответы без ожидания: новые сообщения уже были.
+    std::uint64_t woken = 0;
+    // Ожидания, завершённые приходом сообщения.
+    std::uint64_t timedOut = 0;
+    std::uint64_t superseded = 0;
+};
+
+class LongPollRegistry {
+// Long-poll доставка для клиентов без WebSocket: GET /messages/wait.
+// У пользователя, который опрашивает сервер, есть почтовый ящик: кольцо последних
+// кадров в порядке публикации и список ожидающих запросов. Запрос, для которого
+// уже есть кадры новее after, отвечается сразу; иначе он «паркуется» — это запись
+// в списке ящика (обработчик завершения и таймер), а не поток. publish() отдаёт
+// кадр всем ожидающим пользователя немедленно.
+//
+// Курсор after — id последнего полученного сообщения. Ответ — кадры, опубликованные
+// после него: сообщения, сохранённые параллельно, могут опубликоваться не по
+// порядку id, и сравнение id потеряло бы опоздавшее.
+//
+// Как и WebSocket-соединение, ящик — канал реального времени, а не хранилище:
+// он заводится первым запросом пользователя, и сообщения до этого (или вытесненные
+// из кольца) читаются через GET /messages. Запрос с after, заведший ящик, поэтому
+// отвечается сразу с gap: после after могли сохраниться сообщения, которых в ящике нет.
+//
+// Таймауты ожиданий — на колесе таймеров шарда (под мьютексом шарда); колёса
+// проворачивает один фоновый поток реестра.
+public:
+    using Callback = std::function<void(LongPollResult)>;
+
+    explicit LongPollRegistry(LongPollOptions options = {});
+    ~LongPollRegistry();
+    // Останавливает фоновый поток; ожидающие запросы получают пустой ответ.
+
+    LongPollRegistry(const LongPollRegistry&) = delete;
+    LongPollRegistry& operator=(const LongPollRegistry&) = delete;
+
+    void wait(std::int64_t userId, std::optional<std::int64_t> after,
+              std::chrono::milliseconds timeout, Callback done);
+    // Ждёт кадров новее after не дольше timeout (обрезается до maxTimeout).
+    // Без after — только сообщения, пришедшие с этого момента. С after и без ящика —
+    // сразу gap (ящик заводится этим запросом).
+    // done вызывается ровно один раз, без блокировок реестра: синхронно (кадры уже
+    // есть, timeout == 0) либо позже из потока publish() или фонового потока.
+
+    void publish(std::int64_t userId, std::int64_t messageId, const std::shared_ptr<const std::string>& frame);
+    void publish(const std::vector<std::int64_t>& userIds, std::int64_t messageId,
+                 const std::shared_ptr<const std::string>& frame);
+    // Кладёт кадр в ящики пользователей (у кого они есть) и будит их ожидания.
+
+    bool has_mailbox(std::int64_t userId) const;
+    // Опрашивает ли пользователь сервер: иначе кадр для него можно не собирать.
+
+    LongPollStats stats() const;
+
+private:
+    struct Waiter {
+        std::int64_t userId = 0;
+        std::int64_t after = 0;
+        Callback done;
+        concurrency::WheelTimer timeout;
+    };
+
+    struct Entry {
+        std::int64_t id;
+        std::shared_ptr<const std::string> frame;
+    };
+
+    struct Mailbox {
+        std::vector<Entry> recent;
+        std::size_t head = 0;
+        // Кольцо кадров в порядке публикации (не больше mailboxCapacity), head — самый
+        // старый. vector растёт по мере прихода кадров: пустой ящик не занимает буфера
+        // (std::deque выделил бы его сразу).
+        const Entry& at(std::size_t i) const { return recent[(head + i) % recent.size()]; }
+        std::int64_t evictedUpTo = 0;
+        // Наибольший id, вытесненный из recent.
+        std::int64_t latest = 0;
+        std::list<Waiter> waiters;
+        // std::list: узлы не перемещаются, WheelTimer внутри Waiter остаётся на месте.
+        concurrency::WheelTimer retention;
+    };
+
+    struct alignas(64) Shard {
+        explicit Shard(std::chrono::milliseconds tick) : wheel(tick) {}
+        std::mutex mutex;
+        std::unordered_map<std::int64_t, Mailbox> users;
+        concurrency::TimingWheel wheel;
+        std::vector<Waiter*> expired;
+        std::vector<std::int64_t> idle;
+        // Заполняются обработчиками таймеров внутри wheel.advance() и разбираются сразу после.
+    };
+
+    using Completion = std::pair<Callback, LongPollResult>;
+
+    std::size_t shard_index(std::int64_t userId) const;
+    Mailbox& mailbox(Shard& shard, std::int64_t userId, bool& created);
+    LongPollResult collect(const Mailbox& box, std::int64_t after) const;
+    void publish_locked(Shard& shard, std::int64_t userId, std::int64_t messageId,
+                        const std::shared_ptr<const std::string>& frame, std::vector<Completion>& out);
+    void release_mailbox(Shard& shard, Mailbox& box);
+    void sweep(Shard& shard, std::vector<Completion>& out);
+    void sweeper_loop();
+
+    LongPollOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t shardMask_ = 0;
+
+    std::atomic<std::size_t> mailboxes_{0};
+    std::atomic<std::size_t> parked_{0};
+    std::atomic<std::uint64_t> immediate_{0};
+    std::atomic<std::uint64_t> woken_{0};
+    std::atomic<std::uint64_t> timedOut_{0};
+    std::atomic<std::uint64_t> superseded_{0};
+
+    std::mutex sweeperMutex_;
+    std::condition_variable sweeperWake_;
+    bool stopping_ = false;
+    std::thread sweeper_;
+};
+
+}
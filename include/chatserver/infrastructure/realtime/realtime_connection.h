@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace chatserver::infrastructure::realtime {
+// Пространство имён доставки в реальном времени (инфраструктурный слой).
+// Реестр и notifier не зависят от конкретного транспорта: WebSocket-сессия
+// HTTP-сервера — лишь одна из реализаций RealtimeConnection.
+
+class RealtimeConnection {
+// Открытое клиентское соединение, в которое сервер может протолкнуть кадр.
+public:
+    virtual ~RealtimeConnection() = default;
+
+    virtual void send(std::shared_ptr<const std::string> frame) = 0;
+    // Ставит кадр в очередь отправки соединения и сразу возвращает управление.
+    // Вызывается из любого потока; запись в сокет выполняет поток соединения.
+    // Кадр неизменяем и разделяется между всеми соединениями получателя,
+    // поэтому сериализация сообщения выполняется один раз.
+};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "chatserver/domain/services/message_notifier.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chatserver::infrastructure::realtime {
+
+class RealtimeMessageNotifier : public chatserver::domain::services::MessageNotifier {
+// Реализация доменного MessageNotifier поверх ConnectionRegistry:
+// сохранённое сообщение сериализуется в JSON-кадр один раз и ставится
+// в очереди всех открытых соединений получателя. Тот же кадр получают
+// long-poll ожидания получателя (LongPollRegistry), если он опрашивает сервер.
+public:
+    explicit RealtimeMessageNotifier(std::shared_ptr<ConnectionRegistry> registry,
+                                     std::shared_ptr<LongPollRegistry> longPoll = nullptr);
+
+    void message_stored(const chatserver::domain::message::Message& message) override;
+    void group_message_stored(const chatserver::domain::message::Message& message,
+                              const std::vector<chatserver::domain::UserId>& recipients) override;
+    // Кадр собирается один раз; все соединения всех участников получают
+    // один и тот же неизменяемый буфер (shared_ptr<const string>) —
+    // без копии на участника ни здесь, ни при записи в сокет.
+
+    static std::string to_frame(const chatserver::domain::message::Message& message);
+    // {"type":"message","id":..,"sender_id":..,"receiver_id":..,"text":"..","created_at":..,"created_at_us":..}
+    // У группового сообщения вместо receiver_id — "group_id".
+    // Поля совпадают с элементом ответа GET /messages.
+
+private:
+    std::shared_ptr<ConnectionRegistry> registry_;
+    std::shared_ptr<LongPollRegistry> longPoll_;
+};
+
+}
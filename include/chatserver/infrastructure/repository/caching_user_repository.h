@@ -0,0 +1,134 @@
+#pragma once
+
+#include "user_repository.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace chatserver::infrastructure::repository {
+
+struct UserCacheOptions {
+    std::size_t capacity = 100'000;
+    // Сколько имён (найденных и отсутствующих) помнит кэш; 0 — кэш выключен.
+    std::size_t shards = 16;
+    // Число шардов (округляется вверх до степени двойки), у каждого свой shared_mutex.
+    std::chrono::seconds ttl{60};
+    // Срок найденного пользователя: хэш пароля, сменённый мимо этого процесса
+    // (другой узел, ручная правка БД), будет виден не позже чем через ttl.
+    std::chrono::seconds negativeTtl{2};
+    // Срок записи «нет такого пользователя». Короткий: пользователь, только что
+    // зарегистрированный на другом узле, должен быстро начать входить и здесь.
+};
+
+struct UserCacheStats {
+    std::uint64_t hits = 0;
+    // Ответы из кэша, включая отрицательные.
+    std::uint64_t negativeHits = 0;
+    std::uint64_t misses = 0;
+    // Обращения к хранилищу (по одному на промах, совпавшие промахи — одно).
+    std::uint64_t coalesced = 0;
+    // Промахи, дождавшиеся чужого обращения к хранилищу за тем же именем.
+    std::uint64_t evictions = 0;
+    std::uint64_t expired = 0;
+    std::uint64_t invalidations = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    // Оценка памяти: слоты, строки и узлы индекса.
+    std::size_t capacity = 0;
+};
+
+class CachingUserRepository final : public UserRepository {
+// Декоратор UserRepository: кэш find_by_username перед медленным хранилищем
+// (PostgresUserRepository открывает соединение на каждый запрос, а /login
+// читает пользователя при каждом входе).
+//
+// Шард — кольцо слотов фиксированного размера с вытеснением CLOCK: попадание
+// только взводит бит обращения (атомарно, под разделяемой блокировкой), поэтому
+// параллельные входы не сериализуются на мьютексе, как было бы со списком LRU.
+// Вставка (под эксклюзивной) ищет жертву стрелкой часов, сбрасывая биты по пути.
+//
+// Отсутствующие имена тоже кэшируются (negativeTtl): перебор логинов и повторные
+// /login с опечаткой не доходят до БД.
+//
+// Одновременные промахи по одному имени ждут одного запроса к хранилищу
+// (single-flight); ошибка хранилища достаётся всем ожидающим и не кэшируется.
+//
+// save() идёт в хранилище и затем сбрасывает запись имени — и при успехе, и при
+// UsernameTakenError (имя, значит, существует). Запрос к хранилищу, начатый до
+// save(), свой результат в кэш уже не положит.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CachingUserRepository(std::shared_ptr<UserRepository> inner, UserCacheOptions options = {});
+
+    std::int64_t save(const chatserver::domain::user::User& user) override;
+    std::optional<chatserver::domain::user::User>
+    find_by_username(const std::string& username) override;
+    void for_each_username(const std::function<void(const std::string&)>& visit) override;
+    // Напрямую в хранилище, мимо кэша.
+
+    void invalidate(const std::string& username);
+    // Сбросить запись (например, после изменения пользователя в обход save).
+
+    UserCacheStats stats() const;
+
+private:
+    struct Slot {
+        std::string username;
+        std::optional<chatserver::domain::user::User> user;
+        // nullopt — пользователя нет (отрицательная запись).
+        Clock::time_point expires{};
+        std::atomic<bool> referenced{false};
+        bool used = false;
+        std::size_t bytes = 0;
+    };
+
+    struct Flight {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool finished = false;
+        bool stale = false;
+        // save() того же имени во время запроса: результат в кэш не кладётся.
+        std::optional<chatserver::domain::user::User> user;
+        std::exception_ptr error;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+        std::size_t size = 0;
+        std::size_t hand = 0;
+        std::unordered_map<std::string, std::size_t> index;
+        std::unordered_map<std::string, std::shared_ptr<Flight>> inflight;
+        std::size_t bytes = 0;
+    };
+
+    Shard& shard_for(const std::string& username) const;
+    void store(Shard& shard, const std::string& username,
+               const std::optional<chatserver::domain::user::User>& user, Clock::time_point now);
+    void erase_slot(Shard& shard, std::size_t i);
+
+    std::shared_ptr<UserRepository> inner_;
+    UserCacheOptions options_;
+    std::size_t shardMask_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> negativeHits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> coalesced_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> expired_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "chatserver/domain/group/group_id.h"
+#include "chatserver/domain/user/user_id.h"
+
+namespace chatserver::infrastructure::repository {
+
+class GroupNotFoundError : public std::runtime_error {
+    // members() для несуществующей группы. Общий контракт всех реализаций.
+public:
+    explicit GroupNotFoundError(std::int64_t groupId)
+        : std::runtime_error("group not found: " + std::to_string(groupId)) {}
+};
+
+class NotGroupMemberError : public std::runtime_error {
+    // Пользователь пишет в группу или читает её историю, не будучи участником.
+    // Бросается handler'ами после is_member(); HTTP-слой отвечает 403.
+public:
+    NotGroupMemberError(std::int64_t groupId, std::int64_t userId)
+        : std::runtime_error("user " + std::to_string(userId) + " is not a member of group " +
+                             std::to_string(groupId)) {}
+};
+
+class GroupRepository {
+    // Групповые чаты: состав участников. Сами сообщения группы хранит
+    // MessageRepository — одной записью на сообщение, а не копией на участника.
+public:
+    virtual ~GroupRepository() = default;
+
+    virtual std::int64_t create(const std::vector<chatserver::domain::UserId>& members) = 0;
+    // Создаёт группу с указанным составом (дубликаты игнорируются), возвращает её id.
+
+    virtual std::vector<chatserver::domain::UserId> members(const chatserver::domain::GroupId& group) const = 0;
+    // Участники группы. GroupNotFoundError — группы нет.
+
+    virtual bool is_member(const chatserver::domain::GroupId& group,
+                           const chatserver::domain::UserId& user) const = 0;
+};
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "group_repository.h"
+
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace chatserver::infrastructure::repository {
+
+class InMemoryGroupRepository final : public GroupRepository {
+    // Группы в памяти процесса — для бенчмарков, тестов и single-node режима.
+    // Состав группы — отсортированный вектор id: members() отдаёт его копией,
+    // is_member() — двоичный поиск. id выдаются монотонно с 1 (как SERIAL).
+public:
+    InMemoryGroupRepository() = default;
+
+    std::int64_t create(const std::vector<chatserver::domain::UserId>& members) override;
+    std::vector<chatserver::domain::UserId> members(const chatserver::domain::GroupId& group) const override;
+    bool is_member(const chatserver::domain::GroupId& group,
+                   const chatserver::domain::UserId& user) const override;
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::int64_t, std::vector<chatserver::domain::UserId>> groups_;
+    std::atomic<std::int64_t> nextId_{1};
+};
+
+}
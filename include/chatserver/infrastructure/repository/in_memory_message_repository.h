@@ -0,0 +1,78 @@
+#pragma once
+
+#include "message_repository.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+class InMemoryMessageRepository final : public MessageRepository {
+    // Append-only хранилище сообщений в памяти процесса.
+    // Используется в бенчмарках и single-node режиме без Postgres.
+    //
+    // Сообщения лежат в чанках фиксированного размера (kChunkSize слотов).
+    // Директория чанков выделяется один раз в конструкторе, поэтому её не нужно
+    // перераспределять и читатели не берут блокировок:
+    //   • save() получает индекс слота через fetch_add — это и есть id (1, 2, 3, ... как SERIAL),
+    //   • чанк создаётся лениво первым писателем (CAS в директории),
+    //   • слот публикуется флагом ready (release), читатель проверяет его (acquire).
+    // Уже записанные сообщения никогда не перемещаются и не меняются.
+    //
+    // Для find_page рядом держится индекс conversation_id → отсортированные id сообщений
+    // переписки (аналог индекса (conversation_id, id) в Postgres): страница — это
+    // lower_bound по курсору и limit шагов назад, независимо от глубины.
+public:
+    static constexpr std::size_t kChunkSize = 4096;
+    static constexpr std::size_t kDefaultMaxMessages = std::size_t{1} << 28;
+    // ~268M сообщений; директория на такой объём — 64K указателей (512 KB).
+
+    explicit InMemoryMessageRepository(std::size_t maxMessages = kDefaultMaxMessages);
+    ~InMemoryMessageRepository() override;
+
+    InMemoryMessageRepository(const InMemoryMessageRepository&) = delete;
+    InMemoryMessageRepository& operator=(const InMemoryMessageRepository&) = delete;
+
+    std::int64_t save(const chatserver::domain::message::Message& message) override;
+
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+
+    std::optional<chatserver::domain::message::Message> find_by_id(std::int64_t id) const;
+    // Возвращает опубликованное сообщение или nullopt (нет такого id / запись ещё идёт).
+
+    std::size_t size() const;
+    // Количество выданных id (включая слоты, запись в которые ещё не завершена).
+
+private:
+    struct Chunk {
+        std::array<std::optional<chatserver::domain::message::Message>, kChunkSize> slots;
+        std::array<std::atomic<bool>, kChunkSize> ready{};
+    };
+
+    struct alignas(64) ConversationShard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::int64_t, std::vector<std::int64_t>> ids;
+    };
+    static constexpr std::size_t kConversationShards = 64;
+
+    Chunk* chunk_at(std::size_t chunkIndex);
+    // Возвращает чанк, создавая его при первом обращении.
+
+    ConversationShard& conversation_shard(std::int64_t conversationId) const;
+
+    std::size_t maxChunks_;
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+    std::atomic<std::size_t> next_{0};
+    std::unique_ptr<ConversationShard[]> conversations_;
+};
+
+}
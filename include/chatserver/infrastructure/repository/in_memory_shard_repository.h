@@ -0,0 +1,48 @@
+#pragma once
+
+#include "message_repository.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+class InMemoryShardRepository final : public MessageRepository {
+// Заменитель Postgres-шарды для локального запуска и тестов (storage = memory с
+// message_shards). В отличие от InMemoryMessageRepository хранит id, назначенные
+// вызывающим: у шард общая нумерация (MessageIdGenerator), и сообщение, перенесённое
+// с шарды на шарду, сохраняет свой id. save() без id — std::invalid_argument.
+public:
+    std::int64_t save(const chatserver::domain::message::Message& message) override;
+
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+
+    std::size_t save_batch(const std::vector<chatserver::domain::message::Message>& messages) override;
+    // Уже сохранённые id пропускаются, как ON CONFLICT DO NOTHING у Postgres.
+
+    std::vector<chatserver::domain::message::Message> extract_if(
+        const std::function<bool(const chatserver::domain::message::Message&)>& predicate,
+        bool remove);
+    // Все сообщения, подходящие под predicate (remove — заодно удалить): перенос
+    // диапазона между шардами в тестах, как copy/cleanup у tools/chatshard.
+
+    std::size_t size() const;
+
+private:
+    bool insert(const chatserver::domain::message::Message& message);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::int64_t, std::map<std::int64_t, chatserver::domain::message::Message>> byConversation_;
+    // conversation_id → сообщения по id.
+    std::size_t size_ = 0;
+};
+
+}
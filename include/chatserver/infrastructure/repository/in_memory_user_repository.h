@@ -0,0 +1,51 @@
+#pragma once
+
+#include "user_repository.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace chatserver::infrastructure::repository {
+
+class InMemoryUserRepository final : public UserRepository {
+    // Потокобезопасное хранилище пользователей в памяти процесса.
+    // Используется в бенчмарках и single-node режиме, где задержка БД не нужна.
+    //
+    // Карта username → User разбита на kShards шардов, у каждого свой shared_mutex:
+    // параллельные /login и /register по разным именам почти не конкурируют.
+    // Семантика совпадает с таблицей users:
+    //   • username уникален (save бросает UsernameTakenError),
+    //   • id выдаётся монотонно, начиная с 1 (как SERIAL).
+public:
+    InMemoryUserRepository() = default;
+
+    std::int64_t save(const chatserver::domain::user::User& user) override;
+    std::optional<chatserver::domain::user::User>
+    find_by_username(const std::string& username) override;
+    void for_each_username(const std::function<void(const std::string&)>& visit) override;
+    // Обход по шардам; visit вызывается под разделяемой блокировкой шарда.
+
+    std::size_t size() const;
+    // Количество пользователей (сумма по шардам, без общей блокировки).
+
+private:
+    static constexpr std::size_t kShards = 64;
+
+    struct alignas(64) Shard {
+        // alignas(64) — шарды не делят кэш-линию, нет false sharing между мьютексами.
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, chatserver::domain::user::User> users;
+    };
+
+    Shard& shard_for(const std::string& username);
+    const Shard& shard_for(const std::string& username) const;
+
+    std::array<Shard, kShards> shards_;
+    std::atomic<std::int64_t> nextId_{1};
+};
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "message_repository.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+enum class FsyncPolicy {
+    EveryWrite,
+    // fdatasync после каждой записи: максимум надёжности, минимум пропускной способности.
+    GroupCommit,
+    // Писатели ждут общего fdatasync: один «лидер» синхронизирует диск за всех,
+    // кто успел дописать к этому моменту. save() возвращается только после fsync.
+    Interval,
+    // Фоновый fdatasync раз в fsyncInterval. save() не ждёт диска:
+    // при падении ОС можно потерять последние fsyncInterval записей.
+};
+
+struct LogStoreOptions {
+    std::string directory;
+    // Каталог с сегментами. Создаётся, если не существует.
+    std::uint64_t maxSegmentBytes = std::uint64_t{256} << 20;
+    // При превышении размера активный сегмент закрывается и начинается новый.
+    std::uint64_t indexIntervalBytes = 4096;
+    // Шаг разреженного индекса: одна точка id → offset примерно на столько байт записей.
+    FsyncPolicy fsyncPolicy = FsyncPolicy::GroupCommit;
+    std::chrono::milliseconds fsyncInterval{10};
+    // Используется только для FsyncPolicy::Interval.
+};
+
+struct LogRecoveryStats {
+    std::size_t segments = 0;
+    std::size_t scannedSegments = 0;
+    // Сегменты, которые пришлось читать целиком (нет .idx или это активный сегмент).
+    std::uint64_t records = 0;
+    std::uint64_t truncatedBytes = 0;
+    // Сколько байт «рваного хвоста» отрезано в последнем сегменте.
+    std::chrono::microseconds duration{0};
+};
+
+class LogMessageRepository final : public MessageRepository {
+    // MessageRepository поверх сегментированного append-only журнала на диске.
+    // Предназначен для edge-развёртываний без Postgres.
+    //
+    // Формат сегмента <base_id>.log — последовательность записей:
+    //   [u32 length][u32 crc32c(payload)][payload: length байт]
+    //   payload v3 = u8 version | u64 id | i64 sender_id | i64 receiver_id |
+    //                u64 prev_in_conversation | i64 created_at | u32 text_len | text
+    //   payload v2 — как v3, но created_at в секундах (v3 — в микросекундах)
+    //   payload v1 = u8 version | u64 id | i64 sender_id | i64 created_at | u32 text_len | text
+    // Числа — в порядке байт хоста (little-endian на всех целевых платформах).
+    // id идут подряд без пропусков, первый id сегмента — в имени файла.
+    // Записи v1 (до появления получателя) читаются с receiver_id = 0 и не входят ни в одну переписку.
+    // У группового сообщения receiver_id = -group_id: id пользователей положительны,
+    // так что формат записи не меняется.
+    //
+    // prev_in_conversation — id предыдущего сообщения той же переписки (0 — первое).
+    // Вместе с таблицей «последнее сообщение каждой переписки» это даёт историю
+    // переписки без сканирования: страница — limit переходов по обратным ссылкам.
+    //
+    // Для каждого сегмента в памяти держится разреженный индекс id → offset.
+    // При закрытии сегмента индекс и последние id переписок этого сегмента
+    // сохраняются в <base_id>.idx, поэтому при старте читаются только индексы
+    // закрытых сегментов и хвост активного.
+    // Хвост проверяется по длине и CRC: недописанная при падении запись отрезается.
+    //
+    // Чтение идёт через mmap сегмента, без системных вызовов на каждую запись.
+public:
+    explicit LogMessageRepository(LogStoreOptions options);
+    ~LogMessageRepository() override;
+
+    LogMessageRepository(const LogMessageRepository&) = delete;
+    LogMessageRepository& operator=(const LogMessageRepository&) = delete;
+
+    std::int64_t save(const chatserver::domain::message::Message& message) override;
+
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+    // Идёт по цепочке prev_in_conversation от курсора (или от последнего сообщения
+    // переписки): O(limit) чтений независимо от глубины и числа других переписок.
+
+    std::optional<chatserver::domain::message::Message> find_by_id(std::int64_t id) const;
+
+    std::int64_t last_id() const;
+    // Последний записанный id (0 — журнал пуст).
+
+    void sync();
+    // Принудительный fdatasync активного сегмента (независимо от политики).
+
+    const LogRecoveryStats& recovery_stats() const { return recoveryStats_; }
+
+private:
+    struct Segment;
+
+    void recover();
+    void open_new_segment(std::uint64_t baseId);
+    void roll_segment();
+    void wait_durable(std::uint64_t id);
+    void sync_up_to_latest();
+    void interval_flusher();
+
+    std::shared_ptr<Segment> segment_for(std::uint64_t id) const;
+
+    std::optional<chatserver::domain::message::Message>
+    read_record(std::uint64_t id, std::uint64_t* prevInConversation) const;
+    // Общая часть find_by_id и find_page: запись по id и её обратная ссылка.
+
+    std::uint64_t conversation_head(std::int64_t conversationId) const;
+
+    LogStoreOptions options_;
+    LogRecoveryStats recoveryStats_;
+
+    mutable std::shared_mutex segmentsMutex_;
+    std::map<std::uint64_t, std::shared_ptr<Segment>> segments_;
+    // base_id → сегмент. Меняется только при roll (под эксклюзивной блокировкой).
+
+    std::mutex appendMutex_;
+    std::shared_ptr<Segment> active_;
+    std::atomic<std::uint64_t> lastId_{0};
+
+    mutable std::shared_mutex headsMutex_;
+    std::unordered_map<std::int64_t, std::uint64_t> conversationHeads_;
+    // conversation_id → id последнего сообщения переписки. Меняется писателем под
+    // appendMutex_ (после публикации записи), читается find_page под shared-блокировкой.
+
+    std::mutex syncMutex_;
+    std::condition_variable syncCv_;
+    std::uint64_t syncedId_ = 0;
+    bool syncInProgress_ = false;
+    // Состояние group commit: id, до которого данные гарантированно на диске.
+
+    std::atomic<bool> stopping_{false};
+    std::thread flusher_;
+};
+
+}
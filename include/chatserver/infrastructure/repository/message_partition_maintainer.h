@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+enum class PartitionInterval {
+    None,
+    // messages — обычная таблица, обслуживать нечего.
+    Daily,
+    // messages_pYYYYMMDD: [00:00, 00:00 следующего дня) UTC.
+    Monthly,
+    // messages_pYYYYMM: [1-е число 00:00, 1-е число следующего месяца) UTC.
+};
+
+PartitionInterval parse_partition_interval(const std::string& name);
+// "none" | "daily" | "monthly"; иначе std::invalid_argument.
+
+struct PartitionOptions {
+    PartitionInterval interval = PartitionInterval::None;
+    // Должен совпадать со схемой (tools/migrate_db.sh, tools/partition_messages.sh).
+    int ahead = 7;
+    // Сколько следующих партиций держать созданными заранее. Вставка, для created_at
+    // которой нет партиции, падает — запас покрывает простой обслуживания.
+    std::chrono::hours retention{0};
+    // Партиции, целиком старше now - retention, отсоединяются (DETACH CONCURRENTLY)
+    // и удаляются одним DROP — без DELETE и последующего VACUUM. 0 — хранить всё.
+    std::chrono::minutes checkInterval{60};
+};
+
+struct PartitionRange {
+    std::string name;
+    std::int64_t fromUnix = 0;
+    std::int64_t toUnix = 0;
+    // [from, to) в секундах Unix-времени.
+};
+
+PartitionRange partition_for(PartitionInterval interval, std::int64_t unixSeconds);
+// Партиция, в которую попадает момент unixSeconds (interval != None).
+
+struct PartitionMaintenanceStats {
+    std::uint64_t runs = 0;
+    std::uint64_t created = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t failures = 0;
+    std::size_t partitions = 0;
+    // Число партиций messages после последнего удачного прохода.
+    std::int64_t coveredUntilUnix = 0;
+    // До какого момента вставки гарантированно найдут партицию.
+    std::int64_t lastRunUnix = 0;
+    std::string lastError;
+};
+
+class MessagePartitionMaintainer {
+// Обслуживание секционированной по created_at таблицы messages:
+//   • создаёт партиции на ahead интервалов вперёд (CREATE TABLE ... PARTITION OF);
+//   • по retention отсоединяет (DETACH PARTITION ... CONCURRENTLY — без блокировки
+//     чтения и записи в messages) и удаляет партиции, целиком вышедшие за срок,
+//     включая messages_legacy после онлайн-конвертации (tools/partition_messages.sh).
+// Проход выполняется в конструкторе и затем раз в checkInterval в фоновом потоке
+// (после ошибки — через минуту). Нескольким серверам обслуживать одну БД можно:
+// IF NOT EXISTS и повторный DETACH безопасны, проигравший проход считается ошибкой.
+// Нужен PostgreSQL 14+ (DETACH CONCURRENTLY).
+public:
+    MessagePartitionMaintainer(std::string connStr, PartitionOptions options);
+    // Первая ошибка прохода не фатальна (БД могла ещё не подняться): она в stats().
+    ~MessagePartitionMaintainer();
+
+    MessagePartitionMaintainer(const MessagePartitionMaintainer&) = delete;
+    MessagePartitionMaintainer& operator=(const MessagePartitionMaintainer&) = delete;
+
+    void run_once();
+    // Один проход синхронно. Ошибка БД — исключение (и счётчик failures).
+
+    void stop();
+
+    PartitionMaintenanceStats stats() const;
+
+    const PartitionOptions& options() const { return options_; }
+
+private:
+    void loop();
+
+    std::string connStr_;
+    PartitionOptions options_;
+
+    mutable std::mutex statsMutex_;
+    PartitionMaintenanceStats stats_;
+
+    std::mutex runMutex_;
+    // Проходы не пересекаются (фоновый поток и ручной run_once()).
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
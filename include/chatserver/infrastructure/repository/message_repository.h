@@ -1,15 +1,45 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "chatserver/domain/message/message.h"
 
 namespace chatserver::infrastructure::repository {
 
+class MessageRejectedError : public std::runtime_error {
+    // save_batch(): хранилище отвергло сами данные (нет отправителя или получателя —
+    // внешний ключ, нарушен CHECK, некорректный текст). В отличие от сбоя соединения,
+    // повтор той же пачки не поможет. Postgres переводит в него классы SQLSTATE 22 и 23.
+public:
+    explicit MessageRejectedError(const std::string& what) : std::runtime_error(what) {}
+};
+
 class MessageRepository {
 public:
     virtual ~MessageRepository() = default;
     virtual std::int64_t save(const chatserver::domain::message::Message& message) = 0;
+    // Возвращает id, под которым сообщение сохранено. Id, уже назначенный вызывающим
+    // (MessageIdGenerator, id != 0), Postgres сохраняет как есть — без RETURNING;
+    // локальные хранилища (InMemory, Log) нумеруют подряд сами и его не используют.
+
+    virtual std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const = 0;
+    // Keyset-пагинация истории переписки: до limit сообщений conversation с id < before
+    // (без before — с конца), отсортированных по id по убыванию. Следующая страница
+    // запрашивается с before = id последнего элемента, поэтому стоимость запроса
+    // не зависит от глубины (никаких OFFSET).
+
+    virtual std::size_t save_batch(const std::vector<chatserver::domain::message::Message>& messages);
+    // Сохраняет пачку сообщений с уже назначенными id (write-behind outbox). Id, который
+    // уже есть в хранилище, пропускается — повтор пачки после сбоя не дублирует
+    // сообщения. Возвращает, сколько записано впервые. По умолчанию — std::logic_error:
+    // локальные хранилища нумеруют сообщения сами и чужие id не сохраняют.
 };
 
 }
-
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "message_repository.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+struct OutboxOptions {
+    std::string directory;
+    // Каталог outbox (сегменты *.outbox и отметка слитого). Создаётся, если не существует.
+    std::uint64_t maxSegmentBytes = std::uint64_t{64} << 20;
+    // Активный сегмент больше этого закрывается; полностью слитые закрытые сегменты удаляются.
+    std::size_t batchSize = 1000;
+    // Сколько сообщений уходит в хранилище одним save_batch().
+    std::size_t maxPending = 1'000'000;
+    // Сколько неслитых сообщений держит outbox. Дальше save() ждёт drainer'а:
+    // при долгом простое Postgres подтверждение снова упирается в скорость БД,
+    // а память и диск не растут без предела.
+    std::chrono::milliseconds retryBackoff{100};
+    // Пауза после ошибки хранилища; удваивается до 5 с, сбрасывается первой удачей.
+};
+
+struct OutboxStats {
+    std::uint64_t appended = 0;
+    // Подтверждённые save() (записаны и синхронизированы на диск outbox).
+    std::uint64_t fsyncs = 0;
+    // fdatasync outbox: под нагрузкой один на много save() (group commit).
+    std::uint64_t replayed = 0;
+    // Неслитые сообщения, найденные в outbox при старте.
+    std::uint64_t drained = 0;
+    // Сообщения, переданные в хранилище.
+    std::uint64_t duplicates = 0;
+    // Из них уже были в хранилище (повтор пачки после рестарта или ошибки) — пропущены по id.
+    std::uint64_t batches = 0;
+    std::uint64_t failures = 0;
+    // Неудачные save_batch(): пачка остаётся в outbox и повторяется.
+    std::uint64_t rejected = 0;
+    // Сообщения, отвергнутые хранилищем (MessageRejectedError): перенесены в файл
+    // rejected каталога outbox и больше не повторяются.
+    std::uint64_t throttled = 0;
+    // save(), ждавшие места в outbox (maxPending).
+    std::size_t pending = 0;
+    std::size_t segments = 0;
+    std::int64_t oldestPendingMs = 0;
+    // Возраст самого старого неслитого сообщения — отставание хранилища от подтверждений.
+    bool failed = false;
+    // fdatasync outbox вернул ошибку: save() отказывает до рестарта.
+};
+
+class OutboxMessageRepository final : public MessageRepository {
+// Write-behind декоратор MessageRepository: save() подтверждает сообщение после
+// записи в локальный файл outbox и fdatasync, не дожидаясь коммита в Postgres.
+// Фоновый drainer переносит сообщения в хранилище пачками (save_batch — COPY).
+//
+// Ровно один раз: у сообщения уже есть id (MessageIdGenerator), хранилище
+// пропускает id, который у него есть. Пачка, записанная в хранилище, но не
+// отмеченная в outbox (падение между ними), после рестарта просто повторится —
+// дубликатов не будет. Поэтому отметка слитого пишется без fsync: её потеря
+// стоит лишь повторной пересылки. save() без назначенного id — std::invalid_argument.
+//
+// Формат сегмента <n>.outbox — записи [u32 length][u32 crc32c(payload)][payload]:
+//   payload v1 = u8 version | i64 id | i64 sender_id | i64 receiver_id (-group_id) |
+//                i64 created_at_us | u32 text_len | text
+// Отметка drained — u64 номер сегмента | u64 смещение | u32 crc: всё до неё слито.
+// При старте outbox читается от отметки: рваный хвост последнего сегмента отрезается,
+// неслитые сообщения снова встают в очередь drainer'а. Запись всегда идёт в новый сегмент.
+//
+// Durability: save() возвращается после fdatasync (group commit: один лидер
+// синхронизирует за всех, кто успел дописать). Drainer берёт только синхронизированные
+// записи, поэтому в хранилище не попадёт то, что может пропасть из outbox.
+// Ошибка fdatasync необратима: ядро могло выбросить грязные страницы и снять ошибку,
+// и следующий fdatasync «успешно» вернётся без них. Поэтому outbox закрывается на
+// запись до рестарта, а несинхронизированные записи (их save() получают ошибку)
+// убираются из очереди, из чтения и с диска — повтор клиента не станет дубликатом.
+//
+// Отказ хранилища из-за данных (MessageRejectedError: /send_message не проверяет, что
+// отправитель и получатель существуют, а в messages на них внешние ключи) не должен
+// навсегда останавливать слив: пачка делится пополам, пока не найдутся отвергнутые
+// сообщения, они дописываются в файл rejected (тот же формат записей, с fdatasync)
+// и снимаются с очереди. Остальные ошибки (соединение, таймаут) повторяют пачку целиком.
+//
+// Чтение: find_page объединяет страницу хранилища с ещё неслитыми сообщениями
+// переписки, так что отправитель видит своё сообщение сразу после ответа.
+public:
+    OutboxMessageRepository(std::shared_ptr<MessageRepository> inner, OutboxOptions options);
+    ~OutboxMessageRepository() override;
+    // Останавливает drainer. Неслитое остаётся в outbox до следующего старта.
+
+    OutboxMessageRepository(const OutboxMessageRepository&) = delete;
+    OutboxMessageRepository& operator=(const OutboxMessageRepository&) = delete;
+
+    std::int64_t save(const chatserver::domain::message::Message& message) override;
+
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+
+    bool flush(std::chrono::milliseconds timeout);
+    // Ждёт, пока drainer сольёт всё подтверждённое к моменту вызова. false — не успел.
+
+    std::int64_t max_replayed_id() const { return maxReplayedId_; }
+    // Наибольший id среди сообщений outbox при старте (0 — не было). Генератор id
+    // должен выдавать id больше него (MessageIdGenerator::advance_past).
+
+    OutboxStats stats() const;
+
+private:
+    struct Pending {
+        chatserver::domain::message::Message message;
+        std::uint64_t seq;
+        // Порядковый номер записи в outbox (для group commit).
+        std::uint64_t segment;
+        std::uint64_t endOffset;
+        // Где кончается запись — отметка drained после её слива.
+        std::chrono::steady_clock::time_point appendedAt;
+    };
+
+    void replay();
+    void open_segment(std::uint64_t number);
+    void roll_segment();
+    void wait_durable(std::uint64_t seq);
+    void sync_active();
+    void fail_closed();
+    void drain_loop();
+    std::size_t save_isolating(std::vector<chatserver::domain::message::Message> batch,
+                               std::vector<chatserver::domain::message::Message>& rejected);
+    void write_rejected(const std::vector<chatserver::domain::message::Message>& rejected);
+    void write_drained_mark(std::uint64_t segment, std::uint64_t offset);
+    void remove_segments_before(std::uint64_t segment);
+
+    std::shared_ptr<MessageRepository> inner_;
+    OutboxOptions options_;
+    std::int64_t maxReplayedId_ = 0;
+
+    struct SegmentFile;
+
+    std::mutex appendMutex_;
+    std::shared_ptr<SegmentFile> active_;
+    std::uint64_t size_ = 0;
+    std::uint64_t seq_ = 0;
+    // Активный сегмент, его размер и номер последней записи — под appendMutex_.
+
+    std::mutex syncMutex_;
+    std::condition_variable syncCv_;
+    std::atomic<std::uint64_t> syncedSeq_{0};
+    // Записи до syncedSeq_ включительно на диске; меняется под syncMutex_.
+    std::uint64_t syncedSegment_ = 0;
+    std::uint64_t syncedSize_ = 0;
+    // Синхронизированный префикс последнего сегмента — до него усекается активный при сбое.
+    bool syncInProgress_ = false;
+    std::atomic<bool> failed_{false};
+    // Выставляется под appendMutex_ и syncMutex_; обратно не сбрасывается.
+
+    mutable std::mutex pendingMutex_;
+    std::condition_variable pendingCv_;
+    // Будит drainer (новые синхронизированные записи, остановка) и ждущих места/flush.
+    std::deque<Pending> pending_;
+    // В порядке записи в outbox; drainer снимает с головы.
+    std::unordered_map<std::int64_t, std::map<std::int64_t, chatserver::domain::message::Message>> byConversation_;
+    // conversation_id → неслитые сообщения по id: для find_page.
+    std::uint64_t drainedSeq_ = 0;
+    bool stopping_ = false;
+
+    std::uint64_t oldestSegment_ = 0;
+    // Самый старый сегмент на диске; меняют только replay() и drainer.
+    std::atomic<std::size_t> segments_{0};
+
+    std::atomic<std::uint64_t> appended_{0};
+    std::atomic<std::uint64_t> fsyncs_{0};
+    std::atomic<std::uint64_t> replayed_{0};
+    std::atomic<std::uint64_t> drained_{0};
+    std::atomic<std::uint64_t> duplicates_{0};
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> failures_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::atomic<std::uint64_t> throttled_{0};
+
+    std::thread drainer_;
+};
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <pqxx/pqxx>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+struct PgPoolOptions {
+    std::size_t size = 8;
+    // Сколько соединений с одной БД держится открытыми. 0 — без пула: соединение
+    // открывается на каждый запрос и закрывается после него (прежнее поведение).
+    std::chrono::milliseconds acquireTimeout{5000};
+    // Сколько acquire() ждёт свободного соединения, когда все size заняты.
+};
+
+struct PgPoolStats {
+    std::uint64_t opened = 0;
+    // Соединений открыто за всё время (включая переоткрытые после обрыва).
+    std::uint64_t reused = 0;
+    // acquire(), получившие уже открытое соединение.
+    std::uint64_t waits = 0;
+    // acquire(), ждавшие освобождения соединения.
+    std::uint64_t timeouts = 0;
+    std::uint64_t broken = 0;
+    // Соединения, вернувшиеся закрытыми (обрыв, рестарт БД) или через discard(), — выброшены.
+    std::size_t idle = 0;
+    std::size_t leased = 0;
+};
+
+class PgConnectionPool {
+// Пул соединений libpqxx к одной БД. acquire() выдаёт соединение в аренду (Lease);
+// по окончании аренды живое соединение возвращается в пул, закрытое — выбрасывается,
+// и следующий acquire() откроет новое. Соединение открывается лениво, под ограничение
+// size попадают и открытые, и открывающиеся. Пул должен пережить все свои Lease.
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *conn_; }
+        pqxx::connection* operator->() const { return conn_.get(); }
+
+        void discard();
+        // Не возвращать соединение в пул (например, после отмены запроса).
+
+    private:
+        friend class PgConnectionPool;
+        Lease(PgConnectionPool* pool, std::unique_ptr<pqxx::connection> conn);
+
+        PgConnectionPool* pool_;
+        std::unique_ptr<pqxx::connection> conn_;
+    };
+
+    PgConnectionPool(std::string connStr, PgPoolOptions options = {});
+
+    PgConnectionPool(const PgConnectionPool&) = delete;
+    PgConnectionPool& operator=(const PgConnectionPool&) = delete;
+
+    Lease acquire();
+    // Свободное или новое соединение. Не удалось открыть — std::runtime_error;
+    // все заняты дольше acquireTimeout — тоже std::runtime_error.
+
+    void close_idle();
+    // Закрывает простаивающие соединения (остановка сервера); арендованные закроются
+    // при возврате.
+
+    PgPoolStats stats() const;
+
+    const std::string& connection_string() const { return connStr_; }
+
+private:
+    void release(std::unique_ptr<pqxx::connection> conn);
+
+    std::string connStr_;
+    PgPoolOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<pqxx::connection>> idle_;
+    std::size_t open_ = 0;
+    // Открытые и открывающиеся соединения (в пуле и в аренде).
+    bool closing_ = false;
+    PgPoolStats stats_;
+};
+
+}
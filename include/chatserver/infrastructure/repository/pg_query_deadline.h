@@ -0,0 +1,60 @@
+#pragma once
+
+#include <pqxx/pqxx>
+
+#include <chrono>
+#include <cstdint>
+
+namespace chatserver::infrastructure::repository {
+
+struct QueryDeadlineStats {
+    std::uint64_t armed = 0;
+    // Транзакции, выполненные под сроком запроса.
+    std::uint64_t statementTimeouts = 0;
+    // Оборваны сервером по statement_timeout.
+    std::uint64_t cancelled = 0;
+    // Отменены клиентом (PQcancel), потому что пережили срок запроса.
+    std::uint64_t expiredBeforeQuery = 0;
+    // Срок истёк раньше, чем дошло до БД (ожидание воркера, предыдущие запросы).
+    std::uint64_t poolWaitExpired = 0;
+    // Срок истёк в ожидании свободного соединения пула.
+};
+
+class PgQueryDeadline {
+// Срок HTTP-запроса (concurrency::RequestDeadline) для транзакции libpqxx. Создаётся
+// сразу после транзакции и живёт до её конца:
+//   • срок уже истёк — DeadlineExceeded без обращения к БД;
+//   • осталось меньше kStatementTimeoutBelow — SET LOCAL statement_timeout =
+//     оставшееся время: зависший оператор обрывает сам сервер, SET LOCAL действует
+//     только до конца транзакции и не остаётся на соединении, вернувшемся в пул.
+//     SET — отдельный обмен с сервером, поэтому с запасом срока его не шлём;
+//   • в любом случае фоновый поток через kCancelGrace после срока отменяет текущий
+//     запрос соединения (PQcancel) — это покрывает и транзакции без SET, и те, до
+//     сервера которых statement_timeout не доходит (ожидание сети, несколько
+//     операторов, каждый в пределах таймаута).
+// Отменённый запрос завершается pqxx::query_canceled, транзакция откатывается,
+// и соединение возвращается в пул исправным. Исключение, вылетевшее после срока,
+// помечает запрос превысившим срок (RequestDeadline::mark_exceeded) — HttpServer
+// ответит 504. Вне RequestDeadline::Scope ничего не делает.
+public:
+    static constexpr std::chrono::milliseconds kCancelGrace{50};
+    static constexpr std::chrono::milliseconds kStatementTimeoutBelow{1000};
+
+    PgQueryDeadline(pqxx::connection& conn, pqxx::transaction_base& txn);
+    ~PgQueryDeadline();
+
+    PgQueryDeadline(const PgQueryDeadline&) = delete;
+    PgQueryDeadline& operator=(const PgQueryDeadline&) = delete;
+
+    static QueryDeadlineStats stats();
+
+    static void note_pool_wait_expired();
+    // Для PgConnectionPool: acquire() не дождался соединения до срока запроса.
+
+private:
+    std::uint64_t ticket_ = 0;
+    // Регистрация в потоке отмены; 0 — срока нет.
+    int uncaught_ = 0;
+};
+
+}
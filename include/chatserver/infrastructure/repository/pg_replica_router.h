@@ -0,0 +1,179 @@
+#pragma once
+
+#include "pg_connection_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+enum class ReplicaPolicy {
+    RoundRobin,
+    // Подходящие реплики по очереди.
+    LeastLoaded,
+    // Реплика с наименьшим числом арендованных соединений (при равенстве — по очереди).
+};
+
+ReplicaPolicy parse_replica_policy(const std::string& name);
+// "round_robin" | "least_loaded"; иначе std::invalid_argument.
+
+struct ReplicaOptions {
+    ReplicaPolicy policy = ReplicaPolicy::RoundRobin;
+    std::chrono::milliseconds maxLag{1000};
+    // Реплика, отставшая больше, не получает чтений, пока не догонит.
+    std::chrono::milliseconds readYourWrites{5000};
+    // Сколько после записи чтения того же ключа (имя пользователя, переписка) идут
+    // в primary: запись видна её автору сразу, даже если реплика отстаёт. 0 — выключено.
+    std::chrono::milliseconds lagCheckInterval{1000};
+    // Период замера отставания реплик (фоновый поток).
+    PgPoolOptions pool;
+    // Пул соединений каждой реплики.
+};
+
+struct ReplicaStats {
+    std::string name;
+    // replicaN — строки подключения с паролями в статистику не попадают.
+    std::uint64_t reads = 0;
+    std::uint64_t failures = 0;
+    // Неудачные замеры и подключения; после них реплика исключена до следующего замера.
+    std::optional<std::int64_t> lagMs;
+    // Последний замер; nullopt — реплика недоступна или ещё не замерена.
+    bool usable = false;
+};
+
+struct ReplicaRoutingStats {
+    std::vector<ReplicaStats> replicas;
+    std::uint64_t primaryReads = 0;
+    // Чтения, ушедшие в primary по любой причине (включая две ниже).
+    std::uint64_t stickyReads = 0;
+    // ...из-за недавней записи того же ключа.
+    std::uint64_t lagFallbacks = 0;
+    // ...потому что ни одна реплика не подходила (отставание, недоступность).
+    std::size_t stickyKeys = 0;
+};
+
+class ReplicaSelector {
+// Выбор реплики для чтения без ввода-вывода: отставание и ошибки сообщает владелец
+// (PgReplicaRouter), нагрузку передаёт в pick(). nullopt — читать из primary.
+// Потокобезопасен.
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ReplicaSelector(std::size_t replicas, ReplicaOptions options);
+
+    std::optional<std::size_t> pick(std::uint64_t key, Clock::time_point now, const std::vector<std::size_t>& load);
+    // key — ключ read-your-writes (0 — без привязки); load[i] — занятые соединения
+    // реплики i (для LeastLoaded).
+
+    void note_write(std::uint64_t key, Clock::time_point now);
+    // Запись key подтверждена primary: его чтения readYourWrites идут в primary.
+
+    bool report_lag(std::size_t replica, std::optional<std::chrono::milliseconds> lag);
+    // Результат замера; nullopt — замер не удался. Возвращает, получает ли теперь
+    // реплика чтения (отвечает и отстаёт не больше maxLag).
+
+    void report_failure(std::size_t replica);
+    // Не удалось подключиться к реплике: исключить до следующего удачного замера.
+
+    ReplicaRoutingStats stats() const;
+
+private:
+    struct Replica {
+        std::optional<std::chrono::milliseconds> lag;
+        bool failed = true;
+        // Незамеренная реплика чтений не получает.
+        std::uint64_t reads = 0;
+        std::uint64_t failures = 0;
+    };
+
+    bool usable(const Replica& replica) const;
+
+    ReplicaOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<Replica> replicas_;
+    std::size_t cursor_ = 0;
+    std::unordered_map<std::uint64_t, Clock::time_point> sticky_;
+    // Ключ → до какого момента читать из primary. Истёкшие вычищаются при росте.
+    std::size_t sweepAt_ = 1024;
+    ReplicaRoutingStats counters_;
+};
+
+std::uint64_t replica_key(const std::string& value);
+// Ключ read-your-writes из строки (имя пользователя). Совпадение хэшей лишь
+// отправит лишнее чтение в primary.
+
+class PgReplicaRouter {
+// Primary и реплики одной БД: записи и чтения «своих» недавних записей — в primary,
+// остальные чтения — в реплику, выбранную ReplicaSelector. Отставание реплик
+// (pg_last_xact_replay_timestamp) замеряется в конструкторе и затем раз в
+// lagCheckInterval в фоновом потоке. Реплика, к которой не удалось подключиться,
+// исключается до следующего замера, а чтение уходит в primary.
+//
+// Привязка read-your-writes — в пределах процесса: запросы одного пользователя к
+// разным узлам её не разделяют. Без реплик всё идёт в primary, поток не запускается.
+public:
+    explicit PgReplicaRouter(std::shared_ptr<PgConnectionPool> primary,
+                             std::vector<std::shared_ptr<PgConnectionPool>> replicas = {},
+                             ReplicaOptions options = {});
+    ~PgReplicaRouter();
+
+    PgReplicaRouter(const PgReplicaRouter&) = delete;
+    PgReplicaRouter& operator=(const PgReplicaRouter&) = delete;
+
+    PgConnectionPool::Lease write();
+    // Соединение с primary.
+
+    void note_write(std::uint64_t key);
+    // Вызывается после commit записи key.
+
+    PgConnectionPool::Lease read(std::uint64_t key);
+    // Соединение для чтения key (0 — без read-your-writes).
+
+    void probe_once();
+    // Замер отставания всех реплик синхронно. В журнал пишется только смена
+    // пригодности реплики; повторные неудачи видны в ReplicaStats::failures.
+
+    void stop();
+
+    void close_idle();
+    // Закрывает простаивающие соединения primary и реплик.
+
+    ReplicaRoutingStats stats() const;
+    PgPoolStats primary_stats() const { return primary_->stats(); }
+
+    const std::string& connection_string() const { return primary_->connection_string(); }
+    // Строка primary (для журналов).
+
+    bool has_replicas() const { return !replicas_.empty(); }
+
+    const ReplicaOptions& options() const { return options_; }
+
+private:
+    void loop();
+
+    std::shared_ptr<PgConnectionPool> primary_;
+    std::vector<std::shared_ptr<PgConnectionPool>> replicas_;
+    ReplicaOptions options_;
+    ReplicaSelector selector_;
+
+    std::mutex probeMutex_;
+    std::vector<std::optional<bool>> probedUsable_;
+    // Пригодность реплик по последнему замеру (nullopt — ещё не замерена).
+    // Замеры не пересекаются: probe_once() держит probeMutex_.
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+}
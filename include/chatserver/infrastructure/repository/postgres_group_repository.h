@@ -0,0 +1,25 @@
+#pragma once
+
+#include "group_repository.h"
+#include <pqxx/pqxx>
+#include <string>
+
+namespace chatserver::infrastructure::repository {
+
+class PostgresGroupRepository final : public GroupRepository {
+    // Таблицы chat_groups и group_members (см. tools/migrate_db.sh).
+public:
+    explicit PostgresGroupRepository(const std::string& connStr);
+
+    std::int64_t create(const std::vector<chatserver::domain::UserId>& members) override;
+    // Группа и участники вставляются в одной транзакции.
+    std::vector<chatserver::domain::UserId> members(const chatserver::domain::GroupId& group) const override;
+    bool is_member(const chatserver::domain::GroupId& group,
+                   const chatserver::domain::UserId& user) const override;
+    // Точечный поиск по первичному ключу (group_id, user_id).
+
+private:
+    std::string connStr_;
+};
+
+}
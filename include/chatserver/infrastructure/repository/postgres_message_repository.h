@@ -1,19 +1,73 @@
 #pragma once
 
 #include "message_repository.h"
+#include "pg_connection_pool.h"
+#include "pg_replica_router.h"
 #include <pqxx/pqxx>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 
 namespace chatserver::infrastructure::repository {
 
+struct HistoryPruningOptions {
+    bool enabled = false;
+    // messages секционирована по created_at (messages_partitions != none): запросы
+    // истории добавляют условие на created_at, чтобы планировщик отбросил лишние партиции.
+    std::chrono::hours recentWindow{24 * 7};
+    // Сначала читается окно [верх - recentWindow, верх); остальные партиции — только
+    // если в окне не набралась страница.
+    std::chrono::seconds clockSkew{300};
+    // Допустимое расхождение часов узлов: на сколько created_at сообщения может быть
+    // позже времени, зашитого в id курсора.
+};
+
+struct HistoryTimeBounds {
+    std::optional<std::int64_t> beforeUs;
+    // Верхняя граница created_at страницы (мкс); nullopt — без ограничения.
+    std::int64_t recentFromUs = 0;
+    // Нижняя граница первого (узкого) запроса.
+};
+
+HistoryTimeBounds history_time_bounds(std::optional<chatserver::domain::MessageId> before,
+                                      std::int64_t nowUs,
+                                      const HistoryPruningOptions& options);
+// Курсор — id, выданный MessageIdGenerator (≥ 2^32, в нём время в мс): всё, что старше
+// него, создано не позже этого времени + clockSkew. id из последовательности БД времени
+// не несут — для них верхней границы нет.
+
 class PostgresMessageRepository final : public MessageRepository {
 public:
-    explicit PostgresMessageRepository(const std::string& connStr);
+    explicit PostgresMessageRepository(const std::string& connStr, HistoryPruningOptions pruning = {});
+    // Без пула: соединение на каждый запрос.
+    explicit PostgresMessageRepository(std::shared_ptr<PgConnectionPool> pool, HistoryPruningOptions pruning = {});
+    // Соединения берутся из pool (например, пул своей шарды, ShardedMessageRepository).
+    explicit PostgresMessageRepository(std::shared_ptr<PgReplicaRouter> router, HistoryPruningOptions pruning = {});
+    // Запись — в primary, find_page — в реплику, кроме переписок, в которые этот процесс
+    // писал в последние readYourWrites.
 
     std::int64_t save(const chatserver::domain::message::Message& message) override;
 
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+    // WHERE conversation_id = $1 AND id < $2 ORDER BY id DESC LIMIT $3 — один
+    // index range scan по messages_conversation_id_id_idx (см. tools/migrate_db.sh).
+    // С pruning.enabled — то же с условием на created_at (history_time_bounds): сначала
+    // по недавним партициям, при неполной странице — дочитывание более старых.
+
+    std::size_t save_batch(const std::vector<chatserver::domain::message::Message>& messages) override;
+    // Одна транзакция: COPY пачки во временную таблицу, затем
+    // INSERT ... SELECT ... ON CONFLICT DO NOTHING — уже сохранённые id пропускаются
+    // (ключ — id или, в секционированной таблице, (id, created_at): повтор пачки несёт
+    // то же created_at).
+
 private:
-    std::string connStr_;
+    std::shared_ptr<PgReplicaRouter> router_;
+    HistoryPruningOptions pruning_;
 };
 
 }
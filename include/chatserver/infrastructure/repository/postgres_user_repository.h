@@ -1,6 +1,7 @@
 #pragma once
 
 #include "user_repository.h"
+#include "pg_replica_router.h"
 #include <pqxx/pqxx>
 #include <memory>
 
@@ -9,13 +10,20 @@ namespace chatserver::infrastructure::repository {
 class PostgresUserRepository final : public UserRepository {
 public:
     explicit PostgresUserRepository(const std::string& connStr);
+    // Без пула и реплик: соединение с connStr на каждый запрос.
+    explicit PostgresUserRepository(std::shared_ptr<PgReplicaRouter> router);
+    // save — в primary; find_by_username и for_each_username — в реплику, кроме имён,
+    // записанных этим процессом в последние readYourWrites (регистрация и сразу вход).
 
     std::int64_t save(const chatserver::domain::user::User& user) override;
     std::optional<chatserver::domain::user::User>
     find_by_username(const std::string& username) override;
+    void for_each_username(const std::function<void(const std::string&)>& visit) override;
+    // SELECT username FROM users через потоковое чтение (COPY TO STDOUT): строки
+    // не копятся в pqxx::result. Ошибки БД пробрасываются.
 
 private:
-    std::string connStr_;
+    std::shared_ptr<PgReplicaRouter> router_;
 };
 
 }
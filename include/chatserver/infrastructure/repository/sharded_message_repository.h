@@ -0,0 +1,105 @@
+#pragma once
+
+#include "message_repository.h"
+#include "chatserver/infrastructure/concurrency/thread_pool.h"
+#include "chatserver/infrastructure/sharding/hash_ring.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+enum class ShardKey {
+    Conversation,
+    // Переписка целиком на одной шарде: история — запрос к одной БД.
+    Sender,
+    // Сообщение на шарде отправителя: запись одного пользователя не расползается
+    // по БД, но история личной переписки читается с двух шард (по участнику),
+    // групповой — со всех.
+};
+
+ShardKey parse_shard_key(const std::string& name);
+// "conversation" | "sender"; иначе std::invalid_argument.
+
+struct ShardStats {
+    std::string name;
+    std::uint64_t saves = 0;
+    // Сообщения, записанные на шарду (save и save_batch).
+    std::uint64_t reads = 0;
+    // Запросы find_page к шарде.
+    std::uint64_t failures = 0;
+};
+
+struct ShardedStats {
+    std::vector<ShardStats> shards;
+    std::uint64_t fanoutReads = 0;
+    // find_page, которым понадобилось больше одной шарды (ключ sender или перенос).
+};
+
+class ShardedMessageRepository final : public MessageRepository {
+// Маршрутизирует сообщения по N хранилищам (обычно PostgresMessageRepository со своим
+// пулом соединений на каждую БД) через консистентное кольцо sharding::HashRing.
+// Ключ — conversation_id или sender_id (ShardKey), позиция — shard_hash(ключ).
+//
+// Id сообщений должны быть глобальными: их назначает MessageIdGenerator до записи
+// (message_id_node), последовательности разных БД пересекались бы. save() без id —
+// std::invalid_argument.
+//
+// Чтение с нескольких шард (ключ sender, migrating-перенос диапазона) выполняется
+// параллельно на общем пуле из readThreads потоков (без пула — по очереди в
+// вызывающем потоке); страницы сливаются по id с удалением повторов (во время переноса
+// сообщение может лежать на обеих шардах) и обрезаются до limit. Ошибка любой из
+// шард — ошибка запроса: неполная история хуже отказа.
+public:
+    ShardedMessageRepository(sharding::HashRing ring,
+                             std::vector<std::shared_ptr<MessageRepository>> shards,
+                             ShardKey key = ShardKey::Conversation,
+                             std::size_t readThreads = 0);
+    // shards[i] — хранилище шарды ring.shards()[i]; размеры не совпадают — std::invalid_argument.
+    // readThreads — потоки общего пула чтения с нескольких шард; 0 — без пула.
+
+    std::int64_t save(const chatserver::domain::message::Message& message) override;
+
+    std::vector<chatserver::domain::message::Message> find_page(
+        const chatserver::domain::ConversationId& conversation,
+        std::optional<chatserver::domain::MessageId> before,
+        std::size_t limit) const override;
+
+    std::size_t save_batch(const std::vector<chatserver::domain::message::Message>& messages) override;
+    // Пачка делится по шардам; каждая часть — один save_batch своей шарды.
+
+    std::size_t shard_for(const chatserver::domain::message::Message& message) const;
+    // Индекс шарды, на которую пишется сообщение.
+
+    std::vector<std::size_t> shards_for(const chatserver::domain::ConversationId& conversation) const;
+    // Шарды, с которых читается история переписки.
+
+    const sharding::HashRing& ring() const { return ring_; }
+
+    ShardedStats stats() const;
+
+private:
+    struct FanOut;
+
+    struct Counters {
+        std::atomic<std::uint64_t> saves{0};
+        std::atomic<std::uint64_t> reads{0};
+        std::atomic<std::uint64_t> failures{0};
+    };
+
+    void add_key(std::int64_t key, std::vector<std::size_t>& out) const;
+
+    sharding::HashRing ring_;
+    std::vector<std::shared_ptr<MessageRepository>> shards_;
+    ShardKey key_;
+    std::unique_ptr<Counters[]> counters_;
+    mutable std::atomic<std::uint64_t> fanoutReads_{0};
+    std::unique_ptr<concurrency::ThreadPool> readers_;
+    // Последним: останавливается первым, пока шарды и счётчики ещё живы.
+};
+
+}
@@ -1,12 +1,22 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include "chatserver/domain/user/user.h"
 
 namespace chatserver::infrastructure::repository {
 
+class UsernameTakenError : public std::runtime_error {
+    // save() для уже занятого username. Общий контракт всех реализаций:
+    // Postgres переводит в него нарушение UNIQUE(username), in-memory бросает напрямую.
+public:
+    explicit UsernameTakenError(const std::string& username)
+        : std::runtime_error("username already exists: " + username) {}
+};
+
 class UserRepository {
 public:
     virtual ~UserRepository() = default;
@@ -14,6 +24,11 @@ public:
     virtual std::int64_t save(const chatserver::domain::user::User& user) = 0;
     virtual std::optional<chatserver::domain::user::User>
     find_by_username(const std::string& username) = 0;
+
+    virtual void for_each_username(const std::function<void(const std::string&)>& visit);
+    // Обходит имена всех пользователей потоком, не держа таблицу в памяти целиком —
+    // прогрев UsernameFilter при старте. Порядок не определён. Реализация по умолчанию
+    // бросает std::logic_error: хранилище не умеет перечислять пользователей.
 };
 
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chatserver::infrastructure::sharding {
+
+std::uint64_t shard_hash(std::int64_t key);
+// Позиция ключа (conversation_id или sender_id) на кольце. Функция зафиксирована:
+// от неё зависит, в какой БД лежат сохранённые сообщения, — менять только с
+// перекладкой всех данных.
+
+struct ShardSpec {
+    std::string name;
+    // Имя шарды — из него выводятся точки на кольце, поэтому порядок шард в списке
+    // и их DSN можно менять без перемещения данных.
+    int vnodes = 64;
+    // Виртуальных узлов (точек на кольце). Больше — ровнее доли шард. 0 — шарда
+    // известна (пул, цель переноса), но своих диапазонов на кольце не имеет.
+};
+
+struct HashRange {
+    std::uint64_t first = 0;
+    std::uint64_t last = 0;
+    // Включительно с обеих сторон: весь круг — [0, 2^64 - 1].
+
+    bool contains(std::uint64_t hash) const { return first <= hash && hash <= last; }
+};
+
+struct ShardMove {
+    HashRange range;
+    std::string target;
+    bool migrating = false;
+    // true — данные ещё переносятся (tools/chatshard copy): новые записи идут в target,
+    // чтение — из target и из прежнего владельца. false — диапазон окончательно у target.
+};
+
+std::vector<ShardSpec> parse_shard_specs(const std::string& list, int defaultVnodes);
+// "a,b,c:32" → шарды a и b с defaultVnodes, c — с 32. Пустое имя, повтор,
+// неверное число — std::invalid_argument.
+
+std::vector<ShardMove> parse_shard_moves(const std::string& list);
+// "<first>-<last>:<target>[:migrating], ..." — границы шестнадцатеричные (16 цифр).
+
+std::string format_shard_moves(const std::vector<ShardMove>& moves);
+// Обратное parse_shard_moves (для tools/chatshard plan).
+
+class HashRing {
+// Консистентное хэширование с виртуальными узлами. Каждая шарда ставит на кольцо
+// vnodes точек shard_hash(name#i); ключ принадлежит шарде первой точки не меньше
+// его хэша (по кругу). Добавление шарды забирает у соседей лишь диапазоны перед
+// её точками — около 1/N ключей, остальные остаются на месте.
+//
+// Поверх кольца — явные переносы диапазонов (ShardMove): ими перераспределяются
+// горячие диапазоны и проводится перебалансировка (сначала migrating, после
+// копирования — окончательно или вместе с новыми vnodes шарды-получателя).
+public:
+    HashRing(std::vector<ShardSpec> shards, std::vector<ShardMove> moves = {});
+    // Нет шард, нет ни одного vnode, перенос на неизвестную шарду или
+    // пересекающиеся переносы — std::invalid_argument.
+
+    std::size_t owner(std::uint64_t hash) const;
+    // Куда пишется ключ: цель переноса, если хэш в диапазоне переноса, иначе кольцо.
+
+    std::size_t settled_owner(std::uint64_t hash) const;
+    // Владелец без учёта незавершённых (migrating) переносов — откуда их копировать.
+
+    std::optional<std::size_t> previous_owner(std::uint64_t hash) const;
+    // Для хэша в migrating-переносе: прежний владелец, если он не совпадает с целью.
+    // Его данные ещё читаются вместе с данными цели.
+
+    std::size_t ring_owner(std::uint64_t hash) const;
+    // Только кольцо, без переносов.
+
+    std::vector<std::pair<HashRange, std::size_t>> arcs() const;
+    // Разбиение круга на диапазоны с владельцами по кольцу (без переносов),
+    // по возрастанию, соседние диапазоны одного владельца слиты.
+
+    std::vector<ShardMove> diff(const HashRing& next) const;
+    // Диапазоны, где владелец (owner) в next отличается от нашего, — переносы
+    // к владельцам next (target по имени, migrating = true).
+
+    std::vector<double> ownership() const;
+    // Доля круга за каждой шардой с учётом переносов.
+
+    std::optional<std::size_t> find(const std::string& name) const;
+
+    const std::vector<ShardSpec>& shards() const { return shards_; }
+    const std::vector<ShardMove>& moves() const { return moves_; }
+
+private:
+    const ShardMove* move_for(std::uint64_t hash) const;
+
+    std::vector<ShardSpec> shards_;
+    std::vector<ShardMove> moves_;
+    std::vector<std::size_t> moveTargets_;
+    // Индексы шард-целей moves_.
+    std::vector<std::pair<std::uint64_t, std::size_t>> points_;
+    // (точка, шарда), по возрастанию точки.
+};
+
+}
@@ -0,0 +1,42 @@
+#include "chatserver/application/handlers/create_group_handler.h"
+
+#include "chatserver/domain/message/conversation_id.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace chatserver::application {
+
+CreateGroupHandler::CreateGroupHandler(std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository)
+    : groupRepository_(std::move(groupRepository)) {}
+
+std::int64_t CreateGroupHandler::handle(const CreateGroupCommand& command) {
+    if (!groupRepository_) {
+        std::cerr << "[CreateGroupHandler] ERROR: groupRepository_ is null" << std::endl;
+        throw std::runtime_error("groupRepository not initialized");
+    }
+    if (command.member_ids.empty()) {
+        throw std::invalid_argument("group must have at least one member");
+    }
+    if (command.member_ids.size() > kMaxMembers) {
+        throw std::invalid_argument("too many group members");
+    }
+
+    std::vector<domain::UserId> members;
+    members.reserve(command.member_ids.size());
+    for (auto id : command.member_ids) {
+        // Те же границы, что у участника личной переписки: id должен помещаться в 32 бита.
+        domain::ConversationId::between(domain::UserId(id), domain::UserId(id));
+        members.emplace_back(id);
+    }
+
+    try {
+        return groupRepository_->create(members);
+    } catch (const std::exception& e) {
+        std::cerr << "[CreateGroupHandler] groupRepository create failed: " << e.what() << std::endl;
+        throw;
+    }
+}
+
+} // namespace chatserver::application
@@ -0,0 +1,156 @@
+#include "chatserver/application/handlers/get_message_history_handler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace chatserver::application {
+
+GetMessageHistoryHandler::GetMessageHistoryHandler(
+    std::shared_ptr<domain::services::MessageEncryptor> encryptor,
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository,
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache
+)
+    : encryptor_(std::move(encryptor))
+    , messageRepository_(std::move(messageRepository))
+    , groupRepository_(std::move(groupRepository))
+    , cache_(std::move(cache)) {}
+
+MessageHistoryPage GetMessageHistoryHandler::handle(const GetMessageHistoryQuery& query) const {
+    if (!encryptor_ || !messageRepository_) {
+        std::cerr << "[GetMessageHistoryHandler] ERROR: dependencies are not initialized" << std::endl;
+        throw std::runtime_error("GetMessageHistoryHandler not initialized");
+    }
+
+    const std::size_t limit = std::clamp<std::size_t>(
+        query.limit == 0 ? kDefaultLimit : query.limit, 1, kMaxLimit);
+
+    std::optional<domain::MessageId> before;
+    if (query.before_id) {
+        before.emplace(*query.before_id);
+    }
+
+    // std::invalid_argument для невалидной пары (или группы) — HTTP-слой отвечает на него 400.
+    auto conversation = query.group_id
+        ? domain::ConversationId::group(domain::GroupId(*query.group_id))
+        : domain::ConversationId::between(domain::UserId(query.user_id), domain::UserId(query.peer_id));
+    if (query.group_id) {
+        if (!groupRepository_) {
+            throw std::runtime_error("group chats are not configured");
+        }
+        if (!groupRepository_->is_member(domain::GroupId(*query.group_id), domain::UserId(query.user_id))) {
+            throw infrastructure::repository::NotGroupMemberError(*query.group_id, query.user_id);
+        }
+    }
+
+    // Просим на одну запись больше: так has_more известен без отдельного COUNT.
+    if (cache_) {
+        if (auto cached = cache_->find_page(conversation.value(), query.before_id, limit + 1)) {
+            return page_from_cache(std::move(*cached), limit);
+        }
+    }
+
+    // Промах первой страницы заполняет кэш: читаем весь хвост, который помещается в кольцо.
+    const std::uint64_t ticket = (cache_ && !before) ? cache_->begin_fill(conversation.value()) : 0;
+    const std::size_t fetch = ticket ? std::max(limit + 1, cache_->messages_per_conversation()) : limit + 1;
+    const bool fillPlain = ticket != 0 && cache_->stores_plain_text();
+
+    std::vector<domain::message::Message> rows;
+    std::vector<std::string> plainTexts;
+    try {
+        rows = messageRepository_->find_page(conversation, before, fetch);
+
+        // Для кэша с открытым текстом расшифровываем весь хвост, иначе — только страницу.
+        const std::size_t decryptCount = fillPlain ? rows.size() : std::min(rows.size(), limit);
+        std::vector<std::string> cipherTexts;
+        cipherTexts.reserve(decryptCount);
+        for (std::size_t i = 0; i < decryptCount; ++i) {
+            cipherTexts.push_back(rows[i].text().value());
+        }
+        plainTexts = encryptor_->decrypt_batch(cipherTexts);
+        if (plainTexts.size() != decryptCount) {
+            throw std::runtime_error("decrypt_batch returned a different number of messages");
+        }
+
+        if (ticket) {
+            std::vector<infrastructure::cache::CachedMessage> tail;
+            tail.reserve(rows.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                tail.push_back(infrastructure::cache::CachedMessage{
+                    rows[i].id().value(),
+                    rows[i].sender_id().value(),
+                    rows[i].receiver_id().value(),
+                    rows[i].group_id() ? rows[i].group_id()->value() : 0,
+                    rows[i].created_at().epoch_micros(),
+                    fillPlain ? plainTexts[i] : rows[i].text().value()
+                });
+            }
+            cache_->complete_fill(conversation.value(), ticket, std::move(tail), rows.size() < fetch);
+        }
+    } catch (...) {
+        if (ticket) {
+            cache_->abort_fill(conversation.value(), ticket);
+        }
+        throw;
+    }
+
+    MessageHistoryPage page;
+    page.has_more = rows.size() > limit;
+    if (rows.size() > limit) {
+        rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(limit), rows.end());
+    }
+
+    page.messages.reserve(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        page.messages.push_back(MessageHistoryItem{
+            rows[i].id().value(),
+            rows[i].sender_id().value(),
+            rows[i].receiver_id().value(),
+            std::move(plainTexts[i]),
+            rows[i].created_at().epoch_micros(),
+            rows[i].group_id() ? rows[i].group_id()->value() : 0
+        });
+    }
+    return page;
+}
+
+MessageHistoryPage GetMessageHistoryHandler::page_from_cache(
+    std::vector<infrastructure::cache::CachedMessage> rows, std::size_t limit) const {
+    MessageHistoryPage page;
+    page.has_more = rows.size() > limit;
+    if (rows.size() > limit) {
+        rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(limit), rows.end());
+    }
+
+    if (!cache_->stores_plain_text()) {
+        // Кэш шифртекстов: хранилище не нужно, расшифровка — как обычно, одной пачкой.
+        std::vector<std::string> cipherTexts;
+        cipherTexts.reserve(rows.size());
+        for (auto& row : rows) {
+            cipherTexts.push_back(std::move(row.text));
+        }
+        auto plainTexts = encryptor_->decrypt_batch(cipherTexts);
+        if (plainTexts.size() != rows.size()) {
+            throw std::runtime_error("decrypt_batch returned a different number of messages");
+        }
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            rows[i].text = std::move(plainTexts[i]);
+        }
+    }
+
+    page.messages.reserve(rows.size());
+    for (auto& row : rows) {
+        page.messages.push_back(MessageHistoryItem{
+            row.id,
+            row.senderId,
+            row.receiverId,
+            std::move(row.text),
+            row.createdAt,
+            row.groupId
+        });
+    }
+    return page;
+}
+
+} // namespace chatserver::application
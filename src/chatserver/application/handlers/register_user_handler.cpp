@@ -9,13 +9,15 @@ namespace chatserver::application {
 RegisterUserHandler::RegisterUserHandler(
     std::shared_ptr<domain::services::PasswordHasher> passwordHasher,
     // PasswordHasher — доменный сервис, отвечающий за хэширование паролей.
-    std::shared_ptr<infrastructure::repository::UserRepository> userRepository
+    std::shared_ptr<infrastructure::repository::UserRepository> userRepository,
     // UserRepository — инфраструктурный компонент, который знает о БД.
+    std::shared_ptr<infrastructure::cache::UsernameFilter> usernameFilter
 )
     : passwordHasher_(std::move(passwordHasher))
     // Сохраняем сервис хэширования в приватное поле.
-    , userRepository_(std::move(userRepository)) {}
+    , userRepository_(std::move(userRepository))
     // Сохраняем репозиторий пользователей.
+    , usernameFilter_(std::move(usernameFilter)) {}
 
 std::int64_t RegisterUserHandler::handle(
     const RegisterUserCommand& command
@@ -39,6 +41,16 @@ std::int64_t RegisterUserHandler::handle(
             throw std::runtime_error("userRepository not initialized");
         }
 
+        if (usernameFilter_ && usernameFilter_->may_contain(command.username)) {
+            // 0. Фильтр не исключил имя: подтверждаем поиском (обычно попадает в кэш
+            // пользователей) и отказываем, не тратя ~50 мс CPU на PBKDF2.
+            if (userRepository_->find_by_username(command.username)) {
+                std::cout << "[RegisterUserHandler] username taken (filter precheck)" << std::endl;
+                throw infrastructure::repository::UsernameTakenError(command.username);
+            }
+            usernameFilter_->note_false_positive();
+        }
+
         std::cout << "[RegisterUserHandler] calling passwordHasher_->hash" << std::endl;
         auto hash = passwordHasher_->hash(command.password);
         // 1. Хэшируем пароль через доменный сервис.
@@ -55,10 +67,18 @@ std::int64_t RegisterUserHandler::handle(
         );
         std::cout << "[RegisterUserHandler] user constructed" << std::endl;
 
-        auto id = userRepository_->save(user);
-        // 2. Сохраняем пользователя через репозиторий.
-        // Handler не знает SQL — только вызывает интерфейс.
-        // save() возвращает ID созданного пользователя.
+        std::int64_t id = 0;
+        try {
+            id = userRepository_->save(user);
+            // 2. Сохраняем пользователя через репозиторий.
+            // Handler не знает SQL — только вызывает интерфейс.
+            // save() возвращает ID созданного пользователя.
+        } catch (const infrastructure::repository::UsernameTakenError&) {
+            // Имя заняли мимо фильтра (другой узел или гонка) — запоминаем его.
+            if (usernameFilter_) usernameFilter_->add(command.username);
+            throw;
+        }
+        if (usernameFilter_) usernameFilter_->add(command.username);
         std::cout << "[RegisterUserHandler] save returned id=" << id << std::endl;
 
         return id;
@@ -0,0 +1,92 @@
+#include "chatserver/application/handlers/send_group_message_handler.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace chatserver::application {
+
+SendGroupMessageHandler::SendGroupMessageHandler(
+    std::shared_ptr<domain::services::MessageEncryptor> encryptor,
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepository,
+    std::shared_ptr<domain::services::MessageNotifier> notifier,
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache,
+    std::shared_ptr<domain::MessageIdGenerator> ids
+)
+    : encryptor_(std::move(encryptor))
+    , messageRepository_(std::move(messageRepository))
+    , groupRepository_(std::move(groupRepository))
+    , notifier_(std::move(notifier))
+    , cache_(std::move(cache))
+    , ids_(std::move(ids)) {}
+
+std::int64_t SendGroupMessageHandler::handle(const SendGroupMessageCommand& command) {
+    if (!encryptor_ || !messageRepository_ || !groupRepository_) {
+        std::cerr << "[SendGroupMessageHandler] ERROR: dependencies are not initialized" << std::endl;
+        throw std::runtime_error("SendGroupMessageHandler not initialized");
+    }
+
+    const domain::GroupId groupId(command.group_id);
+    const domain::UserId senderId(command.sender_id);
+    const auto conversation = domain::ConversationId::group(groupId);
+    // Невалидный id группы — std::invalid_argument (400) до похода в хранилище.
+
+    // Один запрос за составом: он нужен и для проверки членства, и для рассылки.
+    auto members = groupRepository_->members(groupId);
+    const auto self = std::find(members.begin(), members.end(), senderId);
+    if (self == members.end()) {
+        throw infrastructure::repository::NotGroupMemberError(command.group_id, command.sender_id);
+    }
+    members.erase(self);
+
+    std::string encrypted;
+    try {
+        encrypted = encryptor_->encrypt(command.text);
+        // Шифруем один раз на сообщение, а не на участника.
+    } catch (const std::exception& e) {
+        std::cerr << "[SendGroupMessageHandler] encryption failed: " << e.what() << std::endl;
+        throw;
+    }
+
+    const auto createdAt = domain::Timestamp::now();
+
+    std::int64_t messageId = 0;
+    try {
+        // Одна запись в хранилище на всю группу.
+        messageId = messageRepository_->save(domain::message::Message(
+            ids_ ? ids_->next() : domain::MessageId(0),
+            senderId, groupId, domain::MessageText(encrypted), createdAt));
+    } catch (const std::exception& e) {
+        std::cerr << "[SendGroupMessageHandler] messageRepository save failed: " << e.what() << std::endl;
+        throw;
+    }
+
+    if (cache_) {
+        try {
+            cache_->append(conversation.value(), infrastructure::cache::CachedMessage{
+                messageId, command.sender_id, 0, command.group_id, createdAt.epoch_micros(),
+                cache_->stores_plain_text() ? command.text : encrypted});
+        } catch (const std::exception& e) {
+            std::cerr << "[SendGroupMessageHandler] cache write failed: " << e.what() << std::endl;
+        }
+    }
+
+    if (notifier_) {
+        // Как и для личного сообщения: доставка только после сохранения,
+        // её ошибка не отменяет отправку.
+        try {
+            notifier_->group_message_stored(domain::message::Message(
+                domain::MessageId(messageId),
+                senderId,
+                groupId,
+                domain::MessageText(command.text),
+                createdAt), members);
+        } catch (const std::exception& e) {
+            std::cerr << "[SendGroupMessageHandler] notify failed: " << e.what() << std::endl;
+        }
+    }
+    return messageId;
+}
+
+} // namespace chatserver::application
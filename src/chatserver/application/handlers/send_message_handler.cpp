@@ -4,7 +4,9 @@
 
 #include <iostream>
 #include <exception>
+#include <functional>
 #include <stdexcept>
+#include <string>
 
 namespace chatserver::application {
 
@@ -12,18 +14,44 @@ SendMessageHandler::SendMessageHandler(
     std::shared_ptr<domain::services::MessageEncryptor> encryptor,
     // MessageEncryptor — доменный сервис, отвечающий за шифрование текста.
     // Handler не знает алгоритм (AES/ChaCha20/etc.) — это скрыто за интерфейсом.
-    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepository,
     // MessageRepository — инфраструктурный компонент, который знает о БД.
     // Handler работает только с интерфейсом, не зная SQL.
+    std::shared_ptr<domain::services::MessageNotifier> notifier,
+    // MessageNotifier — доставка получателю в реальном времени (может быть nullptr).
+    std::shared_ptr<infrastructure::cache::ConversationCache> cache,
+    // ConversationCache — кэш истории (может быть nullptr).
+    std::shared_ptr<infrastructure::cache::IdempotencyTable> idempotency,
+    // IdempotencyTable — ключи идемпотентности (может быть nullptr).
+    std::shared_ptr<domain::MessageIdGenerator> ids
+    // MessageIdGenerator — id сообщения до сохранения (может быть nullptr).
 )
     : encryptor_(std::move(encryptor))
     // Сохраняем сервис шифрования. std::move — корректно для shared_ptr.
-    , messageRepository_(std::move(messageRepository)) {}
+    , messageRepository_(std::move(messageRepository))
+    , notifier_(std::move(notifier))
+    , cache_(std::move(cache))
+    , idempotency_(std::move(idempotency))
+    , ids_(std::move(ids)) {}
     // Сохраняем репозиторий сообщений. Handler полностью готов выполнять use‑case.
 
 std::int64_t SendMessageHandler::handle(const SendMessageCommand& command) {
+    if (!idempotency_ || !command.idempotency_key) {
+        return send(command);
+    }
+    // Ключ клиента действует в пределах отправителя: одинаковые ключи разных
+    // клиентов не пересекаются. Отпечаток — получатель и текст: тот же ключ
+    // с другим сообщением не должен вернуть чужой id.
+    const std::string key = std::to_string(command.sender_id) + ':' + *command.idempotency_key;
+    std::uint64_t fingerprint = std::hash<std::string>{}(command.text);
+    fingerprint ^= static_cast<std::uint64_t>(command.receiver_id) * 0x9E3779B97F4A7C15ull;
+    // Повторы считает сама таблица (IdempotencyStats::replayed).
+    return idempotency_->execute(key, fingerprint, [&] { return send(command); }).id;
+}
+
+std::int64_t SendMessageHandler::send(const SendMessageCommand& command) {
     // Основной метод use‑case "отправить сообщение".
-    // Принимает SendMessageCommand (sender_id, text).
+    // Принимает SendMessageCommand (sender_id, receiver_id, text).
     // Преобразует данные в доменные объекты, шифрует текст, создаёт Message и 
     // сохраняет его через репозиторий.
 
@@ -40,6 +68,11 @@ std::int64_t SendMessageHandler::handle(const SendMessageCommand& command) {
             throw std::runtime_error("messageRepository not initialized");
         }
 
+        // Пара участников должна образовывать валидный ключ переписки — проверяем
+        // до шифрования, std::invalid_argument уходит клиенту как 400.
+        const auto conversation = domain::ConversationId::between(domain::UserId(command.sender_id),
+                                                                  domain::UserId(command.receiver_id));
+
         std::string encrypted;
         try {
             encrypted = encryptor_->encrypt(command.text);
@@ -51,22 +84,56 @@ std::int64_t SendMessageHandler::handle(const SendMessageCommand& command) {
             throw;
         }
 
-        // Создаём доменную сущность Message.
+        const auto createdAt = domain::Timestamp::now();  // Фиксируем время создания.
+
+        // Создаём доменную сущность Message. С генератором id известен до сохранения.
         domain::message::Message message(
+            ids_ ? ids_->next() : domain::MessageId(0),
             domain::UserId(command.sender_id), // Превращаем sender_id в доменный UserId.
+            domain::UserId(command.receiver_id), // И receiver_id — тоже.
             domain::MessageText(encrypted), // Оборачиваем зашифрованный текст в Value Object.
-            domain::Timestamp::now()  // Фиксируем время создания.
+            createdAt
         );
 
+        std::int64_t messageId = 0;
         try {
             // 2. Сохраняем сообщение через репозиторий.
             // Handler не знает SQL — только вызывает интерфейс.
-            return messageRepository_->save(message);
+            messageId = messageRepository_->save(message);
         } catch (const std::exception& e) {
             // Логируем ошибку сохранения и пробрасываем дальше.
             std::cerr << "[SendMessageHandler] messageRepository save failed: " << e.what() << std::endl;
             throw;
         }
+
+        if (cache_) {
+            // Write-through: горячая переписка видит сообщение без похода в хранилище.
+            // Кэш — не источник истины: его ошибка отправку не отменяет.
+            try {
+                cache_->append(conversation.value(), infrastructure::cache::CachedMessage{
+                    messageId, command.sender_id, command.receiver_id, 0, createdAt.epoch_micros(),
+                    cache_->stores_plain_text() ? command.text : encrypted});
+            } catch (const std::exception& e) {
+                std::cerr << "[SendMessageHandler] cache write failed: " << e.what() << std::endl;
+            }
+        }
+
+        if (notifier_) {
+            // 3. Доставляем получателю — только после успешного сохранения, чтобы
+            // клиент никогда не увидел сообщение, которого нет в истории.
+            // Ошибка доставки не отменяет отправку: сообщение уже сохранено.
+            try {
+                notifier_->message_stored(domain::message::Message(
+                    domain::MessageId(messageId),
+                    domain::UserId(command.sender_id),
+                    domain::UserId(command.receiver_id),
+                    domain::MessageText(command.text),
+                    createdAt));
+            } catch (const std::exception& e) {
+                std::cerr << "[SendMessageHandler] notify failed: " << e.what() << std::endl;
+            }
+        }
+        return messageId;
     } catch (const std::exception& ex) {
         // Ловим любые std::exception — логируем и пробрасываем дальше.
         // Это позволяет HTTP‑слою вернуть корректный статус (например, 500).
@@ -0,0 +1 @@
+#include "chatserver/application/queries/get_message_history_query.h"
@@ -4,21 +4,134 @@
 #include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
 #include "chatserver/infrastructure/repository/postgres_user_repository.h"
 #include "chatserver/infrastructure/repository/postgres_message_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_user_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_shard_repository.h"
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+#include "chatserver/infrastructure/repository/postgres_group_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
 #include "chatserver/application/handlers/register_user_handler.h"
 #include "chatserver/application/handlers/login_user_handler.h"
 #include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/create_group_handler.h"
+#include "chatserver/application/handlers/send_group_message_handler.h"
 #include "chatserver/infrastructure/http/resources/user_resource.h"
 #include "chatserver/infrastructure/http/resources/message_resource.h"
+#include "chatserver/infrastructure/http/resources/admin_resource.h"
+#include "chatserver/infrastructure/http/resources/group_resource.h"
+#include "chatserver/infrastructure/http/resources/long_poll_resource.h"
 #include "chatserver/infrastructure/http/http_server.h"
 #include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 namespace chatserver::bootstrap {
 
+StorageBackend parse_storage_backend(const std::string& name)
+{
+    if (name == "postgres") return StorageBackend::Postgres;
+    if (name == "memory")   return StorageBackend::InMemory;
+    if (name == "log")      return StorageBackend::EmbeddedLog;
+    throw std::invalid_argument("unknown storage backend: " + name);
+}
+
+infrastructure::repository::FsyncPolicy parse_fsync_policy(const std::string& name)
+{
+    using infrastructure::repository::FsyncPolicy;
+    if (name == "always")   return FsyncPolicy::EveryWrite;
+    if (name == "group")    return FsyncPolicy::GroupCommit;
+    if (name == "interval") return FsyncPolicy::Interval;
+    throw std::invalid_argument("unknown fsync policy: " + name);
+}
+
+infrastructure::http::SlowConsumerPolicy parse_slow_consumer_policy(const std::string& name)
+{
+    using infrastructure::http::SlowConsumerPolicy;
+    if (name == "throttle")   return SlowConsumerPolicy::Throttle;
+    if (name == "disconnect") return SlowConsumerPolicy::Disconnect;
+    throw std::invalid_argument("unknown slow consumer policy: " + name);
+}
+
+infrastructure::cache::CachedTextForm parse_cached_text_form(const std::string& name)
+{
+    using infrastructure::cache::CachedTextForm;
+    if (name == "plain")     return CachedTextForm::Plain;
+    if (name == "encrypted") return CachedTextForm::Encrypted;
+    throw std::invalid_argument("unknown cached text form: " + name);
+}
+
+domain::TimestampClock parse_timestamp_clock(const std::string& name)
+{
+    if (name == "precise") return domain::TimestampClock::Precise;
+    if (name == "coarse")  return domain::TimestampClock::Coarse;
+    if (name == "cached")  return domain::TimestampClock::Cached;
+    throw std::invalid_argument("unknown timestamp clock: " + name);
+}
+
+std::unordered_map<std::string, std::chrono::milliseconds> parse_route_deadlines(const std::string& list)
+{
+    std::unordered_map<std::string, std::chrono::milliseconds> budgets;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) continue;
+        const auto colon = item.rfind(':');
+        if (colon == std::string::npos || colon == 0 || item.front() != '/') {
+            throw std::invalid_argument("bad route deadline (expected /path:ms): " + item);
+        }
+        std::size_t used = 0;
+        const auto ms = std::stoll(item.substr(colon + 1), &used);
+        if (used != item.size() - colon - 1 || ms < 0) {
+            throw std::invalid_argument("bad route deadline (expected /path:ms): " + item);
+        }
+        budgets[item.substr(0, colon)] = std::chrono::milliseconds(ms);
+    }
+    return budgets;
+}
+
+std::unordered_map<std::string, std::string> parse_route_classes(const std::string& list)
+{
+    std::unordered_map<std::string, std::string> classes;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) continue;
+        const auto colon = item.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == item.size() || item.front() != '/') {
+            throw std::invalid_argument("bad route class (expected /path:class): " + item);
+        }
+        classes[item.substr(0, colon)] = item.substr(colon + 1);
+    }
+    return classes;
+}
+
 AppContext initialize_app(const std::string& dbConnStr,
                           const std::string& secret,
                           const std::string& address,
-                          int port)
+                          int port,
+                          const StorageOptions& storage,
+                          const infrastructure::http::HttpServerOptions& http,
+                          const infrastructure::concurrency::AdmissionOptions& admission)
 {
+    // ---------------------
+    // Clock: время создания сообщений (Timestamp::now() на каждую отправку)
+    // ---------------------
+    std::shared_ptr<infrastructure::concurrency::ClockTicker> clockTicker;
+    if (storage.timestampClock == domain::TimestampClock::Cached) {
+        clockTicker = std::make_shared<infrastructure::concurrency::ClockTicker>(storage.timestampTick);
+    } else {
+        domain::Timestamp::use_clock(storage.timestampClock);
+    }
+
     // ---------------------
     // Crypto
     // ---------------------
@@ -28,15 +141,199 @@ AppContext initialize_app(const std::string& dbConnStr,
     // ---------------------
     // Repositories
     // ---------------------
-    auto userRepo    = std::make_shared<infrastructure::repository::PostgresUserRepository>(dbConnStr);
-    auto messageRepo = std::make_shared<infrastructure::repository::PostgresMessageRepository>(dbConnStr);
+    std::shared_ptr<infrastructure::repository::UserRepository> userRepo;
+    std::shared_ptr<infrastructure::repository::MessageRepository> messageRepo;
+    std::shared_ptr<infrastructure::repository::GroupRepository> groupRepo;
+    std::shared_ptr<infrastructure::repository::CachingUserRepository> userCache;
+    std::shared_ptr<domain::MessageIdGenerator> messageIds;
+    std::shared_ptr<infrastructure::repository::OutboxMessageRepository> outbox;
+    std::shared_ptr<infrastructure::repository::MessagePartitionMaintainer> partitions;
+    std::shared_ptr<infrastructure::repository::ShardedMessageRepository> sharded;
+    std::vector<std::shared_ptr<infrastructure::repository::PgConnectionPool>> shardPools;
+    std::vector<std::shared_ptr<infrastructure::repository::MessagePartitionMaintainer>> shardPartitions;
+    std::shared_ptr<infrastructure::repository::PgReplicaRouter> replicas;
+    const bool partitioned = storage.partitions.interval != infrastructure::repository::PartitionInterval::None;
+    switch (storage.backend) {
+    case StorageBackend::Postgres:
+        if (!storage.replicas.empty()) {
+            // С репликами соединения держатся в пулах: замер отставания и выбор реплики
+            // не должны добавлять установку соединения к каждому чтению.
+            std::vector<std::shared_ptr<infrastructure::repository::PgConnectionPool>> replicaPools;
+            for (const auto& replica : storage.replicas) {
+                replicaPools.push_back(std::make_shared<infrastructure::repository::PgConnectionPool>(
+                    replica, storage.replicaRouting.pool));
+            }
+            replicas = std::make_shared<infrastructure::repository::PgReplicaRouter>(
+                std::make_shared<infrastructure::repository::PgConnectionPool>(dbConnStr, storage.replicaRouting.pool),
+                std::move(replicaPools), storage.replicaRouting);
+            std::size_t usable = 0;
+            for (const auto& r : replicas->stats().replicas) usable += r.usable ? 1 : 0;
+            std::cerr << "[INFO] DB replicas: " << storage.replicas.size() << " (" << usable
+                      << " within max lag)" << std::endl;
+            userRepo = std::make_shared<infrastructure::repository::PostgresUserRepository>(replicas);
+        } else {
+            userRepo = std::make_shared<infrastructure::repository::PostgresUserRepository>(dbConnStr);
+        }
+        if (storage.userCache.capacity > 0) {
+            // Вход читает пользователя каждый раз: кэш снимает с БД повторные /login.
+            userCache = std::make_shared<infrastructure::repository::CachingUserRepository>(
+                userRepo, storage.userCache);
+            userRepo  = userCache;
+        }
+        groupRepo   = std::make_shared<infrastructure::repository::PostgresGroupRepository>(dbConnStr);
+        if (storage.messageIdNode >= 0) {
+            // id сообщения назначает сервер: INSERT без RETURNING (колонка id — BIGINT,
+            // см. tools/migrate_db.sh). Локальные хранилища нумеруют сообщения сами.
+            messageIds = std::make_shared<domain::MessageIdGenerator>(storage.messageIdNode);
+            std::cerr << "[INFO] Message ids: generated, node " << storage.messageIdNode << std::endl;
+        }
+        {
+            infrastructure::repository::HistoryPruningOptions pruning;
+            pruning.enabled = partitioned;
+            pruning.recentWindow = storage.historyRecentWindow;
+            if (storage.sharding.shards.empty()) {
+                if (partitioned) {
+                    // Партиции на ahead интервалов вперёд должны существовать до первой вставки.
+                    partitions = std::make_shared<infrastructure::repository::MessagePartitionMaintainer>(
+                        dbConnStr, storage.partitions);
+                    const auto s = partitions->stats();
+                    std::cerr << "[INFO] Message partitions: " << s.partitions << ", covered until "
+                              << s.coveredUntilUnix << std::endl;
+                }
+                if (replicas) {
+                    messageRepo = std::make_shared<infrastructure::repository::PostgresMessageRepository>(
+                        replicas, pruning);
+                } else {
+                    messageRepo = std::make_shared<infrastructure::repository::PostgresMessageRepository>(
+                        dbConnStr, pruning);
+                }
+            } else {
+                // Последовательности разных БД выдают одинаковые id — нумерует сервер.
+                if (!messageIds) {
+                    throw std::invalid_argument("message_shards requires message_id_node >= 0");
+                }
+                std::vector<std::shared_ptr<infrastructure::repository::MessageRepository>> shardRepos;
+                for (const auto& shard : storage.sharding.shards) {
+                    const auto conn = storage.sharding.connections.find(shard.name);
+                    if (conn == storage.sharding.connections.end()) {
+                        throw std::invalid_argument("no connection string for message shard " + shard.name +
+                                                    " (message_shard_" + shard.name + ")");
+                    }
+                    auto pool = std::make_shared<infrastructure::repository::PgConnectionPool>(
+                        conn->second, storage.sharding.pool);
+                    if (partitioned) {
+                        shardPartitions.push_back(std::make_shared<infrastructure::repository::MessagePartitionMaintainer>(
+                            conn->second, storage.partitions));
+                    }
+                    shardRepos.push_back(std::make_shared<infrastructure::repository::PostgresMessageRepository>(
+                        pool, pruning));
+                    shardPools.push_back(std::move(pool));
+                }
+                sharded = std::make_shared<infrastructure::repository::ShardedMessageRepository>(
+                    infrastructure::sharding::HashRing(storage.sharding.shards, storage.sharding.moves),
+                    std::move(shardRepos), storage.sharding.key, storage.sharding.readThreads);
+                messageRepo = sharded;
+            }
+        }
+        if (!storage.outbox.directory.empty()) {
+            // Ровно один раз держится на id, назначенных до записи: без генератора
+            // повтор пачки после рестарта продублировал бы сообщения.
+            if (!messageIds) {
+                throw std::invalid_argument("outbox requires message_id_node >= 0");
+            }
+            outbox = std::make_shared<infrastructure::repository::OutboxMessageRepository>(
+                messageRepo, storage.outbox);
+            messageIds->advance_past(domain::MessageId(outbox->max_replayed_id()));
+            messageRepo = outbox;
+            std::cerr << "[INFO] Message outbox: " << storage.outbox.directory << ", "
+                      << outbox->stats().pending << " messages to replay" << std::endl;
+        }
+        break;
+    case StorageBackend::InMemory:
+        // dbConnStr не используется: всё состояние живёт в памяти процесса.
+        userRepo    = std::make_shared<infrastructure::repository::InMemoryUserRepository>();
+        messageRepo = std::make_shared<infrastructure::repository::InMemoryMessageRepository>();
+        groupRepo   = std::make_shared<infrastructure::repository::InMemoryGroupRepository>();
+        if (!storage.sharding.shards.empty()) {
+            // Шарды в памяти — для локальной проверки маршрутизации без нескольких Postgres.
+            std::vector<std::shared_ptr<infrastructure::repository::MessageRepository>> shardRepos;
+            for (std::size_t i = 0; i < storage.sharding.shards.size(); ++i) {
+                shardRepos.push_back(std::make_shared<infrastructure::repository::InMemoryShardRepository>());
+            }
+            messageIds = std::make_shared<domain::MessageIdGenerator>(std::max<std::int64_t>(0, storage.messageIdNode));
+            sharded = std::make_shared<infrastructure::repository::ShardedMessageRepository>(
+                infrastructure::sharding::HashRing(storage.sharding.shards, storage.sharding.moves),
+                std::move(shardRepos), storage.sharding.key, storage.sharding.readThreads);
+            messageRepo = sharded;
+        }
+        break;
+    case StorageBackend::EmbeddedLog:
+        userRepo    = std::make_shared<infrastructure::repository::InMemoryUserRepository>();
+        messageRepo = std::make_shared<infrastructure::repository::LogMessageRepository>(storage.log);
+        groupRepo   = std::make_shared<infrastructure::repository::InMemoryGroupRepository>();
+        break;
+    }
+    if (!outbox && !storage.outbox.directory.empty()) {
+        std::cerr << "[WARN] outbox_dir is ignored: the outbox fronts Postgres only" << std::endl;
+    }
+    if (sharded) {
+        std::cerr << "[INFO] Message shards: " << sharded->ring().shards().size() << ", "
+                  << sharded->ring().moves().size() << " range moves" << std::endl;
+    } else if (!storage.sharding.shards.empty()) {
+        std::cerr << "[WARN] message_shards is ignored: sharding needs storage = postgres or memory" << std::endl;
+    }
+    if (!replicas && !storage.replicas.empty()) {
+        std::cerr << "[WARN] db_replicas is ignored: replicas front Postgres only" << std::endl;
+    }
+    if (!partitions && shardPartitions.empty() && partitioned) {
+        std::cerr << "[WARN] messages_partitions is ignored: only Postgres tables are partitioned" << std::endl;
+    }
+
+    // Фильтр занятых имён: заполняем из хранилища до приёма запросов. Неудачная или
+    // неполная загрузка не опасна — окончательно имя проверяет save(); фильтр
+    // в худшем случае пропустит дубликат до хэширования, как без него.
+    std::shared_ptr<infrastructure::cache::UsernameFilter> usernameFilter;
+    if (storage.usernameFilter.expectedItems > 0) {
+        usernameFilter = std::make_shared<infrastructure::cache::UsernameFilter>(storage.usernameFilter);
+        try {
+            userRepo->for_each_username([&usernameFilter](const std::string& name) {
+                usernameFilter->add(name);
+            });
+            const auto s = usernameFilter->stats();
+            std::cerr << "[INFO] Username filter: " << s.items << " names, " << (s.bytes >> 10)
+                      << " KB, estimated fpr " << s.estimatedFpr << std::endl;
+        } catch (const std::exception& ex) {
+            std::cerr << "[WARN] Username filter load failed, continuing with a partial filter: "
+                      << ex.what() << std::endl;
+        }
+    }
+
+    // Повторы /send_message с тем же Idempotency-Key: в памяти процесса, для всех хранилищ.
+    std::shared_ptr<infrastructure::cache::IdempotencyTable> idempotency;
+    if (storage.idempotency.capacity > 0) {
+        idempotency = std::make_shared<infrastructure::cache::IdempotencyTable>(storage.idempotency);
+    }
+
+    // Кэш горячих переписок: одинаково для всех хранилищ, пишут в него обработчики отправки.
+    std::shared_ptr<infrastructure::cache::ConversationCache> conversationCache;
+    if (storage.conversationCache.budgetBytes > 0) {
+        conversationCache = std::make_shared<infrastructure::cache::ConversationCache>(storage.conversationCache);
+    }
+
+    // ---------------------
+    // Realtime delivery (WebSocket и long-poll)
+    // ---------------------
+    auto connections = std::make_shared<infrastructure::realtime::ConnectionRegistry>();
+    auto longPoll    = std::make_shared<infrastructure::realtime::LongPollRegistry>();
+    auto notifier    = std::make_shared<infrastructure::realtime::RealtimeMessageNotifier>(connections, longPoll);
 
     // ---------------------
     // Application Handlers
     // ---------------------
     auto registerHandler = std::make_shared<application::RegisterUserHandler>(
         passwordHasher,
-        userRepo
+        userRepo,
+        usernameFilter
     );
 
     auto loginHandler = std::make_shared<application::LoginUserHandler>(
@@ -46,7 +343,31 @@ AppContext initialize_app(const std::string& dbConnStr,
 
     auto sendHandler = std::make_shared<application::SendMessageHandler>(
         messageEncryptor,
-        messageRepo
+        messageRepo,
+        notifier,
+        conversationCache,
+        idempotency,
+        messageIds
+    );
+
+    auto sendGroupHandler = std::make_shared<application::SendGroupMessageHandler>(
+        messageEncryptor,
+        messageRepo,
+        groupRepo,
+        notifier,
+        conversationCache,
+        messageIds
+    );
+
+    auto historyHandler = std::make_shared<application::GetMessageHistoryHandler>(
+        messageEncryptor,
+        messageRepo,
+        groupRepo,
+        conversationCache
+    );
+
+    auto createGroupHandler = std::make_shared<application::CreateGroupHandler>(
+        groupRepo
     );
 
     // ---------------------
@@ -54,6 +375,14 @@ AppContext initialize_app(const std::string& dbConnStr,
     // ---------------------
     auto router = std::make_shared<infrastructure::http::HttpRouter>();
 
+    // ---------------------
+    // Admission: адаптивные лимиты одновременных запросов по классам маршрутов
+    // ---------------------
+    std::shared_ptr<infrastructure::concurrency::AdmissionControl> admissionControl;
+    if (admission.enabled) {
+        admissionControl = std::make_shared<infrastructure::concurrency::AdmissionControl>(admission);
+    }
+
     // ---------------------
     // HTTP Resources (создаём как shared_ptr и сохраняем в контексте)
     // ---------------------
@@ -62,12 +391,41 @@ AppContext initialize_app(const std::string& dbConnStr,
     );
 
     auto messageResource = std::make_shared<infrastructure::http::resources::MessageResource>(
-        sendHandler
+        sendHandler,
+        historyHandler
+    );
+
+    auto adminResource = std::make_shared<infrastructure::http::resources::AdminResource>(
+        connections,
+        longPoll,
+        conversationCache,
+        userCache,
+        usernameFilter,
+        idempotency,
+        outbox,
+        partitions,
+        sharded,
+        shardPools,
+        shardPartitions,
+        replicas,
+        admissionControl
+    );
+
+    auto groupResource = std::make_shared<infrastructure::http::resources::GroupResource>(
+        createGroupHandler,
+        sendGroupHandler
+    );
+
+    auto longPollResource = std::make_shared<infrastructure::http::resources::LongPollResource>(
+        longPoll
     );
 
     // Регистрируем маршруты
     userResource->register_routes(*router);
     messageResource->register_routes(*router);
+    adminResource->register_routes(*router);
+    groupResource->register_routes(*router);
+    longPollResource->register_routes(*router);
 
     // ---------------------
     // HTTP Server
@@ -75,7 +433,10 @@ AppContext initialize_app(const std::string& dbConnStr,
     auto server = std::make_shared<infrastructure::http::HttpServer>(
         address,
         port,
-        router
+        router,
+        connections,
+        http,
+        admissionControl
     );
 
     // ---------------------
@@ -85,27 +446,92 @@ AppContext initialize_app(const std::string& dbConnStr,
     ctx.registerHandler    = registerHandler;
     ctx.loginHandler       = loginHandler;
     ctx.sendMessageHandler = sendHandler;
+    ctx.messageHistoryHandler = historyHandler;
+    ctx.createGroupHandler = createGroupHandler;
+    ctx.sendGroupMessageHandler = sendGroupHandler;
+    ctx.connections        = connections;
+    ctx.longPoll           = longPoll;
+    ctx.conversationCache  = conversationCache;
+    ctx.userCache          = userCache;
+    ctx.usernameFilter     = usernameFilter;
+    ctx.idempotency        = idempotency;
+    ctx.messageIds         = messageIds;
+    ctx.outbox             = outbox;
+    ctx.partitions         = partitions;
+    ctx.sharded            = sharded;
+    ctx.shardPools         = shardPools;
+    ctx.shardPartitions    = shardPartitions;
+    ctx.replicas           = replicas;
+    ctx.clockTicker        = clockTicker;
+    ctx.admission          = admissionControl;
     ctx.router             = router;
     ctx.server             = server;
 
     // Сохраняем ресурсы в контексте, чтобы их lifetime покрывал работу сервера
     ctx.userResource    = userResource;
     ctx.messageResource = messageResource;
+    ctx.adminResource   = adminResource;
+    ctx.groupResource   = groupResource;
+    ctx.longPollResource = longPollResource;
 
     // Для совместимости/удобства можно также хранить их в контейнере void-указателей
     ctx.resources.emplace_back(std::static_pointer_cast<void>(userResource));
     ctx.resources.emplace_back(std::static_pointer_cast<void>(messageResource));
+    ctx.resources.emplace_back(std::static_pointer_cast<void>(adminResource));
+    ctx.resources.emplace_back(std::static_pointer_cast<void>(groupResource));
+    ctx.resources.emplace_back(std::static_pointer_cast<void>(longPollResource));
 
     return ctx;
 }
 
+void shutdown_app(AppContext& ctx, std::chrono::milliseconds timeout)
+{
+    // Новых запросов нет: все записи, которые ещё надо сделать, уже в outbox.
+    if (ctx.server) {
+        ctx.server->stop();
+    }
+    if (ctx.outbox) {
+        const auto pending = ctx.outbox->stats().pending;
+        if (!ctx.outbox->flush(timeout)) {
+            std::cerr << "[WARN] Outbox not drained in " << timeout.count() << " ms: "
+                      << ctx.outbox->stats().pending << " messages will be replayed on next start" << std::endl;
+        } else if (pending != 0) {
+            std::cerr << "[INFO] Outbox drained: " << pending << " messages" << std::endl;
+        }
+    }
+    if (ctx.partitions) {
+        ctx.partitions->stop();
+    }
+    for (const auto& maintainer : ctx.shardPartitions) {
+        maintainer->stop();
+    }
+    // Соединения закрываются штатно (Terminate), а не обрывом при выходе процесса.
+    if (ctx.replicas) {
+        ctx.replicas->stop();
+        ctx.replicas->close_idle();
+    }
+    for (const auto& pool : ctx.shardPools) {
+        pool->close_idle();
+    }
+    if (ctx.clockTicker) {
+        ctx.clockTicker->stop();
+    }
+    std::cerr << "[INFO] Shutdown complete" << std::endl;
+    std::cout.flush();
+    std::clog.flush();
+}
+
 void run_app(const std::string& dbConnStr,
              const std::string& secret,
              const std::string& address,
-             int port)
+             int port,
+             const StorageOptions& storage,
+             const infrastructure::http::HttpServerOptions& http,
+             const infrastructure::concurrency::AdmissionOptions& admission)
 {
-    auto ctx = initialize_app(dbConnStr, secret, address, port);
+    auto ctx = initialize_app(dbConnStr, secret, address, port, storage, http, admission);
     ctx.server->run();
+    shutdown_app(ctx, http.drainTimeout);
 }
 
 } // namespace chatserver::bootstrap
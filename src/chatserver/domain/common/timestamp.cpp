@@ -2,44 +2,105 @@
 // Подключаем заголовочный файл, где объявлен класс Timestamp.
 // Это позволяет использовать его методы и определять их реализацию.
 
+#include <atomic>
+#include <ctime>
+// clock_gettime(CLOCK_REALTIME_COARSE) для грубого источника времени.
+
 namespace chatserver::domain {
 // Открываем пространство имен domain внутри chatserver,
 // чтобы реализация соответствовала объяалению в .h файле.
 
+namespace {
+
+constexpr std::int64_t kMicrosPerSecond = 1'000'000;
+
+std::atomic<TimestampClock> gClock{TimestampClock::Precise};
+// Источник времени для now(); меняется при старте и остановке тикера.
+std::atomic<std::int64_t> gCached{0};
+// Последнее опубликованное тикером время в микросекундах; 0 — тикер ещё не работал.
+
+std::int64_t precise_micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        Timestamp::clock::now().time_since_epoch()
+    ).count();
+}
+
+std::int64_t coarse_micros() {
+#ifdef CLOCK_REALTIME_COARSE
+    timespec ts{};
+    if (::clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0) {
+        return static_cast<std::int64_t>(ts.tv_sec) * kMicrosPerSecond + ts.tv_nsec / 1000;
+    }
+#endif
+    return precise_micros();
+}
+
+}
+
 Timestamp Timestamp::now() {
     // Реализация статического метода, создающего Timestamp с текущим временем.
-    auto now = clock::now();
-    // Получаем текущее время из system_clock (псевдоним clock).
-    // now - это std::chrono::time_point.
-    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
-        now.time_since_epoch()
-    ).count();
-    // Преобразуем время с начала эпохи (time_since_epoch) в секунды.
-    // duration_cast гарантирует точное преобразование к секундам.
-    // count() возвращает целочисленное значение.
-    return Timestamp(seconds);
-    // Создаем и возвращаем новый Timestamp, используя количество секунд.
+    switch (gClock.load(std::memory_order_relaxed)) {
+    case TimestampClock::Coarse:
+        return Timestamp(Micros{}, coarse_micros());
+    case TimestampClock::Cached:
+        if (const auto cached = gCached.load(std::memory_order_relaxed); cached != 0) {
+            return Timestamp(Micros{}, cached);
+        }
+        break;
+        // Тикер ещё не опубликовал время — берём точное.
+    case TimestampClock::Precise:
+        break;
+    }
+    return Timestamp(Micros{}, precise_micros());
+}
+
+Timestamp Timestamp::precise_now() {
+    return Timestamp(Micros{}, precise_micros());
+}
+
+void Timestamp::use_clock(TimestampClock source) {
+    gClock.store(source, std::memory_order_relaxed);
+}
+
+TimestampClock Timestamp::current_clock() {
+    return gClock.load(std::memory_order_relaxed);
+}
+
+void Timestamp::publish_cached(Timestamp value) {
+    gCached.store(value.epochMicros_, std::memory_order_relaxed);
 }
 
 Timestamp::Timestamp(std::int64_t epochSeconds)
-    : epochSeconds_(epochSeconds) {}
-// Конструктор, инициализирующий внутреннее поле epochSeconds_.
-// Используем список инициализации для эффективности.
+    : epochMicros_(epochSeconds * kMicrosPerSecond) {}
+// Конструктор из секунд: хранится то же время в микросекундах.
+
+Timestamp::Timestamp(Micros, std::int64_t epochMicros)
+    : epochMicros_(epochMicros) {}
+
+Timestamp Timestamp::from_micros(std::int64_t epochMicros) {
+    return Timestamp(Micros{}, epochMicros);
+}
 
 std::int64_t Timestamp::epoch_seconds() const {
-    return epochSeconds_;
+    // Деление с округлением вниз: -1 мкс — это секунда -1, а не 0.
+    const auto seconds = epochMicros_ / kMicrosPerSecond;
+    return (epochMicros_ % kMicrosPerSecond < 0) ? seconds - 1 : seconds;
 }
-// Геттер, возвращающий количество секунд от эпохи.
+// Геттер, возвращающий количество целых секунд от эпохи.
 // const гарантирует, что метод не изменяет объект.
 
+std::int64_t Timestamp::epoch_micros() const {
+    return epochMicros_;
+}
+
 bool Timestamp::operator==(const Timestamp& other) const {
-    return epochSeconds_ == other.epochSeconds_;
+    return epochMicros_ == other.epochMicros_;
 }
 // Оператор сравнеия на равенство.
-// Два Timestamp равны, если их значения секунд совпадают.
+// Два Timestamp равны, если совпадают их значения в микросекундах.
 
 bool Timestamp::operator<(const Timestamp& other) const {
-    return epochSeconds_ < other.epochSeconds_;
+    return epochMicros_ < other.epochMicros_;
 }
 // Оператор "меньше", позволяющий сортировать Timestamp,
 // использовать в std::map, std::set и других структурах.
@@ -0,0 +1,18 @@
+#include "chatserver/domain/group/group_id.h"
+
+namespace chatserver::domain {
+// Пространство имен domain - слой предметной области (DDD).
+
+GroupId::GroupId(std::int64_t value)
+    : value_(value) {}
+// Конструктор сохраняет идентификатор группы во внутреннем поле.
+
+std::int64_t GroupId::value() const {
+    return value_;
+}
+
+bool GroupId::operator==(const GroupId& other) const {
+    return value_ == other.value_;
+}
+// Две группы равны, если равны их числовые идентификаторы.
+}
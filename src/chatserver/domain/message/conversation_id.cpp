@@ -0,0 +1,58 @@
+#include "chatserver/domain/message/conversation_id.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace chatserver::domain {
+
+namespace {
+
+constexpr std::int64_t kMaxUserId = (std::int64_t{1} << 32) - 1;
+
+}
+
+ConversationId ConversationId::between(const UserId& a, const UserId& b) {
+    auto lo = std::min(a.value(), b.value());
+    auto hi = std::max(a.value(), b.value());
+    if (lo < 1 || hi > kMaxUserId) {
+        throw std::invalid_argument("user id out of range for a conversation key");
+    }
+    return ConversationId(static_cast<std::int64_t>(
+        (static_cast<std::uint64_t>(lo) << 32) | static_cast<std::uint64_t>(hi)));
+}
+// Нормализуем порядок участников и упаковываем пару в 64 бита.
+// Для id из SERIAL (< 2^31) ключ положительный; при больших id он остаётся
+// уникальным, но становится отрицательным int64.
+
+ConversationId ConversationId::group(const GroupId& group) {
+    if (group.value() < 1 || group.value() > kMaxUserId) {
+        throw std::invalid_argument("group id out of range for a conversation key");
+    }
+    return ConversationId(group.value());
+}
+// Старшая половина нулевая — такой ключ не может получиться из пары пользователей.
+
+ConversationId::ConversationId(std::int64_t value)
+    : value_(value) {}
+
+std::int64_t ConversationId::value() const {
+    return value_;
+}
+
+bool ConversationId::is_group() const {
+    return (static_cast<std::uint64_t>(value_) >> 32) == 0;
+}
+
+UserId ConversationId::low() const {
+    return UserId(static_cast<std::int64_t>(static_cast<std::uint64_t>(value_) >> 32));
+}
+
+UserId ConversationId::high() const {
+    return UserId(static_cast<std::int64_t>(static_cast<std::uint64_t>(value_) & 0xFFFFFFFFu));
+}
+
+bool ConversationId::operator==(const ConversationId& other) const {
+    return value_ == other.value_;
+}
+
+}
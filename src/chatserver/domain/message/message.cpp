@@ -7,30 +7,65 @@ namespace chatserver::domain::message {
 Message::Message(
     MessageId id,
     UserId senderId,
+    UserId receiverId,
     MessageText text,
     Timestamp createdAt
 )
     : id_(id)
     , senderId_(senderId)
+    , receiverId_(receiverId)
     , text_(std::move(text))
     , createdAt_(createdAt) {}
 // Основной конструктор сущности Message.
 // Все параметры передаются по значению, затем:
-//   • id_ и senderId_ копируются (оба лёгкие Value Object'ы)
+//   • id_, senderId_ и receiverId_ копируются (лёгкие Value Object'ы)
 //   • text_ перемещается (строка внутри может быть большой)
 //   • createdAt_ копируется (int64_t внутри, копирование дешёвое)
 // Такой подход упрощает вызов конструктора и использует move semantics там,
 // где это даёт реальную выгоду.
 Message::Message(
     UserId senderId,
+    UserId receiverId,
     MessageText text,
     Timestamp createdAt
 )
     : id_(0)
     , senderId_(senderId)
+    , receiverId_(receiverId)
     , text_(std::move(text))
     , createdAt_(createdAt) {}
 
+Message::Message(
+    MessageId id,
+    UserId senderId,
+    GroupId groupId,
+    MessageText text,
+    Timestamp createdAt
+)
+    : id_(id)
+    , senderId_(senderId)
+    , receiverId_(0)
+    , groupId_(groupId.value())
+    , text_(std::move(text))
+    , createdAt_(createdAt) {}
+// Групповое сообщение: получателей много, поэтому receiverId_ = 0,
+// а адресат — группа.
+
+Message::Message(
+    UserId senderId,
+    GroupId groupId,
+    MessageText text,
+    Timestamp createdAt
+)
+    : Message(MessageId(0), senderId, groupId, std::move(text), createdAt) {}
+
+Message Message::with_id(MessageId id) const {
+    Message copy = *this;
+    copy.id_ = id;
+    return copy;
+}
+// Копия с id, выданным хранилищем: групповая принадлежность сохраняется.
+
 // Message::Message(
 //     UserId senderId,
 //     MessageText text,
@@ -53,6 +88,27 @@ const UserId& Message::sender_id() const {
 }
 // Геттер, возвращающий идентификатор отправителя сообщения.
 
+const UserId& Message::receiver_id() const {
+    return receiverId_;
+}
+// Геттер, возвращающий идентификатор получателя сообщения.
+
+std::optional<GroupId> Message::group_id() const {
+    if (groupId_ == 0) {
+        return std::nullopt;
+    }
+    return GroupId(groupId_);
+}
+
+ConversationId Message::conversation_id() const {
+    if (groupId_ != 0) {
+        return ConversationId::group(GroupId(groupId_));
+    }
+    return ConversationId::between(senderId_, receiverId_);
+}
+// Ключ переписки вычисляется из участников, а не хранится отдельно:
+// так он не может разойтись с sender/receiver.
+
 const MessageText& Message::text() const {
     return text_;
 }
@@ -0,0 +1,85 @@
+#include "chatserver/domain/message/message_id_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace chatserver::domain {
+
+MessageIdGenerator::MessageIdGenerator(std::int64_t node, std::function<std::int64_t()> unixMsClock)
+    : node_(node)
+    , clock_(std::move(unixMsClock))
+{
+    if (node < 0 || node > kMaxNode) {
+        throw std::invalid_argument("message id node must be in 0.." + std::to_string(kMaxNode) +
+                                    ", got " + std::to_string(node));
+    }
+}
+
+std::int64_t MessageIdGenerator::now_ms() const {
+    if (clock_) {
+        return clock_();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+MessageId MessageIdGenerator::next() {
+    // Часы до эпохи генератора (неверно выставленное время) считаем её началом.
+    const auto sinceEpoch = std::max<std::int64_t>(0, now_ms() - kEpochMs);
+    const auto floor = static_cast<std::uint64_t>(sinceEpoch) << kSequenceBits;
+
+    std::uint64_t current = state_.load(std::memory_order_relaxed);
+    std::uint64_t next;
+    do {
+        next = std::max(current + 1, floor);
+    } while (!state_.compare_exchange_weak(current, next, std::memory_order_relaxed));
+
+    const std::uint64_t ms = next >> kSequenceBits;
+    const std::uint64_t sequence = next & ((std::uint64_t{1} << kSequenceBits) - 1);
+    return MessageId(static_cast<std::int64_t>(
+        (ms << (kNodeBits + kSequenceBits)) |
+        (static_cast<std::uint64_t>(node_) << kSequenceBits) |
+        sequence));
+}
+
+void MessageIdGenerator::advance_past(MessageId issued) {
+    // Состояние — это id без поля узла: мс и последовательность.
+    const auto raw = static_cast<std::uint64_t>(issued.value());
+    const auto floor = ((raw >> (kNodeBits + kSequenceBits)) << kSequenceBits) |
+                       (raw & ((std::uint64_t{1} << kSequenceBits) - 1));
+    std::uint64_t current = state_.load(std::memory_order_relaxed);
+    while (current < floor &&
+           !state_.compare_exchange_weak(current, floor, std::memory_order_relaxed)) {
+    }
+}
+
+MessageId MessageIdGenerator::compose(std::int64_t unixMs, std::int64_t node, std::int64_t sequence) {
+    if (unixMs < kEpochMs) {
+        throw std::invalid_argument("time " + std::to_string(unixMs) +
+                                    " ms predates the message id epoch (2024-01-01)");
+    }
+    if (node < 0 || node > kMaxNode) {
+        throw std::invalid_argument("message id node must be in 0.." + std::to_string(kMaxNode) +
+                                    ", got " + std::to_string(node));
+    }
+    const auto ms = static_cast<std::uint64_t>(unixMs - kEpochMs);
+    if (ms >> (63 - kNodeBits - kSequenceBits)) {
+        throw std::invalid_argument("time " + std::to_string(unixMs) + " ms is beyond the message id range");
+    }
+    const auto seq = static_cast<std::uint64_t>(sequence) & ((std::uint64_t{1} << kSequenceBits) - 1);
+    return MessageId(static_cast<std::int64_t>(
+        (ms << (kNodeBits + kSequenceBits)) | (static_cast<std::uint64_t>(node) << kSequenceBits) | seq));
+}
+
+MessageIdGenerator::Parts MessageIdGenerator::decode(MessageId id) {
+    const auto raw = static_cast<std::uint64_t>(id.value());
+    Parts parts;
+    parts.unixMs = static_cast<std::int64_t>(raw >> (kNodeBits + kSequenceBits)) + kEpochMs;
+    parts.node = static_cast<std::int64_t>((raw >> kSequenceBits) & static_cast<std::uint64_t>(kMaxNode));
+    parts.sequence = static_cast<std::int64_t>(raw & ((std::uint64_t{1} << kSequenceBits) - 1));
+    return parts;
+}
+
+}
@@ -1,4 +1,23 @@
 #include "chatserver/domain/services/message_encryptor.h"
 
-// интерфейс — реализации нет
+namespace chatserver::domain::services {
 
+std::vector<std::string> MessageEncryptor::encrypt_batch(const std::vector<std::string>& plainTexts) const {
+    std::vector<std::string> out;
+    out.reserve(plainTexts.size());
+    for (const auto& plainText : plainTexts) {
+        out.push_back(encrypt(plainText));
+    }
+    return out;
+}
+
+std::vector<std::string> MessageEncryptor::decrypt_batch(const std::vector<std::string>& cipherTexts) const {
+    std::vector<std::string> out;
+    out.reserve(cipherTexts.size());
+    for (const auto& cipherText : cipherTexts) {
+        out.push_back(decrypt(cipherText));
+    }
+    return out;
+}
+
+}
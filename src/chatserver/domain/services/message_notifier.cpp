@@ -0,0 +1,3 @@
+#include "chatserver/domain/services/message_notifier.h"
+
+// интерфейс — реализации нет
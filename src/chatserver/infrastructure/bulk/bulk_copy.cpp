@@ -0,0 +1,181 @@
+#include "chatserver/infrastructure/bulk/bulk_copy.h"
+
+#include "chatserver/domain/message/conversation_id.h"
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/domain/services/message_encryptor.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::bulk {
+
+namespace {
+
+[[noreturn]] void rethrow_with_line(std::size_t line, const std::exception& ex) {
+    throw std::invalid_argument("line " + std::to_string(line) + ": " + ex.what());
+}
+
+std::int64_t conversation_of(const BulkMessageRow& row) {
+    if (row.groupId) {
+        return domain::ConversationId::group(domain::GroupId(*row.groupId)).value();
+    }
+    return domain::ConversationId::between(domain::UserId(row.senderId), domain::UserId(*row.receiverId)).value();
+}
+
+std::int64_t required_int(const std::optional<std::string_view>& field, const char* name) {
+    if (!field) throw std::runtime_error(std::string("COPY row has NULL ") + name);
+    return pgcopy::read_int8(*field);
+}
+
+std::optional<std::int64_t> optional_int(const std::optional<std::string_view>& field) {
+    return field ? std::optional<std::int64_t>(pgcopy::read_int8(*field)) : std::nullopt;
+}
+
+}
+
+void reserve_message_ids(BulkChunk& chunk, domain::MessageIdGenerator& ids)
+{
+    // По id на запись, даже если у неё свой: какие записи без id, видно только после
+    // разбора, а разбор — в параллельной стадии. Лишние id — лишь пропуски в нумерации.
+    chunk.ids.resize(chunk.records.size());
+    for (auto& id : chunk.ids) {
+        id = ids.next().value();
+    }
+    chunk.idNode = ids.node();
+}
+
+std::string encode_messages(const BulkChunk& chunk,
+                            const BulkRowParser& parser,
+                            const domain::services::MessageEncryptor& encryptor,
+                            std::int64_t nowUs)
+{
+    std::vector<BulkMessageRow> rows;
+    rows.reserve(chunk.records.size());
+    std::vector<std::string> texts;
+    texts.reserve(chunk.records.size());
+    for (std::size_t i = 0; i < chunk.records.size(); ++i) {
+        try {
+            rows.push_back(parser.message(chunk.records[i]));
+        } catch (const std::exception& ex) {
+            rethrow_with_line(chunk.lines[i], ex);
+        }
+        auto& row = rows.back();
+        if (row.id == 0) {
+            if (chunk.ids.empty()) {
+                throw std::invalid_argument("line " + std::to_string(chunk.lines[i]) +
+                                            ": id is missing and no --id-node was given");
+            }
+            if (!row.createdAtUs) {
+                row.id = chunk.ids[i];
+            } else {
+                // Время id — created_at, а не момент импорта: иначе id DESC поставит
+                // перенесённую историю выше свежих сообщений, а отсечение по времени
+                // (history_time_bounds) спрячет её.
+                try {
+                    row.id = domain::MessageIdGenerator::compose(
+                        *row.createdAtUs / 1000, chunk.idNode,
+                        static_cast<std::int64_t>(chunk.lines[i])).value();
+                } catch (const std::exception& ex) {
+                    rethrow_with_line(chunk.lines[i], ex);
+                }
+            }
+        }
+        texts.push_back(std::move(row.text));
+    }
+
+    const auto ciphertexts = encryptor.encrypt_batch(texts);
+
+    std::string out;
+    out.reserve(rows.size() * (64 + (texts.empty() ? 0 : ciphertexts.front().size())));
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const auto& row = rows[i];
+        pgcopy::begin_tuple(out, 7);
+        pgcopy::append_int8(out, row.id);
+        pgcopy::append_int8(out, row.senderId);
+        if (row.receiverId) pgcopy::append_int8(out, *row.receiverId); else pgcopy::append_null(out);
+        if (row.groupId) pgcopy::append_int8(out, *row.groupId); else pgcopy::append_null(out);
+        pgcopy::append_int8(out, conversation_of(row));
+        pgcopy::append_text(out, ciphertexts[i]);
+        pgcopy::append_timestamp(out, row.createdAtUs.value_or(nowUs));
+    }
+    return out;
+}
+
+std::string encode_users(const BulkChunk& chunk, const BulkRowParser& parser, std::int64_t nowUs) {
+    std::string out;
+    for (std::size_t i = 0; i < chunk.records.size(); ++i) {
+        BulkUserRow row;
+        try {
+            row = parser.user(chunk.records[i]);
+            if (row.id > std::numeric_limits<std::int32_t>::max()) {
+                throw std::invalid_argument("id does not fit users.id (int4)");
+            }
+        } catch (const std::exception& ex) {
+            rethrow_with_line(chunk.lines[i], ex);
+        }
+        pgcopy::begin_tuple(out, 4);
+        pgcopy::append_int4(out, static_cast<std::int32_t>(row.id));
+        pgcopy::append_text(out, row.username);
+        pgcopy::append_text(out, row.passwordHash);
+        pgcopy::append_timestamp(out, row.createdAtUs.value_or(nowUs));
+    }
+    return out;
+}
+
+BulkMessageRow message_from_copy(const PgCopyBinaryReader::Tuple& tuple) {
+    if (tuple.size() != 6) {
+        throw std::runtime_error("COPY row has " + std::to_string(tuple.size()) + " fields, expected 6");
+    }
+    BulkMessageRow row;
+    row.id = required_int(tuple[0], "id");
+    row.senderId = required_int(tuple[1], "sender_id");
+    row.receiverId = optional_int(tuple[2]);
+    row.groupId = optional_int(tuple[3]);
+    if (tuple[4]) row.text.assign(tuple[4]->data(), tuple[4]->size());
+    if (tuple[5]) row.createdAtUs = pgcopy::read_timestamp(*tuple[5]);
+    return row;
+}
+
+BulkUserRow user_from_copy(const PgCopyBinaryReader::Tuple& tuple) {
+    if (tuple.size() != 4) {
+        throw std::runtime_error("COPY row has " + std::to_string(tuple.size()) + " fields, expected 4");
+    }
+    BulkUserRow row;
+    row.id = required_int(tuple[0], "id");
+    if (tuple[1]) row.username.assign(tuple[1]->data(), tuple[1]->size());
+    if (tuple[2]) row.passwordHash.assign(tuple[2]->data(), tuple[2]->size());
+    if (tuple[3]) row.createdAtUs = pgcopy::read_timestamp(*tuple[3]);
+    return row;
+}
+
+std::string format_messages(std::vector<BulkMessageRow>& rows,
+                            const domain::services::MessageEncryptor& encryptor,
+                            BulkFormat format)
+{
+    std::vector<std::string> ciphertexts;
+    ciphertexts.reserve(rows.size());
+    for (auto& row : rows) ciphertexts.push_back(std::move(row.text));
+    auto plain = encryptor.decrypt_batch(ciphertexts);
+
+    std::string out;
+    out.reserve(rows.size() * 128);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        // decrypt() сообщает о неверном теге пустой строкой, а пустых сообщений не бывает.
+        if (plain[i].empty()) {
+            throw std::runtime_error("cannot decrypt message " + std::to_string(rows[i].id) +
+                                     " (wrong secret or corrupted text)");
+        }
+        rows[i].text = std::move(plain[i]);
+        append_row(out, rows[i], format);
+    }
+    return out;
+}
+
+std::string format_users(const std::vector<BulkUserRow>& rows, BulkFormat format) {
+    std::string out;
+    out.reserve(rows.size() * 128);
+    for (const auto& row : rows) append_row(out, row, format);
+    return out;
+}
+
+}
@@ -0,0 +1,345 @@
+#include "chatserver/infrastructure/bulk/bulk_rows.h"
+
+#include "chatserver/domain/message/conversation_id.h"
+#include "chatserver/domain/message/message_text.h"
+#include "chatserver/domain/user/username.h"
+#include "chatserver/nlohmann/json.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::bulk {
+
+namespace {
+
+using json = nlohmann::json;
+
+std::vector<std::string> split_csv(std::string_view record) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (std::size_t i = 0; i < record.size(); ++i) {
+        const char c = record[i];
+        if (quoted) {
+            if (c != '"') {
+                field += c;
+            } else if (i + 1 < record.size() && record[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(std::move(field));
+    return fields;
+}
+
+std::int64_t parse_int(std::string_view s, const char* name) {
+    std::int64_t value = 0;
+    const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc() || end != s.data() + s.size()) {
+        throw std::invalid_argument(std::string("field ") + name + " is not an integer");
+    }
+    return value;
+}
+
+double parse_double(std::string_view s, const char* name) {
+    double value = 0;
+    const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc() || end != s.data() + s.size()) {
+        throw std::invalid_argument(std::string("field ") + name + " is not a number");
+    }
+    return value;
+}
+
+class Fields {
+// Одинаковый доступ к полям записи NDJSON и CSV.
+public:
+    Fields(BulkFormat format, const std::vector<std::string>& header, std::string_view record)
+        : header_(header)
+    {
+        if (format == BulkFormat::Ndjson) {
+            try {
+                json_ = json::parse(record);
+            } catch (const json::exception& ex) {
+                throw std::invalid_argument(std::string("invalid JSON: ") + ex.what());
+            }
+            if (!json_.is_object()) {
+                throw std::invalid_argument("record is not a JSON object");
+            }
+            csv_ = false;
+        } else {
+            values_ = split_csv(record);
+            if (values_.size() != header_.size()) {
+                throw std::invalid_argument("expected " + std::to_string(header_.size()) + " CSV fields, got " +
+                                            std::to_string(values_.size()));
+            }
+        }
+    }
+
+    std::optional<std::string> text(const char* name) const {
+        if (csv_) {
+            const auto* v = csv_value(name);
+            return v ? std::optional<std::string>(*v) : std::nullopt;
+        }
+        const auto it = json_.find(name);
+        if (it == json_.end() || it->is_null()) return std::nullopt;
+        if (!it->is_string()) throw std::invalid_argument(std::string("field ") + name + " must be a string");
+        return it->get<std::string>();
+    }
+
+    std::optional<std::int64_t> int64(const char* name) const {
+        if (csv_) {
+            const auto* v = csv_value(name);
+            if (!v || v->empty()) return std::nullopt;
+            return parse_int(*v, name);
+        }
+        const auto it = json_.find(name);
+        if (it == json_.end() || it->is_null()) return std::nullopt;
+        if (it->is_number_integer()) return it->get<std::int64_t>();
+        if (it->is_string()) return parse_int(it->get_ref<const std::string&>(), name);
+        throw std::invalid_argument(std::string("field ") + name + " must be an integer");
+    }
+
+    std::optional<double> number(const char* name) const {
+        if (csv_) {
+            const auto* v = csv_value(name);
+            if (!v || v->empty()) return std::nullopt;
+            return parse_double(*v, name);
+        }
+        const auto it = json_.find(name);
+        if (it == json_.end() || it->is_null()) return std::nullopt;
+        if (!it->is_number()) throw std::invalid_argument(std::string("field ") + name + " must be a number");
+        return it->get<double>();
+    }
+
+    std::optional<std::int64_t> created_at_us() const {
+        if (auto us = int64("created_at_us")) return us;
+        if (auto seconds = number("created_at")) return static_cast<std::int64_t>(std::llround(*seconds * 1e6));
+        return std::nullopt;
+    }
+
+private:
+    const std::string* csv_value(const char* name) const {
+        for (std::size_t i = 0; i < header_.size(); ++i) {
+            if (header_[i] == name) return &values_[i];
+        }
+        return nullptr;
+    }
+
+    const std::vector<std::string>& header_;
+    bool csv_ = true;
+    json json_;
+    std::vector<std::string> values_;
+};
+
+void append_json_string(std::string& out, std::string_view s) {
+    out += '"';
+    for (const char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                static constexpr char kHex[] = "0123456789abcdef";
+                out += "\\u00";
+                out += kHex[(c >> 4) & 0xf];
+                out += kHex[c & 0xf];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void append_csv_string(std::string& out, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(s);
+        return;
+    }
+    out += '"';
+    for (const char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+void append_int(std::string& out, std::int64_t v) {
+    char buf[24];
+    const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, end);
+}
+
+}
+
+BulkFormat parse_bulk_format(const std::string& name) {
+    if (name == "ndjson") return BulkFormat::Ndjson;
+    if (name == "csv") return BulkFormat::Csv;
+    throw std::invalid_argument("format must be ndjson or csv, got '" + name + "'");
+}
+
+BulkRecordReader::BulkRecordReader(std::istream& in, BulkFormat format)
+    : in_(in)
+    , format_(format)
+{
+    if (format_ == BulkFormat::Csv) {
+        std::string header;
+        if (!next(header)) {
+            throw std::invalid_argument("CSV input has no header line");
+        }
+        header_ = split_csv(header);
+    }
+}
+
+bool BulkRecordReader::next(std::string& record) {
+    std::string line;
+    while (std::getline(in_, line)) {
+        ++lineNo_;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        recordLine_ = lineNo_;
+        record = std::move(line);
+        if (format_ == BulkFormat::Ndjson) return true;
+
+        // Нечётное число кавычек — запись продолжается на следующей строке.
+        auto quotes = std::count(record.begin(), record.end(), '"');
+        while (quotes % 2 != 0) {
+            if (!std::getline(in_, line)) {
+                throw std::invalid_argument("line " + std::to_string(recordLine_) + ": unterminated CSV quote");
+            }
+            ++lineNo_;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            record += '\n';
+            record += line;
+            quotes += std::count(line.begin(), line.end(), '"');
+        }
+        return true;
+    }
+    return false;
+}
+
+BulkRowParser::BulkRowParser(BulkFormat format, std::vector<std::string> csvHeader)
+    : format_(format)
+    , header_(std::move(csvHeader))
+{
+}
+
+BulkMessageRow BulkRowParser::message(std::string_view record) const {
+    const Fields f(format_, header_, record);
+    BulkMessageRow row;
+    row.id = f.int64("id").value_or(0);
+    const auto sender = f.int64("sender_id");
+    if (!sender) throw std::invalid_argument("sender_id is required");
+    row.senderId = *sender;
+    row.receiverId = f.int64("receiver_id");
+    row.groupId = f.int64("group_id");
+    if (row.receiverId.has_value() == row.groupId.has_value()) {
+        throw std::invalid_argument("exactly one of receiver_id and group_id is required");
+    }
+    // Проверка диапазонов id — той же логикой, что ключ переписки при отправке.
+    if (row.groupId) {
+        domain::ConversationId::group(domain::GroupId(*row.groupId));
+    } else {
+        domain::ConversationId::between(domain::UserId(row.senderId), domain::UserId(*row.receiverId));
+    }
+    auto text = f.text("text");
+    if (!text) throw std::invalid_argument("text is required");
+    row.text = domain::MessageText(std::move(*text)).value();
+    row.createdAtUs = f.created_at_us();
+    return row;
+}
+
+BulkUserRow BulkRowParser::user(std::string_view record) const {
+    const Fields f(format_, header_, record);
+    BulkUserRow row;
+    const auto id = f.int64("id");
+    if (!id || *id <= 0) throw std::invalid_argument("positive id is required");
+    row.id = *id;
+    auto username = f.text("username");
+    if (!username) throw std::invalid_argument("username is required");
+    row.username = domain::Username(std::move(*username)).value();
+    auto hash = f.text("password_hash");
+    if (!hash || hash->empty()) throw std::invalid_argument("password_hash is required");
+    row.passwordHash = std::move(*hash);
+    row.createdAtUs = f.created_at_us();
+    return row;
+}
+
+void append_row(std::string& out, const BulkMessageRow& row, BulkFormat format) {
+    if (format == BulkFormat::Csv) {
+        append_int(out, row.id);
+        out += ',';
+        append_int(out, row.senderId);
+        out += ',';
+        if (row.receiverId) append_int(out, *row.receiverId);
+        out += ',';
+        if (row.groupId) append_int(out, *row.groupId);
+        out += ',';
+        append_csv_string(out, row.text);
+        out += ',';
+        if (row.createdAtUs) append_int(out, *row.createdAtUs);
+        out += '\n';
+        return;
+    }
+    out += "{\"id\":";
+    append_int(out, row.id);
+    out += ",\"sender_id\":";
+    append_int(out, row.senderId);
+    if (row.receiverId) {
+        out += ",\"receiver_id\":";
+        append_int(out, *row.receiverId);
+    }
+    if (row.groupId) {
+        out += ",\"group_id\":";
+        append_int(out, *row.groupId);
+    }
+    out += ",\"text\":";
+    append_json_string(out, row.text);
+    if (row.createdAtUs) {
+        out += ",\"created_at_us\":";
+        append_int(out, *row.createdAtUs);
+    }
+    out += "}\n";
+}
+
+void append_row(std::string& out, const BulkUserRow& row, BulkFormat format) {
+    if (format == BulkFormat::Csv) {
+        append_int(out, row.id);
+        out += ',';
+        append_csv_string(out, row.username);
+        out += ',';
+        append_csv_string(out, row.passwordHash);
+        out += ',';
+        if (row.createdAtUs) append_int(out, *row.createdAtUs);
+        out += '\n';
+        return;
+    }
+    out += "{\"id\":";
+    append_int(out, row.id);
+    out += ",\"username\":";
+    append_json_string(out, row.username);
+    out += ",\"password_hash\":";
+    append_json_string(out, row.passwordHash);
+    if (row.createdAtUs) {
+        out += ",\"created_at_us\":";
+        append_int(out, *row.createdAtUs);
+    }
+    out += "}\n";
+}
+
+}
@@ -0,0 +1,171 @@
+#include "chatserver/infrastructure/bulk/pg_copy_binary.h"
+
+#include <arpa/inet.h>
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::bulk {
+
+namespace {
+
+constexpr char kSignature[] = "PGCOPY\n\377\r\n";
+constexpr std::size_t kSignatureSize = 11;
+// Сигнатура включает завершающий '\0'.
+constexpr std::size_t kHeaderSize = kSignatureSize + 4 + 4;
+// + i32 флаги + i32 длина расширения заголовка
+
+std::uint64_t to_network(std::uint64_t v) {
+    // Перестановка симметрична: годится и для обратного перевода.
+    if constexpr (std::endian::native == std::endian::little) {
+        return __builtin_bswap64(v);
+    }
+    return v;
+}
+
+template <typename T>
+T read_be(const char* p) {
+    if constexpr (sizeof(T) == 2) {
+        std::uint16_t v;
+        std::memcpy(&v, p, 2);
+        return static_cast<T>(ntohs(v));
+    } else if constexpr (sizeof(T) == 4) {
+        std::uint32_t v;
+        std::memcpy(&v, p, 4);
+        return static_cast<T>(ntohl(v));
+    } else {
+        std::uint64_t v;
+        std::memcpy(&v, p, 8);
+        return static_cast<T>(to_network(v));
+    }
+}
+
+void put16(std::string& out, std::int16_t v) {
+    const auto n = htons(static_cast<std::uint16_t>(v));
+    out.append(reinterpret_cast<const char*>(&n), 2);
+}
+
+void put32(std::string& out, std::int32_t v) {
+    const auto n = htonl(static_cast<std::uint32_t>(v));
+    out.append(reinterpret_cast<const char*>(&n), 4);
+}
+
+void put64(std::string& out, std::int64_t v) {
+    const auto n = to_network(static_cast<std::uint64_t>(v));
+    out.append(reinterpret_cast<const char*>(&n), 8);
+}
+
+}
+
+namespace pgcopy {
+
+void append_header(std::string& out) {
+    out.append(kSignature, kSignatureSize);
+    put32(out, 0);
+    put32(out, 0);
+}
+
+void append_trailer(std::string& out) {
+    put16(out, -1);
+}
+
+void begin_tuple(std::string& out, std::int16_t fields) {
+    put16(out, fields);
+}
+
+void append_int8(std::string& out, std::int64_t value) {
+    put32(out, 8);
+    put64(out, value);
+}
+
+void append_int4(std::string& out, std::int32_t value) {
+    put32(out, 4);
+    put32(out, value);
+}
+
+void append_text(std::string& out, std::string_view value) {
+    put32(out, static_cast<std::int32_t>(value.size()));
+    out.append(value);
+}
+
+void append_timestamp(std::string& out, std::int64_t unixMicros) {
+    append_int8(out, unixMicros - kPostgresEpochUnixUs);
+}
+
+void append_null(std::string& out) {
+    put32(out, -1);
+}
+
+std::int64_t read_int8(std::string_view field) {
+    if (field.size() == 4) return read_be<std::int32_t>(field.data());
+    if (field.size() != 8) {
+        throw std::runtime_error("COPY binary: integer field of " + std::to_string(field.size()) + " bytes");
+    }
+    return read_be<std::int64_t>(field.data());
+}
+
+std::int64_t read_timestamp(std::string_view field) {
+    if (field.size() != 8) {
+        throw std::runtime_error("COPY binary: timestamp field of " + std::to_string(field.size()) + " bytes");
+    }
+    return read_be<std::int64_t>(field.data()) + kPostgresEpochUnixUs;
+}
+
+}
+
+void PgCopyBinaryReader::feed(const char* data, std::size_t size) {
+    // Разобранное отбрасываем: буфер держит только недочитанный хвост.
+    if (pos_ > 0) {
+        buffer_.erase(0, pos_);
+        pos_ = 0;
+    }
+    buffer_.append(data, size);
+}
+
+bool PgCopyBinaryReader::next(Tuple& tuple) {
+    if (finished_) return false;
+    if (!headerDone_) {
+        if (buffer_.size() - pos_ < kHeaderSize) return false;
+        if (std::memcmp(buffer_.data() + pos_, kSignature, kSignatureSize) != 0) {
+            throw std::runtime_error("COPY binary: bad signature");
+        }
+        const auto extension = read_be<std::uint32_t>(buffer_.data() + pos_ + kSignatureSize + 4);
+        if (buffer_.size() - pos_ < kHeaderSize + extension) return false;
+        pos_ += kHeaderSize + extension;
+        headerDone_ = true;
+    }
+
+    std::size_t p = pos_;
+    if (buffer_.size() - p < 2) return false;
+    const auto fields = read_be<std::int16_t>(buffer_.data() + p);
+    p += 2;
+    if (fields == -1) {
+        pos_ = p;
+        finished_ = true;
+        return false;
+    }
+    if (fields < 0) {
+        throw std::runtime_error("COPY binary: bad field count");
+    }
+    tuple.clear();
+    for (std::int16_t i = 0; i < fields; ++i) {
+        if (buffer_.size() - p < 4) return false;
+        const auto length = read_be<std::int32_t>(buffer_.data() + p);
+        p += 4;
+        if (length == -1) {
+            tuple.emplace_back(std::nullopt);
+            continue;
+        }
+        if (length < 0) {
+            throw std::runtime_error("COPY binary: bad field length");
+        }
+        if (buffer_.size() - p < static_cast<std::size_t>(length)) return false;
+        tuple.emplace_back(std::string_view(buffer_.data() + p, static_cast<std::size_t>(length)));
+        p += static_cast<std::size_t>(length);
+    }
+    pos_ = p;
+    return true;
+}
+
+}
@@ -0,0 +1,264 @@
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace chatserver::infrastructure::cache {
+
+namespace {
+
+// Узел unordered_map + узел списка LRU + сама запись — грубая оценка накладных расходов.
+constexpr std::size_t kEntryOverhead = 160;
+
+}
+
+ConversationCache::ConversationCache(ConversationCacheOptions options)
+    : options_(options)
+{
+    const std::size_t shards = std::bit_ceil(std::max<std::size_t>(1, options_.shards));
+    options_.shards = shards;
+    options_.messagesPerConversation = std::max<std::size_t>(1, options_.messagesPerConversation);
+    shardMask_ = shards - 1;
+    shardBudget_ = options_.budgetBytes / shards;
+    shards_ = std::make_unique<Shard[]>(shards);
+}
+
+bool ConversationCache::stores_plain_text() const
+{
+    return options_.text == CachedTextForm::Plain;
+}
+
+std::size_t ConversationCache::messages_per_conversation() const
+{
+    return options_.messagesPerConversation;
+}
+
+ConversationCache::Shard& ConversationCache::shard_for(std::int64_t conversation) const
+{
+    // Ключ — пара id, поэтому перемешиваем обе половины (как в InMemoryMessageRepository).
+    const auto key = static_cast<std::uint64_t>(conversation) * 0x9E3779B97F4A7C15ull;
+    return shards_[(key >> 32) & shardMask_];
+}
+
+std::optional<std::vector<CachedMessage>> ConversationCache::find_page(
+    std::int64_t conversation, std::optional<std::int64_t> before, std::size_t limit)
+{
+    auto& shard = shard_for(conversation);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(conversation);
+    if (it == shard.entries.end() || it->second.loading != 0) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    if (it->second.expires <= Clock::now()) {
+        // Сообщения других узлов могли пройти мимо кэша: перечитываем хвост.
+        erase(shard, it);
+        expired_.fetch_add(1, std::memory_order_relaxed);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    const auto& entry = it->second;
+
+    // Число сообщений кольца с id < before: бинарный поиск по логическим индексам.
+    std::size_t end = entry.size();
+    if (before) {
+        std::size_t lo = 0;
+        std::size_t hi = entry.size();
+        while (lo < hi) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (entry.at(mid).id < *before) lo = mid + 1; else hi = mid;
+        }
+        end = lo;
+    }
+    const std::size_t count = std::min(limit, end);
+    if (count < limit && !entry.complete) {
+        // Страница уходит за самое старое сообщение кольца.
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    std::vector<CachedMessage> page;
+    page.reserve(count);
+    for (std::size_t i = end; i > end - count; --i) {
+        page.push_back(entry.at(i - 1));
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return page;
+}
+
+std::uint64_t ConversationCache::begin_fill(std::int64_t conversation)
+{
+    if (shardBudget_ == 0) {
+        return 0;
+    }
+    auto& shard = shard_for(conversation);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.entries.try_emplace(conversation);
+    if (!inserted) {
+        return 0;
+    }
+    auto& entry = it->second;
+    entry.loading = nextTicket_.fetch_add(1, std::memory_order_relaxed);
+    shard.lru.push_front(conversation);
+    entry.lru = shard.lru.begin();
+    account(shard, entry);
+    return entry.loading;
+}
+
+void ConversationCache::complete_fill(std::int64_t conversation, std::uint64_t ticket,
+                                      std::vector<CachedMessage> newestFirst, bool wholeConversation)
+{
+    auto& shard = shard_for(conversation);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(conversation);
+    if (it == shard.entries.end() || it->second.loading != ticket) {
+        // Запись вытеснили, пока шла загрузка.
+        return;
+    }
+    auto& entry = it->second;
+    const std::size_t capacity = options_.messagesPerConversation;
+    const std::size_t keep = std::min(capacity, newestFirst.size());
+    entry.ring.reserve(capacity);
+    for (std::size_t i = keep; i > 0; --i) {
+        entry.textBytes += newestFirst[i - 1].text.capacity();
+        entry.ring.push_back(std::move(newestFirst[i - 1]));
+    }
+    entry.head = 0;
+    entry.complete = wholeConversation && newestFirst.size() <= capacity;
+    if (options_.ttl.count() > 0) {
+        entry.expires = Clock::now() + options_.ttl;
+    }
+    entry.loading = 0;
+    for (auto& message : entry.pending) {
+        insert(entry, std::move(message));
+    }
+    entry.pending.clear();
+    entry.pending.shrink_to_fit();
+    fills_.fetch_add(1, std::memory_order_relaxed);
+    account(shard, entry);
+    evict(shard);
+}
+
+void ConversationCache::abort_fill(std::int64_t conversation, std::uint64_t ticket)
+{
+    auto& shard = shard_for(conversation);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(conversation);
+    if (it != shard.entries.end() && it->second.loading == ticket) {
+        erase(shard, it);
+    }
+}
+
+void ConversationCache::append(std::int64_t conversation, CachedMessage message)
+{
+    auto& shard = shard_for(conversation);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(conversation);
+    if (it == shard.entries.end()) {
+        return;
+    }
+    auto& entry = it->second;
+    appends_.fetch_add(1, std::memory_order_relaxed);
+    if (entry.loading != 0) {
+        entry.pending.push_back(std::move(message));
+        return;
+    }
+    insert(entry, std::move(message));
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru);
+    account(shard, entry);
+    evict(shard);
+}
+
+void ConversationCache::insert(Entry& entry, CachedMessage message)
+{
+    const std::size_t capacity = options_.messagesPerConversation;
+    if (entry.ring.capacity() < capacity) {
+        entry.ring.reserve(capacity);
+    }
+    const std::size_t size = entry.size();
+
+    if (size == 0 || message.id > entry.at(size - 1).id) {
+        // Обычный случай: новое сообщение новее всех в кольце.
+        entry.textBytes += message.text.capacity();
+        if (size < capacity) {
+            entry.ring.push_back(std::move(message));
+        } else {
+            auto& oldest = entry.ring[entry.head];
+            entry.textBytes -= oldest.text.capacity();
+            oldest = std::move(message);
+            entry.head = (entry.head + 1) % capacity;
+            entry.complete = false;
+        }
+        return;
+    }
+
+    // Параллельные сохранения пришли не по порядку id: вставка в середину
+    // (редко, поэтому кольцо сначала выпрямляется).
+    std::rotate(entry.ring.begin(), entry.ring.begin() + static_cast<std::ptrdiff_t>(entry.head), entry.ring.end());
+    entry.head = 0;
+    auto pos = std::lower_bound(entry.ring.begin(), entry.ring.end(), message.id,
+                                [](const CachedMessage& m, std::int64_t id) { return m.id < id; });
+    if (pos != entry.ring.end() && pos->id == message.id) {
+        return;
+    }
+    if (size == capacity) {
+        entry.complete = false;
+        if (pos == entry.ring.begin()) {
+            // Старше всего кольца — за пределами хвоста.
+            return;
+        }
+        entry.textBytes -= entry.ring.front().text.capacity();
+        const auto offset = pos - entry.ring.begin() - 1;
+        entry.ring.erase(entry.ring.begin());
+        pos = entry.ring.begin() + offset;
+    }
+    entry.textBytes += message.text.capacity();
+    entry.ring.insert(pos, std::move(message));
+}
+
+void ConversationCache::account(Shard& shard, Entry& entry)
+{
+    const std::size_t bytes = kEntryOverhead + entry.ring.capacity() * sizeof(CachedMessage) + entry.textBytes;
+    shard.bytes = shard.bytes - entry.bytes + bytes;
+    entry.bytes = bytes;
+}
+
+void ConversationCache::evict(Shard& shard)
+{
+    while (shard.bytes > shardBudget_ && !shard.lru.empty()) {
+        erase(shard, shard.entries.find(shard.lru.back()));
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ConversationCache::erase(Shard& shard, std::unordered_map<std::int64_t, Entry>::iterator it)
+{
+    shard.bytes -= it->second.bytes;
+    shard.lru.erase(it->second.lru);
+    shard.entries.erase(it);
+}
+
+ConversationCacheStats ConversationCache::stats() const
+{
+    ConversationCacheStats s;
+    s.hits      = hits_.load(std::memory_order_relaxed);
+    s.misses    = misses_.load(std::memory_order_relaxed);
+    s.fills     = fills_.load(std::memory_order_relaxed);
+    s.appends   = appends_.load(std::memory_order_relaxed);
+    s.evictions = evictions_.load(std::memory_order_relaxed);
+    s.expired = expired_.load(std::memory_order_relaxed);
+    s.budgetBytes = options_.budgetBytes;
+    for (std::size_t i = 0; i <= shardMask_; ++i) {
+        auto& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.conversations += shard.entries.size();
+        s.bytes += shard.bytes;
+        for (const auto& [key, entry] : shard.entries) {
+            s.messages += entry.size();
+        }
+    }
+    return s;
+}
+
+}
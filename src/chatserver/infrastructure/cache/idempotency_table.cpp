@@ -0,0 +1,161 @@
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace chatserver::infrastructure::cache {
+
+namespace {
+
+// Узел unordered_map<string, Entry> плюс элемент очереди — грубая оценка сверх строк.
+constexpr std::size_t kEntryOverhead = 96;
+
+std::size_t entry_bytes(const std::string& key) {
+    // Ключ хранится дважды: в таблице и в очереди.
+    return kEntryOverhead + key.capacity() * 2;
+}
+
+}
+
+IdempotencyTable::IdempotencyTable(IdempotencyOptions options)
+    : options_(options)
+{
+    const std::size_t shards = std::bit_ceil(std::max<std::size_t>(1, options_.shards));
+    options_.shards = shards;
+    shardMask_ = shards - 1;
+    perShard_ = (options_.capacity + shards - 1) / shards;
+    shards_ = std::make_unique<Shard[]>(shards);
+}
+
+IdempotencyTable::Shard& IdempotencyTable::shard_for(const std::string& key) const {
+    return shards_[(std::hash<std::string>{}(key) * 0x9E3779B97F4A7C15ull >> 40) & shardMask_];
+}
+
+IdempotencyTable::Result IdempotencyTable::execute(const std::string& key, std::uint64_t fingerprint,
+                                                   const std::function<std::int64_t()>& run) {
+    if (options_.capacity == 0) {
+        return Result{run(), false};
+    }
+    auto& shard = shard_for(key);
+
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto now = Clock::now();
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end() && !it->second.flight && it->second.expires <= now) {
+            // Истёкший ключ: запись в очереди останется и будет пропущена в trim().
+            shard.bytes -= entry_bytes(it->first);
+            shard.entries.erase(it);
+            expired_.fetch_add(1, std::memory_order_relaxed);
+            it = shard.entries.end();
+        }
+        if (it != shard.entries.end()) {
+            auto& entry = it->second;
+            if (entry.fingerprint != fingerprint) {
+                mismatches_.fetch_add(1, std::memory_order_relaxed);
+                throw IdempotencyKeyReusedError(key);
+            }
+            if (!entry.flight) {
+                replayed_.fetch_add(1, std::memory_order_relaxed);
+                return Result{entry.id, true};
+            }
+            flight = entry.flight;
+        } else {
+            Entry entry;
+            entry.fingerprint = fingerprint;
+            entry.flight = std::make_shared<Flight>();
+            flight = entry.flight;
+            auto inserted = shard.entries.emplace(key, std::move(entry)).first;
+            shard.bytes += entry_bytes(inserted->first);
+            leader = true;
+        }
+    }
+
+    if (!leader) {
+        // Повтор во время выполнения первого запроса: ждём его результат.
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> wait(flight->mutex);
+        flight->done.wait(wait, [&flight] { return flight->finished; });
+        if (flight->error) {
+            std::rethrow_exception(flight->error);
+        }
+        return Result{flight->id, true};
+    }
+
+    executed_.fetch_add(1, std::memory_order_relaxed);
+    std::int64_t id = 0;
+    std::exception_ptr error;
+    try {
+        id = run();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (error) {
+            // Неудача не запоминается: следующий повтор клиента выполнится заново.
+            shard.bytes -= entry_bytes(it->first);
+            shard.entries.erase(it);
+        } else {
+            const auto now = Clock::now();
+            it->second.id = id;
+            it->second.expires = now + options_.ttl;
+            it->second.flight.reset();
+            shard.order.push_back(Completed{key, it->second.expires});
+            trim(shard, now);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> flightLock(flight->mutex);
+        flight->id = id;
+        flight->error = error;
+        flight->finished = true;
+    }
+    flight->done.notify_all();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return Result{id, false};
+}
+
+void IdempotencyTable::trim(Shard& shard, Clock::time_point now) {
+    while (!shard.order.empty()) {
+        const auto& head = shard.order.front();
+        const bool overCapacity = shard.order.size() > perShard_;
+        if (!overCapacity && head.expires > now) {
+            break;
+        }
+        auto it = shard.entries.find(head.key);
+        if (it != shard.entries.end() && !it->second.flight && it->second.expires == head.expires) {
+            (head.expires > now ? evictions_ : expired_).fetch_add(1, std::memory_order_relaxed);
+            shard.bytes -= entry_bytes(it->first);
+            shard.entries.erase(it);
+        }
+        shard.order.pop_front();
+    }
+}
+
+IdempotencyStats IdempotencyTable::stats() const {
+    IdempotencyStats s;
+    s.executed   = executed_.load(std::memory_order_relaxed);
+    s.replayed   = replayed_.load(std::memory_order_relaxed);
+    s.coalesced  = coalesced_.load(std::memory_order_relaxed);
+    s.mismatches = mismatches_.load(std::memory_order_relaxed);
+    s.evictions  = evictions_.load(std::memory_order_relaxed);
+    s.expired    = expired_.load(std::memory_order_relaxed);
+    s.capacity   = options_.capacity;
+    for (std::size_t i = 0; i <= shardMask_; ++i) {
+        const auto& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.entries += shard.entries.size();
+        s.bytes += shard.bytes;
+    }
+    return s;
+}
+
+}
@@ -0,0 +1,128 @@
+#include "chatserver/infrastructure/cache/username_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::cache {
+
+namespace {
+
+// 64-битный хэш даёт 7 позиций по 9 бит (512 = 2^9).
+constexpr std::size_t kPositionsPerWord = 7;
+
+std::uint64_t mix(std::uint64_t x) {
+    // splitmix64: std::hash у libstdc++ хорош, но другие реализации отдают слабые биты.
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+double blocked_fpr(double perBlock, std::size_t k) {
+    // Число имён в блоке — пуассоновское с λ = n / blocks; в блоке с j именами
+    // ложное срабатывание — (1 - (1 - 1/512)^(k·j))^k. Классическая формула
+    // (1 - e^(-kn/m))^k неравномерность блоков не учитывает и занижает оценку.
+    const double kd = static_cast<double>(k);
+    const double keep = std::log1p(-1.0 / 512.0);
+    double term = std::exp(-perBlock);  // P(j = 0)
+    double fpr = 0;
+    const auto last = static_cast<std::size_t>(perBlock + 12.0 * std::sqrt(perBlock) + 16.0);
+    for (std::size_t j = 0; j <= last; ++j) {
+        if (j > 0) term *= perBlock / static_cast<double>(j);
+        fpr += term * std::pow(-std::expm1(kd * static_cast<double>(j) * keep), kd);
+    }
+    return fpr;
+}
+
+}
+
+UsernameFilter::UsernameFilter(UsernameFilterOptions options)
+{
+    if (options.expectedItems == 0) {
+        throw std::invalid_argument("UsernameFilter: expectedItems must be > 0");
+    }
+    if (!(options.falsePositiveRate > 0.0 && options.falsePositiveRate < 1.0)) {
+        throw std::invalid_argument("UsernameFilter: falsePositiveRate must be in (0, 1)");
+    }
+    // k — как у классического фильтра (log2(1/p)); число блоков — наименьшее, при
+    // котором оценка блочного фильтра укладывается в цель. Классический размер
+    // (n·ln(1/p)/ln²2 бит) — нижняя граница: блочному нужно на 10–25% больше.
+    const double ln2 = std::log(2.0);
+    const double n = static_cast<double>(options.expectedItems);
+    hashes_ = std::clamp<std::size_t>(
+        static_cast<std::size_t>(std::lround(-std::log2(options.falsePositiveRate))), 1, 16);
+    const double classicBits = -std::log(options.falsePositiveRate) / (ln2 * ln2) * n;
+    std::size_t lo = std::max<std::size_t>(1, static_cast<std::size_t>(classicBits / kBlockBits));
+    std::size_t hi = lo;
+    while (blocked_fpr(n / static_cast<double>(hi), hashes_) > options.falsePositiveRate) {
+        lo = hi;
+        hi *= 2;
+    }
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (blocked_fpr(n / static_cast<double>(mid), hashes_) > options.falsePositiveRate) lo = mid + 1;
+        else hi = mid;
+    }
+    blocks_ = hi;
+    bits_ = std::make_unique<Block[]>(blocks_);
+}
+
+UsernameFilter::Probe UsernameFilter::probe(std::string_view username) const {
+    const std::uint64_t h = mix(std::hash<std::string_view>{}(username));
+    Probe p;
+    p.block = static_cast<std::size_t>(h % blocks_);
+    // Позиции берутся из независимого хэша: двойное хэширование (first + i·step)
+    // внутри 512 бит даёт мало различных наборов и заметно поднимает долю ошибок.
+    p.bits  = mix(h ^ 0xC2B2AE3D27D4EB4Full);
+    return p;
+}
+
+void UsernameFilter::add(std::string_view username) {
+    const auto p = probe(username);
+    auto& block = bits_[p.block];
+    std::uint64_t source = p.bits;
+    for (std::size_t i = 0; i < hashes_; ++i) {
+        if (i > 0 && i % kPositionsPerWord == 0) source = mix(source);
+        const auto bit = static_cast<std::uint32_t>((source >> (9 * (i % kPositionsPerWord))) % kBlockBits);
+        block.words[bit / 64].fetch_or(std::uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+    items_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool UsernameFilter::may_contain(std::string_view username) const {
+    checks_.fetch_add(1, std::memory_order_relaxed);
+    const auto p = probe(username);
+    const auto& block = bits_[p.block];
+    std::uint64_t source = p.bits;
+    for (std::size_t i = 0; i < hashes_; ++i) {
+        if (i > 0 && i % kPositionsPerWord == 0) source = mix(source);
+        const auto bit = static_cast<std::uint32_t>((source >> (9 * (i % kPositionsPerWord))) % kBlockBits);
+        const auto word = block.words[bit / 64].load(std::memory_order_relaxed);
+        if (!(word & (std::uint64_t{1} << (bit % 64)))) {
+            definitelyAbsent_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void UsernameFilter::note_false_positive() {
+    falsePositives_.fetch_add(1, std::memory_order_relaxed);
+}
+
+UsernameFilterStats UsernameFilter::stats() const {
+    UsernameFilterStats s;
+    s.items            = items_.load(std::memory_order_relaxed);
+    s.checks           = checks_.load(std::memory_order_relaxed);
+    s.definitelyAbsent = definitelyAbsent_.load(std::memory_order_relaxed);
+    s.falsePositives   = falsePositives_.load(std::memory_order_relaxed);
+    s.bits             = blocks_ * kBlockBits;
+    s.hashes           = hashes_;
+    s.bytes            = blocks_ * sizeof(Block);
+    s.estimatedFpr     = blocked_fpr(static_cast<double>(s.items) / static_cast<double>(blocks_), hashes_);
+    return s;
+}
+
+}
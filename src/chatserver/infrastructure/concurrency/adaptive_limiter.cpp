@@ -0,0 +1,112 @@
+#include "chatserver/infrastructure/concurrency/adaptive_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace chatserver::infrastructure::concurrency {
+
+AdaptiveLimiter::AdaptiveLimiter(AdaptiveLimiterOptions options)
+    : options_(options)
+    , limit_(static_cast<double>(std::clamp(options.initialLimit, options.minLimit, options.maxLimit))) {}
+
+bool AdaptiveLimiter::try_acquire() {
+    std::lock_guard lock(mutex_);
+    if (static_cast<double>(inFlight_) >= std::floor(limit_)) {
+        ++shed_;
+        return false;
+    }
+    ++inFlight_;
+    ++admitted_;
+    windowPeak_ = std::max(windowPeak_, inFlight_);
+    return true;
+}
+
+void AdaptiveLimiter::release(Clock::duration latency) {
+    std::lock_guard lock(mutex_);
+    if (inFlight_ > 0) {
+        --inFlight_;
+    }
+    // Нулевая задержка (грубые часы) сделала бы градиент бесконечным.
+    const double rtt = std::max(std::chrono::duration<double>(latency).count(), 1e-6);
+    if (minRtt_ == 0 || rtt < minRtt_) {
+        minRtt_ = rtt;
+    }
+    windowSum_ += rtt;
+    if (++windowCount_ >= std::max<std::size_t>(1, options_.windowSamples)) {
+        update_limit();
+    }
+}
+
+void AdaptiveLimiter::release_dropped() {
+    std::lock_guard lock(mutex_);
+    if (inFlight_ > 0) {
+        --inFlight_;
+    }
+}
+
+void AdaptiveLimiter::update_limit() {
+    // Вызывается под mutex_.
+    sampleRtt_ = windowSum_ / static_cast<double>(windowCount_);
+    const double gradient = std::clamp(options_.tolerance * minRtt_ / sampleRtt_, 0.5, 1.0);
+    double next = limit_ * gradient + std::sqrt(limit_);
+    if (next > limit_ && static_cast<double>(windowPeak_) < limit_ / 2) {
+        // Запросов было мало — рост лимита ничем не подтверждён.
+        next = limit_;
+    }
+    limit_ = std::clamp(limit_ * (1 - options_.smoothing) + next * options_.smoothing,
+                        static_cast<double>(options_.minLimit), static_cast<double>(options_.maxLimit));
+
+    windowSum_ = 0;
+    windowCount_ = 0;
+    windowPeak_ = inFlight_;
+    if (options_.minRttResetWindows != 0 && ++windows_ % options_.minRttResetWindows == 0) {
+        minRtt_ = sampleRtt_;
+    }
+}
+
+AdaptiveLimiterStats AdaptiveLimiter::stats() const {
+    std::lock_guard lock(mutex_);
+    AdaptiveLimiterStats s;
+    s.limit = static_cast<std::size_t>(std::floor(limit_));
+    s.inFlight = inFlight_;
+    s.admitted = admitted_;
+    s.shed = shed_;
+    s.minRttUs = static_cast<std::uint64_t>(std::llround(minRtt_ * 1e6));
+    s.sampleRttUs = static_cast<std::uint64_t>(std::llround(sampleRtt_ * 1e6));
+    return s;
+}
+
+AdmissionControl::AdmissionControl(AdmissionOptions options)
+    : options_(std::move(options))
+{
+    limiters_.emplace(std::string(kDefaultClass), std::make_unique<AdaptiveLimiter>(options_.limiter));
+    for (const auto& [path, name] : options_.routeClasses) {
+        if (name != kUnlimitedClass && !limiters_.count(name)) {
+            limiters_.emplace(name, std::make_unique<AdaptiveLimiter>(options_.limiter));
+        }
+    }
+}
+
+AdaptiveLimiter* AdmissionControl::limiter_for(std::string_view path) {
+    std::string_view name = kDefaultClass;
+    if (auto it = options_.routeClasses.find(std::string(path)); it != options_.routeClasses.end()) {
+        name = it->second;
+    }
+    if (name == kUnlimitedClass) {
+        return nullptr;
+    }
+    return limiters_.at(std::string(name)).get();
+}
+
+std::vector<AdmissionClassStats> AdmissionControl::stats() const {
+    std::vector<AdmissionClassStats> out;
+    out.reserve(limiters_.size());
+    for (const auto& [name, limiter] : limiters_) {
+        out.push_back({name, limiter->stats()});
+    }
+    std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+    return out;
+}
+
+}
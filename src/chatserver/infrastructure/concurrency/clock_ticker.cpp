@@ -0,0 +1,44 @@
+#include "chatserver/infrastructure/concurrency/clock_ticker.h"
+
+#include <stdexcept>
+
+namespace chatserver::infrastructure::concurrency {
+
+ClockTicker::ClockTicker(std::chrono::microseconds interval)
+    : interval_(interval)
+    , previous_(domain::Timestamp::current_clock())
+{
+    if (interval_.count() <= 0) {
+        throw std::invalid_argument("clock ticker interval must be positive");
+    }
+    domain::Timestamp::publish_cached(domain::Timestamp::precise_now());
+    thread_ = std::thread([this] { run(); });
+    domain::Timestamp::use_clock(domain::TimestampClock::Cached);
+}
+
+ClockTicker::~ClockTicker() {
+    stop();
+}
+
+void ClockTicker::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    // Сначала источник: после stop() никто не должен получить застывшее время.
+    domain::Timestamp::use_clock(previous_);
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ClockTicker::run() {
+    std::unique_lock lock(mutex_);
+    while (!wake_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        domain::Timestamp::publish_cached(domain::Timestamp::precise_now());
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace chatserver::infrastructure::concurrency {
+
+namespace {
+
+thread_local std::optional<RequestDeadline::Clock::time_point> tlsDeadline;
+thread_local bool tlsExceeded = false;
+
+std::atomic<std::uint64_t> requestsTotal{0};
+std::atomic<std::uint64_t> exceededTotal{0};
+
+}
+
+RequestDeadline::Scope::Scope(Clock::time_point deadline)
+    : previous_(tlsDeadline)
+    , previousExceeded_(tlsExceeded)
+{
+    tlsDeadline = previous_ ? std::min(*previous_, deadline) : deadline;
+    tlsExceeded = false;
+    if (!previous_) {
+        requestsTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+RequestDeadline::Scope::Scope(Clock::time_point deadline, Forked)
+    : previous_(tlsDeadline)
+    , previousExceeded_(tlsExceeded)
+    , counted_(false)
+{
+    tlsDeadline = previous_ ? std::min(*previous_, deadline) : deadline;
+    tlsExceeded = false;
+}
+
+RequestDeadline::Scope::~Scope() {
+    if (tlsExceeded && !previous_ && counted_) {
+        exceededTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Превышение во вложенном Scope — превышение и внешнего.
+    tlsExceeded = previousExceeded_ || (tlsExceeded && previous_.has_value());
+    tlsDeadline = previous_;
+}
+
+bool RequestDeadline::Scope::exceeded() const {
+    return tlsExceeded;
+}
+
+std::optional<RequestDeadline::Clock::time_point> RequestDeadline::current() {
+    return tlsDeadline;
+}
+
+std::optional<std::chrono::milliseconds> RequestDeadline::remaining() {
+    if (!tlsDeadline) {
+        return std::nullopt;
+    }
+    const auto left = std::chrono::ceil<std::chrono::milliseconds>(*tlsDeadline - Clock::now());
+    return std::max(left, std::chrono::milliseconds(0));
+}
+
+void RequestDeadline::check() {
+    if (tlsDeadline && Clock::now() >= *tlsDeadline) {
+        mark_exceeded();
+        throw DeadlineExceeded();
+    }
+}
+
+void RequestDeadline::mark_exceeded() {
+    if (tlsDeadline) {
+        tlsExceeded = true;
+    }
+}
+
+RequestDeadlineStats RequestDeadline::stats() {
+    RequestDeadlineStats s;
+    s.requests = requestsTotal.load(std::memory_order_relaxed);
+    s.exceeded = exceededTotal.load(std::memory_order_relaxed);
+    return s;
+}
+
+}
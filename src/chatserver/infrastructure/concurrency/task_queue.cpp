@@ -1 +1,46 @@
 #include "chatserver/infrastructure/concurrency/task_queue.h"
+
+namespace chatserver::infrastructure::concurrency {
+
+bool TaskQueue::push(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    // Будим потребителя уже без мьютекса, чтобы он не проснулся в занятый лок.
+    ready_.notify_one();
+    return true;
+}
+
+std::optional<Task> TaskQueue::pop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return closed_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+        return std::nullopt;
+    }
+    Task task = std::move(tasks_.front());
+    tasks_.pop_front();
+    return task;
+}
+
+void TaskQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    ready_.notify_all();
+}
+
+std::size_t TaskQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+}
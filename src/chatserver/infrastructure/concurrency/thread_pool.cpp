@@ -1 +1,54 @@
 #include "chatserver/infrastructure/concurrency/thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace chatserver::infrastructure::concurrency {
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    stop();
+}
+
+bool ThreadPool::post(Task task)
+{
+    return queue_.push(std::move(task));
+}
+
+void ThreadPool::stop()
+{
+    queue_.close();
+    for (auto& worker : workers_) {
+        if (worker.joinable() && worker.get_id() != std::this_thread::get_id()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    while (auto task = queue_.pop()) {
+        try {
+            (*task)();
+        } catch (const std::exception& ex) {
+            // Исключение задачи не должно убивать воркер (и весь процесс через std::terminate).
+            std::cerr << "[ThreadPool] task exception: " << ex.what() << std::endl;
+        } catch (...) {
+            std::cerr << "[ThreadPool] task unknown exception" << std::endl;
+        }
+    }
+}
+
+}
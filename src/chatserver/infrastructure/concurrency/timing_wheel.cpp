@@ -0,0 +1,121 @@
+#include "chatserver/infrastructure/concurrency/timing_wheel.h"
+
+#include <algorithm>
+
+namespace chatserver::infrastructure::concurrency {
+
+void WheelTimer::cancel()
+{
+    if (wheel_ != nullptr) {
+        wheel_->unlink(*this);
+    }
+}
+
+TimingWheel::TimingWheel(Clock::duration tick, Clock::time_point start)
+    : tick_(std::max<Clock::duration>(tick, std::chrono::milliseconds(1)))
+    , start_(start)
+{
+}
+
+TimingWheel::~TimingWheel()
+{
+    for (auto& level : slots_) {
+        for (auto& head : level) {
+            while (head != nullptr) {
+                unlink(*head);
+            }
+        }
+    }
+}
+
+void TimingWheel::schedule(WheelTimer& timer, Clock::duration delay)
+{
+    if (timer.wheel_ != nullptr) {
+        timer.wheel_->unlink(timer);
+    }
+    const auto ticks = delay <= Clock::duration::zero()
+        ? std::uint64_t{1}
+        : static_cast<std::uint64_t>((delay + tick_ - Clock::duration(1)) / tick_);
+    constexpr std::uint64_t kMaxTicks = (std::uint64_t{1} << (kSlotBits * kLevels)) - 1;
+    timer.expiry_ = current_ + std::clamp<std::uint64_t>(ticks, 1, kMaxTicks);
+    timer.wheel_ = this;
+    ++armed_;
+    insert(timer);
+}
+
+void TimingWheel::insert(WheelTimer& timer)
+{
+    // Уровень — по расстоянию до срабатывания, слот — по битам абсолютного срока
+    // этого уровня. Таймер уровня L > 0 спустится ниже, когда уровень L-1 пройдёт
+    // через ноль и начнётся его блок из 256^L тиков.
+    const std::uint64_t delta = timer.expiry_ - current_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (std::uint64_t{1} << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    const auto slot = (timer.expiry_ >> (kSlotBits * level)) & (kSlots - 1);
+    auto& head = slots_[level][slot];
+    timer.next_ = head;
+    timer.pprev_ = &head;
+    if (head != nullptr) {
+        head->pprev_ = &timer.next_;
+    }
+    head = &timer;
+}
+
+void TimingWheel::unlink(WheelTimer& timer)
+{
+    *timer.pprev_ = timer.next_;
+    if (timer.next_ != nullptr) {
+        timer.next_->pprev_ = timer.pprev_;
+    }
+    timer.next_ = nullptr;
+    timer.pprev_ = nullptr;
+    timer.wheel_ = nullptr;
+    --armed_;
+}
+
+void TimingWheel::cascade(unsigned level)
+{
+    // Переносим слот, чей блок начинается сейчас, на уровни ниже.
+    auto& head = slots_[level][(current_ >> (kSlotBits * level)) & (kSlots - 1)];
+    WheelTimer* timer = head;
+    head = nullptr;
+    while (timer != nullptr) {
+        WheelTimer* next = timer->next_;
+        insert(*timer);
+        timer = next;
+    }
+}
+
+std::size_t TimingWheel::advance(Clock::time_point now)
+{
+    if (now <= start_) {
+        return 0;
+    }
+    const auto target = static_cast<std::uint64_t>((now - start_) / tick_);
+    std::size_t fired = 0;
+    while (current_ < target) {
+        ++current_;
+        for (unsigned level = 1; level < kLevels; ++level) {
+            if (((current_ >> (kSlotBits * (level - 1))) & (kSlots - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+        // Снимаем по одному с головы: обработчик может снять или перевзвести
+        // соседей по слоту (например, уничтожив их владельца).
+        auto& head = slots_[0][current_ & (kSlots - 1)];
+        while (head != nullptr) {
+            WheelTimer& timer = *head;
+            unlink(timer);
+            ++fired;
+            if (timer.onExpire_) {
+                timer.onExpire_();
+            }
+        }
+    }
+    return fired;
+}
+
+}
@@ -3,6 +3,8 @@
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <iomanip>
@@ -17,31 +19,97 @@ static std::string to_hex(const unsigned char* data, size_t len) {
     return oss.str();
 }
 
-static std::vector<unsigned char> from_hex(const std::string& hex) {
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    throw std::invalid_argument("invalid hex digit in ciphertext");
+}
+
+static std::vector<unsigned char> from_hex(std::string_view hex) {
     std::vector<unsigned char> out(hex.size() / 2);
     for (size_t i = 0; i < out.size(); ++i)
         out[i] = static_cast<unsigned char>(
-            std::stoi(hex.substr(i * 2, 2), nullptr, 16)
+            (hex_value(hex[i * 2]) << 4) | hex_value(hex[i * 2 + 1])
         );
     return out;
 }
 
+static std::string decrypt_with(
+    EVP_CIPHER_CTX* ctx,
+    std::string_view encrypted
+) {
+    // ctx уже инициализирован шифром и ключом (init_decrypt_ctx): здесь меняется
+    // только IV — без повторного поиска реализации шифра и развёртки ключа AES.
+    // Формат: hex(iv):hex(ciphertext):hex(tag). Битый формат или тег — пустая строка,
+    // как и раньше в decrypt().
+    auto p1 = encrypted.find(':');
+    auto p2 = p1 == std::string_view::npos ? p1 : encrypted.find(':', p1 + 1);
+    if (p2 == std::string_view::npos) {
+        return {};
+    }
+
+    auto iv = from_hex(encrypted.substr(0, p1));
+    auto data = from_hex(encrypted.substr(p1 + 1, p2 - p1 - 1));
+    auto tag = from_hex(encrypted.substr(p2 + 1));
+
+    EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data());
+
+    std::vector<unsigned char> out(data.size());
+    int len;
+    EVP_DecryptUpdate(ctx, out.data(), &len, data.data(), data.size());
+
+    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, tag.size(), tag.data());
+
+    if (EVP_DecryptFinal_ex(ctx, out.data() + len, &len) <= 0) {
+        return {};
+    }
+    return std::string(out.begin(), out.end());
+}
+
 OpenSSLMessageEncryptor::OpenSSLMessageEncryptor(
     const std::string& secret
-) : secret_(secret) {}
+) : secret_(secret) {
+    EVP_Digest(secret_.data(), secret_.size(),
+               key_.data(), nullptr, EVP_sha256(), nullptr);
+}
+
+static std::string encrypt_with(
+    EVP_CIPHER_CTX* ctx,
+    const unsigned char* iv,
+    const std::string& plaintext
+) {
+    // ctx уже настроен шифром и ключом: для сообщения задаётся только IV.
+    EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv);
+
+    std::vector<unsigned char> out(plaintext.size());
+    int len;
+    EVP_EncryptUpdate(
+        ctx, out.data(), &len,
+        reinterpret_cast<const unsigned char*>(plaintext.data()),
+        plaintext.size()
+    );
+
+    int ciphertext_len = len;
+    EVP_EncryptFinal_ex(ctx, out.data() + len, &len);
+    ciphertext_len += len;
+
+    unsigned char tag[16];
+    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, 16, tag);
+
+    return to_hex(iv, 12) + ":" +
+           to_hex(out.data(), ciphertext_len) + ":" +
+           to_hex(tag, sizeof(tag));
+}
 
 std::string OpenSSLMessageEncryptor::encrypt(
     const std::string& plaintext
 ) const {
-    unsigned char key[32];
-    EVP_Digest(secret_.data(), secret_.size(),
-               key, nullptr, EVP_sha256(), nullptr);
-
     unsigned char iv[12];
     RAND_bytes(iv, sizeof(iv));
 
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, iv);
+    EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key_.data(), iv);
 
     std::vector<unsigned char> out(plaintext.size());
     int len;
@@ -64,37 +132,67 @@ std::string OpenSSLMessageEncryptor::encrypt(
            to_hex(tag, sizeof(tag));
 }
 
+static EVP_CIPHER_CTX* init_decrypt_ctx(const unsigned char* key) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, nullptr);
+    return ctx;
+}
+
 std::string OpenSSLMessageEncryptor::decrypt(
     const std::string& encrypted
 ) const {
-    auto p1 = encrypted.find(':');
-    auto p2 = encrypted.find(':', p1 + 1);
-
-    auto iv = from_hex(encrypted.substr(0, p1));
-    auto data = from_hex(encrypted.substr(p1 + 1, p2 - p1 - 1));
-    auto tag = from_hex(encrypted.substr(p2 + 1));
-
-    unsigned char key[32];
-    EVP_Digest(secret_.data(), secret_.size(),
-               key, nullptr, EVP_sha256(), nullptr);
+    EVP_CIPHER_CTX* ctx = init_decrypt_ctx(key_.data());
+    try {
+        auto plain = decrypt_with(ctx, encrypted);
+        EVP_CIPHER_CTX_free(ctx);
+        return plain;
+    } catch (...) {
+        EVP_CIPHER_CTX_free(ctx);
+        throw;
+    }
+}
 
+std::vector<std::string> OpenSSLMessageEncryptor::encrypt_batch(
+    const std::vector<std::string>& plaintexts
+) const {
+    // Случайные IV для всей пачки — одним RAND_bytes.
+    std::vector<unsigned char> ivs(plaintexts.size() * 12);
+    if (!ivs.empty() && RAND_bytes(ivs.data(), static_cast<int>(ivs.size())) != 1) {
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    std::vector<std::string> out;
+    out.reserve(plaintexts.size());
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, iv.data());
-
-    std::vector<unsigned char> out(data.size());
-    int len;
-    EVP_DecryptUpdate(ctx, out.data(), &len, data.data(), data.size());
-
-    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, tag.size(), tag.data());
-
-    if (EVP_DecryptFinal_ex(ctx, out.data() + len, &len) <= 0) {
+    EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key_.data(), nullptr);
+    try {
+        for (std::size_t i = 0; i < plaintexts.size(); ++i) {
+            out.push_back(encrypt_with(ctx, ivs.data() + i * 12, plaintexts[i]));
+        }
+    } catch (...) {
         EVP_CIPHER_CTX_free(ctx);
-        return {};
+        throw;
     }
-
     EVP_CIPHER_CTX_free(ctx);
-    return std::string(out.begin(), out.end());
+    return out;
 }
 
+std::vector<std::string> OpenSSLMessageEncryptor::decrypt_batch(
+    const std::vector<std::string>& ciphertexts
+) const {
+    std::vector<std::string> out;
+    out.reserve(ciphertexts.size());
+    EVP_CIPHER_CTX* ctx = init_decrypt_ctx(key_.data());
+    try {
+        for (const auto& encrypted : ciphertexts) {
+            // Шифр и ключ настроены один раз на всю пачку, для каждого сообщения — только IV.
+            out.push_back(decrypt_with(ctx, encrypted));
+        }
+    } catch (...) {
+        EVP_CIPHER_CTX_free(ctx);
+        throw;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return out;
 }
 
+}
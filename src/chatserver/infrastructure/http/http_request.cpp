@@ -1 +1,78 @@
 #include "chatserver/infrastructure/http/http_request.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace chatserver::infrastructure::http {
+
+namespace {
+
+int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string url_decode(std::string_view in) {
+    // Некорректные %-последовательности оставляем как есть — решать, валидно ли
+    // значение, будет обработчик маршрута.
+    std::string out;
+    out.reserve(in.size());
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        if (in[i] == '+') {
+            out.push_back(' ');
+        } else if (in[i] == '%' && i + 2 < in.size() &&
+                   hex_digit(in[i + 1]) >= 0 && hex_digit(in[i + 2]) >= 0) {
+            out.push_back(static_cast<char>(hex_digit(in[i + 1]) * 16 + hex_digit(in[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(in[i]);
+        }
+    }
+    return out;
+}
+
+}
+
+std::optional<std::string> HttpRequest::header(std::string_view name) const {
+    // Быстрый путь — точное совпадение; иначе сравнение без учёта регистра (RFC 9110).
+    if (auto it = headers.find(std::string(name)); it != headers.end()) {
+        return it->second;
+    }
+    for (const auto& [key, value] : headers) {
+        if (key.size() == name.size() &&
+            std::equal(key.begin(), key.end(), name.begin(), [](char a, char b) {
+                return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+            })) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view HttpRequest::path() const {
+    std::string_view t = target;
+    return t.substr(0, t.find('?'));
+}
+
+std::optional<std::string> HttpRequest::query_param(std::string_view name) const {
+    const auto q = target.find('?');
+    if (q == std::string::npos) {
+        return std::nullopt;
+    }
+    std::string_view query = std::string_view(target).substr(q + 1);
+    while (!query.empty()) {
+        const auto amp = query.find('&');
+        const auto pair = query.substr(0, amp);
+        const auto eq = pair.find('=');
+        if (url_decode(pair.substr(0, eq)) == name) {
+            return eq == std::string_view::npos ? std::string{} : url_decode(pair.substr(eq + 1));
+        }
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return std::nullopt;
+}
+
+}
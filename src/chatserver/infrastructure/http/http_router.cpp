@@ -17,8 +17,9 @@ void HttpRouter::add_route(const std::string& method,
 
 HttpResponse HttpRouter::route(const HttpRequest& request) const
 {
-    const std::string key = make_key(request.method, request.target);
+    const std::string key = make_key(request.method, std::string(request.path()));
     // Формируем ключ для поиска обработчика по методу и пути запроса.
+    // Query-строка в ключ не входит: "/messages?peer=1" обслуживает маршрут "/messages".
     auto it = routes_.find(key);
     if (it == routes_.end()) {
         // Маршрут не найден — вернём 404
@@ -2,134 +2,1232 @@
 #include "chatserver/infrastructure/http/http_server.h"
 #include "chatserver/infrastructure/http/http_request.h"
 #include "chatserver/infrastructure/http/http_response.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+#include "chatserver/infrastructure/concurrency/thread_pool.h"
+#include "chatserver/infrastructure/concurrency/timing_wheel.h"
 
+#include <utility>
 #include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
 #include <boost/asio.hpp>
-#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace chatserver::infrastructure::http {
 
-namespace beast = boost::beast;
-namespace http  = beast::http;
-namespace net   = boost::asio;
-using tcp       = net::ip::tcp;
+namespace beast     = boost::beast;
+namespace http      = beast::http;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using concurrency::AdaptiveLimiter;
+using concurrency::RequestDeadline;
+using concurrency::TimingWheel;
+using concurrency::WheelTimer;
 // Удобные псевдонимы для Beast/Asio, чтобы код был короче и читабельнее.
 
+namespace {
+
+struct DeferredGate {
+    // Отложенные ответы (HttpResponse::deferred) завершаются из чужих потоков.
+    // Под этим мьютексом sink проверяет, что сервер работает, и post'ит ответ
+    // в io_context; stop() закрывает ворота до остановки io_context'ов, и после
+    // этого запоздавший sink не трогает ни сессию, ни io_context.
+    std::mutex mutex;
+    bool open = true;
+};
+
+class DrainableSession {
+// Соединение, которое умеет плавно завершиться при остановке сервера (shutdown()).
+public:
+    virtual ~DrainableSession() = default;
+    virtual void drain() = 0;
+    // Вызывается в io-потоке соединения.
+    virtual void abort() = 0;
+    // Срок остановки вышел: соединение рвётся сразу. Тоже в io-потоке.
+};
+
+struct SessionTracker {
+    // Открытые соединения сервера: shutdown() обходит их и ждёт, пока закроются все.
+    // Сессию может уничтожить и чужой поток (последней ссылкой из отложенного
+    // ответа), поэтому реестр общий, под мьютексом, а не свой у каждого io-потока.
+    std::mutex mutex;
+    std::condition_variable emptied;
+    std::unordered_map<const DrainableSession*,
+                       std::pair<std::weak_ptr<DrainableSession>, net::any_io_executor>> sessions;
+    std::atomic<bool> draining{false};
+    // Сервер останавливается: новых запросов на соединениях не читаем.
+
+    void add(const std::shared_ptr<DrainableSession>& session, net::any_io_executor executor) {
+        std::lock_guard lock(mutex);
+        sessions.emplace(session.get(), std::make_pair(std::weak_ptr<DrainableSession>(session), std::move(executor)));
+    }
+
+    void remove(const DrainableSession* session) {
+        std::lock_guard lock(mutex);
+        if (sessions.erase(session) != 0 && sessions.empty()) {
+            emptied.notify_all();
+        }
+    }
+
+    void drain_all() {
+        for_each([](DrainableSession& session) { session.drain(); });
+    }
+
+    void abort_all() {
+        for_each([](DrainableSession& session) { session.abort(); });
+    }
+
+    template <typename Action>
+    void for_each(Action action) {
+        // action выполняется в io-потоке каждой сессии.
+        std::vector<std::pair<std::weak_ptr<DrainableSession>, net::any_io_executor>> targets;
+        {
+            std::lock_guard lock(mutex);
+            for (const auto& [ptr, target] : sessions) targets.push_back(target);
+        }
+        for (auto& [weak, executor] : targets) {
+            if (auto session = weak.lock()) {
+                net::post(executor, [session, action] { action(*session); });
+            }
+        }
+    }
+
+    std::size_t wait_empty(std::chrono::steady_clock::time_point deadline) {
+        // Сколько соединений осталось открытыми к сроку.
+        std::unique_lock lock(mutex);
+        emptied.wait_until(lock, deadline, [this] { return sessions.empty(); });
+        return sessions.size();
+    }
+};
+
+// Общее состояние, которое разделяют все сессии сервера.
+struct ServerState {
+    std::shared_ptr<HttpRouter> router;
+    std::shared_ptr<realtime::ConnectionRegistry> connections;
+    std::shared_ptr<concurrency::AdmissionControl> admission;
+    std::shared_ptr<concurrency::ThreadPool> workers;
+    std::shared_ptr<DeferredGate> deferred;
+    std::shared_ptr<SessionTracker> sessions;
+    HttpServerOptions options;
+};
+
+bool is_routine_disconnect(const beast::error_code& ec) {
+    // Клиент ушёл, истёк срок соединения (колесо таймеров закрывает сокет — отсюда
+    // operation_aborted), сервер останавливается — в лог не пишем.
+    return ec == http::error::end_of_stream ||
+           ec == beast::error::timeout ||
+           ec == websocket::error::closed ||
+           ec == net::error::operation_aborted ||
+           ec == net::error::connection_reset ||
+           ec == net::error::broken_pipe ||
+           ec == net::error::eof;
+}
+
+HttpRequest to_http_request(const http::request<http::string_body>& req) {
+    // Конвертация Beast → HttpRequest
+    HttpRequest hreq;
+    hreq.method = std::string(req.method_string());
+    hreq.target = std::string(req.target());
+    hreq.body   = req.body();
+    for (auto const& field : req) {
+        hreq.headers.emplace(
+            std::string(field.name_string()),
+            std::string(field.value())
+        );
+    }
+    return hreq;
+}
+
+HttpResponse route_safely(const HttpRouter& router, const HttpRequest& hreq) {
+    // Передаём запрос в роутер.
+    try {
+        return router.route(hreq);
+    } catch (const std::exception& ex) {
+        // Если обработчик маршрута упал — возвращаем 500.
+        std::cerr << "Router exception: " << ex.what() << std::endl;
+        HttpResponse hresp;
+        hresp.status_code = 500;
+        hresp.body = R"({"error":"internal server error"})";
+        return hresp;
+    }
+}
+
+std::chrono::milliseconds request_budget(const HttpServerOptions& options, const HttpRequest& hreq) {
+    // Бюджет маршрута, если задан, иначе общий; 0 — без срока.
+    if (!options.routeDeadlines.empty()) {
+        auto it = options.routeDeadlines.find(std::string(hreq.path()));
+        if (it != options.routeDeadlines.end()) {
+            return it->second;
+        }
+    }
+    return options.requestDeadline;
+}
+
+template <typename Session, typename... Args>
+std::shared_ptr<Session> make_session(net::io_context::executor_type executor, Args&&... args) {
+    // Сессию уничтожает её io-поток: таймер колеса и сокет принадлежат ему, а
+    // последней ссылкой может оказаться воркер, отложенный ответ или рассылка из
+    // чужого потока. Оттуда удаление post'ится в io-поток; не выполненное до
+    // остановки io_context оно случится при его разрушении (stop()).
+    return std::shared_ptr<Session>(new Session(std::forward<Args>(args)...), [executor](Session* session) {
+        if (executor.running_in_this_thread()) {
+            delete session;
+            return;
+        }
+        net::post(executor, [owned = std::unique_ptr<Session>(session)] {});
+    });
+}
+
+HttpResponse deadline_exceeded_response() {
+    HttpResponse hresp;
+    hresp.status_code = 504;
+    hresp.body = R"({"error":"deadline exceeded"})";
+    return hresp;
+}
+
+// ---------------------
+// WebSocket-сессия
+// ---------------------
+
+class WebSocketSession : public realtime::RealtimeConnection,
+                         public DrainableSession,
+                         public std::enable_shared_from_this<WebSocketSession> {
+// Канал доставки сервер → клиент. Входящие кадры клиента читаются (нужно для
+// ping/pong и close), но игнорируются: отправка сообщений идёт через POST /send_message.
+// Всё состояние сессии трогает только её io-поток: send() из чужих потоков
+// лишь post'ит кадр в executor соединения.
+//
+// Исходящая очередь ограничена wsHighWaterBytes. Пока идёт запись, новые кадры
+// копятся в очереди; клиенту с batch=1 они уходят следующей записью все сразу.
+//
+// Сроки — на колесе таймеров io-потока, одним таймером heartbeat_: сначала это
+// срок handshake, затем период ping. Собственные таймауты Beast выключены —
+// они взводили бы steady_timer соединения на каждую операцию.
+public:
+    WebSocketSession(tcp::socket&& socket, std::shared_ptr<const ServerState> state,
+                     TimingWheel& wheel, std::int64_t userId, bool batch)
+        : ws_(std::move(socket))
+        , state_(std::move(state))
+        , wheel_(wheel)
+        , heartbeat_([this] { on_heartbeat(); })
+        , userId_(userId)
+        , batch_(batch) {}
+
+    ~WebSocketSession() override {
+        if (registered_) {
+            state_->connections->remove(userId_, this);
+        }
+        state_->sessions->remove(this);
+    }
+
+    void run(http::request<http::string_body> req) {
+        websocket::stream_base::timeout timeouts{};
+        timeouts.handshake_timeout = websocket::stream_base::none();
+        timeouts.idle_timeout = websocket::stream_base::none();
+        timeouts.keep_alive_pings = false;
+        ws_.set_option(timeouts);
+        ws_.control_callback([this](websocket::frame_type kind, beast::string_view) {
+            if (kind == websocket::frame_type::pong) {
+                awaitingPong_ = false;
+            }
+        });
+        ws_.text(true);
+        state_->sessions->add(shared_from_this(), ws_.get_executor());
+        wheel_.schedule(heartbeat_, state_->options.headerTimeout);
+        ws_.async_accept(req, beast::bind_front_handler(&WebSocketSession::on_accept, shared_from_this()));
+    }
+
+    void send(std::shared_ptr<const std::string> frame) override {
+        net::post(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+            self->enqueue(std::move(frame));
+        });
+    }
+
+    void drain() override {
+        // Сервер останавливается: close 1001, клиент переподключится к другому узлу.
+        // Handshake, который ещё идёт, закроет on_accept. Начатая запись кадров
+        // дописывается: close-кадр уходит после неё. Ответ на close ждём не дольше
+        // headerTimeout — дальше heartbeat_ рвёт TCP.
+        if (!accepted_ || closed_) {
+            return;
+        }
+        close();
+        wheel_.schedule(heartbeat_, state_->options.headerTimeout);
+        ws_.async_close(websocket::close_code::going_away, [self = shared_from_this()](beast::error_code) {
+            self->heartbeat_.cancel();
+        });
+    }
+
+    void abort() override {
+        close();
+        beast::error_code ignored;
+        beast::get_lowest_layer(ws_).close(ignored);
+    }
+
+private:
+    void on_accept(beast::error_code ec) {
+        if (ec) {
+            heartbeat_.cancel();
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "WebSocket handshake error: " << ec.message() << std::endl;
+            }
+            return;
+        }
+        if (state_->sessions->draining) {
+            // Сервер останавливается — heartbeat_ остаётся сроком ответа на close.
+            ws_.async_close(websocket::close_code::going_away,
+                            [self = shared_from_this()](beast::error_code) {});
+            return;
+        }
+        if (!state_->connections->add(userId_, shared_from_this())) {
+            // Лимит соединений на пользователя исчерпан — закрываем с кодом 1008.
+            // heartbeat_ остаётся сроком handshake: не ответившего на close он отключит.
+            ws_.async_close(websocket::close_code::policy_error,
+                            [self = shared_from_this()](beast::error_code) {});
+            return;
+        }
+        registered_ = true;
+        accepted_ = true;
+        wheel_.schedule(heartbeat_, state_->options.wsPingInterval);
+        do_read();
+    }
+
+    void on_heartbeat() {
+        // Вызывается из колеса в io-потоке сессии. Сессию держат её незавершённые
+        // операции, а деструктор снимает таймер, так что this здесь жив.
+        if (!accepted_ || awaitingPong_ || closed_) {
+            // Handshake не уложился в срок, на прошлый ping нет ответа или клиент не
+            // ответил на close (drain): клиент пропал или не читает (тогда и ping
+            // стоит в очереди за нашей записью).
+            close();
+            beast::error_code ignored;
+            beast::get_lowest_layer(ws_).close(ignored);
+            return;
+        }
+        awaitingPong_ = true;
+        ws_.async_ping({}, [self = shared_from_this()](beast::error_code) {});
+        wheel_.schedule(heartbeat_, state_->options.wsPingInterval);
+    }
+
+    void do_read() {
+        ws_.async_read(buffer_, beast::bind_front_handler(&WebSocketSession::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, std::size_t) {
+        if (ec) {
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "WebSocket read error: " << ec.message() << std::endl;
+            }
+            close();
+            return;
+        }
+        buffer_.consume(buffer_.size());
+        awaitingPong_ = false;
+        do_read();
+    }
+
+    void enqueue(std::shared_ptr<const std::string> frame) {
+        if (closed_) {
+            return;
+        }
+        auto& counters = state_->connections->outbound();
+        const auto& options = state_->options;
+
+        if (throttled_) {
+            // Гистерезис: после переполнения ждём, пока очередь уйдёт до половины порога,
+            // иначе соединение на границе порога отбрасывало бы каждый второй кадр.
+            if (queuedBytes_ > options.wsHighWaterBytes / 2) {
+                ++droppedSinceGap_;
+                counters.dropped(1);
+                return;
+            }
+            throttled_ = false;
+        }
+        if (queuedBytes_ + frame->size() > options.wsHighWaterBytes && !queue_.empty()) {
+            counters.slow_consumer();
+            if (options.wsSlowConsumerPolicy == SlowConsumerPolicy::Disconnect) {
+                // Получатель не читает — close-кадр до него тоже не дойдёт: рвём TCP.
+                counters.disconnected();
+                counters.dropped(queue_.size() - inFlight_ + 1);
+                close();
+                beast::error_code ignored;
+                beast::get_lowest_layer(ws_).close(ignored);
+                return;
+            }
+            throttled_ = true;
+            ++droppedSinceGap_;
+            counters.dropped(1);
+            return;
+        }
+        if (droppedSinceGap_ != 0) {
+            // Клиент должен знать о пропуске: по этому кадру он перечитывает историю.
+            push(std::make_shared<const std::string>(
+                R"({"type":"gap","dropped":)" + std::to_string(droppedSinceGap_) + "}"));
+            droppedSinceGap_ = 0;
+        }
+        push(std::move(frame));
+        if (inFlight_ == 0) {
+            do_write();
+        }
+    }
+
+    void push(std::shared_ptr<const std::string> frame) {
+        state_->connections->outbound().queued(1);
+        queuedBytes_ += frame->size();
+        queue_.push_back(std::move(frame));
+    }
+
+    void do_write() {
+        // У websocket::stream может быть только одна незавершённая запись, поэтому
+        // кадры, пришедшие во время записи, ждут в очереди и уходят следующей.
+        buffers_.clear();
+        inFlightBytes_ = 0;
+        if (!batch_ || queue_.size() == 1) {
+            inFlight_ = 1;
+            inFlightBytes_ = queue_.front()->size();
+            buffers_.push_back(net::buffer(*queue_.front()));
+        } else {
+            // Одно WebSocket-сообщение из нескольких кадров: в буферы идут ссылки
+            // на сами кадры (shared_ptr держит их в queue_), копирования нет.
+            static constexpr std::string_view kOpen = R"({"type":"batch","messages":[)";
+            static constexpr std::string_view kComma = ",";
+            static constexpr std::string_view kClose = "]}";
+            buffers_.push_back(net::buffer(kOpen.data(), kOpen.size()));
+            inFlight_ = 0;
+            for (const auto& frame : queue_) {
+                if (inFlight_ != 0 && inFlightBytes_ + frame->size() > state_->options.wsMaxBatchBytes) {
+                    break;
+                }
+                if (inFlight_ != 0) {
+                    buffers_.push_back(net::buffer(kComma.data(), kComma.size()));
+                }
+                buffers_.push_back(net::buffer(*frame));
+                inFlightBytes_ += frame->size();
+                ++inFlight_;
+            }
+            buffers_.push_back(net::buffer(kClose.data(), kClose.size()));
+            if (inFlight_ == 1) {
+                // Лимит пропустил только один кадр — отправляем его как есть.
+                buffers_.erase(buffers_.begin());
+                buffers_.pop_back();
+            }
+        }
+        ws_.async_write(buffers_, beast::bind_front_handler(&WebSocketSession::on_write, shared_from_this()));
+    }
+
+    void on_write(beast::error_code ec, std::size_t bytes) {
+        if (ec) {
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "WebSocket write error: " << ec.message() << std::endl;
+            }
+            close();
+            return;
+        }
+        state_->connections->outbound().written(inFlight_, bytes);
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(inFlight_));
+        queuedBytes_ -= inFlightBytes_;
+        inFlight_ = 0;
+        if (closed_) {
+            queue_.clear();
+            queuedBytes_ = 0;
+            return;
+        }
+        if (!queue_.empty()) {
+            do_write();
+        }
+    }
+
+    void close() {
+        closed_ = true;
+        heartbeat_.cancel();
+        if (inFlight_ == 0) {
+            // Пока запись идёт, её буферы ссылаются на кадры в очереди.
+            queue_.clear();
+            queuedBytes_ = 0;
+        }
+        if (registered_) {
+            state_->connections->remove(userId_, this);
+            registered_ = false;
+        }
+    }
+
+    websocket::stream<tcp::socket> ws_;
+    beast::flat_buffer buffer_;
+    std::shared_ptr<const ServerState> state_;
+    TimingWheel& wheel_;
+    WheelTimer heartbeat_;
+    std::int64_t userId_;
+    bool batch_;
+    // Клиент подключился с ?batch=1 и принимает {"type":"batch",...}.
+    std::deque<std::shared_ptr<const std::string>> queue_;
+    std::size_t queuedBytes_ = 0;
+    // Сумма размеров кадров в queue_ (включая записываемые).
+    std::size_t inFlight_ = 0;
+    std::size_t inFlightBytes_ = 0;
+    // Кадры из начала queue_, которые сейчас пишутся. 0 — записи нет.
+    std::vector<net::const_buffer> buffers_;
+    // Буферы текущей gather-записи; живут до on_write.
+    std::size_t droppedSinceGap_ = 0;
+    bool throttled_ = false;
+    bool registered_ = false;
+    bool accepted_ = false;
+    bool awaitingPong_ = false;
+    bool closed_ = false;
+};
+
+// ---------------------
+// HTTP-сессия (keep-alive)
+// ---------------------
+
+class HttpSession : public DrainableSession,
+                    public std::enable_shared_from_this<HttpSession> {
+// Одно TCP-соединение: чтение запроса в io-потоке, обработчик маршрута — в пуле
+// воркеров, запись ответа — снова в io-потоке. Пока воркер занят, io-поток
+// обслуживает другие соединения.
+//
+// Сроки соединения — один таймер deadline_ на колесе io-потока, перевзводимый
+// на каждой фазе: ожидание запроса (idleTimeout), заголовки (headerTimeout),
+// тело и запись ответа (idleTimeout). Истёкший срок закрывает сокет, и ожидающая
+// операция завершается с operation_aborted. Пока запрос у воркера, таймер снят;
+// каждый путь, которым соединение заканчивается, тоже его снимает.
+public:
+    HttpSession(tcp::socket&& socket, std::shared_ptr<const ServerState> state, TimingWheel& wheel)
+        : socket_(std::move(socket))
+        , state_(std::move(state))
+        , wheel_(wheel)
+        , deadline_([this] { on_deadline(); }) {}
+
+    ~HttpSession() override {
+        // Запрос, занявший место в лимите, не дошёл до обработчика (сервер остановлен).
+        if (limiter_) {
+            limiter_->release_dropped();
+        }
+        state_->sessions->remove(this);
+    }
+
+    void run() {
+        state_->sessions->add(shared_from_this(), socket_.get_executor());
+        net::dispatch(socket_.get_executor(),
+                      beast::bind_front_handler(&HttpSession::do_read, shared_from_this()));
+    }
+
+    void drain() override {
+        // Простаивающее keep-alive соединение закрываем сразу. Начатый запрос
+        // дорабатывает: ответ уйдёт с Connection: close (write_response), следующий
+        // запрос не читается (do_read). Ждущему long-poll отвечаем 503 — клиент
+        // повторит запрос на другом узле, не дожидаясь таймаута.
+        if (parked_) {
+            HttpResponse hresp;
+            hresp.status_code = 503;
+            hresp.headers.emplace("Retry-After", "1");
+            hresp.body = R"({"error":"shutting down"})";
+            resume(hresp, req_.version(), false);
+            return;
+        }
+        if (idle_) {
+            beast::error_code ignored;
+            socket_.close(ignored);
+        }
+    }
+
+    void abort() override {
+        // Запись потокового ответа, которую ждёт воркер, завершится ошибкой — stop()
+        // не ждёт клиента, переставшего читать.
+        deadline_.cancel();
+        parked_ = false;
+        beast::error_code ignored;
+        socket_.close(ignored);
+    }
+
+private:
+    void do_read() {
+        if (state_->sessions->draining) {
+            do_close();
+            return;
+        }
+        parser_.emplace();
+        wheel_.schedule(deadline_, state_->options.idleTimeout);
+        if (buffer_.size() != 0) {
+            // Клиент прислал следующий запрос вместе с предыдущим (pipelining).
+            on_readable({});
+            return;
+        }
+        // Keep-alive: ждём первый байт следующего запроса, ничего не читая —
+        // до него соединение просто простаивает.
+        idle_ = true;
+        socket_.async_wait(tcp::socket::wait_read,
+                           beast::bind_front_handler(&HttpSession::on_readable, shared_from_this()));
+    }
+
+    void on_readable(beast::error_code ec) {
+        idle_ = false;
+        if (ec) {
+            deadline_.cancel();
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "HTTP connection error: " << ec.message() << std::endl;
+            }
+            return;
+        }
+        // Запрос начался: заголовки должны прийти целиком за headerTimeout.
+        wheel_.schedule(deadline_, state_->options.headerTimeout);
+        http::async_read_header(socket_, buffer_, *parser_,
+                                beast::bind_front_handler(&HttpSession::on_header, shared_from_this()));
+    }
+
+    void on_header(beast::error_code ec, std::size_t bytes) {
+        // Срок запроса отсчитывается от заголовков: чтение тела и очередь к воркеру
+        // входят в бюджет маршрута.
+        received_ = RequestDeadline::Clock::now();
+        if (!ec && !admit()) {
+            return;
+        }
+        if (ec || parser_->is_done()) {
+            on_read(ec, bytes);
+            return;
+        }
+        wheel_.schedule(deadline_, state_->options.idleTimeout);
+        http::async_read(socket_, buffer_, *parser_,
+                         beast::bind_front_handler(&HttpSession::on_read, shared_from_this()));
+    }
+
+    void on_deadline() {
+        beast::error_code ignored;
+        socket_.close(ignored);
+    }
+
+    bool admit() {
+        // Лимит класса маршрута проверяется по заголовкам: лишний запрос получает 503
+        // до чтения тела и не встаёт в очередь воркеров. WebSocket не ограничивается —
+        // соединение держит io-поток, а не воркер.
+        if (!state_->admission) {
+            return true;
+        }
+        const std::string_view target(parser_->get().target().data(), parser_->get().target().size());
+        const auto path = target.substr(0, target.find('?'));
+        if (state_->connections && path == state_->options.websocketPath) {
+            return true;
+        }
+        limiter_ = state_->admission->limiter_for(path);
+        if (!limiter_ || limiter_->try_acquire()) {
+            return true;
+        }
+        limiter_ = nullptr;
+        HttpResponse hresp;
+        hresp.status_code = 503;
+        hresp.headers.emplace("Retry-After", std::to_string(state_->admission->retry_after().count()));
+        hresp.body = R"({"error":"overloaded"})";
+        // Непрочитанное тело осталось бы в сокете перед следующим запросом — такое
+        // соединение закрываем. Запрос без тела соединение не портит.
+        const bool keepAlive = parser_->is_done() && parser_->get().keep_alive();
+        write_response(hresp, parser_->get().version(), keepAlive);
+        return false;
+    }
+
+    void release_limit() {
+        // Выполняется в воркере, когда ответ готов: задержка от чтения запроса
+        // (включая очередь воркеров) до ответа — сигнал для лимита.
+        if (limiter_) {
+            limiter_->release(AdaptiveLimiter::Clock::now() - readAt_);
+            limiter_ = nullptr;
+        }
+    }
+
+    void on_read(beast::error_code ec, std::size_t) {
+        if (ec && limiter_) {
+            // Тело не дочитано (клиент ушёл, истёк срок) — место в лимите свободно.
+            limiter_->release_dropped();
+            limiter_ = nullptr;
+        }
+        if (ec == http::error::end_of_stream) {
+            // Клиент закрыл соединение между запросами — это штатная ситуация.
+            do_close();
+            return;
+        }
+        if (ec) {
+            deadline_.cancel();
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "HTTP connection error: " << ec.message() << std::endl;
+            }
+            return;
+        }
+        deadline_.cancel();
+        readAt_ = AdaptiveLimiter::Clock::now();
+        req_ = parser_->release();
+
+        if (state_->connections && websocket::is_upgrade(req_)) {
+            HttpRequest hreq;
+            hreq.target = std::string(req_.target());
+            if (hreq.path() == state_->options.websocketPath) {
+                upgrade(hreq);
+                return;
+            }
+        }
+
+        // Обработчик может блокироваться (БД, PBKDF2) — уходим в пул воркеров.
+        // Срок на время обработки снят (выше): это не простой клиента.
+        auto self = shared_from_this();
+        if (!state_->workers->post([self] { self->handle_request(); })) {
+            // Пул остановлен — сервер завершается.
+            do_close();
+        }
+    }
+
+    void upgrade(const HttpRequest& hreq) {
+        std::int64_t userId = 0;
+        auto user = hreq.query_param("user");
+        if (user) {
+            auto [ptr, ec] = std::from_chars(user->data(), user->data() + user->size(), userId);
+            if (ec != std::errc{} || ptr != user->data() + user->size()) {
+                userId = 0;
+            }
+        }
+        if (userId <= 0) {
+            HttpResponse hresp;
+            hresp.status_code = 400;
+            hresp.body = R"({"error":"invalid request: user (int) required"})";
+            write_response(hresp, req_.version(), false);
+            return;
+        }
+        const auto batch = hreq.query_param("batch");
+        // Сокет переходит WebSocket-сессии; HTTP-сессия на этом заканчивается.
+        const auto executor = *socket_.get_executor().target<net::io_context::executor_type>();
+        make_session<WebSocketSession>(executor, std::move(socket_), state_, wheel_, userId, batch && *batch == "1")
+            ->run(std::move(req_));
+    }
+
+    void handle_request() {
+        // Выполняется в воркере. Сокет в это время никто больше не трогает:
+        // io-поток вернётся к соединению только после post() ниже.
+        const unsigned version = req_.version();
+        const bool keepAlive = req_.keep_alive() && !state_->sessions->draining;
+        const HttpRequest hreq = to_http_request(req_);
+        HttpResponse hresp;
+        const auto budget = request_budget(state_->options, hreq);
+        if (budget.count() > 0) {
+            // Срок виден репозиториям через RequestDeadline: statement_timeout,
+            // отмена зависших запросов, ожидание пула. Превышение — 504, что бы ни
+            // вернул обработчик.
+            RequestDeadline::Scope scope(received_ + budget);
+            if (RequestDeadline::Clock::now() >= received_ + budget) {
+                // Запрос простоял в очереди воркеров дольше бюджета — клиент уже
+                // не ждёт ответа, обработчик не запускаем.
+                RequestDeadline::mark_exceeded();
+            } else {
+                hresp = route_safely(*state_->router, hreq);
+            }
+            if (scope.exceeded()) {
+                hresp = deadline_exceeded_response();
+            }
+        } else {
+            hresp = route_safely(*state_->router, hreq);
+        }
+        if (!hresp.stream_body) {
+            release_limit();
+        }
+
+        if (hresp.deferred) {
+            defer(hresp.deferred, version, keepAlive);
+            return;
+        }
+
+        if (hresp.stream_body) {
+            // Тело производится здесь же, в воркере, по частям; пишет их io-поток
+            // (write_from_worker).
+            const bool ok = write_stream(hresp, version, keepAlive);
+            release_limit();
+            auto self = shared_from_this();
+            net::post(socket_.get_executor(), [self, ok, keepAlive] {
+                if (ok && keepAlive) {
+                    self->do_read();
+                } else {
+                    self->do_close();
+                }
+            });
+            return;
+        }
+
+        net::post(socket_.get_executor(),
+                  [self = shared_from_this(), hresp = std::move(hresp), version, keepAlive] {
+                      self->write_response(hresp, version, keepAlive);
+                  });
+    }
+
+    void defer(const std::function<void(ResponseSink)>& deferred, unsigned version, bool keepAlive) {
+        // Выполняется в воркере. Сначала io-поток «паркует» соединение, затем ответ
+        // может прийти: post'ы в один io_context выполняются по порядку, поэтому
+        // park() всегда отработает раньше resume().
+        auto self = shared_from_this();
+        net::post(socket_.get_executor(), [self] { self->park(); });
+        std::weak_ptr<HttpSession> weak = self;
+        ResponseSink sink = [gate = state_->deferred, weak, version, keepAlive](HttpResponse hresp) {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            if (!gate->open) {
+                return;
+            }
+            if (auto session = weak.lock()) {
+                net::post(session->socket_.get_executor(),
+                          [session, hresp = std::move(hresp), version, keepAlive] {
+                              session->resume(hresp, version, keepAlive);
+                          });
+            }
+        };
+        try {
+            deferred(sink);
+        } catch (const std::exception& ex) {
+            std::cerr << "Deferred response exception: " << ex.what() << std::endl;
+            HttpResponse hresp;
+            hresp.status_code = 500;
+            hresp.body = R"({"error":"internal server error"})";
+            sink(std::move(hresp));
+        }
+    }
+
+    void park() {
+        // Ответа ещё нет, потока на соединение тоже нет. Ожидание сокета держит
+        // сессию живой (её не держит никто, кроме sink'а по weak_ptr) и замечает
+        // клиента, закрывшего соединение, не дождавшись ответа.
+        parked_ = true;
+        socket_.async_wait(tcp::socket::wait_read,
+                           beast::bind_front_handler(&HttpSession::on_parked_readable, shared_from_this()));
+    }
+
+    void on_parked_readable(beast::error_code ec) {
+        if (ec || !parked_) {
+            return;
+        }
+        char byte = 0;
+        beast::error_code peekEc;
+        const auto n = socket_.receive(net::buffer(&byte, 1), tcp::socket::message_peek, peekEc);
+        if (peekEc || n == 0) {
+            // Клиент ушёл: закрываем сокет, sink потом ничего не найдёт.
+            parked_ = false;
+            beast::error_code ignored;
+            socket_.close(ignored);
+            return;
+        }
+        // Клиент прислал следующий запрос, не дождавшись ответа (pipelining): он
+        // прочитается после ответа, а до тех пор ждём только ошибки сокета.
+        socket_.async_wait(tcp::socket::wait_error,
+                           beast::bind_front_handler(&HttpSession::on_parked_readable, shared_from_this()));
+    }
+
+    void resume(const HttpResponse& hresp, unsigned version, bool keepAlive) {
+        if (!parked_) {
+            return;
+        }
+        parked_ = false;
+        beast::error_code ignored;
+        socket_.cancel(ignored);
+        // Снимает ожидание парковки: его обработчик завершится с operation_aborted.
+        write_response(hresp, version, keepAlive);
+    }
+
+    bool write_stream(const HttpResponse& hresp, unsigned version, bool keepAlive) {
+        // Потоковый ответ: заголовки сразу, тело — chunk'ами по мере готовности.
+        http::response<http::empty_body> head;
+        head.version(version);
+        head.result(static_cast<http::status>(hresp.status_code));
+        head.set(http::field::content_type, "application/json");
+        for (const auto& [name, value] : hresp.headers) {
+            head.set(name, value);
+        }
+        head.keep_alive(keepAlive);
+        head.chunked(true);
+
+        try {
+            http::response_serializer<http::empty_body> sr{head};
+            write_from_worker([&](auto handler) { http::async_write_header(socket_, sr, std::move(handler)); });
+            hresp.stream_body([this](std::string_view chunk) {
+                if (!chunk.empty()) {
+                    const auto body = http::make_chunk(net::const_buffer(chunk.data(), chunk.size()));
+                    write_from_worker([&](auto handler) { net::async_write(socket_, body, std::move(handler)); });
+                }
+            });
+            const auto last = http::make_chunk_last();
+            write_from_worker([&](auto handler) { net::async_write(socket_, last, std::move(handler)); });
+        } catch (const beast::system_error& ex) {
+            if (!is_routine_disconnect(ex.code())) {
+                std::cerr << "Stream write error: " << ex.code().message() << std::endl;
+            }
+            return false;
+        } catch (const std::exception& ex) {
+            // Статус уже отправлен — сообщить об ошибке можно только
+            // оборванным ответом: закрываем соединение без последнего chunk'а.
+            std::cerr << "Stream body exception: " << ex.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Start>
+    void write_from_worker(Start start) {
+        // Выполняется в воркере: запись идёт в io-потоке под сроком deadline_, как
+        // у обычного ответа, а воркер ждёт её. Клиент, переставший читать, держит
+        // воркер не дольше idleTimeout: срок закроет сокет. Буферы живут в стеке
+        // воркера до конца ожидания.
+        auto done = std::make_shared<std::promise<beast::error_code>>();
+        auto result = done->get_future();
+        net::post(socket_.get_executor(), [self = shared_from_this(), &start, done] {
+            self->wheel_.schedule(self->deadline_, self->state_->options.idleTimeout);
+            start([self, done](beast::error_code ec, std::size_t) {
+                self->deadline_.cancel();
+                done->set_value(ec);
+            });
+        });
+        if (const auto ec = result.get()) {
+            throw beast::system_error(ec);
+        }
+    }
+
+    void write_response(const HttpResponse& hresp, unsigned version, bool keepAlive) {
+        // Конвертация HttpResponse → Beast response
+        auto res = std::make_shared<http::response<http::string_body>>();
+        res->version(version);
+        res->result(static_cast<http::status>(hresp.status_code));
+        res->set(http::field::content_type, "application/json");
+        for (const auto& [name, value] : hresp.headers) {
+            res->set(name, value);
+        }
+        res->keep_alive(keepAlive && !state_->sessions->draining);
+        // Повторяем решение клиента: HTTP/1.1 по умолчанию держит соединение,
+        // HTTP/1.0 и "Connection: close" — закрывают. При остановке сервера — закрываем.
+        res->body() = hresp.body;
+        res->prepare_payload();
+        // prepare_payload() автоматически выставляет Content-Length.
+
+        wheel_.schedule(deadline_, state_->options.idleTimeout);
+        http::async_write(socket_, *res,
+                          [self = shared_from_this(), res](beast::error_code ec, std::size_t) {
+                              self->on_write(ec, res->keep_alive());
+                          });
+    }
+
+    void on_write(beast::error_code ec, bool keepAlive) {
+        if (ec) {
+            deadline_.cancel();
+            if (!is_routine_disconnect(ec)) {
+                std::cerr << "HTTP write error: " << ec.message() << std::endl;
+            }
+            return;
+        }
+        if (!keepAlive) {
+            do_close();
+            return;
+        }
+        do_read();
+    }
+
+    void do_close() {
+        // Закрываем передачу после последнего запроса соединения
+        beast::error_code ec;
+        deadline_.cancel();
+        socket_.shutdown(tcp::socket::shutdown_send, ec);
+    }
+
+    tcp::socket socket_;
+    beast::flat_buffer buffer_;
+    // Буфер переиспользуется между запросами одного соединения.
+    std::optional<http::request_parser<http::string_body>> parser_;
+    // Парсер текущего запроса: заголовки и тело читаются раздельно, каждое со своим сроком.
+    http::request<http::string_body> req_;
+    std::shared_ptr<const ServerState> state_;
+    TimingWheel& wheel_;
+    WheelTimer deadline_;
+    RequestDeadline::Clock::time_point received_;
+    // Когда пришли заголовки текущего запроса — начало его срока (requestDeadline).
+    AdaptiveLimiter* limiter_ = nullptr;
+    // Лимит класса, в котором текущий запрос занимает место (admission).
+    AdaptiveLimiter::Clock::time_point readAt_;
+    // Когда запрос прочитан целиком — начало замера задержки для лимита.
+    bool parked_ = false;
+    // Ждём отложенного ответа (HttpResponse::deferred).
+    bool idle_ = false;
+    // Keep-alive соединение ждёт первого байта следующего запроса.
+};
+
+}
+
+struct HttpServer::Runtime {
+    std::vector<std::unique_ptr<TimingWheel>> wheels;
+    // Колесо таймеров каждого io-потока. Объявлено раньше contexts: сессии,
+    // уничтожаемые вместе с io_context'ами, снимают свои таймеры с колеса.
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    // По io_context на io-поток (concurrency hint 1 — без внутренних блокировок Asio).
+    std::vector<std::unique_ptr<net::steady_timer>> tickers;
+    // Единственный системный таймер io-потока: раз в timerTick проворачивает его колесо.
+    std::vector<net::executor_work_guard<net::io_context::executor_type>> guards;
+    std::unique_ptr<tcp::acceptor> acceptor;
+    std::unique_ptr<net::steady_timer> acceptRetry;
+    std::unique_ptr<net::signal_set> signals;
+    // SIGTERM/SIGINT для run(); nullptr — сервер запущен через start().
+    std::vector<std::thread> threads;
+    std::shared_ptr<const ServerState> state;
+    std::size_t nextContext = 0;
+
+    void tick(std::size_t index) {
+        auto& ticker = *tickers[index];
+        ticker.expires_after(state->options.timerTick);
+        ticker.async_wait([this, index](beast::error_code ec) {
+            if (ec) {
+                return;
+            }
+            wheels[index]->advance(TimingWheel::Clock::now());
+            tick(index);
+        });
+    }
+
+    void do_accept() {
+        // Новые соединения раскладываются по io_context'ам по кругу.
+        const std::size_t index = nextContext++ % contexts.size();
+        acceptor->async_accept(*contexts[index], [this, index](beast::error_code ec, tcp::socket socket) {
+            if (ec == net::error::operation_aborted) {
+                return;
+            }
+            if (ec) {
+                // Например, EMFILE: не крутимся в цикле ошибок, а ждём освобождения дескрипторов.
+                std::cerr << "HTTP accept error: " << ec.message() << std::endl;
+                acceptRetry->expires_after(std::chrono::milliseconds(50));
+                acceptRetry->async_wait([this](beast::error_code waitEc) {
+                    if (!waitEc) do_accept();
+                });
+                return;
+            }
+            make_session<HttpSession>(contexts[index]->get_executor(), std::move(socket), state, *wheels[index])->run();
+            do_accept();
+        });
+    }
+};
+
 HttpServer::HttpServer(const std::string& address,
                        int port,
-                       std::shared_ptr<HttpRouter> router)
+                       std::shared_ptr<HttpRouter> router,
+                       std::shared_ptr<realtime::ConnectionRegistry> connections,
+                       HttpServerOptions options,
+                       std::shared_ptr<concurrency::AdmissionControl> admission)
     : address_(address)
     , port_(port)
     , router_(std::move(router))
+    , connections_(std::move(connections))
+    , options_(std::move(options))
+    , admission_(std::move(admission))
 {}
 // Конструктор HTTP‑сервера.
 // address — IP, на котором слушаем (например, "0.0.0.0").
 // port — порт (например, 8080).
 // router — объект маршрутизатора, который будет обрабатывать запросы.
 
-void HttpServer::run() {
-    try {
-        net::io_context ioc{1};
-        // io_context — основной объект Asio, управляющий событиями ввода/вывода.
-        // {1} означает один поток обработки событий.
-        tcp::endpoint endpoint{
-            net::ip::make_address(address_),
-            // это функция Boost.Asio, которая перобразует строку с IP-адремом в объект boost::asio::ip::address
-            static_cast<unsigned short>(port_)
-        };
-        // Создаём TCP‑endpoint из адреса и порта.
-
-        tcp::acceptor acceptor{ioc, endpoint};
-        // acceptor — объект, который принимает входящие TCP‑соединения.
-
-        std::cout << "HttpServer listening on " << address_ << ":" << port_ << std::endl;
-
-        for (;;) {
-            // Основной цикл сервера: бесконечно принимаем соединения.
-            tcp::socket socket{ioc};
-            acceptor.accept(socket);
-            // Блокирующее ожидание входящего соединения.
-            // После accept() у нас есть socket для общения с клиентом.
-            std::thread([sock = std::move(socket), this]() mutable {
-                // Для каждого соединения создаём отдельный поток.
-                // В реальном продакшене лучше использовать thread pool.
+HttpServer::~HttpServer() {
+    stop();
+}
+
+void HttpServer::start() {
+    std::unique_lock<std::mutex> lock(lifecycleMutex_);
+    stopped_.wait(lock, [this] { return !stopping_; });
+    if (running_) {
+        return;
+    }
+
+    auto runtime = std::make_unique<Runtime>();
+    auto state = std::make_shared<ServerState>();
+    state->router = router_;
+    state->connections = connections_;
+    state->admission = admission_;
+    state->workers = std::make_shared<concurrency::ThreadPool>(options_.workerThreads);
+    state->deferred = std::make_shared<DeferredGate>();
+    state->sessions = std::make_shared<SessionTracker>();
+    state->options = options_;
+    runtime->state = state;
+
+    const std::size_t ioThreads = std::max<std::size_t>(1, options_.ioThreads);
+    for (std::size_t i = 0; i < ioThreads; ++i) {
+        runtime->wheels.push_back(std::make_unique<TimingWheel>(options_.timerTick));
+        runtime->contexts.push_back(std::make_unique<net::io_context>(1));
+        runtime->tickers.push_back(std::make_unique<net::steady_timer>(*runtime->contexts.back()));
+        runtime->guards.push_back(net::make_work_guard(*runtime->contexts.back()));
+        runtime->tick(i);
+    }
+
+    tcp::endpoint endpoint{
+        net::ip::make_address(address_),
+        // это функция Boost.Asio, которая перобразует строку с IP-адремом в объект boost::asio::ip::address
+        static_cast<unsigned short>(port_)
+    };
+    // Создаём TCP‑endpoint из адреса и порта.
+    runtime->acceptor = std::make_unique<tcp::acceptor>(*runtime->contexts.front());
+    runtime->acceptor->open(endpoint.protocol());
+    runtime->acceptor->set_option(net::socket_base::reuse_address(true));
+    runtime->acceptor->bind(endpoint);
+    runtime->acceptor->listen(net::socket_base::max_listen_connections);
+    // acceptor — объект, который принимает входящие TCP‑соединения.
+    port_ = runtime->acceptor->local_endpoint().port();
+    runtime->acceptRetry = std::make_unique<net::steady_timer>(*runtime->contexts.front());
+    runtime->do_accept();
+
+    for (auto& ctx : runtime->contexts) {
+        runtime->threads.emplace_back([ctx = ctx.get()] {
+            for (;;) {
                 try {
-                    beast::flat_buffer buffer;
-                    http::request<http::string_body> req;
-                    // Буфер и объект HTTP‑запроса Beast.
-
-                    // Читаем один HTTP‑запрос
-                    http::read(sock, buffer, req);
-
-                    // Debug: логируем заголовки и тело запроса (временно)
-                    std::cerr << "[HTTP] Request: " << req.method_string() << " " << req.target() << "\n";
-                    for (auto const& field : req) {
-                        std::cerr << "[HTTP] Header: " << std::string(field.name_string())
-                                  << ": " << std::string(field.value()) << "\n";
-                    }
-                    std::cerr << "[HTTP] Body length: " << req.body().size() << "\n";
-                    std::cerr << "[HTTP] Body raw: [" << req.body() << "]\n";
-
-                    // Конвертация Beast → HttpRequest
-                    HttpRequest hreq;
-                    hreq.method = std::string(req.method_string());
-                    hreq.target = std::string(req.target());
-                    hreq.body   = req.body();
-
-                    for (auto const& field : req) {
-                        hreq.headers.emplace(
-                            std::string(field.name_string()),
-                            std::string(field.value())
-                        );
-                    }
-
-                    // Маршрутизация
-                    // Передаём запрос в роутер.
-                    HttpResponse hresp;
-                    try {
-                        hresp = router_->route(hreq);
-                    } catch (const std::exception& ex) {
-                        // Если обработчик маршрута упал — возвращаем 500.
-                        std::cerr << "Router exception: " << ex.what() << std::endl;
-                        hresp.status_code = 500;
-                        hresp.body = R"({"error":"internal server error"})";
-                    }
-
-                    // Конвертация HttpResponse → Beast response
-                    http::response<http::string_body> res;
-                    res.version(req.version());
-                    res.result(static_cast<http::status>(hresp.status_code));
-                    res.set(http::field::content_type, "application/json");
-
-                    // Если у тебя в HttpResponse есть headers — можно проставить их здесь
-                    for (const auto& [name, value] : hresp.headers) {
-                        res.set(name, value);
-                    }
-
-                    res.body() = hresp.body;
-                    res.prepare_payload();
-                    // prepare_payload() автоматически выставляет Content-Length.
-
-                    http::write(sock, res);
-                    // Отправляем ответ клиенту.
-
-                    // Закрываем соединение после одного запроса
-                    beast::error_code ec;
-                    sock.shutdown(tcp::socket::shutdown_send, ec);
-                }
-                catch (const std::exception& e) {
-                    std::cerr << "HTTP connection error: " << e.what() << std::endl;
+                    ctx->run();
+                    return;
+                } catch (const std::exception& e) {
+                    // Исключение из обработчика не должно останавливать io-поток.
+                    std::cerr << "HTTP Server error: " << e.what() << std::endl;
                 }
-            }).detach();
-            // detach() — поток работает сам по себе.
-            // В продакшене лучше использовать пул потоков, а не detach().
-        }
+            }
+        });
+    }
+
+    std::cout << "HttpServer listening on " << address_ << ":" << port_
+              << " (io threads: " << ioThreads << ", workers: " << state->workers->size() << ")" << std::endl;
+    runtime_ = std::move(runtime);
+    running_ = true;
+    shutdownRequested_ = false;
+}
+
+void HttpServer::run() {
+    try {
+        start();
     }
     catch (const std::exception& e) {
         std::cerr << "HTTP Server error: " << e.what() << std::endl;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(lifecycleMutex_);
+    if (running_) {
+        runtime_->signals = std::make_unique<net::signal_set>(*runtime_->contexts.front(), SIGINT, SIGTERM);
+        runtime_->signals->async_wait([this](beast::error_code ec, int signal) {
+            if (ec) {
+                return;
+            }
+            std::cout << "HttpServer: signal " << signal << ", shutting down" << std::endl;
+            {
+                std::lock_guard<std::mutex> signalLock(lifecycleMutex_);
+                shutdownRequested_ = true;
+            }
+            stopped_.notify_all();
+        });
+    }
+    // Остановка, начатая другим потоком (stop()), дожидается до конца: после возврата
+    // из run() io-потоки уже остановлены.
+    stopped_.wait(lock, [this] { return !stopping_ && (!running_ || shutdownRequested_); });
+    if (!running_) {
+        return;
     }
+    lock.unlock();
+    // Остановка — здесь, а не в обработчике сигнала: shutdown() ждёт io-потоки.
+    shutdown(options_.drainTimeout);
 }
 
-} // namespace chatserver::infrastructure::http
+void HttpServer::shutdown(std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::shared_ptr<const ServerState> state;
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        if (!running_) {
+            return;
+        }
+        state = runtime_->state;
+        state->sessions->draining = true;
+        net::post(*runtime_->contexts.front(), [rt = runtime_.get()] {
+            beast::error_code ec;
+            rt->acceptor->close(ec);
+            rt->acceptRetry->cancel();
+        });
+    }
+    state->sessions->drain_all();
+    const auto left = state->sessions->wait_empty(deadline);
+    if (left != 0) {
+        std::cerr << "[WARN] HttpServer: " << left << " connections still open after "
+                  << timeout.count() << " ms, closing" << std::endl;
+    }
+    stop();
+    std::cout << "HttpServer stopped" << std::endl;
+}
+
+void HttpServer::stop() {
+    std::unique_ptr<Runtime> runtime;
+    {
+        std::unique_lock<std::mutex> lock(lifecycleMutex_);
+        if (!running_) {
+            // Сервер уже остановлен или его останавливает другой поток — ждём конца.
+            stopped_.wait(lock, [this] { return !stopping_; });
+            return;
+        }
+        // running_ сбрасывается вместе с изъятием runtime_: параллельный shutdown()
+        // видит остановленный сервер, а не пустой runtime_.
+        running_ = false;
+        stopping_ = true;
+        runtime = std::move(runtime_);
+    }
 
+    {
+        // Отложенные ответы, пришедшие после этой точки, отбрасываются.
+        std::lock_guard<std::mutex> gateLock(runtime->state->deferred->mutex);
+        runtime->state->deferred->open = false;
+    }
+    // Acceptor принадлежит первому io-потоку — закрываем его там же.
+    net::post(*runtime->contexts.front(), [rt = runtime.get()] {
+        beast::error_code ec;
+        rt->acceptor->close(ec);
+        rt->acceptRetry->cancel();
+    });
+    // Оставшиеся соединения рвутся, пока io-потоки ещё работают: воркер, ждущий
+    // записи потокового ответа, получает ошибку, а не держит stop().
+    runtime->state->sessions->abort_all();
+    // Воркеры доделывают начатые запросы; их ответы ставятся в io_context'ы.
+    runtime->state->workers->stop();
+    for (auto& guard : runtime->guards) {
+        guard.reset();
+    }
+    for (auto& ctx : runtime->contexts) {
+        ctx->stop();
+    }
+    for (auto& thread : runtime->threads) {
+        thread.join();
+    }
+    // Сессии, ещё ждущие ввода-вывода, уничтожаются вместе с io_context'ами.
+    runtime.reset();
+
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        stopping_ = false;
+    }
+    stopped_.notify_all();
+}
+
+unsigned short HttpServer::port() const {
+    return static_cast<unsigned short>(port_);
+}
+
+std::size_t HttpServer::open_connections() const {
+    std::shared_ptr<const ServerState> state;
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex_);
+        if (!runtime_) {
+            return 0;
+        }
+        state = runtime_->state;
+    }
+    std::lock_guard<std::mutex> lock(state->sessions->mutex);
+    return state->sessions->sessions.size();
+}
+
+bool HttpServer::handling_signals() const {
+    std::lock_guard<std::mutex> lock(lifecycleMutex_);
+    return runtime_ && runtime_->signals;
+}
+
+} // namespace chatserver::infrastructure::http
@@ -0,0 +1,77 @@
+#include "chatserver/infrastructure/http/message_cursor.h"
+
+#include <array>
+
+namespace chatserver::infrastructure::http {
+
+namespace {
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+constexpr std::uint8_t kCursorVersion = 1;
+constexpr std::size_t kRawSize = 9;
+// u8 version + u64 id (big-endian)
+constexpr std::size_t kEncodedSize = kRawSize / 3 * 4;
+
+int decode_char(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '-') return 62;
+    if (c == '_') return 63;
+    return -1;
+}
+
+}
+
+std::string encode_message_cursor(std::int64_t beforeId) {
+    std::array<std::uint8_t, kRawSize> raw{};
+    raw[0] = kCursorVersion;
+    const auto value = static_cast<std::uint64_t>(beforeId);
+    for (int i = 0; i < 8; ++i) {
+        raw[1 + i] = static_cast<std::uint8_t>(value >> (56 - 8 * i));
+    }
+
+    std::string out;
+    out.reserve(kEncodedSize);
+    for (std::size_t i = 0; i < kRawSize; i += 3) {
+        const std::uint32_t triple = (raw[i] << 16) | (raw[i + 1] << 8) | raw[i + 2];
+        out.push_back(kAlphabet[(triple >> 18) & 0x3F]);
+        out.push_back(kAlphabet[(triple >> 12) & 0x3F]);
+        out.push_back(kAlphabet[(triple >> 6) & 0x3F]);
+        out.push_back(kAlphabet[triple & 0x3F]);
+    }
+    return out;
+}
+
+std::optional<std::int64_t> decode_message_cursor(std::string_view cursor) {
+    if (cursor.size() != kEncodedSize) {
+        return std::nullopt;
+    }
+    std::array<std::uint8_t, kRawSize> raw{};
+    for (std::size_t i = 0, o = 0; i < kEncodedSize; i += 4, o += 3) {
+        std::uint32_t triple = 0;
+        for (std::size_t k = 0; k < 4; ++k) {
+            const int v = decode_char(cursor[i + k]);
+            if (v < 0) return std::nullopt;
+            triple = (triple << 6) | static_cast<std::uint32_t>(v);
+        }
+        raw[o] = static_cast<std::uint8_t>(triple >> 16);
+        raw[o + 1] = static_cast<std::uint8_t>(triple >> 8);
+        raw[o + 2] = static_cast<std::uint8_t>(triple);
+    }
+    if (raw[0] != kCursorVersion) {
+        return std::nullopt;
+    }
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | raw[1 + i];
+    }
+    const auto id = static_cast<std::int64_t>(value);
+    if (id <= 0) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+}
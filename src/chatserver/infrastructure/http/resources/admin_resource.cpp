@@ -0,0 +1,314 @@
+// src/chatserver/infrastructure/http/resources/admin_resource.cpp
+#include "chatserver/infrastructure/http/resources/admin_resource.h"
+#include "chatserver/infrastructure/http/http_response.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
+
+#include "chatserver/nlohmann/json.hpp"
+#include <charconv>
+
+using json = nlohmann::json;
+
+namespace chatserver::infrastructure::http::resources {
+
+AdminResource::AdminResource(std::shared_ptr<chatserver::infrastructure::realtime::ConnectionRegistry> connections,
+                             std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> longPoll,
+                             std::shared_ptr<chatserver::infrastructure::cache::ConversationCache> conversationCache,
+                             std::shared_ptr<chatserver::infrastructure::repository::CachingUserRepository> userCache,
+                             std::shared_ptr<chatserver::infrastructure::cache::UsernameFilter> usernameFilter,
+                             std::shared_ptr<chatserver::infrastructure::cache::IdempotencyTable> idempotency,
+                             std::shared_ptr<chatserver::infrastructure::repository::OutboxMessageRepository> outbox,
+                             std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer> partitions,
+                             std::shared_ptr<chatserver::infrastructure::repository::ShardedMessageRepository> sharded,
+                             std::vector<std::shared_ptr<chatserver::infrastructure::repository::PgConnectionPool>> shardPools,
+                             std::vector<std::shared_ptr<chatserver::infrastructure::repository::MessagePartitionMaintainer>> shardPartitions,
+                             std::shared_ptr<chatserver::infrastructure::repository::PgReplicaRouter> replicas,
+                             std::shared_ptr<chatserver::infrastructure::concurrency::AdmissionControl> admission)
+    : connections_(std::move(connections))
+    , longPoll_(std::move(longPoll))
+    , conversationCache_(std::move(conversationCache))
+    , userCache_(std::move(userCache))
+    , usernameFilter_(std::move(usernameFilter))
+    , idempotency_(std::move(idempotency))
+    , outbox_(std::move(outbox))
+    , partitions_(std::move(partitions))
+    , sharded_(std::move(sharded))
+    , shardPools_(std::move(shardPools))
+    , shardPartitions_(std::move(shardPartitions))
+    , replicas_(std::move(replicas))
+    , admission_(std::move(admission)) {}
+
+void AdminResource::register_routes(chatserver::infrastructure::http::HttpRouter& router) {
+    auto connections = connections_;
+    auto longPoll = longPoll_;
+    router.add_route("GET", "/admin/presence", [connections, longPoll](const auto& req) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        if (auto user = req.query_param("user")) {
+            std::int64_t userId = 0;
+            auto [ptr, ec] = std::from_chars(user->data(), user->data() + user->size(), userId);
+            if (ec != std::errc{} || ptr != user->data() + user->size() || userId <= 0) {
+                json res{{"error", "invalid request: user (int) required"}};
+                return HttpResponse{400, res.dump()};
+            }
+            const auto count = connections->connections_of(userId);
+            json res{{"user_id", userId}, {"online", count > 0}, {"connections", count}};
+            return HttpResponse{200, res.dump()};
+        }
+
+        const auto stats = connections->stats();
+        json res{
+            {"online_users", stats.onlineUsers},
+            {"connections", stats.connections},
+            {"went_online", stats.wentOnline},
+            {"went_offline", stats.wentOffline},
+            {"rejected", stats.rejected},
+            {"shards", stats.shards},
+        };
+        const auto out = connections->outbound().snapshot();
+        res["outbound"] = {
+            {"frames_queued", out.framesQueued},
+            {"frames_written", out.framesWritten},
+            {"write_calls", out.writeCalls},
+            {"bytes_written", out.bytesWritten},
+            {"frames_dropped", out.framesDropped},
+            {"slow_consumers", out.slowConsumers},
+            {"slow_consumers_disconnected", out.slowConsumersDisconnected},
+        };
+        if (longPoll) {
+            const auto lp = longPoll->stats();
+            res["long_poll"] = {
+                {"mailboxes", lp.mailboxes},
+                {"parked", lp.parked},
+                {"immediate", lp.immediate},
+                {"woken", lp.woken},
+                {"timed_out", lp.timedOut},
+                {"superseded", lp.superseded},
+            };
+        }
+        return HttpResponse{200, res.dump()};
+    });
+
+    auto conversationCache = conversationCache_;
+    auto userCache = userCache_;
+    auto usernameFilter = usernameFilter_;
+    auto idempotency = idempotency_;
+    router.add_route("GET", "/admin/cache", [conversationCache, userCache, usernameFilter, idempotency](const auto&) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        json res{{"conversations", nullptr}, {"users", nullptr}, {"username_filter", nullptr},
+                 {"idempotency", nullptr}};
+        if (conversationCache) {
+            const auto s = conversationCache->stats();
+            const auto lookups = s.hits + s.misses;
+            res["conversations"] = {
+                {"hits", s.hits},
+                {"misses", s.misses},
+                {"hit_ratio", lookups == 0 ? 0.0 : static_cast<double>(s.hits) / static_cast<double>(lookups)},
+                {"fills", s.fills},
+                {"appends", s.appends},
+                {"evictions", s.evictions},
+                {"expired", s.expired},
+                {"cached", s.conversations},
+                {"messages", s.messages},
+                {"bytes", s.bytes},
+                {"budget_bytes", s.budgetBytes},
+            };
+        }
+        if (userCache) {
+            const auto s = userCache->stats();
+            const auto lookups = s.hits + s.misses + s.coalesced;
+            res["users"] = {
+                {"hits", s.hits},
+                {"negative_hits", s.negativeHits},
+                {"misses", s.misses},
+                {"coalesced", s.coalesced},
+                {"hit_ratio", lookups == 0 ? 0.0 : static_cast<double>(s.hits) / static_cast<double>(lookups)},
+                {"evictions", s.evictions},
+                {"expired", s.expired},
+                {"invalidations", s.invalidations},
+                {"entries", s.entries},
+                {"capacity", s.capacity},
+                {"bytes", s.bytes},
+            };
+        }
+        if (usernameFilter) {
+            const auto s = usernameFilter->stats();
+            res["username_filter"] = {
+                {"items", s.items},
+                {"checks", s.checks},
+                {"definitely_absent", s.definitelyAbsent},
+                {"false_positives", s.falsePositives},
+                {"estimated_fpr", s.estimatedFpr},
+                {"bits", s.bits},
+                {"hashes", s.hashes},
+                {"bytes", s.bytes},
+            };
+        }
+        if (idempotency) {
+            const auto s = idempotency->stats();
+            res["idempotency"] = {
+                {"executed", s.executed},
+                {"replayed", s.replayed},
+                {"coalesced", s.coalesced},
+                {"mismatches", s.mismatches},
+                {"evictions", s.evictions},
+                {"expired", s.expired},
+                {"entries", s.entries},
+                {"capacity", s.capacity},
+                {"bytes", s.bytes},
+            };
+        }
+        return HttpResponse{200, res.dump()};
+    });
+
+    auto outbox = outbox_;
+    auto partitions = partitions_;
+    auto sharded = sharded_;
+    auto shardPools = shardPools_;
+    auto shardPartitions = shardPartitions_;
+    auto replicas = replicas_;
+    router.add_route("GET", "/admin/storage", [outbox, partitions, sharded, shardPools, shardPartitions, replicas](const auto&) {
+        using chatserver::infrastructure::http::HttpResponse;
+        using chatserver::infrastructure::repository::PartitionInterval;
+        using chatserver::infrastructure::repository::MessagePartitionMaintainer;
+        using chatserver::infrastructure::repository::PgPoolStats;
+        using chatserver::infrastructure::repository::ReplicaPolicy;
+
+        auto partitionsJson = [](const MessagePartitionMaintainer& maintainer) {
+            const auto s = maintainer.stats();
+            return json{
+                {"interval", maintainer.options().interval == PartitionInterval::Daily ? "daily" : "monthly"},
+                {"partitions", s.partitions},
+                {"covered_until", s.coveredUntilUnix},
+                {"runs", s.runs},
+                {"created", s.created},
+                {"dropped", s.dropped},
+                {"failures", s.failures},
+                {"last_run", s.lastRunUnix},
+                {"last_error", s.lastError},
+            };
+        };
+
+        auto poolJson = [](const PgPoolStats& p) {
+            return json{
+                {"opened", p.opened},
+                {"reused", p.reused},
+                {"waits", p.waits},
+                {"timeouts", p.timeouts},
+                {"broken", p.broken},
+                {"idle", p.idle},
+                {"leased", p.leased},
+            };
+        };
+
+        json res{{"outbox", nullptr}, {"partitions", nullptr}, {"shards", nullptr}, {"replicas", nullptr}};
+        if (outbox) {
+            const auto s = outbox->stats();
+            res["outbox"] = {
+                {"appended", s.appended},
+                {"fsyncs", s.fsyncs},
+                {"replayed", s.replayed},
+                {"drained", s.drained},
+                {"duplicates", s.duplicates},
+                {"batches", s.batches},
+                {"failures", s.failures},
+                {"rejected", s.rejected},
+                {"throttled", s.throttled},
+                {"pending", s.pending},
+                {"segments", s.segments},
+                {"oldest_pending_ms", s.oldestPendingMs},
+                {"failed", s.failed},
+            };
+        }
+        if (partitions) {
+            res["partitions"] = partitionsJson(*partitions);
+        }
+        if (sharded) {
+            const auto s = sharded->stats();
+            const auto share = sharded->ring().ownership();
+            json list = json::array();
+            for (std::size_t i = 0; i < s.shards.size(); ++i) {
+                json shard{
+                    {"name", s.shards[i].name},
+                    {"share", share[i]},
+                    {"saves", s.shards[i].saves},
+                    {"reads", s.shards[i].reads},
+                    {"failures", s.shards[i].failures},
+                    {"pool", nullptr},
+                    {"partitions", nullptr},
+                };
+                if (i < shardPools.size()) {
+                    shard["pool"] = poolJson(shardPools[i]->stats());
+                }
+                if (i < shardPartitions.size()) {
+                    shard["partitions"] = partitionsJson(*shardPartitions[i]);
+                }
+                list.push_back(std::move(shard));
+            }
+            res["shards"] = {
+                {"fanout_reads", s.fanoutReads},
+                {"moves", chatserver::infrastructure::sharding::format_shard_moves(sharded->ring().moves())},
+                {"list", std::move(list)},
+            };
+        }
+        if (replicas) {
+            const auto s = replicas->stats();
+            json list = json::array();
+            for (const auto& r : s.replicas) {
+                list.push_back({
+                    {"name", r.name},
+                    {"lag_ms", r.lagMs ? json(*r.lagMs) : json(nullptr)},
+                    {"usable", r.usable},
+                    {"reads", r.reads},
+                    {"failures", r.failures},
+                });
+            }
+            res["replicas"] = {
+                {"policy", replicas->options().policy == ReplicaPolicy::LeastLoaded ? "least_loaded" : "round_robin"},
+                {"primary_reads", s.primaryReads},
+                {"sticky_reads", s.stickyReads},
+                {"lag_fallbacks", s.lagFallbacks},
+                {"sticky_keys", s.stickyKeys},
+                {"primary_pool", poolJson(replicas->primary_stats())},
+                {"list", std::move(list)},
+            };
+        }
+        const auto requests = chatserver::infrastructure::concurrency::RequestDeadline::stats();
+        const auto queries = chatserver::infrastructure::repository::PgQueryDeadline::stats();
+        res["deadlines"] = {
+            {"requests", requests.requests},
+            {"exceeded", requests.exceeded},
+            {"queries", queries.armed},
+            {"statement_timeouts", queries.statementTimeouts},
+            {"cancelled", queries.cancelled},
+            {"expired_before_query", queries.expiredBeforeQuery},
+            {"pool_wait_expired", queries.poolWaitExpired},
+        };
+        return HttpResponse{200, res.dump()};
+    });
+
+    auto admission = admission_;
+    router.add_route("GET", "/admin/limits", [admission](const auto&) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        json res{{"enabled", admission != nullptr}, {"retry_after_s", nullptr}, {"classes", json::array()}};
+        if (admission) {
+            res["retry_after_s"] = admission->retry_after().count();
+            for (const auto& c : admission->stats()) {
+                res["classes"].push_back({
+                    {"name", c.name},
+                    {"limit", c.limiter.limit},
+                    {"in_flight", c.limiter.inFlight},
+                    {"admitted", c.limiter.admitted},
+                    {"shed", c.limiter.shed},
+                    {"min_rtt_us", c.limiter.minRttUs},
+                    {"sample_rtt_us", c.limiter.sampleRttUs},
+                });
+            }
+        }
+        return HttpResponse{200, res.dump()};
+    });
+}
+
+}
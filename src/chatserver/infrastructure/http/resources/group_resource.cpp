@@ -0,0 +1,94 @@
+// src/chatserver/infrastructure/http/resources/group_resource.cpp
+#include "chatserver/infrastructure/http/resources/group_resource.h"
+#include "chatserver/infrastructure/http/http_response.h"
+
+#include "chatserver/nlohmann/json.hpp"
+#include <iostream>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace chatserver::infrastructure::http::resources {
+
+GroupResource::GroupResource(std::shared_ptr<chatserver::application::CreateGroupHandler> createHandler,
+                             std::shared_ptr<chatserver::application::SendGroupMessageHandler> sendHandler)
+    : createHandler_(std::move(createHandler))
+    , sendHandler_(std::move(sendHandler)) {}
+
+void GroupResource::register_routes(chatserver::infrastructure::http::HttpRouter& router) {
+    auto handler = createHandler_;
+    router.add_route("POST", "/groups", [handler](const auto& req) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        json j = json::parse(req.body, nullptr, false);
+        if (j.is_discarded() || !j.is_object() || !j.contains("members") || !j["members"].is_array()) {
+            json res{{"error", "invalid request: members (array of int) required"}};
+            return HttpResponse{400, res.dump()};
+        }
+
+        chatserver::application::CreateGroupCommand cmd;
+        cmd.member_ids.reserve(j["members"].size());
+        for (const auto& member : j["members"]) {
+            if (!member.is_number_integer()) {
+                json res{{"error", "invalid request: members (array of int) required"}};
+                return HttpResponse{400, res.dump()};
+            }
+            cmd.member_ids.push_back(member.get<std::int64_t>());
+        }
+
+        try {
+            json res{{"id", handler->handle(cmd)}};
+            return HttpResponse{200, res.dump()};
+        } catch (const std::invalid_argument& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{400, res.dump()};
+        } catch (const std::exception& ex) {
+            std::cerr << "[GroupResource] /groups exception: " << ex.what() << std::endl;
+            json res{{"error", "internal server error"}};
+            return HttpResponse{500, res.dump()};
+        }
+    });
+
+    auto sender = sendHandler_;
+    router.add_route("POST", "/send_group_message", [sender](const auto& req) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        json j = json::parse(req.body, nullptr, false);
+        if (j.is_discarded() || !j.is_object()) {
+            json res{{"error", "invalid json"}};
+            return HttpResponse{400, res.dump()};
+        }
+        if (!j.contains("sender_id") || !j.contains("group_id") || !j.contains("text") ||
+            !j["sender_id"].is_number_integer() || !j["group_id"].is_number_integer() ||
+            !j["text"].is_string()) {
+            json res{{"error", "invalid request: sender_id (int), group_id (int) and text (string) required"}};
+            return HttpResponse{400, res.dump()};
+        }
+
+        chatserver::application::SendGroupMessageCommand cmd{
+            j["sender_id"].get<std::int64_t>(),
+            j["group_id"].get<std::int64_t>(),
+            j["text"].get<std::string>()
+        };
+
+        try {
+            json res{{"id", sender->handle(cmd)}};
+            return HttpResponse{200, res.dump()};
+        } catch (const chatserver::infrastructure::repository::NotGroupMemberError& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{403, res.dump()};
+        } catch (const chatserver::infrastructure::repository::GroupNotFoundError& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{404, res.dump()};
+        } catch (const std::invalid_argument& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{400, res.dump()};
+        } catch (const std::exception& ex) {
+            std::cerr << "[GroupResource] /send_group_message exception: " << ex.what() << std::endl;
+            json res{{"error", "internal server error"}};
+            return HttpResponse{500, res.dump()};
+        }
+    });
+}
+
+} // namespace chatserver::infrastructure::http::resources
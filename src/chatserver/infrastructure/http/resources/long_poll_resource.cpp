@@ -0,0 +1,87 @@
+// src/chatserver/infrastructure/http/resources/long_poll_resource.cpp
+#include "chatserver/infrastructure/http/resources/long_poll_resource.h"
+#include "chatserver/infrastructure/http/http_response.h"
+
+#include "chatserver/nlohmann/json.hpp"
+#include <algorithm>
+#include <charconv>
+#include <optional>
+
+using json = nlohmann::json;
+
+namespace chatserver::infrastructure::http::resources {
+
+namespace {
+
+std::optional<std::int64_t> parse_int(const std::string& s) {
+    std::int64_t value = 0;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc{} || ptr != s.data() + s.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+constexpr std::int64_t kDefaultTimeoutSeconds = 30;
+
+chatserver::infrastructure::http::HttpResponse to_response(const chatserver::infrastructure::realtime::LongPollResult& result) {
+    // Кадры уже сериализованы для WebSocket — вклеиваем их в массив как есть.
+    std::string body = R"({"messages":[)";
+    for (std::size_t i = 0; i < result.frames.size(); ++i) {
+        if (i != 0) body += ',';
+        body += *result.frames[i];
+    }
+    body += R"(],"next_after":)";
+    body += std::to_string(result.nextAfter);
+    body += result.gap ? R"(,"gap":true})" : R"(,"gap":false})";
+    return chatserver::infrastructure::http::HttpResponse{200, std::move(body)};
+}
+
+}
+
+LongPollResource::LongPollResource(std::shared_ptr<chatserver::infrastructure::realtime::LongPollRegistry> registry)
+    : registry_(std::move(registry)) {}
+
+void LongPollResource::register_routes(chatserver::infrastructure::http::HttpRouter& router) {
+    auto registry = registry_;
+    router.add_route("GET", "/messages/wait", [registry](const auto& req) {
+        using chatserver::infrastructure::http::HttpResponse;
+        using chatserver::infrastructure::http::ResponseSink;
+
+        auto user = req.query_param("user");
+        auto userId = user ? parse_int(*user) : std::nullopt;
+        if (!userId || *userId <= 0) {
+            json res{{"error", "invalid request: user (int) required"}};
+            return HttpResponse{400, res.dump()};
+        }
+        std::optional<std::int64_t> after;
+        if (auto value = req.query_param("after"); value && !value->empty()) {
+            after = parse_int(*value);
+            if (!after || *after < 0) {
+                json res{{"error", "invalid request: after must be a message id"}};
+                return HttpResponse{400, res.dump()};
+            }
+        }
+        std::int64_t timeout = kDefaultTimeoutSeconds;
+        if (auto value = req.query_param("timeout")) {
+            auto parsed = parse_int(*value);
+            if (!parsed || *parsed < 0) {
+                json res{{"error", "invalid request: timeout must be a non-negative integer (seconds)"}};
+                return HttpResponse{400, res.dump()};
+            }
+            // Верхнюю границу задаёт реестр (maxTimeout); здесь — только защита от переполнения.
+            timeout = std::min<std::int64_t>(*parsed, 3600);
+        }
+
+        HttpResponse hresp;
+        hresp.deferred = [registry, userId = *userId, after, timeout](ResponseSink sink) {
+            registry->wait(userId, after, std::chrono::seconds(timeout),
+                           [sink = std::move(sink)](chatserver::infrastructure::realtime::LongPollResult result) {
+                               sink(to_response(result));
+                           });
+        };
+        return hresp;
+    });
+}
+
+}
@@ -1,18 +1,99 @@
 // src/chatserver/infrastructure/http/resources/message_resource.cpp
 #include "chatserver/infrastructure/http/resources/message_resource.h"
 #include "chatserver/infrastructure/http/http_response.h"
+#include "chatserver/infrastructure/http/message_cursor.h"
+#include "chatserver/domain/common/timestamp.h"
 
 #include "chatserver/nlohmann/json.hpp"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 
 using json = nlohmann::json;
 // Упрощаем доступ к JSON-библиотеке.
 
 namespace chatserver::infrastructure::http::resources {
 
-MessageResource::MessageResource(std::shared_ptr<chatserver::application::SendMessageHandler> sendHandler)
-    : sendHandler_(std::move(sendHandler)) {}
-// Внедрение зависимости: обработчик use case "отправить сообщение".
+namespace {
+
+std::optional<std::int64_t> parse_int(const std::string& s) {
+    std::int64_t value = 0;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (ec != std::errc{} || ptr != s.data() + s.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+constexpr std::size_t kMaxIdempotencyKeyBytes = 255;
+// Ключ — непрозрачная строка клиента (обычно UUID); длинные не храним.
+
+bool valid_idempotency_key(const std::string& key) {
+    if (key.empty() || key.size() > kMaxIdempotencyKeyBytes) return false;
+    return std::all_of(key.begin(), key.end(), [](char c) { return c > 0x20 && c < 0x7f; });
+}
+
+constexpr std::size_t kStreamChunkBytes = 16 * 1024;
+// Размер chunk'а потокового ответа: достаточно крупный, чтобы не делать write на
+// каждое сообщение, и достаточно мелкий, чтобы не держать всю страницу в JSON-строке.
+
+void stream_history_page(const chatserver::application::MessageHistoryPage& page,
+                         const chatserver::infrastructure::http::ChunkWriter& write) {
+    // JSON собирается вручную по одному сообщению, без построения дерева nlohmann::json
+    // на всю страницу: в памяти одновременно только текущий chunk.
+    std::string buf;
+    buf.reserve(kStreamChunkBytes + 1024);
+    buf += R"({"messages":[)";
+    bool first = true;
+    for (const auto& m : page.messages) {
+        if (!first) buf += ',';
+        first = false;
+        buf += R"({"id":)";
+        buf += std::to_string(m.id);
+        buf += R"(,"sender_id":)";
+        buf += std::to_string(m.sender_id);
+        if (m.group_id != 0) {
+            buf += R"(,"group_id":)";
+            buf += std::to_string(m.group_id);
+        } else {
+            buf += R"(,"receiver_id":)";
+            buf += std::to_string(m.receiver_id);
+        }
+        buf += R"(,"text":)";
+        buf += json(m.text).dump(-1, ' ', false, json::error_handler_t::replace);
+        // created_at — секунды (как раньше), created_at_us — то же время в микросекундах.
+        buf += R"(,"created_at":)";
+        buf += std::to_string(chatserver::domain::Timestamp::from_micros(m.created_at).epoch_seconds());
+        buf += R"(,"created_at_us":)";
+        buf += std::to_string(m.created_at);
+        buf += '}';
+        if (buf.size() >= kStreamChunkBytes) {
+            write(buf);
+            buf.clear();
+        }
+    }
+    buf += R"(],"next_cursor":)";
+    if (page.has_more && !page.messages.empty()) {
+        buf += '"';
+        buf += chatserver::infrastructure::http::encode_message_cursor(page.messages.back().id);
+        buf += '"';
+    } else {
+        buf += "null";
+    }
+    buf += '}';
+    write(buf);
+}
+
+}
+
+MessageResource::MessageResource(std::shared_ptr<chatserver::application::SendMessageHandler> sendHandler,
+                                 std::shared_ptr<chatserver::application::GetMessageHistoryHandler> historyHandler)
+    : sendHandler_(std::move(sendHandler))
+    , historyHandler_(std::move(historyHandler)) {}
+// Внедрение зависимостей: обработчики use case "отправить сообщение" и "прочитать историю".
 // Хранится в shared_ptr, чтобы ресурс мог безопасно использовать его в лямбдах.
 
 void MessageResource::register_routes(chatserver::infrastructure::http::HttpRouter& router) {
@@ -34,23 +115,40 @@ void MessageResource::register_routes(chatserver::infrastructure::http::HttpRout
             return chatserver::infrastructure::http::HttpResponse{400, res.dump()};
         }
 
-        // Проверяем поля и типы (без receiver_id — согласно схеме БД)
-        if (!j.contains("sender_id") || !j.contains("text") ||
-            j["sender_id"].is_null() || !j["text"].is_string() ||
-            !j["sender_id"].is_number_integer()) {
-            json res{{"error", "invalid request: sender_id (int) and text (string) required"}};
+        // Проверяем поля и типы
+        if (!j.contains("sender_id") || !j.contains("receiver_id") || !j.contains("text") ||
+            !j["sender_id"].is_number_integer() || !j["receiver_id"].is_number_integer() ||
+            !j["text"].is_string()) {
+            json res{{"error", "invalid request: sender_id (int), receiver_id (int) and text (string) required"}};
             return chatserver::infrastructure::http::HttpResponse{400, res.dump()};
         }
 
         chatserver::application::SendMessageCommand cmd{
             j["sender_id"].get<std::int64_t>(),
-            j["text"].get<std::string>()
+            j["receiver_id"].get<std::int64_t>(),
+            j["text"].get<std::string>(),
+            std::nullopt
         };
+        if (auto key = req.header("Idempotency-Key")) {
+            if (!valid_idempotency_key(*key)) {
+                json res{{"error", "invalid Idempotency-Key: 1-255 visible ASCII characters"}};
+                return chatserver::infrastructure::http::HttpResponse{400, res.dump()};
+            }
+            cmd.idempotency_key = std::move(*key);
+        }
 
         try {
             std::int64_t messageId = handler->handle(cmd);
             json res{{"id", messageId}};
             return chatserver::infrastructure::http::HttpResponse{200, res.dump()};
+        } catch (const chatserver::infrastructure::cache::IdempotencyKeyReusedError& ex) {
+            // Ключ уже использован для другого сообщения — повтором это не считаем.
+            json res{{"error", ex.what()}};
+            return chatserver::infrastructure::http::HttpResponse{422, res.dump()};
+        } catch (const std::invalid_argument& ex) {
+            // Нарушен инвариант домена (пустой текст, id вне диапазона) — ошибка клиента.
+            json res{{"error", ex.what()}};
+            return chatserver::infrastructure::http::HttpResponse{400, res.dump()};
         } catch (const std::exception& ex) {
             std::cerr << "[MessageResource] /send_message exception: " << ex.what() << std::endl;
             json res{{"error", "internal server error"}};
@@ -61,6 +159,69 @@ void MessageResource::register_routes(chatserver::infrastructure::http::HttpRout
             return chatserver::infrastructure::http::HttpResponse{500, res.dump()};
         }
     });
+
+    auto history = historyHandler_;
+    router.add_route("GET", "/messages", [history](const auto& req) {
+        using chatserver::infrastructure::http::HttpResponse;
+
+        // Личная переписка — user + peer, групповой чат — user + group.
+        auto user = req.query_param("user");
+        auto peer = req.query_param("peer");
+        auto group = req.query_param("group");
+        auto userId = user ? parse_int(*user) : std::nullopt;
+        auto peerId = peer ? parse_int(*peer) : std::nullopt;
+        auto groupId = group ? parse_int(*group) : std::nullopt;
+        const bool validPeer = peerId && *peerId > 0 && !group;
+        const bool validGroup = groupId && *groupId > 0 && !peer;
+        if (!userId || *userId <= 0 || (!validPeer && !validGroup)) {
+            json res{{"error", "invalid request: user (int) and either peer (int) or group (int) required"}};
+            return HttpResponse{400, res.dump()};
+        }
+
+        chatserver::application::GetMessageHistoryQuery query{
+            *userId,
+            validPeer ? *peerId : 0,
+            std::nullopt,
+            chatserver::application::GetMessageHistoryHandler::kDefaultLimit,
+            validGroup ? groupId : std::nullopt
+        };
+
+        if (auto before = req.query_param("before"); before && !before->empty()) {
+            query.before_id = chatserver::infrastructure::http::decode_message_cursor(*before);
+            if (!query.before_id) {
+                json res{{"error", "invalid cursor"}};
+                return HttpResponse{400, res.dump()};
+            }
+        }
+        if (auto limit = req.query_param("limit")) {
+            auto value = parse_int(*limit);
+            if (!value || *value <= 0) {
+                json res{{"error", "invalid request: limit must be a positive integer"}};
+                return HttpResponse{400, res.dump()};
+            }
+            query.limit = static_cast<std::size_t>(*value);
+        }
+
+        try {
+            auto page = std::make_shared<chatserver::application::MessageHistoryPage>(history->handle(query));
+            HttpResponse resp;
+            resp.status_code = 200;
+            resp.stream_body = [page](const chatserver::infrastructure::http::ChunkWriter& write) {
+                stream_history_page(*page, write);
+            };
+            return resp;
+        } catch (const chatserver::infrastructure::repository::NotGroupMemberError& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{403, res.dump()};
+        } catch (const std::invalid_argument& ex) {
+            json res{{"error", ex.what()}};
+            return HttpResponse{400, res.dump()};
+        } catch (const std::exception& ex) {
+            std::cerr << "[MessageResource] /messages exception: " << ex.what() << std::endl;
+            json res{{"error", "internal server error"}};
+            return HttpResponse{500, res.dump()};
+        }
+    });
 }
 
 } // namespace chatserver::infrastructure::http::resources
@@ -60,6 +60,11 @@ void UserResource::register_routes(chatserver::infrastructure::http::HttpRouter&
             json res{{"id", userId}};
             return chatserver::infrastructure::http::HttpResponse{200, res.dump()};
         }
+        catch (const chatserver::infrastructure::repository::UsernameTakenError&) {
+            // Имя занято — ошибка клиента, а не сервера.
+            json res{{"error", "username already exists"}};
+            return chatserver::infrastructure::http::HttpResponse{409, res.dump()};
+        }
         catch (const std::exception& ex) {
             // Ловим любые исключения — возвращаем 500.
             std::cerr << "[UserResource] /register exception: " << ex.what() << std::endl;
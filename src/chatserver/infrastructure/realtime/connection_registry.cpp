@@ -0,0 +1,240 @@
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace chatserver::infrastructure::realtime {
+
+void ConnectionList::push_back(std::weak_ptr<RealtimeConnection> connection)
+{
+    if (size_ < kInline) {
+        inline_[size_] = std::move(connection);
+    } else {
+        if (!overflow_) {
+            overflow_ = std::make_unique<std::vector<std::weak_ptr<RealtimeConnection>>>();
+        }
+        overflow_->push_back(std::move(connection));
+    }
+    ++size_;
+}
+
+void ConnectionList::pop_back()
+{
+    --size_;
+    if (size_ < kInline) {
+        inline_[size_].reset();
+    } else {
+        overflow_->pop_back();
+    }
+    if (size_ <= kInline) {
+        overflow_.reset();
+    }
+}
+
+ConnectionRegistry::ConnectionRegistry(ConnectionRegistryOptions options)
+    : options_(options)
+{
+    const std::size_t shards = std::bit_ceil(std::max<std::size_t>(1, options_.shards));
+    options_.shards = shards;
+    shards_ = std::make_unique<Shard[]>(shards);
+    shardMask_ = shards - 1;
+}
+
+std::size_t ConnectionRegistry::shard_index(std::int64_t userId) const
+{
+    // Мультипликативный хеш: последовательные id расходятся по разным шардам.
+    const auto h = static_cast<std::uint64_t>(userId) * 0x9E3779B97F4A7C15ull;
+    return (h >> 32) & shardMask_;
+}
+
+ConnectionRegistry::Shard& ConnectionRegistry::shard_for(std::int64_t userId) const
+{
+    return shards_[shard_index(userId)];
+}
+
+bool ConnectionRegistry::add(std::int64_t userId, const std::shared_ptr<RealtimeConnection>& connection)
+{
+    auto& shard = shard_for(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.users.try_emplace(userId);
+    auto& list = it->second;
+    if (!inserted && list.size() >= options_.maxConnectionsPerUser) {
+        // Перед отказом вычищаем соединения, которые уже уничтожены, но ещё не успели remove().
+        const auto expired = list.remove_if([](const std::weak_ptr<RealtimeConnection>& weak) {
+            return weak.expired();
+        });
+        connectionCount_.fetch_sub(expired, std::memory_order_relaxed);
+        if (list.size() >= options_.maxConnectionsPerUser) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    list.push_back(connection);
+    connectionCount_.fetch_add(1, std::memory_order_relaxed);
+    if (inserted) {
+        onlineUsers_.fetch_add(1, std::memory_order_relaxed);
+        wentOnline_.fetch_add(1, std::memory_order_relaxed);
+        if (listener_) listener_(userId, true);
+    }
+    return true;
+}
+
+void ConnectionRegistry::remove(std::int64_t userId, const RealtimeConnection* connection)
+{
+    // Ссылки, взятые weak.lock() под блокировкой, отпускаются только после неё:
+    // если владелец тем временем отпустил соединение, последней окажется наша ссылка,
+    // и деструктор сессии снова позовёт remove() на этот же шард.
+    std::vector<std::shared_ptr<RealtimeConnection>> held;
+    auto& shard = shard_for(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return;
+    }
+    // Сравниваем по адресу. remove() зовётся и из деструктора соединения,
+    // когда его weak_ptr уже истёк, — поэтому истёкшие записи вычищаются заодно.
+    held.reserve(it->second.size());
+    const auto removed = it->second.remove_if([connection, &held](const std::weak_ptr<RealtimeConnection>& weak) {
+        auto alive = weak.lock();
+        if (!alive) {
+            return true;
+        }
+        const bool match = alive.get() == connection;
+        held.push_back(std::move(alive));
+        return match;
+    });
+    connectionCount_.fetch_sub(removed, std::memory_order_relaxed);
+    if (it->second.empty()) {
+        shard.users.erase(it);
+        onlineUsers_.fetch_sub(1, std::memory_order_relaxed);
+        wentOffline_.fetch_add(1, std::memory_order_relaxed);
+        if (listener_) listener_(userId, false);
+    }
+}
+
+std::size_t ConnectionRegistry::send_to_user(std::int64_t userId,
+                                             const std::shared_ptr<const std::string>& frame) const
+{
+    // Соединения копируем под блокировкой шарда на стек (обычно одно-два),
+    // а send() зовём уже без неё: он post'ит в чужой io-поток.
+    std::array<std::shared_ptr<RealtimeConnection>, ConnectionList::kInline> inlineTargets;
+    std::vector<std::shared_ptr<RealtimeConnection>> moreTargets;
+    std::size_t count = 0;
+    {
+        auto& shard = shard_for(userId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.users.find(userId);
+        if (it == shard.users.end()) {
+            return 0;
+        }
+        it->second.for_each([&](const std::weak_ptr<RealtimeConnection>& weak) {
+            if (auto alive = weak.lock()) {
+                if (count < inlineTargets.size()) {
+                    inlineTargets[count] = std::move(alive);
+                } else {
+                    moreTargets.push_back(std::move(alive));
+                }
+                ++count;
+            }
+        });
+    }
+    for (std::size_t i = 0; i < std::min(count, inlineTargets.size()); ++i) {
+        inlineTargets[i]->send(frame);
+    }
+    for (const auto& connection : moreTargets) {
+        connection->send(frame);
+    }
+    return count;
+}
+
+std::size_t ConnectionRegistry::send_to_users(const std::vector<std::int64_t>& userIds,
+                                              const std::shared_ptr<const std::string>& frame) const
+{
+    // Сортируем пользователей по номеру шарда и проходим шарды по порядку:
+    // один захват мьютекса на шард вместо одного на участника.
+    std::vector<std::pair<std::size_t, std::int64_t>> byShard;
+    byShard.reserve(userIds.size());
+    for (auto userId : userIds) {
+        byShard.emplace_back(shard_index(userId), userId);
+    }
+    std::sort(byShard.begin(), byShard.end());
+
+    std::vector<std::shared_ptr<RealtimeConnection>> targets;
+    targets.reserve(userIds.size());
+    for (std::size_t i = 0; i < byShard.size();) {
+        auto& shard = shards_[byShard[i].first];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const std::size_t current = byShard[i].first; i < byShard.size() && byShard[i].first == current; ++i) {
+            auto it = shard.users.find(byShard[i].second);
+            if (it == shard.users.end()) {
+                continue;
+            }
+            it->second.for_each([&](const std::weak_ptr<RealtimeConnection>& weak) {
+                if (auto alive = weak.lock()) {
+                    targets.push_back(std::move(alive));
+                }
+            });
+        }
+    }
+    for (const auto& connection : targets) {
+        connection->send(frame);
+    }
+    return targets.size();
+}
+
+void ConnectionRegistry::set_presence_listener(PresenceListener listener)
+{
+    listener_ = std::move(listener);
+}
+
+bool ConnectionRegistry::is_online(std::int64_t userId) const
+{
+    auto& shard = shard_for(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.users.count(userId) != 0;
+}
+
+std::size_t ConnectionRegistry::connections_of(std::int64_t userId) const
+{
+    auto& shard = shard_for(userId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    return it == shard.users.end() ? 0 : it->second.size();
+}
+
+std::size_t ConnectionRegistry::online_users() const
+{
+    return onlineUsers_.load(std::memory_order_relaxed);
+}
+
+std::size_t ConnectionRegistry::connection_count() const
+{
+    return connectionCount_.load(std::memory_order_relaxed);
+}
+
+PresenceStats ConnectionRegistry::stats() const
+{
+    PresenceStats s;
+    s.onlineUsers = online_users();
+    s.connections = connection_count();
+    s.wentOnline  = wentOnline_.load(std::memory_order_relaxed);
+    s.wentOffline = wentOffline_.load(std::memory_order_relaxed);
+    s.rejected    = rejected_.load(std::memory_order_relaxed);
+    s.shards      = options_.shards;
+    return s;
+}
+
+OutboundStats OutboundCounters::snapshot() const
+{
+    OutboundStats s;
+    s.framesQueued  = framesQueued_.load(std::memory_order_relaxed);
+    s.framesWritten = framesWritten_.load(std::memory_order_relaxed);
+    s.writeCalls    = writeCalls_.load(std::memory_order_relaxed);
+    s.bytesWritten  = bytesWritten_.load(std::memory_order_relaxed);
+    s.framesDropped = framesDropped_.load(std::memory_order_relaxed);
+    s.slowConsumers = slowConsumers_.load(std::memory_order_relaxed);
+    s.slowConsumersDisconnected = slowConsumersDisconnected_.load(std::memory_order_relaxed);
+    return s;
+}
+
+}
@@ -0,0 +1,298 @@
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace chatserver::infrastructure::realtime {
+
+LongPollRegistry::LongPollRegistry(LongPollOptions options)
+    : options_(options)
+{
+    const std::size_t shards = std::bit_ceil(std::max<std::size_t>(1, options_.shards));
+    options_.shards = shards;
+    options_.mailboxCapacity = std::max<std::size_t>(1, options_.mailboxCapacity);
+    options_.maxWaitersPerUser = std::max<std::size_t>(1, options_.maxWaitersPerUser);
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(options_.tick));
+    }
+    shardMask_ = shards - 1;
+    sweeper_ = std::thread([this] { sweeper_loop(); });
+}
+
+LongPollRegistry::~LongPollRegistry()
+{
+    {
+        std::lock_guard<std::mutex> lock(sweeperMutex_);
+        stopping_ = true;
+    }
+    sweeperWake_.notify_all();
+    sweeper_.join();
+
+    // Ожидающие запросы не должны повиснуть: отвечаем им пустым результатом.
+    std::vector<Completion> out;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto& [userId, box] : shard->users) {
+            for (auto& waiter : box.waiters) {
+                waiter.timeout.cancel();
+                out.emplace_back(std::move(waiter.done), LongPollResult{{}, waiter.after, false});
+            }
+            box.waiters.clear();
+            box.retention.cancel();
+        }
+        shard->users.clear();
+    }
+    for (auto& [done, result] : out) {
+        done(std::move(result));
+    }
+}
+
+std::size_t LongPollRegistry::shard_index(std::int64_t userId) const
+{
+    // Тот же мультипликативный хеш, что в ConnectionRegistry.
+    const auto h = static_cast<std::uint64_t>(userId) * 0x9E3779B97F4A7C15ull;
+    return (h >> 32) & shardMask_;
+}
+
+LongPollRegistry::Mailbox& LongPollRegistry::mailbox(Shard& shard, std::int64_t userId, bool& created)
+{
+    auto [it, inserted] = shard.users.try_emplace(userId);
+    created = inserted;
+    if (inserted) {
+        mailboxes_.fetch_add(1, std::memory_order_relaxed);
+        Shard* owner = &shard;
+        it->second.retention.set_handler([owner, userId] { owner->idle.push_back(userId); });
+    }
+    return it->second;
+}
+
+LongPollResult LongPollRegistry::collect(const Mailbox& box, std::int64_t after) const
+{
+    LongPollResult result;
+    result.nextAfter = after;
+    const std::size_t size = box.recent.size();
+    std::size_t cursor = size;
+    for (std::size_t i = size; i-- > 0;) {
+        if (box.at(i).id == after) {
+            cursor = i;
+            break;
+        }
+    }
+    if (cursor != size) {
+        // Клиент видел этот кадр — отдаём всё, что опубликовано после него.
+        for (std::size_t i = cursor + 1; i < size; ++i) {
+            result.frames.push_back(box.at(i).frame);
+            result.nextAfter = box.at(i).id;
+        }
+        return result;
+    }
+    // Курсора в кольце нет: либо он вытеснен (клиент отстал — gap, отдаём всё, что
+    // есть), либо ящик заведён после него — тогда нужны кадры с id больше курсора.
+    result.gap = after < box.evictedUpTo;
+    for (std::size_t i = 0; i < size; ++i) {
+        const auto& entry = box.at(i);
+        if (result.gap || entry.id > after) {
+            result.frames.push_back(entry.frame);
+            result.nextAfter = entry.id;
+        }
+    }
+    return result;
+}
+
+void LongPollRegistry::release_mailbox(Shard& shard, Mailbox& box)
+{
+    // Ожиданий больше нет: ящик доживает mailboxRetention до следующего запроса.
+    shard.wheel.schedule(box.retention, options_.mailboxRetention);
+}
+
+void LongPollRegistry::wait(std::int64_t userId, std::optional<std::int64_t> after,
+                            std::chrono::milliseconds timeout, Callback done)
+{
+    auto& shard = *shards_[shard_index(userId)];
+    std::vector<Completion> out;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bool created = false;
+        auto& box = mailbox(shard, userId, created);
+        const auto cursor = after.value_or(box.latest);
+        auto result = collect(box, cursor);
+        if (created && after) {
+            // Ящика не было: сообщения, сохранённые после after до этого запроса (первый
+            // опрос или ящик истёк по mailboxRetention), в нём не копились — клиент
+            // дочитывает их через GET /messages, а следующий опрос уже застанет ящик.
+            result.gap = true;
+        }
+        if (!result.frames.empty() || result.gap || timeout <= std::chrono::milliseconds::zero()) {
+            immediate_.fetch_add(1, std::memory_order_relaxed);
+            if (box.waiters.empty()) {
+                release_mailbox(shard, box);
+            }
+            out.emplace_back(std::move(done), std::move(result));
+        } else {
+            if (box.waiters.size() >= options_.maxWaitersPerUser) {
+                auto& oldest = box.waiters.front();
+                oldest.timeout.cancel();
+                out.emplace_back(std::move(oldest.done), LongPollResult{{}, oldest.after, false});
+                box.waiters.pop_front();
+                parked_.fetch_sub(1, std::memory_order_relaxed);
+                superseded_.fetch_add(1, std::memory_order_relaxed);
+            }
+            auto& waiter = box.waiters.emplace_back();
+            waiter.userId = userId;
+            waiter.after = cursor;
+            waiter.done = std::move(done);
+            Shard* owner = &shard;
+            Waiter* self = &waiter;
+            waiter.timeout.set_handler([owner, self] { owner->expired.push_back(self); });
+            shard.wheel.schedule(waiter.timeout,
+                                 std::min<std::chrono::milliseconds>(timeout, options_.maxTimeout));
+            box.retention.cancel();
+            parked_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    for (auto& [callback, result] : out) {
+        callback(std::move(result));
+    }
+}
+
+void LongPollRegistry::publish_locked(Shard& shard, std::int64_t userId, std::int64_t messageId,
+                                      const std::shared_ptr<const std::string>& frame,
+                                      std::vector<Completion>& out)
+{
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return;
+    }
+    auto& box = it->second;
+    box.latest = std::max(box.latest, messageId);
+    if (box.recent.size() < options_.mailboxCapacity) {
+        box.recent.push_back({messageId, frame});
+    } else {
+        auto& oldest = box.recent[box.head];
+        box.evictedUpTo = std::max(box.evictedUpTo, oldest.id);
+        oldest = {messageId, frame};
+        box.head = (box.head + 1) % box.recent.size();
+    }
+    if (box.waiters.empty()) {
+        return;
+    }
+    for (auto& waiter : box.waiters) {
+        waiter.timeout.cancel();
+        out.emplace_back(std::move(waiter.done), collect(box, waiter.after));
+    }
+    woken_.fetch_add(box.waiters.size(), std::memory_order_relaxed);
+    parked_.fetch_sub(box.waiters.size(), std::memory_order_relaxed);
+    box.waiters.clear();
+    release_mailbox(shard, box);
+}
+
+void LongPollRegistry::publish(std::int64_t userId, std::int64_t messageId,
+                               const std::shared_ptr<const std::string>& frame)
+{
+    auto& shard = *shards_[shard_index(userId)];
+    std::vector<Completion> out;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        publish_locked(shard, userId, messageId, frame, out);
+    }
+    // Обработчики (post ответа в io-поток) — уже без блокировки шарда.
+    for (auto& [callback, result] : out) {
+        callback(std::move(result));
+    }
+}
+
+void LongPollRegistry::publish(const std::vector<std::int64_t>& userIds, std::int64_t messageId,
+                               const std::shared_ptr<const std::string>& frame)
+{
+    // Как ConnectionRegistry::send_to_users: по одному захвату мьютекса на шард.
+    std::vector<std::pair<std::size_t, std::int64_t>> byShard;
+    byShard.reserve(userIds.size());
+    for (auto userId : userIds) {
+        byShard.emplace_back(shard_index(userId), userId);
+    }
+    std::sort(byShard.begin(), byShard.end());
+
+    std::vector<Completion> out;
+    for (std::size_t i = 0; i < byShard.size();) {
+        auto& shard = *shards_[byShard[i].first];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const std::size_t current = byShard[i].first; i < byShard.size() && byShard[i].first == current; ++i) {
+            publish_locked(shard, byShard[i].second, messageId, frame, out);
+        }
+    }
+    for (auto& [callback, result] : out) {
+        callback(std::move(result));
+    }
+}
+
+bool LongPollRegistry::has_mailbox(std::int64_t userId) const
+{
+    auto& shard = *shards_[shard_index(userId)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.users.count(userId) != 0;
+}
+
+void LongPollRegistry::sweep(Shard& shard, std::vector<Completion>& out)
+{
+    shard.wheel.advance(concurrency::TimingWheel::Clock::now());
+    for (Waiter* waiter : shard.expired) {
+        auto& box = shard.users.at(waiter->userId);
+        auto it = std::find_if(box.waiters.begin(), box.waiters.end(),
+                               [waiter](const Waiter& w) { return &w == waiter; });
+        out.emplace_back(std::move(it->done), LongPollResult{{}, it->after, false});
+        box.waiters.erase(it);
+        timedOut_.fetch_add(1, std::memory_order_relaxed);
+        parked_.fetch_sub(1, std::memory_order_relaxed);
+        if (box.waiters.empty()) {
+            release_mailbox(shard, box);
+        }
+    }
+    shard.expired.clear();
+    for (auto userId : shard.idle) {
+        auto it = shard.users.find(userId);
+        if (it != shard.users.end() && it->second.waiters.empty() && !it->second.retention.armed()) {
+            shard.users.erase(it);
+            mailboxes_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    shard.idle.clear();
+}
+
+void LongPollRegistry::sweeper_loop()
+{
+    std::unique_lock<std::mutex> lock(sweeperMutex_);
+    while (!stopping_) {
+        sweeperWake_.wait_for(lock, options_.tick, [this] { return stopping_; });
+        if (stopping_) {
+            break;
+        }
+        lock.unlock();
+        std::vector<Completion> out;
+        for (auto& shard : shards_) {
+            {
+                std::lock_guard<std::mutex> shardLock(shard->mutex);
+                sweep(*shard, out);
+            }
+            for (auto& [callback, result] : out) {
+                callback(std::move(result));
+            }
+            out.clear();
+        }
+        lock.lock();
+    }
+}
+
+LongPollStats LongPollRegistry::stats() const
+{
+    LongPollStats s;
+    s.mailboxes  = mailboxes_.load(std::memory_order_relaxed);
+    s.parked     = parked_.load(std::memory_order_relaxed);
+    s.immediate  = immediate_.load(std::memory_order_relaxed);
+    s.woken      = woken_.load(std::memory_order_relaxed);
+    s.timedOut   = timedOut_.load(std::memory_order_relaxed);
+    s.superseded = superseded_.load(std::memory_order_relaxed);
+    return s;
+}
+
+}
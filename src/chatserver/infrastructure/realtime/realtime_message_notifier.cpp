@@ -0,0 +1,68 @@
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+
+#include "chatserver/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+namespace chatserver::infrastructure::realtime {
+
+RealtimeMessageNotifier::RealtimeMessageNotifier(std::shared_ptr<ConnectionRegistry> registry,
+                                                 std::shared_ptr<LongPollRegistry> longPoll)
+    : registry_(std::move(registry))
+    , longPoll_(std::move(longPoll)) {}
+
+void RealtimeMessageNotifier::message_stored(const chatserver::domain::message::Message& message)
+{
+    const auto receiver = message.receiver_id().value();
+    const bool online = registry_->is_online(receiver);
+    const bool polling = longPoll_ && longPoll_->has_mailbox(receiver);
+    // Получатель не в сети и не опрашивает сервер — кадр даже не собираем.
+    if (!online && !polling) {
+        return;
+    }
+    auto frame = std::make_shared<const std::string>(to_frame(message));
+    if (online) {
+        registry_->send_to_user(receiver, frame);
+    }
+    if (polling) {
+        longPoll_->publish(receiver, message.id().value(), frame);
+    }
+}
+
+void RealtimeMessageNotifier::group_message_stored(const chatserver::domain::message::Message& message,
+                                                   const std::vector<chatserver::domain::UserId>& recipients)
+{
+    if (recipients.empty()) {
+        return;
+    }
+    std::vector<std::int64_t> ids;
+    ids.reserve(recipients.size());
+    for (const auto& user : recipients) {
+        ids.push_back(user.value());
+    }
+    auto frame = std::make_shared<const std::string>(to_frame(message));
+    registry_->send_to_users(ids, frame);
+    if (longPoll_) {
+        longPoll_->publish(ids, message.id().value(), frame);
+    }
+}
+
+std::string RealtimeMessageNotifier::to_frame(const chatserver::domain::message::Message& message)
+{
+    json j{
+        {"type", "message"},
+        {"id", message.id().value()},
+        {"sender_id", message.sender_id().value()},
+    };
+    if (const auto group = message.group_id()) {
+        j["group_id"] = group->value();
+    } else {
+        j["receiver_id"] = message.receiver_id().value();
+    }
+    j["text"] = message.text().value();
+    j["created_at"] = message.created_at().epoch_seconds();
+    j["created_at_us"] = message.created_at().epoch_micros();
+    return j.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+}
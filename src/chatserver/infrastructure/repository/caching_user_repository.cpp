@@ -0,0 +1,238 @@
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+namespace {
+
+// Узел unordered_map<string, size_t> (с ключом) — грубая оценка сверх самих строк.
+constexpr std::size_t kIndexNodeOverhead = 64;
+
+std::size_t slot_bytes(const std::string& username, const std::optional<chatserver::domain::user::User>& user) {
+    std::size_t bytes = kIndexNodeOverhead + username.capacity() * 2;
+    // Имя хранится дважды: в слоте и ключом индекса.
+    if (user) {
+        bytes += user->username().value().capacity() + user->password_hash().value().capacity();
+    }
+    return bytes;
+}
+
+}
+
+CachingUserRepository::CachingUserRepository(std::shared_ptr<UserRepository> inner, UserCacheOptions options)
+    : inner_(std::move(inner))
+    , options_(options)
+{
+    if (!inner_) {
+        throw std::invalid_argument("CachingUserRepository: inner repository is required");
+    }
+    const std::size_t shards = std::bit_ceil(std::max<std::size_t>(1, options_.shards));
+    options_.shards = shards;
+    shardMask_ = shards - 1;
+    const std::size_t perShard = (options_.capacity + shards - 1) / shards;
+    shards_ = std::make_unique<Shard[]>(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        shards_[i].size = perShard;
+        shards_[i].slots = std::make_unique<Slot[]>(perShard);
+        shards_[i].index.reserve(perShard);
+    }
+}
+
+CachingUserRepository::Shard& CachingUserRepository::shard_for(const std::string& username) const {
+    return shards_[std::hash<std::string>{}(username) & shardMask_];
+}
+
+std::optional<chatserver::domain::user::User>
+CachingUserRepository::find_by_username(const std::string& username) {
+    if (options_.capacity == 0) {
+        return inner_->find_by_username(username);
+    }
+    auto& shard = shard_for(username);
+    const auto now = Clock::now();
+
+    {
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.index.find(username);
+        if (it != shard.index.end()) {
+            auto& slot = shard.slots[it->second];
+            if (slot.expires > now) {
+                slot.referenced.store(true, std::memory_order_relaxed);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                if (!slot.user) {
+                    negativeHits_.fetch_add(1, std::memory_order_relaxed);
+                }
+                return slot.user;
+            }
+        }
+    }
+
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::unique_lock lock(shard.mutex);
+        // Повторная проверка: запись могли положить, пока мы ждали эксклюзивную блокировку.
+        auto it = shard.index.find(username);
+        if (it != shard.index.end()) {
+            auto& slot = shard.slots[it->second];
+            if (slot.expires > now) {
+                slot.referenced.store(true, std::memory_order_relaxed);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                if (!slot.user) {
+                    negativeHits_.fetch_add(1, std::memory_order_relaxed);
+                }
+                return slot.user;
+            }
+            erase_slot(shard, it->second);
+            expired_.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto [flightIt, inserted] = shard.inflight.try_emplace(username);
+        if (inserted) {
+            flightIt->second = std::make_shared<Flight>();
+            leader = true;
+        }
+        flight = flightIt->second;
+    }
+
+    if (!leader) {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock wait(flight->mutex);
+        flight->done.wait(wait, [&flight] { return flight->finished; });
+        if (flight->error) {
+            std::rethrow_exception(flight->error);
+        }
+        return flight->user;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    std::optional<chatserver::domain::user::User> user;
+    std::exception_ptr error;
+    try {
+        user = inner_->find_by_username(username);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.inflight.erase(username);
+        std::lock_guard<std::mutex> flightLock(flight->mutex);
+        if (!error && !flight->stale) {
+            store(shard, username, user, Clock::now());
+        }
+    }
+    {
+        std::lock_guard<std::mutex> flightLock(flight->mutex);
+        flight->user = user;
+        flight->error = error;
+        flight->finished = true;
+    }
+    flight->done.notify_all();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return user;
+}
+
+void CachingUserRepository::store(Shard& shard, const std::string& username,
+                                  const std::optional<chatserver::domain::user::User>& user,
+                                  Clock::time_point now) {
+    // Жертва — первый слот, к которому не обращались с прошлого прохода стрелки.
+    std::size_t victim = shard.hand;
+    for (;;) {
+        auto& slot = shard.slots[shard.hand];
+        victim = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.size;
+        if (!slot.used) {
+            break;
+        }
+        if (slot.expires <= now) {
+            expired_.fetch_add(1, std::memory_order_relaxed);
+            erase_slot(shard, victim);
+            break;
+        }
+        if (!slot.referenced.exchange(false, std::memory_order_relaxed)) {
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+            erase_slot(shard, victim);
+            break;
+        }
+    }
+
+    auto& slot = shard.slots[victim];
+    slot.username = username;
+    slot.user = user;
+    slot.expires = now + (user ? options_.ttl : options_.negativeTtl);
+    slot.referenced.store(false, std::memory_order_relaxed);
+    slot.used = true;
+    slot.bytes = slot_bytes(slot.username, slot.user);
+    shard.bytes += slot.bytes;
+    shard.index[slot.username] = victim;
+}
+
+void CachingUserRepository::erase_slot(Shard& shard, std::size_t i) {
+    auto& slot = shard.slots[i];
+    shard.index.erase(slot.username);
+    shard.bytes -= slot.bytes;
+    slot.bytes = 0;
+    slot.used = false;
+    slot.user.reset();
+    slot.username.clear();
+    slot.username.shrink_to_fit();
+}
+
+std::int64_t CachingUserRepository::save(const chatserver::domain::user::User& user) {
+    try {
+        const auto id = inner_->save(user);
+        invalidate(user.username().value());
+        return id;
+    } catch (const UsernameTakenError&) {
+        // Имя существует: отрицательная запись для него (если была) неверна.
+        invalidate(user.username().value());
+        throw;
+    }
+}
+
+void CachingUserRepository::for_each_username(const std::function<void(const std::string&)>& visit) {
+    inner_->for_each_username(visit);
+}
+
+void CachingUserRepository::invalidate(const std::string& username) {
+    if (options_.capacity == 0) {
+        return;
+    }
+    auto& shard = shard_for(username);
+    std::unique_lock lock(shard.mutex);
+    if (auto it = shard.index.find(username); it != shard.index.end()) {
+        erase_slot(shard, it->second);
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto it = shard.inflight.find(username); it != shard.inflight.end()) {
+        std::lock_guard<std::mutex> flightLock(it->second->mutex);
+        it->second->stale = true;
+    }
+}
+
+UserCacheStats CachingUserRepository::stats() const {
+    UserCacheStats s;
+    s.hits          = hits_.load(std::memory_order_relaxed);
+    s.negativeHits  = negativeHits_.load(std::memory_order_relaxed);
+    s.misses        = misses_.load(std::memory_order_relaxed);
+    s.coalesced     = coalesced_.load(std::memory_order_relaxed);
+    s.evictions     = evictions_.load(std::memory_order_relaxed);
+    s.expired       = expired_.load(std::memory_order_relaxed);
+    s.invalidations = invalidations_.load(std::memory_order_relaxed);
+    s.capacity      = options_.capacity;
+    for (std::size_t i = 0; i <= shardMask_; ++i) {
+        const auto& shard = shards_[i];
+        std::shared_lock lock(shard.mutex);
+        s.entries += shard.index.size();
+        s.bytes += shard.bytes + shard.size * sizeof(Slot);
+    }
+    return s;
+}
+
+}
@@ -0,0 +1 @@
+#include "chatserver/infrastructure/repository/group_repository.h"
@@ -0,0 +1,36 @@
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace chatserver::infrastructure::repository {
+
+std::int64_t InMemoryGroupRepository::create(const std::vector<chatserver::domain::UserId>& members) {
+    auto sorted = members;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    const std::int64_t id = nextId_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock lock(mutex_);
+    groups_.emplace(id, std::move(sorted));
+    return id;
+}
+
+std::vector<chatserver::domain::UserId>
+InMemoryGroupRepository::members(const chatserver::domain::GroupId& group) const {
+    std::shared_lock lock(mutex_);
+    auto it = groups_.find(group.value());
+    if (it == groups_.end()) {
+        throw GroupNotFoundError(group.value());
+    }
+    return it->second;
+}
+
+bool InMemoryGroupRepository::is_member(const chatserver::domain::GroupId& group,
+                                        const chatserver::domain::UserId& user) const {
+    std::shared_lock lock(mutex_);
+    auto it = groups_.find(group.value());
+    return it != groups_.end() && std::binary_search(it->second.begin(), it->second.end(), user);
+}
+
+} // namespace chatserver::infrastructure::repository
@@ -0,0 +1,135 @@
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+InMemoryMessageRepository::InMemoryMessageRepository(std::size_t maxMessages)
+    : maxChunks_((maxMessages + kChunkSize - 1) / kChunkSize)
+    , chunks_(std::make_unique<std::atomic<Chunk*>[]>(maxChunks_))
+    , conversations_(std::make_unique<ConversationShard[]>(kConversationShards)) {
+    if (maxChunks_ == 0) {
+        throw std::invalid_argument("InMemoryMessageRepository: capacity must be positive");
+    }
+    for (std::size_t i = 0; i < maxChunks_; ++i) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+InMemoryMessageRepository::~InMemoryMessageRepository() {
+    for (std::size_t i = 0; i < maxChunks_; ++i) {
+        delete chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+InMemoryMessageRepository::Chunk*
+InMemoryMessageRepository::chunk_at(std::size_t chunkIndex) {
+    auto& entry = chunks_[chunkIndex];
+    Chunk* chunk = entry.load(std::memory_order_acquire);
+    if (chunk) {
+        return chunk;
+    }
+    // Несколько писателей могут одновременно дойти до нового чанка:
+    // побеждает первый CAS, остальные удаляют свою копию и берут его.
+    auto fresh = std::make_unique<Chunk>();
+    if (entry.compare_exchange_strong(chunk, fresh.get(),
+                                      std::memory_order_acq_rel,
+                                      std::memory_order_acquire)) {
+        return fresh.release();
+    }
+    return chunk;
+}
+
+std::int64_t InMemoryMessageRepository::save(
+    const chatserver::domain::message::Message& message
+) {
+    const std::size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= maxChunks_ * kChunkSize) {
+        throw std::runtime_error("in-memory message store is full");
+    }
+
+    Chunk* chunk = chunk_at(index / kChunkSize);
+    const std::size_t slot = index % kChunkSize;
+    const auto id = static_cast<std::int64_t>(index + 1);
+
+    chunk->slots[slot].emplace(message.with_id(chatserver::domain::MessageId(id)));
+    chunk->ready[slot].store(true, std::memory_order_release);
+
+    // В индекс переписки id попадает только после публикации слота,
+    // поэтому find_page никогда не видит id без сообщения.
+    {
+        const auto conversation = message.conversation_id().value();
+        auto& shard = conversation_shard(conversation);
+        std::unique_lock lock(shard.mutex);
+        auto& ids = shard.ids[conversation];
+        // Параллельные save() в одну переписку могут прийти не по порядку id —
+        // вставляем с конца, обычно это push_back.
+        auto pos = ids.end();
+        while (pos != ids.begin() && *std::prev(pos) > id) --pos;
+        ids.insert(pos, id);
+    }
+    return id;
+}
+
+InMemoryMessageRepository::ConversationShard&
+InMemoryMessageRepository::conversation_shard(std::int64_t conversationId) const {
+    // Ключ — пара id, поэтому перемешиваем обе половины, а не берём остаток младших бит.
+    const auto key = static_cast<std::uint64_t>(conversationId) * 0x9E3779B97F4A7C15ull;
+    return conversations_[(key >> 32) % kConversationShards];
+}
+
+std::vector<chatserver::domain::message::Message>
+InMemoryMessageRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit
+) const {
+    std::vector<std::int64_t> pageIds;
+    {
+        const auto& shard = conversation_shard(conversation.value());
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.ids.find(conversation.value());
+        if (it == shard.ids.end()) {
+            return {};
+        }
+        const auto& ids = it->second;
+        auto end = before ? std::lower_bound(ids.begin(), ids.end(), before->value()) : ids.end();
+        const auto count = std::min<std::size_t>(limit, static_cast<std::size_t>(end - ids.begin()));
+        pageIds.assign(std::make_reverse_iterator(end), std::make_reverse_iterator(end) + count);
+    }
+
+    std::vector<chatserver::domain::message::Message> page;
+    page.reserve(pageIds.size());
+    for (auto id : pageIds) {
+        if (auto message = find_by_id(id)) {
+            page.push_back(std::move(*message));
+        }
+    }
+    return page;
+}
+
+std::optional<chatserver::domain::message::Message>
+InMemoryMessageRepository::find_by_id(std::int64_t id) const {
+    if (id <= 0) {
+        return std::nullopt;
+    }
+    const auto index = static_cast<std::size_t>(id - 1);
+    if (index >= next_.load(std::memory_order_acquire) || index >= maxChunks_ * kChunkSize) {
+        return std::nullopt;
+    }
+    const Chunk* chunk = chunks_[index / kChunkSize].load(std::memory_order_acquire);
+    const std::size_t slot = index % kChunkSize;
+    if (!chunk || !chunk->ready[slot].load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+    return chunk->slots[slot];
+}
+
+std::size_t InMemoryMessageRepository::size() const {
+    return std::min(next_.load(std::memory_order_acquire), maxChunks_ * kChunkSize);
+}
+
+} // namespace chatserver::infrastructure::repository
@@ -0,0 +1,93 @@
+#include "chatserver/infrastructure/repository/in_memory_shard_repository.h"
+
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+bool InMemoryShardRepository::insert(const chatserver::domain::message::Message& message) {
+    const auto id = message.id().value();
+    if (id <= 0) {
+        throw std::invalid_argument("shard stores messages with assigned ids only");
+    }
+    auto& conversation = byConversation_[message.conversation_id().value()];
+    if (!conversation.emplace(id, message).second) {
+        return false;
+    }
+    ++size_;
+    return true;
+}
+
+std::int64_t InMemoryShardRepository::save(const chatserver::domain::message::Message& message) {
+    std::unique_lock lock(mutex_);
+    insert(message);
+    return message.id().value();
+}
+
+std::size_t InMemoryShardRepository::save_batch(
+    const std::vector<chatserver::domain::message::Message>& messages
+) {
+    std::unique_lock lock(mutex_);
+    std::size_t inserted = 0;
+    for (const auto& message : messages) {
+        if (insert(message)) {
+            ++inserted;
+        }
+    }
+    return inserted;
+}
+
+std::vector<chatserver::domain::message::Message>
+InMemoryShardRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit
+) const {
+    std::shared_lock lock(mutex_);
+    std::vector<chatserver::domain::message::Message> page;
+    auto it = byConversation_.find(conversation.value());
+    if (it == byConversation_.end()) {
+        return page;
+    }
+    const auto& messages = it->second;
+    auto end = before ? messages.lower_bound(before->value()) : messages.end();
+    while (end != messages.begin() && page.size() < limit) {
+        --end;
+        page.push_back(end->second);
+    }
+    return page;
+}
+
+std::vector<chatserver::domain::message::Message> InMemoryShardRepository::extract_if(
+    const std::function<bool(const chatserver::domain::message::Message&)>& predicate,
+    bool remove
+) {
+    std::unique_lock lock(mutex_);
+    std::vector<chatserver::domain::message::Message> out;
+    for (auto conversation = byConversation_.begin(); conversation != byConversation_.end();) {
+        auto& messages = conversation->second;
+        for (auto it = messages.begin(); it != messages.end();) {
+            if (!predicate(it->second)) {
+                ++it;
+                continue;
+            }
+            out.push_back(it->second);
+            if (remove) {
+                it = messages.erase(it);
+                --size_;
+            } else {
+                ++it;
+            }
+        }
+        conversation = messages.empty() ? byConversation_.erase(conversation) : std::next(conversation);
+    }
+    return out;
+}
+
+std::size_t InMemoryShardRepository::size() const {
+    std::shared_lock lock(mutex_);
+    return size_;
+}
+
+}
@@ -0,0 +1,64 @@
+#include "chatserver/infrastructure/repository/in_memory_user_repository.h"
+
+#include <functional>
+#include <mutex>
+
+namespace chatserver::infrastructure::repository {
+
+InMemoryUserRepository::Shard&
+InMemoryUserRepository::shard_for(const std::string& username) {
+    return shards_[std::hash<std::string>{}(username) % kShards];
+}
+
+const InMemoryUserRepository::Shard&
+InMemoryUserRepository::shard_for(const std::string& username) const {
+    return shards_[std::hash<std::string>{}(username) % kShards];
+}
+
+std::int64_t InMemoryUserRepository::save(const chatserver::domain::user::User& user) {
+    const auto& name = user.username().value();
+    auto& shard = shard_for(name);
+
+    std::unique_lock lock(shard.mutex);
+    if (shard.users.find(name) != shard.users.end()) {
+        throw UsernameTakenError(name);
+    }
+    // id выдаём только после проверки уникальности: отклонённая вставка
+    // не оставляет дырок в последовательности.
+    const std::int64_t id = nextId_.fetch_add(1, std::memory_order_relaxed);
+    shard.users.emplace(name, chatserver::domain::user::User(
+        chatserver::domain::UserId(id), user.username(), user.password_hash()));
+    return id;
+}
+
+std::optional<chatserver::domain::user::User>
+InMemoryUserRepository::find_by_username(const std::string& username) {
+    const auto& shard = shard_for(username);
+
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.users.find(username);
+    if (it == shard.users.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void InMemoryUserRepository::for_each_username(const std::function<void(const std::string&)>& visit) {
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        for (const auto& [name, user] : shard.users) {
+            visit(name);
+        }
+    }
+}
+
+std::size_t InMemoryUserRepository::size() const {
+    std::size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        total += shard.users.size();
+    }
+    return total;
+}
+
+} // namespace chatserver::infrastructure::repository
@@ -0,0 +1,707 @@
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+
+#include "chatserver/common/crc32c.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr std::uint8_t  kRecordVersion = 3;
+// v3 = v2 с created_at в микросекундах; v1/v2 хранят секунды.
+constexpr std::size_t   kHeaderSize = 8;
+// u32 length + u32 crc
+constexpr std::size_t   kFixedPayloadV1 = 1 + 8 + 8 + 8 + 4;
+// version + id + sender_id + created_at + text_len
+constexpr std::size_t   kFixedPayload = 1 + 8 + 8 + 8 + 8 + 8 + 4;
+// version + id + sender_id + receiver_id + prev_in_conversation + created_at + text_len
+constexpr std::uint32_t kMaxPayload = 16u << 20;
+// Защита от мусорной длины в рваном хвосте: запись больше 16 MB считаем повреждённой.
+constexpr char          kIndexMagicV1[8] = {'C', 'H', 'L', 'O', 'G', 'I', 'D', 'X'};
+constexpr char          kIndexMagic[8] = {'C', 'H', 'L', 'O', 'G', 'I', 'X', '2'};
+// .idx v2 = v1 + таблица последних id переписок сегмента (см. roll_segment).
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::string segment_file(const std::string& dir, std::uint64_t baseId, const char* ext) {
+    // Имя = base_id с ведущими нулями: лексикографический порядок совпадает с числовым.
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(baseId));
+    return (fs::path(dir) / (std::string(name) + ext)).string();
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void encode_record(std::string& out, std::uint64_t id, std::uint64_t prevInConversation,
+                   const chatserver::domain::message::Message& message) {
+    const auto& text = message.text().value();
+    const auto payloadSize = static_cast<std::uint32_t>(kFixedPayload + text.size());
+    if (payloadSize > kMaxPayload) {
+        throw std::invalid_argument("message is too large for the log store");
+    }
+    out.clear();
+    out.reserve(kHeaderSize + payloadSize);
+    put<std::uint32_t>(out, payloadSize);
+    put<std::uint32_t>(out, 0);
+    // CRC посчитаем после того, как payload будет собран.
+    put<std::uint8_t>(out, kRecordVersion);
+    put<std::uint64_t>(out, id);
+    put<std::int64_t>(out, message.sender_id().value());
+    // Групповое сообщение: вместо получателя — минус id группы (получатели > 0).
+    const auto group = message.group_id();
+    put<std::int64_t>(out, group ? -group->value() : message.receiver_id().value());
+    put<std::uint64_t>(out, prevInConversation);
+    put<std::int64_t>(out, message.created_at().epoch_micros());
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(text.size()));
+    out.append(text);
+    const auto crc = common::crc32c(out.data() + kHeaderSize, payloadSize);
+    std::memcpy(out.data() + 4, &crc, sizeof(crc));
+}
+
+struct DecodedRecord {
+    std::uint64_t id;
+    std::int64_t senderId;
+    std::int64_t receiverId;
+    std::uint64_t prevInConversation;
+    std::int64_t createdAt;
+    // Микросекунды от эпохи (у записей v1/v2 — переведённые из секунд).
+    std::string_view text;
+    std::size_t totalSize;
+};
+
+std::optional<DecodedRecord> decode_record(const char* data, std::size_t size, std::size_t offset,
+                                          bool verifyCrc = true) {
+    // Возвращает nullopt для любой невалидной записи: обрезанной, с мусорной длиной,
+    // с несовпавшим CRC. При восстановлении это и есть граница рваного хвоста.
+    // verifyCrc = false — для перешагивания через уже проверенные записи при чтении.
+    if (size - offset < kHeaderSize) return std::nullopt;
+    const char* p = data + offset;
+    const auto payloadSize = get<std::uint32_t>(p);
+    const auto crc = get<std::uint32_t>(p + 4);
+    if (payloadSize < kFixedPayloadV1 || payloadSize > kMaxPayload) return std::nullopt;
+    if (size - offset - kHeaderSize < payloadSize) return std::nullopt;
+    const char* payload = p + kHeaderSize;
+    if (verifyCrc && common::crc32c(payload, payloadSize) != crc) return std::nullopt;
+
+    DecodedRecord rec;
+    rec.id = get<std::uint64_t>(payload + 1);
+    rec.senderId = get<std::int64_t>(payload + 9);
+    rec.totalSize = kHeaderSize + payloadSize;
+    std::size_t fixed = 0;
+    switch (get<std::uint8_t>(payload)) {
+    case 1:
+        fixed = kFixedPayloadV1;
+        rec.receiverId = 0;
+        rec.prevInConversation = 0;
+        rec.createdAt = get<std::int64_t>(payload + 17) * 1'000'000;
+        break;
+    case 2:
+    case kRecordVersion:
+        if (payloadSize < kFixedPayload) return std::nullopt;
+        fixed = kFixedPayload;
+        rec.receiverId = get<std::int64_t>(payload + 17);
+        rec.prevInConversation = get<std::uint64_t>(payload + 25);
+        rec.createdAt = get<std::int64_t>(payload + 33);
+        if (get<std::uint8_t>(payload) == 2) rec.createdAt *= 1'000'000;
+        break;
+    default:
+        return std::nullopt;
+    }
+    const auto textSize = get<std::uint32_t>(payload + fixed - 4);
+    if (fixed + textSize != payloadSize) return std::nullopt;
+    rec.text = std::string_view(payload + fixed, textSize);
+    return rec;
+}
+
+std::optional<std::int64_t> conversation_of(const DecodedRecord& rec) {
+    // У записей v1 получателя нет — они не принадлежат ни одной переписке.
+    if (rec.receiverId == 0) return std::nullopt;
+    if (rec.receiverId < 0) {
+        return chatserver::domain::ConversationId::group(chatserver::domain::GroupId(-rec.receiverId)).value();
+    }
+    return chatserver::domain::ConversationId::between(
+        chatserver::domain::UserId(rec.senderId), chatserver::domain::UserId(rec.receiverId)).value();
+}
+
+chatserver::domain::message::Message to_message(const DecodedRecord& rec) {
+    if (rec.receiverId < 0) {
+        return chatserver::domain::message::Message(
+            chatserver::domain::MessageId(static_cast<std::int64_t>(rec.id)),
+            chatserver::domain::UserId(rec.senderId),
+            chatserver::domain::GroupId(-rec.receiverId),
+            chatserver::domain::MessageText(std::string(rec.text)),
+            chatserver::domain::Timestamp::from_micros(rec.createdAt)
+        );
+    }
+    return chatserver::domain::message::Message(
+        chatserver::domain::MessageId(static_cast<std::int64_t>(rec.id)),
+        chatserver::domain::UserId(rec.senderId),
+        chatserver::domain::UserId(rec.receiverId),
+        chatserver::domain::MessageText(std::string(rec.text)),
+        chatserver::domain::Timestamp::from_micros(rec.createdAt)
+    );
+}
+
+void write_fully(int fd, const char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("log store pwrite");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+void fsync_directory(const std::string& dir) {
+    // Новый файл или rename долговечны только после fsync каталога.
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) throw_errno("open log directory");
+    ::fsync(fd);
+    ::close(fd);
+}
+
+struct Mapping {
+    // Отображение сегмента в память. Живёт, пока на него ссылается хотя бы один читатель,
+    // поэтому перемапливание растущего сегмента не ломает параллельные чтения.
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+    Mapping(int fd, std::size_t bytes) : size(bytes) {
+        void* addr = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) throw_errno("log store mmap");
+        data = static_cast<const char*>(addr);
+    }
+    ~Mapping() {
+        if (data) ::munmap(const_cast<char*>(data), size);
+    }
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+};
+
+struct IndexEntry {
+    std::uint64_t id;
+    std::uint64_t offset;
+};
+
+}
+
+struct LogMessageRepository::Segment {
+    std::uint64_t baseId = 0;
+    std::string path;
+    int fd = -1;
+
+    std::atomic<std::uint64_t> size{0};
+    // Байт полностью записанных записей. Всё, что дальше, читателям не видно.
+    std::atomic<std::uint64_t> lastId{0};
+    // Последний id в сегменте (baseId - 1, если сегмент пуст).
+
+    std::uint64_t lastIndexedOffset = 0;
+    // Используется только писателем (под appendMutex_).
+    mutable std::shared_mutex indexMutex;
+    std::vector<IndexEntry> index;
+
+    mutable std::mutex mapMutex;
+    mutable std::shared_ptr<const Mapping> mapping;
+
+    std::unordered_map<std::int64_t, std::uint64_t> heads;
+    // Последний id каждой переписки, встретившейся в сегменте. Только для писателя
+    // (под appendMutex_): уходит в .idx при закрытии сегмента.
+
+    ~Segment() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    void add_index(std::uint64_t id, std::uint64_t offset) {
+        std::unique_lock lock(indexMutex);
+        index.push_back({id, offset});
+        lastIndexedOffset = offset;
+    }
+
+    std::uint64_t scan_start(std::uint64_t id) const {
+        // Ближайшая точка индекса с id ≤ искомого — оттуда начинается линейный проход.
+        std::shared_lock lock(indexMutex);
+        auto it = std::upper_bound(index.begin(), index.end(), id,
+            [](std::uint64_t value, const IndexEntry& e) { return value < e.id; });
+        if (it == index.begin()) return 0;
+        return std::prev(it)->offset;
+    }
+
+    std::shared_ptr<const Mapping> map_at_least(std::uint64_t bytes, std::uint64_t segmentLimit) const {
+        // Отображение растущего сегмента берётся с запасом (вдвое, но не больше
+        // segmentLimit): иначе запись и сразу чтение новейшего сообщения перемапливали
+        // бы сегмент на каждое чтение. Страницы за концом файла не читаются — чтение
+        // ограничено закоммиченным размером, а дописанное в файл видно через тот же
+        // MAP_SHARED без перемапливания.
+        std::lock_guard lock(mapMutex);
+        if (!mapping || mapping->size < bytes) {
+            const auto current = size.load(std::memory_order_acquire);
+            if (current < bytes || current == 0) return nullptr;
+            std::uint64_t capacity = std::max<std::uint64_t>(current, kMinMapping);
+            if (mapping) {
+                capacity = std::max(capacity, std::min<std::uint64_t>(mapping->size * 2, segmentLimit));
+            }
+            mapping = std::make_shared<const Mapping>(fd, static_cast<std::size_t>(capacity));
+        }
+        return mapping;
+    }
+
+    static constexpr std::uint64_t kMinMapping = 1 << 20;
+};
+
+LogMessageRepository::LogMessageRepository(LogStoreOptions options)
+    : options_(std::move(options)) {
+    if (options_.directory.empty()) {
+        throw std::invalid_argument("LogMessageRepository: directory is required");
+    }
+    if (options_.maxSegmentBytes < kHeaderSize + kFixedPayload) {
+        throw std::invalid_argument("LogMessageRepository: maxSegmentBytes is too small");
+    }
+    recover();
+    if (options_.fsyncPolicy == FsyncPolicy::Interval) {
+        flusher_ = std::thread([this] { interval_flusher(); });
+    }
+}
+
+LogMessageRepository::~LogMessageRepository() {
+    stopping_ = true;
+    syncCv_.notify_all();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    try {
+        sync_up_to_latest();
+    } catch (const std::exception& ex) {
+        std::cerr << "[LogMessageRepository] final sync failed: " << ex.what() << std::endl;
+    }
+}
+
+void LogMessageRepository::recover() {
+    const auto started = std::chrono::steady_clock::now();
+    fs::create_directories(options_.directory);
+
+    std::vector<std::uint64_t> bases;
+    for (const auto& entry : fs::directory_iterator(options_.directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".log") continue;
+        try {
+            bases.push_back(std::stoull(entry.path().stem().string()));
+        } catch (const std::exception&) {
+            std::cerr << "[LogMessageRepository] skipping foreign file " << entry.path() << std::endl;
+        }
+    }
+    std::sort(bases.begin(), bases.end());
+
+    std::uint64_t expectedNext = bases.empty() ? 1 : bases.front();
+    for (std::size_t i = 0; i < bases.size(); ++i) {
+        const bool isLast = i + 1 == bases.size();
+        auto seg = std::make_shared<Segment>();
+        seg->baseId = bases[i];
+        seg->path = segment_file(options_.directory, seg->baseId, ".log");
+        if (seg->baseId != expectedNext) {
+            throw std::runtime_error("log store: gap in segment ids before " + seg->path);
+        }
+        seg->fd = ::open(seg->path.c_str(), O_RDWR | O_CLOEXEC);
+        if (seg->fd < 0) throw_errno("open " + seg->path);
+
+        struct stat st{};
+        if (::fstat(seg->fd, &st) != 0) throw_errno("fstat " + seg->path);
+        const auto fileSize = static_cast<std::uint64_t>(st.st_size);
+
+        // Закрытый сегмент с валидным .idx не читаем целиком — это и делает старт быстрым.
+        bool indexed = false;
+        if (!isLast) {
+            const auto idxPath = segment_file(options_.directory, seg->baseId, ".idx");
+            int idxFd = ::open(idxPath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (idxFd >= 0) {
+                struct stat ist{};
+                if (::fstat(idxFd, &ist) == 0 && ist.st_size >= 36) {
+                    std::string buf(static_cast<std::size_t>(ist.st_size), '\0');
+                    if (::pread(idxFd, buf.data(), buf.size(), 0) == static_cast<ssize_t>(buf.size())) {
+                        const bool v2 = std::memcmp(buf.data(), kIndexMagic, 8) == 0;
+                        const bool v1 = std::memcmp(buf.data(), kIndexMagicV1, 8) == 0;
+                        const auto count = get<std::uint64_t>(buf.data() + 8);
+                        const auto lastId = get<std::uint64_t>(buf.data() + 16);
+                        const auto dataSize = get<std::uint64_t>(buf.data() + 24);
+                        const auto entriesEnd = 32 + count * sizeof(IndexEntry);
+                        std::uint64_t headCount = 0;
+                        if (v2 && buf.size() >= entriesEnd + 8) {
+                            headCount = get<std::uint64_t>(buf.data() + entriesEnd);
+                        }
+                        const auto body = v2 ? entriesEnd + 8 + headCount * 16 : entriesEnd;
+                        if ((v1 || v2) &&
+                            buf.size() == body + 4 &&
+                            get<std::uint32_t>(buf.data() + body) == common::crc32c(buf.data(), body) &&
+                            dataSize == fileSize) {
+                            seg->index.resize(count);
+                            std::memcpy(seg->index.data(), buf.data() + 32, count * sizeof(IndexEntry));
+                            // Сегменты идут по возрастанию, поэтому более поздний id переписки
+                            // перезаписывает более ранний.
+                            for (std::uint64_t h = 0; h < headCount; ++h) {
+                                const char* entry = buf.data() + entriesEnd + 8 + h * 16;
+                                conversationHeads_[get<std::int64_t>(entry)] = get<std::uint64_t>(entry + 8);
+                            }
+                            seg->size = fileSize;
+                            seg->lastId = lastId;
+                            seg->lastIndexedOffset = count ? seg->index.back().offset : 0;
+                            recoveryStats_.records += lastId + 1 - seg->baseId;
+                            indexed = true;
+                        }
+                    }
+                }
+                ::close(idxFd);
+            }
+        }
+
+        if (!indexed) {
+            ++recoveryStats_.scannedSegments;
+            std::uint64_t offset = 0;
+            std::uint64_t nextId = seg->baseId;
+            if (fileSize > 0) {
+                Mapping map(seg->fd, static_cast<std::size_t>(fileSize));
+                while (offset < fileSize) {
+                    auto rec = decode_record(map.data, map.size, offset);
+                    if (!rec || rec->id != nextId) break;
+                    if (offset == 0 || offset - seg->lastIndexedOffset >= options_.indexIntervalBytes) {
+                        seg->add_index(rec->id, offset);
+                    }
+                    if (auto conversation = conversation_of(*rec)) {
+                        seg->heads[*conversation] = rec->id;
+                        conversationHeads_[*conversation] = rec->id;
+                    }
+                    offset += rec->totalSize;
+                    ++nextId;
+                }
+            }
+            if (offset != fileSize) {
+                if (!isLast) {
+                    // Повреждение в середине журнала — не «рваный хвост»; молча резать нельзя.
+                    throw std::runtime_error("log store: corrupted record in sealed segment " + seg->path);
+                }
+                std::cerr << "[LogMessageRepository] truncating torn tail of " << seg->path
+                          << ": " << (fileSize - offset) << " bytes at offset " << offset << std::endl;
+                if (::ftruncate(seg->fd, static_cast<off_t>(offset)) != 0) throw_errno("ftruncate " + seg->path);
+                if (::fdatasync(seg->fd) != 0) throw_errno("fdatasync " + seg->path);
+                recoveryStats_.truncatedBytes += fileSize - offset;
+            }
+            seg->size = offset;
+            seg->lastId = nextId - 1;
+            recoveryStats_.records += nextId - seg->baseId;
+        }
+
+        expectedNext = seg->lastId + 1;
+        segments_.emplace(seg->baseId, seg);
+    }
+
+    if (segments_.empty()) {
+        open_new_segment(1);
+    } else {
+        active_ = segments_.rbegin()->second;
+    }
+    lastId_ = active_->lastId.load();
+    syncedId_ = lastId_;
+
+    recoveryStats_.segments = segments_.size();
+    recoveryStats_.duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started);
+}
+
+void LogMessageRepository::open_new_segment(std::uint64_t baseId) {
+    auto seg = std::make_shared<Segment>();
+    seg->baseId = baseId;
+    seg->path = segment_file(options_.directory, baseId, ".log");
+    seg->fd = ::open(seg->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (seg->fd < 0) throw_errno("create " + seg->path);
+    seg->lastId = baseId - 1;
+    fsync_directory(options_.directory);
+
+    std::unique_lock lock(segmentsMutex_);
+    segments_.emplace(baseId, seg);
+    active_ = std::move(seg);
+}
+
+void LogMessageRepository::roll_segment() {
+    // Вызывается под appendMutex_. Закрываемый сегмент сначала уходит на диск,
+    // затем рядом кладётся его индекс: .idx существует только для долговечных данных.
+    auto sealed = active_;
+    if (::fdatasync(sealed->fd) != 0) throw_errno("fdatasync " + sealed->path);
+
+    std::string buf;
+    {
+        std::shared_lock lock(sealed->indexMutex);
+        buf.append(kIndexMagic, sizeof(kIndexMagic));
+        put<std::uint64_t>(buf, sealed->index.size());
+        put<std::uint64_t>(buf, sealed->lastId.load());
+        put<std::uint64_t>(buf, sealed->size.load());
+        buf.append(reinterpret_cast<const char*>(sealed->index.data()),
+                   sealed->index.size() * sizeof(IndexEntry));
+    }
+    put<std::uint64_t>(buf, sealed->heads.size());
+    for (const auto& [conversation, lastId] : sealed->heads) {
+        put<std::int64_t>(buf, conversation);
+        put<std::uint64_t>(buf, lastId);
+    }
+    put<std::uint32_t>(buf, common::crc32c(buf.data(), buf.size()));
+
+    const auto idxPath = segment_file(options_.directory, sealed->baseId, ".idx");
+    const auto tmpPath = idxPath + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw_errno("create " + tmpPath);
+    try {
+        write_fully(fd, buf.data(), buf.size(), 0);
+        if (::fsync(fd) != 0) throw_errno("fsync " + tmpPath);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (::rename(tmpPath.c_str(), idxPath.c_str()) != 0) throw_errno("rename " + tmpPath);
+
+    {
+        std::lock_guard lock(syncMutex_);
+        syncedId_ = std::max(syncedId_, sealed->lastId.load());
+    }
+    syncCv_.notify_all();
+
+    sealed->heads = {};
+    // Таблица уже в .idx; в памяти актуальные значения живут в conversationHeads_.
+    open_new_segment(sealed->lastId.load() + 1);
+}
+
+std::int64_t LogMessageRepository::save(const chatserver::domain::message::Message& message) {
+    thread_local std::string record;
+    const auto conversation = message.conversation_id().value();
+    // Невалидная пара участников отбрасывается до записи в журнал.
+    std::uint64_t id;
+    {
+        std::lock_guard lock(appendMutex_);
+        id = lastId_.load(std::memory_order_relaxed) + 1;
+        // Читать conversationHeads_ без блокировки можно: меняет его только писатель под appendMutex_.
+        const auto head = conversationHeads_.find(conversation);
+        encode_record(record, id, head == conversationHeads_.end() ? 0 : head->second, message);
+
+        if (active_->size.load(std::memory_order_relaxed) > 0 &&
+            active_->size.load(std::memory_order_relaxed) + record.size() > options_.maxSegmentBytes) {
+            roll_segment();
+        }
+
+        auto& seg = *active_;
+        const auto offset = seg.size.load(std::memory_order_relaxed);
+        write_fully(seg.fd, record.data(), record.size(), offset);
+        if (offset == 0 || offset - seg.lastIndexedOffset >= options_.indexIntervalBytes) {
+            seg.add_index(id, offset);
+        }
+        seg.size.store(offset + record.size(), std::memory_order_release);
+        seg.lastId.store(id, std::memory_order_release);
+        lastId_.store(id, std::memory_order_release);
+
+        // Голова переписки сдвигается только после публикации записи:
+        // find_page, увидев новый id, гарантированно его прочитает.
+        seg.heads[conversation] = id;
+        {
+            std::unique_lock headsLock(headsMutex_);
+            conversationHeads_[conversation] = id;
+        }
+
+        if (options_.fsyncPolicy == FsyncPolicy::EveryWrite) {
+            if (::fdatasync(seg.fd) != 0) throw_errno("fdatasync " + seg.path);
+            std::lock_guard syncLock(syncMutex_);
+            syncedId_ = id;
+        }
+    }
+
+    if (options_.fsyncPolicy == FsyncPolicy::GroupCommit) {
+        wait_durable(id);
+    }
+    return static_cast<std::int64_t>(id);
+}
+
+void LogMessageRepository::wait_durable(std::uint64_t id) {
+    // Group commit: первый пришедший писатель становится лидером и делает fdatasync
+    // за всех, кто дописал к этому моменту; остальные ждут на condition_variable.
+    // Под нагрузкой один fdatasync подтверждает десятки записей.
+    std::unique_lock lock(syncMutex_);
+    while (syncedId_ < id) {
+        if (syncInProgress_) {
+            syncCv_.wait(lock);
+            continue;
+        }
+        syncInProgress_ = true;
+        lock.unlock();
+        bool ok = true;
+        try {
+            sync_up_to_latest();
+        } catch (...) {
+            ok = false;
+        }
+        lock.lock();
+        syncInProgress_ = false;
+        syncCv_.notify_all();
+        if (!ok) {
+            throw std::runtime_error("log store: fdatasync failed");
+        }
+    }
+}
+
+void LogMessageRepository::sync_up_to_latest() {
+    std::shared_ptr<Segment> seg;
+    std::uint64_t target;
+    {
+        std::lock_guard lock(appendMutex_);
+        seg = active_;
+        target = lastId_.load(std::memory_order_relaxed);
+    }
+    // fdatasync вне appendMutex_: писатели продолжают дописывать, пока идёт синхронизация.
+    // Всё до target в более старых сегментах уже синхронизировано в roll_segment().
+    if (::fdatasync(seg->fd) != 0) throw_errno("fdatasync " + seg->path);
+    {
+        std::lock_guard lock(syncMutex_);
+        syncedId_ = std::max(syncedId_, target);
+    }
+    syncCv_.notify_all();
+}
+
+void LogMessageRepository::sync() {
+    sync_up_to_latest();
+}
+
+void LogMessageRepository::interval_flusher() {
+    while (!stopping_) {
+        {
+            std::unique_lock lock(syncMutex_);
+            syncCv_.wait_for(lock, options_.fsyncInterval, [this] { return stopping_.load(); });
+        }
+        if (stopping_) break;
+        try {
+            sync_up_to_latest();
+        } catch (const std::exception& ex) {
+            std::cerr << "[LogMessageRepository] interval fsync failed: " << ex.what() << std::endl;
+        }
+    }
+}
+
+std::shared_ptr<LogMessageRepository::Segment> LogMessageRepository::segment_for(std::uint64_t id) const {
+    std::shared_lock lock(segmentsMutex_);
+    auto it = segments_.upper_bound(id);
+    if (it == segments_.begin()) return nullptr;
+    return std::prev(it)->second;
+}
+
+std::optional<chatserver::domain::message::Message>
+LogMessageRepository::read_record(std::uint64_t uid, std::uint64_t* prevInConversation) const {
+    if (uid == 0 || uid > lastId_.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+    auto seg = segment_for(uid);
+    if (!seg || seg->lastId.load(std::memory_order_acquire) < uid) {
+        return std::nullopt;
+    }
+
+    const auto committed = seg->size.load(std::memory_order_acquire);
+    auto map = seg->map_at_least(committed, options_.maxSegmentBytes);
+    if (!map) return std::nullopt;
+
+    // От точки индекса идём по длинам записей; CRC проверяем только у найденной.
+    std::uint64_t offset = seg->scan_start(uid);
+    while (offset < committed) {
+        auto rec = decode_record(map->data, static_cast<std::size_t>(committed), offset, false);
+        if (!rec || rec->id > uid) break;
+        if (rec->id == uid) {
+            if (!decode_record(map->data, static_cast<std::size_t>(committed), offset)) {
+                throw std::runtime_error("log store: CRC mismatch for message " + std::to_string(uid));
+            }
+            if (prevInConversation) *prevInConversation = rec->prevInConversation;
+            return to_message(*rec);
+        }
+        offset += rec->totalSize;
+    }
+    return std::nullopt;
+}
+
+std::optional<chatserver::domain::message::Message>
+LogMessageRepository::find_by_id(std::int64_t id) const {
+    if (id <= 0) return std::nullopt;
+    return read_record(static_cast<std::uint64_t>(id), nullptr);
+}
+
+std::uint64_t LogMessageRepository::conversation_head(std::int64_t conversationId) const {
+    std::shared_lock lock(headsMutex_);
+    auto it = conversationHeads_.find(conversationId);
+    return it == conversationHeads_.end() ? 0 : it->second;
+}
+
+std::vector<chatserver::domain::message::Message>
+LogMessageRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit
+) const {
+    std::vector<chatserver::domain::message::Message> page;
+    if (limit == 0 || (before && before->value() <= 1)) {
+        return page;
+    }
+
+    std::uint64_t next = conversation_head(conversation.value());
+    if (before && next >= static_cast<std::uint64_t>(before->value())) {
+        // Обычный случай: курсор — id последнего сообщения предыдущей страницы этой же
+        // переписки, и следующая страница начинается с его обратной ссылки.
+        const auto cursor = static_cast<std::uint64_t>(before->value());
+        std::uint64_t prev = 0;
+        auto anchor = read_record(cursor, &prev);
+        if (anchor && (anchor->receiver_id().value() != 0 || anchor->group_id()) &&
+            anchor->conversation_id() == conversation) {
+            next = prev;
+        } else {
+            // Произвольный before: идём по цепочке от головы до первого id < before.
+            while (next >= cursor) {
+                if (!read_record(next, &next)) return page;
+            }
+        }
+    }
+
+    while (next != 0 && page.size() < limit) {
+        std::uint64_t prev = 0;
+        auto message = read_record(next, &prev);
+        if (!message) {
+            throw std::runtime_error("log store: broken conversation chain at message " + std::to_string(next));
+        }
+        page.push_back(std::move(*message));
+        next = prev;
+    }
+    return page;
+}
+
+std::int64_t LogMessageRepository::last_id() const {
+    return static_cast<std::int64_t>(lastId_.load(std::memory_order_acquire));
+}
+
+} // namespace chatserver::infrastructure::repository
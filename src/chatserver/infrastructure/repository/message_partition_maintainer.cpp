@@ -0,0 +1,247 @@
+#include "chatserver/infrastructure/repository/message_partition_maintainer.h"
+
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+namespace {
+
+struct Existing {
+    std::string name;
+    std::optional<std::int64_t> fromUnix;
+    std::optional<std::int64_t> toUnix;
+    // nullopt — MINVALUE / MAXVALUE (messages_legacy начинается с MINVALUE).
+    bool isDefault = false;
+    bool detachPending = false;
+};
+
+std::string format_utc(std::int64_t unixSeconds) {
+    const std::time_t t = static_cast<std::time_t>(unixSeconds);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+bool overlaps(const Existing& e, const PartitionRange& r) {
+    if (e.isDefault) return false;
+    const bool startsBeforeEnd = !e.fromUnix || *e.fromUnix < r.toUnix;
+    const bool endsAfterStart = !e.toUnix || *e.toUnix > r.fromUnix;
+    return startsBeforeEnd && endsAfterStart;
+}
+
+}
+
+PartitionInterval parse_partition_interval(const std::string& name) {
+    if (name == "none") return PartitionInterval::None;
+    if (name == "daily") return PartitionInterval::Daily;
+    if (name == "monthly") return PartitionInterval::Monthly;
+    throw std::invalid_argument("Unknown messages_partitions: " + name + " (expected none, daily or monthly)");
+}
+
+PartitionRange partition_for(PartitionInterval interval, std::int64_t unixSeconds) {
+    if (interval == PartitionInterval::None) {
+        throw std::invalid_argument("partition_for: table is not partitioned");
+    }
+    const std::time_t t = static_cast<std::time_t>(unixSeconds);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    char name[48];
+    // С запасом под худший случай int в %04d%02d%02d: -Wformat-truncation.
+    PartitionRange range;
+    if (interval == PartitionInterval::Daily) {
+        std::snprintf(name, sizeof(name), "messages_p%04d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+        range.fromUnix = timegm(&tm);
+        range.toUnix = range.fromUnix + 24 * 60 * 60;
+    } else {
+        std::snprintf(name, sizeof(name), "messages_p%04d%02d", tm.tm_year + 1900, tm.tm_mon + 1);
+        tm.tm_mday = 1;
+        range.fromUnix = timegm(&tm);
+        tm.tm_mon += 1;
+        // timegm нормализует 13-й месяц в январь следующего года.
+        range.toUnix = timegm(&tm);
+    }
+    range.name = name;
+    return range;
+}
+
+MessagePartitionMaintainer::MessagePartitionMaintainer(std::string connStr, PartitionOptions options)
+    : connStr_(std::move(connStr))
+    , options_(options)
+{
+    if (options_.interval == PartitionInterval::None) {
+        throw std::invalid_argument("MessagePartitionMaintainer: partition interval is required");
+    }
+    if (options_.ahead < 1) {
+        throw std::invalid_argument("MessagePartitionMaintainer: ahead must be at least 1");
+    }
+    try {
+        run_once();
+    } catch (const std::exception& ex) {
+        std::cerr << "[MessagePartitionMaintainer] initial pass failed, will retry: " << ex.what() << std::endl;
+    }
+    thread_ = std::thread([this] { loop(); });
+}
+
+MessagePartitionMaintainer::~MessagePartitionMaintainer() {
+    stop();
+}
+
+void MessagePartitionMaintainer::stop() {
+    {
+        std::lock_guard lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MessagePartitionMaintainer::loop() {
+    while (true) {
+        const bool failed = !stats().lastError.empty();
+        const auto delay = failed ? std::chrono::minutes(1) : options_.checkInterval;
+        {
+            std::unique_lock lock(wakeMutex_);
+            if (wake_.wait_for(lock, delay, [this] { return stopping_; })) {
+                return;
+            }
+        }
+        try {
+            run_once();
+        } catch (const std::exception& ex) {
+            std::cerr << "[MessagePartitionMaintainer] pass failed: " << ex.what() << std::endl;
+        }
+    }
+}
+
+void MessagePartitionMaintainer::run_once() {
+    std::lock_guard run(runMutex_);
+    const auto now = static_cast<std::int64_t>(std::time(nullptr));
+    std::uint64_t created = 0;
+    std::uint64_t dropped = 0;
+    try {
+        pqxx::connection conn(connStr_);
+        if (!conn.is_open()) {
+            throw std::runtime_error("failed to open database connection");
+        }
+        // DETACH ... CONCURRENTLY нельзя выполнять в блоке транзакции.
+        pqxx::nontransaction txn(conn);
+
+        const auto kind = txn.exec("SELECT relkind FROM pg_class WHERE oid = to_regclass('messages')");
+        if (kind.empty()) {
+            throw std::runtime_error("table messages does not exist");
+        }
+        if (kind[0][0].as<std::string>() != "p") {
+            throw std::runtime_error("messages is not partitioned: convert it with tools/partition_messages.sh "
+                                     "or set messages_partitions = none");
+        }
+
+        // Границы партиций — из выражения FOR VALUES FROM ('...') TO ('...');
+        // MINVALUE/MAXVALUE дают NULL, DEFAULT — оба NULL.
+        const auto rows = txn.exec(
+            "SELECT c.relname, "
+            "EXTRACT(EPOCH FROM substring(pg_get_expr(c.relpartbound, c.oid) FROM 'FROM \\(''([^'']+)''\\)')::timestamp)::BIGINT, "
+            "EXTRACT(EPOCH FROM substring(pg_get_expr(c.relpartbound, c.oid) FROM 'TO \\(''([^'']+)''\\)')::timestamp)::BIGINT, "
+            "pg_get_expr(c.relpartbound, c.oid) = 'DEFAULT', i.inhdetachpending "
+            "FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid "
+            "WHERE i.inhparent = 'messages'::regclass");
+        std::vector<Existing> existing;
+        for (const auto& row : rows) {
+            Existing e;
+            e.name = row[0].as<std::string>();
+            if (!row[1].is_null()) e.fromUnix = row[1].as<std::int64_t>();
+            if (!row[2].is_null()) e.toUnix = row[2].as<std::int64_t>();
+            e.isDefault = row[3].as<bool>();
+            e.detachPending = row[4].as<bool>();
+            existing.push_back(std::move(e));
+        }
+
+        // Вперёд: текущий интервал и ahead следующих. Интервал, уже покрытый другой
+        // партицией (messages_legacy до момента конвертации), пропускаем.
+        std::int64_t cursor = now;
+        for (int k = 0; k <= options_.ahead; ++k) {
+            const auto range = partition_for(options_.interval, cursor);
+            cursor = range.toUnix;
+            if (std::any_of(existing.begin(), existing.end(), [&](const auto& e) { return overlaps(e, range); })) {
+                continue;
+            }
+            txn.exec("CREATE TABLE IF NOT EXISTS " + txn.quote_name(range.name) +
+                     " PARTITION OF messages FOR VALUES FROM ('" + format_utc(range.fromUnix) + "') TO ('" +
+                     format_utc(range.toUnix) + "')");
+            existing.push_back(Existing{range.name, range.fromUnix, range.toUnix, false, false});
+            ++created;
+            std::cerr << "[MessagePartitionMaintainer] created partition " << range.name << std::endl;
+        }
+
+        // Назад: партиции, целиком старше срока хранения.
+        if (options_.retention.count() > 0) {
+            const auto cutoff = now - std::chrono::duration_cast<std::chrono::seconds>(options_.retention).count();
+            for (auto it = existing.begin(); it != existing.end();) {
+                if (it->isDefault || !it->toUnix || *it->toUnix > cutoff) {
+                    ++it;
+                    continue;
+                }
+                // Прерванный DETACH CONCURRENTLY оставляет партицию «в отсоединении»:
+                // его нужно завершить (FINALIZE), а не начинать заново.
+                const auto name = txn.quote_name(it->name);
+                txn.exec("ALTER TABLE messages DETACH PARTITION " + name +
+                         (it->detachPending ? " FINALIZE" : " CONCURRENTLY"));
+                txn.exec("DROP TABLE " + name);
+                std::cerr << "[MessagePartitionMaintainer] dropped partition " << it->name
+                          << " (older than retention)" << std::endl;
+                ++dropped;
+                it = existing.erase(it);
+            }
+        }
+
+        // Докуда вставки гарантированно найдут партицию: идём от now по смежным диапазонам.
+        std::int64_t coveredUntil = now;
+        for (bool advanced = true; advanced;) {
+            advanced = false;
+            for (const auto& e : existing) {
+                if (!e.isDefault && (!e.fromUnix || *e.fromUnix <= coveredUntil) && e.toUnix &&
+                    *e.toUnix > coveredUntil) {
+                    coveredUntil = *e.toUnix;
+                    advanced = true;
+                }
+            }
+        }
+
+        std::lock_guard lock(statsMutex_);
+        ++stats_.runs;
+        stats_.created += created;
+        stats_.dropped += dropped;
+        stats_.partitions = existing.size();
+        stats_.coveredUntilUnix = coveredUntil;
+        stats_.lastRunUnix = now;
+        stats_.lastError.clear();
+    } catch (const std::exception& ex) {
+        std::lock_guard lock(statsMutex_);
+        ++stats_.runs;
+        ++stats_.failures;
+        stats_.created += created;
+        stats_.dropped += dropped;
+        stats_.lastRunUnix = now;
+        stats_.lastError = ex.what();
+        throw;
+    }
+}
+
+PartitionMaintenanceStats MessagePartitionMaintainer::stats() const {
+    std::lock_guard lock(statsMutex_);
+    return stats_;
+}
+
+}
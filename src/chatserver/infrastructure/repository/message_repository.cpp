@@ -1 +1,11 @@
 #include "chatserver/infrastructure/repository/message_repository.h"
+
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+std::size_t MessageRepository::save_batch(const std::vector<chatserver::domain::message::Message>&) {
+    throw std::logic_error("this message repository cannot store messages with assigned ids");
+}
+
+}
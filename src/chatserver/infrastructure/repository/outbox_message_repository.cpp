@@ -0,0 +1,716 @@
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+
+#include "chatserver/common/crc32c.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace chatserver::infrastructure::repository {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr std::uint8_t  kRecordVersion = 1;
+constexpr std::size_t   kHeaderSize = 8;
+// u32 length + u32 crc
+constexpr std::size_t   kFixedPayload = 1 + 8 + 8 + 8 + 8 + 4;
+// version + id + sender_id + receiver_id + created_at_us + text_len
+constexpr std::uint32_t kMaxPayload = 16u << 20;
+constexpr std::size_t   kMarkSize = 8 + 8 + 4;
+constexpr std::chrono::milliseconds kMaxBackoff{5000};
+constexpr const char* kFailedError = "outbox: fdatasync failed, not accepting messages until restart";
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::string segment_path(const std::string& dir, std::uint64_t number) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu.outbox", static_cast<unsigned long long>(number));
+    return (fs::path(dir) / name).string();
+}
+
+std::string mark_path(const std::string& dir) {
+    return (fs::path(dir) / "drained").string();
+}
+
+std::string rejected_path(const std::string& dir) {
+    return (fs::path(dir) / "rejected").string();
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void encode_record(std::string& out, const chatserver::domain::message::Message& message) {
+    const auto& text = message.text().value();
+    const auto payloadSize = static_cast<std::uint32_t>(kFixedPayload + text.size());
+    if (payloadSize > kMaxPayload) {
+        throw std::invalid_argument("message is too large for the outbox");
+    }
+    out.clear();
+    out.reserve(kHeaderSize + payloadSize);
+    put<std::uint32_t>(out, payloadSize);
+    put<std::uint32_t>(out, 0);
+    put<std::uint8_t>(out, kRecordVersion);
+    put<std::int64_t>(out, message.id().value());
+    put<std::int64_t>(out, message.sender_id().value());
+    // Как в журнале: групповое сообщение хранит минус id группы вместо получателя.
+    const auto group = message.group_id();
+    put<std::int64_t>(out, group ? -group->value() : message.receiver_id().value());
+    put<std::int64_t>(out, message.created_at().epoch_micros());
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(text.size()));
+    out.append(text);
+    const auto crc = common::crc32c(out.data() + kHeaderSize, payloadSize);
+    std::memcpy(out.data() + 4, &crc, sizeof(crc));
+}
+
+std::optional<chatserver::domain::message::Message>
+decode_record(const std::string& data, std::size_t offset, std::size_t* totalSize) {
+    // nullopt — запись обрезана или повреждена (граница рваного хвоста).
+    if (data.size() - offset < kHeaderSize) return std::nullopt;
+    const char* p = data.data() + offset;
+    const auto payloadSize = get<std::uint32_t>(p);
+    if (payloadSize < kFixedPayload || payloadSize > kMaxPayload) return std::nullopt;
+    if (data.size() - offset - kHeaderSize < payloadSize) return std::nullopt;
+    const char* payload = p + kHeaderSize;
+    if (common::crc32c(payload, payloadSize) != get<std::uint32_t>(p + 4)) return std::nullopt;
+    if (get<std::uint8_t>(payload) != kRecordVersion) return std::nullopt;
+    const auto textSize = get<std::uint32_t>(payload + kFixedPayload - 4);
+    if (kFixedPayload + textSize != payloadSize) return std::nullopt;
+
+    *totalSize = kHeaderSize + payloadSize;
+    const chatserver::domain::MessageId id(get<std::int64_t>(payload + 1));
+    const chatserver::domain::UserId sender(get<std::int64_t>(payload + 9));
+    const auto receiver = get<std::int64_t>(payload + 17);
+    const auto createdAt = chatserver::domain::Timestamp::from_micros(get<std::int64_t>(payload + 25));
+    chatserver::domain::MessageText text(std::string(payload + kFixedPayload, textSize));
+    if (receiver < 0) {
+        return chatserver::domain::message::Message(
+            id, sender, chatserver::domain::GroupId(-receiver), std::move(text), createdAt);
+    }
+    return chatserver::domain::message::Message(
+        id, sender, chatserver::domain::UserId(receiver), std::move(text), createdAt);
+}
+
+void write_fully(int fd, const char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("outbox pwrite");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+std::string read_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw_errno("open " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw_errno("fstat " + path);
+    }
+    std::string data(static_cast<std::size_t>(st.st_size), '\0');
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::pread(fd, data.data() + done, data.size() - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            throw_errno("read " + path);
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return data;
+}
+
+void fsync_directory(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) throw_errno("open outbox directory");
+    ::fsync(fd);
+    ::close(fd);
+}
+
+}
+
+struct OutboxMessageRepository::SegmentFile {
+    std::uint64_t number = 0;
+    std::string path;
+    int fd = -1;
+
+    ~SegmentFile() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+OutboxMessageRepository::OutboxMessageRepository(std::shared_ptr<MessageRepository> inner,
+                                                 OutboxOptions options)
+    : inner_(std::move(inner))
+    , options_(std::move(options))
+{
+    if (!inner_) {
+        throw std::invalid_argument("OutboxMessageRepository: inner repository is required");
+    }
+    if (options_.directory.empty()) {
+        throw std::invalid_argument("OutboxMessageRepository: directory is required");
+    }
+    if (options_.batchSize == 0 || options_.maxPending == 0) {
+        throw std::invalid_argument("OutboxMessageRepository: batchSize and maxPending must be positive");
+    }
+    replay();
+    drainer_ = std::thread([this] { drain_loop(); });
+}
+
+OutboxMessageRepository::~OutboxMessageRepository() {
+    {
+        std::lock_guard lock(pendingMutex_);
+        stopping_ = true;
+    }
+    pendingCv_.notify_all();
+    if (drainer_.joinable()) {
+        drainer_.join();
+    }
+    const auto left = stats().pending;
+    if (left > 0) {
+        std::cerr << "[OutboxMessageRepository] stopping with " << left
+                  << " undrained messages; they will be replayed on next start" << std::endl;
+    }
+}
+
+void OutboxMessageRepository::replay() {
+    fs::create_directories(options_.directory);
+
+    std::uint64_t markSegment = 0;
+    std::uint64_t markOffset = 0;
+    if (fs::exists(mark_path(options_.directory))) {
+        const auto mark = read_file(mark_path(options_.directory));
+        // Битая или недописанная отметка — читаем всё: повтор отсеется по id.
+        if (mark.size() == kMarkSize &&
+            get<std::uint32_t>(mark.data() + 16) == common::crc32c(mark.data(), 16)) {
+            markSegment = get<std::uint64_t>(mark.data());
+            markOffset = get<std::uint64_t>(mark.data() + 8);
+        }
+    }
+
+    std::vector<std::uint64_t> numbers;
+    for (const auto& entry : fs::directory_iterator(options_.directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".outbox") continue;
+        try {
+            numbers.push_back(std::stoull(entry.path().stem().string()));
+        } catch (const std::exception&) {
+            std::cerr << "[OutboxMessageRepository] skipping foreign file " << entry.path() << std::endl;
+        }
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    const auto now = std::chrono::steady_clock::now();
+    std::uint64_t lastNumber = markSegment;
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+        const auto number = numbers[i];
+        const auto path = segment_path(options_.directory, number);
+        lastNumber = std::max(lastNumber, number);
+        if (number < markSegment) {
+            // Слит целиком, но не удалён до падения.
+            fs::remove(path);
+            continue;
+        }
+        if (oldestSegment_ == 0) oldestSegment_ = number;
+        ++segments_;
+
+        const auto data = read_file(path);
+        std::size_t offset = number == markSegment && markOffset <= data.size() ? markOffset : 0;
+        while (offset < data.size()) {
+            std::size_t total = 0;
+            auto message = decode_record(data, offset, &total);
+            if (!message) break;
+            offset += total;
+            maxReplayedId_ = std::max(maxReplayedId_, message->id().value());
+            byConversation_[message->conversation_id().value()].emplace(message->id().value(), *message);
+            pending_.push_back(Pending{std::move(*message), ++seq_, number, offset, now});
+        }
+        if (offset != data.size()) {
+            if (i + 1 != numbers.size()) {
+                throw std::runtime_error("outbox: corrupted record in sealed segment " + path);
+            }
+            std::cerr << "[OutboxMessageRepository] truncating torn tail of " << path << ": "
+                      << (data.size() - offset) << " bytes at offset " << offset << std::endl;
+            fs::resize_file(path, offset);
+        }
+        // Неподтверждённые до падения записи могли не дойти до диска: синхронизируем,
+        // прежде чем drainer отправит их в хранилище.
+        int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) throw_errno("open " + path);
+        const int rc = ::fdatasync(fd);
+        ::close(fd);
+        if (rc != 0) throw_errno("fdatasync " + path);
+    }
+
+    replayed_ = pending_.size();
+    syncedSeq_ = seq_;
+    drainedSeq_ = 0;
+    if (!pending_.empty()) {
+        std::cerr << "[OutboxMessageRepository] replaying " << pending_.size()
+                  << " undrained messages from " << options_.directory << std::endl;
+    }
+    open_segment(lastNumber + 1);
+    if (oldestSegment_ == 0) oldestSegment_ = lastNumber + 1;
+}
+
+void OutboxMessageRepository::open_segment(std::uint64_t number) {
+    auto seg = std::make_shared<SegmentFile>();
+    seg->number = number;
+    seg->path = segment_path(options_.directory, number);
+    seg->fd = ::open(seg->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (seg->fd < 0) throw_errno("create " + seg->path);
+    fsync_directory(options_.directory);
+    active_ = std::move(seg);
+    size_ = 0;
+    ++segments_;
+}
+
+void OutboxMessageRepository::roll_segment() {
+    // Под appendMutex_: закрываемый сегмент уходит на диск целиком, дальше его
+    // записи ждать group commit уже не нужно.
+    if (::fdatasync(active_->fd) != 0) {
+        const auto error = errno;
+        std::cerr << "[OutboxMessageRepository] fdatasync failed: " << std::strerror(error) << std::endl;
+        fail_closed();
+        throw std::system_error(error, std::generic_category(), "fdatasync " + active_->path);
+    }
+    ++fsyncs_;
+    {
+        std::lock_guard lock(syncMutex_);
+        syncedSeq_ = std::max(syncedSeq_.load(), seq_);
+        syncedSegment_ = active_->number;
+        syncedSize_ = size_;
+    }
+    syncCv_.notify_all();
+    open_segment(active_->number + 1);
+}
+
+std::int64_t OutboxMessageRepository::save(const chatserver::domain::message::Message& message) {
+    if (message.id().value() == 0) {
+        throw std::invalid_argument("outbox requires a message id assigned before save (MessageIdGenerator)");
+    }
+    thread_local std::string record;
+    encode_record(record, message);
+
+    {
+        std::unique_lock lock(pendingMutex_);
+        if (pending_.size() >= options_.maxPending) {
+            ++throttled_;
+            pendingCv_.wait(lock, [this] {
+                return stopping_ || failed_ || pending_.size() < options_.maxPending;
+            });
+        }
+        if (stopping_) {
+            throw std::runtime_error("outbox is stopping");
+        }
+    }
+
+    std::uint64_t seq;
+    {
+        std::lock_guard lock(appendMutex_);
+        if (failed_) {
+            throw std::runtime_error(kFailedError);
+        }
+        if (size_ > 0 && size_ + record.size() > options_.maxSegmentBytes) {
+            roll_segment();
+        }
+        try {
+            write_fully(active_->fd, record.data(), record.size(), size_);
+        } catch (const std::exception&) {
+            // Недописанная запись (ENOSPC посреди записи) осталась бы за size_, и
+            // roll_segment() запечатал бы её в сегмент — рестарт счёл бы его битым.
+            if (::ftruncate(active_->fd, static_cast<off_t>(size_)) != 0) {
+                std::cerr << "[OutboxMessageRepository] failed to truncate " << active_->path
+                          << " after a failed write: " << std::strerror(errno) << std::endl;
+                fail_closed();
+            }
+            throw;
+        }
+        size_ += record.size();
+        seq = ++seq_;
+        // Очередь drainer'а — в порядке записи: он снимает пачки с головы.
+        std::lock_guard pendingLock(pendingMutex_);
+        byConversation_[message.conversation_id().value()].emplace(message.id().value(), message);
+        pending_.push_back(Pending{message, seq, active_->number, size_, std::chrono::steady_clock::now()});
+    }
+
+    wait_durable(seq);
+    ++appended_;
+    return message.id().value();
+}
+
+void OutboxMessageRepository::wait_durable(std::uint64_t seq) {
+    // Group commit, как в LogMessageRepository: первый пришедший делает fdatasync
+    // за всех, кто дописал к этому моменту; остальные ждут.
+    std::unique_lock lock(syncMutex_);
+    while (syncedSeq_.load() < seq) {
+        if (failed_) {
+            throw std::runtime_error(kFailedError);
+        }
+        if (syncInProgress_) {
+            syncCv_.wait(lock);
+            continue;
+        }
+        syncInProgress_ = true;
+        lock.unlock();
+        try {
+            sync_active();
+        } catch (const std::exception& ex) {
+            std::cerr << "[OutboxMessageRepository] fdatasync failed: " << ex.what() << std::endl;
+            std::lock_guard appendLock(appendMutex_);
+            fail_closed();
+        }
+        lock.lock();
+        syncInProgress_ = false;
+        syncCv_.notify_all();
+    }
+}
+
+void OutboxMessageRepository::sync_active() {
+    std::shared_ptr<SegmentFile> seg;
+    std::uint64_t target;
+    std::uint64_t size;
+    {
+        std::lock_guard lock(appendMutex_);
+        seg = active_;
+        target = seq_;
+        size = size_;
+    }
+    // Вне appendMutex_: писатели дописывают, пока идёт синхронизация. Записи более
+    // старых сегментов синхронизированы в roll_segment().
+    if (::fdatasync(seg->fd) != 0) throw_errno("fdatasync " + seg->path);
+    ++fsyncs_;
+    {
+        std::lock_guard lock(syncMutex_);
+        if (failed_) {
+            // roll_segment() уже выбросил эти записи, пока шла синхронизация.
+            throw std::runtime_error(kFailedError);
+        }
+        syncedSeq_ = std::max(syncedSeq_.load(), target);
+        if (seg->number > syncedSegment_ || (seg->number == syncedSegment_ && size > syncedSize_)) {
+            syncedSegment_ = seg->number;
+            syncedSize_ = size;
+        }
+    }
+    syncCv_.notify_all();
+    {
+        // Пустая критическая секция: drainer не пропустит пробуждение между
+        // проверкой syncedSeq_ и ожиданием.
+        std::lock_guard lock(pendingMutex_);
+    }
+    pendingCv_.notify_all();
+}
+
+void OutboxMessageRepository::fail_closed() {
+    // Под appendMutex_: новых записей не будет, пока очередь и файл приводятся к
+    // синхронизированному префиксу.
+    std::uint64_t synced;
+    std::uint64_t keep;
+    {
+        std::lock_guard lock(syncMutex_);
+        if (failed_) return;
+        failed_ = true;
+        synced = syncedSeq_.load();
+        keep = syncedSegment_ == active_->number ? syncedSize_ : 0;
+    }
+    syncCv_.notify_all();
+
+    std::size_t dropped = 0;
+    {
+        // Записи после synced — хвост очереди: drainer их ещё не брал.
+        std::lock_guard lock(pendingMutex_);
+        while (!pending_.empty() && pending_.back().seq > synced) {
+            const auto& message = pending_.back().message;
+            auto it = byConversation_.find(message.conversation_id().value());
+            if (it != byConversation_.end()) {
+                it->second.erase(message.id().value());
+                if (it->second.empty()) byConversation_.erase(it);
+            }
+            pending_.pop_back();
+            ++dropped;
+        }
+    }
+    pendingCv_.notify_all();
+
+    // Чтобы рестарт не переслал неподтверждённое. Не вышло — повтор отсеется только
+    // по id, а клиент мог уже отправить сообщение заново под новым.
+    if (::ftruncate(active_->fd, static_cast<off_t>(keep)) != 0) {
+        std::cerr << "[OutboxMessageRepository] failed to truncate " << active_->path
+                  << " after fdatasync error: " << std::strerror(errno) << std::endl;
+    }
+    std::cerr << "[OutboxMessageRepository] outbox closed for writes until restart; dropped "
+              << dropped << " unsynced messages" << std::endl;
+}
+
+void OutboxMessageRepository::drain_loop() {
+    auto backoff = options_.retryBackoff;
+    std::vector<chatserver::domain::message::Message> batch;
+    batch.reserve(options_.batchSize);
+    while (true) {
+        std::uint64_t lastSegment = 0;
+        std::uint64_t lastOffset = 0;
+        std::uint64_t lastSeq = 0;
+        batch.clear();
+        {
+            std::unique_lock lock(pendingMutex_);
+            const auto ready = [this] {
+                return !pending_.empty() && pending_.front().seq <= syncedSeq_.load();
+            };
+            pendingCv_.wait_for(lock, std::chrono::milliseconds(50),
+                                [&] { return stopping_ || ready(); });
+            if (stopping_) return;
+            if (!ready()) continue;
+            const auto synced = syncedSeq_.load();
+            for (const auto& entry : pending_) {
+                if (batch.size() == options_.batchSize || entry.seq > synced) break;
+                batch.push_back(entry.message);
+                lastSegment = entry.segment;
+                lastOffset = entry.endOffset;
+                lastSeq = entry.seq;
+            }
+        }
+
+        std::size_t written = 0;
+        std::vector<chatserver::domain::message::Message> rejected;
+        try {
+            try {
+                written = inner_->save_batch(batch);
+            } catch (const MessageRejectedError& ex) {
+                std::cerr << "[OutboxMessageRepository] storage rejected a batch of " << batch.size()
+                          << " messages, isolating the bad ones: " << ex.what() << std::endl;
+                written = save_isolating(batch, rejected);
+                write_rejected(rejected);
+            }
+        } catch (const std::exception& ex) {
+            ++failures_;
+            std::cerr << "[OutboxMessageRepository] drain of " << batch.size()
+                      << " messages failed, retrying in " << backoff.count() << " ms: " << ex.what() << std::endl;
+            std::unique_lock lock(pendingMutex_);
+            pendingCv_.wait_for(lock, backoff, [this] { return stopping_; });
+            backoff = std::min(backoff * 2, kMaxBackoff);
+            continue;
+        }
+        backoff = options_.retryBackoff;
+        ++batches_;
+        const auto stored = batch.size() - rejected.size();
+        drained_ += stored;
+        rejected_ += rejected.size();
+        duplicates_ += stored - std::min(written, stored);
+
+        {
+            // Снимаем с головы ровно отправленную пачку: снимает только drainer.
+            std::lock_guard lock(pendingMutex_);
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                const auto& message = pending_.front().message;
+                auto it = byConversation_.find(message.conversation_id().value());
+                if (it != byConversation_.end()) {
+                    it->second.erase(message.id().value());
+                    if (it->second.empty()) byConversation_.erase(it);
+                }
+                pending_.pop_front();
+            }
+        }
+        pendingCv_.notify_all();
+
+        try {
+            write_drained_mark(lastSegment, lastOffset);
+            remove_segments_before(lastSegment);
+        } catch (const std::exception& ex) {
+            // Не страшно: при старте слитое отправится ещё раз и отсеется по id.
+            std::cerr << "[OutboxMessageRepository] failed to record drain progress: " << ex.what() << std::endl;
+        }
+        {
+            // flush() видит пачку слитой, когда отметка уже записана.
+            std::lock_guard lock(pendingMutex_);
+            drainedSeq_ = lastSeq;
+        }
+        pendingCv_.notify_all();
+    }
+}
+
+std::size_t OutboxMessageRepository::save_isolating(
+    std::vector<chatserver::domain::message::Message> batch,
+    std::vector<chatserver::domain::message::Message>& rejected)
+{
+    // Делим пополам, пока отказ не сведётся к отдельным сообщениям: k плохих в пачке
+    // из n — O(k log n) запросов. Прочие ошибки уходят наверх, и пачка повторится
+    // целиком (уже записанные части хранилище пропустит по id).
+    try {
+        return inner_->save_batch(batch);
+    } catch (const MessageRejectedError& ex) {
+        if (batch.size() == 1) {
+            const auto& message = batch.front();
+            std::cerr << "[OutboxMessageRepository] message " << message.id().value()
+                      << " from " << message.sender_id().value()
+                      << " rejected by storage, moved to " << rejected_path(options_.directory)
+                      << ": " << ex.what() << std::endl;
+            rejected.push_back(message);
+            return 0;
+        }
+    }
+    const auto middle = batch.begin() + static_cast<std::ptrdiff_t>(batch.size() / 2);
+    std::vector<chatserver::domain::message::Message> tail(middle, batch.end());
+    batch.erase(middle, batch.end());
+    const auto written = save_isolating(std::move(batch), rejected);
+    return written + save_isolating(std::move(tail), rejected);
+}
+
+void OutboxMessageRepository::write_rejected(const std::vector<chatserver::domain::message::Message>& rejected) {
+    // С fdatasync: после отметки drained это единственная копия сообщений.
+    if (rejected.empty()) return;
+    std::string buf;
+    std::string record;
+    for (const auto& message : rejected) {
+        encode_record(record, message);
+        buf += record;
+    }
+    const auto path = rejected_path(options_.directory);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) throw_errno("open " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw_errno("fstat " + path);
+    }
+    try {
+        write_fully(fd, buf.data(), buf.size(), static_cast<std::uint64_t>(st.st_size));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    const int rc = ::fdatasync(fd);
+    ::close(fd);
+    if (rc != 0) throw_errno("fdatasync " + path);
+}
+
+void OutboxMessageRepository::write_drained_mark(std::uint64_t segment, std::uint64_t offset) {
+    std::string buf;
+    put<std::uint64_t>(buf, segment);
+    put<std::uint64_t>(buf, offset);
+    put<std::uint32_t>(buf, common::crc32c(buf.data(), buf.size()));
+
+    const auto path = mark_path(options_.directory);
+    const auto tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw_errno("create " + tmp);
+    try {
+        write_fully(fd, buf.data(), buf.size(), 0);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    // Без fsync: потерянная отметка означает лишь повторную пересылку (см. заголовок).
+    if (::rename(tmp.c_str(), path.c_str()) != 0) throw_errno("rename " + tmp);
+}
+
+void OutboxMessageRepository::remove_segments_before(std::uint64_t segment) {
+    // Сегменты до segment закрыты (активный не старше последней слитой записи) и слиты.
+    while (oldestSegment_ < segment) {
+        std::error_code ec;
+        fs::remove(segment_path(options_.directory, oldestSegment_), ec);
+        if (ec) throw std::system_error(ec, "remove outbox segment");
+        ++oldestSegment_;
+        --segments_;
+    }
+}
+
+std::vector<chatserver::domain::message::Message> OutboxMessageRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit) const
+{
+    // Сначала неслитые, потом хранилище: сообщение, слитое между двумя чтениями,
+    // попадёт в обе выборки (и отсеется), а не выпадет из обеих.
+    std::vector<chatserver::domain::message::Message> fresh;
+    {
+        std::lock_guard lock(pendingMutex_);
+        auto it = byConversation_.find(conversation.value());
+        if (it != byConversation_.end()) {
+            auto end = before ? it->second.lower_bound(before->value()) : it->second.end();
+            while (end != it->second.begin() && fresh.size() < limit) {
+                --end;
+                fresh.push_back(end->second);
+            }
+        }
+    }
+    auto page = inner_->find_page(conversation, before, limit);
+    if (fresh.empty()) {
+        return page;
+    }
+
+    page.insert(page.end(), std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+    std::sort(page.begin(), page.end(), [](const auto& a, const auto& b) {
+        return a.id().value() > b.id().value();
+    });
+    page.erase(std::unique(page.begin(), page.end(), [](const auto& a, const auto& b) {
+        return a.id().value() == b.id().value();
+    }), page.end());
+    if (page.size() > limit) {
+        page.erase(page.begin() + static_cast<std::ptrdiff_t>(limit), page.end());
+    }
+    return page;
+}
+
+bool OutboxMessageRepository::flush(std::chrono::milliseconds timeout) {
+    std::uint64_t target;
+    {
+        std::lock_guard lock(appendMutex_);
+        // После сбоя fdatasync несинхронизированные записи выброшены и слиты не будут.
+        target = failed_ ? syncedSeq_.load() : seq_;
+    }
+    std::unique_lock lock(pendingMutex_);
+    return pendingCv_.wait_for(lock, timeout, [this, target] { return drainedSeq_ >= target; });
+}
+
+OutboxStats OutboxMessageRepository::stats() const {
+    OutboxStats s;
+    s.appended = appended_.load(std::memory_order_relaxed);
+    s.fsyncs = fsyncs_.load(std::memory_order_relaxed);
+    s.replayed = replayed_.load(std::memory_order_relaxed);
+    s.drained = drained_.load(std::memory_order_relaxed);
+    s.duplicates = duplicates_.load(std::memory_order_relaxed);
+    s.batches = batches_.load(std::memory_order_relaxed);
+    s.failures = failures_.load(std::memory_order_relaxed);
+    s.rejected = rejected_.load(std::memory_order_relaxed);
+    s.throttled = throttled_.load(std::memory_order_relaxed);
+    s.segments = segments_.load(std::memory_order_relaxed);
+    s.failed = failed_.load(std::memory_order_relaxed);
+    std::lock_guard lock(pendingMutex_);
+    s.pending = pending_.size();
+    if (!pending_.empty()) {
+        s.oldestPendingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - pending_.front().appendedAt).count();
+    }
+    return s;
+}
+
+}
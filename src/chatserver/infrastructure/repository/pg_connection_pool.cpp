@@ -0,0 +1,140 @@
+#include "chatserver/infrastructure/repository/pg_connection_pool.h"
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+// Helper to mask password in connection string for safe logging
+static std::string mask_connstr(const std::string& s) {
+    std::string out = s;
+    const std::string key = "password=";
+    auto pos = out.find(key);
+    if (pos != std::string::npos) {
+        auto start = pos + key.size();
+        out.replace(start, std::string::npos, "***");
+    }
+    return out;
+}
+
+PgConnectionPool::Lease::Lease(PgConnectionPool* pool, std::unique_ptr<pqxx::connection> conn)
+    : pool_(pool)
+    , conn_(std::move(conn)) {}
+
+PgConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_)
+    , conn_(std::move(other.conn_)) {}
+
+PgConnectionPool::Lease::~Lease() {
+    if (conn_) {
+        pool_->release(std::move(conn_));
+    }
+}
+
+void PgConnectionPool::Lease::discard() {
+    if (conn_) {
+        conn_->close();
+        pool_->release(std::move(conn_));
+    }
+}
+
+PgConnectionPool::PgConnectionPool(std::string connStr, PgPoolOptions options)
+    : connStr_(std::move(connStr))
+    , options_(options) {}
+
+PgConnectionPool::Lease PgConnectionPool::acquire() {
+    {
+        std::unique_lock lock(mutex_);
+        if (options_.size > 0) {
+            if (idle_.empty() && open_ >= options_.size) {
+                ++stats_.waits;
+                // Ждать дольше срока HTTP-запроса бессмысленно: клиент уже получит 504.
+                const auto left = concurrency::RequestDeadline::remaining();
+                const bool deadlineFirst = left && *left < options_.acquireTimeout;
+                const bool ready = available_.wait_for(lock, deadlineFirst ? *left : options_.acquireTimeout, [this] {
+                    return !idle_.empty() || open_ < options_.size;
+                });
+                if (!ready) {
+                    ++stats_.timeouts;
+                    if (deadlineFirst) {
+                        PgQueryDeadline::note_pool_wait_expired();
+                        concurrency::RequestDeadline::mark_exceeded();
+                        throw concurrency::DeadlineExceeded();
+                    }
+                    throw std::runtime_error("database connection pool exhausted");
+                }
+            }
+            if (!idle_.empty()) {
+                auto conn = std::move(idle_.back());
+                idle_.pop_back();
+                ++stats_.reused;
+                ++stats_.leased;
+                return Lease(this, std::move(conn));
+            }
+        }
+        ++open_;
+        ++stats_.leased;
+    }
+
+    // Открываем вне мьютекса: установка соединения — сетевой round-trip.
+    std::unique_ptr<pqxx::connection> conn;
+    try {
+        conn = std::make_unique<pqxx::connection>(connStr_);
+        if (!conn->is_open()) {
+            throw std::runtime_error("failed to open database connection");
+        }
+    } catch (...) {
+        std::cerr << "[PgConnectionPool] PQ connection failed: connstr=["
+                  << mask_connstr(connStr_) << "]" << std::endl;
+        std::lock_guard lock(mutex_);
+        --open_;
+        --stats_.leased;
+        available_.notify_one();
+        throw;
+    }
+    std::lock_guard lock(mutex_);
+    ++stats_.opened;
+    return Lease(this, std::move(conn));
+}
+
+void PgConnectionPool::release(std::unique_ptr<pqxx::connection> conn) {
+    std::unique_ptr<pqxx::connection> closing;
+    {
+        std::lock_guard lock(mutex_);
+        --stats_.leased;
+        if (options_.size > 0 && !closing_ && conn->is_open()) {
+            idle_.push_back(std::move(conn));
+        } else {
+            if (options_.size > 0 && !closing_) {
+                ++stats_.broken;
+            }
+            --open_;
+            closing = std::move(conn);
+        }
+    }
+    available_.notify_one();
+    // Закрытие (Terminate на сокете) — тоже вне мьютекса.
+    closing.reset();
+}
+
+void PgConnectionPool::close_idle() {
+    std::vector<std::unique_ptr<pqxx::connection>> closing;
+    {
+        std::lock_guard lock(mutex_);
+        closing_ = true;
+        closing.swap(idle_);
+        open_ -= closing.size();
+    }
+    available_.notify_all();
+}
+
+PgPoolStats PgConnectionPool::stats() const {
+    std::lock_guard lock(mutex_);
+    auto s = stats_;
+    s.idle = idle_.size();
+    return s;
+}
+
+}
@@ -0,0 +1,205 @@
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chatserver::infrastructure::repository {
+
+using concurrency::RequestDeadline;
+
+namespace {
+
+std::atomic<std::uint64_t> armedTotal{0};
+std::atomic<std::uint64_t> statementTimeoutsTotal{0};
+std::atomic<std::uint64_t> cancelledTotal{0};
+std::atomic<std::uint64_t> expiredBeforeQueryTotal{0};
+std::atomic<std::uint64_t> poolWaitExpiredTotal{0};
+
+class CancelWatchdog {
+// Один поток на процесс: ждёт ближайшего срока среди взведённых транзакций и
+// отменяет их запросы. PQcancel — сетевой обмен с сервером, поэтому идёт вне общего
+// мьютекса: arm()/disarm() других транзакций его не ждут. disarm() ждёт только
+// отмену своей же записи, так что после него соединение, ушедшее в пул и выданное
+// другому запросу, уже не будет отменено.
+public:
+    ~CancelWatchdog() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::uint64_t arm(pqxx::connection& conn, RequestDeadline::Clock::time_point fireAt) {
+        std::lock_guard lock(mutex_);
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this] { loop(); });
+        }
+        const auto ticket = ++nextTicket_;
+        auto entry = std::make_shared<Entry>();
+        entry->fireAt = fireAt;
+        entry->conn = &conn;
+        entries_.emplace(ticket, std::move(entry));
+        wake_.notify_all();
+        return ticket;
+    }
+
+    bool disarm(std::uint64_t ticket) {
+        // true — запрос этой транзакции был отменён.
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = entries_.find(ticket);
+            if (it == entries_.end()) {
+                return false;
+            }
+            entry = std::move(it->second);
+            entries_.erase(it);
+        }
+        std::unique_lock lock(entry->mutex);
+        entry->done.wait(lock, [&] { return !entry->cancelling; });
+        return entry->fired;
+    }
+
+private:
+    struct Entry {
+        RequestDeadline::Clock::time_point fireAt;
+        pqxx::connection* conn = nullptr;
+        std::mutex mutex;
+        std::condition_variable done;
+        bool fired = false;
+        bool cancelling = false;
+        // Под mutex записи: идёт PQcancel — disarm() ждёт его окончания на done.
+    };
+
+    void loop() {
+        std::unique_lock lock(mutex_);
+        std::vector<std::shared_ptr<Entry>> due;
+        while (!stopping_) {
+            auto next = RequestDeadline::Clock::time_point::max();
+            const auto now = RequestDeadline::Clock::now();
+            for (auto& [ticket, entry] : entries_) {
+                if (entry->fired) {
+                    continue;
+                }
+                if (entry->fireAt <= now) {
+                    std::lock_guard entryLock(entry->mutex);
+                    entry->fired = true;
+                    entry->cancelling = true;
+                    due.push_back(entry);
+                } else {
+                    next = std::min(next, entry->fireAt);
+                }
+            }
+            if (!due.empty()) {
+                lock.unlock();
+                for (auto& entry : due) {
+                    cancel(*entry);
+                }
+                due.clear();
+                lock.lock();
+                continue;
+            }
+            if (next == RequestDeadline::Clock::time_point::max()) {
+                wake_.wait(lock);
+            } else {
+                wake_.wait_until(lock, next);
+            }
+        }
+    }
+
+    static void cancel(Entry& entry) {
+        cancelledTotal.fetch_add(1, std::memory_order_relaxed);
+        try {
+            // PQcancel: отдельное короткое соединение с сервером, сам PGconn в другом
+            // потоке при этом не трогается. Соединение живо: его disarm() ждёт нас.
+            entry.conn->cancel_query();
+        } catch (const std::exception& ex) {
+            std::cerr << "[PgQueryDeadline] cancel failed: " << ex.what() << std::endl;
+        }
+        {
+            std::lock_guard lock(entry.mutex);
+            entry.cancelling = false;
+        }
+        entry.done.notify_all();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::map<std::uint64_t, std::shared_ptr<Entry>> entries_;
+    std::uint64_t nextTicket_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+CancelWatchdog& watchdog() {
+    static CancelWatchdog instance;
+    return instance;
+}
+
+}
+
+PgQueryDeadline::PgQueryDeadline(pqxx::connection& conn, pqxx::transaction_base& txn)
+    : uncaught_(std::uncaught_exceptions())
+{
+    const auto deadline = RequestDeadline::current();
+    if (!deadline) {
+        return;
+    }
+    const auto left = RequestDeadline::remaining();
+    if (left->count() <= 0) {
+        expiredBeforeQueryTotal.fetch_add(1, std::memory_order_relaxed);
+        RequestDeadline::mark_exceeded();
+        throw concurrency::DeadlineExceeded();
+    }
+    if (*left < kStatementTimeoutBelow) {
+        txn.exec("SET LOCAL statement_timeout = " + std::to_string(left->count()));
+    }
+    ticket_ = watchdog().arm(conn, *deadline + kCancelGrace);
+    armedTotal.fetch_add(1, std::memory_order_relaxed);
+}
+
+PgQueryDeadline::~PgQueryDeadline() {
+    if (ticket_ == 0) {
+        return;
+    }
+    const bool cancelled = watchdog().disarm(ticket_);
+    if (std::uncaught_exceptions() <= uncaught_) {
+        // Запрос успел завершиться (возможно, вместе с запоздавшей отменой) — ответ есть.
+        return;
+    }
+    if (cancelled) {
+        RequestDeadline::mark_exceeded();
+    } else if (RequestDeadline::Clock::now() >= *RequestDeadline::current()) {
+        statementTimeoutsTotal.fetch_add(1, std::memory_order_relaxed);
+        RequestDeadline::mark_exceeded();
+    }
+}
+
+QueryDeadlineStats PgQueryDeadline::stats() {
+    QueryDeadlineStats s;
+    s.armed = armedTotal.load(std::memory_order_relaxed);
+    s.statementTimeouts = statementTimeoutsTotal.load(std::memory_order_relaxed);
+    s.cancelled = cancelledTotal.load(std::memory_order_relaxed);
+    s.expiredBeforeQuery = expiredBeforeQueryTotal.load(std::memory_order_relaxed);
+    s.poolWaitExpired = poolWaitExpiredTotal.load(std::memory_order_relaxed);
+    return s;
+}
+
+void PgQueryDeadline::note_pool_wait_expired() {
+    poolWaitExpiredTotal.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
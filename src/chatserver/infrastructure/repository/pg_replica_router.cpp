@@ -0,0 +1,259 @@
+#include "chatserver/infrastructure/repository/pg_replica_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+namespace {
+
+// Отставание реплики в мс. Пока реплика проигрывает всё полученное, отставания нет,
+// даже если primary давно ничего не писал (время последней транзакции тогда старое).
+// Но «всё полученное» ничего не значит без потока WAL: реплика, у которой WAL receiver
+// отключён от primary, тоже проиграла всё, что получила, и выглядела бы свежей
+// бесконечно. Поэтому без status = 'streaming' — NULL (реплика непригодна). Статус
+// виден роли с pg_read_all_stats (или pg_monitor); без неё он NULL, и реплика
+// тоже считается непригодной. Не реплика (stand-in на primary) — 0.
+const char* kLagQuery =
+    "SELECT CASE WHEN NOT pg_is_in_recovery() THEN 0 "
+    "WHEN NOT EXISTS (SELECT 1 FROM pg_stat_wal_receiver WHERE status = 'streaming') THEN NULL "
+    "WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+    "ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) * 1000, 0) END";
+
+}
+
+ReplicaPolicy parse_replica_policy(const std::string& name) {
+    if (name == "round_robin") return ReplicaPolicy::RoundRobin;
+    if (name == "least_loaded") return ReplicaPolicy::LeastLoaded;
+    throw std::invalid_argument("Unknown db_replica_policy: " + name + " (expected round_robin or least_loaded)");
+}
+
+std::uint64_t replica_key(const std::string& value) {
+    const auto h = static_cast<std::uint64_t>(std::hash<std::string>{}(value));
+    return h == 0 ? 1 : h;
+}
+
+ReplicaSelector::ReplicaSelector(std::size_t replicas, ReplicaOptions options)
+    : options_(options)
+    , replicas_(replicas) {}
+
+bool ReplicaSelector::usable(const Replica& replica) const {
+    return !replica.failed && replica.lag && *replica.lag <= options_.maxLag;
+}
+
+std::optional<std::size_t> ReplicaSelector::pick(std::uint64_t key,
+                                                 Clock::time_point now,
+                                                 const std::vector<std::size_t>& load) {
+    std::lock_guard lock(mutex_);
+    if (replicas_.empty()) {
+        ++counters_.primaryReads;
+        return std::nullopt;
+    }
+    if (key != 0) {
+        auto it = sticky_.find(key);
+        if (it != sticky_.end()) {
+            if (it->second > now) {
+                ++counters_.stickyReads;
+                ++counters_.primaryReads;
+                return std::nullopt;
+            }
+            sticky_.erase(it);
+        }
+    }
+
+    const std::size_t n = replicas_.size();
+    std::optional<std::size_t> chosen;
+    for (std::size_t step = 0; step < n; ++step) {
+        const std::size_t i = (cursor_ + step) % n;
+        if (!usable(replicas_[i])) continue;
+        if (!chosen) {
+            chosen = i;
+            if (options_.policy == ReplicaPolicy::RoundRobin) break;
+        } else if (i < load.size() && *chosen < load.size() && load[i] < load[*chosen]) {
+            chosen = i;
+        }
+    }
+    if (!chosen) {
+        ++counters_.lagFallbacks;
+        ++counters_.primaryReads;
+        return std::nullopt;
+    }
+    cursor_ = (*chosen + 1) % n;
+    ++replicas_[*chosen].reads;
+    return chosen;
+}
+
+void ReplicaSelector::note_write(std::uint64_t key, Clock::time_point now) {
+    if (key == 0 || replicas_.empty() || options_.readYourWrites.count() <= 0) {
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    sticky_[key] = now + options_.readYourWrites;
+    if (sticky_.size() >= sweepAt_) {
+        std::erase_if(sticky_, [now](const auto& entry) { return entry.second <= now; });
+        sweepAt_ = std::max<std::size_t>(1024, sticky_.size() * 2);
+    }
+}
+
+bool ReplicaSelector::report_lag(std::size_t replica, std::optional<std::chrono::milliseconds> lag) {
+    std::lock_guard lock(mutex_);
+    auto& r = replicas_.at(replica);
+    r.lag = lag;
+    r.failed = !lag;
+    if (!lag) ++r.failures;
+    return usable(r);
+}
+
+void ReplicaSelector::report_failure(std::size_t replica) {
+    std::lock_guard lock(mutex_);
+    auto& r = replicas_.at(replica);
+    r.failed = true;
+    ++r.failures;
+}
+
+ReplicaRoutingStats ReplicaSelector::stats() const {
+    std::lock_guard lock(mutex_);
+    auto s = counters_;
+    s.stickyKeys = sticky_.size();
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+        ReplicaStats r;
+        r.name = "replica" + std::to_string(i);
+        r.reads = replicas_[i].reads;
+        r.failures = replicas_[i].failures;
+        if (!replicas_[i].failed && replicas_[i].lag) r.lagMs = replicas_[i].lag->count();
+        r.usable = usable(replicas_[i]);
+        s.replicas.push_back(std::move(r));
+    }
+    return s;
+}
+
+PgReplicaRouter::PgReplicaRouter(std::shared_ptr<PgConnectionPool> primary,
+                                 std::vector<std::shared_ptr<PgConnectionPool>> replicas,
+                                 ReplicaOptions options)
+    : primary_(std::move(primary))
+    , replicas_(std::move(replicas))
+    , options_(options)
+    , selector_(replicas_.size(), options)
+    , probedUsable_(replicas_.size())
+{
+    if (!primary_) {
+        throw std::invalid_argument("PgReplicaRouter: primary pool is required");
+    }
+    if (replicas_.empty()) {
+        return;
+    }
+    probe_once();
+    thread_ = std::thread([this] { loop(); });
+}
+
+PgReplicaRouter::~PgReplicaRouter() {
+    stop();
+}
+
+void PgReplicaRouter::stop() {
+    {
+        std::lock_guard lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void PgReplicaRouter::loop() {
+    while (true) {
+        {
+            std::unique_lock lock(wakeMutex_);
+            if (wake_.wait_for(lock, options_.lagCheckInterval, [this] { return stopping_; })) {
+                return;
+            }
+        }
+        probe_once();
+    }
+}
+
+void PgReplicaRouter::probe_once() {
+    std::lock_guard probeLock(probeMutex_);
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+        std::optional<std::chrono::milliseconds> lag;
+        std::string problem;
+        try {
+            auto conn = replicas_[i]->acquire();
+            pqxx::work txn(*conn);
+            const auto r = txn.exec(kLagQuery);
+            if (r[0][0].is_null()) {
+                problem = "is not streaming WAL from the primary";
+            } else {
+                lag = std::chrono::milliseconds(static_cast<std::int64_t>(std::ceil(r[0][0].as<double>())));
+            }
+            txn.commit();
+        } catch (const std::exception& ex) {
+            // Ошибка уже в журнале пула, если не удалось подключиться; здесь — о замере.
+            problem = std::string("lag probe failed: ") + ex.what();
+        }
+        const bool usable = selector_.report_lag(i, lag);
+
+        // Пока реплика лежит, замер раз в lagCheckInterval повторял бы одно и то же:
+        // пишем только переходы (и непригодность с первого замера).
+        auto& previous = probedUsable_[i];
+        const bool changed = previous ? *previous != usable : !usable;
+        previous = usable;
+        if (!changed) {
+            continue;
+        }
+        if (usable) {
+            std::cerr << "[PgReplicaRouter] replica" << i << " is back in rotation, lag "
+                      << lag->count() << " ms" << std::endl;
+        } else if (!problem.empty()) {
+            std::cerr << "[PgReplicaRouter] replica" << i << " " << problem << "; excluded" << std::endl;
+        } else {
+            std::cerr << "[PgReplicaRouter] replica" << i << " lags " << lag->count()
+                      << " ms behind the primary (max " << options_.maxLag.count() << " ms); excluded" << std::endl;
+        }
+    }
+}
+
+PgConnectionPool::Lease PgReplicaRouter::write() {
+    return primary_->acquire();
+}
+
+void PgReplicaRouter::note_write(std::uint64_t key) {
+    selector_.note_write(key, ReplicaSelector::Clock::now());
+}
+
+PgConnectionPool::Lease PgReplicaRouter::read(std::uint64_t key) {
+    if (replicas_.empty()) {
+        return primary_->acquire();
+    }
+    std::vector<std::size_t> load;
+    if (options_.policy == ReplicaPolicy::LeastLoaded) {
+        load.reserve(replicas_.size());
+        for (const auto& replica : replicas_) load.push_back(replica->stats().leased);
+    }
+    const auto chosen = selector_.pick(key, ReplicaSelector::Clock::now(), load);
+    if (chosen) {
+        try {
+            return replicas_[*chosen]->acquire();
+        } catch (const std::exception& ex) {
+            std::cerr << "[PgReplicaRouter] replica" << *chosen << " unavailable, reading from primary: "
+                      << ex.what() << std::endl;
+            selector_.report_failure(*chosen);
+        }
+    }
+    return primary_->acquire();
+}
+
+void PgReplicaRouter::close_idle() {
+    primary_->close_idle();
+    for (const auto& replica : replicas_) replica->close_idle();
+}
+
+ReplicaRoutingStats PgReplicaRouter::stats() const {
+    return selector_.stats();
+}
+
+}
@@ -0,0 +1,125 @@
+// src/chatserver/infrastructure/repository/postgres_group_repository.cpp
+#include "chatserver/infrastructure/repository/postgres_group_repository.h"
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
+
+#include <pqxx/pqxx>
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+// Helper to mask password in connection string for safe logging
+static std::string mask_connstr(const std::string& s) {
+    std::string out = s;
+    const std::string key = "password=";
+    auto pos = out.find(key);
+    if (pos != std::string::npos) {
+        auto start = pos + key.size();
+        out.replace(start, std::string::npos, "***");
+    }
+    return out;
+}
+
+PostgresGroupRepository::PostgresGroupRepository(const std::string& connStr)
+    : connStr_(connStr) {}
+
+std::int64_t PostgresGroupRepository::create(const std::vector<chatserver::domain::UserId>& members) {
+    try {
+        pqxx::connection conn(connStr_);
+        if (!conn.is_open()) {
+            std::cerr << "[PostgresGroupRepository::create] PQ connection failed: connstr=["
+                      << mask_connstr(connStr_) << "]" << std::endl;
+            throw std::runtime_error("failed to open database connection");
+        }
+
+        pqxx::work txn(conn);
+        PgQueryDeadline deadline(conn, txn);
+
+        pqxx::result result = txn.exec("INSERT INTO chat_groups DEFAULT VALUES RETURNING id");
+        if (result.empty()) {
+            std::cerr << "[PostgresGroupRepository::create] INSERT returned no rows" << std::endl;
+            throw std::runtime_error("insert returned no id");
+        }
+        const std::int64_t id = result[0][0].as<std::int64_t>();
+
+        for (const auto& member : members) {
+            txn.exec_params(
+                "INSERT INTO group_members (group_id, user_id) VALUES ($1, $2) ON CONFLICT DO NOTHING",
+                id, member.value());
+        }
+
+        txn.commit();
+        return id;
+    } catch (const std::exception& ex) {
+        std::cerr << "[PostgresGroupRepository::create] ERROR: " << ex.what()
+                  << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+        throw;
+    }
+}
+
+std::vector<chatserver::domain::UserId>
+PostgresGroupRepository::members(const chatserver::domain::GroupId& group) const {
+    try {
+        pqxx::connection conn(connStr_);
+        if (!conn.is_open()) {
+            std::cerr << "[PostgresGroupRepository::members] PQ connection failed: connstr=["
+                      << mask_connstr(connStr_) << "]" << std::endl;
+            throw std::runtime_error("failed to open database connection");
+        }
+
+        pqxx::read_transaction txn(conn);
+        PgQueryDeadline deadline(conn, txn);
+
+        // Пустой результат не отличает «нет группы» от «группа без участников»,
+        // поэтому существование группы проверяется в том же запросе.
+        pqxx::result result = txn.exec_params(
+            "SELECT m.user_id FROM chat_groups g "
+            "LEFT JOIN group_members m ON m.group_id = g.id "
+            "WHERE g.id = $1 ORDER BY m.user_id",
+            group.value());
+        if (result.empty()) {
+            throw GroupNotFoundError(group.value());
+        }
+
+        std::vector<chatserver::domain::UserId> out;
+        out.reserve(result.size());
+        for (const auto& row : result) {
+            if (!row[0].is_null()) {
+                out.emplace_back(row[0].as<std::int64_t>());
+            }
+        }
+        return out;
+    } catch (const GroupNotFoundError&) {
+        throw;
+    } catch (const std::exception& ex) {
+        std::cerr << "[PostgresGroupRepository::members] ERROR: " << ex.what()
+                  << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+        throw;
+    }
+}
+
+bool PostgresGroupRepository::is_member(const chatserver::domain::GroupId& group,
+                                        const chatserver::domain::UserId& user) const {
+    try {
+        pqxx::connection conn(connStr_);
+        if (!conn.is_open()) {
+            std::cerr << "[PostgresGroupRepository::is_member] PQ connection failed: connstr=["
+                      << mask_connstr(connStr_) << "]" << std::endl;
+            throw std::runtime_error("failed to open database connection");
+        }
+
+        pqxx::read_transaction txn(conn);
+        PgQueryDeadline deadline(conn, txn);
+        pqxx::result result = txn.exec_params(
+            "SELECT 1 FROM group_members WHERE group_id = $1 AND user_id = $2",
+            group.value(), user.value());
+        return !result.empty();
+    } catch (const std::exception& ex) {
+        std::cerr << "[PostgresGroupRepository::is_member] ERROR: " << ex.what()
+                  << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+        throw;
+    }
+}
+
+} // namespace chatserver::infrastructure::repository
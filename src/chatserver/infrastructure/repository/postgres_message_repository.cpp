@@ -1,14 +1,20 @@
 // src/chatserver/infrastructure/repository/postgres_message_repository.cpp
 #include "chatserver/infrastructure/repository/postgres_message_repository.h"
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
 
 #include "chatserver/domain/message/message.h"
 #include "chatserver/domain/message/message_text.h"
 #include "chatserver/domain/user/user_id.h"
+#include "chatserver/domain/common/timestamp.h"
+#include "chatserver/domain/message/message_id_generator.h"
 
 #include <pqxx/pqxx>
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <limits>
+#include <optional>
+#include <algorithm>
 
 namespace chatserver::infrastructure::repository {
 
@@ -24,30 +30,103 @@ static std::string mask_connstr(const std::string& s) {
     return out;
 }
 
-PostgresMessageRepository::PostgresMessageRepository(const std::string& connStr)
-    : connStr_(connStr) {}
+static void append_rows(const pqxx::result& result, std::vector<chatserver::domain::message::Message>& page) {
+    for (const auto& row : result) {
+        const auto createdAt = chatserver::domain::Timestamp::from_micros(
+            row[4].is_null() ? 0 : row[4].as<std::int64_t>());
+        if (!row[5].is_null()) {
+            page.emplace_back(
+                chatserver::domain::MessageId(row[0].as<std::int64_t>()),
+                chatserver::domain::UserId(row[1].as<std::int64_t>()),
+                chatserver::domain::GroupId(row[5].as<std::int64_t>()),
+                chatserver::domain::MessageText(row[3].as<std::string>()),
+                createdAt
+            );
+            continue;
+        }
+        page.emplace_back(
+            chatserver::domain::MessageId(row[0].as<std::int64_t>()),
+            chatserver::domain::UserId(row[1].as<std::int64_t>()),
+            chatserver::domain::UserId(row[2].as<std::int64_t>()),
+            chatserver::domain::MessageText(row[3].as<std::string>()),
+            createdAt
+        );
+    }
+}
+
+HistoryTimeBounds history_time_bounds(std::optional<chatserver::domain::MessageId> before,
+                                      std::int64_t nowUs,
+                                      const HistoryPruningOptions& options) {
+    const auto skewUs = std::chrono::duration_cast<std::chrono::microseconds>(options.clockSkew).count();
+    const auto windowUs = std::chrono::duration_cast<std::chrono::microseconds>(options.recentWindow).count();
+    HistoryTimeBounds bounds;
+    if (before && before->value() >= (std::int64_t{1} << 32)) {
+        // +1 мс: время в id округлено вниз до миллисекунды.
+        const auto idMs = chatserver::domain::MessageIdGenerator::decode(*before).unixMs;
+        bounds.beforeUs = (idMs + 1) * 1000 + skewUs;
+    }
+    bounds.recentFromUs = bounds.beforeUs.value_or(nowUs) - windowUs;
+    return bounds;
+}
+
+PostgresMessageRepository::PostgresMessageRepository(const std::string& connStr, HistoryPruningOptions pruning)
+    : PostgresMessageRepository(std::make_shared<PgConnectionPool>(connStr, PgPoolOptions{0}), pruning) {}
+
+PostgresMessageRepository::PostgresMessageRepository(std::shared_ptr<PgConnectionPool> pool,
+                                                     HistoryPruningOptions pruning)
+    : PostgresMessageRepository(std::make_shared<PgReplicaRouter>(std::move(pool)), pruning) {}
+
+PostgresMessageRepository::PostgresMessageRepository(std::shared_ptr<PgReplicaRouter> router,
+                                                     HistoryPruningOptions pruning)
+    : router_(std::move(router))
+    , pruning_(pruning) {}
 
 std::int64_t PostgresMessageRepository::save(
     const chatserver::domain::message::Message& message
 ) {
     try {
-        pqxx::connection conn(connStr_);
-        if (!conn.is_open()) {
-            std::cerr << "[PostgresMessageRepository::save] PQ connection failed: connstr=["
-                      << mask_connstr(connStr_) << "]" << std::endl;
-            throw std::runtime_error("failed to open database connection");
-        }
+        auto conn = router_->write();
+
+        pqxx::work txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
 
-        pqxx::work txn(conn);
+        // created_at — время Timestamp сообщения с микросекундами (TIMESTAMP хранит
+        // их без потерь), а не DEFAULT: порядок внутри секунды тот же, что у сервера.
+        // conversation_id пишется явно, чтобы история переписки читалась по индексу
+        // (conversation_id, id).
+        // У группового сообщения receiver_id = NULL, а group_id заполнен.
+        const auto group = message.group_id();
+        if (message.id().value() != 0) {
+            // id назначен до сохранения (MessageIdGenerator): RETURNING не нужен.
+            txn.exec_params(
+                "INSERT INTO messages (id, sender_id, receiver_id, group_id, conversation_id, text, created_at) "
+                "VALUES ($1, $2, $3, $4, $5, $6, TIMESTAMP 'epoch' + $7 * INTERVAL '1 microsecond')",
+                message.id().value(),
+                message.sender_id().value(),
+                group ? std::nullopt : std::optional<std::int64_t>(message.receiver_id().value()),
+                group ? std::optional<std::int64_t>(group->value()) : std::nullopt,
+                message.conversation_id().value(),
+                message.text().value(),
+                message.created_at().epoch_micros()
+            );
+            txn.commit();
+            router_->note_write(static_cast<std::uint64_t>(message.conversation_id().value()));
+            return message.id().value();
+        }
 
-        // SQL: только sender_id и text (и, если в БД есть created_at с DEFAULT now(), не передаём его)
         pqxx::result result = txn.exec_params(
-            "INSERT INTO messages (sender_id, text) VALUES ($1, $2) RETURNING id",
+            "INSERT INTO messages (sender_id, receiver_id, group_id, conversation_id, text, created_at) "
+            "VALUES ($1, $2, $3, $4, $5, TIMESTAMP 'epoch' + $6 * INTERVAL '1 microsecond') RETURNING id",
             message.sender_id().value(),
-            message.text().value()
+            group ? std::nullopt : std::optional<std::int64_t>(message.receiver_id().value()),
+            group ? std::optional<std::int64_t>(group->value()) : std::nullopt,
+            message.conversation_id().value(),
+            message.text().value(),
+            message.created_at().epoch_micros()
         );
 
         txn.commit();
+        router_->note_write(static_cast<std::uint64_t>(message.conversation_id().value()));
 
         if (result.empty()) {
             std::cerr << "[PostgresMessageRepository::save] INSERT returned no rows" << std::endl;
@@ -57,7 +136,143 @@ std::int64_t PostgresMessageRepository::save(
         return result[0][0].as<long long>();
     } catch (const std::exception& ex) {
         std::cerr << "[PostgresMessageRepository::save] ERROR: " << ex.what()
-                  << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+                  << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
+        throw;
+    }
+}
+
+std::vector<chatserver::domain::message::Message> PostgresMessageRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit
+) const {
+    try {
+        auto conn = router_->read(static_cast<std::uint64_t>(conversation.value()));
+
+        pqxx::read_transaction txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
+
+        // Keyset: курсор — id последнего сообщения предыдущей страницы.
+        // Index scan по (conversation_id, id) начинается сразу с нужной позиции,
+        // а OFFSET пришлось бы пройти и отбросить все строки до неё.
+        // Без курсора подставляем максимальный id — план запроса тот же.
+        const auto beforeId = before ? before->value() : std::numeric_limits<std::int64_t>::max();
+        std::vector<chatserver::domain::message::Message> page;
+        page.reserve(limit);
+        if (!pruning_.enabled) {
+            append_rows(txn.exec_params(
+                "SELECT id, sender_id, receiver_id, text, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, group_id "
+                "FROM messages WHERE conversation_id = $1 AND id < $2 "
+                "ORDER BY id DESC LIMIT $3",
+                conversation.value(), beforeId, static_cast<std::int64_t>(limit)), page);
+            return page;
+        }
+
+        // Секционированная таблица: без условия на created_at каждая страница спускалась
+        // бы в индекс каждой партиции. Сначала — только недавнее окно.
+        const auto bounds = history_time_bounds(
+            before, chatserver::domain::Timestamp::precise_now().epoch_micros(), pruning_);
+        if (bounds.beforeUs) {
+            append_rows(txn.exec_params(
+                "SELECT id, sender_id, receiver_id, text, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, group_id "
+                "FROM messages WHERE conversation_id = $1 AND id < $2 "
+                "AND created_at >= TIMESTAMP 'epoch' + $4 * INTERVAL '1 microsecond' "
+                "AND created_at < TIMESTAMP 'epoch' + $5 * INTERVAL '1 microsecond' "
+                "ORDER BY id DESC LIMIT $3",
+                conversation.value(), beforeId, static_cast<std::int64_t>(limit),
+                bounds.recentFromUs, *bounds.beforeUs), page);
+        } else {
+            append_rows(txn.exec_params(
+                "SELECT id, sender_id, receiver_id, text, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, group_id "
+                "FROM messages WHERE conversation_id = $1 AND id < $2 "
+                "AND created_at >= TIMESTAMP 'epoch' + $4 * INTERVAL '1 microsecond' "
+                "ORDER BY id DESC LIMIT $3",
+                conversation.value(), beforeId, static_cast<std::int64_t>(limit),
+                bounds.recentFromUs), page);
+        }
+        if (page.size() < limit) {
+            // Окно не набрало страницу: дочитываем старые партиции. Берём полный limit —
+            // у старой строки id может оказаться больше, чем у части строк окна
+            // (id и created_at разных узлов упорядочены лишь с точностью до часов).
+            append_rows(txn.exec_params(
+                "SELECT id, sender_id, receiver_id, text, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, group_id "
+                "FROM messages WHERE conversation_id = $1 AND id < $2 "
+                "AND created_at < TIMESTAMP 'epoch' + $4 * INTERVAL '1 microsecond' "
+                "ORDER BY id DESC LIMIT $3",
+                conversation.value(), beforeId, static_cast<std::int64_t>(limit),
+                bounds.recentFromUs), page);
+            std::sort(page.begin(), page.end(), [](const auto& a, const auto& b) {
+                return a.id().value() > b.id().value();
+            });
+            if (page.size() > limit) {
+                page.erase(page.begin() + static_cast<std::ptrdiff_t>(limit), page.end());
+            }
+        }
+        return page;
+    } catch (const std::exception& ex) {
+        std::cerr << "[PostgresMessageRepository::find_page] ERROR: " << ex.what()
+                  << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
+        throw;
+    }
+}
+
+std::size_t PostgresMessageRepository::save_batch(
+    const std::vector<chatserver::domain::message::Message>& messages
+) {
+    if (messages.empty()) {
+        return 0;
+    }
+    try {
+        auto conn = router_->write();
+
+        pqxx::work txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
+        // COPY не умеет ON CONFLICT, поэтому пачка сначала уходит во временную таблицу
+        // (одним потоком данных вместо INSERT на строку), а в messages переносится
+        // одним INSERT ... SELECT, пропускающим уже сохранённые id. Цель конфликта не
+        // указана: в секционированной таблице уникален (id, created_at), а не id.
+        txn.exec(
+            "CREATE TEMP TABLE outbox_batch ("
+            "id BIGINT, sender_id BIGINT, receiver_id BIGINT, group_id BIGINT, "
+            "conversation_id BIGINT, text TEXT, created_at_us BIGINT) ON COMMIT DROP");
+        auto copy = pqxx::stream_to::table(txn, {"outbox_batch"},
+            {"id", "sender_id", "receiver_id", "group_id", "conversation_id", "text", "created_at_us"});
+        for (const auto& message : messages) {
+            if (message.id().value() == 0) {
+                throw std::invalid_argument("save_batch requires messages with assigned ids");
+            }
+            const auto group = message.group_id();
+            copy.write_values(
+                message.id().value(),
+                message.sender_id().value(),
+                group ? std::nullopt : std::optional<std::int64_t>(message.receiver_id().value()),
+                group ? std::optional<std::int64_t>(group->value()) : std::nullopt,
+                message.conversation_id().value(),
+                message.text().value(),
+                message.created_at().epoch_micros()
+            );
+        }
+        copy.complete();
+
+        const auto inserted = txn.exec(
+            "INSERT INTO messages (id, sender_id, receiver_id, group_id, conversation_id, text, created_at) "
+            "SELECT id, sender_id, receiver_id, group_id, conversation_id, text, "
+            "TIMESTAMP 'epoch' + created_at_us * INTERVAL '1 microsecond' FROM outbox_batch "
+            "ON CONFLICT DO NOTHING");
+        txn.commit();
+        for (const auto& message : messages) {
+            router_->note_write(static_cast<std::uint64_t>(message.conversation_id().value()));
+        }
+        return static_cast<std::size_t>(inserted.affected_rows());
+    } catch (const pqxx::integrity_constraint_violation& ex) {
+        std::cerr << "[PostgresMessageRepository::save_batch] rejected: " << ex.what() << std::endl;
+        throw MessageRejectedError(ex.what());
+    } catch (const pqxx::data_exception& ex) {
+        std::cerr << "[PostgresMessageRepository::save_batch] rejected: " << ex.what() << std::endl;
+        throw MessageRejectedError(ex.what());
+    } catch (const std::exception& ex) {
+        std::cerr << "[PostgresMessageRepository::save_batch] ERROR: " << ex.what()
+                  << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
         throw;
     }
 }
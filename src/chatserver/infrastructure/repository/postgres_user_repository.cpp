@@ -1,4 +1,5 @@
 #include "chatserver/infrastructure/repository/postgres_user_repository.h"
+#include "chatserver/infrastructure/repository/pg_query_deadline.h"
 
 #include <pqxx/pqxx>
 #include <iostream>
@@ -13,7 +14,11 @@
 namespace chatserver::infrastructure::repository {
 
 PostgresUserRepository::PostgresUserRepository(const std::string& connStr)
-    : connStr_(connStr) {}
+    : PostgresUserRepository(std::make_shared<PgReplicaRouter>(
+          std::make_shared<PgConnectionPool>(connStr, PgPoolOptions{0}))) {}
+
+PostgresUserRepository::PostgresUserRepository(std::shared_ptr<PgReplicaRouter> router)
+    : router_(std::move(router)) {}
 
 // Helper to mask password in connection string for safe logging
 static std::string mask_connstr(const std::string& s) {
@@ -32,14 +37,9 @@ std::int64_t PostgresUserRepository::save(
     const chatserver::domain::user::User& user
 ) {
     try {
-        pqxx::connection conn(connStr_);
-        if (!conn.is_open()) {
-            std::cerr << "[PostgresUserRepository::save] PQ connection failed: connstr=["
-                      << mask_connstr(connStr_) << "]" << std::endl;
-            throw std::runtime_error("failed to open database connection");
-        }
-
-        pqxx::work txn(conn);
+        auto conn = router_->write();
+        pqxx::work txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
 
         pqxx::params params{
             user.username().value(),
@@ -53,6 +53,7 @@ std::int64_t PostgresUserRepository::save(
         );
 
         txn.commit();
+        router_->note_write(replica_key(user.username().value()));
 
         if (result.empty()) {
             std::cerr << "[PostgresUserRepository::save] INSERT returned no rows" << std::endl;
@@ -61,9 +62,13 @@ std::int64_t PostgresUserRepository::save(
 
         return result[0][0].as<long long>();
     }
+    catch (const pqxx::unique_violation&) {
+        // Нарушение UNIQUE(username) — не ошибка инфраструктуры, а занятое имя.
+        throw UsernameTakenError(user.username().value());
+    }
     catch (const std::exception& ex) {
         std::cerr << "[PostgresUserRepository::save] ERROR: "
-                  << ex.what() << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+                  << ex.what() << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
         throw;
     }
 }
@@ -71,14 +76,9 @@ std::int64_t PostgresUserRepository::save(
 std::optional<chatserver::domain::user::User>
 PostgresUserRepository::find_by_username(const std::string& username) {
     try {
-        pqxx::connection conn(connStr_);
-        if (!conn.is_open()) {
-            std::cerr << "[PostgresUserRepository::find_by_username] PQ connection failed: connstr=["
-                      << mask_connstr(connStr_) << "]" << std::endl;
-            return std::nullopt;
-        }
-
-        pqxx::work txn(conn);
+        auto conn = router_->read(replica_key(username));
+        pqxx::work txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
 
         pqxx::params params{ username };
 
@@ -101,10 +101,32 @@ PostgresUserRepository::find_by_username(const std::string& username) {
     }
     catch (const std::exception& ex) {
         std::cerr << "[PostgresUserRepository::find_by_username] ERROR: "
-                  << ex.what() << " connstr=[" << mask_connstr(connStr_) << "]" << std::endl;
+                  << ex.what() << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
         return std::nullopt;
     }
 }
 
+void PostgresUserRepository::for_each_username(const std::function<void(const std::string&)>& visit) {
+    try {
+        auto conn = router_->read(0);
+        pqxx::read_transaction txn(*conn);
+        PgQueryDeadline deadline(*conn, txn);
+        std::string name;
+        txn.for_stream<std::string_view>(
+            "SELECT username FROM users",
+            [&](std::string_view username) {
+                // string_view живёт до следующей строки потока — копируем в буфер.
+                name.assign(username);
+                visit(name);
+            }
+        );
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "[PostgresUserRepository::for_each_username] ERROR: "
+                  << ex.what() << " connstr=[" << mask_connstr(router_->connection_string()) << "]" << std::endl;
+        throw;
+    }
+}
+
 } // namespace chatserver::infrastructure::repository
 
@@ -0,0 +1,241 @@
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::repository {
+
+struct ShardedMessageRepository::FanOut {
+    // Чтения одного find_page. Шарды разбирают по индексу и вызывающий поток, и
+    // задачи пула: задача, дошедшая до воркера после того, как вызывающий всё
+    // прочитал сам, ничего не трогает, кроме этой структуры.
+    explicit FanOut(std::size_t n) : parts(n), errors(n) {}
+
+    std::function<std::vector<chatserver::domain::message::Message>(std::size_t)> read;
+    // Ссылается на стек вызывающего: вызывается только для взятого индекса, а
+    // вызывающий ждёт, пока все взятые индексы будут прочитаны.
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t done = 0;
+    std::vector<std::vector<chatserver::domain::message::Message>> parts;
+    std::vector<std::exception_ptr> errors;
+
+    void drain() {
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < parts.size();) {
+            try {
+                parts[i] = read(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            std::lock_guard lock(mutex);
+            if (++done == parts.size()) finished.notify_all();
+        }
+    }
+};
+
+ShardKey parse_shard_key(const std::string& name) {
+    if (name == "conversation") return ShardKey::Conversation;
+    if (name == "sender") return ShardKey::Sender;
+    throw std::invalid_argument("Unknown message_shard_key: " + name + " (expected conversation or sender)");
+}
+
+ShardedMessageRepository::ShardedMessageRepository(sharding::HashRing ring,
+                                                   std::vector<std::shared_ptr<MessageRepository>> shards,
+                                                   ShardKey key,
+                                                   std::size_t readThreads)
+    : ring_(std::move(ring))
+    , shards_(std::move(shards))
+    , key_(key)
+    , counters_(std::make_unique<Counters[]>(shards_.size()))
+    , readers_(readThreads > 0 ? std::make_unique<concurrency::ThreadPool>(readThreads) : nullptr)
+{
+    if (shards_.size() != ring_.shards().size()) {
+        throw std::invalid_argument("ShardedMessageRepository: one repository per ring shard is required");
+    }
+    for (const auto& shard : shards_) {
+        if (!shard) {
+            throw std::invalid_argument("ShardedMessageRepository: shard repository is null");
+        }
+    }
+}
+
+std::size_t ShardedMessageRepository::shard_for(const chatserver::domain::message::Message& message) const {
+    const auto key = key_ == ShardKey::Conversation ? message.conversation_id().value()
+                                                    : message.sender_id().value();
+    return ring_.owner(sharding::shard_hash(key));
+}
+
+void ShardedMessageRepository::add_key(std::int64_t key, std::vector<std::size_t>& out) const {
+    const auto hash = sharding::shard_hash(key);
+    out.push_back(ring_.owner(hash));
+    if (const auto previous = ring_.previous_owner(hash)) {
+        out.push_back(*previous);
+    }
+}
+
+std::vector<std::size_t> ShardedMessageRepository::shards_for(
+    const chatserver::domain::ConversationId& conversation
+) const {
+    std::vector<std::size_t> out;
+    if (key_ == ShardKey::Conversation) {
+        add_key(conversation.value(), out);
+    } else if (conversation.is_group()) {
+        // Отправитель группового сообщения — любой участник: спрашиваем все шарды.
+        for (std::size_t i = 0; i < shards_.size(); ++i) out.push_back(i);
+    } else {
+        add_key(conversation.low().value(), out);
+        add_key(conversation.high().value(), out);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+std::int64_t ShardedMessageRepository::save(const chatserver::domain::message::Message& message) {
+    if (message.id().value() <= 0) {
+        throw std::invalid_argument("sharded message storage requires pre-assigned message ids");
+    }
+    const auto shard = shard_for(message);
+    try {
+        const auto id = shards_[shard]->save(message);
+        counters_[shard].saves.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    } catch (...) {
+        counters_[shard].failures.fetch_add(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+
+std::size_t ShardedMessageRepository::save_batch(
+    const std::vector<chatserver::domain::message::Message>& messages
+) {
+    std::vector<std::vector<chatserver::domain::message::Message>> parts(shards_.size());
+    for (const auto& message : messages) {
+        if (message.id().value() <= 0) {
+            throw std::invalid_argument("sharded message storage requires pre-assigned message ids");
+        }
+        parts[shard_for(message)].push_back(message);
+    }
+    // Части пишутся по очереди: при ошибке уже записанные повторятся вместе с пачкой,
+    // и шарды пропустят их по id.
+    std::size_t inserted = 0;
+    for (std::size_t shard = 0; shard < parts.size(); ++shard) {
+        if (parts[shard].empty()) continue;
+        try {
+            inserted += shards_[shard]->save_batch(parts[shard]);
+            counters_[shard].saves.fetch_add(parts[shard].size(), std::memory_order_relaxed);
+        } catch (...) {
+            counters_[shard].failures.fetch_add(1, std::memory_order_relaxed);
+            throw;
+        }
+    }
+    return inserted;
+}
+
+std::vector<chatserver::domain::message::Message>
+ShardedMessageRepository::find_page(
+    const chatserver::domain::ConversationId& conversation,
+    std::optional<chatserver::domain::MessageId> before,
+    std::size_t limit
+) const {
+    const auto targets = shards_for(conversation);
+    auto read = [&](std::size_t shard) {
+        counters_[shard].reads.fetch_add(1, std::memory_order_relaxed);
+        try {
+            return shards_[shard]->find_page(conversation, before, limit);
+        } catch (...) {
+            counters_[shard].failures.fetch_add(1, std::memory_order_relaxed);
+            throw;
+        }
+    };
+    if (targets.size() == 1) {
+        return read(targets.front());
+    }
+    fanoutReads_.fetch_add(1, std::memory_order_relaxed);
+
+    // Срок запроса — thread_local воркера: в потоки пула его переносит Scope,
+    // а превышение (отменённый запрос к шарде) возвращается сюда, иначе не будет 504.
+    const auto deadline = concurrency::RequestDeadline::current();
+    std::vector<char> exceeded(targets.size(), 0);
+    auto forked = [&](std::size_t i) {
+        if (!deadline) {
+            return read(targets[i]);
+        }
+        concurrency::RequestDeadline::Scope scope(*deadline, concurrency::RequestDeadline::kForked);
+        try {
+            auto rows = read(targets[i]);
+            exceeded[i] = scope.exceeded();
+            return rows;
+        } catch (...) {
+            exceeded[i] = scope.exceeded();
+            throw;
+        }
+    };
+
+    // Вызывающий читает сам и отдаёт пулу не больше его размера: занятый пул не
+    // задерживает запрос — шарды, до которых воркеры не дошли, прочитает вызывающий.
+    auto fanOut = std::make_shared<FanOut>(targets.size());
+    fanOut->read = forked;
+    if (readers_) {
+        const auto helpers = std::min(targets.size() - 1, readers_->size());
+        for (std::size_t i = 0; i < helpers; ++i) {
+            readers_->post([fanOut] { fanOut->drain(); });
+        }
+    }
+    fanOut->drain();
+    {
+        std::unique_lock lock(fanOut->mutex);
+        fanOut->finished.wait(lock, [&] { return fanOut->done == targets.size(); });
+    }
+
+    std::vector<chatserver::domain::message::Message> page;
+    std::exception_ptr error;
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        if (fanOut->errors[i]) {
+            if (!error) error = fanOut->errors[i];
+            continue;
+        }
+        auto& rows = fanOut->parts[i];
+        page.insert(page.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    }
+    if (std::find(exceeded.begin(), exceeded.end(), 1) != exceeded.end()) {
+        concurrency::RequestDeadline::mark_exceeded();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::sort(page.begin(), page.end(), [](const auto& a, const auto& b) {
+        return a.id().value() > b.id().value();
+    });
+    page.erase(std::unique(page.begin(), page.end(), [](const auto& a, const auto& b) {
+        return a.id().value() == b.id().value();
+    }), page.end());
+    if (page.size() > limit) {
+        page.erase(page.begin() + static_cast<std::ptrdiff_t>(limit), page.end());
+    }
+    return page;
+}
+
+ShardedStats ShardedMessageRepository::stats() const {
+    ShardedStats s;
+    s.fanoutReads = fanoutReads_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        ShardStats shard;
+        shard.name = ring_.shards()[i].name;
+        shard.saves = counters_[i].saves.load(std::memory_order_relaxed);
+        shard.reads = counters_[i].reads.load(std::memory_order_relaxed);
+        shard.failures = counters_[i].failures.load(std::memory_order_relaxed);
+        s.shards.push_back(std::move(shard));
+    }
+    return s;
+}
+
+}
@@ -1 +1,9 @@
 #include "chatserver/infrastructure/repository/user_repository.h"
+
+namespace chatserver::infrastructure::repository {
+
+void UserRepository::for_each_username(const std::function<void(const std::string&)>&) {
+    throw std::logic_error("this user repository cannot enumerate usernames");
+}
+
+}
@@ -0,0 +1,296 @@
+#include "chatserver/infrastructure/sharding/hash_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace chatserver::infrastructure::sharding {
+
+namespace {
+
+constexpr std::uint64_t kMaxHash = std::numeric_limits<std::uint64_t>::max();
+
+std::uint64_t fmix64(std::uint64_t k) {
+    // Финализатор MurmurHash3: соседние ключи (id подряд) расходятся по всему кругу.
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+std::uint64_t vnode_point(const std::string& name, int vnode) {
+    const auto label = name + "#" + std::to_string(vnode);
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (const unsigned char c : label) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return fmix64(h);
+}
+
+std::string trim(const std::string& s) {
+    const auto begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return {};
+    const auto end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, sep)) {
+        out.push_back(trim(item));
+    }
+    return out;
+}
+
+std::uint64_t parse_hex(const std::string& s) {
+    std::size_t used = 0;
+    const auto value = std::stoull(s, &used, 16);
+    if (used != s.size()) {
+        throw std::invalid_argument("bad hash bound: " + s);
+    }
+    return value;
+}
+
+void append_segment(std::vector<std::pair<HashRange, std::size_t>>& out, std::uint64_t first,
+                    std::uint64_t last, std::size_t owner) {
+    if (!out.empty() && out.back().second == owner && out.back().first.last + 1 == first) {
+        out.back().first.last = last;
+        return;
+    }
+    out.push_back({HashRange{first, last}, owner});
+}
+
+std::vector<std::uint64_t> segment_starts(const HashRing& ring) {
+    // Точки, с которых владелец может смениться: начала дуг кольца и границы переносов.
+    std::vector<std::uint64_t> starts{0};
+    for (const auto& [range, owner] : ring.arcs()) {
+        starts.push_back(range.first);
+    }
+    for (const auto& move : ring.moves()) {
+        starts.push_back(move.range.first);
+        if (move.range.last != kMaxHash) {
+            starts.push_back(move.range.last + 1);
+        }
+    }
+    return starts;
+}
+
+}
+
+std::uint64_t shard_hash(std::int64_t key) {
+    return fmix64(static_cast<std::uint64_t>(key));
+}
+
+std::vector<ShardSpec> parse_shard_specs(const std::string& list, int defaultVnodes) {
+    std::vector<ShardSpec> shards;
+    for (const auto& item : split(list, ',')) {
+        if (item.empty()) continue;
+        ShardSpec spec;
+        spec.vnodes = defaultVnodes;
+        const auto colon = item.find(':');
+        spec.name = trim(item.substr(0, colon));
+        if (colon != std::string::npos) {
+            std::size_t used = 0;
+            const auto vnodesText = trim(item.substr(colon + 1));
+            spec.vnodes = std::stoi(vnodesText, &used);
+            if (used != vnodesText.size() || spec.vnodes < 0) {
+                throw std::invalid_argument("bad vnode count for shard " + spec.name);
+            }
+        }
+        if (spec.name.empty()) {
+            throw std::invalid_argument("empty shard name in: " + list);
+        }
+        for (const auto& other : shards) {
+            if (other.name == spec.name) {
+                throw std::invalid_argument("duplicate shard: " + spec.name);
+            }
+        }
+        shards.push_back(std::move(spec));
+    }
+    return shards;
+}
+
+std::vector<ShardMove> parse_shard_moves(const std::string& list) {
+    std::vector<ShardMove> moves;
+    for (const auto& item : split(list, ',')) {
+        if (item.empty()) continue;
+        const auto parts = split(item, ':');
+        const auto dash = parts[0].find('-');
+        if (parts.size() < 2 || parts.size() > 3 || dash == std::string::npos) {
+            throw std::invalid_argument("bad shard move (expected first-last:target[:migrating]): " + item);
+        }
+        ShardMove move;
+        move.range.first = parse_hex(parts[0].substr(0, dash));
+        move.range.last = parse_hex(parts[0].substr(dash + 1));
+        move.target = parts[1];
+        if (parts.size() == 3) {
+            if (parts[2] != "migrating") {
+                throw std::invalid_argument("bad shard move state: " + parts[2]);
+            }
+            move.migrating = true;
+        }
+        moves.push_back(std::move(move));
+    }
+    return moves;
+}
+
+std::string format_shard_moves(const std::vector<ShardMove>& moves) {
+    std::string out;
+    for (const auto& move : moves) {
+        char range[40];
+        std::snprintf(range, sizeof(range), "%016llx-%016llx",
+                      static_cast<unsigned long long>(move.range.first),
+                      static_cast<unsigned long long>(move.range.last));
+        if (!out.empty()) out += ", ";
+        out += range;
+        out += ":" + move.target;
+        if (move.migrating) out += ":migrating";
+    }
+    return out;
+}
+
+HashRing::HashRing(std::vector<ShardSpec> shards, std::vector<ShardMove> moves)
+    : shards_(std::move(shards))
+    , moves_(std::move(moves))
+{
+    if (shards_.empty()) {
+        throw std::invalid_argument("hash ring needs at least one shard");
+    }
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        for (int v = 0; v < shards_[i].vnodes; ++v) {
+            points_.emplace_back(vnode_point(shards_[i].name, v), i);
+        }
+    }
+    if (points_.empty()) {
+        throw std::invalid_argument("hash ring needs at least one virtual node");
+    }
+    // Совпавшие точки (вероятность ~N²/2^64) достаются шарде, стоящей раньше в списке.
+    std::sort(points_.begin(), points_.end());
+    points_.erase(std::unique(points_.begin(), points_.end(),
+                              [](const auto& a, const auto& b) { return a.first == b.first; }),
+                  points_.end());
+
+    std::sort(moves_.begin(), moves_.end(),
+              [](const ShardMove& a, const ShardMove& b) { return a.range.first < b.range.first; });
+    for (std::size_t i = 0; i < moves_.size(); ++i) {
+        const auto& move = moves_[i];
+        if (move.range.first > move.range.last) {
+            throw std::invalid_argument("shard move range is empty: " + format_shard_moves({move}));
+        }
+        if (i > 0 && moves_[i - 1].range.last >= move.range.first) {
+            throw std::invalid_argument("shard moves overlap: " + format_shard_moves({moves_[i - 1], move}));
+        }
+        const auto target = find(move.target);
+        if (!target) {
+            throw std::invalid_argument("shard move targets unknown shard: " + move.target);
+        }
+        moveTargets_.push_back(*target);
+    }
+}
+
+std::optional<std::size_t> HashRing::find(const std::string& name) const {
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i].name == name) return i;
+    }
+    return std::nullopt;
+}
+
+const ShardMove* HashRing::move_for(std::uint64_t hash) const {
+    auto it = std::upper_bound(moves_.begin(), moves_.end(), hash,
+                               [](std::uint64_t h, const ShardMove& m) { return h < m.range.first; });
+    if (it == moves_.begin()) return nullptr;
+    --it;
+    return it->range.contains(hash) ? &*it : nullptr;
+}
+
+std::size_t HashRing::ring_owner(std::uint64_t hash) const {
+    auto it = std::lower_bound(points_.begin(), points_.end(), hash,
+                               [](const auto& point, std::uint64_t h) { return point.first < h; });
+    return it == points_.end() ? points_.front().second : it->second;
+}
+
+std::size_t HashRing::owner(std::uint64_t hash) const {
+    if (const auto* move = move_for(hash)) {
+        return moveTargets_[static_cast<std::size_t>(move - moves_.data())];
+    }
+    return ring_owner(hash);
+}
+
+std::size_t HashRing::settled_owner(std::uint64_t hash) const {
+    const auto* move = move_for(hash);
+    if (move && !move->migrating) {
+        return moveTargets_[static_cast<std::size_t>(move - moves_.data())];
+    }
+    return ring_owner(hash);
+}
+
+std::optional<std::size_t> HashRing::previous_owner(std::uint64_t hash) const {
+    const auto* move = move_for(hash);
+    if (!move || !move->migrating) {
+        return std::nullopt;
+    }
+    const auto previous = ring_owner(hash);
+    if (previous == moveTargets_[static_cast<std::size_t>(move - moves_.data())]) {
+        return std::nullopt;
+    }
+    return previous;
+}
+
+std::vector<std::pair<HashRange, std::size_t>> HashRing::arcs() const {
+    // Дуга точки — от предыдущей точки (не включая) до неё; дуга первой точки
+    // переходит через 2^64 → 0.
+    std::vector<std::pair<HashRange, std::size_t>> out;
+    const auto wrapOwner = points_.front().second;
+    std::uint64_t start = 0;
+    for (const auto& [point, shard] : points_) {
+        append_segment(out, start, point, shard);
+        if (point == kMaxHash) return out;
+        start = point + 1;
+    }
+    append_segment(out, start, kMaxHash, wrapOwner);
+    return out;
+}
+
+std::vector<ShardMove> HashRing::diff(const HashRing& next) const {
+    auto starts = segment_starts(*this);
+    const auto nextStarts = segment_starts(next);
+    starts.insert(starts.end(), nextStarts.begin(), nextStarts.end());
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    std::vector<ShardMove> moves;
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+        const auto first = starts[i];
+        const auto last = i + 1 < starts.size() ? starts[i + 1] - 1 : kMaxHash;
+        const auto& from = shards_[owner(first)].name;
+        const auto& to = next.shards()[next.owner(first)].name;
+        if (from == to) continue;
+        if (!moves.empty() && moves.back().target == to && moves.back().range.last + 1 == first) {
+            moves.back().range.last = last;
+            continue;
+        }
+        moves.push_back(ShardMove{HashRange{first, last}, to, true});
+    }
+    return moves;
+}
+
+std::vector<double> HashRing::ownership() const {
+    auto starts = segment_starts(*this);
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    std::vector<double> share(shards_.size(), 0.0);
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+        const auto last = i + 1 < starts.size() ? starts[i + 1] - 1 : kMaxHash;
+        share[owner(starts[i])] += (static_cast<double>(last - starts[i]) + 1.0) / 18446744073709551616.0;
+    }
+    return share;
+}
+
+}
@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <string>
 #include <memory>
+#include <chrono>
+#include <sstream>
 
 int main() {
     // --- Жёстко заданные параметры ---
@@ -19,6 +21,21 @@ int main() {
     const std::string address   = "0.0.0.0";
     const int         serverPort = 8080;
 
+    // Хранилище: config/server.ini (storage = postgres | memory),
+    // переменная окружения CHATSERVER_STORAGE имеет приоритет.
+    std::string storageName = "postgres";
+    auto serverIni = chatserver::common::parse_ini("config/server.ini");
+    if (auto it = serverIni.find("storage"); it != serverIni.end()) {
+        storageName = it->second;
+    }
+    if (const char* env = std::getenv("CHATSERVER_STORAGE")) {
+        storageName = env;
+    }
+    auto iniValue = [&serverIni](const std::string& key, const std::string& fallback) {
+        auto it = serverIni.find(key);
+        return it != serverIni.end() ? it->second : fallback;
+    };
+
     // Формируем строку подключения к Postgres
     std::string dbConnStr =
         "host=" + db_host +
@@ -35,18 +52,121 @@ int main() {
         " user=" + db_user +
         " password=***";
 
+    std::cerr << "[INFO] Storage backend: " << storageName << std::endl;
     std::cerr << "[INFO] DB connection string: [" << dbConnStrNoPass << "]" << std::endl;
 
     try {
+        chatserver::bootstrap::StorageOptions storage;
+        storage.backend = chatserver::bootstrap::parse_storage_backend(storageName);
+        // Параметры журнала (storage = log)
+        storage.log.directory = iniValue("log_dir", "data/messages");
+        storage.log.fsyncPolicy = chatserver::bootstrap::parse_fsync_policy(iniValue("log_fsync", "group"));
+        storage.log.fsyncInterval = std::chrono::milliseconds(std::stoi(iniValue("log_fsync_interval_ms", "10")));
+        storage.log.maxSegmentBytes = std::stoull(iniValue("log_segment_mb", "256")) << 20;
+        // Кэш горячих переписок: бюджет (0 — выключен), ёмкость кольца, форма текста, срок записи.
+        storage.conversationCache.budgetBytes = std::stoull(iniValue("history_cache_mb", "64")) << 20;
+        storage.conversationCache.messagesPerConversation = std::stoul(iniValue("history_cache_messages", "64"));
+        storage.conversationCache.text = chatserver::bootstrap::parse_cached_text_form(
+            iniValue("history_cache_text", "plain"));
+        storage.conversationCache.ttl = std::chrono::seconds(std::stoi(iniValue("history_cache_ttl_s", "5")));
+        // Кэш пользователей для /login (storage = postgres): записей и сроки жизни.
+        storage.userCache.capacity = std::stoull(iniValue("user_cache_entries", "100000"));
+        storage.userCache.ttl = std::chrono::seconds(std::stoi(iniValue("user_cache_ttl_s", "60")));
+        storage.userCache.negativeTtl = std::chrono::seconds(std::stoi(iniValue("user_cache_negative_ttl_s", "2")));
+        // Фильтр занятых имён для /register: на сколько имён рассчитан (0 — выключен) и доля ложных срабатываний.
+        storage.usernameFilter.expectedItems = std::stoull(iniValue("username_filter_expected", "1000000"));
+        storage.usernameFilter.falsePositiveRate = std::stod(iniValue("username_filter_fpr", "0.01"));
+        // Ключи Idempotency-Key для /send_message: сколько помнить (0 — выключено) и как долго.
+        storage.idempotency.capacity = std::stoull(iniValue("idempotency_keys", "100000"));
+        storage.idempotency.ttl = std::chrono::seconds(std::stoi(iniValue("idempotency_ttl_s", "600")));
+        // Номер узла для id сообщений, назначаемых сервером (storage = postgres; -1 — id из БД).
+        storage.messageIdNode = std::stoll(iniValue("message_id_node", "-1"));
+        // Write-behind outbox сообщений (storage = postgres, нужен message_id_node): каталог (пусто — выключен).
+        storage.outbox.directory = iniValue("outbox_dir", "");
+        storage.outbox.batchSize = std::stoull(iniValue("outbox_batch", "1000"));
+        storage.outbox.maxPending = std::stoull(iniValue("outbox_max_pending", "1000000"));
+        // Секционирование messages по created_at (storage = postgres): интервал, запас
+        // партиций вперёд, срок хранения (0 — бессрочно), окно первого запроса истории.
+        storage.partitions.interval = chatserver::infrastructure::repository::parse_partition_interval(
+            iniValue("messages_partitions", "none"));
+        storage.partitions.ahead = std::stoi(iniValue("messages_partitions_ahead", "7"));
+        storage.partitions.retention = std::chrono::hours(24 * std::stoll(iniValue("messages_retention_days", "0")));
+        storage.historyRecentWindow = std::chrono::hours(24 * std::stoll(iniValue("history_recent_days", "7")));
+        // Шарды сообщений: имена на кольце (пусто — одна БД), ключ, переносы диапазонов,
+        // пул на шарду, потоки чтения с нескольких шард; строка подключения шарды <name> — message_shard_<name>.
+        storage.sharding.shards = chatserver::infrastructure::sharding::parse_shard_specs(
+            iniValue("message_shards", ""), std::stoi(iniValue("message_shard_vnodes", "64")));
+        for (const auto& shard : storage.sharding.shards) {
+            storage.sharding.connections[shard.name] = iniValue("message_shard_" + shard.name, "");
+        }
+        storage.sharding.moves = chatserver::infrastructure::sharding::parse_shard_moves(
+            iniValue("message_shard_moves", ""));
+        storage.sharding.key = chatserver::infrastructure::repository::parse_shard_key(
+            iniValue("message_shard_key", "conversation"));
+        storage.sharding.pool.size = std::stoull(iniValue("message_shard_pool", "8"));
+        storage.sharding.readThreads = std::stoull(iniValue("message_shard_read_threads", "4"));
+        // Реплики основной БД (URI через запятую, пусто — без реплик): выбор, допустимое
+        // отставание, окно read-your-writes после записи, период замера, пул на БД.
+        std::istringstream replicaList(iniValue("db_replicas", ""));
+        for (std::string replica; std::getline(replicaList, replica, ',');) {
+            if (!replica.empty()) storage.replicas.push_back(replica);
+        }
+        storage.replicaRouting.policy = chatserver::infrastructure::repository::parse_replica_policy(
+            iniValue("db_replica_policy", "round_robin"));
+        storage.replicaRouting.maxLag = std::chrono::milliseconds(std::stoll(iniValue("db_replica_max_lag_ms", "1000")));
+        storage.replicaRouting.readYourWrites = std::chrono::milliseconds(
+            std::stoll(iniValue("db_read_your_writes_ms", "5000")));
+        storage.replicaRouting.lagCheckInterval = std::chrono::milliseconds(
+            std::stoll(iniValue("db_replica_check_ms", "1000")));
+        storage.replicaRouting.pool.size = std::stoull(iniValue("db_pool", "8"));
+        // Часы для created_at: precise | coarse | cached и период тикера для cached.
+        storage.timestampClock = chatserver::bootstrap::parse_timestamp_clock(iniValue("timestamp_clock", "precise"));
+        storage.timestampTick = std::chrono::microseconds(std::stoll(iniValue("timestamp_tick_us", "1000")));
+
+        // Потоки HTTP-сервера: io-потоки держат соединения (включая WebSocket),
+        // воркеры выполняют обработчики маршрутов. 0 воркеров — по числу ядер.
+        chatserver::infrastructure::http::HttpServerOptions http;
+        http.ioThreads = std::stoul(iniValue("io_threads", "1"));
+        http.workerThreads = std::stoul(iniValue("worker_threads", "0"));
+        http.idleTimeout = std::chrono::seconds(std::stoi(iniValue("idle_timeout_s", "60")));
+        // Сроки соединений: заголовки запроса (slowloris) и период WebSocket ping.
+        http.headerTimeout = std::chrono::seconds(std::stoi(iniValue("header_timeout_s", "10")));
+        http.wsPingInterval = std::chrono::seconds(std::stoi(iniValue("ws_ping_interval_s", "30")));
+        // Исходящая очередь WebSocket: порог в КБ и поведение при медленном получателе.
+        http.wsHighWaterBytes = std::stoull(iniValue("ws_high_water_kb", "1024")) << 10;
+        http.wsSlowConsumerPolicy = chatserver::bootstrap::parse_slow_consumer_policy(
+            iniValue("ws_slow_consumer", "throttle"));
+        // Бюджет запроса (мс, 0 — без срока) и бюджеты отдельных маршрутов: по истечении
+        // клиент получает 504, а запрос к БД отменяется.
+        http.requestDeadline = std::chrono::milliseconds(std::stoll(iniValue("request_deadline_ms", "5000")));
+        http.routeDeadlines = chatserver::bootstrap::parse_route_deadlines(iniValue("route_deadlines", ""));
+        // SIGTERM/SIGINT: сколько ждать начатые запросы и слив outbox перед выходом.
+        http.drainTimeout = std::chrono::milliseconds(std::stoll(iniValue("shutdown_timeout_ms", "10000")));
+        // Адаптивный лимит одновременных запросов по классам маршрутов: лишние
+        // получают 503 с Retry-After, не дожидаясь воркера.
+        chatserver::infrastructure::concurrency::AdmissionOptions admission;
+        admission.enabled = iniValue("adaptive_limit", "on") == "on";
+        admission.limiter.initialLimit = std::stoull(iniValue("limit_initial", "32"));
+        admission.limiter.minLimit = std::stoull(iniValue("limit_min", "4"));
+        admission.limiter.maxLimit = std::stoull(iniValue("limit_max", "1024"));
+        admission.limiter.tolerance = std::stod(iniValue("limit_latency_tolerance", "2.0"));
+        admission.routeClasses = chatserver::bootstrap::parse_route_classes(iniValue("route_classes", ""));
+        admission.retryAfter = std::chrono::seconds(std::stoi(iniValue("retry_after_s", "1")));
+
         auto ctx = chatserver::bootstrap::initialize_app(
             dbConnStr,
             secret,
             address,
-            serverPort
+            serverPort,
+            storage,
+            http,
+            admission
         );
 
         std::cout << "ChatServer REST API started on " << address << ":" << serverPort << std::endl;
         ctx.server->run();
+        // run() возвращается после SIGTERM/SIGINT, когда соединения закрыты.
+        chatserver::bootstrap::shutdown_app(ctx, http.drainTimeout);
     }
     catch (const std::exception& ex) {
         std::cerr << "[FATAL] Initialization error: " << ex.what() << std::endl;
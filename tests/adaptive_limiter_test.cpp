@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "chatserver/bootstrap/bootstrap.h"
+#include "chatserver/infrastructure/concurrency/adaptive_limiter.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace bhttp     = beast::http;
+using namespace chatserver::infrastructure;
+using namespace std::chrono_literals;
+using concurrency::AdaptiveLimiter;
+using concurrency::AdaptiveLimiterOptions;
+using concurrency::AdmissionControl;
+using concurrency::AdmissionOptions;
+
+namespace {
+
+AdaptiveLimiterOptions options(std::size_t initial) {
+    AdaptiveLimiterOptions o;
+    o.initialLimit = initial;
+    o.minLimit = 2;
+    o.maxLimit = 100;
+    o.windowSamples = 10;
+    o.minRttResetWindows = 0;
+    return o;
+}
+
+// Окно из windowSamples запросов, выполнявшихся по `concurrency` одновременно.
+void run_window(AdaptiveLimiter& limiter, std::size_t concurrency, std::chrono::microseconds latency) {
+    for (std::size_t done = 0; done < 10;) {
+        std::size_t taken = 0;
+        while (taken < concurrency && limiter.try_acquire()) ++taken;
+        for (std::size_t i = 0; i < taken; ++i) limiter.release(latency);
+        done += taken;
+        ASSERT_GT(taken, 0u);
+    }
+}
+
+struct Server {
+    explicit Server(std::size_t limit) : web(routes(), single_worker(), nullptr, admission(limit)) {}
+
+    static std::shared_ptr<http::HttpRouter> routes() {
+        auto router = std::make_shared<http::HttpRouter>();
+        router->add_route("GET", "/block", [](const http::HttpRequest&) {
+            std::this_thread::sleep_for(300ms);
+            return http::HttpResponse{200, "{}"};
+        });
+        router->add_route("POST", "/block", [](const http::HttpRequest&) {
+            return http::HttpResponse{200, "{}"};
+        });
+        router->add_route("GET", "/admin", [](const http::HttpRequest&) {
+            return http::HttpResponse{200, "{}"};
+        });
+        return router;
+    }
+
+    static http::HttpServerOptions single_worker() {
+        http::HttpServerOptions options;
+        options.workerThreads = 1;
+        return options;
+    }
+
+    static std::shared_ptr<AdmissionControl> admission(std::size_t limit) {
+        AdmissionOptions admission;
+        admission.enabled = true;
+        admission.limiter = concurrency::AdaptiveLimiterOptions{};
+        admission.limiter.initialLimit = limit;
+        admission.limiter.minLimit = limit;
+        admission.limiter.maxLimit = limit;
+        admission.routeClasses = {{"/block", "write"}, {"/admin", "none"}};
+        admission.retryAfter = 2s;
+        return std::make_shared<AdmissionControl>(admission);
+    }
+
+    chatserver::test::TestServer web;
+};
+
+}
+
+TEST(AdaptiveLimiterTest, ShedsAboveLimit) {
+    AdaptiveLimiter limiter(options(3));
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+    limiter.release_dropped();
+    EXPECT_TRUE(limiter.try_acquire());
+    const auto s = limiter.stats();
+    EXPECT_EQ(s.limit, 3u);
+    EXPECT_EQ(s.inFlight, 3u);
+    EXPECT_EQ(s.admitted, 4u);
+    EXPECT_EQ(s.shed, 1u);
+    EXPECT_EQ(s.minRttUs, 0u);
+}
+
+TEST(AdaptiveLimiterTest, GrowsWhileLatencyStaysAtMinimum) {
+    AdaptiveLimiter limiter(options(10));
+    for (int i = 0; i < 10; ++i) run_window(limiter, 100, 1000us);
+    const auto s = limiter.stats();
+    EXPECT_GT(s.limit, 10u);
+    EXPECT_EQ(s.minRttUs, 1000u);
+    EXPECT_EQ(s.sampleRttUs, 1000u);
+}
+
+TEST(AdaptiveLimiterTest, DoesNotGrowWhenUnderused) {
+    AdaptiveLimiter limiter(options(10));
+    for (int i = 0; i < 10; ++i) run_window(limiter, 2, 1000us);
+    EXPECT_EQ(limiter.stats().limit, 10u);
+}
+
+TEST(AdaptiveLimiterTest, ShrinksWhenLatencyGrows) {
+    AdaptiveLimiter limiter(options(40));
+    run_window(limiter, 100, 1000us);
+    const auto before = limiter.stats().limit;
+    // Запросы ждут в очереди: задержка в 10 раз выше минимальной.
+    for (int i = 0; i < 20; ++i) run_window(limiter, 100, 10000us);
+    const auto after = limiter.stats();
+    EXPECT_LT(after.limit, before);
+    EXPECT_GE(after.limit, 2u);
+    EXPECT_EQ(after.minRttUs, 1000u);
+    EXPECT_EQ(after.sampleRttUs, 10000u);
+
+    // Очередь рассосалась — лимит снова растёт.
+    for (int i = 0; i < 20; ++i) run_window(limiter, 100, 1000us);
+    EXPECT_GT(limiter.stats().limit, after.limit);
+}
+
+TEST(AdaptiveLimiterTest, AdmissionControlMapsRoutesToClasses) {
+    AdmissionOptions o;
+    o.routeClasses = {{"/send_message", "write"}, {"/send_group_message", "write"},
+                      {"/messages", "read"}, {"/admin/storage", "none"}};
+    AdmissionControl control(o);
+    EXPECT_EQ(control.limiter_for("/send_message"), control.limiter_for("/send_group_message"));
+    EXPECT_NE(control.limiter_for("/send_message"), control.limiter_for("/messages"));
+    EXPECT_EQ(control.limiter_for("/login"), control.limiter_for("/register"));
+    EXPECT_EQ(control.limiter_for("/admin/storage"), nullptr);
+    const auto stats = control.stats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[0].name, "default");
+    EXPECT_EQ(stats[1].name, "read");
+    EXPECT_EQ(stats[2].name, "write");
+}
+
+TEST(AdaptiveLimiterTest, ParsesRouteClasses) {
+    const auto classes = chatserver::bootstrap::parse_route_classes("/send_message:write,/admin/storage:none");
+    ASSERT_EQ(classes.size(), 2u);
+    EXPECT_EQ(classes.at("/send_message"), "write");
+    EXPECT_EQ(classes.at("/admin/storage"), "none");
+    EXPECT_THROW(chatserver::bootstrap::parse_route_classes("/send_message"), std::invalid_argument);
+    EXPECT_THROW(chatserver::bootstrap::parse_route_classes("/send_message:"), std::invalid_argument);
+}
+
+TEST(AdaptiveLimiterTest, ServerShedsExcessWith503AndRetryAfter) {
+    Server s(1);
+    auto blocking = std::async(std::launch::async, [&s] { return s.web.request(bhttp::verb::get, "/block").result_int(); });
+    ASSERT_TRUE(chatserver::test::wait_until([&s] { return s.web.admission->stats()[1].limiter.inFlight == 1; }));
+
+    // Класс write занят: отказ сразу, тело не читается, соединение закрывается.
+    const auto shed = s.web.request(bhttp::verb::post, "/block", R"({"text":"hello"})");
+    EXPECT_EQ(shed.result_int(), 503);
+    EXPECT_EQ(shed[bhttp::field::retry_after], "2");
+    EXPECT_FALSE(shed.keep_alive());
+    // Неограниченный класс проходит (ждёт воркера).
+    EXPECT_EQ(s.web.request(bhttp::verb::get, "/admin").result_int(), 200);
+
+    EXPECT_EQ(blocking.get(), 200);
+    EXPECT_EQ(s.web.request(bhttp::verb::post, "/block", R"({"text":"hello"})").result_int(), 200);
+
+    const auto stats = s.web.admission->stats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[1].name, "write");
+    EXPECT_EQ(stats[1].limiter.shed, 1u);
+    EXPECT_EQ(stats[1].limiter.admitted, 2u);
+    EXPECT_EQ(stats[1].limiter.inFlight, 0u);
+}
@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "chatserver/domain/message/conversation_id.h"
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/bulk/bulk_copy.h"
+#include "chatserver/infrastructure/concurrency/ordered_pipeline.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+
+using namespace chatserver::infrastructure::bulk;
+using chatserver::infrastructure::concurrency::run_ordered_pipeline;
+using chatserver::infrastructure::crypto::OpenSSLMessageEncryptor;
+
+namespace {
+
+std::vector<std::string> read_all(const std::string& input, BulkFormat format, std::vector<std::size_t>* lines = nullptr,
+                                  std::vector<std::string>* header = nullptr) {
+    std::istringstream in(input);
+    BulkRecordReader reader(in, format);
+    if (header) *header = reader.header();
+    std::vector<std::string> records;
+    std::string record;
+    while (reader.next(record)) {
+        records.push_back(record);
+        if (lines) lines->push_back(reader.line());
+    }
+    return records;
+}
+
+}
+
+TEST(BulkRows, NdjsonRoundTrip) {
+    BulkMessageRow direct;
+    direct.id = 1;
+    direct.senderId = 7;
+    direct.receiverId = 9;
+    direct.text = "quote \" backslash \\ newline \n tab \t bell \x07 юникод";
+    direct.createdAtUs = 1700000000123456;
+    BulkMessageRow group;
+    group.id = 2;
+    group.senderId = 7;
+    group.groupId = 3;
+    group.text = "group";
+
+    std::string out;
+    append_row(out, direct, BulkFormat::Ndjson);
+    append_row(out, group, BulkFormat::Ndjson);
+
+    const auto records = read_all(out, BulkFormat::Ndjson);
+    ASSERT_EQ(records.size(), 2u);
+    const BulkRowParser parser(BulkFormat::Ndjson);
+    const auto a = parser.message(records[0]);
+    EXPECT_EQ(a.text, direct.text);
+    EXPECT_EQ(a.receiverId, 9);
+    EXPECT_FALSE(a.groupId);
+    EXPECT_EQ(a.createdAtUs, direct.createdAtUs);
+    const auto b = parser.message(records[1]);
+    EXPECT_EQ(b.groupId, 3);
+    EXPECT_FALSE(b.receiverId);
+    EXPECT_FALSE(b.createdAtUs);
+
+    // Большие id строкой, время в секундах.
+    const auto c = parser.message(
+        R"({"id":"432345564227567616","sender_id":1,"receiver_id":2,"text":"x","created_at":1700000000.5})");
+    EXPECT_EQ(c.id, 432345564227567616);
+    EXPECT_EQ(c.createdAtUs, 1700000000500000);
+}
+
+TEST(BulkRows, CsvQuotedFieldsSpanLines) {
+    BulkMessageRow row;
+    row.id = 5;
+    row.senderId = 1;
+    row.receiverId = 2;
+    row.text = "line one\nline, \"two\"";
+    std::string out(kMessageCsvHeader);
+    append_row(out, row, BulkFormat::Csv);
+    append_row(out, row, BulkFormat::Csv);
+
+    std::vector<std::size_t> lines;
+    std::vector<std::string> header;
+    const auto records = read_all(out, BulkFormat::Csv, &lines, &header);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(lines, (std::vector<std::size_t>{2, 4}));
+    const BulkRowParser parser(BulkFormat::Csv, header);
+    const auto parsed = parser.message(records[1]);
+    EXPECT_EQ(parsed.text, row.text);
+    EXPECT_EQ(parsed.id, 5);
+    EXPECT_FALSE(parsed.groupId);
+
+    // Столбцы в любом порядке, лишние игнорируются.
+    const auto other = read_all("text,extra,receiver_id,sender_id\nhello,?,2,1\n", BulkFormat::Csv, nullptr, &header);
+    const auto reordered = BulkRowParser(BulkFormat::Csv, header).message(other[0]);
+    EXPECT_EQ(reordered.text, "hello");
+    EXPECT_EQ(reordered.senderId, 1);
+    EXPECT_EQ(reordered.id, 0);
+
+    EXPECT_THROW(read_all("id,text\n1,\"unterminated\n", BulkFormat::Csv), std::invalid_argument);
+}
+
+TEST(BulkRows, InvalidRowsAreRejected) {
+    const BulkRowParser parser(BulkFormat::Ndjson);
+    EXPECT_THROW(parser.message(R"({"sender_id":1,"text":"no receiver"})"), std::invalid_argument);
+    EXPECT_THROW(parser.message(R"({"sender_id":1,"receiver_id":2,"group_id":3,"text":"both"})"), std::invalid_argument);
+    EXPECT_THROW(parser.message(R"({"sender_id":1,"receiver_id":2,"text":""})"), std::invalid_argument);
+    EXPECT_THROW(parser.message(R"({"sender_id":"abc","receiver_id":2,"text":"x"})"), std::invalid_argument);
+    EXPECT_THROW(parser.message("not json"), std::invalid_argument);
+    EXPECT_THROW(parser.user(R"({"id":1,"username":"bob"})"), std::invalid_argument);
+}
+
+TEST(BulkCopy, ImportEncodesEncryptedBinaryTuples) {
+    const OpenSSLMessageEncryptor encryptor("secret");
+    chatserver::domain::MessageIdGenerator ids(5);
+    BulkChunk chunk;
+    chunk.records = {R"({"id":10,"sender_id":1,"receiver_id":2,"text":"hello","created_at_us":946684800000001})",
+                     R"({"sender_id":1,"group_id":4,"text":"to group"})"};
+    chunk.lines = {1, 2};
+    const BulkRowParser parser(BulkFormat::Ndjson);
+    reserve_message_ids(chunk, ids);
+
+    std::string stream;
+    pgcopy::append_header(stream);
+    stream += encode_messages(chunk, parser, encryptor, 1700000000000000);
+    pgcopy::append_trailer(stream);
+
+    PgCopyBinaryReader reader;
+    // По байту: граница кортежа и поля может прийти в любом месте.
+    std::vector<PgCopyBinaryReader::Tuple> tuples;
+    std::vector<std::vector<std::string>> copies;
+    PgCopyBinaryReader::Tuple tuple;
+    for (char c : stream) {
+        reader.feed(&c, 1);
+        while (reader.next(tuple)) {
+            std::vector<std::string> owned;
+            for (const auto& f : tuple) owned.push_back(f ? std::string(*f) : "<null>");
+            copies.push_back(owned);
+        }
+    }
+    EXPECT_TRUE(reader.finished());
+    ASSERT_EQ(copies.size(), 2u);
+    ASSERT_EQ(copies[0].size(), 7u);
+    EXPECT_EQ(pgcopy::read_int8(copies[0][0]), 10);
+    EXPECT_EQ(copies[0][3], "<null>");
+    EXPECT_EQ(pgcopy::read_int8(copies[0][4]),
+              chatserver::domain::ConversationId::between(chatserver::domain::UserId(1),
+                                                          chatserver::domain::UserId(2)).value());
+    EXPECT_EQ(encryptor.decrypt(copies[0][5]), "hello");
+    EXPECT_EQ(pgcopy::read_timestamp(copies[0][6]), 946684800000001);
+    // Postgres-эпоха 2000-01-01: в проводе — 1 мкс.
+    EXPECT_EQ(pgcopy::read_int8(copies[0][6]), 1);
+
+    EXPECT_EQ(chatserver::domain::MessageIdGenerator::decode(
+                  chatserver::domain::MessageId(pgcopy::read_int8(copies[1][0]))).node, 5);
+    EXPECT_EQ(copies[1][2], "<null>");
+    EXPECT_EQ(pgcopy::read_int8(copies[1][3]), 4);
+    EXPECT_EQ(encryptor.decrypt(copies[1][5]), "to group");
+    EXPECT_EQ(pgcopy::read_timestamp(copies[1][6]), 1700000000000000);
+
+    // Без генератора запись без id — ошибка с номером строки.
+    chunk.ids.clear();
+    try {
+        encode_messages(chunk, parser, encryptor, 0);
+        FAIL() << "expected invalid_argument";
+    } catch (const std::invalid_argument& ex) {
+        EXPECT_EQ(std::string(ex.what()).rfind("line 2:", 0), 0u) << ex.what();
+    }
+}
+
+TEST(BulkCopy, ParallelImportKeepsInputOrderOfGeneratedIds) {
+    // Пачки кодируются параллельно и вразнобой, но id выдаёт читающая стадия — по
+    // порядку файла, и история (ORDER BY id) совпадает с ним.
+    const OpenSSLMessageEncryptor encryptor("secret");
+    chatserver::domain::MessageIdGenerator ids(1);
+    const BulkRowParser parser(BulkFormat::Ndjson);
+    int nextRow = 0;
+    std::vector<std::int64_t> imported;
+    run_ordered_pipeline<BulkChunk, std::string>(
+        4, 8,
+        [&]() -> std::optional<BulkChunk> {
+            if (nextRow == 400) return std::nullopt;
+            BulkChunk chunk;
+            for (int i = 0; i < 10; ++i, ++nextRow) {
+                chunk.records.push_back(R"({"sender_id":1,"receiver_id":2,"text":"m)" +
+                                        std::to_string(nextRow) + R"("})");
+                chunk.lines.push_back(static_cast<std::size_t>(nextRow + 1));
+            }
+            reserve_message_ids(chunk, ids);
+            return chunk;
+        },
+        [&](BulkChunk& chunk) {
+            // Поздние пачки быстрее ранних.
+            std::this_thread::sleep_for(std::chrono::microseconds((400 - chunk.lines.front()) % 7 * 100));
+            return encode_messages(chunk, parser, encryptor, 0);
+        },
+        [&](std::string& encoded) {
+            std::string stream;
+            pgcopy::append_header(stream);
+            stream += encoded;
+            pgcopy::append_trailer(stream);
+            PgCopyBinaryReader reader;
+            reader.feed(stream.data(), stream.size());
+            PgCopyBinaryReader::Tuple tuple;
+            while (reader.next(tuple)) imported.push_back(pgcopy::read_int8(*tuple[0]));
+        });
+    ASSERT_EQ(imported.size(), 400u);
+    EXPECT_TRUE(std::is_sorted(imported.begin(), imported.end()));
+    EXPECT_EQ(std::adjacent_find(imported.begin(), imported.end()), imported.end());
+}
+
+TEST(BulkCopy, ImportedIdsFollowCreatedAt) {
+    // Бэкфилл: id из created_at, а не из времени импорта, — порядок по id совпадает
+    // с порядком по времени и не ставит старые сообщения выше новых.
+    const OpenSSLMessageEncryptor encryptor("secret");
+    const std::int64_t importUs = 1760000000000000;
+    chatserver::domain::MessageIdGenerator ids(900, [&] { return importUs / 1000; });
+    const BulkRowParser parser(BulkFormat::Ndjson);
+    BulkChunk chunk;
+    chunk.records = {R"({"sender_id":1,"receiver_id":2,"text":"b","created_at_us":1710000000000500})",
+                     R"({"sender_id":1,"receiver_id":2,"text":"a","created_at_us":1705000000000000})",
+                     R"({"sender_id":1,"receiver_id":2,"text":"c","created_at_us":1710000000000900})",
+                     R"({"sender_id":1,"receiver_id":2,"text":"now"})"};
+    chunk.lines = {1, 2, 3, 4};
+    reserve_message_ids(chunk, ids);
+
+    std::string stream;
+    pgcopy::append_header(stream);
+    stream += encode_messages(chunk, parser, encryptor, importUs);
+    pgcopy::append_trailer(stream);
+    PgCopyBinaryReader reader;
+    reader.feed(stream.data(), stream.size());
+    std::vector<std::pair<std::int64_t, std::int64_t>> rows;
+    // (created_at, id)
+    PgCopyBinaryReader::Tuple tuple;
+    while (reader.next(tuple)) {
+        rows.emplace_back(pgcopy::read_timestamp(*tuple[6]), pgcopy::read_int8(*tuple[0]));
+    }
+    ASSERT_EQ(rows.size(), 4u);
+    std::sort(rows.begin(), rows.end());
+    for (std::size_t i = 1; i < rows.size(); ++i) {
+        EXPECT_LT(rows[i - 1].second, rows[i].second) << "created_at " << rows[i].first;
+    }
+    for (const auto& [createdUs, id] : rows) {
+        const auto parts = chatserver::domain::MessageIdGenerator::decode(chatserver::domain::MessageId(id));
+        EXPECT_EQ(parts.unixMs, createdUs / 1000);
+        EXPECT_EQ(parts.node, 900);
+    }
+
+    // До эпохи id время не выразить: такой записи нужен свой id.
+    chunk.records = {R"({"sender_id":1,"receiver_id":2,"text":"old","created_at_us":1600000000000000})",
+                     R"({"id":7,"sender_id":1,"receiver_id":2,"text":"old","created_at_us":1600000000000000})"};
+    chunk.lines = {5, 6};
+    reserve_message_ids(chunk, ids);
+    try {
+        encode_messages(chunk, parser, encryptor, importUs);
+        FAIL() << "expected invalid_argument";
+    } catch (const std::invalid_argument& ex) {
+        EXPECT_EQ(std::string(ex.what()).rfind("line 5:", 0), 0u) << ex.what();
+    }
+    chunk.records.erase(chunk.records.begin());
+    chunk.lines.erase(chunk.lines.begin());
+    reserve_message_ids(chunk, ids);
+    EXPECT_NO_THROW(encode_messages(chunk, parser, encryptor, importUs));
+}
+
+TEST(BulkCopy, ExportDecryptsAndFormats) {
+    const OpenSSLMessageEncryptor encryptor("secret");
+    std::string stream;
+    pgcopy::append_header(stream);
+    pgcopy::begin_tuple(stream, 6);
+    pgcopy::append_int8(stream, 42);
+    pgcopy::append_int8(stream, 1);
+    pgcopy::append_int8(stream, 2);
+    pgcopy::append_null(stream);
+    pgcopy::append_text(stream, encryptor.encrypt("secret text"));
+    pgcopy::append_timestamp(stream, 1700000000000001);
+    pgcopy::append_trailer(stream);
+
+    PgCopyBinaryReader reader;
+    reader.feed(stream.data(), stream.size());
+    PgCopyBinaryReader::Tuple tuple;
+    ASSERT_TRUE(reader.next(tuple));
+    std::vector<BulkMessageRow> rows{message_from_copy(tuple)};
+    EXPECT_FALSE(reader.next(tuple));
+    EXPECT_TRUE(reader.finished());
+
+    auto copy = rows;
+    EXPECT_EQ(format_messages(rows, encryptor, BulkFormat::Ndjson),
+              "{\"id\":42,\"sender_id\":1,\"receiver_id\":2,\"text\":\"secret text\",\"created_at_us\":1700000000000001}\n");
+    EXPECT_EQ(format_messages(copy, encryptor, BulkFormat::Csv), "42,1,2,,secret text,1700000000000001\n");
+
+    std::vector<BulkMessageRow> foreign{rows[0]};
+    foreign[0].text = OpenSSLMessageEncryptor("other key").encrypt("x");
+    EXPECT_THROW(format_messages(foreign, encryptor, BulkFormat::Ndjson), std::runtime_error);
+}
+
+TEST(BulkCopy, EncryptBatchMatchesEncrypt) {
+    const OpenSSLMessageEncryptor encryptor("secret");
+    const std::vector<std::string> texts{"a", "bb", std::string(1000, 'c')};
+    const auto batch = encryptor.encrypt_batch(texts);
+    ASSERT_EQ(batch.size(), texts.size());
+    EXPECT_NE(batch[0].substr(0, 24), batch[1].substr(0, 24));  // IV у каждого свой
+    EXPECT_EQ(encryptor.decrypt_batch(batch), texts);
+}
+
+TEST(OrderedPipeline, KeepsOrderAndBoundsInFlight) {
+    int next = 0;
+    std::atomic<int> inFlight{0};
+    std::atomic<int> peak{0};
+    std::vector<int> consumed;
+    run_ordered_pipeline<int, int>(
+        4, 3,
+        [&]() -> std::optional<int> {
+            if (next == 200) return std::nullopt;
+            const int now = ++inFlight;
+            peak = std::max(peak.load(), now);
+            return next++;
+        },
+        [](int& v) {
+            // Поздние элементы быстрее ранних: порядок обязан восстановить потребитель.
+            std::this_thread::sleep_for(std::chrono::microseconds((200 - v) % 7 * 100));
+            return v * 2;
+        },
+        [&](int& v) {
+            consumed.push_back(v);
+            --inFlight;
+        });
+    ASSERT_EQ(consumed.size(), 200u);
+    for (int i = 0; i < 200; ++i) EXPECT_EQ(consumed[static_cast<std::size_t>(i)], i * 2);
+    EXPECT_LE(peak.load(), 3);
+}
+
+TEST(OrderedPipeline, PropagatesFirstError) {
+    int next = 0;
+    int consumed = 0;
+    EXPECT_THROW(
+        (run_ordered_pipeline<int, int>(
+            2, 4,
+            [&]() -> std::optional<int> { return next++; },
+            [](int& v) {
+                if (v == 50) throw std::invalid_argument("bad row");
+                return v;
+            },
+            [&](int&) { ++consumed; })),
+        std::invalid_argument);
+    EXPECT_LT(consumed, 50 + 1);
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_user_repository.h"
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::user::User;
+
+namespace {
+
+User user_named(const std::string& name) {
+    return User(Username(name), PasswordHash("hash-of-" + name));
+}
+
+// Хранилище-заглушка: считает обращения, умеет задерживать их и падать.
+class ProbeRepository final : public UserRepository {
+public:
+    std::int64_t save(const User& user) override { return inner.save(user); }
+
+    std::optional<User> find_by_username(const std::string& username) override {
+        ++lookups;
+        // Снимок берётся до ожидания — как ответ БД, который ещё «в пути».
+        auto result = inner.find_by_username(username);
+        {
+            std::unique_lock lock(mutex);
+            ++entered;
+            changed.notify_all();
+            changed.wait(lock, [this] { return !blocked; });
+        }
+        if (failNext.exchange(false)) {
+            throw std::runtime_error("database is down");
+        }
+        return result;
+    }
+
+    void block() {
+        std::lock_guard lock(mutex);
+        blocked = true;
+    }
+    void release() {
+        std::lock_guard lock(mutex);
+        blocked = false;
+        changed.notify_all();
+    }
+    void wait_entered(int n) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this, n] { return entered >= n; });
+    }
+
+    InMemoryUserRepository inner;
+    std::atomic<int> lookups{0};
+    std::atomic<bool> failNext{false};
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool blocked = false;
+    int entered = 0;
+};
+
+UserCacheOptions small_options() {
+    UserCacheOptions options;
+    options.capacity = 4;
+    options.shards = 1;
+    return options;
+}
+
+}
+
+TEST(CachingUserRepository, CachesFoundAndMissingUsers) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+    const auto id = repo.save(user_named("alice"));
+
+    for (int i = 0; i < 3; ++i) {
+        auto found = repo.find_by_username("alice");
+        ASSERT_TRUE(found);
+        EXPECT_EQ(found->id().value(), id);
+        EXPECT_EQ(found->password_hash().value(), "hash-of-alice");
+        EXPECT_FALSE(repo.find_by_username("mallory"));
+    }
+    EXPECT_EQ(probe->lookups, 2);
+
+    const auto s = repo.stats();
+    EXPECT_EQ(s.misses, 2u);
+    EXPECT_EQ(s.hits, 4u);
+    EXPECT_EQ(s.negativeHits, 2u);
+    EXPECT_EQ(s.entries, 2u);
+    EXPECT_GT(s.bytes, 0u);
+}
+
+TEST(CachingUserRepository, SaveInvalidatesNegativeEntry) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+    EXPECT_FALSE(repo.find_by_username("bob"));
+    repo.save(user_named("bob"));
+    EXPECT_TRUE(repo.find_by_username("bob"));
+
+    // Имя заняли в обход кэша (другой узел): отказ save() тоже сбрасывает запись.
+    EXPECT_FALSE(repo.find_by_username("carol"));
+    probe->inner.save(user_named("carol"));
+    EXPECT_FALSE(repo.find_by_username("carol"));
+    EXPECT_THROW(repo.save(user_named("carol")), UsernameTakenError);
+    EXPECT_TRUE(repo.find_by_username("carol"));
+    EXPECT_EQ(repo.stats().invalidations, 2u);
+}
+
+TEST(CachingUserRepository, NegativeEntriesExpire) {
+    auto probe = std::make_shared<ProbeRepository>();
+    auto options = small_options();
+    options.negativeTtl = std::chrono::seconds(1);
+    CachingUserRepository repo(probe, options);
+
+    EXPECT_FALSE(repo.find_by_username("dave"));
+    probe->inner.save(user_named("dave"));
+    EXPECT_FALSE(repo.find_by_username("dave"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(repo.find_by_username("dave"));
+    EXPECT_EQ(repo.stats().expired, 1u);
+}
+
+TEST(CachingUserRepository, ConcurrentMissesShareOneLookup) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+    repo.save(user_named("erin"));
+
+    probe->block();
+    constexpr int kThreads = 8;
+    std::atomic<int> found{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            if (repo.find_by_username("erin")) ++found;
+        });
+    }
+    probe->wait_entered(1);
+    // Ждём, пока остальные потоки встанут в очередь за первым запросом.
+    for (int i = 0; i < 500 && repo.stats().coalesced < kThreads - 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    probe->release();
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(found, kThreads);
+    EXPECT_EQ(probe->lookups, 1);
+    EXPECT_EQ(repo.stats().coalesced, static_cast<std::uint64_t>(kThreads - 1));
+}
+
+TEST(CachingUserRepository, ErrorsAreSharedButNotCached) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+    repo.save(user_named("frank"));
+
+    probe->failNext = true;
+    EXPECT_THROW(repo.find_by_username("frank"), std::runtime_error);
+    EXPECT_TRUE(repo.find_by_username("frank"));
+    EXPECT_EQ(probe->lookups, 2);
+}
+
+TEST(CachingUserRepository, SaveDuringLookupKeepsStaleResultOut) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+
+    probe->block();
+    std::thread reader([&] { EXPECT_FALSE(repo.find_by_username("grace")); });
+    probe->wait_entered(1);
+    repo.save(user_named("grace"));  // пока отрицательный ответ ещё в пути
+    probe->release();
+    reader.join();
+
+    EXPECT_TRUE(repo.find_by_username("grace"));
+}
+
+TEST(CachingUserRepository, ClockKeepsRecentlyUsedEntries) {
+    auto probe = std::make_shared<ProbeRepository>();
+    CachingUserRepository repo(probe, small_options());
+    for (const auto* name : {"u1", "u2", "u3", "u4"}) repo.find_by_username(name);
+    // u1 и u3 читаются снова — бит обращения спасает их от вытеснения.
+    repo.find_by_username("u1");
+    repo.find_by_username("u3");
+    repo.find_by_username("u5");
+    repo.find_by_username("u6");
+    EXPECT_EQ(repo.stats().evictions, 2u);
+    EXPECT_EQ(repo.stats().entries, 4u);
+
+    const int before = probe->lookups;
+    repo.find_by_username("u1");
+    repo.find_by_username("u3");
+    EXPECT_EQ(probe->lookups, before);
+    repo.find_by_username("u2");
+    EXPECT_EQ(probe->lookups, before + 1);
+}
+
+TEST(CachingUserRepository, ZeroCapacityPassesThrough) {
+    auto probe = std::make_shared<ProbeRepository>();
+    auto options = small_options();
+    options.capacity = 0;
+    CachingUserRepository repo(probe, options);
+    repo.find_by_username("x");
+    repo.find_by_username("x");
+    EXPECT_EQ(probe->lookups, 2);
+}
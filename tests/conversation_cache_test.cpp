@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/send_group_message_handler.h"
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/cache/conversation_cache.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::application::GetMessageHistoryHandler;
+using chatserver::application::GetMessageHistoryQuery;
+using chatserver::application::SendGroupMessageHandler;
+using chatserver::application::SendMessageHandler;
+using cache::CachedMessage;
+using cache::ConversationCache;
+using cache::ConversationCacheOptions;
+
+namespace {
+
+CachedMessage cached(std::int64_t id, const std::string& text = "t") {
+    return CachedMessage{id, 1, 2, 0, 1700000000, text};
+}
+
+std::vector<CachedMessage> newest_first(std::int64_t from, std::int64_t to) {
+    std::vector<CachedMessage> rows;
+    for (auto id = to; id >= from; --id) rows.push_back(cached(id));
+    return rows;
+}
+
+std::vector<std::int64_t> ids_of(const std::vector<CachedMessage>& page) {
+    std::vector<std::int64_t> ids;
+    for (const auto& m : page) ids.push_back(m.id);
+    return ids;
+}
+
+ConversationCacheOptions small_options(std::size_t capacity = 4) {
+    ConversationCacheOptions options;
+    options.messagesPerConversation = capacity;
+    options.shards = 1;
+    return options;
+}
+
+// Считает обращения к хранилищу: попадание в кэш их не делает.
+class CountingRepository final : public repository::MessageRepository {
+public:
+    std::int64_t save(const message::Message& message) override { return inner.save(message); }
+    std::vector<message::Message> find_page(const ConversationId& conversation,
+                                            std::optional<MessageId> before,
+                                            std::size_t limit) const override {
+        ++reads;
+        return inner.find_page(conversation, before, limit);
+    }
+    repository::InMemoryMessageRepository inner;
+    mutable std::atomic<int> reads{0};
+};
+
+}
+
+TEST(ConversationCache, ServesTailAndMissesBeyondIt) {
+    ConversationCache cache(small_options());
+    EXPECT_FALSE(cache.find_page(10, std::nullopt, 2));
+
+    const auto ticket = cache.begin_fill(10);
+    ASSERT_NE(ticket, 0u);
+    EXPECT_EQ(cache.begin_fill(10), 0u);  // уже загружается
+    EXPECT_FALSE(cache.find_page(10, std::nullopt, 2));
+    cache.complete_fill(10, ticket, newest_first(1, 6), false);  // в кольцо помещаются 3..6
+
+    EXPECT_EQ(ids_of(*cache.find_page(10, std::nullopt, 2)), (std::vector<std::int64_t>{6, 5}));
+    EXPECT_EQ(ids_of(*cache.find_page(10, 5, 2)), (std::vector<std::int64_t>{4, 3}));
+    EXPECT_FALSE(cache.find_page(10, 5, 3));      // нужен id 2 — его в кольце нет
+    EXPECT_FALSE(cache.find_page(10, std::nullopt, 5));
+
+    cache.append(10, cached(7));
+    EXPECT_EQ(ids_of(*cache.find_page(10, std::nullopt, 4)), (std::vector<std::int64_t>{7, 6, 5, 4}));
+    cache.append(99, cached(8));  // переписки нет в кэше — ничего не заводится
+
+    const auto s = cache.stats();
+    EXPECT_EQ(s.conversations, 1u);
+    EXPECT_EQ(s.messages, 4u);
+    EXPECT_EQ(s.fills, 1u);
+    EXPECT_EQ(s.appends, 1u);
+    EXPECT_EQ(s.hits, 3u);
+    EXPECT_EQ(s.misses, 4u);
+}
+
+TEST(ConversationCache, ShortConversationIsCompleteUntilRingOverflows) {
+    ConversationCache cache(small_options());
+    cache.complete_fill(1, cache.begin_fill(1), newest_first(1, 2), true);
+    EXPECT_EQ(ids_of(*cache.find_page(1, std::nullopt, 51)), (std::vector<std::int64_t>{2, 1}));
+    EXPECT_TRUE(cache.find_page(1, 1, 51)->empty());
+
+    cache.complete_fill(2, cache.begin_fill(2), {}, true);
+    EXPECT_TRUE(cache.find_page(2, std::nullopt, 51)->empty());  // пустая переписка — тоже попадание
+
+    for (std::int64_t id = 3; id <= 5; ++id) cache.append(1, cached(id));
+    EXPECT_FALSE(cache.find_page(1, std::nullopt, 51));  // 1 вытеснен из кольца
+    EXPECT_EQ(ids_of(*cache.find_page(1, std::nullopt, 4)), (std::vector<std::int64_t>{5, 4, 3, 2}));
+}
+
+TEST(ConversationCache, WritesDuringFillAndOutOfOrderCommitsAreKept) {
+    ConversationCache cache(small_options());
+    const auto ticket = cache.begin_fill(1);
+    // Снимок хранилища сделан до сохранения 5 и 6.
+    cache.append(1, cached(6));
+    cache.append(1, cached(5));
+    cache.complete_fill(1, ticket, newest_first(3, 4), true);
+    EXPECT_EQ(ids_of(*cache.find_page(1, std::nullopt, 10)), (std::vector<std::int64_t>{6, 5, 4, 3}));
+
+    // Кольцо полно: опоздавшее сообщение в середину вытесняет самое старое.
+    cache.append(1, cached(8));
+    cache.append(1, cached(7));
+    EXPECT_EQ(ids_of(*cache.find_page(1, std::nullopt, 4)), (std::vector<std::int64_t>{8, 7, 6, 5}));
+    cache.append(1, cached(2));  // старше всего кольца — не попадает
+    cache.append(1, cached(7));  // повтор
+    EXPECT_EQ(ids_of(*cache.find_page(1, std::nullopt, 4)), (std::vector<std::int64_t>{8, 7, 6, 5}));
+
+    // Неудачная загрузка и устаревший билет не оставляют записей.
+    const auto failed = cache.begin_fill(2);
+    cache.abort_fill(2, failed);
+    cache.complete_fill(2, failed, newest_first(1, 2), true);
+    EXPECT_FALSE(cache.find_page(2, std::nullopt, 1));
+}
+
+TEST(ConversationCache, EntryExpiresAfterTtlEvenIfWrittenTo) {
+    // Сообщения другого узла в кэш не попадают: complete-запись не должна жить вечно.
+    auto options = small_options();
+    options.ttl = std::chrono::seconds(1);
+    ConversationCache cache(options);
+    cache.complete_fill(1, cache.begin_fill(1), newest_first(1, 2), true);
+    ASSERT_TRUE(cache.find_page(1, std::nullopt, 50));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    cache.append(1, cached(3));  // запись своего узла срок не продлевает
+    EXPECT_FALSE(cache.find_page(1, std::nullopt, 50));
+    const auto s = cache.stats();
+    EXPECT_EQ(s.expired, 1u);
+    EXPECT_EQ(s.conversations, 0u);
+    EXPECT_EQ(s.bytes, 0u);
+    // Следующее чтение загружает хвост заново.
+    EXPECT_NE(cache.begin_fill(1), 0u);
+
+    // ttl = 0 — без срока.
+    options.ttl = std::chrono::seconds(0);
+    ConversationCache forever(options);
+    forever.complete_fill(1, forever.begin_fill(1), newest_first(1, 2), true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(forever.find_page(1, std::nullopt, 50));
+}
+
+TEST(ConversationCache, EvictsLeastRecentlyUsedUnderBudget) {
+    auto options = small_options(8);
+    options.budgetBytes = 0;
+    {
+        ConversationCache disabled(options);
+        EXPECT_EQ(disabled.begin_fill(1), 0u);
+    }
+
+    // Бюджет на три переписки по восемь сообщений.
+    ConversationCache probe(small_options(8));
+    probe.complete_fill(1, probe.begin_fill(1), newest_first(1, 8), false);
+    options.budgetBytes = probe.stats().bytes * 3 + probe.stats().bytes / 2;
+    ConversationCache cache(options);
+
+    for (std::int64_t c = 1; c <= 3; ++c) {
+        cache.complete_fill(c, cache.begin_fill(c), newest_first(1, 8), false);
+    }
+    EXPECT_EQ(cache.stats().conversations, 3u);
+    ASSERT_TRUE(cache.find_page(1, std::nullopt, 2));  // 1 — самая свежая, 2 — самая старая
+    cache.complete_fill(4, cache.begin_fill(4), newest_first(1, 8), false);
+
+    const auto s = cache.stats();
+    EXPECT_EQ(s.conversations, 3u);
+    EXPECT_EQ(s.evictions, 1u);
+    EXPECT_LE(s.bytes, options.budgetBytes);
+    EXPECT_TRUE(cache.find_page(1, std::nullopt, 2));
+    EXPECT_FALSE(cache.find_page(2, std::nullopt, 2));
+    EXPECT_TRUE(cache.find_page(3, std::nullopt, 2));
+    EXPECT_TRUE(cache.find_page(4, std::nullopt, 2));
+}
+
+namespace {
+
+void expect_history_through_cache(cache::CachedTextForm form) {
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("test-secret");
+    auto repo = std::make_shared<CountingRepository>();
+    ConversationCacheOptions options;
+    options.messagesPerConversation = 8;
+    options.text = form;
+    auto conversationCache = std::make_shared<ConversationCache>(options);
+    SendMessageHandler sender(encryptor, repo, nullptr, conversationCache);
+    GetMessageHistoryHandler history(encryptor, repo, nullptr, conversationCache);
+
+    for (int i = 1; i <= 10; ++i) sender.handle({1, 2, "m" + std::to_string(i), std::nullopt});
+    EXPECT_EQ(conversationCache->stats().conversations, 0u);  // запись кэш не заполняет
+
+    auto first = history.handle(GetMessageHistoryQuery{2, 1, std::nullopt, 3, std::nullopt});
+    EXPECT_EQ(repo->reads, 1);
+    ASSERT_EQ(first.messages.size(), 3u);
+    EXPECT_EQ(first.messages[0].text, "m10");
+    EXPECT_TRUE(first.has_more);
+
+    // Повтор и следующая страница — из кэша.
+    auto again = history.handle(GetMessageHistoryQuery{1, 2, std::nullopt, 3, std::nullopt});
+    auto second = history.handle(GetMessageHistoryQuery{1, 2, first.messages.back().id, 3, std::nullopt});
+    EXPECT_EQ(repo->reads, 1);
+    EXPECT_EQ(again.messages[2].text, "m8");
+    ASSERT_EQ(second.messages.size(), 3u);
+    EXPECT_EQ(second.messages[0].text, "m7");
+    EXPECT_EQ(second.messages[0].sender_id, 1);
+    EXPECT_EQ(second.messages[0].receiver_id, 2);
+    EXPECT_TRUE(second.has_more);
+
+    // Write-through: новое сообщение видно без похода в хранилище.
+    const auto id = sender.handle({2, 1, "fresh", std::nullopt});
+    auto fresh = history.handle(GetMessageHistoryQuery{1, 2, std::nullopt, 1, std::nullopt});
+    EXPECT_EQ(repo->reads, 1);
+    ASSERT_EQ(fresh.messages.size(), 1u);
+    EXPECT_EQ(fresh.messages[0].id, id);
+    EXPECT_EQ(fresh.messages[0].text, "fresh");
+
+    // Глубже кольца — снова хранилище, и страница та же, что без кэша.
+    auto deep = history.handle(GetMessageHistoryQuery{1, 2, 3, 50, std::nullopt});
+    EXPECT_EQ(repo->reads, 2);
+    ASSERT_EQ(deep.messages.size(), 2u);
+    EXPECT_EQ(deep.messages[0].text, "m2");
+    EXPECT_FALSE(deep.has_more);
+
+    // В памяти — та форма текста, что настроена.
+    auto raw = conversationCache->find_page(ConversationId::between(UserId(1), UserId(2)).value(), std::nullopt, 1);
+    ASSERT_TRUE(raw);
+    if (form == cache::CachedTextForm::Plain) {
+        EXPECT_EQ(raw->front().text, "fresh");
+    } else {
+        EXPECT_NE(raw->front().text, "fresh");
+        EXPECT_EQ(encryptor->decrypt(raw->front().text), "fresh");
+    }
+}
+
+}
+
+TEST(ConversationCacheHistory, PlainTextCache) {
+    expect_history_through_cache(cache::CachedTextForm::Plain);
+}
+
+TEST(ConversationCacheHistory, EncryptedCache) {
+    expect_history_through_cache(cache::CachedTextForm::Encrypted);
+}
+
+TEST(ConversationCacheHistory, GroupWriteThroughKeepsMembershipCheck) {
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("test-secret");
+    auto repo = std::make_shared<CountingRepository>();
+    auto groups = std::make_shared<repository::InMemoryGroupRepository>();
+    auto conversationCache = std::make_shared<ConversationCache>();
+    const auto group = groups->create({UserId(1), UserId(2)});
+    SendGroupMessageHandler sender(encryptor, repo, groups, nullptr, conversationCache);
+    GetMessageHistoryHandler history(encryptor, repo, groups, conversationCache);
+
+    sender.handle({1, group, "hello"});
+    EXPECT_EQ(history.handle(GetMessageHistoryQuery{2, 0, std::nullopt, 10, group}).messages.size(), 1u);
+    sender.handle({2, group, "again"});
+    auto page = history.handle(GetMessageHistoryQuery{1, 0, std::nullopt, 10, group});
+    EXPECT_EQ(repo->reads, 1);
+    ASSERT_EQ(page.messages.size(), 2u);
+    EXPECT_EQ(page.messages[0].text, "again");
+    EXPECT_EQ(page.messages[0].group_id, group);
+    EXPECT_EQ(page.messages[0].receiver_id, 0);
+    EXPECT_FALSE(page.has_more);
+
+    // Кэш не обходит проверку членства.
+    EXPECT_THROW(history.handle(GetMessageHistoryQuery{3, 0, std::nullopt, 10, group}),
+                 repository::NotGroupMemberError);
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace bhttp     = beast::http;
+namespace net       = boost::asio;
+namespace websocket = beast::websocket;
+using tcp           = net::ip::tcp;
+using namespace chatserver::infrastructure;
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+using chatserver::test::TestServer;
+using chatserver::test::wait_until;
+
+namespace {
+
+struct Probe {
+    // Что уже случилось на сервере: тесты ждут этого, а не угадывают паузой.
+    std::atomic<int> slowStarted{0};
+    std::atomic<int> streamStarted{0};
+    std::atomic<int> parked{0};
+};
+
+std::shared_ptr<http::HttpRouter> make_router(const std::shared_ptr<Probe>& probe = std::make_shared<Probe>()) {
+    auto router = std::make_shared<http::HttpRouter>();
+    router->add_route("GET", "/ping", [](const http::HttpRequest&) { return http::HttpResponse{200, "{}"}; });
+    router->add_route("GET", "/slow", [probe](const http::HttpRequest&) {
+        ++probe->slowStarted;
+        std::this_thread::sleep_for(300ms);
+        return http::HttpResponse{200, R"({"done":true})"};
+    });
+    router->add_route("GET", "/stream", [probe](const http::HttpRequest&) {
+        // Потоковый ответ больше буферов сокета: без читающего клиента запись встаёт.
+        http::HttpResponse hresp;
+        hresp.stream_body = [probe](const http::ChunkWriter& write) {
+            ++probe->streamStarted;
+            const std::string chunk(64 * 1024, 'x');
+            for (int i = 0; i < 1024; ++i) write(chunk);
+        };
+        return hresp;
+    });
+    router->add_route("GET", "/wait", [probe](const http::HttpRequest&) {
+        // Long-poll, ответ на который так и не приходит.
+        http::HttpResponse hresp;
+        hresp.deferred = [probe](http::ResponseSink) { ++probe->parked; };
+        return hresp;
+    });
+    return router;
+}
+
+http::HttpServerOptions options() {
+    http::HttpServerOptions o;
+    o.workerThreads = 2;
+    o.drainTimeout = 5s;
+    return o;
+}
+
+struct Client {
+    explicit Client(unsigned short port) : socket(ioc) {
+        socket.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+    }
+
+    bhttp::response<bhttp::string_body> get(const std::string& target) {
+        bhttp::request<bhttp::empty_body> req{bhttp::verb::get, target, 11};
+        req.set(bhttp::field::host, "127.0.0.1");
+        bhttp::write(socket, req);
+        bhttp::response<bhttp::string_body> res;
+        bhttp::read(socket, buffer, res);
+        return res;
+    }
+
+    bool closed_by_server() {
+        // Сервер закрыл соединение: чтение сразу возвращает EOF.
+        char byte = 0;
+        beast::error_code ec;
+        socket.read_some(net::buffer(&byte, 1), ec);
+        return ec == net::error::eof || ec == net::error::connection_reset;
+    }
+
+    net::io_context ioc;
+    tcp::socket socket;
+    beast::flat_buffer buffer;
+};
+
+}
+
+TEST(GracefulShutdownTest, InFlightRequestCompletesAndIdleConnectionsClose) {
+    auto probe = std::make_shared<Probe>();
+    TestServer srv(make_router(probe), options(), nullptr);
+    const auto port = srv.server.port();
+
+    Client idle(port);
+    EXPECT_EQ(idle.get("/ping").result_int(), 200);
+
+    auto inFlight = std::async(std::launch::async, [port] { return Client(port).get("/slow"); });
+    ASSERT_TRUE(wait_until([&] { return probe->slowStarted == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(5s);
+    // Ждали только начатый запрос, а не срок и не простаивающее соединение.
+    EXPECT_LT(Clock::now() - started, 2s);
+
+    const auto res = inFlight.get();
+    EXPECT_EQ(res.result_int(), 200);
+    EXPECT_EQ(res.body(), R"({"done":true})");
+    EXPECT_FALSE(res.keep_alive());
+    EXPECT_TRUE(idle.closed_by_server());
+
+    // Порт закрыт.
+    net::io_context ioc;
+    tcp::socket socket(ioc);
+    beast::error_code ec;
+    socket.connect(tcp::endpoint(net::ip::make_address("127.0.0.1"), port), ec);
+    EXPECT_TRUE(ec);
+}
+
+TEST(GracefulShutdownTest, ParkedLongPollGets503) {
+    auto probe = std::make_shared<Probe>();
+    TestServer srv(make_router(probe), options(), nullptr);
+    const auto port = srv.server.port();
+
+    auto parked = std::async(std::launch::async, [port] { return Client(port).get("/wait"); });
+    ASSERT_TRUE(wait_until([&] { return probe->parked == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(5s);
+    EXPECT_LT(Clock::now() - started, 2s);
+
+    const auto res = parked.get();
+    EXPECT_EQ(res.result_int(), 503);
+    EXPECT_EQ(res[bhttp::field::retry_after], "1");
+    EXPECT_FALSE(res.keep_alive());
+}
+
+TEST(GracefulShutdownTest, WebSocketGetsGoingAway) {
+    TestServer srv(make_router(), options());
+    auto ws = srv.connect_ws("/ws?user=2");
+    auto reading = std::async(std::launch::async, [&ws] {
+        beast::flat_buffer buffer;
+        beast::error_code ec;
+        ws->read(buffer, ec);
+        return ec;
+    });
+    ASSERT_TRUE(wait_until([&] { return srv.registry->stats().connections == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(5s);
+    EXPECT_LT(Clock::now() - started, 2s);
+    EXPECT_EQ(reading.get(), websocket::error::closed);
+    EXPECT_EQ(ws->reason().code, websocket::close_code::going_away);
+    EXPECT_EQ(srv.registry->stats().connections, 0u);
+}
+
+TEST(GracefulShutdownTest, WebSocketThatIgnoresCloseIsCut) {
+    auto o = options();
+    o.headerTimeout = 1s;
+    TestServer srv(make_router(), o);
+
+    // Клиент после handshake ничего не читает и на close не отвечает.
+    auto ws = srv.connect_ws("/ws?user=3");
+    ASSERT_TRUE(wait_until([&] { return srv.registry->stats().connections == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(5s);
+    // Не весь срок остановки: соединение рвёт срок ответа на close (headerTimeout).
+    EXPECT_LT(Clock::now() - started, 3s);
+    EXPECT_EQ(srv.registry->stats().connections, 0u);
+}
+
+TEST(GracefulShutdownTest, TimeoutBoundsShutdown) {
+    TestServer srv(make_router(), options(), nullptr);
+
+    // Клиент начал запрос и пропал, не дослав заголовки.
+    auto stuck = srv.connect();
+    net::write(stuck, net::buffer(std::string("GET /ping HTTP/1.1\r\nHost: x\r\n")));
+    ASSERT_TRUE(wait_until([&] { return srv.server.open_connections() == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(200ms);
+    const auto took = Clock::now() - started;
+    EXPECT_GE(took, 200ms);
+    EXPECT_LT(took, 2s);
+}
+
+TEST(GracefulShutdownTest, StalledStreamReaderDoesNotBlockStop) {
+    auto probe = std::make_shared<Probe>();
+    TestServer srv(make_router(probe), options(), nullptr);
+
+    // Клиент запросил потоковый ответ и перестал читать.
+    auto stalled = srv.connect();
+    net::write(stalled, net::buffer(std::string("GET /stream HTTP/1.1\r\nHost: x\r\n\r\n")));
+    ASSERT_TRUE(wait_until([&] { return probe->streamStarted == 1; }));
+
+    const auto started = Clock::now();
+    srv.server.shutdown(200ms);
+    EXPECT_LT(Clock::now() - started, 2s);
+}
+
+TEST(GracefulShutdownTest, RunReturnsOnSigterm) {
+    auto o = options();
+    o.drainTimeout = 1s;
+    http::HttpServer server("127.0.0.1", 0, make_router(), nullptr, o);
+    auto running = std::async(std::launch::async, [&server] { server.run(); });
+    // Сигнал до обработчика run() убил бы весь тестовый процесс.
+    ASSERT_TRUE(wait_until([&] { return server.handling_signals(); }));
+    EXPECT_EQ(Client(server.port()).get("/ping").result_int(), 200);
+
+    std::raise(SIGTERM);
+    EXPECT_EQ(running.wait_for(3s), std::future_status::ready);
+}
+
+TEST(GracefulShutdownTest, ConcurrentStopAndShutdown) {
+    // Как SIGTERM во время остановки из другого потока: оба вызова завершаются,
+    // и ни один не трогает уже изъятое состояние сервера.
+    for (int i = 0; i < 20; ++i) {
+        TestServer srv(make_router(), options(), nullptr);
+        auto draining = std::async(std::launch::async, [&srv] { srv.server.shutdown(1s); });
+        srv.server.stop();
+        EXPECT_EQ(srv.server.open_connections(), 0u);
+        EXPECT_EQ(draining.wait_for(5s), std::future_status::ready);
+    }
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "chatserver/application/handlers/create_group_handler.h"
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/send_group_message_handler.h"
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/http/resources/group_resource.h"
+#include "chatserver/infrastructure/http/resources/message_resource.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+#include "chatserver/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct CountingEncryptor : services::MessageEncryptor {
+    mutable std::atomic<int> encrypts{0};
+    std::string encrypt(const std::string& plain) const override { ++encrypts; return "enc:" + plain; }
+    std::string decrypt(const std::string& cipher) const override { return cipher.substr(4); }
+};
+
+struct RecordingNotifier : services::MessageNotifier {
+    std::vector<message::Message> direct;
+    std::vector<message::Message> group;
+    std::vector<std::vector<UserId>> recipients;
+    void message_stored(const message::Message& m) override { direct.push_back(m); }
+    void group_message_stored(const message::Message& m, const std::vector<UserId>& to) override {
+        group.push_back(m);
+        recipients.push_back(to);
+    }
+};
+
+struct FrameConnection : realtime::RealtimeConnection {
+    std::vector<std::shared_ptr<const std::string>> frames;
+    void send(std::shared_ptr<const std::string> frame) override { frames.push_back(std::move(frame)); }
+};
+
+}
+
+TEST(GroupConversation, KeyDoesNotCollideWithDirectConversations) {
+    auto g = ConversationId::group(GroupId(7));
+    EXPECT_TRUE(g.is_group());
+    EXPECT_FALSE(ConversationId::between(UserId(1), UserId(7)).is_group());
+    EXPECT_NE(g, ConversationId::between(UserId(1), UserId(7)));
+    EXPECT_THROW(ConversationId::group(GroupId(0)), std::invalid_argument);
+    EXPECT_THROW(ConversationId::group(GroupId(std::int64_t{1} << 32)), std::invalid_argument);
+
+    message::Message m(UserId(3), GroupId(7), MessageText("hi"), Timestamp(1));
+    ASSERT_TRUE(m.group_id().has_value());
+    EXPECT_EQ(m.group_id()->value(), 7);
+    EXPECT_EQ(m.receiver_id().value(), 0);
+    EXPECT_EQ(m.conversation_id(), g);
+}
+
+TEST(GroupConversation, InMemoryAndLogStoresKeepGroupMessages) {
+    const auto dir = fs::temp_directory_path() / ("chatserver_group_test_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    repository::LogStoreOptions logOptions;
+    logOptions.directory = dir.string();
+
+    auto check = [](repository::MessageRepository& repo) {
+        repo.save(message::Message(UserId(1), GroupId(5), MessageText("a"), Timestamp(10)));
+        repo.save(message::Message(UserId(1), UserId(2), MessageText("direct"), Timestamp(11)));
+        repo.save(message::Message(UserId(2), GroupId(5), MessageText("b"), Timestamp(12)));
+        auto page = repo.find_page(ConversationId::group(GroupId(5)), std::nullopt, 10);
+        ASSERT_EQ(page.size(), 2u);
+        EXPECT_EQ(page[0].text().value(), "b");
+        EXPECT_EQ(page[1].text().value(), "a");
+        ASSERT_TRUE(page[0].group_id().has_value());
+        EXPECT_EQ(page[0].group_id()->value(), 5);
+        EXPECT_EQ(page[0].sender_id().value(), 2);
+
+        auto next = repo.find_page(ConversationId::group(GroupId(5)), page[0].id(), 10);
+        ASSERT_EQ(next.size(), 1u);
+        EXPECT_EQ(next[0].text().value(), "a");
+    };
+
+    repository::InMemoryMessageRepository memory;
+    check(memory);
+    {
+        repository::LogMessageRepository log(logOptions);
+        check(log);
+    }
+    // После перезапуска индекс переписок восстанавливается из журнала
+    repository::LogMessageRepository reopened(logOptions);
+    auto page = reopened.find_page(ConversationId::group(GroupId(5)), std::nullopt, 10);
+    ASSERT_EQ(page.size(), 2u);
+    EXPECT_EQ(page[1].group_id()->value(), 5);
+    fs::remove_all(dir);
+}
+
+TEST(GroupConversation, HandlerEncryptsAndStoresOnceForWholeGroup) {
+    auto encryptor = std::make_shared<CountingEncryptor>();
+    auto messages = std::make_shared<repository::InMemoryMessageRepository>();
+    auto groups = std::make_shared<repository::InMemoryGroupRepository>();
+    auto notifier = std::make_shared<RecordingNotifier>();
+    chatserver::application::SendGroupMessageHandler handler(encryptor, messages, groups, notifier);
+    chatserver::application::CreateGroupHandler create(groups);
+
+    const auto groupId = create.handle({{1, 2, 3, 4, 5, 3}});
+    const auto id = handler.handle(chatserver::application::SendGroupMessageCommand{2, groupId, "hello"});
+
+    EXPECT_EQ(encryptor->encrypts, 1);
+    EXPECT_EQ(messages->size(), 1u);
+    ASSERT_EQ(notifier->group.size(), 1u);
+    EXPECT_EQ(notifier->group[0].id().value(), id);
+    EXPECT_EQ(notifier->group[0].text().value(), "hello");
+    EXPECT_EQ(notifier->recipients[0], (std::vector<UserId>{UserId(1), UserId(3), UserId(4), UserId(5)}));
+
+    EXPECT_THROW(handler.handle(chatserver::application::SendGroupMessageCommand{9, groupId, "x"}),
+                 repository::NotGroupMemberError);
+    EXPECT_THROW(handler.handle(chatserver::application::SendGroupMessageCommand{1, groupId + 1, "x"}),
+                 repository::GroupNotFoundError);
+    EXPECT_THROW(create.handle({{}}), std::invalid_argument);
+    EXPECT_EQ(encryptor->encrypts, 1);
+}
+
+TEST(GroupConversation, EveryMemberConnectionGetsTheSameFrameBuffer) {
+    realtime::ConnectionRegistryOptions options;
+    options.shards = 4;
+    auto registry = std::make_shared<realtime::ConnectionRegistry>(options);
+    std::vector<std::shared_ptr<FrameConnection>> connections;
+    std::vector<UserId> members;
+    for (std::int64_t user = 1; user <= 50; ++user) {
+        members.emplace_back(user);
+        if (user % 5 == 0) continue;  // каждый пятый не в сети
+        for (int device = 0; device < (user % 2 ? 1 : 3); ++device) {
+            connections.push_back(std::make_shared<FrameConnection>());
+            registry->add(user, connections.back());
+        }
+    }
+
+    realtime::RealtimeMessageNotifier notifier(registry);
+    notifier.group_message_stored(
+        message::Message(MessageId(42), UserId(100), GroupId(9), MessageText("hi all"), Timestamp(5)), members);
+
+    ASSERT_FALSE(connections.empty());
+    const auto* shared = connections[0]->frames.at(0).get();
+    for (const auto& connection : connections) {
+        ASSERT_EQ(connection->frames.size(), 1u);
+        EXPECT_EQ(connection->frames[0].get(), shared);
+    }
+    auto frame = json::parse(*connections[0]->frames[0]);
+    EXPECT_EQ(frame["group_id"], 9);
+    EXPECT_EQ(frame["text"], "hi all");
+    EXPECT_FALSE(frame.contains("receiver_id"));
+
+    std::vector<std::int64_t> ids{1, 2, 5, 1000};
+    auto raw = std::make_shared<const std::string>("x");
+    EXPECT_EQ(registry->send_to_users(ids, raw), 1u + 3u);
+}
+
+TEST(GroupConversation, HttpRoutesCreateSendAndReadGroupHistory) {
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("group-test-secret");
+    auto messages = std::make_shared<repository::InMemoryMessageRepository>();
+    auto groups = std::make_shared<repository::InMemoryGroupRepository>();
+    auto sendHandler = std::make_shared<chatserver::application::SendMessageHandler>(encryptor, messages);
+    auto groupSendHandler = std::make_shared<chatserver::application::SendGroupMessageHandler>(
+        encryptor, messages, groups);
+    auto historyHandler = std::make_shared<chatserver::application::GetMessageHistoryHandler>(
+        encryptor, messages, groups);
+
+    http::HttpRouter router;
+    http::resources::MessageResource(sendHandler, historyHandler).register_routes(router);
+    http::resources::GroupResource(std::make_shared<chatserver::application::CreateGroupHandler>(groups),
+                                   groupSendHandler).register_routes(router);
+
+    auto call = [&](const std::string& method, const std::string& target, const std::string& body = {}) {
+        http::HttpRequest req;
+        req.method = method;
+        req.target = target;
+        req.body = body;
+        return router.route(req);
+    };
+    auto collect = [](const http::HttpResponse& resp) {
+        if (!resp.stream_body) return resp.body;
+        std::string out;
+        resp.stream_body([&](std::string_view chunk) { out += chunk; });
+        return out;
+    };
+
+    auto created = call("POST", "/groups", R"({"members":[1,2,3]})");
+    ASSERT_EQ(created.status_code, 200);
+    const auto groupId = json::parse(created.body)["id"].get<std::int64_t>();
+    const auto g = std::to_string(groupId);
+
+    EXPECT_EQ(call("POST", "/send_group_message",
+                   R"({"sender_id":1,"group_id":)" + g + R"(,"text":"first"})").status_code, 200);
+    EXPECT_EQ(call("POST", "/send_group_message",
+                   R"({"sender_id":3,"group_id":)" + g + R"(,"text":"second"})").status_code, 200);
+    EXPECT_EQ(call("POST", "/send_group_message",
+                   R"({"sender_id":7,"group_id":)" + g + R"(,"text":"intruder"})").status_code, 403);
+    EXPECT_EQ(call("POST", "/send_group_message",
+                   R"({"sender_id":1,"group_id":999,"text":"x"})").status_code, 404);
+    EXPECT_EQ(call("POST", "/groups", R"({"members":["a"]})").status_code, 400);
+
+    auto history = call("GET", "/messages?user=2&group=" + g);
+    ASSERT_EQ(history.status_code, 200);
+    auto page = json::parse(collect(history));
+    ASSERT_EQ(page["messages"].size(), 2u);
+    EXPECT_EQ(page["messages"][0]["text"], "second");
+    EXPECT_EQ(page["messages"][0]["group_id"], groupId);
+    EXPECT_EQ(page["messages"][1]["sender_id"], 1);
+
+    EXPECT_EQ(call("GET", "/messages?user=7&group=" + g).status_code, 403);
+    EXPECT_EQ(call("GET", "/messages?user=1&peer=2&group=" + g).status_code, 400);
+}
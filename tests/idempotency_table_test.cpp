@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/cache/idempotency_table.h"
+#include "chatserver/infrastructure/http/http_router.h"
+#include "chatserver/infrastructure/http/resources/message_resource.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::application::SendMessageCommand;
+using chatserver::application::SendMessageHandler;
+
+namespace {
+
+// Шифратор-заглушка: считает вызовы.
+class CountingEncryptor final : public services::MessageEncryptor {
+public:
+    std::string encrypt(const std::string& plain) const override {
+        ++calls;
+        return "enc:" + plain;
+    }
+    std::string decrypt(const std::string& cipher) const override { return cipher.substr(4); }
+    mutable std::atomic<int> calls{0};
+};
+
+// Хранилище-заглушка: считает сохранения, умеет задерживать их и падать.
+class ProbeRepository final : public repository::MessageRepository {
+public:
+    std::int64_t save(const message::Message& message) override {
+        ++saves;
+        {
+            std::unique_lock lock(mutex);
+            ++entered;
+            changed.notify_all();
+            changed.wait(lock, [this] { return !blocked; });
+        }
+        if (failNext.exchange(false)) {
+            throw std::runtime_error("database is down");
+        }
+        return inner.save(message);
+    }
+    std::vector<message::Message> find_page(const ConversationId& conversation,
+                                            std::optional<MessageId> before,
+                                            std::size_t limit) const override {
+        return inner.find_page(conversation, before, limit);
+    }
+
+    void block() {
+        std::lock_guard lock(mutex);
+        blocked = true;
+    }
+    void release() {
+        std::lock_guard lock(mutex);
+        blocked = false;
+        changed.notify_all();
+    }
+    void wait_entered(int n) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this, n] { return entered >= n; });
+    }
+
+    repository::InMemoryMessageRepository inner;
+    std::atomic<int> saves{0};
+    std::atomic<bool> failNext{false};
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool blocked = false;
+    int entered = 0;
+};
+
+struct Fixture {
+    explicit Fixture(cache::IdempotencyOptions options = small_options())
+        : table(std::make_shared<cache::IdempotencyTable>(options))
+        , handler(encryptor, repo, nullptr, nullptr, table) {}
+
+    static cache::IdempotencyOptions small_options() {
+        cache::IdempotencyOptions options;
+        options.capacity = 4;
+        options.shards = 1;
+        return options;
+    }
+
+    std::shared_ptr<CountingEncryptor> encryptor = std::make_shared<CountingEncryptor>();
+    std::shared_ptr<ProbeRepository> repo = std::make_shared<ProbeRepository>();
+    std::shared_ptr<cache::IdempotencyTable> table;
+    SendMessageHandler handler;
+};
+
+SendMessageCommand keyed(std::int64_t sender, std::int64_t receiver, std::string text, std::string key) {
+    SendMessageCommand cmd{sender, receiver, std::move(text), std::move(key)};
+    return cmd;
+}
+
+}
+
+TEST(Idempotency, RetryReturnsOriginalIdWithoutWork) {
+    Fixture f;
+    const auto id = f.handler.handle(keyed(1, 2, "hello", "k-1"));
+    EXPECT_EQ(f.handler.handle(keyed(1, 2, "hello", "k-1")), id);
+    EXPECT_EQ(f.handler.handle(keyed(1, 2, "hello", "k-1")), id);
+    EXPECT_EQ(f.encryptor->calls, 1);
+    EXPECT_EQ(f.repo->saves, 1);
+
+    // Без ключа и с другим ключом — обычные отправки.
+    EXPECT_NE(f.handler.handle({1, 2, "hello", std::nullopt}), id);
+    EXPECT_NE(f.handler.handle(keyed(1, 2, "hello", "k-2")), id);
+    EXPECT_EQ(f.repo->saves, 3);
+
+    const auto s = f.table->stats();
+    EXPECT_EQ(s.executed, 2u);
+    EXPECT_EQ(s.replayed, 2u);
+    EXPECT_EQ(s.entries, 2u);
+    EXPECT_GT(s.bytes, 0u);
+}
+
+TEST(Idempotency, KeysAreScopedBySender) {
+    Fixture f;
+    const auto a = f.handler.handle(keyed(1, 2, "same", "shared"));
+    const auto b = f.handler.handle(keyed(3, 2, "same", "shared"));
+    EXPECT_NE(a, b);
+    EXPECT_EQ(f.repo->saves, 2);
+}
+
+TEST(Idempotency, KeyReusedForDifferentMessageIsRejected) {
+    Fixture f;
+    f.handler.handle(keyed(1, 2, "first", "k"));
+    EXPECT_THROW(f.handler.handle(keyed(1, 2, "second", "k")), cache::IdempotencyKeyReusedError);
+    EXPECT_THROW(f.handler.handle(keyed(1, 5, "first", "k")), cache::IdempotencyKeyReusedError);
+    EXPECT_EQ(f.repo->saves, 1);
+    EXPECT_EQ(f.table->stats().mismatches, 2u);
+}
+
+TEST(Idempotency, ConcurrentDuplicatesCoalesce) {
+    Fixture f;
+    f.repo->block();
+    constexpr int kThreads = 8;
+    std::vector<std::int64_t> ids(kThreads, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i] { ids[i] = f.handler.handle(keyed(1, 2, "tap tap", "double-tap")); });
+    }
+    f.repo->wait_entered(1);
+    // Ждём, пока остальные повторы встанут за первым запросом.
+    for (int i = 0; i < 500 && f.table->stats().coalesced < kThreads - 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    f.repo->release();
+    for (auto& t : threads) t.join();
+
+    for (const auto id : ids) EXPECT_EQ(id, ids[0]);
+    EXPECT_EQ(f.repo->saves, 1);
+    EXPECT_EQ(f.encryptor->calls, 1);
+    EXPECT_EQ(f.table->stats().coalesced, static_cast<std::uint64_t>(kThreads - 1));
+}
+
+TEST(Idempotency, FailureIsNotRemembered) {
+    Fixture f;
+    f.repo->failNext = true;
+    EXPECT_THROW(f.handler.handle(keyed(1, 2, "retry me", "k")), std::runtime_error);
+    EXPECT_EQ(f.table->stats().entries, 0u);
+    const auto id = f.handler.handle(keyed(1, 2, "retry me", "k"));
+    EXPECT_GT(id, 0);
+    EXPECT_EQ(f.handler.handle(keyed(1, 2, "retry me", "k")), id);
+    EXPECT_EQ(f.repo->saves, 2);
+}
+
+TEST(Idempotency, KeysExpireAfterTtl) {
+    auto options = Fixture::small_options();
+    options.ttl = std::chrono::seconds(1);
+    Fixture f(options);
+    const auto id = f.handler.handle(keyed(1, 2, "old", "k"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_NE(f.handler.handle(keyed(1, 2, "old", "k")), id);
+    EXPECT_EQ(f.table->stats().expired, 1u);
+}
+
+TEST(Idempotency, CapacityEvictsOldestKeys) {
+    Fixture f;
+    std::vector<std::int64_t> ids;
+    for (int i = 0; i < 6; ++i) ids.push_back(f.handler.handle(keyed(1, 2, "m", "k" + std::to_string(i))));
+    const auto s = f.table->stats();
+    EXPECT_EQ(s.evictions, 2u);
+    EXPECT_EQ(s.entries, 4u);
+
+    EXPECT_EQ(f.handler.handle(keyed(1, 2, "m", "k5")), ids[5]);
+    EXPECT_NE(f.handler.handle(keyed(1, 2, "m", "k0")), ids[0]);  // вытеснен — выполняется снова
+}
+
+TEST(Idempotency, HttpHeaderIsCaseInsensitiveAndValidated) {
+    Fixture f;
+    http::HttpRouter router;
+    auto handler = std::make_shared<SendMessageHandler>(f.encryptor, f.repo, nullptr, nullptr, f.table);
+    http::resources::MessageResource resource(handler, nullptr);
+    resource.register_routes(router);
+
+    auto post = [&](const std::string& header, const std::string& key, const std::string& text) {
+        http::HttpRequest req;
+        req.method = "POST";
+        req.target = "/send_message";
+        req.body = R"({"sender_id":1,"receiver_id":2,"text":")" + text + R"("})";
+        req.headers.emplace(header, key);
+        return router.route(req);
+    };
+
+    const auto first = post("Idempotency-Key", "abc", "hi");
+    ASSERT_EQ(first.status_code, 200);
+    const auto retry = post("idempotency-key", "abc", "hi");
+    EXPECT_EQ(retry.status_code, 200);
+    EXPECT_EQ(retry.body, first.body);
+    EXPECT_EQ(f.repo->saves, 1);
+
+    EXPECT_EQ(post("Idempotency-Key", "abc", "changed").status_code, 422);
+    EXPECT_EQ(post("Idempotency-Key", "", "hi").status_code, 400);
+    EXPECT_EQ(post("Idempotency-Key", std::string(256, 'x'), "hi").status_code, 400);
+}
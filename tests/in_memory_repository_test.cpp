@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/repository/in_memory_user_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::message::Message;
+using chatserver::domain::user::User;
+
+TEST(InMemoryUserRepository, SaveAssignsIdsAndFinds) {
+    InMemoryUserRepository repo;
+
+    auto aliceId = repo.save(User(Username("alice"), PasswordHash("salt:hash1")));
+    auto bobId = repo.save(User(Username("bob"), PasswordHash("salt:hash2")));
+    // id выдаются как SERIAL: с единицы и по возрастанию
+    EXPECT_EQ(aliceId, 1);
+    EXPECT_EQ(bobId, 2);
+
+    auto found = repo.find_by_username("bob");
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(found->id().value(), bobId);
+    EXPECT_EQ(found->password_hash().value(), "salt:hash2");
+
+    EXPECT_FALSE(repo.find_by_username("carol").has_value());
+}
+
+TEST(InMemoryUserRepository, DuplicateUsernameRejected) {
+    InMemoryUserRepository repo;
+    repo.save(User(Username("alice"), PasswordHash("h1")));
+
+    EXPECT_THROW(repo.save(User(Username("alice"), PasswordHash("h2"))), UsernameTakenError);
+    // Первый пользователь не перезаписан
+    EXPECT_EQ(repo.find_by_username("alice")->password_hash().value(), "h1");
+    EXPECT_EQ(repo.size(), 1u);
+}
+
+TEST(InMemoryUserRepository, ConcurrentRegistrationOfSameNameHasOneWinner) {
+    InMemoryUserRepository repo;
+    std::atomic<int> winners{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            try {
+                repo.save(User(Username("contended"), PasswordHash("h")));
+                ++winners;
+            } catch (const UsernameTakenError&) {}
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(winners.load(), 1);
+}
+
+TEST(InMemoryMessageRepository, IdsAreSequentialAndReadable) {
+    InMemoryMessageRepository repo;
+    for (int i = 1; i <= 5; ++i) {
+        Message m(UserId(42), UserId(43), MessageText("text " + std::to_string(i)), Timestamp(1000 + i));
+        EXPECT_EQ(repo.save(m), i);
+    }
+
+    auto third = repo.find_by_id(3);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->id().value(), 3);
+    EXPECT_EQ(third->sender_id().value(), 42);
+    EXPECT_EQ(third->text().value(), "text 3");
+
+    EXPECT_FALSE(repo.find_by_id(0).has_value());
+    EXPECT_FALSE(repo.find_by_id(6).has_value());
+}
+
+TEST(InMemoryMessageRepository, ConcurrentSavesCrossChunksWithUniqueIds) {
+    InMemoryMessageRepository repo;
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 2 * static_cast<int>(InMemoryMessageRepository::kChunkSize);
+
+    std::vector<std::vector<std::int64_t>> ids(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                ids[t].push_back(repo.save(Message(UserId(t + 1), UserId(1), MessageText("m"), Timestamp(0))));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    std::set<std::int64_t> all;
+    for (const auto& v : ids) all.insert(v.begin(), v.end());
+    ASSERT_EQ(all.size(), static_cast<std::size_t>(kThreads * kPerThread));
+    EXPECT_EQ(*all.begin(), 1);
+    EXPECT_EQ(*all.rbegin(), kThreads * kPerThread);
+
+    // Каждое сообщение читается по своему id и принадлежит потоку, который его записал
+    for (int t = 0; t < kThreads; ++t) {
+        for (auto id : ids[t]) {
+            auto m = repo.find_by_id(id);
+            ASSERT_TRUE(m.has_value());
+            EXPECT_EQ(m->sender_id().value(), t + 1);
+        }
+    }
+}
+
+TEST(InMemoryMessageRepository, FullStoreThrows) {
+    InMemoryMessageRepository repo(1);
+    // Ёмкость округляется вверх до целого чанка
+    for (std::size_t i = 0; i < InMemoryMessageRepository::kChunkSize; ++i) {
+        repo.save(Message(UserId(1), UserId(2), MessageText("m"), Timestamp(0)));
+    }
+    EXPECT_THROW(repo.save(Message(UserId(1), UserId(2), MessageText("m"), Timestamp(0))), std::runtime_error);
+}
@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/http/resources/long_poll_resource.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/long_poll_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/nlohmann/json.hpp"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace bhttp     = beast::http;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using json          = nlohmann::json;
+
+using namespace chatserver::infrastructure;
+using namespace std::chrono_literals;
+using chatserver::test::wait_until;
+
+namespace {
+
+std::shared_ptr<const std::string> frame(const std::string& text) {
+    return std::make_shared<const std::string>(text);
+}
+
+realtime::LongPollOptions fast_options() {
+    realtime::LongPollOptions options;
+    options.shards = 4;
+    options.tick = 10ms;
+    return options;
+}
+
+// Результат ожидания: заполняется из потока, вызвавшего done.
+struct Outcome {
+    std::promise<realtime::LongPollResult> promise;
+    std::future<realtime::LongPollResult> future = promise.get_future();
+    realtime::LongPollRegistry::Callback callback() {
+        return [this](realtime::LongPollResult result) { promise.set_value(std::move(result)); };
+    }
+    bool ready() { return future.wait_for(0s) == std::future_status::ready; }
+};
+
+std::vector<std::string> texts(const realtime::LongPollResult& result) {
+    std::vector<std::string> out;
+    for (const auto& f : result.frames) out.push_back(*f);
+    return out;
+}
+
+}
+
+TEST(LongPollRegistry, ParksUntilPublishAndAnswersAtOnceWhenAhead) {
+    realtime::LongPollRegistry registry(fast_options());
+
+    Outcome first;
+    registry.wait(7, std::nullopt, 10s, first.callback());
+    EXPECT_FALSE(first.ready());
+    EXPECT_EQ(registry.stats().parked, 1u);
+    EXPECT_TRUE(registry.has_mailbox(7));
+    EXPECT_FALSE(registry.has_mailbox(8));
+
+    registry.publish(8, 1, frame("other"));  // у пользователя 8 ящика нет — ничего не происходит
+    registry.publish(7, 2, frame("a"));
+    ASSERT_TRUE(first.ready());
+    auto r1 = first.future.get();
+    EXPECT_EQ(texts(r1), std::vector<std::string>{"a"});
+    EXPECT_EQ(r1.nextAfter, 2);
+    EXPECT_FALSE(r1.gap);
+
+    // Сообщения, пришедшие между запросами, отдаются сразу
+    registry.publish(7, 3, frame("b"));
+    registry.publish(7, 4, frame("c"));
+    Outcome second;
+    registry.wait(7, r1.nextAfter, 10s, second.callback());
+    ASSERT_TRUE(second.ready());
+    auto r2 = second.future.get();
+    EXPECT_EQ(texts(r2), (std::vector<std::string>{"b", "c"}));
+    EXPECT_EQ(r2.nextAfter, 4);
+
+    const auto stats = registry.stats();
+    EXPECT_EQ(stats.woken, 1u);
+    EXPECT_EQ(stats.immediate, 1u);
+    EXPECT_EQ(stats.parked, 0u);
+}
+
+TEST(LongPollRegistry, TimesOutWithEmptyAnswer) {
+    realtime::LongPollRegistry registry(fast_options());
+    Outcome open;
+    registry.wait(1, std::nullopt, 0ms, open.callback());  // заводим ящик
+    Outcome outcome;
+    const auto start = std::chrono::steady_clock::now();
+    registry.wait(1, 5, 100ms, outcome.callback());
+    ASSERT_EQ(outcome.future.wait_for(5s), std::future_status::ready);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 100ms);
+    auto result = outcome.future.get();
+    EXPECT_TRUE(result.frames.empty());
+    EXPECT_EQ(result.nextAfter, 5);
+    EXPECT_EQ(registry.stats().timedOut, 1u);
+
+    // timeout=0 — просто проверка, без ожидания
+    Outcome poll;
+    registry.wait(1, 5, 0ms, poll.callback());
+    EXPECT_TRUE(poll.ready());
+}
+
+TEST(LongPollRegistry, OutOfOrderCommitsAreNotLost) {
+    realtime::LongPollRegistry registry(fast_options());
+    Outcome open;
+    registry.wait(1, 0, 0ms, open.callback());  // заводим ящик
+
+    // Сообщения 11 и 10 сохранены параллельно, 11 опубликовано первым
+    registry.publish(1, 11, frame("eleven"));
+    Outcome first;
+    registry.wait(1, 0, 1s, first.callback());
+    auto r1 = first.future.get();
+    EXPECT_EQ(r1.nextAfter, 11);
+
+    Outcome second;
+    registry.wait(1, r1.nextAfter, 5s, second.callback());
+    EXPECT_FALSE(second.ready());
+    registry.publish(1, 10, frame("ten"));
+    ASSERT_TRUE(second.ready());
+    auto r2 = second.future.get();
+    EXPECT_EQ(texts(r2), std::vector<std::string>{"ten"});
+    EXPECT_EQ(r2.nextAfter, 10);
+
+    Outcome third;
+    registry.wait(1, r2.nextAfter, 0ms, third.callback());
+    EXPECT_TRUE(third.future.get().frames.empty());
+}
+
+TEST(LongPollRegistry, GapWhenClientFellBehindAndWaiterLimit) {
+    auto options = fast_options();
+    options.mailboxCapacity = 2;
+    options.maxWaitersPerUser = 2;
+    realtime::LongPollRegistry registry(options);
+
+    Outcome open;
+    registry.wait(3, 0, 0ms, open.callback());
+    for (int id = 1; id <= 4; ++id) registry.publish(3, id, frame(std::to_string(id)));
+    Outcome behind;
+    registry.wait(3, 1, 5s, behind.callback());
+    auto r = behind.future.get();
+    EXPECT_TRUE(r.gap);
+    EXPECT_EQ(texts(r), (std::vector<std::string>{"3", "4"}));
+
+    // Третий ожидающий вытесняет первого
+    Outcome a, b, c;
+    registry.wait(3, 4, 5s, a.callback());
+    registry.wait(3, 4, 5s, b.callback());
+    registry.wait(3, 4, 5s, c.callback());
+    ASSERT_TRUE(a.ready());
+    EXPECT_TRUE(a.future.get().frames.empty());
+    EXPECT_FALSE(b.ready());
+    EXPECT_EQ(registry.stats().superseded, 1u);
+    registry.publish(3, 5, frame("5"));
+    EXPECT_EQ(texts(b.future.get()), std::vector<std::string>{"5"});
+    EXPECT_EQ(texts(c.future.get()), std::vector<std::string>{"5"});
+}
+
+TEST(LongPollRegistry, CursorWithoutMailboxAnswersGapAtOnce) {
+    auto options = fast_options();
+    options.mailboxRetention = 1s;
+    realtime::LongPollRegistry registry(options);
+
+    // Ящика нет: 6 и 7 сохранены, но в реестре не остались — клиент должен дочитать историю
+    registry.publish(1, 6, frame("6"));
+    registry.publish(1, 7, frame("7"));
+    Outcome first;
+    registry.wait(1, 5, 10s, first.callback());
+    ASSERT_TRUE(first.ready());
+    auto r1 = first.future.get();
+    EXPECT_TRUE(r1.gap);
+    EXPECT_TRUE(r1.frames.empty());
+    EXPECT_EQ(r1.nextAfter, 5);
+
+    // Теперь ящик есть: следующий опрос с курсором из истории ждёт
+    Outcome second;
+    registry.wait(1, 7, 10s, second.callback());
+    EXPECT_FALSE(second.ready());
+    registry.publish(1, 8, frame("8"));
+    auto r2 = second.future.get();
+    EXPECT_FALSE(r2.gap);
+    EXPECT_EQ(texts(r2), std::vector<std::string>{"8"});
+
+    // Ящик истёк по mailboxRetention — сообщение 9 прошло мимо, снова gap
+    ASSERT_TRUE(wait_until([&] { return !registry.has_mailbox(1); }));
+    registry.publish(1, 9, frame("9"));
+    Outcome third;
+    registry.wait(1, 8, 10s, third.callback());
+    ASSERT_TRUE(third.ready());
+    EXPECT_TRUE(third.future.get().gap);
+}
+
+TEST(LongPollRegistry, IdleMailboxIsEvictedAndPendingWaitersAnsweredOnShutdown) {
+    auto options = fast_options();
+    options.mailboxRetention = 1s;
+    Outcome pending;
+    {
+        realtime::LongPollRegistry registry(options);
+        Outcome once;
+        registry.wait(1, 0, 0ms, once.callback());
+        EXPECT_EQ(registry.stats().mailboxes, 1u);
+        EXPECT_TRUE(wait_until([&] { return registry.stats().mailboxes == 0; }));
+        EXPECT_FALSE(registry.has_mailbox(1));
+
+        registry.wait(2, std::nullopt, 30s, pending.callback());
+        EXPECT_FALSE(pending.ready());
+    }
+    ASSERT_TRUE(pending.ready());
+    EXPECT_TRUE(pending.future.get().frames.empty());
+}
+
+namespace {
+
+// /messages/wait и отправка сообщений через общий с ним реестр long-poll.
+struct Server {
+    Server()
+        : sender(std::make_shared<chatserver::application::SendMessageHandler>(
+              std::make_shared<crypto::OpenSSLMessageEncryptor>("test-secret"),
+              std::make_shared<repository::InMemoryMessageRepository>(),
+              std::make_shared<realtime::RealtimeMessageNotifier>(connections, longPoll)))
+        , web(routes(longPoll), single_worker(), connections) {}
+
+    static std::shared_ptr<http::HttpRouter> routes(std::shared_ptr<realtime::LongPollRegistry> longPoll) {
+        auto router = std::make_shared<http::HttpRouter>();
+        http::resources::LongPollResource(std::move(longPoll)).register_routes(*router);
+        router->add_route("GET", "/ping", [](const http::HttpRequest&) { return http::HttpResponse{200, "{}"}; });
+        return router;
+    }
+
+    static http::HttpServerOptions single_worker() {
+        http::HttpServerOptions options;
+        options.workerThreads = 1;
+        return options;
+    }
+
+    std::shared_ptr<realtime::ConnectionRegistry> connections = std::make_shared<realtime::ConnectionRegistry>();
+    std::shared_ptr<realtime::LongPollRegistry> longPoll = std::make_shared<realtime::LongPollRegistry>(fast_options());
+    std::shared_ptr<chatserver::application::SendMessageHandler> sender;
+    chatserver::test::TestServer web;
+};
+
+}
+
+TEST(LongPollHttp, WaitWakesOnSendWithoutHoldingWorkers) {
+    Server srv;
+    // Больше ожидающих, чем воркеров (1): ожидание не занимает поток
+    constexpr int kPollers = 16;
+    std::vector<std::future<bhttp::response<bhttp::string_body>>> polls;
+    for (int i = 0; i < kPollers; ++i) {
+        polls.push_back(std::async(std::launch::async, [&srv, i] {
+            return srv.web.get("/messages/wait?user=" + std::to_string(100 + i) + "&timeout=20");
+        }));
+    }
+    ASSERT_TRUE(wait_until([&] { return srv.longPoll->stats().parked == kPollers; }));
+    EXPECT_EQ(srv.web.get("/ping").result_int(), 200);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPollers; ++i) {
+        srv.sender->handle({1, 100 + i, "hello " + std::to_string(i), std::nullopt});
+    }
+    for (int i = 0; i < kPollers; ++i) {
+        auto res = polls[i].get();
+        ASSERT_EQ(res.result_int(), 200);
+        auto body = json::parse(res.body());
+        ASSERT_EQ(body["messages"].size(), 1u);
+        EXPECT_EQ(body["messages"][0]["text"], "hello " + std::to_string(i));
+        EXPECT_EQ(body["messages"][0]["receiver_id"], 100 + i);
+        EXPECT_EQ(body["next_after"], body["messages"][0]["id"]);
+        EXPECT_EQ(body["gap"], false);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+
+    // Следующий запрос с курсором ждёт и по таймауту отдаёт пустой список
+    auto res = srv.web.get("/messages/wait?user=100&after=1&timeout=1");
+    auto body = json::parse(res.body());
+    EXPECT_TRUE(body["messages"].empty());
+    EXPECT_EQ(body["next_after"], 1);
+
+    EXPECT_EQ(srv.web.get("/messages/wait?user=abc").result_int(), 400);
+    EXPECT_EQ(srv.web.get("/messages/wait?user=1&timeout=-1").result_int(), 400);
+}
+
+TEST(LongPollHttp, ServerStopsWithParkedRequests) {
+    auto srv = std::make_unique<Server>();
+    auto poll = std::async(std::launch::async, [&srv] {
+        try {
+            srv->web.get("/messages/wait?user=5&timeout=30");
+        } catch (const std::exception&) {
+            // Соединение закрыто остановкой сервера
+        }
+    });
+    ASSERT_TRUE(wait_until([&] { return srv->longPoll->stats().parked == 1; }));
+    srv->web.server.stop();
+    EXPECT_EQ(poll.wait_for(5s), std::future_status::ready);
+    // Реестр переживает сервер: запоздалый ответ не трогает остановленный сервер
+    srv->sender->handle({1, 5, "late", std::nullopt});
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/http/http_request.h"
+#include "chatserver/infrastructure/http/message_cursor.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/infrastructure/repository/log_message_repository.h"
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::message::Message;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+Message msg(std::int64_t sender, std::int64_t receiver, const std::string& text) {
+    return Message(UserId(sender), UserId(receiver), MessageText(text), Timestamp(1700000000));
+}
+
+std::vector<std::int64_t> ids_of(const std::vector<Message>& page) {
+    std::vector<std::int64_t> ids;
+    for (const auto& m : page) ids.push_back(m.id().value());
+    return ids;
+}
+
+// Общий сценарий для всех реализаций: две переписки вперемешку,
+// страницы по 3 идут назад по курсору и не пересекаются.
+void expect_keyset_pages(MessageRepository& repo) {
+    for (int i = 0; i < 10; ++i) {
+        if (i % 2 == 0) {
+            // Переписка 7 ↔ 9 в обе стороны
+            repo.save(i % 4 == 0 ? msg(7, 9, "m" + std::to_string(i)) : msg(9, 7, "m" + std::to_string(i)));
+        } else {
+            repo.save(msg(8, 9, "m" + std::to_string(i)));
+        }
+    }
+    // Переписка 7 ↔ 9: id 1, 3, 5, 7, 9
+    const auto conversation = ConversationId::between(UserId(9), UserId(7));
+
+    auto first = repo.find_page(conversation, std::nullopt, 3);
+    EXPECT_EQ(ids_of(first), (std::vector<std::int64_t>{9, 7, 5}));
+
+    auto second = repo.find_page(conversation, MessageId(first.back().id().value()), 3);
+    EXPECT_EQ(ids_of(second), (std::vector<std::int64_t>{3, 1}));
+    EXPECT_EQ(second.front().text().value(), "m2");
+    EXPECT_EQ(second.front().sender_id().value(), 9);
+    EXPECT_EQ(second.front().receiver_id().value(), 7);
+
+    // before не обязан принадлежать переписке
+    EXPECT_EQ(ids_of(repo.find_page(conversation, MessageId(8), 3)), (std::vector<std::int64_t>{7, 5, 3}));
+
+    EXPECT_TRUE(repo.find_page(conversation, MessageId(1), 3).empty());
+    EXPECT_TRUE(repo.find_page(ConversationId::between(UserId(7), UserId(8)), std::nullopt, 3).empty());
+}
+
+}
+
+TEST(ConversationIdTest, OrderedPair) {
+    auto a = ConversationId::between(UserId(5), UserId(3));
+    auto b = ConversationId::between(UserId(3), UserId(5));
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.low().value(), 3);
+    EXPECT_EQ(a.high().value(), 5);
+    EXPECT_FALSE(a == ConversationId::between(UserId(3), UserId(6)));
+    EXPECT_THROW(ConversationId::between(UserId(0), UserId(1)), std::invalid_argument);
+    EXPECT_THROW(ConversationId::between(UserId(1), UserId(std::int64_t{1} << 32)), std::invalid_argument);
+}
+
+TEST(MessageCursor, RoundTripAndRejectsGarbage) {
+    for (std::int64_t id : {1LL, 42LL, 1LL << 40, 9223372036854775807LL}) {
+        auto cursor = chatserver::infrastructure::http::encode_message_cursor(id);
+        EXPECT_EQ(chatserver::infrastructure::http::decode_message_cursor(cursor), id);
+    }
+    EXPECT_FALSE(chatserver::infrastructure::http::decode_message_cursor("123").has_value());
+    EXPECT_FALSE(chatserver::infrastructure::http::decode_message_cursor("AAAAAAAAAAAA").has_value());
+    EXPECT_FALSE(chatserver::infrastructure::http::decode_message_cursor("!!!!!!!!!!!!").has_value());
+}
+
+TEST(HttpRequestQuery, PathAndParams) {
+    chatserver::infrastructure::http::HttpRequest req;
+    req.target = "/messages?peer=5&before=AQ%2D_&limit=20&flag";
+    EXPECT_EQ(req.path(), "/messages");
+    EXPECT_EQ(req.query_param("peer"), "5");
+    EXPECT_EQ(req.query_param("before"), "AQ-_");
+    EXPECT_EQ(req.query_param("flag"), "");
+    EXPECT_FALSE(req.query_param("missing").has_value());
+}
+
+TEST(MessageHistory, InMemoryKeysetPages) {
+    InMemoryMessageRepository repo;
+    expect_keyset_pages(repo);
+}
+
+TEST(MessageHistory, LogStoreKeysetPagesAcrossSegments) {
+    const auto dir = fs::temp_directory_path() /
+                     ("chatserver_history_test_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    {
+        LogStoreOptions options;
+        options.directory = dir.string();
+        options.indexIntervalBytes = 1;
+        // Маленькие сегменты и точка индекса на каждую запись — страница
+        // обязана пройти через границы блоков и сегментов.
+        options.maxSegmentBytes = 128;
+        {
+            LogMessageRepository repo(options);
+            expect_keyset_pages(repo);
+        }
+        // После перезапуска цепочки переписок восстанавливаются из .idx и хвоста
+        LogMessageRepository repo(options);
+        const auto conversation = ConversationId::between(UserId(7), UserId(9));
+        EXPECT_EQ(ids_of(repo.find_page(conversation, std::nullopt, 10)),
+                  (std::vector<std::int64_t>{9, 7, 5, 3, 1}));
+        repo.save(msg(7, 9, "after restart"));
+        EXPECT_EQ(ids_of(repo.find_page(conversation, std::nullopt, 2)), (std::vector<std::int64_t>{11, 9}));
+    }
+    fs::remove_all(dir);
+}
+
+TEST(MessageHistory, HandlerDecryptsPageAndReportsMore) {
+    auto encryptor = std::make_shared<chatserver::infrastructure::crypto::OpenSSLMessageEncryptor>("secret");
+    auto repo = std::make_shared<InMemoryMessageRepository>();
+    for (int i = 1; i <= 5; ++i) {
+        repo->save(msg(i % 2 == 0 ? 3 : 4, i % 2 == 0 ? 4 : 3, encryptor->encrypt("text " + std::to_string(i))));
+    }
+
+    chatserver::application::GetMessageHistoryHandler handler(encryptor, repo);
+    auto page = handler.handle({3, 4, std::nullopt, 2, std::nullopt});
+    ASSERT_EQ(page.messages.size(), 2u);
+    EXPECT_TRUE(page.has_more);
+    EXPECT_EQ(page.messages[0].text, "text 5");
+    EXPECT_EQ(page.messages[1].text, "text 4");
+
+    auto last = handler.handle({4, 3, page.messages.back().id, 10, std::nullopt});
+    ASSERT_EQ(last.messages.size(), 3u);
+    EXPECT_FALSE(last.has_more);
+    EXPECT_EQ(last.messages.back().text, "text 1");
+    EXPECT_EQ(last.messages.back().sender_id, 4);
+
+    EXPECT_THROW(handler.handle({3, 0, std::nullopt, 10, std::nullopt}), std::invalid_argument);
+}
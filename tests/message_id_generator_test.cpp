@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/application/handlers/send_group_message_handler.h"
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/repository/in_memory_group_repository.h"
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::application::SendGroupMessageCommand;
+using chatserver::application::SendGroupMessageHandler;
+using chatserver::application::SendMessageHandler;
+
+namespace {
+
+constexpr std::int64_t kT0 = MessageIdGenerator::kEpochMs + 86'400'000;  // сутки после эпохи
+
+class PlainEncryptor final : public services::MessageEncryptor {
+public:
+    std::string encrypt(const std::string& plain) const override { return plain; }
+    std::string decrypt(const std::string& cipher) const override { return cipher; }
+};
+
+// Хранилище как Postgres с назначенным id: сохраняет id сообщения и возвращает его.
+class RecordingRepository final : public repository::MessageRepository {
+public:
+    std::int64_t save(const message::Message& message) override {
+        std::lock_guard lock(mutex);
+        saved.push_back(message.id().value());
+        return message.id().value();
+    }
+    std::vector<message::Message> find_page(const ConversationId&, std::optional<MessageId>,
+                                            std::size_t) const override {
+        return {};
+    }
+
+    std::mutex mutex;
+    std::vector<std::int64_t> saved;
+};
+
+}
+
+TEST(MessageIdGenerator, LayoutRoundTrips) {
+    MessageIdGenerator ids(517, [] { return kT0; });
+    const auto first = ids.next();
+    const auto second = ids.next();
+    EXPECT_GT(first.value(), 0);
+    EXPECT_EQ(second.value(), first.value() + 1);
+
+    const auto parts = MessageIdGenerator::decode(second);
+    EXPECT_EQ(parts.unixMs, kT0);
+    EXPECT_EQ(parts.node, 517);
+    EXPECT_EQ(parts.sequence, 1);
+
+    // compose — та же раскладка с заданным временем; до эпохи id не бывает.
+    EXPECT_EQ(MessageIdGenerator::compose(kT0, 517, 1), second);
+    EXPECT_EQ(MessageIdGenerator::compose(kT0, 517, 4096 + 1), second);
+    EXPECT_LT(MessageIdGenerator::compose(kT0 - 1, 517, 4095).value(), first.value());
+    EXPECT_THROW(MessageIdGenerator::compose(MessageIdGenerator::kEpochMs - 1, 0, 0), std::invalid_argument);
+    EXPECT_THROW(MessageIdGenerator::compose(kT0, MessageIdGenerator::kMaxNode + 1, 0), std::invalid_argument);
+}
+
+TEST(MessageIdGenerator, NodeMustFitTenBits) {
+    EXPECT_THROW(MessageIdGenerator(-1), std::invalid_argument);
+    EXPECT_THROW(MessageIdGenerator(MessageIdGenerator::kMaxNode + 1), std::invalid_argument);
+    EXPECT_NO_THROW(MessageIdGenerator(MessageIdGenerator::kMaxNode));
+}
+
+TEST(MessageIdGenerator, NodesNeverCollide) {
+    MessageIdGenerator a(1, [] { return kT0; });
+    MessageIdGenerator b(2, [] { return kT0; });
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_NE(a.next().value(), b.next().value());
+    }
+}
+
+TEST(MessageIdGenerator, StaysMonotonicWhenClockGoesBack) {
+    std::int64_t now = kT0;
+    MessageIdGenerator ids(3, [&now] { return now; });
+    const auto before = ids.next();
+    now -= 5'000;  // NTP отвёл часы на 5 секунд назад
+    const auto after = ids.next();
+    EXPECT_GT(after.value(), before.value());
+    EXPECT_EQ(MessageIdGenerator::decode(after).unixMs, kT0);
+
+    now = kT0 + 10;
+    const auto later = ids.next();
+    EXPECT_EQ(MessageIdGenerator::decode(later).unixMs, kT0 + 10);
+    EXPECT_EQ(MessageIdGenerator::decode(later).sequence, 0);
+}
+
+TEST(MessageIdGenerator, SequenceOverflowBorrowsNextMillisecond) {
+    MessageIdGenerator ids(0, [] { return kT0; });
+    MessageId last(0);
+    for (int i = 0; i < (1 << MessageIdGenerator::kSequenceBits); ++i) {
+        last = ids.next();
+    }
+    EXPECT_EQ(MessageIdGenerator::decode(last).unixMs, kT0);
+    EXPECT_EQ(MessageIdGenerator::decode(last).sequence, (1 << MessageIdGenerator::kSequenceBits) - 1);
+
+    const auto borrowed = ids.next();
+    EXPECT_GT(borrowed.value(), last.value());
+    EXPECT_EQ(MessageIdGenerator::decode(borrowed).unixMs, kT0 + 1);
+    EXPECT_EQ(MessageIdGenerator::decode(borrowed).sequence, 0);
+    EXPECT_EQ(MessageIdGenerator::decode(borrowed).node, 0);
+}
+
+TEST(MessageIdGenerator, ConcurrentIdsAreUniqueAndIncreasingPerThread) {
+    MessageIdGenerator ids(42);
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 20'000;
+    std::vector<std::vector<std::int64_t>> issued(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            issued[t].reserve(kPerThread);
+            for (int i = 0; i < kPerThread; ++i) issued[t].push_back(ids.next().value());
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::vector<std::int64_t> all;
+    for (const auto& own : issued) {
+        EXPECT_TRUE(std::is_sorted(own.begin(), own.end()));
+        EXPECT_EQ(std::adjacent_find(own.begin(), own.end()), own.end());
+        all.insert(all.end(), own.begin(), own.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(std::adjacent_find(all.begin(), all.end()), all.end());
+    for (const auto id : all) EXPECT_EQ(MessageIdGenerator::decode(MessageId(id)).node, 42);
+}
+
+TEST(MessageIdGenerator, HandlersAssignIdBeforeSave) {
+    auto encryptor = std::make_shared<PlainEncryptor>();
+    auto repo = std::make_shared<RecordingRepository>();
+    auto groups = std::make_shared<repository::InMemoryGroupRepository>();
+    auto ids = std::make_shared<MessageIdGenerator>(7, [] { return kT0; });
+
+    SendMessageHandler direct(encryptor, repo, nullptr, nullptr, nullptr, ids);
+    SendGroupMessageHandler group(encryptor, repo, groups, nullptr, nullptr, ids);
+    const auto groupId = groups->create({UserId(1), UserId(2)});
+
+    const auto a = direct.handle({1, 2, "hello", std::nullopt});
+    const auto b = group.handle({1, groupId, "hi all"});
+    ASSERT_EQ(repo->saved.size(), 2u);
+    EXPECT_EQ(repo->saved[0], a);
+    EXPECT_EQ(repo->saved[1], b);
+    EXPECT_GT(b, a);
+    EXPECT_EQ(MessageIdGenerator::decode(MessageId(a)).node, 7);
+
+    // Без генератора id назначает хранилище: в save() приходит 0.
+    SendMessageHandler plain(encryptor, repo);
+    plain.handle({1, 2, "legacy", std::nullopt});
+    EXPECT_EQ(repo->saved.back(), 0);
+}
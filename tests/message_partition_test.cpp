@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/repository/message_partition_maintainer.h"
+#include "chatserver/infrastructure/repository/postgres_message_repository.h"
+
+using namespace chatserver::infrastructure::repository;
+using chatserver::domain::MessageId;
+using chatserver::domain::MessageIdGenerator;
+
+namespace {
+
+constexpr std::int64_t kDay = 24 * 60 * 60;
+constexpr std::int64_t k20261019 = 1'792'368'000;
+// 2026-10-19T00:00:00Z
+
+}
+
+TEST(MessagePartitions, ParsesInterval) {
+    EXPECT_EQ(parse_partition_interval("none"), PartitionInterval::None);
+    EXPECT_EQ(parse_partition_interval("daily"), PartitionInterval::Daily);
+    EXPECT_EQ(parse_partition_interval("monthly"), PartitionInterval::Monthly);
+    EXPECT_THROW(parse_partition_interval("weekly"), std::invalid_argument);
+    EXPECT_THROW(partition_for(PartitionInterval::None, k20261019), std::invalid_argument);
+}
+
+TEST(MessagePartitions, DailyRangeCoversUtcDay) {
+    const auto start = partition_for(PartitionInterval::Daily, k20261019);
+    EXPECT_EQ(start.name, "messages_p20261019");
+    EXPECT_EQ(start.fromUnix, k20261019);
+    EXPECT_EQ(start.toUnix, k20261019 + kDay);
+
+    const auto last = partition_for(PartitionInterval::Daily, k20261019 + kDay - 1);
+    EXPECT_EQ(last.name, start.name);
+    EXPECT_EQ(partition_for(PartitionInterval::Daily, start.toUnix).name, "messages_p20261020");
+}
+
+TEST(MessagePartitions, MonthlyRangeRollsOverYear) {
+    const auto october = partition_for(PartitionInterval::Monthly, k20261019 + 12345);
+    EXPECT_EQ(october.name, "messages_p202610");
+    EXPECT_EQ(october.fromUnix, k20261019 - 18 * kDay);
+    EXPECT_EQ(october.toUnix, k20261019 + 13 * kDay);
+
+    const auto december = partition_for(PartitionInterval::Monthly, k20261019 + 60 * kDay);
+    EXPECT_EQ(december.name, "messages_p202612");
+    const auto january = partition_for(PartitionInterval::Monthly, december.toUnix);
+    EXPECT_EQ(january.name, "messages_p202701");
+    EXPECT_EQ(january.fromUnix, december.toUnix);
+    EXPECT_EQ(january.toUnix - january.fromUnix, 31 * kDay);
+}
+
+TEST(HistoryPruning, FirstPageReadsRecentWindow) {
+    HistoryPruningOptions options;
+    options.enabled = true;
+    const std::int64_t nowUs = k20261019 * 1'000'000;
+    const auto bounds = history_time_bounds(std::nullopt, nowUs, options);
+    EXPECT_FALSE(bounds.beforeUs.has_value());
+    EXPECT_EQ(bounds.recentFromUs, nowUs - std::int64_t{7} * kDay * 1'000'000);
+}
+
+TEST(HistoryPruning, GeneratedCursorBoundsCreatedAt) {
+    HistoryPruningOptions options;
+    options.enabled = true;
+    options.recentWindow = std::chrono::hours(24);
+    options.clockSkew = std::chrono::seconds(60);
+    const std::int64_t cursorMs = k20261019 * 1000 - 30 * kDay * 1000 + 123;
+    MessageIdGenerator ids(5, [cursorMs] { return cursorMs; });
+    const auto cursor = ids.next();
+
+    const auto bounds = history_time_bounds(cursor, k20261019 * 1'000'000, options);
+    ASSERT_TRUE(bounds.beforeUs.has_value());
+    // Время id округлено до миллисекунды: граница — её конец плюс расхождение часов.
+    EXPECT_EQ(*bounds.beforeUs, (cursorMs + 1) * 1000 + 60'000'000);
+    EXPECT_EQ(bounds.recentFromUs, *bounds.beforeUs - kDay * 1'000'000);
+}
+
+TEST(HistoryPruning, SequenceCursorHasNoUpperBound) {
+    // id из последовательности БД не несут времени: сужать можно только от now.
+    HistoryPruningOptions options;
+    options.enabled = true;
+    const std::int64_t nowUs = k20261019 * 1'000'000;
+    const auto bounds = history_time_bounds(MessageId(48'000'000), nowUs, options);
+    EXPECT_FALSE(bounds.beforeUs.has_value());
+    EXPECT_EQ(bounds.recentFromUs, nowUs - std::int64_t{7} * kDay * 1'000'000);
+}
@@ -0,0 +1,360 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/repository/outbox_message_repository.h"
+
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::domain::message::Message;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Хранилище-заглушка с семантикой ON CONFLICT (id) DO NOTHING: умеет задерживать и падать.
+class FakeStore final : public MessageRepository {
+public:
+    std::int64_t save(const Message&) override {
+        throw std::logic_error("outbox must use save_batch");
+    }
+
+    std::size_t save_batch(const std::vector<Message>& messages) override {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this] { return !blocked; });
+        if (failures > 0) {
+            --failures;
+            throw std::runtime_error("database is down");
+        }
+        for (const auto& m : messages) {
+            if (m.sender_id().value() == unknownSender) {
+                throw MessageRejectedError("violates foreign key constraint messages_sender_id_fkey");
+            }
+        }
+        std::size_t written = 0;
+        for (const auto& m : messages) {
+            written += rows.emplace(m.id().value(), m).second ? 1 : 0;
+        }
+        ++batches;
+        return written;
+    }
+
+    std::vector<Message> find_page(const ConversationId& conversation, std::optional<MessageId> before,
+                                   std::size_t limit) const override {
+        std::lock_guard lock(mutex);
+        std::vector<Message> page;
+        for (auto it = rows.rbegin(); it != rows.rend() && page.size() < limit; ++it) {
+            if (it->second.conversation_id().value() != conversation.value()) continue;
+            if (before && it->first >= before->value()) continue;
+            page.push_back(it->second);
+        }
+        return page;
+    }
+
+    void block() {
+        std::lock_guard lock(mutex);
+        blocked = true;
+    }
+    void release() {
+        std::lock_guard lock(mutex);
+        blocked = false;
+        changed.notify_all();
+    }
+    std::size_t size() const {
+        std::lock_guard lock(mutex);
+        return rows.size();
+    }
+
+    int failures = 0;
+    int batches = 0;
+    std::int64_t unknownSender = 0;
+    // Пачка с сообщением от него отвергается целиком, как COPY при нарушении внешнего ключа.
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    bool blocked = false;
+    std::map<std::int64_t, Message> rows;
+};
+
+class OutboxTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() /
+               ("chatserver_outbox_test_" + std::to_string(::getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(dir_);
+    }
+    void TearDown() override { fs::remove_all(dir_); }
+
+    OutboxOptions options() const {
+        OutboxOptions o;
+        o.directory = dir_.string();
+        o.retryBackoff = std::chrono::milliseconds(5);
+        return o;
+    }
+
+    Message msg(std::int64_t sender, std::int64_t receiver, const std::string& text) {
+        return Message(ids_.next(), UserId(sender), UserId(receiver), MessageText(text),
+                       Timestamp::from_micros(1700000000000000 + sender));
+    }
+
+    fs::path dir_;
+    MessageIdGenerator ids_{1};
+};
+
+}
+
+TEST_F(OutboxTest, AcknowledgesBeforeStoreAndServesUndrainedReads) {
+    auto store = std::make_shared<FakeStore>();
+    store->block();
+    OutboxMessageRepository outbox(store, options());
+
+    const auto a = msg(1, 2, "first");
+    const auto b = msg(2, 1, "second");
+    EXPECT_EQ(outbox.save(a), a.id().value());
+    EXPECT_EQ(outbox.save(b), b.id().value());
+    EXPECT_EQ(store->size(), 0u);
+
+    // Отправитель сразу видит свои сообщения, хотя в хранилище их ещё нет.
+    auto page = outbox.find_page(a.conversation_id(), std::nullopt, 10);
+    ASSERT_EQ(page.size(), 2u);
+    EXPECT_EQ(page[0].text().value(), "second");
+    EXPECT_EQ(page[0].created_at(), b.created_at());
+    EXPECT_EQ(outbox.find_page(a.conversation_id(), b.id(), 10).size(), 1u);
+    EXPECT_EQ(outbox.stats().pending, 2u);
+
+    store->release();
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 2u);
+    EXPECT_EQ(outbox.find_page(a.conversation_id(), std::nullopt, 10).size(), 2u);
+
+    const auto s = outbox.stats();
+    EXPECT_EQ(s.appended, 2u);
+    EXPECT_EQ(s.drained, 2u);
+    EXPECT_EQ(s.pending, 0u);
+    EXPECT_GE(s.fsyncs, 1u);
+}
+
+TEST_F(OutboxTest, RequiresAssignedId) {
+    OutboxMessageRepository outbox(std::make_shared<FakeStore>(), options());
+    EXPECT_THROW(outbox.save(Message(UserId(1), UserId(2), MessageText("x"), Timestamp(1))),
+                 std::invalid_argument);
+}
+
+TEST_F(OutboxTest, RetriesAfterStoreFailure) {
+    auto store = std::make_shared<FakeStore>();
+    store->failures = 3;
+    OutboxMessageRepository outbox(store, options());
+    outbox.save(msg(1, 2, "survives outages"));
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 1u);
+    EXPECT_EQ(outbox.stats().failures, 3u);
+}
+
+TEST_F(OutboxTest, RejectedMessagesAreSetAsideAndDrainContinues) {
+    auto store = std::make_shared<FakeStore>();
+    store->unknownSender = 99;
+    store->block();
+    {
+        OutboxMessageRepository outbox(store, options());
+        for (int i = 0; i < 8; ++i) outbox.save(msg(i == 2 || i == 5 ? 99 : 1, 2, "m" + std::to_string(i)));
+        store->release();
+        ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+        EXPECT_EQ(store->size(), 6u);
+
+        const auto s = outbox.stats();
+        EXPECT_EQ(s.drained, 6u);
+        EXPECT_EQ(s.rejected, 2u);
+        EXPECT_EQ(s.pending, 0u);
+        EXPECT_EQ(s.failures, 0u);
+        EXPECT_EQ(s.duplicates, 0u);
+        // Отвергнутые больше не видны в истории: хранилище их не примет.
+        EXPECT_EQ(outbox.find_page(ConversationId::between(UserId(99), UserId(2)), std::nullopt, 10).size(), 0u);
+    }
+    ASSERT_TRUE(fs::exists(dir_ / "rejected"));
+    EXPECT_GT(fs::file_size(dir_ / "rejected"), 0u);
+
+    // После рестарта отвергнутые не повторяются.
+    OutboxMessageRepository outbox(store, options());
+    EXPECT_EQ(outbox.stats().replayed, 0u);
+}
+
+TEST_F(OutboxTest, PartialWriteIsNotSealedIntoSegment) {
+    auto down = std::make_shared<FakeStore>();
+    down->block();
+    auto o = options();
+    o.maxSegmentBytes = 80;
+    std::vector<std::int64_t> saved;
+    {
+        OutboxMessageRepository outbox(down, o);
+        saved.push_back(outbox.save(msg(1, 2, "a")));
+
+        // Запись длинного сообщения (в новый сегмент) обрывается на 300-м байте,
+        // как при ENOSPC: RLIMIT_FSIZE даёт короткий pwrite, затем EFBIG.
+        struct rlimit old{};
+        ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &old), 0);
+        const auto oldHandler = std::signal(SIGXFSZ, SIG_IGN);
+        struct rlimit limited = old;
+        limited.rlim_cur = 300;
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+        EXPECT_THROW(outbox.save(msg(1, 2, std::string(500, 'x'))), std::system_error);
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &old), 0);
+        std::signal(SIGXFSZ, oldHandler);
+
+        // Короткое ложится в тот же сегмент, следующее его запечатывает.
+        saved.push_back(outbox.save(msg(1, 2, "c")));
+        saved.push_back(outbox.save(msg(1, 2, "d")));
+        down->failures = 1000;
+        down->release();
+    }
+
+    auto store = std::make_shared<FakeStore>();
+    OutboxMessageRepository outbox(store, o);
+    EXPECT_EQ(outbox.stats().replayed, 3u);
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    const auto page = store->find_page(ConversationId::between(UserId(1), UserId(2)), std::nullopt, 10);
+    ASSERT_EQ(page.size(), 3u);
+    EXPECT_EQ(page[0].id().value(), saved[2]);
+    EXPECT_EQ(page[2].id().value(), saved[0]);
+}
+
+TEST_F(OutboxTest, ReplaysUndrainedMessagesAfterRestart) {
+    std::vector<std::int64_t> saved;
+    {
+        auto down = std::make_shared<FakeStore>();
+        down->block();
+        OutboxMessageRepository outbox(down, options());
+        for (int i = 0; i < 5; ++i) saved.push_back(outbox.save(msg(1, 2, "m" + std::to_string(i))));
+        // Хранилище так и не ответило: процесс останавливается с полным outbox.
+        down->failures = 1000;
+        down->release();
+    }
+
+    auto store = std::make_shared<FakeStore>();
+    OutboxMessageRepository outbox(store, options());
+    EXPECT_EQ(outbox.stats().replayed, 5u);
+    EXPECT_EQ(outbox.max_replayed_id(), saved.back());
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 5u);
+    const auto page = store->find_page(ConversationId::between(UserId(1), UserId(2)), std::nullopt, 10);
+    ASSERT_EQ(page.size(), 5u);
+    EXPECT_EQ(page.front().text().value(), "m4");
+}
+
+TEST_F(OutboxTest, LostDrainMarkDoesNotDuplicate) {
+    auto store = std::make_shared<FakeStore>();
+    {
+        OutboxMessageRepository outbox(store, options());
+        for (int i = 0; i < 4; ++i) outbox.save(msg(1, 2, "once"));
+        ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    }
+    // Падение между коммитом в хранилище и записью отметки: отметки нет.
+    fs::remove(dir_ / "drained");
+
+    OutboxMessageRepository outbox(store, options());
+    EXPECT_EQ(outbox.stats().replayed, 4u);
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 4u);
+    EXPECT_EQ(outbox.stats().duplicates, 4u);
+}
+
+TEST_F(OutboxTest, TornTailIsDroppedOnReplay) {
+    auto down = std::make_shared<FakeStore>();
+    down->failures = 1000;
+    {
+        OutboxMessageRepository outbox(down, options());
+        outbox.save(msg(1, 2, "complete"));
+    }
+    fs::path segment;
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        if (entry.path().extension() == ".outbox" && fs::file_size(entry.path()) > 0) segment = entry.path();
+    }
+    ASSERT_FALSE(segment.empty());
+    const auto sizeBefore = fs::file_size(segment);
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        const char garbage[] = {0x30, 0x00, 0x00, 0x00, 0x01, 0x02};
+        out.write(garbage, sizeof(garbage));
+    }
+
+    auto store = std::make_shared<FakeStore>();
+    OutboxMessageRepository outbox(store, options());
+    EXPECT_EQ(outbox.stats().replayed, 1u);
+    EXPECT_EQ(fs::file_size(segment), sizeBefore);
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 1u);
+}
+
+TEST_F(OutboxTest, DrainedSegmentsAreRemoved) {
+    auto store = std::make_shared<FakeStore>();
+    auto o = options();
+    o.maxSegmentBytes = 256;
+    o.batchSize = 4;
+    OutboxMessageRepository outbox(store, o);
+    for (int i = 0; i < 40; ++i) outbox.save(msg(1, 2, "segment filler " + std::to_string(i)));
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 40u);
+
+    std::size_t files = 0;
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        files += entry.path().extension() == ".outbox" ? 1 : 0;
+    }
+    // Остаются только сегмент последней слитой записи и активный.
+    EXPECT_LE(files, 2u);
+    EXPECT_EQ(outbox.stats().segments, files);
+}
+
+TEST_F(OutboxTest, FullOutboxMakesSendersWait) {
+    auto store = std::make_shared<FakeStore>();
+    store->block();
+    auto o = options();
+    o.maxPending = 2;
+    OutboxMessageRepository outbox(store, o);
+    outbox.save(msg(1, 2, "a"));
+    outbox.save(msg(1, 2, "b"));
+
+    std::atomic<bool> done{false};
+    std::thread third([&] {
+        outbox.save(msg(1, 2, "c"));
+        done = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(done);
+    store->release();
+    third.join();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(outbox.stats().throttled, 1u);
+    ASSERT_TRUE(outbox.flush(std::chrono::seconds(5)));
+    EXPECT_EQ(store->size(), 3u);
+}
+
+TEST_F(OutboxTest, GeneratorAdvancesPastReplayedIds) {
+    std::int64_t now = MessageIdGenerator::kEpochMs + 1000;
+    MessageIdGenerator before(1, [&now] { return now; });
+    MessageId last(0);
+    // Переполнение последовательности: id ушли на 2 мс вперёд часов.
+    for (int i = 0; i < 3 * (1 << MessageIdGenerator::kSequenceBits); ++i) last = before.next();
+
+    MessageIdGenerator after(1, [&now] { return now; });
+    after.advance_past(last);
+    EXPECT_GT(after.next().value(), last.value());
+    after.advance_past(MessageId(1));  // назад не двигает
+    EXPECT_GT(after.next().value(), last.value());
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/http/resources/admin_resource.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/nlohmann/json.hpp"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using json          = nlohmann::json;
+
+using namespace chatserver::infrastructure;
+using chatserver::test::TestServer;
+using chatserver::test::wait_until;
+
+namespace {
+
+struct CountingConnection : realtime::RealtimeConnection {
+    int frames = 0;
+    void send(std::shared_ptr<const std::string>) override { ++frames; }
+};
+
+// Как WebSocket-сессия: уничтожаясь, сама удаляет себя из реестра.
+struct SelfRemovingConnection : realtime::RealtimeConnection {
+    SelfRemovingConnection(realtime::ConnectionRegistry& registry, std::int64_t userId)
+        : registry(registry), userId(userId) {}
+    ~SelfRemovingConnection() override { registry.remove(userId, this); }
+    void send(std::shared_ptr<const std::string>) override {}
+    realtime::ConnectionRegistry& registry;
+    std::int64_t userId;
+};
+
+}
+
+TEST(PresenceRegistry, InlineAndOverflowConnections) {
+    realtime::ConnectionRegistry registry;
+    std::vector<std::shared_ptr<CountingConnection>> devices;
+    for (int i = 0; i < 5; ++i) {
+        devices.push_back(std::make_shared<CountingConnection>());
+        ASSERT_TRUE(registry.add(42, devices.back()));
+    }
+    EXPECT_EQ(registry.connections_of(42), 5u);
+    auto frame = std::make_shared<const std::string>("x");
+    EXPECT_EQ(registry.send_to_user(42, frame), 5u);
+    for (const auto& d : devices) EXPECT_EQ(d->frames, 1);
+
+    // Удаление из середины inline-части и из overflow
+    registry.remove(42, devices[0].get());
+    registry.remove(42, devices[3].get());
+    registry.remove(42, devices[4].get());
+    EXPECT_EQ(registry.connections_of(42), 2u);
+    EXPECT_EQ(registry.send_to_user(42, frame), 2u);
+    EXPECT_EQ(devices[1]->frames, 2);
+    EXPECT_EQ(devices[2]->frames, 2);
+    EXPECT_EQ(devices[0]->frames, 1);
+
+    registry.remove(42, devices[1].get());
+    registry.remove(42, devices[2].get());
+    EXPECT_FALSE(registry.is_online(42));
+    EXPECT_EQ(registry.connection_count(), 0u);
+    EXPECT_EQ(registry.online_users(), 0u);
+}
+
+TEST(PresenceRegistry, TransitionsAndPerUserLimit) {
+    realtime::ConnectionRegistryOptions options;
+    options.shards = 3;  // округляется до 4
+    options.maxConnectionsPerUser = 2;
+    realtime::ConnectionRegistry registry(options);
+    std::vector<std::pair<std::int64_t, bool>> events;
+    registry.set_presence_listener([&](std::int64_t user, bool online) { events.emplace_back(user, online); });
+
+    auto a = std::make_shared<CountingConnection>();
+    auto b = std::make_shared<CountingConnection>();
+    auto c = std::make_shared<CountingConnection>();
+    EXPECT_TRUE(registry.add(7, a));
+    EXPECT_TRUE(registry.add(7, b));
+    EXPECT_FALSE(registry.add(7, c));
+    registry.remove(7, a.get());
+    registry.remove(7, b.get());
+    EXPECT_TRUE(registry.add(7, c));
+    registry.remove(7, c.get());
+
+    EXPECT_EQ(events, (std::vector<std::pair<std::int64_t, bool>>{{7, true}, {7, false}, {7, true}, {7, false}}));
+    auto stats = registry.stats();
+    EXPECT_EQ(stats.shards, 4u);
+    EXPECT_EQ(stats.wentOnline, 2u);
+    EXPECT_EQ(stats.wentOffline, 2u);
+    EXPECT_EQ(stats.rejected, 1u);
+
+    // Истёкшие соединения не занимают лимит
+    auto d = std::make_shared<CountingConnection>();
+    auto e = std::make_shared<CountingConnection>();
+    EXPECT_TRUE(registry.add(8, d));
+    EXPECT_TRUE(registry.add(8, e));
+    d.reset();
+    EXPECT_TRUE(registry.add(8, c));
+    EXPECT_EQ(registry.connections_of(8), 2u);
+}
+
+TEST(PresenceRegistry, ConcurrentChurnLeavesNothingBehind) {
+    realtime::ConnectionRegistry registry;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&registry, t] {
+            auto connection = std::make_shared<CountingConnection>();
+            auto frame = std::make_shared<const std::string>("x");
+            for (int i = 0; i < 20000; ++i) {
+                const std::int64_t user = (i * 7 + t) % 1000 + 1;
+                registry.add(user, connection);
+                registry.send_to_user(user, frame);
+                registry.remove(user, connection.get());
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(registry.online_users(), 0u);
+    EXPECT_EQ(registry.connection_count(), 0u);
+    EXPECT_EQ(registry.stats().wentOnline, registry.stats().wentOffline);
+}
+
+TEST(PresenceRegistry, LastReferenceDroppedDuringRemoveDoesNotDeadlock) {
+    // Владелец отпускает соединение, пока remove() другого соединения того же
+    // пользователя держит его weak_ptr продвинутым: деструктор не должен звать
+    // remove() под мьютексом шарда.
+    realtime::ConnectionRegistry registry;
+    std::atomic<bool> stop{false};
+    auto done = std::async(std::launch::async, [&registry, &stop] {
+        std::thread owner([&registry, &stop] {
+            while (!stop.load()) {
+                std::vector<std::shared_ptr<SelfRemovingConnection>> owned;
+                for (int i = 0; i < 4; ++i) {
+                    owned.push_back(std::make_shared<SelfRemovingConnection>(registry, 1));
+                    registry.add(1, owned.back());
+                }
+            }
+        });
+        auto other = std::make_shared<CountingConnection>();
+        for (int i = 0; i < 200000; ++i) {
+            registry.add(1, other);
+            registry.remove(1, other.get());
+        }
+        stop = true;
+        owner.join();
+    });
+    ASSERT_EQ(done.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+    EXPECT_EQ(registry.connection_count(), 0u);
+    EXPECT_FALSE(registry.is_online(1));
+}
+
+TEST(PresenceRegistry, AdminRouteReportsCounts) {
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    auto a = std::make_shared<CountingConnection>();
+    auto b = std::make_shared<CountingConnection>();
+    registry->add(1, a);
+    registry->add(1, b);
+    registry->add(2, a);
+
+    http::HttpRouter router;
+    http::resources::AdminResource admin(registry);
+    admin.register_routes(router);
+
+    http::HttpRequest req;
+    req.method = "GET";
+    req.target = "/admin/presence";
+    auto all = json::parse(router.route(req).body);
+    EXPECT_EQ(all["online_users"], 2);
+    EXPECT_EQ(all["connections"], 3);
+
+    req.target = "/admin/presence?user=1";
+    auto one = json::parse(router.route(req).body);
+    EXPECT_EQ(one["online"], true);
+    EXPECT_EQ(one["connections"], 2);
+
+    req.target = "/admin/presence?user=abc";
+    EXPECT_EQ(router.route(req).status_code, 400);
+}
+
+TEST(PresenceRegistry, ServerClosesConnectionsOverLimit) {
+    realtime::ConnectionRegistryOptions options;
+    options.maxConnectionsPerUser = 1;
+    auto registry = std::make_shared<realtime::ConnectionRegistry>(options);
+    TestServer srv(std::make_shared<http::HttpRouter>(), {}, registry);
+
+    auto first = srv.connect_ws("/ws?user=5");
+    ASSERT_TRUE(wait_until([&] { return registry->is_online(5); }));
+
+    auto second = srv.connect_ws("/ws?user=5");
+    beast::flat_buffer buffer;
+    beast::error_code ec;
+    second->read(buffer, ec);
+    EXPECT_EQ(ec, websocket::error::closed);
+    EXPECT_EQ(second->reason().code, websocket::close_code::policy_error);
+    EXPECT_EQ(registry->connections_of(5), 1u);
+
+    // Отключение первого соединения переводит пользователя в офлайн
+    first->next_layer().close();
+    EXPECT_TRUE(wait_until([&] { return !registry->is_online(5); }));
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chatserver/infrastructure/repository/pg_replica_router.h"
+
+using namespace chatserver::infrastructure::repository;
+using namespace std::chrono_literals;
+using Clock = ReplicaSelector::Clock;
+
+namespace {
+
+ReplicaOptions options(ReplicaPolicy policy = ReplicaPolicy::RoundRobin) {
+    ReplicaOptions o;
+    o.policy = policy;
+    o.maxLag = 500ms;
+    o.readYourWrites = 2s;
+    return o;
+}
+
+// Реплики с замеренным отставанием lags[i] (nullopt — замер не удался).
+std::unique_ptr<ReplicaSelector> selector(const std::vector<std::optional<std::chrono::milliseconds>>& lags,
+                                          ReplicaOptions o = options()) {
+    auto s = std::make_unique<ReplicaSelector>(lags.size(), o);
+    for (std::size_t i = 0; i < lags.size(); ++i) s->report_lag(i, lags[i]);
+    return s;
+}
+
+// Порт 1 на localhost закрыт: подключение сразу отклоняется.
+const std::string kUnreachable = "postgresql://chat@127.0.0.1:1/chat?connect_timeout=1";
+
+}
+
+TEST(ReplicaSelectorTest, ParsesPolicy) {
+    EXPECT_EQ(parse_replica_policy("round_robin"), ReplicaPolicy::RoundRobin);
+    EXPECT_EQ(parse_replica_policy("least_loaded"), ReplicaPolicy::LeastLoaded);
+    EXPECT_THROW(parse_replica_policy("random"), std::invalid_argument);
+}
+
+TEST(ReplicaSelectorTest, RoundRobinCyclesOverFreshReplicas) {
+    auto s = selector({10ms, 0ms, 20ms});
+    const auto now = Clock::now();
+    std::vector<std::size_t> picks;
+    for (int i = 0; i < 6; ++i) picks.push_back(s->pick(0, now, {}).value());
+    EXPECT_EQ(picks, (std::vector<std::size_t>{0, 1, 2, 0, 1, 2}));
+    const auto stats = s->stats();
+    EXPECT_EQ(stats.primaryReads, 0u);
+    for (const auto& r : stats.replicas) EXPECT_EQ(r.reads, 2u);
+}
+
+TEST(ReplicaSelectorTest, SkipsLaggingAndFailedReplicas) {
+    auto s = selector({900ms, 100ms, std::nullopt});
+    const auto now = Clock::now();
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(s->pick(0, now, {}), std::optional<std::size_t>(1));
+
+    // Единственная подходящая реплика перестала отвечать — чтения уходят в primary.
+    s->report_failure(1);
+    EXPECT_EQ(s->pick(0, now, {}), std::nullopt);
+    auto stats = s->stats();
+    EXPECT_EQ(stats.lagFallbacks, 1u);
+    EXPECT_EQ(stats.primaryReads, 1u);
+    EXPECT_FALSE(stats.replicas[0].usable);
+    EXPECT_EQ(stats.replicas[0].lagMs, 900);
+    EXPECT_FALSE(stats.replicas[2].lagMs.has_value());
+
+    // Следующий замер возвращает реплики, догнавшие primary.
+    s->report_lag(0, 50ms);
+    s->report_lag(1, 50ms);
+    EXPECT_TRUE(s->pick(0, now, {}).has_value());
+}
+
+TEST(ReplicaSelectorTest, UnprobedReplicasGetNoReads) {
+    ReplicaSelector s(2, options());
+    EXPECT_EQ(s.pick(0, Clock::now(), {}), std::nullopt);
+    EXPECT_EQ(s.stats().lagFallbacks, 1u);
+}
+
+TEST(ReplicaSelectorTest, LeastLoadedPrefersIdleReplica) {
+    auto s = selector({0ms, 0ms, 0ms, 900ms}, options(ReplicaPolicy::LeastLoaded));
+    const auto now = Clock::now();
+    EXPECT_EQ(s->pick(0, now, {5, 1, 3, 0}), std::optional<std::size_t>(1));
+    EXPECT_EQ(s->pick(0, now, {5, 4, 3, 0}), std::optional<std::size_t>(2));
+    // Равная нагрузка — по очереди.
+    EXPECT_EQ(s->pick(0, now, {2, 2, 2, 0}), std::optional<std::size_t>(0));
+    EXPECT_EQ(s->pick(0, now, {2, 2, 2, 0}), std::optional<std::size_t>(1));
+}
+
+TEST(ReplicaSelectorTest, ReadsOwnWritesFromPrimaryWithinWindow) {
+    auto s = selector({0ms, 0ms});
+    const auto t0 = Clock::now();
+    const auto alice = replica_key("alice");
+    s->note_write(alice, t0);
+
+    EXPECT_EQ(s->pick(alice, t0 + 1s, {}), std::nullopt);
+    EXPECT_TRUE(s->pick(replica_key("bob"), t0 + 1s, {}).has_value());
+    EXPECT_TRUE(s->pick(0, t0 + 1s, {}).has_value());
+    auto stats = s->stats();
+    EXPECT_EQ(stats.stickyReads, 1u);
+    EXPECT_EQ(stats.stickyKeys, 1u);
+
+    // Окно прошло — снова реплика, запись о ключе забыта.
+    EXPECT_TRUE(s->pick(alice, t0 + 3s, {}).has_value());
+    EXPECT_EQ(s->stats().stickyKeys, 0u);
+}
+
+TEST(ReplicaSelectorTest, ExpiredStickyKeysAreSwept) {
+    auto s = selector({0ms});
+    const auto t0 = Clock::now();
+    for (std::uint64_t key = 1; key <= 1000; ++key) s->note_write(key, t0);
+    for (std::uint64_t key = 1001; key <= 1100; ++key) s->note_write(key, t0 + 10s);
+    EXPECT_LT(s->stats().stickyKeys, 1100u);
+    EXPECT_EQ(s->pick(1100, t0 + 11s, {}), std::nullopt);
+}
+
+TEST(ReplicaSelectorTest, WithoutReplicasEverythingGoesToPrimary) {
+    ReplicaSelector s(0, options());
+    s.note_write(7, Clock::now());
+    EXPECT_EQ(s.pick(7, Clock::now(), {}), std::nullopt);
+    const auto stats = s.stats();
+    EXPECT_EQ(stats.primaryReads, 1u);
+    EXPECT_EQ(stats.stickyKeys, 0u);
+}
+
+TEST(PgReplicaRouterTest, UnreachableReplicaIsExcludedAndReadsFallBackToPrimary) {
+    auto o = options();
+    o.lagCheckInterval = 1h;
+    o.pool.acquireTimeout = 100ms;
+    PgReplicaRouter router(std::make_shared<PgConnectionPool>(kUnreachable, o.pool),
+                           {std::make_shared<PgConnectionPool>(kUnreachable, o.pool)}, o);
+    auto stats = router.stats();
+    ASSERT_EQ(stats.replicas.size(), 1u);
+    EXPECT_FALSE(stats.replicas[0].usable);
+    EXPECT_EQ(stats.replicas[0].failures, 1u);
+
+    // Primary тоже недоступен: чтение — ошибка подключения к primary, а не к реплике.
+    EXPECT_THROW(router.read(replica_key("alice")), std::exception);
+    EXPECT_EQ(router.stats().lagFallbacks, 1u);
+    EXPECT_EQ(router.primary_stats().leased, 0u);
+    router.stop();
+}
+
+TEST(PgReplicaRouterTest, RepeatedProbeFailuresAreLoggedOnce) {
+    auto o = options();
+    o.lagCheckInterval = 1h;
+    o.pool.acquireTimeout = 100ms;
+    PgReplicaRouter router(std::make_shared<PgConnectionPool>(kUnreachable, o.pool),
+                           {std::make_shared<PgConnectionPool>(kUnreachable, o.pool)}, o);
+
+    // Журнал роутера — только о переходе в непригодность (первый замер, в конструкторе);
+    // повторные неудачи копятся в failures.
+    std::ostringstream log;
+    auto* saved = std::cerr.rdbuf(log.rdbuf());
+    for (int i = 0; i < 3; ++i) router.probe_once();
+    std::cerr.rdbuf(saved);
+
+    EXPECT_EQ(log.str().find("[PgReplicaRouter]"), std::string::npos) << log.str();
+    EXPECT_EQ(router.stats().replicas[0].failures, 4u);
+    router.stop();
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "chatserver/bootstrap/bootstrap.h"
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "test_support.h"
+
+using namespace chatserver::infrastructure;
+using namespace std::chrono_literals;
+using concurrency::DeadlineExceeded;
+using concurrency::RequestDeadline;
+
+namespace {
+
+struct Server {
+    Server() : web(routes(fastCalls), single_worker(), nullptr) {}
+
+    static std::shared_ptr<http::HttpRouter> routes(std::atomic<int>& fastCalls) {
+        auto router = std::make_shared<http::HttpRouter>();
+        router->add_route("GET", "/slow", [](const http::HttpRequest&) {
+            // Как репозиторий: долгая работа, затем проверка срока.
+            std::this_thread::sleep_for(300ms);
+            RequestDeadline::check();
+            return http::HttpResponse{200, "{}"};
+        });
+        router->add_route("GET", "/swallow", [](const http::HttpRequest&) {
+            // Обработчик превратил ошибку срока в свой ответ — клиент всё равно получает 504.
+            std::this_thread::sleep_for(300ms);
+            try {
+                RequestDeadline::check();
+            } catch (const DeadlineExceeded&) {
+                return http::HttpResponse{404, R"({"error":"not found"})"};
+            }
+            return http::HttpResponse{200, "{}"};
+        });
+        router->add_route("GET", "/fast", [&fastCalls](const http::HttpRequest&) {
+            ++fastCalls;
+            return http::HttpResponse{200, "{}"};
+        });
+        router->add_route("GET", "/block", [](const http::HttpRequest&) {
+            // Без срока: занимает единственный воркер.
+            std::this_thread::sleep_for(300ms);
+            return http::HttpResponse{200, "{}"};
+        });
+        return router;
+    }
+
+    static http::HttpServerOptions single_worker() {
+        http::HttpServerOptions options;
+        options.workerThreads = 1;
+        options.requestDeadline = 0ms;
+        options.routeDeadlines = {{"/slow", 100ms}, {"/swallow", 100ms}, {"/fast", 100ms}};
+        return options;
+    }
+
+    std::atomic<int> fastCalls{0};
+    chatserver::test::TestServer web;
+};
+
+}
+
+TEST(RequestDeadlineTest, NoDeadlineOutsideScope) {
+    EXPECT_FALSE(RequestDeadline::current().has_value());
+    EXPECT_FALSE(RequestDeadline::remaining().has_value());
+    EXPECT_NO_THROW(RequestDeadline::check());
+    RequestDeadline::mark_exceeded();
+    EXPECT_FALSE(RequestDeadline::current().has_value());
+}
+
+TEST(RequestDeadlineTest, NestedScopeKeepsEarlierDeadline) {
+    const auto before = RequestDeadline::stats();
+    const auto outerDeadline = RequestDeadline::Clock::now() + 1s;
+    {
+        RequestDeadline::Scope outer(outerDeadline);
+        {
+            RequestDeadline::Scope inner(outerDeadline + 1h);
+            EXPECT_EQ(RequestDeadline::current(), outerDeadline);
+            EXPECT_LE(*RequestDeadline::remaining(), 1000ms);
+            EXPECT_GT(*RequestDeadline::remaining(), 0ms);
+        }
+        EXPECT_FALSE(outer.exceeded());
+        {
+            RequestDeadline::Scope inner(RequestDeadline::Clock::now() - 1ms);
+            EXPECT_EQ(*RequestDeadline::remaining(), 0ms);
+            EXPECT_THROW(RequestDeadline::check(), DeadlineExceeded);
+            EXPECT_TRUE(inner.exceeded());
+        }
+        // Превышение вложенного срока — превышение запроса целиком.
+        EXPECT_TRUE(outer.exceeded());
+        EXPECT_EQ(RequestDeadline::current(), outerDeadline);
+    }
+    EXPECT_FALSE(RequestDeadline::current().has_value());
+    const auto after = RequestDeadline::stats();
+    EXPECT_EQ(after.requests - before.requests, 1u);
+    EXPECT_EQ(after.exceeded - before.exceeded, 1u);
+}
+
+TEST(RequestDeadlineTest, ParsesRouteDeadlines) {
+    const auto budgets = chatserver::bootstrap::parse_route_deadlines("/send_message:2000,/messages:0,");
+    ASSERT_EQ(budgets.size(), 2u);
+    EXPECT_EQ(budgets.at("/send_message"), 2000ms);
+    EXPECT_EQ(budgets.at("/messages"), 0ms);
+    EXPECT_TRUE(chatserver::bootstrap::parse_route_deadlines("").empty());
+    EXPECT_THROW(chatserver::bootstrap::parse_route_deadlines("/send_message"), std::invalid_argument);
+    EXPECT_THROW(chatserver::bootstrap::parse_route_deadlines("send_message:10"), std::invalid_argument);
+    EXPECT_THROW(chatserver::bootstrap::parse_route_deadlines("/messages:10ms"), std::invalid_argument);
+}
+
+TEST(RequestDeadlineTest, SlowHandlerGets504AndConnectionStaysUsable) {
+    Server s;
+    EXPECT_EQ(s.web.get("/slow").result_int(), 504);
+    EXPECT_EQ(s.web.get("/swallow").result_int(), 504);
+    EXPECT_EQ(s.web.get("/fast").result_int(), 200);
+    EXPECT_EQ(s.web.get("/block").result_int(), 200);
+}
+
+TEST(RequestDeadlineTest, RequestQueuedPastDeadlineIsNotHandled) {
+    Server s;
+    auto blocking = std::async(std::launch::async, [&s] { return s.web.get("/block").result_int(); });
+    std::this_thread::sleep_for(50ms);
+    // Единственный воркер занят ещё ~250 мс, а бюджет /fast — 100 мс.
+    const auto res = s.web.get("/fast");
+    EXPECT_EQ(res.result_int(), 504);
+    EXPECT_EQ(res.body(), R"({"error":"deadline exceeded"})");
+    EXPECT_EQ(s.fastCalls.load(), 0);
+    EXPECT_EQ(blocking.get(), 200);
+}
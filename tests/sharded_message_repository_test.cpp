@@ -0,0 +1,431 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/concurrency/request_deadline.h"
+#include "chatserver/infrastructure/repository/in_memory_shard_repository.h"
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/sharding/hash_ring.h"
+
+using namespace chatserver::infrastructure::sharding;
+using namespace chatserver::infrastructure::repository;
+using namespace chatserver::domain;
+using chatserver::infrastructure::concurrency::DeadlineExceeded;
+using chatserver::infrastructure::concurrency::RequestDeadline;
+
+namespace {
+
+std::vector<ShardSpec> specs(const std::string& list) {
+    return parse_shard_specs(list, 64);
+}
+
+message::Message direct(std::int64_t id, std::int64_t sender, std::int64_t receiver) {
+    return message::Message(MessageId(id), UserId(sender), UserId(receiver), MessageText("m" + std::to_string(id)),
+                            Timestamp(1700000000));
+}
+
+message::Message to_group(std::int64_t id, std::int64_t sender, std::int64_t group) {
+    return message::Message(MessageId(id), UserId(sender), GroupId(group), MessageText("g" + std::to_string(id)),
+                            Timestamp(1700000000));
+}
+
+std::vector<std::int64_t> ids(const std::vector<message::Message>& page) {
+    std::vector<std::int64_t> out;
+    for (const auto& m : page) out.push_back(m.id().value());
+    return out;
+}
+
+// Шарда, которая проверяет срок запроса, как PgQueryDeadline, и запоминает, какой видела.
+class DeadlineShard final : public MessageRepository {
+public:
+    std::int64_t save(const message::Message& message) override { return store.save(message); }
+
+    std::vector<message::Message> find_page(const ConversationId& conversation, std::optional<MessageId> before,
+                                            std::size_t limit) const override {
+        {
+            std::lock_guard lock(mutex);
+            seen = RequestDeadline::current();
+        }
+        RequestDeadline::check();
+        return store.find_page(conversation, before, limit);
+    }
+
+    InMemoryShardRepository store;
+    mutable std::mutex mutex;
+    mutable std::optional<RequestDeadline::Clock::time_point> seen;
+};
+
+// Шарда, которая запоминает потоки, читавшие с неё.
+class ThreadShard final : public MessageRepository {
+public:
+    std::int64_t save(const message::Message& message) override { return store.save(message); }
+
+    std::vector<message::Message> find_page(const ConversationId& conversation, std::optional<MessageId> before,
+                                            std::size_t limit) const override {
+        {
+            std::lock_guard lock(mutex);
+            readers.insert(std::this_thread::get_id());
+        }
+        return store.find_page(conversation, before, limit);
+    }
+
+    InMemoryShardRepository store;
+    mutable std::mutex mutex;
+    mutable std::set<std::thread::id> readers;
+};
+
+struct Cluster {
+    std::vector<std::shared_ptr<InMemoryShardRepository>> shards;
+    std::shared_ptr<ShardedMessageRepository> repo;
+
+    Cluster(HashRing ring, ShardKey key = ShardKey::Conversation) {
+        std::vector<std::shared_ptr<MessageRepository>> base;
+        for (std::size_t i = 0; i < ring.shards().size(); ++i) {
+            shards.push_back(std::make_shared<InMemoryShardRepository>());
+            base.push_back(shards.back());
+        }
+        repo = std::make_shared<ShardedMessageRepository>(std::move(ring), std::move(base), key);
+    }
+};
+
+}
+
+TEST(HashRingTest, ParsesSpecsAndRejectsBadInput) {
+    const auto list = specs("a, b:32 ,c");
+    ASSERT_EQ(list.size(), 3u);
+    EXPECT_EQ(list[1].name, "b");
+    EXPECT_EQ(list[1].vnodes, 32);
+    EXPECT_EQ(list[2].vnodes, 64);
+    EXPECT_THROW(specs("a,a"), std::invalid_argument);
+    EXPECT_THROW(specs("a,:3"), std::invalid_argument);
+    EXPECT_THROW(specs("a:x"), std::invalid_argument);
+    EXPECT_THROW(HashRing(specs("a:0")), std::invalid_argument);
+}
+
+TEST(HashRingTest, MovesRoundTripThroughText) {
+    const std::vector<ShardMove> moves{
+        {HashRange{0x10, 0xff}, "b", true},
+        {HashRange{0x1000, 0xffffffffffffffffULL}, "a", false},
+    };
+    const auto parsed = parse_shard_moves(format_shard_moves(moves));
+    ASSERT_EQ(parsed.size(), 2u);
+    EXPECT_EQ(parsed[0].range.first, 0x10u);
+    EXPECT_EQ(parsed[0].target, "b");
+    EXPECT_TRUE(parsed[0].migrating);
+    EXPECT_EQ(parsed[1].range.last, 0xffffffffffffffffULL);
+    EXPECT_FALSE(parsed[1].migrating);
+
+    EXPECT_THROW(HashRing(specs("a,b"), {{HashRange{0, 10}, "c", false}}), std::invalid_argument);
+    EXPECT_THROW(HashRing(specs("a,b"), {{HashRange{0, 10}, "a", false}, {HashRange{5, 20}, "b", false}}),
+                 std::invalid_argument);
+}
+
+TEST(HashRingTest, OwnershipDependsOnNamesNotOrderAndIsBalanced) {
+    const HashRing ring(specs("a,b,c,d"));
+    const HashRing reordered(specs("d,b,a,c"));
+    for (std::int64_t key = 1; key <= 1000; ++key) {
+        const auto h = shard_hash(key);
+        EXPECT_EQ(ring.shards()[ring.owner(h)].name, reordered.shards()[reordered.owner(h)].name);
+    }
+
+    std::vector<int> counts(4, 0);
+    for (std::int64_t key = 1; key <= 40000; ++key) ++counts[ring.owner(shard_hash(key))];
+    const auto share = ring.ownership();
+    double total = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        total += share[i];
+        // 64 vnodes: доля каждой шарды в пределах ±40% от равной.
+        EXPECT_GT(counts[i], 6000) << ring.shards()[i].name;
+        EXPECT_LT(counts[i], 14000) << ring.shards()[i].name;
+    }
+    EXPECT_NEAR(total, 1.0, 1e-9);
+}
+
+TEST(HashRingTest, AddingShardMovesAboutOneNthOfKeysOnlyToIt) {
+    const HashRing before(specs("a,b,c"));
+    const HashRing after(specs("a,b,c,d"));
+    int moved = 0;
+    const int keys = 40000;
+    for (std::int64_t key = 1; key <= keys; ++key) {
+        const auto h = shard_hash(key);
+        const auto& was = before.shards()[before.owner(h)].name;
+        const auto& now = after.shards()[after.owner(h)].name;
+        if (was != now) {
+            EXPECT_EQ(now, "d");
+            ++moved;
+        }
+    }
+    EXPECT_GT(moved, keys / 8);
+    EXPECT_LT(moved, keys * 3 / 8);
+}
+
+TEST(HashRingTest, DiffProducesMigratingMovesToNextOwners) {
+    const HashRing before(specs("a,b,c,d:0"));
+    const HashRing after(specs("a,b,c,d"));
+    const auto moves = before.diff(after);
+    ASSERT_FALSE(moves.empty());
+    for (const auto& move : moves) {
+        EXPECT_EQ(move.target, "d");
+        EXPECT_TRUE(move.migrating);
+    }
+
+    // Переходное кольцо пишет как итоговое, а читает ещё и у прежнего владельца.
+    const HashRing transition(specs("a,b,c,d:0"), moves);
+    for (std::int64_t key = 1; key <= 5000; ++key) {
+        const auto h = shard_hash(key);
+        EXPECT_EQ(transition.shards()[transition.owner(h)].name, after.shards()[after.owner(h)].name);
+        EXPECT_EQ(transition.settled_owner(h), before.owner(h));
+        const auto previous = transition.previous_owner(h);
+        if (transition.owner(h) != before.owner(h)) {
+            ASSERT_TRUE(previous.has_value());
+            EXPECT_EQ(*previous, before.owner(h));
+        } else {
+            EXPECT_FALSE(previous.has_value());
+        }
+    }
+    EXPECT_TRUE(HashRing(specs("a,b,c,d")).diff(after).empty());
+}
+
+TEST(HashRingTest, SettledMoveOverridesRing) {
+    const HashRing ring(specs("a,b"), {{HashRange{0, 0xffffffffffffffffULL}, "b", false}});
+    for (std::int64_t key = 1; key <= 100; ++key) {
+        EXPECT_EQ(ring.owner(shard_hash(key)), 1u);
+        EXPECT_FALSE(ring.previous_owner(shard_hash(key)).has_value());
+    }
+    EXPECT_DOUBLE_EQ(ring.ownership()[1], 1.0);
+}
+
+TEST(ShardedMessageRepositoryTest, RoutesConversationToOneShard) {
+    Cluster cluster(HashRing(specs("a,b,c")));
+    std::int64_t id = 1;
+    for (std::int64_t user = 1; user <= 30; ++user) {
+        for (int i = 0; i < 5; ++i) cluster.repo->save(direct(id++, user, user + 100));
+    }
+    std::size_t used = 0;
+    for (const auto& shard : cluster.shards) used += shard->size() > 0 ? 1 : 0;
+    EXPECT_EQ(used, 3u);
+
+    const auto conversation = ConversationId::between(UserId(7), UserId(107));
+    EXPECT_EQ(cluster.repo->shards_for(conversation).size(), 1u);
+    const auto page = cluster.repo->find_page(conversation, std::nullopt, 3);
+    EXPECT_EQ(ids(page), (std::vector<std::int64_t>{35, 34, 33}));
+    EXPECT_EQ(ids(cluster.repo->find_page(conversation, MessageId(33), 10)),
+              (std::vector<std::int64_t>{32, 31}));
+    EXPECT_EQ(cluster.repo->stats().fanoutReads, 0u);
+}
+
+TEST(ShardedMessageRepositoryTest, RequiresAssignedIds) {
+    Cluster cluster(HashRing(specs("a,b")));
+    const message::Message unsaved(UserId(1), UserId(2), MessageText("x"), Timestamp(1));
+    EXPECT_THROW(cluster.repo->save(unsaved), std::invalid_argument);
+    EXPECT_THROW(cluster.repo->save_batch({direct(1, 1, 2), unsaved}), std::invalid_argument);
+    EXPECT_EQ(cluster.shards[0]->size() + cluster.shards[1]->size(), 0u);
+}
+
+TEST(ShardedMessageRepositoryTest, SaveBatchSplitsByShardAndSkipsDuplicates) {
+    Cluster cluster(HashRing(specs("a,b,c")));
+    std::vector<message::Message> batch;
+    for (std::int64_t i = 1; i <= 60; ++i) batch.push_back(direct(i, i, i + 1000));
+    EXPECT_EQ(cluster.repo->save_batch(batch), 60u);
+    EXPECT_EQ(cluster.repo->save_batch(batch), 0u);
+
+    std::uint64_t saves = 0;
+    for (std::size_t i = 0; i < 3; ++i) {
+        const auto s = cluster.repo->stats().shards[i];
+        EXPECT_EQ(s.saves, 2 * cluster.shards[i]->size());
+        saves += cluster.shards[i]->size();
+    }
+    EXPECT_EQ(saves, 60u);
+    for (const auto& m : batch) {
+        const auto page = cluster.repo->find_page(m.conversation_id(), std::nullopt, 10);
+        EXPECT_EQ(ids(page), (std::vector<std::int64_t>{m.id().value()}));
+    }
+}
+
+TEST(ShardedMessageRepositoryTest, SenderKeyMergesBothParticipantsShards) {
+    // Ищем пару пользователей на разных шардах.
+    const HashRing probe(specs("a,b,c"));
+    std::int64_t alice = 1;
+    std::int64_t bob = 2;
+    while (probe.owner(shard_hash(alice)) == probe.owner(shard_hash(bob))) ++bob;
+
+    Cluster cluster(HashRing(specs("a,b,c")), ShardKey::Sender);
+    cluster.repo->save(direct(10, alice, bob));
+    cluster.repo->save(direct(11, bob, alice));
+    cluster.repo->save(direct(12, alice, bob));
+    cluster.repo->save(direct(13, bob, alice));
+
+    const auto conversation = ConversationId::between(UserId(alice), UserId(bob));
+    EXPECT_EQ(cluster.repo->shards_for(conversation).size(), 2u);
+    EXPECT_EQ(ids(cluster.repo->find_page(conversation, std::nullopt, 3)),
+              (std::vector<std::int64_t>{13, 12, 11}));
+    EXPECT_EQ(ids(cluster.repo->find_page(conversation, MessageId(12), 10)),
+              (std::vector<std::int64_t>{11, 10}));
+    EXPECT_EQ(cluster.repo->stats().fanoutReads, 2u);
+
+    // Групповая переписка при ключе sender — со всех шард.
+    cluster.repo->save(to_group(20, alice, 5));
+    cluster.repo->save(to_group(21, bob, 5));
+    const auto group = ConversationId::group(GroupId(5));
+    EXPECT_EQ(cluster.repo->shards_for(group).size(), 3u);
+    EXPECT_EQ(ids(cluster.repo->find_page(group, std::nullopt, 10)), (std::vector<std::int64_t>{21, 20}));
+}
+
+TEST(ShardedMessageRepositoryTest, MigratingMoveReadsBothShardsUntilCleanup) {
+    // Шаг 1: до перебалансировки — три шарды, d без диапазонов.
+    const auto before = HashRing(specs("a,b,c,d:0"));
+    const auto after = HashRing(specs("a,b,c,d"));
+    const auto moves = before.diff(after);
+    Cluster old(before);
+    std::vector<message::Message> history;
+    for (std::int64_t user = 1; user <= 200; ++user) history.push_back(direct(user, user, user + 1000));
+    old.repo->save_batch(history);
+    EXPECT_EQ(old.shards[3]->size(), 0u);
+
+    // Шаг 2: переходная конфигурация поверх тех же хранилищ.
+    std::vector<std::shared_ptr<MessageRepository>> base(old.shards.begin(), old.shards.end());
+    ShardedMessageRepository transition(HashRing(specs("a,b,c,d:0"), moves), base);
+    std::int64_t movedConversation = 0;
+    for (const auto& m : history) {
+        if (transition.ring().previous_owner(shard_hash(m.conversation_id().value()))) {
+            movedConversation = m.conversation_id().value();
+            break;
+        }
+    }
+    ASSERT_NE(movedConversation, 0);
+    const ConversationId moved(movedConversation);
+    EXPECT_EQ(transition.shards_for(moved).size(), 2u);
+
+    // Новое сообщение уходит на d, старое ещё на прежней шарде: страница — из обеих.
+    transition.save(direct(500, moved.low().value(), moved.high().value()));
+    EXPECT_EQ(old.shards[3]->size(), 1u);
+    const auto oldId = moved.low().value();
+    EXPECT_EQ(ids(transition.find_page(moved, std::nullopt, 10)), (std::vector<std::int64_t>{500, oldId}));
+
+    // copy: сообщения не на своей шарде — на владельца; повторы при чтении отбрасываются.
+    const auto& ring = transition.ring();
+    for (std::size_t s = 0; s < 3; ++s) {
+        auto misplaced = old.shards[s]->extract_if([&](const message::Message& m) {
+            return ring.owner(shard_hash(m.conversation_id().value())) != s;
+        }, false);
+        for (const auto& m : misplaced) old.shards[ring.owner(shard_hash(m.conversation_id().value()))]->save(m);
+    }
+    EXPECT_EQ(ids(transition.find_page(moved, std::nullopt, 10)), (std::vector<std::int64_t>{500, oldId}));
+
+    // Шаг 3 и cleanup: итоговое кольцо читает одну шарду, лишние копии удалены.
+    ShardedMessageRepository final_(after, base);
+    EXPECT_EQ(final_.shards_for(moved).size(), 1u);
+    std::size_t removed = 0;
+    for (std::size_t s = 0; s < 4; ++s) {
+        removed += old.shards[s]->extract_if([&](const message::Message& m) {
+            return final_.ring().owner(shard_hash(m.conversation_id().value())) != s;
+        }, true).size();
+    }
+    EXPECT_GT(removed, 0u);
+    std::size_t total = 0;
+    for (const auto& shard : old.shards) total += shard->size();
+    EXPECT_EQ(total, 201u);
+    for (const auto& m : history) {
+        EXPECT_EQ(final_.find_page(m.conversation_id(), std::nullopt, 10).size(),
+                  m.conversation_id() == moved ? 2u : 1u);
+    }
+}
+
+TEST(ShardedMessageRepositoryTest, FanOutReadsRunUnderRequestDeadline) {
+    std::vector<std::shared_ptr<DeadlineShard>> shards;
+    std::vector<std::shared_ptr<MessageRepository>> base;
+    for (int i = 0; i < 3; ++i) {
+        shards.push_back(std::make_shared<DeadlineShard>());
+        base.push_back(shards.back());
+    }
+    ShardedMessageRepository repo(HashRing(specs("a,b,c")), base, ShardKey::Sender, 2);
+    const auto group = ConversationId::group(GroupId(5));
+    ASSERT_EQ(repo.shards_for(group).size(), 3u);
+
+    const auto deadline = RequestDeadline::Clock::now() + std::chrono::seconds(10);
+    {
+        RequestDeadline::Scope scope(deadline);
+        EXPECT_NO_THROW(repo.find_page(group, std::nullopt, 10));
+        EXPECT_FALSE(scope.exceeded());
+    }
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        EXPECT_EQ(shard->seen, deadline);
+    }
+
+    // Срок истёк: шарды в чужих потоках отказывают, запрос помечен превысившим срок.
+    const auto before = RequestDeadline::stats();
+    {
+        RequestDeadline::Scope scope(RequestDeadline::Clock::now() - std::chrono::milliseconds(1));
+        EXPECT_THROW(repo.find_page(group, std::nullopt, 10), DeadlineExceeded);
+        EXPECT_TRUE(scope.exceeded());
+    }
+    const auto after = RequestDeadline::stats();
+    EXPECT_EQ(after.requests - before.requests, 1u);
+    EXPECT_EQ(after.exceeded - before.exceeded, 1u);
+}
+
+TEST(ShardedMessageRepositoryTest, FanOutUsesBoundedSharedPool) {
+    std::vector<std::shared_ptr<ThreadShard>> shards;
+    std::vector<std::shared_ptr<MessageRepository>> base;
+    for (int i = 0; i < 4; ++i) {
+        shards.push_back(std::make_shared<ThreadShard>());
+        base.push_back(shards.back());
+    }
+    const auto group = ConversationId::group(GroupId(5));
+    const auto readers = [&] {
+        std::set<std::thread::id> all;
+        for (const auto& shard : shards) {
+            std::lock_guard lock(shard->mutex);
+            all.insert(shard->readers.begin(), shard->readers.end());
+            shard->readers.clear();
+        }
+        return all;
+    };
+
+    // Без пула все шарды читает вызывающий поток.
+    {
+        ShardedMessageRepository repo(HashRing(specs("a,b,c,d")), base, ShardKey::Sender);
+        repo.save(to_group(20, 1, 5));
+        repo.save(to_group(21, 2, 5));
+        EXPECT_EQ(ids(repo.find_page(group, std::nullopt, 10)), (std::vector<std::int64_t>{21, 20}));
+        EXPECT_EQ(readers(), (std::set<std::thread::id>{std::this_thread::get_id()}));
+    }
+
+    // С пулом из одного потока: сколько бы ни было запросов, кроме вызывающих шарды
+    // читает не больше одного потока.
+    ShardedMessageRepository repo(HashRing(specs("a,b,c,d")), base, ShardKey::Sender, 1);
+    constexpr int kCallers = 8;
+    std::vector<std::thread> callers;
+    std::set<std::thread::id> callerIds;
+    std::mutex callerMutex;
+    for (int c = 0; c < kCallers; ++c) {
+        callers.emplace_back([&] {
+            {
+                std::lock_guard lock(callerMutex);
+                callerIds.insert(std::this_thread::get_id());
+            }
+            for (int i = 0; i < 200; ++i) {
+                EXPECT_EQ(ids(repo.find_page(group, std::nullopt, 10)), (std::vector<std::int64_t>{21, 20}));
+            }
+        });
+    }
+    for (auto& caller : callers) caller.join();
+
+    std::size_t pooled = 0;
+    for (const auto& id : readers()) {
+        if (!callerIds.count(id)) ++pooled;
+    }
+    EXPECT_LE(pooled, 1u);
+    EXPECT_EQ(repo.stats().fanoutReads, static_cast<std::uint64_t>(kCallers * 200));
+}
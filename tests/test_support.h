@@ -0,0 +1,104 @@
+#pragma once
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "chatserver/infrastructure/concurrency/adaptive_limiter.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+
+namespace chatserver::test {
+// Общие помощники сетевых тестов: ожидание условия и сервер на свободном порту.
+
+template <typename Pred>
+bool wait_until(Pred pred, std::chrono::milliseconds limit = std::chrono::milliseconds(5000)) {
+    const auto deadline = std::chrono::steady_clock::now() + limit;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+// Опрашивает pred каждые 10 мс, пока он не станет true или не выйдет limit.
+// Для событий, которые сервер публикует из своих потоков (онлайн, закрытие, парковка).
+
+struct TestServer {
+    using tcp = boost::asio::ip::tcp;
+    using WebSocket = boost::beast::websocket::stream<tcp::socket>;
+    using Response = boost::beast::http::response<boost::beast::http::string_body>;
+
+    explicit TestServer(std::shared_ptr<infrastructure::http::HttpRouter> router = std::make_shared<infrastructure::http::HttpRouter>(),
+                        infrastructure::http::HttpServerOptions options = {},
+                        std::shared_ptr<infrastructure::realtime::ConnectionRegistry> registry =
+                            std::make_shared<infrastructure::realtime::ConnectionRegistry>(),
+                        std::shared_ptr<infrastructure::concurrency::AdmissionControl> admission = nullptr)
+        : router(std::move(router))
+        , registry(std::move(registry))
+        , admission(std::move(admission))
+        , server("127.0.0.1", 0, this->router, this->registry, options, this->admission) {
+        server.start();
+    }
+    // Маршруты регистрируются до конструктора: сервер стартует сразу.
+    // registry = nullptr — сервер без WebSocket; admission = nullptr — без лимитов.
+    ~TestServer() { server.stop(); }
+    // stop() идемпотентен: тест может остановить сервер сам (stop/shutdown).
+
+    tcp::endpoint endpoint() const {
+        return {boost::asio::ip::make_address("127.0.0.1"), server.port()};
+    }
+
+    tcp::socket connect(int rcvbuf = 0) {
+        tcp::socket socket(ioc);
+        socket.open(tcp::v4());
+        if (rcvbuf > 0) {
+            // Маленький приёмный буфер клиента: медленный получатель без десятков МБ в ядре.
+            socket.set_option(boost::asio::socket_base::receive_buffer_size(rcvbuf));
+        }
+        socket.connect(endpoint());
+        return socket;
+    }
+    // Сырое TCP-соединение на ioc.
+
+    std::unique_ptr<WebSocket> connect_ws(const std::string& target, int rcvbuf = 0) {
+        auto ws = std::make_unique<WebSocket>(connect(rcvbuf));
+        ws->handshake("127.0.0.1", target);
+        return ws;
+    }
+    // WebSocket после handshake на target (например, "/ws?user=1").
+
+    Response request(boost::beast::http::verb verb, const std::string& target, const std::string& body = "") const {
+        boost::asio::io_context local;
+        tcp::socket socket(local);
+        socket.connect(endpoint());
+        boost::beast::http::request<boost::beast::http::string_body> req{verb, target, 11};
+        req.set(boost::beast::http::field::host, "127.0.0.1");
+        if (!body.empty()) {
+            req.body() = body;
+            req.prepare_payload();
+        }
+        boost::beast::http::write(socket, req);
+        boost::beast::flat_buffer buffer;
+        Response res;
+        boost::beast::http::read(socket, buffer, res);
+        return res;
+    }
+    // Один запрос на новом соединении. Свой io_context — можно звать из нескольких потоков.
+
+    Response get(const std::string& target) const { return request(boost::beast::http::verb::get, target); }
+
+    std::shared_ptr<infrastructure::http::HttpRouter> router;
+    std::shared_ptr<infrastructure::realtime::ConnectionRegistry> registry;
+    std::shared_ptr<infrastructure::concurrency::AdmissionControl> admission;
+    infrastructure::http::HttpServer server;
+    boost::asio::io_context ioc;
+    // Контекст клиентских сокетов connect()/connect_ws(); используется из потока теста.
+};
+
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+#include "chatserver/domain/common/timestamp.h"
+#include "chatserver/infrastructure/concurrency/clock_ticker.h"
+
+using chatserver::domain::Timestamp;
+using chatserver::domain::TimestampClock;
+using chatserver::infrastructure::concurrency::ClockTicker;
+
+namespace {
+
+std::int64_t distance_us(Timestamp a, Timestamp b) {
+    const auto d = a.epoch_micros() - b.epoch_micros();
+    return d < 0 ? -d : d;
+}
+
+// Источник времени глобальный: каждый тест возвращает Precise за собой.
+class TimestampTest : public ::testing::Test {
+protected:
+    void TearDown() override { Timestamp::use_clock(TimestampClock::Precise); }
+};
+
+}
+
+TEST_F(TimestampTest, SecondsConstructorAndMicrosRoundTrip) {
+    EXPECT_EQ(Timestamp(1700000000).epoch_micros(), 1700000000000000);
+    const auto t = Timestamp::from_micros(1700000000999999);
+    EXPECT_EQ(t.epoch_seconds(), 1700000000);
+    EXPECT_EQ(t.epoch_micros(), 1700000000999999);
+    // Секунды округляются вниз и до эпохи.
+    EXPECT_EQ(Timestamp::from_micros(-1).epoch_seconds(), -1);
+    EXPECT_EQ(Timestamp::from_micros(-1000000).epoch_seconds(), -1);
+}
+
+TEST_F(TimestampTest, OrdersWithinOneSecond) {
+    const auto a = Timestamp::from_micros(1700000000000001);
+    const auto b = Timestamp::from_micros(1700000000000002);
+    EXPECT_EQ(a.epoch_seconds(), b.epoch_seconds());
+    EXPECT_TRUE(a < b);
+    EXPECT_FALSE(a == b);
+
+    const auto first = Timestamp::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_TRUE(first < Timestamp::now());
+}
+
+TEST_F(TimestampTest, CoarseClockStaysCloseToPrecise) {
+    Timestamp::use_clock(TimestampClock::Coarse);
+    EXPECT_EQ(Timestamp::current_clock(), TimestampClock::Coarse);
+    // Шаг грубых часов — тик ядра (до 10 мс при HZ=100).
+    EXPECT_LT(distance_us(Timestamp::now(), Timestamp::precise_now()), 20'000);
+}
+
+TEST_F(TimestampTest, CachedClockFollowsTickerAndRestoresSource) {
+    {
+        ClockTicker ticker(std::chrono::milliseconds(1));
+        EXPECT_EQ(Timestamp::current_clock(), TimestampClock::Cached);
+        const auto first = Timestamp::now();
+        EXPECT_LT(distance_us(first, Timestamp::precise_now()), 50'000);
+
+        // Значение обновляется тикером, а не вызовом now().
+        Timestamp later = first;
+        for (int i = 0; i < 500 && !(first < later); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            later = Timestamp::now();
+        }
+        EXPECT_TRUE(first < later);
+    }
+    EXPECT_EQ(Timestamp::current_clock(), TimestampClock::Precise);
+    EXPECT_THROW(ClockTicker(std::chrono::microseconds(0)), std::invalid_argument);
+}
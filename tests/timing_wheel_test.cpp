@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/concurrency/timing_wheel.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+
+using namespace chatserver::infrastructure;
+using concurrency::TimingWheel;
+using concurrency::WheelTimer;
+using chatserver::test::TestServer;
+using chatserver::test::wait_until;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Сервер читает из сокета до закрытия; true — сервер закрыл соединение.
+bool closed_by_server(tcp::socket& socket) {
+    char buf[256];
+    beast::error_code ec;
+    for (;;) {
+        socket.read_some(net::buffer(buf), ec);
+        if (ec) return ec == net::error::eof || ec == net::error::connection_reset;
+    }
+}
+
+std::shared_ptr<http::HttpRouter> ping_router() {
+    auto router = std::make_shared<http::HttpRouter>();
+    router->add_route("GET", "/ping", [](const http::HttpRequest&) { return http::HttpResponse{200, "{}"}; });
+    return router;
+}
+
+http::HttpServerOptions short_deadlines() {
+    http::HttpServerOptions options;
+    options.idleTimeout = 1s;
+    options.headerTimeout = 1s;
+    options.wsPingInterval = 1s;
+    options.timerTick = 20ms;
+    return options;
+}
+
+}
+
+TEST(TimingWheel, FiresOnTheScheduledTickAndNotBefore) {
+    const auto start = TimingWheel::Clock::time_point{};
+    TimingWheel wheel(10ms, start);
+    int fired = 0;
+    WheelTimer timer([&] { ++fired; });
+    wheel.schedule(timer, 35ms);  // округляется вверх до 4 тиков
+    EXPECT_TRUE(timer.armed());
+    EXPECT_EQ(wheel.armed(), 1u);
+
+    EXPECT_EQ(wheel.advance(start + 39ms), 0u);
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.advance(start + 40ms), 1u);
+    EXPECT_EQ(fired, 1);
+    EXPECT_FALSE(timer.armed());
+    EXPECT_EQ(wheel.armed(), 0u);
+
+    // Нулевая задержка — следующий тик, а не немедленный вызов
+    wheel.schedule(timer, 0ms);
+    EXPECT_EQ(fired, 1);
+    EXPECT_EQ(wheel.advance(start + 50ms), 1u);
+    EXPECT_EQ(fired, 2);
+}
+
+TEST(TimingWheel, CancelRescheduleAndDestroy) {
+    const auto start = TimingWheel::Clock::time_point{};
+    TimingWheel wheel(1ms, start);
+    int a = 0, b = 0;
+    WheelTimer first([&] { ++a; });
+    {
+        WheelTimer second([&] { ++b; });
+        wheel.schedule(first, 5ms);
+        wheel.schedule(second, 5ms);
+        EXPECT_EQ(wheel.armed(), 2u);
+        // Уничтожение взведённого таймера снимает его с колеса
+    }
+    EXPECT_EQ(wheel.armed(), 1u);
+
+    // Перевзвод переносит срок (keep-alive после каждого запроса)
+    wheel.schedule(first, 500ms);
+    wheel.advance(start + 100ms);
+    EXPECT_EQ(a, 0);
+    first.cancel();
+    first.cancel();
+    EXPECT_EQ(wheel.armed(), 0u);
+    wheel.advance(start + 1000ms);
+    EXPECT_EQ(a, 0);
+    EXPECT_EQ(b, 0);
+}
+
+TEST(TimingWheel, CascadedTimersFireExactlyOnTime) {
+    // Сроки на всех уровнях колеса, время двигается неравномерными шагами.
+    const auto start = TimingWheel::Clock::time_point{};
+    TimingWheel wheel(1ms, start);
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<std::int64_t> delayDist(1, 300000);
+
+    constexpr std::size_t kTimers = 3000;
+    std::vector<std::unique_ptr<WheelTimer>> timers;
+    std::vector<std::int64_t> expected(kTimers), actual(kTimers, -1);
+    std::int64_t now = 0;
+    for (std::size_t i = 0; i < kTimers; ++i) {
+        timers.push_back(std::make_unique<WheelTimer>([&, i] { actual[i] = now; }));
+    }
+    for (std::size_t i = 0; i < kTimers; ++i) {
+        // Часть взводится не с нуля: колесо уже провёрнуто на произвольный тик
+        if (i == kTimers / 2) {
+            while (now < 12345) {
+                ++now;
+                wheel.advance(start + std::chrono::milliseconds(now));
+            }
+        }
+        const auto delay = i % 10 == 0 ? std::int64_t{70000} + static_cast<std::int64_t>(i) : delayDist(rng);
+        wheel.schedule(*timers[i], std::chrono::milliseconds(delay));
+        expected[i] = now + delay;
+    }
+    // Дальний таймер за пределом второго уровня (256^3 тиков)
+    std::int64_t farFired = -1;
+    WheelTimer far([&] { farFired = now; });
+    wheel.schedule(far, std::chrono::milliseconds(1 << 24) + 5ms);
+    const auto farExpected = now + (1 << 24) + 5;
+
+    std::uniform_int_distribution<std::int64_t> stepDist(1, 700);
+    while (wheel.armed() > 1) {
+        // Шаг по одному тику, чтобы знать точный момент срабатывания
+        const auto target = now + stepDist(rng);
+        while (now < target) {
+            ++now;
+            wheel.advance(start + std::chrono::milliseconds(now));
+        }
+    }
+    for (std::size_t i = 0; i < kTimers; ++i) {
+        ASSERT_EQ(actual[i], expected[i]) << "timer " << i;
+    }
+    now = farExpected - 1;
+    wheel.advance(start + std::chrono::milliseconds(now));
+    EXPECT_EQ(farFired, -1);
+    now = farExpected;
+    wheel.advance(start + std::chrono::milliseconds(now));
+    EXPECT_EQ(farFired, farExpected);
+}
+
+TEST(TimingWheel, HandlersMayTouchOtherTimersInTheSameSlot) {
+    const auto start = TimingWheel::Clock::time_point{};
+    TimingWheel wheel(1ms, start);
+    int periodic = 0, victim = 0;
+    WheelTimer other([&] { ++victim; });
+    WheelTimer self;
+    self.set_handler([&] {
+        ++periodic;
+        other.cancel();
+        if (periodic < 3) wheel.schedule(self, 1ms);
+    });
+    // Слот — стек: self взведён последним и срабатывает первым
+    wheel.schedule(other, 2ms);
+    wheel.schedule(self, 2ms);
+    EXPECT_EQ(wheel.advance(start + 10ms), 3u);
+    EXPECT_EQ(periodic, 3);
+    EXPECT_EQ(victim, 0);
+    EXPECT_EQ(wheel.armed(), 0u);
+}
+
+TEST(TimingWheelServer, IdleKeepAliveConnectionIsClosed) {
+    TestServer fx(ping_router(), short_deadlines());
+    auto socket = fx.connect();
+    const std::string request = "GET /ping HTTP/1.1\r\nHost: x\r\n\r\n";
+    net::write(socket, net::buffer(request));
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(closed_by_server(socket));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, 900ms);
+    EXPECT_LT(elapsed, 3s);
+}
+
+TEST(TimingWheelServer, SlowHeadersAreCut) {
+    // slowloris: заголовки по байту, каждый раньше idleTimeout, но целиком дольше headerTimeout
+    auto options = short_deadlines();
+    options.idleTimeout = 30s;
+    TestServer fx(ping_router(), options);
+    auto socket = fx.connect();
+    const std::string partial = "GET /ping HTTP/1.1\r\nX-Slow: ";
+    net::write(socket, net::buffer(partial));
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<bool> stop{false};
+    std::thread trickle([&] {
+        beast::error_code ec;
+        while (!stop && !ec) {
+            std::this_thread::sleep_for(200ms);
+            net::write(socket, net::buffer("a", 1), ec);
+        }
+    });
+    EXPECT_TRUE(closed_by_server(socket));
+    stop = true;
+    trickle.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 3s);
+}
+
+TEST(TimingWheelServer, WebSocketPingKeepsReadersAndDropsSilentPeers) {
+    TestServer fx(ping_router(), short_deadlines());
+
+    // Читающий клиент отвечает на ping (Beast делает это внутри read)
+    auto reader = fx.connect_ws("/ws?user=1");
+    std::atomic<int> pings{0};
+    reader->control_callback([&](websocket::frame_type kind, beast::string_view) {
+        if (kind == websocket::frame_type::ping) ++pings;
+    });
+    std::thread readLoop([&] {
+        beast::flat_buffer buffer;
+        beast::error_code ec;
+        reader->read(buffer, ec);
+    });
+
+    // Молчащий клиент ничего не читает — pong не уходит
+    auto silent = fx.connect_ws("/ws?user=2");
+
+    ASSERT_TRUE(wait_until([&] { return fx.registry->is_online(1) && fx.registry->is_online(2); }));
+    EXPECT_TRUE(wait_until([&] { return !fx.registry->is_online(2); }));
+    EXPECT_TRUE(wait_until([&] { return pings >= 2; }));
+    EXPECT_TRUE(fx.registry->is_online(1));
+
+    beast::error_code ignored;
+    reader->next_layer().shutdown(tcp::socket::shutdown_both, ignored);
+    readLoop.join();
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chatserver/application/handlers/register_user_handler.h"
+#include "chatserver/infrastructure/cache/username_filter.h"
+#include "chatserver/infrastructure/repository/caching_user_repository.h"
+#include "chatserver/infrastructure/repository/in_memory_user_repository.h"
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::application::RegisterUserCommand;
+using chatserver::application::RegisterUserHandler;
+
+namespace {
+
+// Хэшер-заглушка: считает вызовы вместо PBKDF2.
+class CountingHasher final : public services::PasswordHasher {
+public:
+    PasswordHash hash(const std::string& plain) const override {
+        ++calls;
+        return PasswordHash("hash-of-" + plain);
+    }
+    bool verify(const std::string& plain, const PasswordHash& hash) const override {
+        return hash.value() == "hash-of-" + plain;
+    }
+    mutable std::atomic<int> calls{0};
+};
+
+// Хранилище-заглушка: считает поиски.
+class CountingRepository final : public repository::UserRepository {
+public:
+    std::int64_t save(const user::User& user) override { return inner.save(user); }
+    std::optional<user::User> find_by_username(const std::string& username) override {
+        ++lookups;
+        return inner.find_by_username(username);
+    }
+    repository::InMemoryUserRepository inner;
+    int lookups = 0;
+};
+
+cache::UsernameFilterOptions options_for(std::size_t items) {
+    cache::UsernameFilterOptions options;
+    options.expectedItems = items;
+    options.falsePositiveRate = 0.01;
+    return options;
+}
+
+}
+
+TEST(UsernameFilter, NeverForgetsAddedNames) {
+    cache::UsernameFilter filter(options_for(50'000));
+    for (int i = 0; i < 50'000; ++i) filter.add("user-" + std::to_string(i));
+    for (int i = 0; i < 50'000; ++i) {
+        ASSERT_TRUE(filter.may_contain("user-" + std::to_string(i))) << i;
+    }
+    EXPECT_EQ(filter.stats().items, 50'000u);
+    EXPECT_EQ(filter.stats().definitelyAbsent, 0u);
+}
+
+TEST(UsernameFilter, FalsePositiveRateStaysNearTarget) {
+    cache::UsernameFilter filter(options_for(100'000));
+    for (int i = 0; i < 100'000; ++i) filter.add("member-" + std::to_string(i));
+    int positives = 0;
+    constexpr int kProbes = 100'000;
+    for (int i = 0; i < kProbes; ++i) {
+        if (filter.may_contain("stranger-" + std::to_string(i))) ++positives;
+    }
+    const double rate = static_cast<double>(positives) / kProbes;
+    EXPECT_LT(rate, 0.015);
+
+    const auto s = filter.stats();
+    EXPECT_NEAR(s.estimatedFpr, 0.01, 0.005);
+    EXPECT_EQ(s.bytes % 64, 0u);
+    EXPECT_GE(s.bits, 100'000u * 9);  // не меньше 1.44·log2(1/p) ≈ 9.6 бит на имя с округлением
+}
+
+TEST(UsernameFilter, RejectsInvalidOptions) {
+    EXPECT_THROW(cache::UsernameFilter(options_for(0)), std::invalid_argument);
+    auto options = options_for(10);
+    options.falsePositiveRate = 1.0;
+    EXPECT_THROW(cache::UsernameFilter{options}, std::invalid_argument);
+}
+
+TEST(UsernameFilter, DuplicateRegistrationSkipsHashing) {
+    auto hasher = std::make_shared<CountingHasher>();
+    auto repo = std::make_shared<CountingRepository>();
+    auto filter = std::make_shared<cache::UsernameFilter>(options_for(1'000));
+    RegisterUserHandler handler(hasher, repo, filter);
+
+    EXPECT_GT(handler.handle(RegisterUserCommand{"alice", "pw"}), 0);
+    EXPECT_EQ(hasher->calls, 1);
+    EXPECT_TRUE(filter->may_contain("alice"));
+
+    EXPECT_THROW(handler.handle(RegisterUserCommand{"alice", "other"}), repository::UsernameTakenError);
+    EXPECT_EQ(hasher->calls, 1);  // PBKDF2 не запускался
+    EXPECT_EQ(repo->lookups, 1);
+}
+
+TEST(UsernameFilter, AbsentNameSkipsLookup) {
+    auto hasher = std::make_shared<CountingHasher>();
+    auto repo = std::make_shared<CountingRepository>();
+    auto filter = std::make_shared<cache::UsernameFilter>(options_for(1'000));
+    RegisterUserHandler handler(hasher, repo, filter);
+
+    for (int i = 0; i < 100; ++i) handler.handle(RegisterUserCommand{"new-" + std::to_string(i), "pw"});
+    EXPECT_EQ(hasher->calls, 100);
+    // Поиск только на ложных срабатываниях, и каждый из них учтён.
+    EXPECT_EQ(static_cast<std::uint64_t>(repo->lookups), filter->stats().falsePositives);
+    EXPECT_LT(repo->lookups, 10);
+}
+
+TEST(UsernameFilter, NameTakenOutsideFilterIsLearned) {
+    auto hasher = std::make_shared<CountingHasher>();
+    auto repo = std::make_shared<CountingRepository>();
+    auto filter = std::make_shared<cache::UsernameFilter>(options_for(1'000));
+    RegisterUserHandler handler(hasher, repo, filter);
+
+    // Имя занято мимо фильтра (другой узел): отказ даёт save(), фильтр его запоминает.
+    repo->inner.save(user::User(Username("bob"), PasswordHash("x")));
+    EXPECT_THROW(handler.handle(RegisterUserCommand{"bob", "pw"}), repository::UsernameTakenError);
+    EXPECT_EQ(hasher->calls, 1);
+    EXPECT_TRUE(filter->may_contain("bob"));
+
+    EXPECT_THROW(handler.handle(RegisterUserCommand{"bob", "pw"}), repository::UsernameTakenError);
+    EXPECT_EQ(hasher->calls, 1);
+}
+
+TEST(UsernameFilter, LoadsFromRepositoryStream) {
+    auto inner = std::make_shared<repository::InMemoryUserRepository>();
+    for (int i = 0; i < 500; ++i) {
+        inner->save(user::User(Username("u" + std::to_string(i)), PasswordHash("h")));
+    }
+    repository::CachingUserRepository cached(inner);
+    cache::UsernameFilter filter(options_for(1'000));
+    std::vector<std::string> seen;
+    cached.for_each_username([&](const std::string& name) {
+        seen.push_back(name);
+        filter.add(name);
+    });
+    EXPECT_EQ(seen.size(), 500u);
+    for (int i = 0; i < 500; ++i) EXPECT_TRUE(filter.may_contain("u" + std::to_string(i)));
+
+    // Хранилище без перечисления пользователей отказывает явно.
+    CountingRepository plain;
+    EXPECT_THROW(plain.for_each_username([](const std::string&) {}), std::logic_error);
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/application/handlers/get_message_history_handler.h"
+#include "chatserver/application/handlers/send_message_handler.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/http/resources/message_resource.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/infrastructure/realtime/realtime_message_notifier.h"
+#include "chatserver/infrastructure/repository/in_memory_message_repository.h"
+#include "chatserver/nlohmann/json.hpp"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace bhttp     = beast::http;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using json          = nlohmann::json;
+
+using namespace chatserver::infrastructure;
+using namespace chatserver::domain;
+using chatserver::test::TestServer;
+using chatserver::test::wait_until;
+
+namespace {
+
+struct RecordingConnection : realtime::RealtimeConnection {
+    std::vector<std::string> frames;
+    void send(std::shared_ptr<const std::string> frame) override { frames.push_back(*frame); }
+};
+
+struct RecordingNotifier : services::MessageNotifier {
+    std::vector<message::Message> stored;
+    void message_stored(const message::Message& message) override { stored.push_back(message); }
+    void group_message_stored(const message::Message& message, const std::vector<UserId>&) override {
+        stored.push_back(message);
+    }
+};
+
+}
+
+TEST(ConnectionRegistry, DeliversToEveryConnectionOfUser) {
+    realtime::ConnectionRegistry registry;
+    auto phone = std::make_shared<RecordingConnection>();
+    auto laptop = std::make_shared<RecordingConnection>();
+    auto other = std::make_shared<RecordingConnection>();
+    registry.add(2, phone);
+    registry.add(2, laptop);
+    registry.add(3, other);
+    EXPECT_EQ(registry.online_users(), 2u);
+    EXPECT_EQ(registry.connection_count(), 3u);
+
+    auto frame = std::make_shared<const std::string>("hello");
+    EXPECT_EQ(registry.send_to_user(2, frame), 2u);
+    EXPECT_EQ(registry.send_to_user(4, frame), 0u);
+    EXPECT_EQ(phone->frames, std::vector<std::string>{"hello"});
+    EXPECT_EQ(laptop->frames, std::vector<std::string>{"hello"});
+    EXPECT_TRUE(other->frames.empty());
+
+    registry.remove(2, phone.get());
+    EXPECT_EQ(registry.send_to_user(2, frame), 1u);
+    EXPECT_TRUE(registry.is_online(2));
+
+    // Уничтоженное соединение не получает кадров и вычищается при remove()
+    const auto* laptopPtr = laptop.get();
+    laptop.reset();
+    EXPECT_EQ(registry.send_to_user(2, frame), 0u);
+    registry.remove(2, laptopPtr);
+    EXPECT_FALSE(registry.is_online(2));
+    EXPECT_EQ(registry.connection_count(), 1u);
+}
+
+TEST(SendMessageHandler, NotifiesWithPlainTextAfterSave) {
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("secret");
+    auto repo = std::make_shared<repository::InMemoryMessageRepository>();
+    auto notifier = std::make_shared<RecordingNotifier>();
+    chatserver::application::SendMessageHandler handler(encryptor, repo, notifier);
+
+    const auto id = handler.handle({1, 2, "hi there", std::nullopt});
+    ASSERT_EQ(notifier->stored.size(), 1u);
+    const auto& m = notifier->stored.front();
+    EXPECT_EQ(m.id().value(), id);
+    EXPECT_EQ(m.sender_id().value(), 1);
+    EXPECT_EQ(m.receiver_id().value(), 2);
+    EXPECT_EQ(m.text().value(), "hi there");
+
+    // Невалидная пара не сохраняется и не доставляется
+    EXPECT_THROW(handler.handle({1, 0, "x", std::nullopt}), std::invalid_argument);
+    EXPECT_EQ(notifier->stored.size(), 1u);
+}
+
+TEST(WebSocketDelivery, SendMessagePushesToRecipientSocket) {
+    auto encryptor = std::make_shared<crypto::OpenSSLMessageEncryptor>("secret");
+    auto repo = std::make_shared<repository::InMemoryMessageRepository>();
+    auto registry = std::make_shared<realtime::ConnectionRegistry>();
+    auto sendHandler = std::make_shared<chatserver::application::SendMessageHandler>(
+        encryptor, repo, std::make_shared<realtime::RealtimeMessageNotifier>(registry));
+    auto historyHandler = std::make_shared<chatserver::application::GetMessageHistoryHandler>(encryptor, repo);
+    auto router = std::make_shared<chatserver::infrastructure::http::HttpRouter>();
+    chatserver::infrastructure::http::resources::MessageResource resource(sendHandler, historyHandler);
+    resource.register_routes(*router);
+
+    chatserver::infrastructure::http::HttpServerOptions options;
+    options.ioThreads = 2;
+    options.workerThreads = 2;
+    TestServer srv(router, options, registry);
+
+    // Получатель: WebSocket /ws?user=2
+    auto ws = srv.connect_ws("/ws?user=2");
+    ASSERT_TRUE(wait_until([&] { return registry->is_online(2); }));
+
+    // Отправитель: обычный keep-alive HTTP на том же порту
+    auto client = srv.connect();
+    beast::flat_buffer httpBuffer;
+    for (int i = 0; i < 2; ++i) {
+        bhttp::request<bhttp::string_body> req{bhttp::verb::post, "/send_message", 11};
+        req.set(bhttp::field::host, "127.0.0.1");
+        req.body() = json{{"sender_id", 1}, {"receiver_id", 2}, {"text", "hello " + std::to_string(i)}}.dump();
+        req.prepare_payload();
+        bhttp::write(client, req);
+        bhttp::response<bhttp::string_body> res;
+        bhttp::read(client, httpBuffer, res);
+        ASSERT_EQ(res.result_int(), 200u);
+    }
+
+    // Потоковый (chunked) ответ истории на том же keep-alive соединении
+    {
+        bhttp::request<bhttp::string_body> req{bhttp::verb::get, "/messages?user=2&peer=1", 11};
+        req.set(bhttp::field::host, "127.0.0.1");
+        bhttp::write(client, req);
+        bhttp::response<bhttp::string_body> res;
+        bhttp::read(client, httpBuffer, res);
+        ASSERT_EQ(res.result_int(), 200u);
+        EXPECT_EQ(json::parse(res.body())["messages"].size(), 2u);
+    }
+
+    // Кадры приходят в порядке отправки, с открытым текстом
+    for (int i = 0; i < 2; ++i) {
+        beast::flat_buffer frame;
+        ws->read(frame);
+        auto j = json::parse(beast::buffers_to_string(frame.data()));
+        EXPECT_EQ(j["type"], "message");
+        EXPECT_EQ(j["id"], i + 1);
+        EXPECT_EQ(j["sender_id"], 1);
+        EXPECT_EQ(j["receiver_id"], 2);
+        EXPECT_EQ(j["text"], "hello " + std::to_string(i));
+    }
+
+    // Upgrade без user отклоняется
+    EXPECT_THROW(srv.connect_ws("/ws"), beast::system_error);
+
+    // Закрытие сокета снимает пользователя с реестра
+    ws->close(websocket::close_code::normal);
+    EXPECT_TRUE(wait_until([&] { return !registry->is_online(2); }));
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatserver/infrastructure/http/http_server.h"
+#include "chatserver/infrastructure/realtime/connection_registry.h"
+#include "chatserver/nlohmann/json.hpp"
+#include "test_support.h"
+
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+namespace net       = boost::asio;
+using tcp           = net::ip::tcp;
+using json          = nlohmann::json;
+
+using chatserver::test::TestServer;
+using chatserver::test::wait_until;
+
+namespace {
+
+std::shared_ptr<const std::string> frame(int i) {
+    return std::make_shared<const std::string>(json{{"type", "message"}, {"id", i}}.dump());
+}
+
+// Разворачивает WebSocket-сообщение в кадры: одиночный или {"type":"batch"}.
+std::vector<json> read_frames(websocket::stream<tcp::socket>& ws) {
+    beast::flat_buffer buffer;
+    ws.read(buffer);
+    auto j = json::parse(beast::buffers_to_string(buffer.data()));
+    if (j["type"] == "batch") {
+        return j["messages"].get<std::vector<json>>();
+    }
+    return {j};
+}
+
+}
+
+TEST(WebSocketOutboundQueue, BurstIsCoalescedForBatchClients) {
+    TestServer f;
+    auto ws = f.connect_ws("/ws?user=1&batch=1");
+    ASSERT_TRUE(wait_until([&] { return f.registry->is_online(1); }));
+
+    constexpr int kFrames = 200;
+    for (int i = 0; i < kFrames; ++i) f.registry->send_to_user(1, frame(i));
+
+    int next = 0;
+    while (next < kFrames) {
+        for (const auto& j : read_frames(*ws)) {
+            ASSERT_EQ(j["id"], next);
+            ++next;
+        }
+    }
+    // Счётчики обновляются в on_write, который может отстать от прихода данных клиенту
+    ASSERT_TRUE(wait_until([&] {
+        return f.registry->outbound().snapshot().framesWritten == static_cast<std::uint64_t>(kFrames);
+    }));
+    const auto stats = f.registry->outbound().snapshot();
+    EXPECT_LT(stats.writeCalls, static_cast<std::uint64_t>(kFrames));
+    EXPECT_EQ(stats.framesDropped, 0u);
+}
+
+TEST(WebSocketOutboundQueue, PlainClientsGetOneMessagePerFrame) {
+    TestServer f;
+    auto ws = f.connect_ws("/ws?user=1");
+    ASSERT_TRUE(wait_until([&] { return f.registry->is_online(1); }));
+
+    for (int i = 0; i < 50; ++i) f.registry->send_to_user(1, frame(i));
+    for (int i = 0; i < 50; ++i) {
+        beast::flat_buffer buffer;
+        ws->read(buffer);
+        auto j = json::parse(beast::buffers_to_string(buffer.data()));
+        ASSERT_EQ(j["type"], "message");
+        ASSERT_EQ(j["id"], i);
+    }
+    EXPECT_TRUE(wait_until([&] { return f.registry->outbound().snapshot().framesWritten == 50u; }));
+    EXPECT_EQ(f.registry->outbound().snapshot().writeCalls, 50u);
+}
+
+TEST(WebSocketOutboundQueue, SlowConsumerIsThrottledAndToldAboutTheGap) {
+    chatserver::infrastructure::http::HttpServerOptions options;
+    options.wsHighWaterBytes = 256 * 1024;
+    TestServer f(std::make_shared<chatserver::infrastructure::http::HttpRouter>(), options);
+    auto ws = f.connect_ws("/ws?user=1&batch=1", 4096);
+    ASSERT_TRUE(wait_until([&] { return f.registry->is_online(1); }));
+
+    // 32 МБ кадров получателю, который ничего не читает
+    auto big = std::make_shared<const std::string>(
+        json{{"type", "message"}, {"text", std::string(64 * 1024, 'x')}}.dump());
+    constexpr std::uint64_t kSent = 512;
+    for (std::uint64_t i = 0; i < kSent; ++i) f.registry->send_to_user(1, big);
+    ASSERT_TRUE(wait_until([&] {
+        const auto s = f.registry->outbound().snapshot();
+        return s.framesQueued + s.framesDropped >= kSent;
+    }));
+    const auto flooded = f.registry->outbound().snapshot();
+    EXPECT_GT(flooded.framesDropped, 0u);
+    EXPECT_GE(flooded.slowConsumers, 1u);
+    EXPECT_TRUE(f.registry->is_online(1));
+
+    // Клиент дочитывает очередь; как только она опустела, приходит ещё один кадр.
+    // Каждый пропуск помечен кадром "gap": сумма dropped по ним равна числу
+    // отброшенных кадров, всё принятое пришло целиком.
+    std::uint64_t messages = 0, gaps = 0, reported = 0;
+    bool sent = false, done = false;
+    while (!done) {
+        if (!sent) {
+            // Не блокируемся в read, пока на сервере не завершилась последняя запись.
+            auto drained = [&] {
+                const auto s = f.registry->outbound().snapshot();
+                return s.framesWritten == s.framesQueued;
+            };
+            ASSERT_TRUE(wait_until([&] { return ws->next_layer().available() > 0 || drained(); }));
+            if (drained()) {
+                f.registry->send_to_user(1, frame(7));
+                sent = true;
+            }
+        }
+        for (const auto& j : read_frames(*ws)) {
+            if (j["type"] == "gap") {
+                ++gaps;
+                reported += j["dropped"].get<std::uint64_t>();
+            } else if (j.contains("id")) {
+                EXPECT_EQ(j["id"], 7);
+                done = true;
+            } else {
+                ++messages;
+            }
+        }
+    }
+    const auto after = f.registry->outbound().snapshot();
+    EXPECT_GE(gaps, 1u);
+    EXPECT_EQ(reported, after.framesDropped);
+    EXPECT_EQ(messages + gaps + 1, after.framesQueued);
+    EXPECT_EQ(messages + reported, kSent);
+}
+
+TEST(WebSocketOutboundQueue, SlowConsumerIsDisconnectedByPolicy) {
+    chatserver::infrastructure::http::HttpServerOptions options;
+    options.wsHighWaterBytes = 256 * 1024;
+    options.wsSlowConsumerPolicy = chatserver::infrastructure::http::SlowConsumerPolicy::Disconnect;
+    TestServer f(std::make_shared<chatserver::infrastructure::http::HttpRouter>(), options);
+    auto ws = f.connect_ws("/ws?user=1", 4096);
+    ASSERT_TRUE(wait_until([&] { return f.registry->is_online(1); }));
+
+    auto big = std::make_shared<const std::string>(std::string(64 * 1024, 'x'));
+    for (int i = 0; i < 512; ++i) f.registry->send_to_user(1, big);
+
+    ASSERT_TRUE(wait_until([&] { return f.registry->outbound().snapshot().slowConsumersDisconnected == 1; }));
+    EXPECT_TRUE(wait_until([&] { return !f.registry->is_online(1); }));
+
+    // Клиент дочитывает то, что успело уйти в сокет, и получает обрыв
+    beast::error_code ec;
+    for (int i = 0; i < 1000 && !ec; ++i) {
+        beast::flat_buffer buffer;
+        ws->read(buffer, ec);
+    }
+    EXPECT_TRUE(ec);
+}
@@ -0,0 +1,309 @@
+// tools/chatbulk/chatbulk.cpp
+//
+// chatbulk — массовая загрузка и выгрузка сообщений и пользователей напрямую в
+// Postgres, минуя /send_message (миграции, бэкфилл, перенос между кластерами).
+//
+// Импорт: NDJSON/CSV → разбор и шифрование пачками в --threads потоках
+// (OpenSSLMessageEncryptor::encrypt_batch) → один COPY ... FROM STDIN (FORMAT binary).
+// Экспорт: COPY ... TO STDOUT (FORMAT binary) → расшифровка пачками (decrypt_batch)
+// в --threads потоках → NDJSON/CSV. В обе стороны порядок строк сохраняется, а в
+// памяти не больше --in-flight пачек по --batch строк, так что объём входа не важен.
+//
+// Импорт — один COPY: при ошибке в любой строке не загружается ничего.
+// Пароли не переносятся: у пользователей копируется password_hash как есть.
+//
+// Примеры:
+//   ./chatbulk import messages --in messages.ndjson --threads 16 --id-node 900
+//   ./chatbulk export messages --format csv --out messages.csv
+//   ./chatbulk import users --in users.csv --format csv --db "host=db dbname=chat user=chat"
+// Пароль БД — как у psql: PGPASSWORD или ~/.pgpass.
+
+#include "chatserver/domain/message/message_id_generator.h"
+#include "chatserver/infrastructure/bulk/bulk_copy.h"
+#include "chatserver/infrastructure/concurrency/ordered_pipeline.h"
+#include "chatserver/infrastructure/crypto/openssl_message_encryptor.h"
+
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chatserver::infrastructure::bulk;
+using chatserver::infrastructure::concurrency::run_ordered_pipeline;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string mode;
+    // import | export
+    std::string kind;
+    // messages | users
+    BulkFormat format = BulkFormat::Ndjson;
+    std::string path = "-";
+    // --in / --out; "-" — stdin / stdout
+    std::string db = "host=localhost port=5432 dbname=chat user=chat";
+    std::string secret = "supersecretkey";
+    // Тот же секрет, что у сервера (src/main.cpp); CHATSERVER_SECRET переопределяет.
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t batch = 2000;
+    std::size_t inFlight = 0;
+    // 0 — 2 × threads
+    std::optional<std::int64_t> idNode;
+};
+
+struct Encoded {
+    std::string data;
+    std::size_t rows = 0;
+};
+
+using Connection = std::unique_ptr<PGconn, decltype(&PQfinish)>;
+using Result = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+Connection connect(const std::string& conninfo) {
+    Connection conn(PQconnectdb(conninfo.c_str()), &PQfinish);
+    if (!conn || PQstatus(conn.get()) != CONNECTION_OK) {
+        throw std::runtime_error(std::string("cannot connect to Postgres: ") +
+                                 (conn ? PQerrorMessage(conn.get()) : "out of memory"));
+    }
+    return conn;
+}
+
+void expect(PGconn* conn, Result res, ExecStatusType status, const char* what) {
+    if (!res || PQresultStatus(res.get()) != status) {
+        throw std::runtime_error(std::string(what) + ": " + PQerrorMessage(conn));
+    }
+}
+
+std::int64_t unix_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::size_t run_import(PGconn* conn, const Options& opts, std::istream& in) {
+    BulkRecordReader reader(in, opts.format);
+    const BulkRowParser parser(opts.format, reader.header());
+    const chatserver::infrastructure::crypto::OpenSSLMessageEncryptor encryptor(opts.secret);
+    std::unique_ptr<chatserver::domain::MessageIdGenerator> ids;
+    if (opts.idNode) ids = std::make_unique<chatserver::domain::MessageIdGenerator>(*opts.idNode);
+    const bool messages = opts.kind == "messages";
+    const auto nowUs = unix_now_us();
+
+    expect(conn, Result(PQexec(conn, std::string(messages ? kMessageCopyIn : kUserCopyIn).c_str()), &PQclear),
+           PGRES_COPY_IN, "COPY FROM STDIN");
+    const auto put = [conn](const std::string& data) {
+        if (PQputCopyData(conn, data.data(), static_cast<int>(data.size())) != 1) {
+            throw std::runtime_error(std::string("COPY write failed: ") + PQerrorMessage(conn));
+        }
+    };
+
+    std::size_t rows = 0;
+    try {
+        std::string header;
+        pgcopy::append_header(header);
+        put(header);
+        run_ordered_pipeline<BulkChunk, Encoded>(
+            opts.threads, opts.inFlight,
+            [&]() -> std::optional<BulkChunk> {
+                BulkChunk chunk;
+                std::string record;
+                while (chunk.records.size() < opts.batch && reader.next(record)) {
+                    chunk.records.push_back(std::move(record));
+                    chunk.lines.push_back(reader.line());
+                }
+                if (chunk.records.empty()) return std::nullopt;
+                if (messages && ids) reserve_message_ids(chunk, *ids);
+                return chunk;
+            },
+            [&](BulkChunk& chunk) {
+                return Encoded{messages ? encode_messages(chunk, parser, encryptor, nowUs)
+                                        : encode_users(chunk, parser, nowUs),
+                               chunk.records.size()};
+            },
+            [&](Encoded& encoded) {
+                put(encoded.data);
+                rows += encoded.rows;
+            });
+        std::string trailer;
+        pgcopy::append_trailer(trailer);
+        put(trailer);
+    } catch (const std::exception& ex) {
+        // Отменяем COPY целиком: в таблицу не попадает ни одна строка.
+        PQputCopyEnd(conn, ex.what());
+        Result(PQgetResult(conn), &PQclear);
+        throw;
+    }
+    if (PQputCopyEnd(conn, nullptr) != 1) {
+        throw std::runtime_error(std::string("COPY end failed: ") + PQerrorMessage(conn));
+    }
+    expect(conn, Result(PQgetResult(conn), &PQclear), PGRES_COMMAND_OK, "COPY");
+
+    // id переданы явно, поэтому последовательность не сдвинулась: без этого следующая
+    // регистрация (или сообщение без message_id_node) получила бы занятый id.
+    // Сообщения: только id из последовательности (< 2^32), сгенерированные id больше.
+    const char* resync = messages
+        ? "SELECT setval(pg_get_serial_sequence('messages', 'id'), "
+          "GREATEST(1, (SELECT COALESCE(max(id), 0) FROM messages WHERE id < 4294967296)))"
+        : "SELECT setval(pg_get_serial_sequence('users', 'id'), "
+          "GREATEST(1, (SELECT COALESCE(max(id), 0) FROM users)))";
+    expect(conn, Result(PQexec(conn, resync), &PQclear), PGRES_TUPLES_OK, "sequence resync");
+    return rows;
+}
+
+template <typename Row>
+std::size_t run_export(PGconn* conn,
+                       const Options& opts,
+                       std::ostream& out,
+                       std::string_view query,
+                       Row (*from_copy)(const PgCopyBinaryReader::Tuple&),
+                       const std::function<std::string(std::vector<Row>&)>& format)
+{
+    expect(conn, Result(PQexec(conn, std::string(query).c_str()), &PQclear), PGRES_COPY_OUT, "COPY TO STDOUT");
+
+    PgCopyBinaryReader reader;
+    PgCopyBinaryReader::Tuple tuple;
+    bool streamEnded = false;
+    std::size_t rows = 0;
+    run_ordered_pipeline<std::vector<Row>, Encoded>(
+        opts.threads, opts.inFlight,
+        [&]() -> std::optional<std::vector<Row>> {
+            std::vector<Row> chunk;
+            chunk.reserve(opts.batch);
+            while (chunk.size() < opts.batch) {
+                if (reader.next(tuple)) {
+                    chunk.push_back(from_copy(tuple));
+                    continue;
+                }
+                if (reader.finished() || streamEnded) break;
+                char* buf = nullptr;
+                const int n = PQgetCopyData(conn, &buf, 0);
+                if (n == -1) {
+                    streamEnded = true;
+                    continue;
+                }
+                if (n < 0) {
+                    throw std::runtime_error(std::string("COPY read failed: ") + PQerrorMessage(conn));
+                }
+                reader.feed(buf, static_cast<std::size_t>(n));
+                PQfreemem(buf);
+            }
+            if (chunk.empty()) return std::nullopt;
+            return chunk;
+        },
+        [&](std::vector<Row>& chunk) { return Encoded{format(chunk), chunk.size()}; },
+        [&](Encoded& encoded) {
+            out.write(encoded.data.data(), static_cast<std::streamsize>(encoded.data.size()));
+            if (!out) throw std::runtime_error("write to output failed");
+            rows += encoded.rows;
+        });
+
+    // Дочитываем хвост потока (маркер конца) и результат команды.
+    while (!streamEnded) {
+        char* buf = nullptr;
+        const int n = PQgetCopyData(conn, &buf, 0);
+        if (n == -1) break;
+        if (n < 0) throw std::runtime_error(std::string("COPY read failed: ") + PQerrorMessage(conn));
+        PQfreemem(buf);
+    }
+    expect(conn, Result(PQgetResult(conn), &PQclear), PGRES_COMMAND_OK, "COPY");
+    return rows;
+}
+
+void usage() {
+    std::cerr << "usage: chatbulk import|export messages|users [--format ndjson|csv] [--in F | --out F]\n"
+              << "                [--db CONNINFO] [--secret S] [--threads N] [--batch ROWS]\n"
+              << "                [--in-flight CHUNKS] [--id-node N]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (const char* env = std::getenv("CHATSERVER_SECRET")) opts.secret = env;
+    try {
+        if (argc < 3) throw std::invalid_argument("mode and table are required");
+        opts.mode = argv[1];
+        opts.kind = argv[2];
+        if (opts.mode != "import" && opts.mode != "export") throw std::invalid_argument("mode must be import or export");
+        if (opts.kind != "messages" && opts.kind != "users") throw std::invalid_argument("table must be messages or users");
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--format") opts.format = parse_bulk_format(value());
+            else if (arg == "--in" || arg == "--out") opts.path = value();
+            else if (arg == "--db") opts.db = value();
+            else if (arg == "--secret") opts.secret = value();
+            else if (arg == "--threads") opts.threads = std::stoul(value());
+            else if (arg == "--batch") opts.batch = std::stoul(value());
+            else if (arg == "--in-flight") opts.inFlight = std::stoul(value());
+            else if (arg == "--id-node") opts.idNode = std::stoll(value());
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.threads == 0 || opts.batch == 0) throw std::invalid_argument("--threads and --batch must be positive");
+        if (opts.inFlight == 0) opts.inFlight = 2 * opts.threads;
+    } catch (const std::exception& ex) {
+        std::cerr << "chatbulk: " << ex.what() << "\n";
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        auto conn = connect(opts.db);
+        const auto start = Clock::now();
+        std::size_t rows = 0;
+        if (opts.mode == "import") {
+            std::ifstream file;
+            if (opts.path != "-") {
+                file.open(opts.path, std::ios::binary);
+                if (!file) throw std::runtime_error("cannot open " + opts.path);
+            }
+            std::istream& in = opts.path == "-" ? std::cin : file;
+            rows = run_import(conn.get(), opts, in);
+        } else {
+            std::ofstream file;
+            if (opts.path != "-") {
+                file.open(opts.path, std::ios::binary | std::ios::trunc);
+                if (!file) throw std::runtime_error("cannot create " + opts.path);
+            }
+            std::ostream& out = opts.path == "-" ? std::cout : file;
+            if (opts.format == BulkFormat::Csv) {
+                const auto header = opts.kind == "messages" ? kMessageCsvHeader : kUserCsvHeader;
+                out.write(header.data(), static_cast<std::streamsize>(header.size()));
+            }
+            if (opts.kind == "messages") {
+                const chatserver::infrastructure::crypto::OpenSSLMessageEncryptor encryptor(opts.secret);
+                rows = run_export<BulkMessageRow>(
+                    conn.get(), opts, out, kMessageCopyOut, &message_from_copy,
+                    [&](std::vector<BulkMessageRow>& chunk) { return format_messages(chunk, encryptor, opts.format); });
+            } else {
+                rows = run_export<BulkUserRow>(
+                    conn.get(), opts, out, kUserCopyOut, &user_from_copy,
+                    [&](std::vector<BulkUserRow>& chunk) { return format_users(chunk, opts.format); });
+            }
+            out.flush();
+        }
+        const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cerr << "chatbulk: " << opts.mode << "ed " << rows << " " << opts.kind << " in " << std::fixed
+                  << std::setprecision(2) << secs << " s (" << std::setprecision(0)
+                  << static_cast<double>(rows) / std::max(secs, 1e-9) << " rows/s, " << opts.threads
+                  << " threads)\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "chatbulk: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
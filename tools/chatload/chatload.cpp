@@ -0,0 +1,725 @@
+// tools/chatload/chatload.cpp
+//
+// chatload — генератор HTTP-нагрузки для REST API ChatServer.
+//
+// Открывает N keep-alive соединений и гоняет по ним смесь запросов
+// /register, /login и /send_message. Два режима:
+//   • closed-loop — каждое соединение шлёт следующий запрос сразу после ответа;
+//   • open-loop   — запросы приходят с фиксированной частотой (--rate), а задержка
+//                   считается от *запланированного* момента отправки. Так очередь,
+//                   накопившаяся из-за медленного сервера, попадает в статистику
+//                   (защита от coordinated omission).
+// В конце печатается пропускная способность и распределение задержек
+// в формате HdrHistogram (percentile distribution).
+//
+// Пример:
+//   ./chatload --connections 64 --threads 4 --duration 30 --rate 5000 --mix 1:4:32
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include "chatserver/nlohmann/json.hpp"
+
+namespace beast = boost::beast;
+namespace http  = beast::http;
+namespace net   = boost::asio;
+using tcp       = net::ip::tcp;
+using json      = nlohmann::json;
+using Clock     = std::chrono::steady_clock;
+
+namespace {
+
+// ---------------------
+// Гистограмма задержек
+// ---------------------
+
+class LatencyHistogram {
+    // Лог-линейная гистограмма в духе HdrHistogram.
+    // Значения (микросекунды) делятся на «магнитуды» — степени двойки,
+    // каждая магнитуда разбита на kSubBuckets линейных корзин.
+    // Нулевая магнитуда точна; в остальных значение всегда попадает в верхнюю половину
+    // корзин (v >> magnitude >= kSubBuckets / 2), поэтому относительная погрешность —
+    // не хуже 2/kSubBuckets (~0.2%), то есть между двумя и тремя значащими цифрами.
+    // record() — O(1) без аллокаций, поэтому её можно звать на горячем пути.
+public:
+    static constexpr int kSubBits = 10;
+    static constexpr std::uint64_t kSubBuckets = 1u << kSubBits;
+    static constexpr int kMagnitudes = 27;
+    // 2^(kSubBits + kMagnitudes - 1) мкс ≈ 19 часов — заведомо больше любого таймаута.
+
+    LatencyHistogram() : counts_(kSubBuckets * kMagnitudes, 0) {}
+
+    void record(std::uint64_t us) {
+        const std::uint64_t maxTrackable = (kSubBuckets << (kMagnitudes - 1)) - 1;
+        us = std::min(us, maxTrackable);
+        ++counts_[index_of(us)];
+        ++total_;
+        sum_ += us;
+        max_ = std::max(max_, us);
+        min_ = std::min(min_, us);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+        min_ = std::min(min_, other.min_);
+    }
+
+    std::uint64_t count() const { return total_; }
+    std::uint64_t max() const { return total_ ? max_ : 0; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+
+    std::uint64_t value_at_percentile(double percentile) const {
+        // Возвращаем верхнюю границу корзины, в которую попал нужный ранг
+        // (highest equivalent value — как это делает HdrHistogram).
+        if (total_ == 0) return 0;
+        auto rank = static_cast<std::uint64_t>(percentile / 100.0 * total_ + 0.5);
+        rank = std::clamp<std::uint64_t>(rank, 1, total_);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(highest_equivalent(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static std::size_t index_of(std::uint64_t v) {
+        const int width = std::bit_width(v);
+        const int magnitude = width > kSubBits ? width - kSubBits : 0;
+        return static_cast<std::size_t>(magnitude) * kSubBuckets + (v >> magnitude);
+    }
+
+    static std::uint64_t highest_equivalent(std::size_t index) {
+        const std::uint64_t magnitude = index / kSubBuckets;
+        const std::uint64_t sub = index % kSubBuckets;
+        return ((sub + 1) << magnitude) - 1;
+    }
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t total_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+    std::uint64_t min_ = UINT64_MAX;
+};
+
+// ---------------------
+// Параметры запуска
+// ---------------------
+
+enum class Op { Register = 0, Login = 1, SendMessage = 2 };
+constexpr std::array<const char*, 3> kOpNames{"register", "login", "send_message"};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    int connections = 16;
+    int threads = 2;
+    int durationSec = 10;
+    double rate = 0.0;
+    // 0 — closed-loop; > 0 — open-loop с заданной суммарной частотой (запросов/с).
+    std::array<int, 3> mix{1, 1, 8};
+    // Веса операций register:login:send_message.
+    std::string password = "chatload-password";
+    std::size_t textSize = 64;
+    bool printDistribution = true;
+};
+
+void print_usage() {
+    std::cerr <<
+        "usage: chatload [options]\n"
+        "  --host H            адрес сервера (127.0.0.1)\n"
+        "  --port P            порт сервера (8080)\n"
+        "  --connections N     число keep-alive соединений (16)\n"
+        "  --threads T         число io-потоков (2)\n"
+        "  --duration S        длительность замера в секундах (10)\n"
+        "  --rate R            open-loop: суммарная частота запросов/с; без флага — closed-loop\n"
+        "  --mix A:B:C         веса register:login:send_message (1:1:8)\n"
+        "  --text-size BYTES   размер текста сообщения (64)\n"
+        "  --no-distribution   не печатать полное распределение перцентилей\n";
+}
+
+bool parse_mix(const std::string& s, std::array<int, 3>& out) {
+    std::array<int, 3> parsed{};
+    std::size_t pos = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto next = s.find(':', pos);
+        if ((i < 2) == (next == std::string::npos)) return false;
+        parsed[i] = std::stoi(s.substr(pos, next - pos));
+        if (parsed[i] < 0) return false;
+        pos = next + 1;
+    }
+    if (parsed[0] + parsed[1] + parsed[2] == 0) return false;
+    out = parsed;
+    return true;
+}
+
+bool parse_options(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--host") opts.host = value();
+        else if (arg == "--port") opts.port = value();
+        else if (arg == "--connections") opts.connections = std::stoi(value());
+        else if (arg == "--threads") opts.threads = std::stoi(value());
+        else if (arg == "--duration") opts.durationSec = std::stoi(value());
+        else if (arg == "--rate") opts.rate = std::stod(value());
+        else if (arg == "--mix") {
+            if (!parse_mix(value(), opts.mix)) throw std::invalid_argument("bad --mix, expected A:B:C");
+        }
+        else if (arg == "--text-size") opts.textSize = std::stoul(value());
+        else if (arg == "--no-distribution") opts.printDistribution = false;
+        else if (arg == "--help" || arg == "-h") return false;
+        else throw std::invalid_argument("unknown option " + arg);
+    }
+    if (opts.connections <= 0 || opts.threads <= 0 || opts.durationSec <= 0 || opts.rate < 0) {
+        throw std::invalid_argument("connections, threads and duration must be positive");
+    }
+    return true;
+}
+
+// ---------------------
+// Статистика io-потока
+// ---------------------
+
+struct WorkerStats {
+    // Каждый io-поток пишет только в свою статистику, поэтому блокировки не нужны.
+    // Слияние — один раз, после остановки всех потоков.
+    std::array<LatencyHistogram, 3> latency;
+    std::array<std::uint64_t, 3> ok{};
+    std::array<std::uint64_t, 3> httpErrors{};
+    std::uint64_t ioErrors = 0;
+    std::uint64_t setupFailures = 0;
+    std::uint64_t completedInWindow = 0;
+    // Ответы (ok и http-ошибки), пришедшие до конца окна замера: по ним считается
+    // throughput. Догоняющие ответы фазы drain входят только в задержки.
+};
+
+struct Shared {
+    Options opts;
+    std::vector<tcp::endpoint> endpoints;
+    std::atomic<int> ready{0};
+    std::atomic<int> finishedSetup{0};
+    // Счётчики фазы подготовки: сколько соединений зарегистрировались / завершили попытку.
+    std::atomic<bool> stopping{false};
+    // После установки новые запросы не создаются, ждём только in-flight.
+    std::string runId;
+};
+
+// ---------------------
+// Одно keep-alive соединение
+// ---------------------
+
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(net::io_context& ioc, Shared& shared, WorkerStats& stats, int index)
+        : shared_(shared)
+        , stats_(stats)
+        , index_(index)
+        , socket_(ioc)
+        , timer_(ioc)
+        , reconnectTimer_(ioc)
+        , rng_(static_cast<std::uint32_t>(index) * 7919u + 1u)
+        , text_(shared.opts.textSize, 'x') {}
+
+    void start() {
+        connect([self = shared_from_this()] { self->setup(); });
+    }
+
+    void begin_load(Clock::time_point measureStart, Clock::time_point measureEnd) {
+        // Вызывается из main через post() в поток соединения.
+        if (userId_ <= 0) return;
+        measureStart_ = measureStart;
+        measureEnd_ = measureEnd;
+        if (shared_.opts.rate > 0.0) {
+            // Open-loop: суммарная частота делится между соединениями поровну,
+            // начальная фаза сдвигается, чтобы соединения не стреляли синхронно.
+            interval_ = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(shared_.opts.connections / shared_.opts.rate));
+            nextArrival_ = measureStart_ + interval_ * index_ / shared_.opts.connections;
+            schedule_arrival();
+        } else {
+            timer_.expires_at(measureStart_);
+            timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+                if (!ec) self->issue_next_closed();
+            });
+        }
+    }
+
+    net::any_io_executor executor() { return socket_.get_executor(); }
+
+    std::size_t backlog() const { return queue_.size() + (inFlight_ ? 1 : 0); }
+
+    void stop() {
+        beast::error_code ec;
+        timer_.cancel();
+        reconnectTimer_.cancel();
+        socket_.shutdown(tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+    }
+
+private:
+    struct Pending {
+        Op op;
+        Clock::time_point intended;
+    };
+
+    template <typename Next>
+    void connect(Next next) {
+        net::async_connect(socket_, shared_.endpoints,
+            [self = shared_from_this(), next](beast::error_code ec, const tcp::endpoint&) {
+                if (ec) {
+                    ++self->stats_.ioErrors;
+                    self->retry_later([self, next] { self->connect(next); });
+                    return;
+                }
+                self->socket_.set_option(tcp::no_delay(true));
+                self->connected_ = true;
+                next();
+            });
+    }
+
+    template <typename Next>
+    void retry_later(Next next) {
+        if (shared_.stopping) return;
+        // Свой таймер: timer_ в open-loop ждёт следующего прихода запроса, и его
+        // перезапуск отменил бы расписание — соединение перестало бы давать нагрузку.
+        reconnectTimer_.expires_after(std::chrono::milliseconds(100));
+        reconnectTimer_.async_wait([next](beast::error_code ec) {
+            if (!ec) next();
+        });
+    }
+
+    void setup() {
+        // Каждое соединение регистрирует «своего» пользователя: его логин/пароль
+        // используются в /login, а id — как sender_id в /send_message.
+        username_ = "chatload-" + shared_.runId + "-" + std::to_string(index_);
+        json body{{"username", username_}, {"password", shared_.opts.password}};
+        send(make_request("/register", body.dump()), [self = shared_from_this()](bool ok, const std::string& resp) {
+            if (ok) {
+                try {
+                    auto j = json::parse(resp);
+                    if (j.contains("id") && j["id"].is_number_integer()) {
+                        self->userId_ = j["id"].get<std::int64_t>();
+                    }
+                } catch (const json::exception&) {}
+            }
+            if (self->userId_ <= 0) {
+                ++self->stats_.setupFailures;
+                std::cerr << "[chatload] connection " << self->index_
+                          << " setup failed: " << resp << std::endl;
+            } else {
+                ++self->shared_.ready;
+            }
+            ++self->shared_.finishedSetup;
+        });
+    }
+
+    void schedule_arrival() {
+        if (shared_.stopping) return;
+        timer_.expires_at(nextArrival_);
+        timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (ec) return;
+            // Запрос «пришёл» в запланированный момент, даже если соединение ещё занято:
+            // он встаёт в очередь, и ожидание в ней войдёт в измеренную задержку.
+            self->queue_.push_back({self->pick_op(), self->nextArrival_});
+            self->nextArrival_ += self->interval_;
+            self->schedule_arrival();
+            self->drain_queue();
+        });
+    }
+
+    void drain_queue() {
+        // Во время переподключения запросы копятся в очереди; её разберёт
+        // продолжение connect().
+        if (inFlight_ || !connected_ || queue_.empty()) return;
+        auto pending = queue_.front();
+        queue_.pop_front();
+        issue(pending);
+    }
+
+    void issue_next_closed() {
+        // Без соединения следующий запрос отправит продолжение connect().
+        if (shared_.stopping || !connected_) return;
+        issue({pick_op(), Clock::now()});
+    }
+
+    Op pick_op() {
+        const auto& mix = shared_.opts.mix;
+        std::uniform_int_distribution<int> dist(0, mix[0] + mix[1] + mix[2] - 1);
+        int r = dist(rng_);
+        if (r < mix[0]) return Op::Register;
+        if (r < mix[0] + mix[1]) return Op::Login;
+        return Op::SendMessage;
+    }
+
+    void issue(Pending pending) {
+        http::request<http::string_body> req;
+        switch (pending.op) {
+        case Op::Register: {
+            json body{{"username", username_ + "-" + std::to_string(++registerSeq_)},
+                      {"password", shared_.opts.password}};
+            req = make_request("/register", body.dump());
+            break;
+        }
+        case Op::Login: {
+            json body{{"username", username_}, {"password", shared_.opts.password}};
+            req = make_request("/login", body.dump());
+            break;
+        }
+        case Op::SendMessage: {
+            json body{{"sender_id", userId_}, {"receiver_id", userId_}, {"text", text_}};
+            req = make_request("/send_message", body.dump());
+            break;
+        }
+        }
+
+        current_ = pending;
+        send(std::move(req), [self = shared_from_this(), pending](bool ok, const std::string&) {
+            const auto now = Clock::now();
+            const auto op = static_cast<std::size_t>(pending.op);
+            self->current_.reset();
+            if (pending.intended >= self->measureStart_) {
+                if (ok) {
+                    ++self->stats_.ok[op];
+                } else {
+                    ++self->stats_.httpErrors[op];
+                }
+                if (now < self->measureEnd_) ++self->stats_.completedInWindow;
+                self->record_latency(pending, now);
+            }
+            if (self->shared_.opts.rate > 0.0) {
+                self->drain_queue();
+            } else {
+                self->issue_next_closed();
+            }
+        });
+    }
+
+    void record_latency(const Pending& pending, Clock::time_point now) {
+        const auto op = static_cast<std::size_t>(pending.op);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - pending.intended);
+        stats_.latency[op].record(static_cast<std::uint64_t>(std::max<std::int64_t>(us.count(), 0)));
+    }
+
+    http::request<http::string_body> make_request(const char* target, std::string body) const {
+        http::request<http::string_body> req{http::verb::post, target, 11};
+        req.set(http::field::host, shared_.opts.host);
+        req.set(http::field::content_type, "application/json");
+        req.keep_alive(true);
+        req.body() = std::move(body);
+        req.prepare_payload();
+        return req;
+    }
+
+    template <typename Done>
+    void send(http::request<http::string_body> req, Done done) {
+        inFlight_ = true;
+        request_ = std::move(req);
+        http::async_write(socket_, request_,
+            [self = shared_from_this(), done](beast::error_code ec, std::size_t) {
+                if (ec) return self->on_io_error(done);
+                self->response_ = {};
+                http::async_read(self->socket_, self->buffer_, self->response_,
+                    [self, done](beast::error_code ec, std::size_t) {
+                        if (ec) return self->on_io_error(done);
+                        self->inFlight_ = false;
+                        const bool ok = self->response_.result_int() / 100 == 2 &&
+                                        self->response_.body().find("\"error\"") == std::string::npos;
+                        if (!self->response_.keep_alive()) {
+                            // Сервер закрывает соединение — переподключаемся перед следующим запросом.
+                            beast::error_code ignored;
+                            self->connected_ = false;
+                            self->socket_.close(ignored);
+                            self->buffer_.clear();
+                            self->connect([self, done, ok, body = self->response_.body()] { done(ok, body); });
+                            return;
+                        }
+                        done(ok, self->response_.body());
+                    });
+            });
+    }
+
+    template <typename Done>
+    void on_io_error(Done done) {
+        // Разрыв соединения: считаем ошибку и переподключаемся.
+        // Запрос не повторяем — open-loop очередь продолжит работу после reconnect.
+        // Его задержка до разрыва входит в гистограмму: иначе сброшенные под нагрузкой
+        // (самые медленные) запросы выпали бы из хвоста распределения.
+        inFlight_ = false;
+        ++stats_.ioErrors;
+        if (current_) {
+            if (current_->intended >= measureStart_) record_latency(*current_, Clock::now());
+            current_.reset();
+        }
+        connected_ = false;
+        if (shared_.stopping) return;
+        beast::error_code ignored;
+        socket_.close(ignored);
+        buffer_.clear();
+        connect([self = shared_from_this(), done] {
+            if (self->userId_ > 0) {
+                if (self->shared_.opts.rate > 0.0) self->drain_queue();
+                else self->issue_next_closed();
+            } else {
+                done(false, "connection error");
+            }
+        });
+    }
+
+    Shared& shared_;
+    WorkerStats& stats_;
+    int index_;
+    tcp::socket socket_;
+    net::steady_timer timer_;
+    // Приходы open-loop (и старт closed-loop).
+    net::steady_timer reconnectTimer_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> request_;
+    http::response<http::string_body> response_;
+    std::mt19937 rng_;
+    std::string text_;
+    std::string username_;
+    std::int64_t userId_ = 0;
+    std::uint64_t registerSeq_ = 0;
+    bool inFlight_ = false;
+    bool connected_ = false;
+    // Сокет подключён; false с разрыва до конца async_connect.
+    std::deque<Pending> queue_;
+    std::optional<Pending> current_;
+    // Запрос нагрузки, ответ на который ещё не пришёл (не запросы фазы подготовки).
+    Clock::time_point measureStart_;
+    Clock::time_point measureEnd_ = Clock::time_point::max();
+    Clock::time_point nextArrival_;
+    Clock::duration interval_{};
+};
+
+// ---------------------
+// Отчёт
+// ---------------------
+
+void print_row(const char* name, const LatencyHistogram& h) {
+    std::cout << std::left << std::setw(14) << name << std::right
+              << std::setw(10) << h.count()
+              << std::setw(10) << static_cast<std::uint64_t>(h.mean())
+              << std::setw(10) << h.value_at_percentile(50.0)
+              << std::setw(10) << h.value_at_percentile(90.0)
+              << std::setw(10) << h.value_at_percentile(99.0)
+              << std::setw(10) << h.value_at_percentile(99.9)
+              << std::setw(10) << h.value_at_percentile(99.99)
+              << std::setw(10) << h.max() << "\n";
+}
+
+void print_distribution(const LatencyHistogram& h) {
+    // Формат совместим с HdrHistogram outputPercentileDistribution
+    // (можно подать в hdrhistogram plotter). Значения в миллисекундах.
+    std::cout << "\n       Value   Percentile   TotalCount 1/(1-Percentile)\n\n";
+    const auto total = h.count();
+    if (total == 0) return;
+    for (int halving = 0; halving <= 20; ++halving) {
+        for (int step = 0; step < 5; ++step) {
+            const double remaining = std::pow(0.5, halving);
+            const double pct = 1.0 - remaining + remaining * 0.5 * step / 5.0;
+            const auto value = h.value_at_percentile(pct * 100.0);
+            const auto count = static_cast<std::uint64_t>(std::min<double>(total, pct * total + 0.5));
+            std::cout << std::fixed << std::setprecision(3)
+                      << std::setw(12) << value / 1000.0
+                      << std::setprecision(6) << std::setw(13) << pct
+                      << std::setw(13) << count;
+            if (pct < 1.0) std::cout << std::setprecision(2) << std::setw(15) << 1.0 / (1.0 - pct);
+            std::cout << "\n";
+        }
+        if (std::pow(0.5, halving) * total < 1.0) break;
+    }
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(12) << h.max() / 1000.0
+              << std::setprecision(6) << std::setw(13) << 1.0
+              << std::setw(13) << total << "\n";
+    std::cout << "#[Mean    = " << std::setprecision(3) << h.mean() / 1000.0
+              << ", Max = " << h.max() / 1000.0 << "]\n"
+              << "#[Total count    = " << total << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Shared shared;
+    try {
+        if (!parse_options(argc, argv, shared.opts)) {
+            print_usage();
+            return EXIT_SUCCESS;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "chatload: " << ex.what() << "\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    const Options& opts = shared.opts;
+    shared.runId = std::to_string(::getpid()) + "-" +
+        std::to_string(std::chrono::system_clock::now().time_since_epoch().count() % 1000000);
+
+    try {
+        net::io_context resolverCtx;
+        tcp::resolver resolver(resolverCtx);
+        for (const auto& entry : resolver.resolve(opts.host, opts.port)) {
+            shared.endpoints.push_back(entry.endpoint());
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "chatload: resolve failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // io_context на поток: соединение живёт в одном потоке, статистика потока без блокировок.
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    std::vector<WorkerStats> stats(opts.threads);
+    for (int t = 0; t < opts.threads; ++t) {
+        contexts.push_back(std::make_unique<net::io_context>(1));
+    }
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    for (int i = 0; i < opts.connections; ++i) {
+        const int t = i % opts.threads;
+        connections.push_back(std::make_shared<Connection>(*contexts[t], shared, stats[t], i));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& ctx : contexts) {
+        threads.emplace_back([&ioc = *ctx] {
+            auto guard = net::make_work_guard(ioc);
+            ioc.run();
+        });
+    }
+
+    // Фаза подготовки: соединения открываются и регистрируют своих пользователей.
+    // Её время в статистику не попадает.
+    for (auto& c : connections) {
+        net::post(c->executor(), [c] { c->start(); });
+    }
+    const auto setupDeadline = Clock::now() + std::chrono::seconds(30);
+    while (shared.finishedSetup < opts.connections && Clock::now() < setupDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (shared.ready == 0) {
+        std::cerr << "chatload: no connection completed /register, is the server running?\n";
+        shared.stopping = true;
+        for (auto& c : connections) net::post(c->executor(), [c] { c->stop(); });
+        for (auto& ctx : contexts) ctx->stop();
+        for (auto& t : threads) t.join();
+        return EXIT_FAILURE;
+    }
+
+    const auto measureStart = Clock::now() + std::chrono::milliseconds(50);
+    const auto measureEnd = measureStart + std::chrono::seconds(opts.durationSec);
+    for (auto& c : connections) {
+        net::post(c->executor(), [c, measureStart, measureEnd] { c->begin_load(measureStart, measureEnd); });
+    }
+    std::this_thread::sleep_until(measureEnd);
+    shared.stopping = true;
+
+    // Даём in-flight запросам (и open-loop очереди) до 5 секунд на завершение:
+    // их задержка — тоже часть результата.
+    const auto drainDeadline = Clock::now() + std::chrono::seconds(5);
+    for (;;) {
+        std::atomic<std::size_t> backlog{0};
+        std::atomic<int> polled{0};
+        for (auto& c : connections) {
+            net::post(c->executor(), [c, &backlog, &polled] {
+                backlog += c->backlog();
+                ++polled;
+            });
+        }
+        while (polled < opts.connections) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (backlog == 0 || Clock::now() >= drainDeadline) {
+            if (backlog != 0) {
+                std::cerr << "chatload: " << backlog << " requests still pending after drain timeout\n";
+            }
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    for (auto& c : connections) net::post(c->executor(), [c] { c->stop(); });
+    for (auto& ctx : contexts) ctx->stop();
+    for (auto& t : threads) t.join();
+
+    // ---------------------
+    // Сводка
+    // ---------------------
+    WorkerStats total;
+    for (const auto& st : stats) {
+        for (std::size_t op = 0; op < 3; ++op) {
+            total.latency[op].merge(st.latency[op]);
+            total.ok[op] += st.ok[op];
+            total.httpErrors[op] += st.httpErrors[op];
+        }
+        total.ioErrors += st.ioErrors;
+        total.setupFailures += st.setupFailures;
+        total.completedInWindow += st.completedInWindow;
+    }
+    LatencyHistogram all;
+    std::uint64_t okTotal = 0, httpErrorsTotal = 0;
+    for (std::size_t op = 0; op < 3; ++op) {
+        all.merge(total.latency[op]);
+        okTotal += total.ok[op];
+        httpErrorsTotal += total.httpErrors[op];
+    }
+    const double seconds = std::chrono::duration<double>(measureEnd - measureStart).count();
+
+    std::cout << "chatload: " << opts.host << ":" << opts.port
+              << ", " << shared.ready << "/" << opts.connections << " connections, "
+              << opts.threads << " threads, " << opts.durationSec << "s, ";
+    if (opts.rate > 0.0) std::cout << "open-loop at " << opts.rate << " req/s";
+    else std::cout << "closed-loop";
+    std::cout << ", mix " << opts.mix[0] << ":" << opts.mix[1] << ":" << opts.mix[2] << "\n\n";
+
+    std::cout << "requests:   ok=" << okTotal << " http_errors=" << httpErrorsTotal
+              << " io_errors=" << total.ioErrors << " setup_failures=" << total.setupFailures << "\n";
+    std::cout << std::fixed << std::setprecision(1)
+              << "throughput: " << total.completedInWindow / seconds << " req/s\n\n";
+
+    std::cout << "latency, us" << "\n"
+              << std::left << std::setw(14) << "op" << std::right
+              << std::setw(10) << "count" << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p90"
+              << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+              << std::setw(10) << "p99.99" << std::setw(10) << "max" << "\n";
+    for (std::size_t op = 0; op < 3; ++op) {
+        if (total.latency[op].count() > 0) print_row(kOpNames[op], total.latency[op]);
+    }
+    print_row("all", all);
+
+    if (opts.printDistribution) {
+        print_distribution(all);
+    }
+
+    return httpErrorsTotal == 0 && total.ioErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,414 @@
+// tools/chatshard/chatshard.cpp
+//
+// chatshard — перебалансировка шард сообщений (message_shards в config/server.ini).
+// Читает ту же конфигурацию, что сервер: кольцо, переносы диапазонов, ключ и строки
+// подключения message_shard_<имя>.
+//
+//   plan [--add NAME[:VNODES]] [--remove NAME]
+//       Доли шард на кольце. С --add/--remove — какие диапазоны хэшей переедут и
+//       конфигурации для каждого шага ниже.
+//   copy
+//       Копирует ключи, лежащие не на своей шарде (owner по текущей конфигурации), на
+//       шарду-владельца: COPY TO STDOUT (binary) источника → COPY FROM STDIN во
+//       временную таблицу цели → INSERT ... ON CONFLICT DO NOTHING. Повторный запуск
+//       безопасен и докопирует только новое.
+//   cleanup [--dry-run]
+//       Удаляет с шарды ключи, которые сервер с текущей конфигурацией на ней уже не
+//       читает (ни владелец, ни прежний владелец migrating-переноса).
+//
+// Перенос диапазона (например, новая шарда d):
+//   1. chatshard plan --add d; в конфигурацию — d:0 и переносы :migrating из вывода,
+//      перезапуск серверов: новые записи идут на d, история читается с обеих шард.
+//   2. chatshard copy.
+//   3. Итоговая конфигурация из вывода plan (d со своими vnodes, без этих переносов),
+//      перезапуск серверов.
+//   4. chatshard cleanup.
+//
+// Ключи источника перечисляются потоком: conversation — loose index scan по
+// (conversation_id, id), sender — SELECT DISTINCT sender_id (полное чтение таблицы).
+// Пароль БД — в строке подключения или PGPASSWORD / ~/.pgpass.
+
+#include "chatserver/common/common.h"
+#include "chatserver/infrastructure/repository/sharded_message_repository.h"
+#include "chatserver/infrastructure/sharding/hash_ring.h"
+
+#include <libpq-fe.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace chatserver::infrastructure::sharding;
+using chatserver::infrastructure::repository::ShardKey;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string command;
+    // plan | copy | cleanup
+    std::string config = "config/server.ini";
+    std::optional<std::string> add;
+    std::optional<std::string> remove;
+    std::size_t batch = 1000;
+    // Ключей на один COPY / DELETE.
+    bool dryRun = false;
+};
+
+struct ShardConfig {
+    std::vector<ShardSpec> shards;
+    std::vector<ShardMove> moves;
+    ShardKey key = ShardKey::Conversation;
+    int vnodes = 64;
+    std::map<std::string, std::string> connections;
+};
+
+ShardConfig load_config(const std::string& path) {
+    const auto ini = chatserver::common::parse_ini(path);
+    auto value = [&ini](const std::string& key, const std::string& fallback) {
+        auto it = ini.find(key);
+        return it != ini.end() ? it->second : fallback;
+    };
+    ShardConfig config;
+    config.vnodes = std::stoi(value("message_shard_vnodes", "64"));
+    config.shards = parse_shard_specs(value("message_shards", ""), config.vnodes);
+    if (config.shards.empty()) {
+        throw std::invalid_argument("message_shards is empty in " + path);
+    }
+    config.moves = parse_shard_moves(value("message_shard_moves", ""));
+    config.key = chatserver::infrastructure::repository::parse_shard_key(value("message_shard_key", "conversation"));
+    for (const auto& shard : config.shards) {
+        config.connections[shard.name] = value("message_shard_" + shard.name, "");
+    }
+    return config;
+}
+
+std::string format_shards(const std::vector<ShardSpec>& shards, int defaultVnodes) {
+    std::string out;
+    for (const auto& shard : shards) {
+        if (!out.empty()) out += ",";
+        out += shard.name;
+        if (shard.vnodes != defaultVnodes) out += ":" + std::to_string(shard.vnodes);
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// plan
+
+void print_shares(const HashRing& ring) {
+    const auto share = ring.ownership();
+    for (std::size_t i = 0; i < ring.shards().size(); ++i) {
+        std::cout << "  " << std::left << std::setw(16) << ring.shards()[i].name << " vnodes "
+                  << std::setw(5) << ring.shards()[i].vnodes << " share " << std::fixed
+                  << std::setprecision(2) << share[i] * 100 << "%\n";
+    }
+}
+
+void run_plan(const Options& opts, const ShardConfig& config) {
+    const HashRing current(config.shards, config.moves);
+    std::cout << "current ring:\n";
+    print_shares(current);
+    if (!opts.add && !opts.remove) {
+        return;
+    }
+
+    // Итоговое кольцо: новая шарда со своими vnodes, удаляемая — без диапазонов.
+    auto finalShards = config.shards;
+    auto transitionShards = config.shards;
+    if (opts.add) {
+        const auto added = parse_shard_specs(*opts.add, config.vnodes).at(0);
+        if (current.find(added.name)) throw std::invalid_argument("shard already exists: " + added.name);
+        finalShards.push_back(added);
+        transitionShards.push_back(ShardSpec{added.name, 0});
+    }
+    if (opts.remove) {
+        bool found = false;
+        for (auto& shard : finalShards) {
+            if (shard.name == *opts.remove) {
+                shard.vnodes = 0;
+                found = true;
+            }
+        }
+        if (!found) throw std::invalid_argument("unknown shard: " + *opts.remove);
+    }
+    // Прежние окончательные переносы остаются; прежние migrating должны быть завершены.
+    std::vector<ShardMove> settled;
+    for (const auto& move : config.moves) {
+        if (move.migrating) {
+            throw std::invalid_argument("finish the pending migration first (message_shard_moves has :migrating)");
+        }
+        settled.push_back(move);
+    }
+    const HashRing transitionBase(transitionShards, settled);
+    const HashRing target(finalShards, settled);
+    auto moves = transitionBase.diff(target);
+    auto transitionMoves = settled;
+    transitionMoves.insert(transitionMoves.end(), moves.begin(), moves.end());
+    const HashRing transition(transitionShards, transitionMoves);
+
+    // Удалённую шарду можно убрать из списка, только если на неё не указывает
+    // ни один оставшийся перенос.
+    auto finalList = finalShards;
+    if (opts.remove) {
+        bool referenced = false;
+        for (const auto& move : settled) referenced = referenced || move.target == *opts.remove;
+        if (!referenced) {
+            std::erase_if(finalList, [&](const ShardSpec& s) { return s.name == *opts.remove; });
+        }
+    }
+
+    std::cout << "\n" << moves.size() << " hash ranges change owner. After the move:\n";
+    print_shares(target);
+    std::cout << "\n1. Configure and restart servers (writes go to new owners, reads merge):\n"
+              << "   message_shards = " << format_shards(transitionShards, config.vnodes) << "\n"
+              << "   message_shard_moves = " << format_shard_moves(transition.moves()) << "\n";
+    if (opts.add) {
+        std::cout << "   message_shard_" << finalShards.back().name << " = <connection string>\n";
+    }
+    std::cout << "2. chatshard copy\n"
+              << "3. Configure and restart servers:\n"
+              << "   message_shards = " << format_shards(finalList, config.vnodes) << "\n"
+              << "   message_shard_moves = " << format_shard_moves(settled) << "\n"
+              << "4. chatshard cleanup\n";
+}
+
+// ---------------------------------------------------------------------------
+// copy / cleanup
+
+using Connection = std::unique_ptr<PGconn, decltype(&PQfinish)>;
+using Result = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+Connection connect(const std::string& name, const std::string& conninfo) {
+    if (conninfo.empty()) {
+        throw std::invalid_argument("no connection string for shard " + name + " (message_shard_" + name + ")");
+    }
+    Connection conn(PQconnectdb(conninfo.c_str()), &PQfinish);
+    if (!conn || PQstatus(conn.get()) != CONNECTION_OK) {
+        throw std::runtime_error("cannot connect to shard " + name + ": " +
+                                 (conn ? PQerrorMessage(conn.get()) : "out of memory"));
+    }
+    return conn;
+}
+
+void expect(PGconn* conn, Result res, ExecStatusType status, const std::string& what) {
+    if (!res || PQresultStatus(res.get()) != status) {
+        throw std::runtime_error(what + ": " + PQerrorMessage(conn));
+    }
+}
+
+Result exec(PGconn* conn, const std::string& sql, ExecStatusType status, const std::string& what) {
+    Result res(PQexec(conn, sql.c_str()), &PQclear);
+    if (!res || PQresultStatus(res.get()) != status) {
+        throw std::runtime_error(what + ": " + PQerrorMessage(conn));
+    }
+    return res;
+}
+
+std::string key_column(ShardKey key) {
+    return key == ShardKey::Conversation ? "conversation_id" : "sender_id";
+}
+
+std::string key_array(const std::vector<std::int64_t>& keys) {
+    std::string out = "'{";
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (i) out += ",";
+        out += std::to_string(keys[i]);
+    }
+    return out + "}'::bigint[]";
+}
+
+class KeyStream {
+// Ключи шарды по одному (single-row mode): память не зависит от их числа.
+public:
+    KeyStream(PGconn* conn, ShardKey key) : conn_(conn) {
+        const std::string sql = key == ShardKey::Conversation
+            // Loose index scan: каждый шаг — один спуск по индексу (conversation_id, id).
+            ? "WITH RECURSIVE k AS ("
+              "  (SELECT conversation_id AS v FROM messages WHERE conversation_id IS NOT NULL "
+              "   ORDER BY conversation_id LIMIT 1) "
+              "  UNION ALL "
+              "  SELECT (SELECT conversation_id FROM messages WHERE conversation_id > k.v "
+              "          ORDER BY conversation_id LIMIT 1) FROM k WHERE k.v IS NOT NULL) "
+              "SELECT v FROM k WHERE v IS NOT NULL"
+            : "SELECT DISTINCT sender_id FROM messages";
+        if (!PQsendQuery(conn_, sql.c_str()) || !PQsetSingleRowMode(conn_)) {
+            throw std::runtime_error(std::string("key scan failed: ") + PQerrorMessage(conn_));
+        }
+    }
+
+    std::optional<std::int64_t> next() {
+        while (true) {
+            Result res(PQgetResult(conn_), &PQclear);
+            if (!res) return std::nullopt;
+            const auto status = PQresultStatus(res.get());
+            if (status == PGRES_SINGLE_TUPLE) {
+                return std::stoll(PQgetvalue(res.get(), 0, 0));
+            }
+            if (status != PGRES_TUPLES_OK) {
+                throw std::runtime_error(std::string("key scan failed: ") + PQerrorMessage(conn_));
+            }
+        }
+    }
+
+private:
+    PGconn* conn_;
+};
+
+std::size_t copy_keys(PGconn* source, PGconn* target, ShardKey key, const std::vector<std::int64_t>& keys) {
+    exec(target, "BEGIN", PGRES_COMMAND_OK, "BEGIN");
+    exec(target,
+         "CREATE TEMP TABLE shard_move (id BIGINT, sender_id BIGINT, receiver_id BIGINT, group_id BIGINT, "
+         "conversation_id BIGINT, text TEXT, created_at TIMESTAMP) ON COMMIT DROP",
+         PGRES_COMMAND_OK, "CREATE TEMP TABLE");
+    exec(target, "COPY shard_move FROM STDIN (FORMAT binary)", PGRES_COPY_IN, "COPY FROM STDIN");
+    exec(source,
+         "COPY (SELECT id, sender_id, receiver_id, group_id, conversation_id, text, created_at "
+         "FROM messages WHERE " + key_column(key) + " = ANY(" + key_array(keys) + ")) "
+         "TO STDOUT (FORMAT binary)",
+         PGRES_COPY_OUT, "COPY TO STDOUT");
+
+    // Двоичный поток источника передаётся цели как есть: формат колонок одинаковый.
+    while (true) {
+        char* buf = nullptr;
+        const int n = PQgetCopyData(source, &buf, 0);
+        if (n == -1) break;
+        if (n < 0) {
+            const std::string error = PQerrorMessage(source);
+            PQputCopyEnd(target, error.c_str());
+            throw std::runtime_error("COPY read failed: " + error);
+        }
+        const int put = PQputCopyData(target, buf, n);
+        PQfreemem(buf);
+        if (put != 1) throw std::runtime_error(std::string("COPY write failed: ") + PQerrorMessage(target));
+    }
+    expect(source, Result(PQgetResult(source), &PQclear), PGRES_COMMAND_OK, "COPY TO STDOUT");
+    if (PQputCopyEnd(target, nullptr) != 1) {
+        throw std::runtime_error(std::string("COPY end failed: ") + PQerrorMessage(target));
+    }
+    expect(target, Result(PQgetResult(target), &PQclear), PGRES_COMMAND_OK, "COPY FROM STDIN");
+
+    auto inserted = exec(target,
+         "INSERT INTO messages (id, sender_id, receiver_id, group_id, conversation_id, text, created_at) "
+         "SELECT id, sender_id, receiver_id, group_id, conversation_id, text, created_at FROM shard_move "
+         "ON CONFLICT DO NOTHING",
+         PGRES_COMMAND_OK, "INSERT");
+    exec(target, "COMMIT", PGRES_COMMAND_OK, "COMMIT");
+    return std::stoull(PQcmdTuples(inserted.get()));
+}
+
+std::size_t delete_keys(PGconn* conn, ShardKey key, const std::vector<std::int64_t>& keys) {
+    auto res = exec(conn, "DELETE FROM messages WHERE " + key_column(key) + " = ANY(" + key_array(keys) + ")",
+                    PGRES_COMMAND_OK, "DELETE");
+    return std::stoull(PQcmdTuples(res.get()));
+}
+
+void run_copy_or_cleanup(const Options& opts, const ShardConfig& config) {
+    const HashRing ring(config.shards, config.moves);
+    const bool copy = opts.command == "copy";
+    std::size_t totalRows = 0;
+    for (std::size_t source = 0; source < ring.shards().size(); ++source) {
+        const auto& name = ring.shards()[source].name;
+        auto scan = connect(name, config.connections.at(name));
+        auto work = connect(name, config.connections.at(name));
+        std::map<std::size_t, Connection> targets;
+        std::map<std::size_t, std::vector<std::int64_t>> pending;
+        std::size_t keys = 0;
+        std::size_t rows = 0;
+
+        auto flush = [&](std::size_t target) {
+            auto& batch = pending[target];
+            if (batch.empty()) return;
+            if (copy) {
+                auto it = targets.find(target);
+                if (it == targets.end()) {
+                    const auto& targetName = ring.shards()[target].name;
+                    it = targets.emplace(target, connect(targetName, config.connections.at(targetName))).first;
+                }
+                rows += copy_keys(work.get(), it->second.get(), config.key, batch);
+            } else if (!opts.dryRun) {
+                rows += delete_keys(work.get(), config.key, batch);
+            }
+            batch.clear();
+        };
+
+        KeyStream stream(scan.get(), config.key);
+        while (const auto k = stream.next()) {
+            const auto hash = shard_hash(*k);
+            const auto owner = ring.owner(hash);
+            if (owner == source) continue;
+            if (!copy && ring.previous_owner(hash) == source) continue;
+            ++keys;
+            auto& batch = pending[copy ? owner : source];
+            batch.push_back(*k);
+            if (batch.size() >= opts.batch) flush(copy ? owner : source);
+        }
+        for (auto& [target, batch] : pending) flush(target);
+
+        std::cerr << "chatshard: " << name << ": " << keys << " misplaced keys, " << rows << " rows "
+                  << (copy ? "copied" : (opts.dryRun ? "would be deleted (dry run)" : "deleted")) << "\n";
+        totalRows += rows;
+    }
+    std::cerr << "chatshard: " << opts.command << " done, " << totalRows << " rows\n";
+}
+
+void usage() {
+    std::cerr << "usage: chatshard plan [--add NAME[:VNODES]] [--remove NAME] [--config F]\n"
+              << "       chatshard copy [--batch KEYS] [--config F]\n"
+              << "       chatshard cleanup [--dry-run] [--batch KEYS] [--config F]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    try {
+        if (argc < 2) throw std::invalid_argument("command is required");
+        opts.command = argv[1];
+        if (opts.command != "plan" && opts.command != "copy" && opts.command != "cleanup") {
+            throw std::invalid_argument("command must be plan, copy or cleanup");
+        }
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--config") opts.config = value();
+            else if (arg == "--add") opts.add = value();
+            else if (arg == "--remove") opts.remove = value();
+            else if (arg == "--batch") opts.batch = std::stoul(value());
+            else if (arg == "--dry-run") opts.dryRun = true;
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+        if (opts.batch == 0) throw std::invalid_argument("--batch must be positive");
+    } catch (const std::exception& ex) {
+        std::cerr << "chatshard: " << ex.what() << "\n";
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const auto config = load_config(opts.config);
+        const auto start = Clock::now();
+        if (opts.command == "plan") {
+            run_plan(opts, config);
+        } else {
+            run_copy_or_cleanup(opts, config);
+            const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+            std::cerr << "chatshard: " << std::fixed << std::setprecision(2) << secs << " s\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "chatshard: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
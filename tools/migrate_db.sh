@@ -7,6 +7,14 @@ DB_PORT="${DB_PORT:-5432}"
 DB_NAME="${DB_NAME:-chat}"
 DB_USER="${DB_USER:-chat}"
 DB_PASSWORD="${DB_PASSWORD:-password123}"
+# none | daily | monthly — новая таблица messages секционируется по created_at
+# (messages_partitions в config/server.ini). Существующую таблицу скрипт не трогает:
+# её переводит tools/partition_messages.sh.
+MESSAGES_PARTITIONING="${MESSAGES_PARTITIONING:-none}"
+PARTITIONS_AHEAD="${PARTITIONS_AHEAD:-7}"
+# 1 — база шарды сообщений (message_shards): users и chat_groups живут в основной
+# БД, поэтому внешние ключи messages на них снимаются.
+MESSAGES_SHARD="${MESSAGES_SHARD:-0}"
 
 export PGPASSWORD="$DB_PASSWORD"
 
@@ -17,6 +25,61 @@ psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -tc \
 "SELECT 1 FROM pg_database WHERE datname = '$DB_NAME'" | grep -q 1 || \
 psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -c "CREATE DATABASE $DB_NAME;"
 
+case "$MESSAGES_PARTITIONING" in
+    none) ;;
+    daily) PART_STEP="1 day"; PART_FORMAT="YYYYMMDD"; PART_TRUNC="day" ;;
+    monthly) PART_STEP="1 month"; PART_FORMAT="YYYYMM"; PART_TRUNC="month" ;;
+    *) echo "MESSAGES_PARTITIONING: ожидается none, daily или monthly" >&2; exit 1 ;;
+esac
+
+if [ "$MESSAGES_PARTITIONING" != "none" ]; then
+# Секционированная messages создаётся сразу в итоговом виде (ALTER TABLE ниже
+# ничего не добавляют): первичный ключ обязан включать ключ секционирования —
+# (id, created_at), created_at NOT NULL. Партиции на PARTITIONS_AHEAD интервалов
+# вперёд; дальше их создаёт сервер (MessagePartitionMaintainer).
+psql -v ON_ERROR_STOP=1 -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" <<EOF
+CREATE TABLE IF NOT EXISTS users (
+    id SERIAL PRIMARY KEY,
+    username VARCHAR(255) UNIQUE NOT NULL,
+    password_hash TEXT NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE TABLE IF NOT EXISTS chat_groups (
+    id SERIAL PRIMARY KEY,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+DO \$\$
+DECLARE
+    start TIMESTAMP := date_trunc('$PART_TRUNC', now() AT TIME ZONE 'UTC');
+    p TIMESTAMP;
+BEGIN
+    IF to_regclass('messages') IS NOT NULL THEN
+        RETURN;
+    END IF;
+    CREATE TABLE messages (
+        id BIGSERIAL,
+        sender_id BIGINT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+        text TEXT NOT NULL,
+        created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+        receiver_id BIGINT REFERENCES users(id) ON DELETE CASCADE,
+        conversation_id BIGINT,
+        group_id BIGINT REFERENCES chat_groups(id) ON DELETE CASCADE,
+        PRIMARY KEY (id, created_at)
+    ) PARTITION BY RANGE (created_at);
+    -- На пустой таблице индекс строится сразу (CONCURRENTLY для секционированных
+    -- таблиц не поддерживается); партиции наследуют его.
+    CREATE INDEX messages_conversation_id_id_idx ON messages (conversation_id, id);
+    FOR k IN 0..$PARTITIONS_AHEAD LOOP
+        p := start + k * INTERVAL '$PART_STEP';
+        EXECUTE format('CREATE TABLE %I PARTITION OF messages FOR VALUES FROM (%L) TO (%L)',
+                       'messages_p' || to_char(p, '$PART_FORMAT'), p, p + INTERVAL '$PART_STEP');
+    END LOOP;
+END \$\$;
+EOF
+fi
+
 # Создаём таблицы
 psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" <<'EOF'
 -- Таблица пользователей
@@ -34,7 +97,75 @@ CREATE TABLE IF NOT EXISTS messages (
     text TEXT NOT NULL,
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
 );
+
+-- Получатель и ключ переписки. Для существующей таблицы это миграция:
+-- ADD COLUMN без DEFAULT не переписывает таблицу. Старые строки остаются с NULL —
+-- получатель для них неизвестен, и в историю переписок они не попадают.
+-- conversation_id = (min(sender, receiver) << 32) | max(sender, receiver) — см. ConversationId.
+ALTER TABLE messages ADD COLUMN IF NOT EXISTS receiver_id BIGINT REFERENCES users(id) ON DELETE CASCADE;
+ALTER TABLE messages ADD COLUMN IF NOT EXISTS conversation_id BIGINT;
+
+-- Групповые чаты. Сообщение группы хранится один раз: receiver_id = NULL,
+-- group_id заполнен, conversation_id = group_id (старшие 32 бита нулевые, с
+-- ключами личных переписок не пересекается — у них старшая половина ≥ 1).
+CREATE TABLE IF NOT EXISTS chat_groups (
+    id SERIAL PRIMARY KEY,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE TABLE IF NOT EXISTS group_members (
+    group_id BIGINT NOT NULL REFERENCES chat_groups(id) ON DELETE CASCADE,
+    user_id BIGINT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    PRIMARY KEY (group_id, user_id)
+);
+
+ALTER TABLE messages ADD COLUMN IF NOT EXISTS group_id BIGINT REFERENCES chat_groups(id) ON DELETE CASCADE;
+
+-- id, назначенные узлом (message_id_node ≥ 0, см. MessageIdGenerator), больше 2^31.
+-- Смена типа переписывает таблицу под эксклюзивной блокировкой — на большой таблице
+-- выполнять в окно обслуживания. Уже BIGINT — ничего не делает. Старые id из
+-- последовательности меньше любых сгенерированных, порядок по id сохраняется.
+DO $$
+BEGIN
+    IF (SELECT data_type FROM information_schema.columns
+        WHERE table_name = 'messages' AND column_name = 'id') <> 'bigint' THEN
+        ALTER TABLE messages ALTER COLUMN id TYPE BIGINT;
+        ALTER SEQUENCE messages_id_seq AS BIGINT;
+    END IF;
+END $$;
+EOF
+
+if [ "$MESSAGES_SHARD" = "1" ]; then
+psql -v ON_ERROR_STOP=1 -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" <<'EOF'
+DO $$
+DECLARE
+    c RECORD;
+BEGIN
+    FOR c IN SELECT conname FROM pg_constraint
+             WHERE conrelid = 'messages'::regclass AND contype = 'f' AND conparentid = 0 LOOP
+        EXECUTE format('ALTER TABLE messages DROP CONSTRAINT %I', c.conname);
+    END LOOP;
+END $$;
 EOF
+fi
+
+if [ "$(psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" -tAc \
+      "SELECT relkind FROM pg_class WHERE oid = to_regclass('messages')")" = "p" ]; then
+    # Секционированная таблица: индекс создан вместе с ней (или при конвертации).
+    echo "Миграция завершена."
+    exit 0
+fi
+
+# Индекс строится CONCURRENTLY (без блокировки записи), поэтому отдельной командой
+# вне транзакции. История переписки читается keyset-пагинацией:
+#   WHERE conversation_id = $1 AND id < $2 ORDER BY id DESC LIMIT $3
+# и (conversation_id, id) отдаёт страницу одним index range scan с позиции курсора.
+psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" -c \
+"CREATE INDEX CONCURRENTLY IF NOT EXISTS messages_conversation_id_id_idx ON messages (conversation_id, id);"
+
+# Индекс по отправителю больше не используется запросами истории.
+psql -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME" -c \
+"DROP INDEX CONCURRENTLY IF EXISTS messages_sender_id_id_idx;"
 
 echo "Миграция завершена."
 
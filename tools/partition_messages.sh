@@ -0,0 +1,141 @@
+#!/bin/bash
+# partition_messages.sh
+# Онлайн-перевод существующей таблицы messages в секционированную по created_at.
+#
+# Старые строки не копируются: таблица целиком становится партицией messages_legacy
+# с диапазоном [MINVALUE, CUTOVER), новые сообщения идут в партиции по интервалам.
+# Всё долгое (заполнение created_at, уникальный индекс, проверка CHECK) выполняется
+# без блокировки записи; под эксклюзивной блокировкой — только переименования и
+# ATTACH, которому уже доказанный CHECK позволяет не сканировать таблицу.
+# messages_legacy удаляется целиком, когда все её строки выходят за срок хранения
+# (messages_retention_days, MessagePartitionMaintainer).
+#
+# Требования: PostgreSQL 14+, колонка id уже BIGINT (tools/migrate_db.sh).
+# Внешние ключи на users и chat_groups остаются на messages_legacy, но на новую
+# родительскую таблицу не переносятся: проверка каждой вставки по ним — отдельный
+# index lookup, а удаление пользователя и так не удаляет историю на горячем пути.
+# При необходимости добавить их вручную (ALTER TABLE messages ADD FOREIGN KEY ...).
+#
+# Повторный запуск после ошибки безопасен: каждый шаг проверяет, сделан ли он.
+
+set -euo pipefail
+
+DB_HOST="${DB_HOST:-localhost}"
+DB_PORT="${DB_PORT:-5432}"
+DB_NAME="${DB_NAME:-chat}"
+DB_USER="${DB_USER:-chat}"
+DB_PASSWORD="${DB_PASSWORD:-password123}"
+PARTITION_INTERVAL="${PARTITION_INTERVAL:-daily}"
+# daily | monthly — как messages_partitions в config/server.ini.
+AHEAD="${AHEAD:-7}"
+BACKFILL_BATCH="${BACKFILL_BATCH:-50000}"
+# Строк за один UPDATE при заполнении пустых created_at.
+
+export PGPASSWORD="$DB_PASSWORD"
+PSQL=(psql -v ON_ERROR_STOP=1 -X -q -h "$DB_HOST" -p "$DB_PORT" -U "$DB_USER" -d "$DB_NAME")
+
+case "$PARTITION_INTERVAL" in
+    daily) PART_STEP="1 day"; PART_FORMAT="YYYYMMDD"; PART_TRUNC="day" ;;
+    monthly) PART_STEP="1 month"; PART_FORMAT="YYYYMM"; PART_TRUNC="month" ;;
+    *) echo "PARTITION_INTERVAL: ожидается daily или monthly" >&2; exit 1 ;;
+esac
+
+if [ "$("${PSQL[@]}" -tAc "SELECT relkind FROM pg_class WHERE oid = to_regclass('messages')")" = "p" ]; then
+    echo "messages уже секционирована."
+    exit 0
+fi
+
+# Граница перехода — начало интервала, до которого не меньше суток: CHECK ниже
+# должен успеть провериться, пока новые строки ещё не доходят до неё.
+CUTOVER="${CUTOVER:-$("${PSQL[@]}" -tAc \
+    "SELECT date_trunc('$PART_TRUNC', (now() AT TIME ZONE 'UTC') + INTERVAL '1 day') + INTERVAL '$PART_STEP'")}"
+echo "Граница перехода: $CUTOVER (UTC)"
+
+# 1. created_at без NULL: ключ секционирования не может быть пустым. Пачками, чтобы
+#    не держать долгую транзакцию и не раздувать WAL одним UPDATE.
+echo "Заполняем пустые created_at..."
+while :; do
+    updated=$("${PSQL[@]}" -tAc "WITH batch AS (
+        SELECT id FROM messages WHERE created_at IS NULL LIMIT $BACKFILL_BATCH)
+        UPDATE messages m SET created_at = TIMESTAMP 'epoch'
+        FROM batch WHERE m.id = batch.id RETURNING 1" | wc -l)
+    [ "$updated" -eq 0 ] && break
+    echo "  $updated"
+done
+
+# 2. Уникальный индекс (id, created_at) — будущий первичный ключ партиции, без
+#    блокировки записи. Недостроенный индекс от прерванного запуска пересоздаётся.
+if [ "$("${PSQL[@]}" -tAc "SELECT NOT indisvalid FROM pg_index
+        WHERE indexrelid = to_regclass('messages_id_created_at_key')")" = "t" ]; then
+    "${PSQL[@]}" -c "DROP INDEX CONCURRENTLY messages_id_created_at_key;"
+fi
+echo "Строим уникальный индекс (id, created_at)..."
+"${PSQL[@]}" -c "CREATE UNIQUE INDEX CONCURRENTLY IF NOT EXISTS messages_id_created_at_key
+    ON messages (id, created_at);"
+
+# 3. CHECK, совпадающий с диапазоном будущей партиции: NOT VALID добавляется
+#    мгновенно, VALIDATE сканирует таблицу под SHARE UPDATE EXCLUSIVE (запись идёт).
+echo "Проверяем ограничение диапазона..."
+"${PSQL[@]}" <<EOF
+DO \$\$
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM pg_constraint
+                   WHERE conrelid = 'messages'::regclass AND conname = 'messages_legacy_range') THEN
+        ALTER TABLE messages ADD CONSTRAINT messages_legacy_range
+            CHECK (created_at IS NOT NULL AND created_at < TIMESTAMP '$CUTOVER') NOT VALID;
+    END IF;
+END \$\$;
+ALTER TABLE messages VALIDATE CONSTRAINT messages_legacy_range;
+EOF
+
+# 4. Переключение — одна короткая транзакция. lock_timeout: если таблицу держит
+#    долгий запрос, лучше упасть и повторить, чем выстроить за собой очередь записей.
+echo "Переключаем messages на секционированную таблицу..."
+"${PSQL[@]}" <<EOF
+SET lock_timeout = '5s';
+BEGIN;
+DO \$\$
+BEGIN
+    IF now() AT TIME ZONE 'UTC' > TIMESTAMP '$CUTOVER' - INTERVAL '1 hour' THEN
+        RAISE EXCEPTION 'слишком близко к границе перехода $CUTOVER: запустите скрипт заново';
+    END IF;
+    IF (SELECT data_type FROM information_schema.columns
+        WHERE table_name = 'messages' AND column_name = 'id') <> 'bigint' THEN
+        RAISE EXCEPTION 'messages.id не BIGINT: сначала tools/migrate_db.sh';
+    END IF;
+END \$\$;
+
+LOCK TABLE messages IN ACCESS EXCLUSIVE MODE;
+-- Доказано CHECK'ом выше: проверка NOT NULL не сканирует таблицу.
+ALTER TABLE messages ALTER COLUMN created_at SET NOT NULL;
+ALTER TABLE messages RENAME TO messages_legacy;
+
+CREATE TABLE messages (LIKE messages_legacy INCLUDING DEFAULTS)
+    PARTITION BY RANGE (created_at);
+ALTER TABLE messages ADD CONSTRAINT messages_part_pkey PRIMARY KEY (id, created_at);
+-- Индекс истории: у messages_legacy такой уже есть (tools/migrate_db.sh) и при
+-- ATTACH становится её частью вместо построения нового.
+CREATE INDEX messages_part_conversation_id_id_idx ON messages (conversation_id, id);
+
+ALTER TABLE messages ATTACH PARTITION messages_legacy
+    FOR VALUES FROM (MINVALUE) TO ('$CUTOVER');
+ALTER TABLE messages_legacy DROP CONSTRAINT messages_legacy_range;
+
+DO \$\$
+DECLARE
+    p TIMESTAMP := TIMESTAMP '$CUTOVER';
+BEGIN
+    FOR k IN 0..$AHEAD LOOP
+        EXECUTE format('CREATE TABLE %I PARTITION OF messages FOR VALUES FROM (%L) TO (%L)',
+                       'messages_p' || to_char(p, '$PART_FORMAT'), p, p + INTERVAL '$PART_STEP');
+        p := p + INTERVAL '$PART_STEP';
+    END LOOP;
+END \$\$;
+
+-- Последовательность переходит к новой таблице: DROP messages_legacy её не удалит.
+ALTER SEQUENCE messages_id_seq OWNED BY messages.id;
+COMMIT;
+EOF
+
+echo "Готово: messages секционирована ($PARTITION_INTERVAL), старые строки — в messages_legacy."
+echo "Включите messages_partitions = $PARTITION_INTERVAL в config/server.ini."